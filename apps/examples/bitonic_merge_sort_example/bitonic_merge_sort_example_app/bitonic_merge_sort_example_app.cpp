@@ -553,6 +553,10 @@ static bool bitonic_merge_sort_example_app_update( bitonic_merge_sort_example_ap
 
 	self->frame_counter++;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive
 }
 
@@ -411,6 +411,10 @@ static bool compute_example_app_update( compute_example_app_o* self ) {
 	self->frame_counter++;
 	self->anim_frame += self->anim_speed;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive
 }
 
@@ -0,0 +1,154 @@
+#include "modules/le_backend_vk/private/le_backend_vk/le_hash_map.h"
+#include "modules/le_core/le_hash_util.h" // for xorshift_64
+
+#include <unordered_map>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * Contention benchmark for the pipeline manager's hash map.
+ *
+ * A number of reader threads look up random keys - as render passes do when
+ * they look up pipelines, layouts, and descriptor set layouts while recording -
+ * while one writer thread keeps inserting new entries at a slow rate.
+ *
+ * We compare the wait-free HashMap with a map protected by a shared mutex -
+ * which is how the pipeline manager used to store its objects.
+ *
+ * Usage: Island-HashMapBenchmark [num_entries] [lookups_per_thread]
+ *
+ */
+
+// ----------------------------------------------------------------------
+// Reference implementation: unordered_map behind a shared mutex.
+template <typename S, typename T>
+class SharedMutexHashMap : NoCopy, NoMove {
+
+	std::shared_mutex         mtx;
+	std::unordered_map<S, T*> store; // owning
+
+  public:
+	T* try_find( S needle ) {
+		auto lock = std::shared_lock( mtx );
+		auto e    = store.find( needle );
+		return e == store.end() ? nullptr : e->second;
+	}
+
+	bool try_insert( S handle, T* obj ) {
+		auto lock   = std::unique_lock( mtx );
+		auto result = store.emplace( handle, nullptr );
+		if ( result.second ) {
+			result.first->second = new T( *obj );
+		}
+		return result.second;
+	}
+
+	~SharedMutexHashMap() {
+		for ( auto& e : store ) {
+			delete e.second;
+		}
+	}
+};
+
+// ----------------------------------------------------------------------
+// Returns nanoseconds per lookup, averaged over all reader threads.
+template <typename Map>
+static double run_benchmark( std::vector<uint64_t> const& keys, size_t num_readers, size_t lookups_per_thread ) {
+
+	Map map;
+
+	// Only insert the first half of keys up-front - the writer inserts the rest while readers run.
+	size_t const num_initial = keys.size() / 2;
+
+	for ( size_t i = 0; i != num_initial; i++ ) {
+		uint64_t value = keys[ i ];
+		map.try_insert( keys[ i ], &value );
+	}
+
+	std::atomic<bool>     start     = false;
+	std::atomic<size_t>   num_done  = 0;
+	std::atomic<uint64_t> total_ns  = 0;
+	std::atomic<uint64_t> sink      = 0; // so that lookups don't get optimised away
+	size_t const          key_count = keys.size();
+	uint64_t const*       keys_data = keys.data();
+
+	std::vector<std::thread> readers;
+
+	for ( size_t r = 0; r != num_readers; r++ ) {
+		readers.emplace_back( [ &, seed = uint64_t( 0x9e3779b97f4a7c15ull * ( r + 1 ) ) ]() mutable {
+			while ( !start ) {
+				std::this_thread::yield();
+			}
+			uint64_t found = 0;
+			auto     t0    = std::chrono::steady_clock::now();
+			for ( size_t i = 0; i != lookups_per_thread; i++ ) {
+				uint64_t const* v = map.try_find( keys_data[ xorshift_64( seed ) % key_count ] );
+				found += v ? *v : 0;
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			total_ns += uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( t1 - t0 ).count() );
+			sink += found;
+			num_done++;
+		} );
+	}
+
+	std::thread writer( [ & ]() {
+		while ( !start ) {
+			std::this_thread::yield();
+		}
+		for ( size_t i = num_initial; i != key_count && num_done != num_readers; i++ ) {
+			uint64_t value = keys[ i ];
+			map.try_insert( keys[ i ], &value );
+			std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+		}
+	} );
+
+	start = true;
+
+	for ( auto& t : readers ) {
+		t.join();
+	}
+	writer.join();
+
+	if ( sink == 0 ) {
+		printf( "(no entries found)\n" );
+	}
+
+	return double( total_ns ) / double( num_readers * lookups_per_thread );
+}
+
+// ----------------------------------------------------------------------
+
+int main( int argc, char const* argv[] ) {
+
+	size_t num_entries        = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 4096;
+	size_t lookups_per_thread = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 2000000;
+
+	if ( num_entries < 2 ) {
+		num_entries = 2;
+	}
+
+	std::vector<uint64_t> keys( num_entries );
+	uint64_t              seed = 0x853c49e6748fea9bull;
+
+	for ( auto& k : keys ) {
+		k = xorshift_64( seed ) | 1; // value must be non-zero so that we can count hits
+	}
+
+	size_t max_threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+	printf( "hash map contention benchmark: %zu entries, %zu lookups per thread\n\n", num_entries, lookups_per_thread );
+	printf( "%8s | %22s | %22s | %8s\n", "readers", "shared_mutex (ns/op)", "HashMap (ns/op)", "speedup" );
+
+	for ( size_t num_readers = 1; num_readers <= max_threads; num_readers *= 2 ) {
+		double ns_locked    = run_benchmark<SharedMutexHashMap<uint64_t, uint64_t>>( keys, num_readers, lookups_per_thread );
+		double ns_lock_free = run_benchmark<HashMap<uint64_t, uint64_t>>( keys, num_readers, lookups_per_thread );
+		printf( "%8zu | %22.2f | %22.2f | %7.2fx\n", num_readers, ns_locked, ns_lock_free, ns_locked / ns_lock_free );
+	}
+
+	return 0;
+}
@@ -690,6 +690,10 @@ static bool hello_world_app_update( hello_world_app_o* self ) {
 
 	self->frame_counter++;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive
 }
 
@@ -0,0 +1,381 @@
+// The encoders open tracy zones - we don't profile this test, so we stub out le_tracy.h,
+// which would otherwise make us link against le_core, and the le_tracy module.
+#define GUARD_le_tracy_H
+#define ZoneScoped
+
+#include "modules/le_swapchain_vk/le_image_encoder.cpp"
+#include "modules/le_pixels/3rdparty/stb_image_implementation.cpp"
+#include "modules/le_core/le_hash_util.h" // for xorshift_64
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Round-trip test for the image swapchain's built-in encoders.
+ *
+ * We encode a set of test images, and decode them again with decoders which
+ * don't share any code with the encoders:
+ *
+ * - PNG files are decoded via stb_image, which le_pixels vendors. Since stb_image
+ *   does not verify checksums, we additionally check every chunk's CRC, and the
+ *   zlib stream's Adler-32, using straightforward reference implementations.
+ * - QOI files are decoded via a reference decoder which follows the QOI spec.
+ *
+ * Decoded pixels must match source pixels exactly - both encoders are lossless.
+ *
+ * Usage: Island-ImageEncoderTest
+ *
+ * Returns EXIT_SUCCESS if all images round-trip, EXIT_FAILURE otherwise.
+ *
+ */
+
+struct test_image_t {
+	std::string          name;
+	uint32_t             width;
+	uint32_t             height;
+	bool                 is_bgra;
+	std::vector<uint8_t> pixels; // as given to the encoder - rgba, or bgra if is_bgra
+};
+
+// ----------------------------------------------------------------------
+// Returns source pixels as rgba, so that we can compare them with decoded pixels.
+static std::vector<uint8_t> test_image_get_rgba( test_image_t const& img ) {
+	std::vector<uint8_t> rgba = img.pixels;
+	if ( img.is_bgra ) {
+		for ( size_t i = 0; i < rgba.size(); i += 4 ) {
+			std::swap( rgba[ i + 0 ], rgba[ i + 2 ] );
+		}
+	}
+	return rgba;
+}
+
+// ----------------------------------------------------------------------
+
+static std::vector<test_image_t> create_test_images() {
+	std::vector<test_image_t> images;
+
+	auto add_image = [ &images ]( char const* name, uint32_t w, uint32_t h, bool is_bgra, auto pixel_fun ) {
+		test_image_t img{ name, w, h, is_bgra, std::vector<uint8_t>( size_t( w ) * h * 4 ) };
+		for ( uint32_t y = 0; y != h; y++ ) {
+			for ( uint32_t x = 0; x != w; x++ ) {
+				pixel_fun( x, y, img.pixels.data() + ( size_t( y ) * w + x ) * 4 );
+			}
+		}
+		images.emplace_back( std::move( img ) );
+	};
+
+	add_image( "single pixel", 1, 1, false, []( uint32_t, uint32_t, uint8_t* p ) {
+		p[ 0 ] = 12, p[ 1 ] = 34, p[ 2 ] = 56, p[ 3 ] = 78;
+	} );
+
+	// long runs: exercises maximum length matches, and qoi runs which span rows
+	add_image( "solid", 640, 360, false, []( uint32_t, uint32_t, uint8_t* p ) {
+		p[ 0 ] = 200, p[ 1 ] = 100, p[ 2 ] = 50, p[ 3 ] = 255;
+	} );
+
+	add_image( "gradient", 257, 129, false, []( uint32_t x, uint32_t y, uint8_t* p ) {
+		p[ 0 ] = uint8_t( x ), p[ 1 ] = uint8_t( y * 2 ), p[ 2 ] = uint8_t( x + y ), p[ 3 ] = 255;
+	} );
+
+	add_image( "gradient bgra", 257, 129, true, []( uint32_t x, uint32_t y, uint8_t* p ) {
+		p[ 0 ] = uint8_t( x ), p[ 1 ] = uint8_t( y * 2 ), p[ 2 ] = uint8_t( x + y ), p[ 3 ] = 255;
+	} );
+
+	// repeats at distances beyond a single row: exercises long-distance matches, and qoi index hits
+	add_image( "checkerboard with alpha", 300, 200, false, []( uint32_t x, uint32_t y, uint8_t* p ) {
+		bool is_dark = ( ( x / 7 ) + ( y / 5 ) ) & 1;
+		p[ 0 ] = is_dark ? 20 : 230, p[ 1 ] = is_dark ? 40 : 210, p[ 2 ] = is_dark ? 60 : 190, p[ 3 ] = uint8_t( ( x / 3 ) * 17 );
+	} );
+
+	// incompressible: exercises literals, and qoi rgba ops
+	uint64_t state = 0x2545f4914f6cdd1dull;
+	add_image( "noise", 333, 77, false, [ &state ]( uint32_t, uint32_t, uint8_t* p ) {
+		uint64_t r = xorshift_64( state );
+		memcpy( p, &r, 4 );
+	} );
+
+	// small deltas: exercises qoi diff and luma ops
+	add_image( "smooth noise", 199, 101, true, [ &state ]( uint32_t x, uint32_t y, uint8_t* p ) {
+		uint64_t r = xorshift_64( state );
+		p[ 0 ] = uint8_t( 128 + ( x % 16 ) + ( r & 3 ) );
+		p[ 1 ] = uint8_t( 64 + ( y % 32 ) + ( ( r >> 8 ) & 7 ) );
+		p[ 2 ] = uint8_t( 32 + ( ( x + y ) % 8 ) + ( ( r >> 16 ) & 31 ) );
+		p[ 3 ] = ( r >> 24 ) & 1 ? 255 : 254;
+	} );
+
+	return images;
+}
+
+// ----------------------------------------------------------------------
+// Bitwise reference implementation - intentionally different from the encoder's table-driven crc.
+static uint32_t reference_crc32( uint8_t const* data, size_t num_bytes ) {
+	uint32_t crc = 0xffffffffu;
+	for ( size_t i = 0; i != num_bytes; i++ ) {
+		crc ^= data[ i ];
+		for ( int k = 0; k != 8; k++ ) {
+			crc = ( crc >> 1 ) ^ ( 0xedb88320u & ( 0u - ( crc & 1 ) ) );
+		}
+	}
+	return ~crc;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t reference_adler32( uint8_t const* data, size_t num_bytes ) {
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for ( size_t i = 0; i != num_bytes; i++ ) {
+		a = ( a + data[ i ] ) % 65521;
+		b = ( b + a ) % 65521;
+	}
+	return ( b << 16 ) | a;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t get_u32_be( uint8_t const* p ) {
+	return ( uint32_t( p[ 0 ] ) << 24 ) | ( uint32_t( p[ 1 ] ) << 16 ) | ( uint32_t( p[ 2 ] ) << 8 ) | uint32_t( p[ 3 ] );
+}
+
+// ----------------------------------------------------------------------
+// Checks chunk CRCs, and the Adler-32 of the inflated image data. Returns false and
+// prints an error message if any check fails.
+static bool png_verify_checksums( std::vector<uint8_t> const& png ) {
+
+	static uint8_t const signature[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	if ( png.size() < 8 || memcmp( png.data(), signature, 8 ) ) {
+		fprintf( stderr, "invalid png signature\n" );
+		return false;
+	}
+
+	std::vector<uint8_t> zlib_stream;
+
+	size_t offset = 8;
+	bool   is_end = false;
+
+	while ( !is_end && offset + 12 <= png.size() ) {
+		uint32_t const length = get_u32_be( png.data() + offset );
+
+		if ( offset + 12 + length > png.size() ) {
+			fprintf( stderr, "png chunk overruns file\n" );
+			return false;
+		}
+
+		uint8_t const* type = png.data() + offset + 4;
+		uint8_t const* data = type + 4;
+
+		if ( reference_crc32( type, length + 4 ) != get_u32_be( data + length ) ) {
+			fprintf( stderr, "crc mismatch in chunk '%.4s'\n", type );
+			return false;
+		}
+
+		if ( 0 == memcmp( type, "IDAT", 4 ) ) {
+			zlib_stream.insert( zlib_stream.end(), data, data + length );
+		}
+
+		is_end = ( 0 == memcmp( type, "IEND", 4 ) );
+		offset += 12 + length;
+	}
+
+	if ( !is_end || offset != png.size() ) {
+		fprintf( stderr, "png must end with IEND chunk\n" );
+		return false;
+	}
+
+	if ( zlib_stream.size() < 6 ) {
+		fprintf( stderr, "zlib stream too short\n" );
+		return false;
+	}
+
+	int   num_inflated = 0;
+	char* inflated     = stbi_zlib_decode_malloc( ( char const* )zlib_stream.data(), int( zlib_stream.size() ), &num_inflated );
+
+	if ( inflated == nullptr ) {
+		fprintf( stderr, "could not inflate image data: %s\n", stbi_failure_reason() );
+		return false;
+	}
+
+	uint32_t adler = reference_adler32( ( uint8_t const* )inflated, size_t( num_inflated ) );
+	free( inflated );
+
+	if ( adler != get_u32_be( zlib_stream.data() + zlib_stream.size() - 4 ) ) {
+		fprintf( stderr, "adler-32 mismatch\n" );
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Reference decoder, following https://qoiformat.org/qoi-specification.pdf
+static bool qoi_decode( std::vector<uint8_t> const& qoi, uint32_t* width, uint32_t* height, std::vector<uint8_t>& rgba ) {
+
+	static uint8_t const end_marker[ 8 ] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	if ( qoi.size() < 14 + 8 || memcmp( qoi.data(), "qoif", 4 ) ) {
+		fprintf( stderr, "invalid qoi header\n" );
+		return false;
+	}
+
+	*width  = get_u32_be( qoi.data() + 4 );
+	*height = get_u32_be( qoi.data() + 8 );
+
+	if ( qoi[ 12 ] != 4 || qoi[ 13 ] > 1 ) {
+		fprintf( stderr, "invalid qoi channels or colorspace\n" );
+		return false;
+	}
+
+	uint8_t index[ 64 ][ 4 ] = {};
+	uint8_t px[ 4 ]          = { 0, 0, 0, 255 };
+
+	size_t const num_pixels = size_t( *width ) * *height;
+	size_t const data_end   = qoi.size() - 8;
+	size_t       pos        = 14;
+	uint32_t     run        = 0;
+
+	rgba.resize( num_pixels * 4 );
+
+	for ( size_t i = 0; i != num_pixels; i++ ) {
+		if ( run > 0 ) {
+			run--;
+		} else {
+			if ( pos >= data_end ) {
+				fprintf( stderr, "qoi data ends early\n" );
+				return false;
+			}
+
+			uint8_t b1 = qoi[ pos++ ];
+
+			if ( b1 == 0xfe ) {
+				px[ 0 ] = qoi[ pos++ ], px[ 1 ] = qoi[ pos++ ], px[ 2 ] = qoi[ pos++ ];
+			} else if ( b1 == 0xff ) {
+				px[ 0 ] = qoi[ pos++ ], px[ 1 ] = qoi[ pos++ ], px[ 2 ] = qoi[ pos++ ], px[ 3 ] = qoi[ pos++ ];
+			} else if ( ( b1 & 0xc0 ) == 0x00 ) {
+				memcpy( px, index[ b1 ], 4 );
+			} else if ( ( b1 & 0xc0 ) == 0x40 ) {
+				px[ 0 ] += ( ( b1 >> 4 ) & 3 ) - 2;
+				px[ 1 ] += ( ( b1 >> 2 ) & 3 ) - 2;
+				px[ 2 ] += ( b1 & 3 ) - 2;
+			} else if ( ( b1 & 0xc0 ) == 0x80 ) {
+				uint8_t b2 = qoi[ pos++ ];
+				int     vg = ( b1 & 0x3f ) - 32;
+				px[ 0 ] += vg - 8 + ( ( b2 >> 4 ) & 0x0f );
+				px[ 1 ] += vg;
+				px[ 2 ] += vg - 8 + ( b2 & 0x0f );
+			} else {
+				run = ( b1 & 0x3f );
+			}
+
+			memcpy( index[ ( px[ 0 ] * 3 + px[ 1 ] * 5 + px[ 2 ] * 7 + px[ 3 ] * 11 ) % 64 ], px, 4 );
+		}
+
+		memcpy( rgba.data() + i * 4, px, 4 );
+	}
+
+	if ( pos != data_end || memcmp( qoi.data() + data_end, end_marker, 8 ) ) {
+		fprintf( stderr, "qoi data must be followed by end marker\n" );
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static bool check_pixels( char const* format, test_image_t const& img, uint32_t w, uint32_t h, uint8_t const* decoded ) {
+	if ( w != img.width || h != img.height ) {
+		fprintf( stderr, "[ FAIL ] %-4s %-24s: extents %ux%u, expected %ux%u\n", format, img.name.c_str(), w, h, img.width, img.height );
+		return false;
+	}
+
+	std::vector<uint8_t> expected = test_image_get_rgba( img );
+
+	for ( size_t i = 0; i != expected.size(); i++ ) {
+		if ( decoded[ i ] != expected[ i ] ) {
+			size_t px = i / 4;
+			fprintf( stderr, "[ FAIL ] %-4s %-24s: first mismatch at pixel (%zu, %zu), channel %zu: %u, expected %u\n",
+			         format, img.name.c_str(), px % w, px / w, i % 4, decoded[ i ], expected[ i ] );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static bool test_png( test_image_t const& img ) {
+
+	le_image_encoder_source_t src{ img.pixels.data(), img.width, img.height, img.is_bgra, true };
+
+	std::vector<uint8_t> png;
+	le_image_encode_png( src, png );
+
+	if ( !png_verify_checksums( png ) ) {
+		fprintf( stderr, "[ FAIL ] png  %-24s: invalid file\n", img.name.c_str() );
+		return false;
+	}
+
+	int      w = 0, h = 0, num_channels = 0;
+	stbi_uc* decoded = stbi_load_from_memory( png.data(), int( png.size() ), &w, &h, &num_channels, 4 );
+
+	if ( decoded == nullptr ) {
+		fprintf( stderr, "[ FAIL ] png  %-24s: could not decode: %s\n", img.name.c_str(), stbi_failure_reason() );
+		return false;
+	}
+
+	bool result = check_pixels( "png", img, uint32_t( w ), uint32_t( h ), decoded );
+	stbi_image_free( decoded );
+
+	if ( result ) {
+		printf( "[  OK  ] png  %-24s: %8zu bytes (%5.1f%%)\n", img.name.c_str(), png.size(), 100. * png.size() / img.pixels.size() );
+	}
+
+	return result;
+}
+
+// ----------------------------------------------------------------------
+
+static bool test_qoi( test_image_t const& img ) {
+
+	le_image_encoder_source_t src{ img.pixels.data(), img.width, img.height, img.is_bgra, true };
+
+	std::vector<uint8_t> qoi;
+	le_image_encode_qoi( src, qoi );
+
+	uint32_t             w = 0, h = 0;
+	std::vector<uint8_t> decoded;
+
+	if ( !qoi_decode( qoi, &w, &h, decoded ) ) {
+		fprintf( stderr, "[ FAIL ] qoi  %-24s: could not decode\n", img.name.c_str() );
+		return false;
+	}
+
+	bool result = check_pixels( "qoi", img, w, h, decoded.data() );
+
+	if ( result ) {
+		printf( "[  OK  ] qoi  %-24s: %8zu bytes (%5.1f%%)\n", img.name.c_str(), qoi.size(), 100. * qoi.size() / img.pixels.size() );
+	}
+
+	return result;
+}
+
+// ----------------------------------------------------------------------
+
+int main() {
+
+	bool all_passed = true;
+
+	for ( auto const& img : create_test_images() ) {
+		all_passed &= test_png( img );
+		all_passed &= test_qoi( img );
+	}
+
+	printf( all_passed ? "All images round-trip.\n" : "Some images failed to round-trip.\n" );
+
+	return all_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
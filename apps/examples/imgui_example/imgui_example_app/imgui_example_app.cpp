@@ -223,6 +223,10 @@ static bool app_update( imgui_example_app_o* self ) {
 
 	self->frame_counter++;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive
 }
 
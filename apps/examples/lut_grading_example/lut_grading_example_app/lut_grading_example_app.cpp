@@ -202,6 +202,10 @@ static bool lut_grading_example_app_update( lut_grading_example_app_o* self ) {
 
 	self->frame_counter++;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive, false will quit app.
 }
 
@@ -506,6 +506,10 @@ static bool app_update( multi_window_example_app_o* self ) {
 	self->renderer.update( renderGraph );
 	++self->frame_counter;
 
+	if ( self->renderer.isBenchmarkComplete() ) {
+		return false; // headless benchmark has written its report - quit app
+	}
+
 	return true; // keep app alive
 }
 
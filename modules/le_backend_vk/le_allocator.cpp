@@ -3,6 +3,8 @@
 
 #include "util/vk_mem_alloc/vk_mem_alloc.h"
 #include <cstring> // for memcpy
+#include <cassert>
+#include <algorithm> // for std::max
 
 /*
 
@@ -16,26 +18,77 @@ Linear sub-allocator
     the resource-system, we only need to know the LE-api specific handle for the
     buffer
 
+    + If a grow callback is set, and the current block is exhausted, the allocator
+    asks the callback for an additional block, and continues allocating from there.
+    Additional blocks are owned by whoever provides them - the allocator returns
+    to its base block on reset.
+
+    + The allocator keeps track of how many bytes were allocated since the last
+    reset, and of the peak number of bytes allocated between any two resets, so
+    that its owner may resize the base block to cover peak use.
+
 */
 
+struct le_allocator_block_t {
+	le_buf_resource_handle resourceId        = {};      // handle of the buffer which backs this block
+	uint8_t*               baseMemoryAddress = nullptr; // mapped memory address
+	uint64_t               baseOffsetInBytes = 0;       // offset into buffer for first address belonging to this block
+	uint64_t               capacity          = 0;
+};
+
 struct le_allocator_o {
 
-	le_buf_resource_handle resourceId = {}; // for transient allocators, this must contain index of transient allocator
+	le_allocator_block_t base;    // base block - we return to this block on reset.
+	le_allocator_block_t current; // block we currently allocate from - either the base block, or the most recently added block
+
+	uint64_t alignment = 256; // 1<<8== 256, minimum allocation chunk size (should proabbly be VkPhysicalDeviceLimits::minTexelBufferOffsetAlignment - see bufferView offset "valid use" in Spec: 11.2 )
+
+	uint8_t* pData               = nullptr; // address of next allocation, initially: (current.baseMemoryAddress + current.baseOffsetInBytes)
+	uint64_t bufferOffsetInBytes = 0;       // offset into current block's buffer for next allocation
 
-	uint8_t* bufferBaseMemoryAddress = nullptr; // mapped memory address
-	uint64_t bufferBaseOffsetInBytes = 0;       // offset into buffer for first address belonging to this allocator
-	uint64_t capacity                = 0;
-	uint64_t alignment               = 256; // 1<<8== 256, minimum allocation chunk size (should proabbly be VkPhysicalDeviceLimits::minTexelBufferOffsetAlignment - see bufferView offset "valid use" in Spec: 11.2 )
+	le_allocator_grow_fun_t grow_fun       = nullptr; // optional: called if an allocation does not fit into the current block
+	void*                   grow_user_data = nullptr;
 
-	uint8_t* pData               = bufferBaseMemoryAddress; // address of last allocation, initially: (bufferBaseMemoryAddress + bufferBaseOffsetInBytes)
-	uint64_t bufferOffsetInBytes = bufferBaseOffsetInBytes;
+	uint64_t bytesAllocated   = 0; // number of bytes allocated since last reset, over all blocks
+	uint64_t bytesHighWater   = 0; // peak value of bytesAllocated observed at any reset
+	uint32_t numBlocksChained = 0; // number of additional blocks requested since last reset
 };
 
 // ----------------------------------------------------------------------
 
+static void allocator_set_current_block( le_allocator_o* self, le_allocator_block_t const& block ) {
+	self->current             = block;
+	self->bufferOffsetInBytes = block.baseOffsetInBytes;
+	self->pData               = block.baseMemoryAddress + block.baseOffsetInBytes;
+}
+
+// ----------------------------------------------------------------------
+
+static le_allocator_block_t allocator_block_from_allocation_info( VmaAllocationInfo const* info ) {
+	le_allocator_block_t block{};
+
+	block.baseMemoryAddress = static_cast<uint8_t*>( info->pMappedData );
+	block.baseOffsetInBytes = info->offset;
+	block.capacity          = info->size;
+
+	// -- Fetch resource handle of underlying buffer from VmaAllocation info
+	memcpy( &block.resourceId, &info->pUserData, sizeof( void* ) ); // note we copy pUserData as a value
+
+	return block;
+}
+
+// ----------------------------------------------------------------------
+
 static void allocator_reset( le_allocator_o* self ) {
-	self->bufferOffsetInBytes = self->bufferBaseOffsetInBytes;
-	self->pData               = self->bufferBaseMemoryAddress + self->bufferBaseOffsetInBytes;
+
+	if ( self->bytesAllocated > self->bytesHighWater ) {
+		self->bytesHighWater = self->bytesAllocated;
+	}
+
+	self->bytesAllocated   = 0;
+	self->numBlocksChained = 0;
+
+	allocator_set_current_block( self, self->base );
 }
 
 // ----------------------------------------------------------------------
@@ -43,20 +96,36 @@ static void allocator_reset( le_allocator_o* self ) {
 static le_allocator_o* allocator_create( VmaAllocationInfo const* info, uint16_t alignment ) {
 	auto self = new le_allocator_o{};
 
-	self->bufferBaseMemoryAddress = static_cast<uint8_t*>( info->pMappedData );
+	self->base      = allocator_block_from_allocation_info( info );
+	self->alignment = alignment;
 
-	self->bufferBaseOffsetInBytes = info->offset;
-	self->capacity                = info->size;
-	self->alignment               = alignment;
+	allocator_reset( self );
 
-	// -- Fetch resource handle of underlying buffer from VmaAllocation info
-	memcpy( &self->resourceId, &info->pUserData, sizeof( void* ) ); // note we copy pUserData as a value
+	return self;
+}
 
-	//	self->resourceId = reinterpret_cast<le_buf_resource_handle const &>( info->pUserData );
+// ----------------------------------------------------------------------
+// Replaces the base block - only call this while no allocations from this allocator are in use,
+// i.e. after reset. Statistics are kept, so that the high water mark persists.
+static void allocator_set_base_block( le_allocator_o* self, VmaAllocationInfo const* info ) {
+	self->base = allocator_block_from_allocation_info( info );
+	allocator_set_current_block( self, self->base );
+}
 
-	allocator_reset( self );
+// ----------------------------------------------------------------------
 
-	return self;
+static void allocator_set_grow_callback( le_allocator_o* self, le_allocator_grow_fun_t grow_fun, void* user_data ) {
+	self->grow_fun       = grow_fun;
+	self->grow_user_data = user_data;
+}
+
+// ----------------------------------------------------------------------
+
+static void allocator_get_stats( le_allocator_o* self, le_allocator_stats_t* stats ) {
+	stats->bytes_allocated    = self->bytesAllocated;
+	stats->bytes_high_water   = std::max( self->bytesHighWater, self->bytesAllocated );
+	stats->base_capacity      = self->base.capacity;
+	stats->num_blocks_chained = self->numBlocksChained;
 }
 
 // ----------------------------------------------------------------------
@@ -75,20 +144,38 @@ static bool allocator_allocate( le_allocator_o* self, uint64_t numBytes, void**
 
 	auto addressAfterAllocation = self->pData + allocationSizeInBytes;
 
-	if ( ( addressAfterAllocation ) > ( self->bufferBaseMemoryAddress + self->bufferBaseOffsetInBytes + self->capacity ) ) {
-		*p_buf_resource = nullptr;
-		return false;
+	if ( ( addressAfterAllocation ) > ( self->current.baseMemoryAddress + self->current.baseOffsetInBytes + self->current.capacity ) ) {
+
+		// Current block is exhausted - chain an additional block, if we can.
+		// New blocks are at least as large as the base block, so that we don't
+		// need to chain another block for every allocation once we overflow.
+
+		VmaAllocationInfo info{};
+
+		if ( nullptr == self->grow_fun ||
+		     false == self->grow_fun( self->grow_user_data, std::max( allocationSizeInBytes, self->base.capacity ), &info ) ) {
+			*p_buf_resource = nullptr;
+			return false;
+		}
+
+		allocator_set_current_block( self, allocator_block_from_allocation_info( &info ) );
+		self->numBlocksChained++;
+
+		addressAfterAllocation = self->pData + allocationSizeInBytes;
+
+		assert( addressAfterAllocation <= self->current.baseMemoryAddress + self->current.baseOffsetInBytes + self->current.capacity );
 	}
 
 	// ----------| invariant: enough capacity to accomodate numBytes
 
 	*pData          = self->pData; // point to next free memory address
 	*bufferOffset   = self->bufferOffsetInBytes;
-	*p_buf_resource = self->resourceId;
+	*p_buf_resource = self->current.resourceId;
 
 	self->pData = addressAfterAllocation;
 
 	self->bufferOffsetInBytes += allocationSizeInBytes;
+	self->bytesAllocated += allocationSizeInBytes;
 
 	return true;
 }
@@ -96,7 +183,7 @@ static bool allocator_allocate( le_allocator_o* self, uint64_t numBytes, void**
 // ----------------------------------------------------------------------
 
 static le_buf_resource_handle allocator_get_le_resource_id( le_allocator_o* self ) {
-	return self->resourceId;
+	return self->base.resourceId;
 }
 
 // ----------------------------------------------------------------------
@@ -110,6 +197,9 @@ void register_le_allocator_linear_api( void* api_ ) {
 	le_allocator_linear_i.destroy            = allocator_destroy;
 	le_allocator_linear_i.allocate           = allocator_allocate;
 	le_allocator_linear_i.reset              = allocator_reset;
+	le_allocator_linear_i.set_base_block     = allocator_set_base_block;
+	le_allocator_linear_i.set_grow_callback  = allocator_set_grow_callback;
+	le_allocator_linear_i.get_stats          = allocator_get_stats;
 }
 
 // ----------------------------------------------------------------------
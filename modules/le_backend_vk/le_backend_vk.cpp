@@ -8,6 +8,8 @@
 #include "le_window.h"
 #include "le_renderer.h"
 #include "private/le_renderer/le_resource_handle_t.inl"
+#include "private/le_backend_vk/le_resource_table.h"
+#include "private/le_core/le_setting_snapshot.h" // for publishing stats to the console
 #include "3rdparty/src/spooky/SpookyV2.h" // for hashing renderpass gestalt
 
 #include "le_tracy.h"
@@ -19,10 +21,12 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <forward_list>
 #include <sstream>
 #include <iomanip>
 #include <list>
+#include <deque>
 #include <set>
 #include <atomic>
 #include <mutex>
@@ -30,11 +34,13 @@
 #include <cstring> // for memcpy
 #include <array>
 #include <algorithm> // for std::find, for std::max
+#include <numeric>   // for std::lcm
 
 #include "util/volk/volk.h"
 
 #include "le_backend_vk_settings.inl"
 #include "private/le_backend_vk/vk_to_str_helpers.inl"
+#include "private/le_backend_vk/le_backend_types_pipeline.inl" // for le_graphics_pipeline_builder_data (dynamic state defaults)
 
 #include "private/le_backend_vk/le_backend_vk_instance.inl"
 
@@ -77,6 +83,9 @@ LE_WRAP_ENUM_IN_STRUCT( VkFormat, VkFormatEnum ); // define wrapper struct `VkFo
 constexpr size_t LE_FRAME_DATA_POOL_BLOCK_SIZE  = 1u << 24; // 16.77 MB
 constexpr size_t LE_FRAME_DATA_POOL_BLOCK_COUNT = 1;
 constexpr size_t LE_LINEAR_ALLOCATOR_SIZE       = 1u << 24;
+constexpr size_t LE_STAGING_CHUNK_SIZE          = 1u << 24;                  // 16.77 MB, persistently mapped
+constexpr size_t LE_STAGING_DEDICATED_THRESHOLD = LE_STAGING_CHUNK_SIZE / 4; // uploads larger than this get their own buffer
+constexpr size_t LE_STAGING_ALIGNMENT           = 16;                        // minimum alignment for staging ranges: multiple of 4, and of compressed texel block sizes
 
 static constexpr VkImageSubresourceRange LE_IMAGE_SUBRESOURCE_RANGE_ALL_MIPLEVELS{
     .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -428,18 +437,33 @@ struct AllocatedResourceVk {
 		VkAccelerationStructureKHR blas; // bottom level acceleration structure
 		VkAccelerationStructureKHR tlas; // top level acceleration structure
 	} as;
-	ResourceCreateInfo info;  // Creation info for resource
-	ResourceState      state; // sync state for resource
+	ResourceCreateInfo info;            // Creation info for resource
+	ResourceState      state;           // sync state for resource
 	uint32_t           padding__;
+	uint64_t           last_used_frame; // number of the most recent frame which used this resource - only maintained for backend-wide resources
+};
+
+// A large, persistently mapped staging buffer. Staging allocators sub-allocate
+// from chunks by atomically bumping `offset`.
+struct le_staging_chunk_t {
+	VkBuffer               buffer;
+	VmaAllocation          allocation;
+	VmaAllocationInfo      allocationInfo; // pMappedData stays valid for the lifetime of the chunk
+	uint64_t               capacity;
+	std::atomic<uint64_t>  offset;         // next free byte; never grows past capacity
+	le_buf_resource_handle handle;         // staging handle under which this chunk is used in the current frame
 };
 
 struct le_staging_allocator_o {
-	VmaAllocator                   allocator;      // non-owning, refers to backend allocator object
-	VkDevice                       device;         // non-owning, refers to vulkan device object
-	std::mutex                     mtx;            // protects all staging* elements
-	std::vector<VkBuffer>          buffers;        // 0..n staging buffers used with the current frame (freed on frame clear)
-	std::vector<VmaAllocation>     allocations;    // SOA: counterpart to buffers[]
-	std::vector<VmaAllocationInfo> allocationInfo; // SOA: counterpart to buffers[]
+	VmaAllocator                     allocator;              // non-owning, refers to backend allocator object
+	VkDevice                         device;                 // non-owning, refers to vulkan device object
+	std::atomic<le_staging_chunk_t*> current_chunk;          // chunk to sub-allocate from without taking a lock, nullptr after reset
+	std::mutex                       mtx;                    // protects all elements below
+	std::vector<le_staging_chunk_t*> chunks;                 // owning; persistent, kept mapped across frames
+	size_t                           num_chunks_used;        // number of chunks[] handed out since last reset
+	std::vector<VkBuffer>            buffers;                // 0..n staging buffers used with the current frame, indexed by staging handle index
+	std::vector<VkBuffer>            dedicatedBuffers;       // buffers for uploads too large for chunks (freed on frame clear)
+	std::vector<VmaAllocation>       dedicatedAllocations;   // SOA: counterpart to dedicatedBuffers[]
 };
 
 // ------------------------------------------------------------
@@ -517,6 +541,13 @@ struct swapchain_state_t {
 	swapchain_data_t                    swapchain_data;
 };
 
+// User data for transient allocator grow callbacks, so that the callback knows
+// which frame to add blocks to. See `backend_transient_allocator_grow`.
+struct backend_transient_block_source_t {
+	struct le_backend_o* backend;
+	size_t               frame_index;
+};
+
 // Herein goes all data which is associated with the current frame.
 // Backend keeps track of multiple frames, exactly one per renderer::FrameData frame.
 //
@@ -525,8 +556,11 @@ struct swapchain_state_t {
 // with other threads processing other frames concurrently.
 struct BackendFrameData {
 
-	VkFence  frameFence  = nullptr; // protects the frame - cpu waits on gpu to pass fence before deleting/recycling frame
-	uint64_t frameNumber = 0;       // current frame number
+	uint64_t completion_value = 0; // protects the frame - default graphics queue's timeline semaphore reaches this value once frame has completed on gpu
+	uint64_t frameNumber      = 0; // current frame number
+
+	uint32_t num_queue_submit_calls = 0; // number of calls to vkQueueSubmit2 when this frame was dispatched
+	uint32_t num_queue_submissions  = 0; // number of batches (VkSubmitInfo2) which these calls submitted
 
 	struct CommandPool {
 		VkCommandPool                pool;                // One pool per submission - must be allocated from the same queue the commands get submitted to.
@@ -554,13 +588,13 @@ struct BackendFrameData {
 
 	using texture_map_t = std::unordered_map<le_texture_handle, Texture>;
 
-	std::unordered_map<le_img_resource_handle, VkImageView> imageViews; // non-owning, references to frame-local textures, cleared on frame fence.
+	ResourceTable<le_img_resource_handle, VkImageView> imageViews; // non-owning, references to frame-local textures, cleared on frame fence.
 
 	// With `syncChainTable` and image_attachment_info_o.syncState, we should
 	// be able to create renderpasses. Each resource has a sync chain, and each attachment_info
 	// has a struct which holds indices into the sync chain telling us where to look
 	// up the sync state for a resource at different stages of renderpass construction.
-	using sync_chain_table_t = std::unordered_map<le_resource_handle, std::vector<ResourceState>>;
+	using sync_chain_table_t = ResourceTable<le_resource_handle, std::vector<ResourceState>>;
 	sync_chain_table_t syncChainTable;
 
 	static_assert( sizeof( VkBuffer ) == sizeof( VkImageView ) && sizeof( VkBuffer ) == sizeof( VkImage ), "size of AbstractPhysicalResource components must be identical" );
@@ -568,7 +602,7 @@ struct BackendFrameData {
 	// Map from renderer resource id to physical resources - only contains resources this frame uses.
 	// Q: Does this table actually own the resources?
 	// A: It must not: as it is used to map external resources as well.
-	std::unordered_map<le_resource_handle, AbstractPhysicalResource> physicalResources;
+	ResourceTable<le_resource_handle, AbstractPhysicalResource> physicalResources;
 
 	/// \brief vk resources retained and destroyed with BackendFrameData.
 	/// These resources (such as samplers, imageviews, framebuffers) are transient,
@@ -578,7 +612,7 @@ struct BackendFrameData {
 	/// \brief if user provides explicit resource info, we collect this here, so that we can make sure
 	/// that any inferred resourceInfo is compatible with what the user selected.
 	/// there is no guarantee that declared resources are unique, which means we must consolidate.
-	std::unordered_map<le_resource_handle, le_resource_info_t> declared_resources; // | pre-declared resources (explicitly declared via rendergraph)
+	ResourceTable<le_resource_handle, le_resource_info_t> declared_resources; // | pre-declared resources (explicitly declared via rendergraph)
 
 	std::vector<BackendRenderPass>   passes;
 	std::vector<le::RootPassesField> queue_submission_keys; // One key per isolated queue invocation,
@@ -592,7 +626,7 @@ struct BackendFrameData {
 
 	std::vector<VkDescriptorPool> descriptorPools; // one descriptor pool per pass
 
-	typedef std::unordered_map<le_resource_handle, AllocatedResourceVk> ResourceMap_T;
+	typedef ResourceTable<le_resource_handle, AllocatedResourceVk> ResourceMap_T;
 
 	ResourceMap_T availableResources; // resources this frame may use - each entry represents an association between a le_resource_handle and a vk resource
 	ResourceMap_T binnedResources;    // resources to delete when this frame comes round to clear()
@@ -605,19 +639,131 @@ struct BackendFrameData {
 	  independent block of memory allcated from the frame pool. This way, encoders can work on their
 	  own thread.
 
+	  If a sub-allocator runs out of memory, it chains an additional block, which gets appended
+	  to allocatorBuffers, allocations, and allocationInfos, after the base blocks (one per
+	  allocator). Additional blocks are released when the frame gets cleared, and base blocks
+	  grow to cover the peak use that was observed.
+
 	 */
 	VmaPool allocationPool; // pool from which allocations for this frame come from
 
 	std::vector<le_allocator_o*>   allocators;       // owning; typically one per `le_worker_thread`.
-	std::vector<VkBuffer>          allocatorBuffers; // per allocator: one vkBuffer
-	std::vector<VmaAllocation>     allocations;      // per allocator: one allocation
-	std::vector<VmaAllocationInfo> allocationInfos;  // per allocator: one allocationInfo
+	std::vector<VkBuffer>          allocatorBuffers; // per allocator: one vkBuffer (base block), followed by any additional blocks
+	std::vector<VmaAllocation>     allocations;      // per allocatorBuffer: one allocation
+	std::vector<VmaAllocationInfo> allocationInfos;  // per allocatorBuffer: one allocationInfo
+
+	backend_transient_block_source_t* transientBlockSource = nullptr; // owning; user data for transient allocator grow callbacks
 
 	le_staging_allocator_o* stagingAllocator; // owning: allocator for large objects to GPU memory
 
 	std::vector<le_command_stream_t*> command_streams; // owning; these must be destroyed when frame gets destroyed.
 
 	bool must_create_queues_dot_graph = false;
+
+	// GPU profiling: each profiled pass writes two timestamp queries, and may use one pipeline
+	// statistics query. Results are read back, and queries reset, when the frame gets cleared.
+	struct GpuPassQuery {
+		std::string debug_name;     // copy of pass debug name
+		uint32_t    queue_idx;      // queue to which pass was submitted - determines valid timestamp bits
+		bool        has_statistics; // whether a pipeline statistics query was recorded for this pass
+	};
+	VkQueryPool               gpu_timestamp_pool  = nullptr; // owning; two queries per pass: begin, end
+	VkQueryPool               gpu_statistics_pool = nullptr; // owning; one query per pass, only at gpu profiling level 2
+	uint32_t                  gpu_query_capacity  = 0;       // number of passes for which pools hold queries
+	std::vector<GpuPassQuery> gpu_pass_queries;              // one entry per profiled pass, index matches query index
+
+	std::vector<uint64_t> cached_renderpass_keys;  // one entry per reference held on backend renderpass cache, released when frame gets cleared
+	std::vector<uint64_t> cached_framebuffer_keys; // one entry per reference held on backend framebuffer cache, released when frame gets cleared
+	std::vector<uint64_t> cached_sampler_keys;     // one entry per reference held on backend sampler cache, released when frame gets cleared
+};
+
+// An upload which was requested via `upload_to_buffer` or `upload_to_image`.
+// Data to upload is held in a staging buffer owned by the request.
+struct BackendUploadRequest {
+	uint64_t                     ticket;
+	le_resource_handle           dst;                // buffer or image resource which receives data
+	le_resource_info_t           dst_info;           // used to allocate dst if it was not yet allocated
+	bool                         has_dst_info;       // whether dst_info is valid
+	uint64_t                     dst_offset;         // buffers only: offset into dst in bytes
+	le_write_to_image_settings_t image_settings;     // images only: target region
+	uint64_t                     num_bytes;          //
+	VkBuffer                     staging_buffer;     // owning
+	VmaAllocation                staging_allocation; // owning
+};
+
+// Uploads which were submitted together to the same queue. A batch is complete once
+// the timeline semaphore for its queue has reached `signal_value`.
+struct BackendUploadBatch {
+	std::vector<BackendUploadRequest> requests;           // staging buffers are freed once batch is complete
+	VkCommandBuffer                   cmd;                //
+	uint32_t                          queue_idx;          // queue to which batch is submitted
+	uint32_t                          queue_family_index; // family of the command pool from which cmd was allocated
+	VkSemaphore                       semaphore;          // non-owning: timeline semaphore for the queue to which batch was submitted
+	uint64_t                          signal_value;       //
+};
+
+struct BackendUploadTimeline {
+	VkSemaphore semaphore; // owning
+	uint64_t    value;     // last value signalled
+};
+
+// Incremental defragmentation for long-lived resources. Long-lived resources are allocated
+// from pools of their own, so that nothing but backend resources ever gets moved. We defragment
+// one pool at a time, and move at most LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME per pass.
+//
+// A pass starts on acquire, and ends once its copies, and all frames which may have used
+// the old versions of moved resources have completed - which usually takes a few frames.
+struct BackendDefragmentation {
+	std::vector<std::pair<uint32_t, VmaPool>> pools;      // owning; one pool per memory type index
+	size_t                                    pool_index; // pool which we currently defragment
+	VmaDefragmentationContext                 context;    // non-null while we defragment pools[pool_index]
+	uint64_t                                  next_sweep_frame;
+
+	bool                             is_pass_open;
+	VmaDefragmentationPassMoveInfo   pass;                // moves for the open pass - owned by VMA
+	std::vector<le_resource_handle>  moved_resources;     // resources which were moved in the open pass
+	std::vector<AllocatedResourceVk> retired_objects;     // old buffers and images of moved resources - destroyed once pass ends, their memory is freed by VMA
+	std::vector<AllocatedResourceVk> deferred_bins;       // binned resources with allocations which take part in the open pass - freed once pass ends
+	uint64_t                         move_frame_number;   // only frames from this frame on may submit copies for the open pass
+	uint64_t                         copy_complete_value; // default graphics queue timeline reaches this value once copies have completed, 0 if not submitted
+	uint64_t                         pass_bytes_moved;    //
+
+	VkCommandPool   command_pool; // owning; created on first use, for the default graphics queue family
+	VkCommandBuffer cmd;          // copy commands for the open pass, nullptr if there is nothing to copy
+
+	uint64_t num_moves;   // total number of moved resources
+	uint64_t bytes_moved; // total number of moved bytes
+};
+
+// Renderpasses and framebuffers are cached across frames. Each frame holds one reference
+// per use of a cache entry until the frame gets cleared.
+struct CachedRenderPass {
+	VkRenderPass          renderpass;      // owning
+	std::vector<uint64_t> key;             // serialized create info - compared on lookup, as cache is keyed by its hash
+	uint32_t              refcount;        // number of references held by frames which have not been cleared yet
+	uint64_t              last_used_frame; // entries which are unreferenced, and have not been used for a while, get evicted
+};
+
+struct CachedFramebuffer {
+	VkFramebuffer            framebuffer;     // owning
+	std::vector<uint64_t>    key;             // serialized renderpass, extents, attachment images and formats - compared on lookup
+	std::vector<VkImageView> image_views;     // owning: one view per attachment
+	std::vector<VkImage>     images;          // non-owning: attachment images - framebuffer must be evicted before any of these gets destroyed
+	VkRenderPass             renderpass;      // non-owning: framebuffer must be evicted before its renderpass
+	uint32_t                 refcount;        // number of references held by frames which have not been cleared yet
+	uint64_t                 last_used_frame; //
+};
+
+struct CachedImageView {
+	VkImageView           image_view; // owning
+	VkImageViewCreateInfo info;       // create info - compared on lookup, as cache is keyed by its hash
+};
+
+struct CachedSampler {
+	VkSampler           sampler;         // owning
+	VkSamplerCreateInfo info;            // create info - compared on lookup, as cache is keyed by its hash
+	uint32_t            refcount;        // number of references held by frames which have not been cleared yet
+	uint64_t            last_used_frame; // entries which are unreferenced, and have not been used for a while, get evicted
 };
 
 /// \brief backend data object
@@ -645,7 +791,7 @@ struct le_backend_o {
 
 	// Siloed per-frame memory
 	std::vector<BackendFrameData> mFrames;
-	uint64_t                      mFramesCount = 0; // total number of rendered or in-flight data frames
+	std::atomic<uint64_t>         mFramesCount = 0; // total number of rendered or in-flight data frames - frames are numbered on clear, before they get recorded
 
 	le_pipeline_manager_o* pipelineCache = nullptr;
 
@@ -658,6 +804,42 @@ struct le_backend_o {
 
 	std::unordered_map<le_resource_handle, uint64_t> resource_queue_family_ownership[ 2 ]; // per-resource queue family ownership - we use this to detect queue family ownership change for resources
 
+	std::mutex transient_blocks_mutex; // protects per-frame allocatorBuffers, allocations, allocationInfos while encoders chain transient blocks
+
+	// Asynchronous uploads - requests may be added from any thread, batches are submitted and retired on dispatch.
+	std::mutex                                          uploads_mutex;             // protects uploads_pending, uploads_in_flight, uploads_failed, uploads_next_ticket
+	std::deque<BackendUploadRequest>                    uploads_pending;           // requests which have not been submitted yet
+	std::vector<BackendUploadBatch>                     uploads_in_flight;         // batches which have been submitted, but may not be complete
+	std::unordered_set<uint64_t>                        uploads_failed;            // tickets for requests which were dropped because they could not be submitted - erased once reported
+	uint64_t                                            uploads_next_ticket   = 1; // 0 is reserved to signal an error
+	uint32_t                                            uploads_queue_idx     = 0; // preferred queue for uploads: a transfer-only queue, if available
+	std::unordered_map<uint32_t, BackendUploadTimeline> uploads_timelines;         // per queue index; only accessed on dispatch
+	std::unordered_map<uint32_t, VkCommandPool>         uploads_command_pools;     // per queue family index; only accessed on dispatch
+
+	// Residency - evictable images may be freed when device-local memory exceeds its budget.
+	std::mutex                                       residency_mutex;                   // protects evictable_images, evicted_images, residency_pending_evictions
+	std::unordered_set<le_resource_handle>           evictable_images;                  // images which may be evicted, if not recently used
+	std::unordered_set<le_resource_handle>           evicted_images;                    // images selected for eviction, until their eviction is acknowledged via was_image_evicted
+	std::unordered_map<le_resource_handle, uint64_t> residency_pending_evictions;       // images selected for eviction -> number of first frame recorded after acknowledgement, or UINT64_MAX if not yet acknowledged
+	uint64_t                                         residency_next_eviction_frame = 0; // we don't evict again until frames which hold evicted images in their bins have come around
+	uint64_t                                         residency_num_evicted         = 0; // total number of evicted images
+	uint64_t                                         residency_bytes_evicted       = 0; // total number of bytes evicted
+
+	BackendDefragmentation defragmentation = {}; // access only with allocated resources locked
+
+	// GPU profiling - only used if gpu profiling level was set via backend settings.
+	std::mutex                                            gpu_timings_mutex;           // protects gpu_pass_timings
+	std::unordered_map<std::string, le_gpu_pass_timing_t> gpu_pass_timings;            // most recent timings per pass debug name - keys provide storage for debug_name
+	std::vector<uint64_t>                                 gpu_timestamp_masks;         // per queue index: mask of valid timestamp bits, 0 if queue can't write timestamps
+	double                                                gpu_timestamp_period_ns = 0; // nanoseconds per timestamp tick
+
+	// Renderpass, framebuffer, image view, and sampler caches - shared by all frames, so that steady-state frames don't create any.
+	std::mutex                                                                 render_object_cache_mutex; // protects all caches below
+	std::unordered_map<uint64_t, CachedRenderPass>                             renderpass_cache;          // key: hash over serialized renderpass create info
+	std::unordered_map<uint64_t, CachedFramebuffer>                            framebuffer_cache;         // key: hash over serialized renderpass, extents, attachment images and formats
+	std::unordered_map<VkImage, std::unordered_map<uint64_t, CachedImageView>> image_view_cache;          // per backend-owned image: views keyed by hash over view create info; destroyed with their image
+	std::unordered_map<uint64_t, CachedSampler>                                sampler_cache;             // key: hash over sampler create info; unreferenced samplers get evicted like renderpasses
+
   private:
 	// Vulkan resources which are available to all frames.
 	// Generally, a resource needs to stay alive until the last frame that uses it has crossed its fence.
@@ -765,6 +947,15 @@ static le_backend_o* backend_create() {
 	return self;
 }
 
+// ----------------------------------------------------------------------
+// ffdecl.
+static void backend_frame_release_transient_blocks( le_backend_o* self, BackendFrameData& frame );
+static void backend_frame_resize_transient_base_blocks( le_backend_o* self, BackendFrameData& frame );
+static void backend_uploads_setup( le_backend_o* self );
+static void backend_uploads_destroy( le_backend_o* self );
+static void backend_defragment_destroy( le_backend_o* self );
+static void backend_render_object_cache_destroy( le_backend_o* self, VkDevice device );
+
 // ----------------------------------------------------------------------
 
 static void backend_destroy( le_backend_o* self ) {
@@ -790,14 +981,21 @@ static void backend_destroy( le_backend_o* self ) {
 
 	vkDeviceWaitIdle( self->device.get()->getVkDevice() );
 
+	// Free staging buffers, command pools, and semaphores used for asynchronous uploads
+	backend_uploads_destroy( self );
+
+	// Destroy cached framebuffers and renderpasses - this must happen before we destroy any images
+	backend_render_object_cache_destroy( self, device );
+
+	// End any open defragmentation pass - this destroys old versions of moved resources
+	backend_defragment_destroy( self );
+
 	for ( auto& frameData : self->mFrames ) {
 
 		using namespace le_backend_vk;
 
 		// -- destroy per-frame data
 
-		vkDestroyFence( device, frameData.frameFence, nullptr );
-
 		frameData.frame_owned_swapchain_state.clear();
 
 		{
@@ -815,6 +1013,8 @@ static void backend_destroy( le_backend_o* self ) {
 
 		{
 			// Destroy linear allocators, and the buffers allocated for them.
+			backend_frame_release_transient_blocks( self, frameData );
+
 			assert( frameData.allocatorBuffers.size() == frameData.allocators.size() &&
 			        frameData.allocatorBuffers.size() == frameData.allocations.size() &&
 			        frameData.allocatorBuffers.size() == frameData.allocationInfos.size() );
@@ -831,6 +1031,16 @@ static void backend_destroy( le_backend_o* self ) {
 			frameData.allocatorBuffers.clear();
 			frameData.allocations.clear();
 			frameData.allocationInfos.clear();
+
+			delete frameData.transientBlockSource;
+			frameData.transientBlockSource = nullptr;
+		}
+
+		if ( frameData.gpu_timestamp_pool ) {
+			vkDestroyQueryPool( device, frameData.gpu_timestamp_pool, nullptr );
+		}
+		if ( frameData.gpu_statistics_pool ) {
+			vkDestroyQueryPool( device, frameData.gpu_statistics_pool, nullptr );
 		}
 
 		vmaDestroyPool( self->mAllocator, frameData.allocationPool );
@@ -902,6 +1112,13 @@ static void backend_destroy( le_backend_o* self ) {
 
 		allocated_resources.clear();
 	}
+
+	// Pools for long-lived resources are empty now.
+	for ( auto& [ memory_type_index, pool ] : self->defragmentation.pools ) {
+		vmaDestroyPool( self->mAllocator, pool );
+	}
+	self->defragmentation.pools.clear();
+
 	if ( self->mAllocator ) {
 		vmaDestroyAllocator( self->mAllocator );
 		self->mAllocator = nullptr;
@@ -1159,7 +1376,7 @@ static le_img_resource_handle backend_get_swapchain_resource_default( le_backend
 /// Vulkan buffer backing. Instead, they use their Frame's buffer for storage. Virtual buffers
 /// are used to store Frame-local transient data such as values for shader parameters.
 /// Each Encoder uses its own virtual buffer for such purposes.
-static le_buf_resource_handle declare_resource_virtual_buffer( uint8_t index ) {
+static le_buf_resource_handle declare_resource_virtual_buffer( uint16_t index ) {
 
 	le_buf_resource_handle resource =
 	    le_renderer::renderer_i.produce_buf_resource_handle( "Encoder-Virtual", le_buf_resource_usage_flags_t::eIsVirtual, index );
@@ -1328,6 +1545,8 @@ static void backend_initialise( le_backend_o* self ) {
 	if ( self->must_track_resources_queue_family_ownership ) {
 		le::Log( LOGGER_LABEL ).info( "Multiple queue families detected - tracking queue ownership per-resource." );
 	}
+
+	backend_uploads_setup( self );
 	self->pipelineCache = le_pipeline_manager_i.create( *self->device );
 }
 // ----------------------------------------------------------------------
@@ -1340,6 +1559,10 @@ static void backend_create_main_allocator( VkInstance instance, VkPhysicalDevice
 	if ( settings->requested_device_features.vk_12.bufferDeviceAddress ) {
 		createInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 	}
+	// Query per-heap budgets from the driver, if VK_EXT_memory_budget was requested, and is supported
+	if ( settings->memory_budget_enabled ) {
+		createInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+	}
 	createInfo.device = device;
 
 	VmaVulkanFunctions vma_vulkan_functions{};
@@ -1391,6 +1614,8 @@ static void backend_setup( le_backend_o* self ) {
 
 	backend_create_main_allocator( vkInstance, vkPhysicalDevice, vkDevice, &self->mAllocator );
 
+	backend_gpu_profiling_setup( self );
+
 	// -- setup backend memory objects
 
 	self->mFrames.reserve( settings->data_frames_count );
@@ -1406,16 +1631,6 @@ static void backend_setup( le_backend_o* self ) {
 		BackendFrameData frameData{};
 		frameData.frameNumber = i;
 
-		{
-			VkFenceCreateInfo create_info = {
-			    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-			    .pNext = nullptr, // optional
-			    .flags = 0,       // optional
-			};
-
-			vkCreateFence( vkDevice, &create_info, nullptr, &frameData.frameFence ); // frence starts out as sigmalled
-		}
-
 		{
 			// -- set up an allocation pool for each frame
 			// so that each frame can create sub-allocators
@@ -1996,18 +2211,18 @@ static void backend_debug_print_framedata( BackendFrameData const& frame ) {
 // ----------------------------------------------------------------------
 
 /// \brief polls frame fence, returns true if fence has been crossed, false otherwise.
+///
+/// Frame completion is tracked via the default graphics queue's timeline semaphore:
+/// a frame has completed once the semaphore has reached the frame's completion value.
+/// This never blocks - use `wait_frame_fence` to block until a frame has completed.
 static bool backend_poll_frame_fence( le_backend_o* self, size_t frameIndex ) {
 	ZoneScoped;
 	static auto logger = LeLog( LOGGER_LABEL );
 	auto&       frame  = self->mFrames[ frameIndex ];
 	VkDevice    device = self->device->getVkDevice();
 
-	// Non-blocking, polling
-	// auto result = device.getFenceStatus( {frame.frameFence} );
-
-	// NOTE: this may block.
-	auto result = vkWaitForFences( device, 1, &frame.frameFence, true, 100'000'000 );
-	// le::Log( LOGGER_LABEL ).info( "=[%3d]== frame fence cleared", frameIndex );
+	uint64_t value  = 0;
+	auto     result = vkGetSemaphoreCounterValue( device, self->queues[ self->queue_default_graphics_idx ]->semaphore, &value );
 
 	if ( result == VK_ERROR_DEVICE_LOST ) {
 		logger.error( "Poll Frame Fence returned: %s", to_str_vk_result( result ) );
@@ -2015,5158 +2230,8200 @@ static bool backend_poll_frame_fence( le_backend_o* self, size_t frameIndex ) {
 	} else if ( result != VK_SUCCESS ) {
 		logger.warn( "Poll Frame Fence returned: %s", to_str_vk_result( result ) );
 		return false;
-	} else {
-		return true;
 	}
+
+	return value >= frame.completion_value;
 }
 
 // ----------------------------------------------------------------------
-/// \brief: Frees all frame local resources
-/// \preliminary: frame fence must have been crossed.
-static bool backend_clear_frame( le_backend_o* self, size_t frameIndex ) {
-	ZoneScoped;
 
+/// \brief blocks until frame has completed, or until timeout has passed.
+/// returns true if frame has completed, false on timeout.
+static bool backend_wait_frame_fence( le_backend_o* self, size_t frameIndex, uint64_t timeout_ns ) {
+	ZoneScoped;
 	static auto logger = LeLog( LOGGER_LABEL );
+	auto&       frame  = self->mFrames[ frameIndex ];
+	VkDevice    device = self->device->getVkDevice();
 
-	using namespace le_backend_vk;
+	VkSemaphoreWaitInfo wait_info{
+	    .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .pNext          = nullptr, // optional
+	    .flags          = 0,       // optional
+	    .semaphoreCount = 1,
+	    .pSemaphores    = &self->queues[ self->queue_default_graphics_idx ]->semaphore,
+	    .pValues        = &frame.completion_value,
+	};
 
-	auto&    frame  = self->mFrames[ frameIndex ];
-	VkDevice device = self->device->getVkDevice();
+	auto result = vkWaitSemaphores( device, &wait_info, timeout_ns );
 
-	// le::Log( LOGGER_LABEL ).info( "=[%3d]== clear frame ", frameIndex );
+	if ( result == VK_ERROR_DEVICE_LOST ) {
+		logger.error( "Wait Frame Fence returned: %s", to_str_vk_result( result ) );
+		exit( 1 );
+	} else if ( result != VK_SUCCESS && result != VK_TIMEOUT ) {
+		logger.warn( "Wait Frame Fence returned: %s", to_str_vk_result( result ) );
+	}
 
-	// -------- Invariant: fence has been crossed, all resources protected by fence
-	//          can now be claimed back.
+	return result == VK_SUCCESS;
+}
 
-	vkResetFences( device, 1, &frame.frameFence );
+// ----------------------------------------------------------------------
+// Finds out which queues may write timestamps, and how to convert timestamps to time.
+static void backend_gpu_profiling_setup( le_backend_o* self ) {
 
-	// -- reset all frame-local sub-allocators
-	for ( auto& alloc : frame.allocators ) {
-		le_allocator_linear_i.reset( alloc );
-	}
+	using namespace le_backend_vk;
 
-	// -- reset frame-local staging allocator
-	le_staging_allocator_i.reset( frame.stagingAllocator );
+	auto settings = api->backend_settings_singleton;
 
-	// -- remove any texture references
-	frame.textures_per_pass.clear();
+	self->gpu_timestamp_masks.assign( self->queues.size(), 0 );
 
-	// -- remove any image view references
-	frame.imageViews.clear();
+	if ( settings->gpu_profiling_level == 0 ) {
+		return;
+	}
 
-	// -- remove any frame-local copy of allocated resources
-	frame.availableResources.clear();
-	frame.declared_resources.clear();
+	VkPhysicalDevice physical_device = self->device->getVkPhysicalDevice();
 
-	frame.must_create_queues_dot_graph = false;
-	frame.debug_root_passes_names.clear();
+	uint32_t num_families = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties( physical_device, &num_families, nullptr );
+	std::vector<VkQueueFamilyProperties> families( num_families );
+	vkGetPhysicalDeviceQueueFamilyProperties( physical_device, &num_families, families.data() );
 
-	for ( auto& d : frame.descriptorPools ) {
-		vkResetDescriptorPool( device, d, VkDescriptorPoolResetFlags() );
+	for ( size_t i = 0; i != self->queues.size(); i++ ) {
+		uint32_t valid_bits = families[ self->queues[ i ]->queue_family_index ].timestampValidBits;
+
+		self->gpu_timestamp_masks[ i ] = valid_bits >= 64 ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << valid_bits ) - 1 );
 	}
 
-	{ // clear resources owned exclusively by this frame
+	self->gpu_timestamp_period_ns = vk_device_i.get_vk_physical_device_properties( *self->device )->limits.timestampPeriod;
+}
 
-		for ( auto& r : frame.ownedResources ) {
-			switch ( r.type ) {
-			case AbstractPhysicalResource::eBuffer:
-				vkDestroyBuffer( device, r.asBuffer, nullptr );
-				break;
-			case AbstractPhysicalResource::eFramebuffer:
-				vkDestroyFramebuffer( device, r.asFramebuffer, nullptr );
-				break;
-			case AbstractPhysicalResource::eImage:
-				vkDestroyImage( device, r.asImage, nullptr );
-				break;
-			case AbstractPhysicalResource::eImageView:
-				vkDestroyImageView( device, r.asImageView, nullptr );
-				break;
-			case AbstractPhysicalResource::eRenderPass:
-				vkDestroyRenderPass( device, r.asRenderPass, nullptr );
-				break;
-			case AbstractPhysicalResource::eSampler:
-				vkDestroySampler( device, r.asSampler, nullptr );
-				break;
+// ----------------------------------------------------------------------
+// Makes sure that the frame's query pools hold enough queries for all of the frame's passes.
+// Executes on the recording thread, before passes get recorded.
+static void backend_frame_prepare_gpu_queries( le_backend_o* self, BackendFrameData& frame ) {
 
-			case AbstractPhysicalResource::eUndefined:
-				logger.warn( "%s: abstract physical resource has unknown type (%p) and cannot be deleted. leaking...", __PRETTY_FUNCTION__, r.type );
-				break;
-			}
-		}
-		frame.ownedResources.clear();
-	}
+	using namespace le_backend_vk;
 
-	for ( auto& cp : frame.available_command_pools ) {
-		if ( cp->is_used ) {
-			vkFreeCommandBuffers( device, cp->pool, uint32_t( cp->buffers.size() ), cp->buffers.data() ); // shouldn't clearing the pool implicitly free all command buffers allocated from the pool?
-			vkResetCommandPool( device, cp->pool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT );
-			cp->is_used = false; // mark this command pool as available for recycling.
-		}
-		// Note that we don't clear `cp->buffers` - no need to do this as buffers
-		// get resized and overwritten whenever a pool gets re-used.
+	auto settings = api->backend_settings_singleton;
+
+	if ( settings->gpu_profiling_level == 0 ) {
+		return;
 	}
-	frame.queue_submission_data.clear();
 
-	frame.physicalResources.clear();
-	frame.syncChainTable.clear();
+	uint32_t num_passes = uint32_t( frame.passes.size() );
 
-	for ( auto& f : frame.passes ) {
-		if ( f.encoder ) {
-			using namespace le_renderer;
-			encoder_i.destroy( f.encoder );
-			f.encoder = nullptr;
-		}
+	if ( num_passes <= frame.gpu_query_capacity ) {
+		return;
 	}
-	frame.passes.clear();
 
-	// Reset command streams
-	for ( auto cs : frame.command_streams ) {
-		cs->reset();
+	// ----------| invariant: we must grow pools - previous pools were reset when the frame was cleared, and are not in use.
+
+	VkDevice device = self->device->getVkDevice();
+
+	if ( frame.gpu_timestamp_pool ) {
+		vkDestroyQueryPool( device, frame.gpu_timestamp_pool, nullptr );
+		frame.gpu_timestamp_pool = nullptr;
+	}
+	if ( frame.gpu_statistics_pool ) {
+		vkDestroyQueryPool( device, frame.gpu_statistics_pool, nullptr );
+		frame.gpu_statistics_pool = nullptr;
 	}
 
-	frame.frameNumber = self->mFramesCount++; // note post-increment
+	frame.gpu_query_capacity = std::max( num_passes, frame.gpu_query_capacity * 2 );
 
-	return true;
-};
-// ----------------------------------------------------------------------
-// we use this to mask out any reads in srcAccess, as it never makes sense to flush reads
-static constexpr auto ANY_WRITE_VK_ACCESS_2_FLAGS =
-    ( VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
-      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
-      VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
-      VK_ACCESS_2_HOST_WRITE_BIT |
-      VK_ACCESS_2_MEMORY_WRITE_BIT |
-      VK_ACCESS_2_SHADER_WRITE_BIT |
-      VK_ACCESS_2_TRANSFER_WRITE_BIT |
-      VK_ACCESS_2_COMMAND_PREPROCESS_WRITE_BIT_NV |
-      VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT );
+	VkQueryPoolCreateInfo timestamp_info = {
+	    .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+	    .pNext              = nullptr, // optional
+	    .flags              = 0,       // optional
+	    .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+	    .queryCount         = 2 * frame.gpu_query_capacity,
+	    .pipelineStatistics = 0, // optional
+	};
+
+	vkCreateQueryPool( device, &timestamp_info, nullptr, &frame.gpu_timestamp_pool );
+	vkResetQueryPool( device, frame.gpu_timestamp_pool, 0, timestamp_info.queryCount );
+
+	if ( settings->gpu_profiling_level >= 2 ) {
+		VkQueryPoolCreateInfo statistics_info = {
+		    .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		    .pNext              = nullptr, // optional
+		    .flags              = 0,       // optional
+		    .queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+		    .queryCount         = frame.gpu_query_capacity,
+		    .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+		                          VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		                          VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		                          VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT,
+		};
+
+		vkCreateQueryPool( device, &statistics_info, nullptr, &frame.gpu_statistics_pool );
+		vkResetQueryPool( device, frame.gpu_statistics_pool, 0, statistics_info.queryCount );
+	}
+}
 
 // ----------------------------------------------------------------------
-// Executes on the DISPATCH FRAME
+// Reads back query results for all passes which this frame profiled, updates per-pass
+// timings, and resets queries so that they may be used again.
 //
-static void backend_create_renderpasses( BackendFrameData& frame, VkDevice& device ) {
-	ZoneScoped;
-	static auto logger = LeLog( LOGGER_LABEL );
+// Timings are published via `get_gpu_pass_timings`, as Tracy plots (one per pass), and via
+// LE_SETTING_BACKEND_GPU_PASS_TIMINGS, which you can inspect via the console:
+// `get LE_SETTING_BACKEND_GPU_PASS_TIMINGS`
+//
+// Frame fence must have been crossed.
+static void backend_frame_read_gpu_queries( le_backend_o* self, BackendFrameData& frame ) {
 
-	const auto& syncChainTable = frame.syncChainTable;
+	if ( frame.gpu_pass_queries.empty() ) {
+		return;
+	}
 
-	// Note: This should be trivial to parallelize.
-	for ( auto& pass : frame.passes ) {
+	// ----------| invariant: some passes were profiled
 
-		// The rest of this loop only concerns draw passes
-		//
-		if ( pass.type != le::QueueFlagBits::eGraphics ) {
-			continue;
-		}
+	ZoneScoped;
 
-		// ---------| Invariant: current pass is a draw pass.
+	LE_SETTING( le_setting_snapshot_t, LE_SETTING_BACKEND_GPU_PASS_TIMINGS, "" );
 
-		std::vector<VkAttachmentDescription2> attachments;
-		attachments.reserve( pass.numColorAttachments + pass.numDepthStencilAttachments );
+	VkDevice device      = self->device->getVkDevice();
+	uint32_t num_queries = uint32_t( frame.gpu_pass_queries.size() );
 
-		std::vector<VkAttachmentReference2> colorAttachmentReferences;
-		std::vector<VkAttachmentReference2> resolveAttachmentReferences;
-		VkAttachmentReference2*             dsAttachmentReference = nullptr;
+	// With VK_QUERY_RESULT_WITH_AVAILABILITY_BIT, each result is followed by its availability -
+	// queries which were not written (e.g. because a submission was skipped) remain unavailable.
 
-		// We must accumulate these flags over all attachments - they are the
-		// union of all flags required by all attachments in a pass.
-		VkPipelineStageFlags2 srcStageFromExternalFlags  = 0;
-		VkPipelineStageFlags2 dstStageFromExternalFlags  = 0;
-		VkAccessFlags2        srcAccessFromExternalFlags = 0;
-		VkAccessFlags2        dstAccessFromExternalFlags = 0;
+	struct timestamp_result_t {
+		uint64_t value;
+		uint64_t available;
+	};
 
-		VkPipelineStageFlags2 srcStageToExternalFlags  = 0;
-		VkPipelineStageFlags2 dstStageToExternalFlags  = 0;
-		VkAccessFlags2        srcAccessToExternalFlags = 0;
-		VkAccessFlags2        dstAccessToExternalFlags = 0;
+	struct statistics_result_t {
+		uint64_t input_assembly_primitives;
+		uint64_t vertex_shader_invocations;
+		uint64_t fragment_shader_invocations;
+		uint64_t compute_shader_invocations;
+		uint64_t available;
+	};
 
-		if ( LE_PRINT_DEBUG_MESSAGES ) {
-			logger.info( "* Renderpass: '%s'", pass.debugName );
-			logger.info( " %40s : %30s : %30s : %30s", "Attachment", "Layout initial", "Layout subpass", "Layout final" );
-		}
+	std::vector<timestamp_result_t>  timestamps( 2 * num_queries );
+	std::vector<statistics_result_t> statistics( frame.gpu_statistics_pool ? num_queries : 0 );
 
-		auto const attachments_end = pass.attachments +
-		                             pass.numColorAttachments +
-		                             pass.numDepthStencilAttachments +
-		                             pass.numResolveAttachments;
+	vkGetQueryPoolResults( device, frame.gpu_timestamp_pool, 0, 2 * num_queries,
+	                       timestamps.size() * sizeof( timestamp_result_t ), timestamps.data(), sizeof( timestamp_result_t ),
+	                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT );
 
-		for ( AttachmentInfo const* attachment = pass.attachments; attachment != attachments_end; attachment++ ) {
+	if ( frame.gpu_statistics_pool ) {
+		vkGetQueryPoolResults( device, frame.gpu_statistics_pool, 0, num_queries,
+		                       statistics.size() * sizeof( statistics_result_t ), statistics.data(), sizeof( statistics_result_t ),
+		                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT );
+	}
 
-			auto& syncChain = syncChainTable.at( attachment->resource );
+	std::ostringstream msg;
 
-			const auto& syncInitial = syncChain.at( attachment->initialStateOffset );
-			const auto& syncSubpass = syncChain.at( attachment->initialStateOffset + 1 );
-			const auto& syncFinal   = syncChain.at( attachment->finalStateOffset );
+	{
+		auto lock = std::scoped_lock( self->gpu_timings_mutex );
 
-			bool isDepth   = false;
-			bool isStencil = false;
-			le_format_get_is_depth_stencil( attachment->format, isDepth, isStencil );
+		for ( uint32_t i = 0; i != num_queries; i++ ) {
 
-			VkAttachmentDescription2 attachmentDescription{
-			    .sType          = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2,
-			    .pNext          = nullptr,                        // optional
-			    .flags          = VkAttachmentDescriptionFlags(), // optional
-			    .format         = VkFormat( attachment->format ),
-			    .samples        = VkSampleCountFlagBits( attachment->numSamples ),
-			    .loadOp         = VkAttachmentLoadOp( attachment->loadOp ),
-			    .storeOp        = VkAttachmentStoreOp( attachment->storeOp ),
-			    .stencilLoadOp  = isStencil ? VkAttachmentLoadOp( attachment->loadOp ) : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-			    .stencilStoreOp = isStencil ? VkAttachmentStoreOp( attachment->storeOp ) : VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			    .initialLayout  = syncInitial.layout,
-			    .finalLayout    = syncFinal.layout,
-			};
+			auto const& q     = frame.gpu_pass_queries[ i ];
+			auto const& begin = timestamps[ 2 * i ];
+			auto const& end   = timestamps[ 2 * i + 1 ];
 
-			if ( LE_PRINT_DEBUG_MESSAGES ) {
-				logger.info( " %38s@%d : %30s → %30s → %30s | sync chain indices: %4d : %4d : %4d",
-				             attachment->resource->data->debug_name, 1 << attachment->resource->data->num_samples,
-				             to_str_vk_image_layout( syncInitial.layout ),
-				             to_str_vk_image_layout( syncSubpass.layout ),
-				             to_str_vk_image_layout( syncFinal.layout ),
-				             attachment->initialStateOffset,
-				             attachment->initialStateOffset + 1,
-				             attachment->finalStateOffset );
+			if ( !begin.available || !end.available ) {
+				continue;
 			}
 
-			attachments.emplace_back( attachmentDescription );
+			auto [ it, was_inserted ] = self->gpu_pass_timings.try_emplace( q.debug_name );
+			le_gpu_pass_timing_t& t   = it->second;
 
-			switch ( attachment->type ) {
-			case AttachmentInfo::Type::eDepthStencilAttachment:
-				dsAttachmentReference = new VkAttachmentReference2{
-				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
-				    .pNext      = nullptr, // optional
-				    .attachment = uint32_t( attachments.size() - 1 ),
-				    .layout     = syncSubpass.layout,
-				    .aspectMask = 0,
-				}; // cleanup at the end of loop
-				break;
-			case AttachmentInfo::Type::eColorAttachment:
-				colorAttachmentReferences.push_back( {
-				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
-				    .pNext      = nullptr, // optional
-				    .attachment = uint32_t( attachments.size() - 1 ),
-				    .layout     = syncSubpass.layout,
-				    .aspectMask = 0,
-				} );
-				break;
-			case AttachmentInfo::Type::eResolveAttachment:
-				resolveAttachmentReferences.push_back( {
-				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
-				    .pNext      = nullptr, // optional
-				    .attachment = uint32_t( attachments.size() - 1 ),
-				    .layout     = syncSubpass.layout,
-				    .aspectMask = 0,
-				} );
-				break;
+			if ( was_inserted || t.frame_number != frame.frameNumber ) {
+				// first measurement for this pass name in this frame
+				t              = {};
+				t.debug_name   = it->first.c_str();
+				t.frame_number = frame.frameNumber;
 			}
 
-			srcStageFromExternalFlags |= syncInitial.stage;
-			dstStageFromExternalFlags |= syncSubpass.stage;
-			srcAccessFromExternalFlags |= ( syncInitial.visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS );
-			dstAccessFromExternalFlags |= syncSubpass.visible_access; // & ~(syncInitial.visible_access );
-			// this would make only changes in availability operations happen. it should only happen if there are no src write_access_flags. we leave this out so as to give the driver more info
-
-			// TODO: deal with other subpasses ...
+			// Timestamps may wrap around - we only care about the difference, modulo valid bits.
+			uint64_t ticks = ( end.value - begin.value ) & self->gpu_timestamp_masks[ q.queue_idx ];
 
-			srcStageToExternalFlags |= syncChain.at( attachment->finalStateOffset - 1 ).stage;
-			dstStageToExternalFlags |= syncFinal.stage;
-			srcAccessToExternalFlags |= ( syncChain.at( attachment->finalStateOffset - 1 ).visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS );
-			dstAccessToExternalFlags |= syncFinal.visible_access;
+			t.gpu_ms += double( ticks ) * self->gpu_timestamp_period_ns / 1'000'000.0;
 
-			if ( 0 == uint64_t( srcStageFromExternalFlags ) ) {
-				// Ensure that the stage mask is valid if no src stage was specified.
-				srcStageFromExternalFlags = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
+			if ( q.has_statistics && statistics[ i ].available ) {
+				t.input_assembly_primitives += statistics[ i ].input_assembly_primitives;
+				t.vertex_shader_invocations += statistics[ i ].vertex_shader_invocations;
+				t.fragment_shader_invocations += statistics[ i ].fragment_shader_invocations;
+				t.compute_shader_invocations += statistics[ i ].compute_shader_invocations;
 			}
 		}
 
-		if ( LE_PRINT_DEBUG_MESSAGES ) {
-			logger.info( "" );
+		for ( auto const& [ name, t ] : self->gpu_pass_timings ) {
+			if ( t.frame_number != frame.frameNumber ) {
+				continue;
+			}
+			TracyPlot( t.debug_name, t.gpu_ms );
+			msg << "'" << name << "': " << std::fixed << std::setprecision( 3 ) << t.gpu_ms << " ms; ";
 		}
+	}
 
-		std::vector<VkSubpassDescription2> subpasses;
-		subpasses.reserve( 1 );
+	LE_SETTING_BACKEND_GPU_PASS_TIMINGS->publish( msg.str() );
 
-		{
-			VkSubpassDescription2 subpassDescription{
-			    .sType                   = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2,
-			    .pNext                   = nullptr, // optional
-			    .flags                   = 0,       // optional
-			    .pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS,
-			    .viewMask                = 0,
-			    .inputAttachmentCount    = 0, // optional
-			    .pInputAttachments       = nullptr,
-			    .colorAttachmentCount    = uint32_t( colorAttachmentReferences.size() ), // optional
-			    .pColorAttachments       = colorAttachmentReferences.data(),
-			    .pResolveAttachments     = resolveAttachmentReferences.empty() ? nullptr : resolveAttachmentReferences.data(), // optional
-			    .pDepthStencilAttachment = dsAttachmentReference,                                                              // optional
-			    .preserveAttachmentCount = 0,                                                                                  // optional
-			    .pPreserveAttachments    = nullptr,
-			};
+	vkResetQueryPool( device, frame.gpu_timestamp_pool, 0, 2 * num_queries );
 
-			subpasses.emplace_back( subpassDescription );
-		}
+	if ( frame.gpu_statistics_pool ) {
+		vkResetQueryPool( device, frame.gpu_statistics_pool, 0, num_queries );
+	}
 
-		VkMemoryBarrier2     memoryBarriers[ 2 ];
-		VkSubpassDependency2 dependencies[ 2 ];
+	frame.gpu_pass_queries.clear();
+}
 
-		{
-			if ( LE_PRINT_DEBUG_MESSAGES ) {
+// ----------------------------------------------------------------------
 
-				logger.info( "Subpass Dependency: VK_SUBPASS_EXTERNAL to subpass `%s`", pass.debugName );
-				logger.info( "\t srcStage: %-40s Anything in stage %1$s must happen-before", to_string_vk_pipeline_stage_flags2( srcStageFromExternalFlags ).c_str() );
-				logger.info( "\t dstStage: %-40s anything in stage %1$s.", to_string_vk_pipeline_stage_flags2( dstStageFromExternalFlags ).c_str() );
-				uint64_t( srcAccessFromExternalFlags )
-				    ? logger.info( "\tsrcAccess: %-40s Memory from stage %s, accessing %1$s must be made available", to_string_vk_access_flags2( srcAccessFromExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( srcStageFromExternalFlags ).c_str() )
-				    : logger.info( "\tsrcAccess: %-40s No memory needs to be made available", to_string_vk_access_flags2( srcAccessFromExternalFlags ).c_str() );
-				logger.info( "\tdstAccess: %-40s before memory is made visible to %1$s in stage %s", to_string_vk_access_flags2( dstAccessFromExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( dstStageFromExternalFlags ).c_str() );
+static void backend_get_gpu_pass_timings( le_backend_o* self, le_gpu_pass_timing_t* timings, uint32_t* num_timings ) {
 
-				logger.info( "Subpass Dependency: subpass `%s` to VK_SUBPASS_EXTERNAL:", pass.debugName );
-				logger.info( "\t srcStage: %-40s Anything in stage %1$s must happen-before", to_string_vk_pipeline_stage_flags2( srcStageToExternalFlags ).c_str() );
-				logger.info( "\t dstStage: %-40s anything in stage %1$s.", to_string_vk_pipeline_stage_flags2( dstStageToExternalFlags ).c_str() );
-				uint64_t( srcAccessToExternalFlags )
-				    ? logger.info( "\tsrcAccess: %-40s Memory from stage %s, accessing %1$s must be made available", to_string_vk_access_flags2( srcAccessToExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( srcStageToExternalFlags ).c_str() )
-				    : logger.info( "\tsrcAccess: %-40s No memory needs to be made available", to_string_vk_access_flags2( srcAccessToExternalFlags ).c_str() );
-				logger.info( "\tdstAccess: %-40s before memory is made visible to %1$s in stage %s", to_string_vk_access_flags2( dstAccessToExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( dstStageToExternalFlags ).c_str() );
-				logger.info( "" );
-			}
+	auto lock = std::scoped_lock( self->gpu_timings_mutex );
 
-			memoryBarriers[ 0 ] = {
-			    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
-			    .pNext         = nullptr,
-			    .srcStageMask  = srcStageFromExternalFlags,
-			    .srcAccessMask = srcAccessFromExternalFlags,
-			    .dstStageMask  = dstStageFromExternalFlags,
-			    .dstAccessMask = dstAccessFromExternalFlags,
-			};
-			memoryBarriers[ 1 ] = {
-			    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
-			    .pNext         = nullptr,
-			    .srcStageMask  = srcStageToExternalFlags,
-			    .srcAccessMask = srcAccessToExternalFlags,
-			    .dstStageMask  = dstStageToExternalFlags,
-			    .dstAccessMask = dstAccessToExternalFlags,
-			};
+	if ( timings == nullptr ) {
+		*num_timings = uint32_t( self->gpu_pass_timings.size() );
+		return;
+	}
 
-			dependencies[ 0 ] = {
-			    // external to subpass
-			    .sType           = VK_STRUCTURE_TYPE_SUBPASS_DEPENDENCY_2,
-			    .pNext           = memoryBarriers,              // optional
-			    .srcSubpass      = VK_SUBPASS_EXTERNAL,         // outside of renderpass
-			    .dstSubpass      = 0,                           // first subpass
-			    .srcStageMask    = 0,                           // not used
-			    .dstStageMask    = 0,                           // not used
-			    .srcAccessMask   = 0,                           // not used
-			    .dstAccessMask   = 0,                           // not used
-			    .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT, // optional
-			    .viewOffset      = 0,
-			};
-			dependencies[ 1 ] = {
-			    // subpass to external
-			    .sType           = VK_STRUCTURE_TYPE_SUBPASS_DEPENDENCY_2,
-			    .pNext           = memoryBarriers + 1,          // optional
-			    .srcSubpass      = 0,                           // last subpass
-			    .dstSubpass      = VK_SUBPASS_EXTERNAL,         // outside of subpass
-			    .srcStageMask    = 0,                           // not used
-			    .dstStageMask    = 0,                           // not used
-			    .srcAccessMask   = 0,                           // not used
-			    .dstAccessMask   = 0,                           // not used
-			    .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT, // optional
-			    .viewOffset      = 0,
-			};
-		}
+	// ----------| invariant: timings points to an array of at least num_timings elements
 
-		{
-			// -- Build hash for compatible renderpass
-			//
-			// We need to include all information that defines renderpass compatibility.
-			//
-			// We are not clear whether subpasses must be identical between two compatible renderpasses,
-			// therefore we don't include subpass information in calculating renderpass compatibility.
+	uint32_t i = 0;
 
-			// -- 1. hash attachments
-			// -- 2. hash subpass descriptions for each subpass
-			//       subpass descriptions are structs with vectors of index references to attachments
+	for ( auto it = self->gpu_pass_timings.begin(); it != self->gpu_pass_timings.end() && i != *num_timings; it++, i++ ) {
+		timings[ i ] = it->second;
+	}
 
-			{
-				uint64_t rp_hash = 0;
+	*num_timings = i;
+}
 
-				// -- hash attachments
-				for ( const auto& a : attachments ) {
+// ----------------------------------------------------------------------
+// Destroys a framebuffer cache entry, and the image views which it owns.
+static void render_object_cache_destroy_framebuffer( VkDevice device, CachedFramebuffer& fb ) {
+	vkDestroyFramebuffer( device, fb.framebuffer, nullptr );
+	for ( auto& iv : fb.image_views ) {
+		vkDestroyImageView( device, iv, nullptr );
+	}
+}
 
-					// We use offsetof so that we can get everything from flags to the start of the
-					// attachmentdescription to (but not including) loadOp.
-					static_assert(
-					    offsetof( VkAttachmentDescription2, loadOp ) -
-					            offsetof( VkAttachmentDescription2, flags ) ==
-					        sizeof( VkAttachmentDescription2::flags ) +
-					            sizeof( VkAttachmentDescription2::format ) +
-					            sizeof( VkAttachmentDescription2::samples ),
-					    "AttachmentDescription struct must be tightly packed for efficient hashing" );
+// ----------------------------------------------------------------------
+// Releases all references which the frame holds on cached renderpasses, framebuffers, and samplers,
+// then evicts any cache entries which are not referenced anymore, and which have not been
+// used for at least LE_SETTING_BACKEND_RENDERPASS_CACHE_EVICT_AFTER_UNUSED_FRAMES frames.
+static void backend_render_object_cache_release_frame( le_backend_o* self, BackendFrameData& frame, VkDevice device ) {
+	ZoneScoped;
 
-					rp_hash = SpookyHash::Hash64(
-					    &a.flags, offsetof( VkAttachmentDescription2, loadOp ) - offsetof( VkAttachmentDescription2, flags ),
-					    rp_hash );
-				}
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_RENDERPASS_CACHE_EVICT_AFTER_UNUSED_FRAMES, 60 );
 
-				// -- Hash subpasses
-				for ( const auto& s : subpasses ) {
+	auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-					// Note: Attachment references are not that straightforward to hash either, as they contain a layout
-					// field, which we want to ignore, since it makes no difference for render pass compatibility.
+	for ( auto const& key : frame.cached_framebuffer_keys ) {
+		auto it = self->framebuffer_cache.find( key );
+		if ( it != self->framebuffer_cache.end() && it->second.refcount ) {
+			it->second.refcount--;
+		}
+	}
+	frame.cached_framebuffer_keys.clear();
 
-					rp_hash = SpookyHash::Hash64( &s.flags, sizeof( s.flags ), rp_hash );
-					rp_hash = SpookyHash::Hash64( &s.pipelineBindPoint, sizeof( s.pipelineBindPoint ), rp_hash );
-					rp_hash = SpookyHash::Hash64( &s.inputAttachmentCount, sizeof( s.inputAttachmentCount ), rp_hash );
-					rp_hash = SpookyHash::Hash64( &s.colorAttachmentCount, sizeof( s.colorAttachmentCount ), rp_hash );
-					rp_hash = SpookyHash::Hash64( &s.preserveAttachmentCount, sizeof( s.preserveAttachmentCount ), rp_hash );
+	for ( auto const& key : frame.cached_renderpass_keys ) {
+		auto it = self->renderpass_cache.find( key );
+		if ( it != self->renderpass_cache.end() && it->second.refcount ) {
+			it->second.refcount--;
+		}
+	}
+	frame.cached_renderpass_keys.clear();
 
-					// We define this as a pure function lambda, and hope for it to be inlined
-					auto calc_hash_for_attachment_references = []( VkAttachmentReference2 const* pAttachmentRefs, unsigned int count, uint64_t seed ) -> uint64_t {
-						if ( pAttachmentRefs == nullptr ) {
-							return seed;
-						}
-						// ----------| invariant: pAttachmentRefs is valid
-						for ( auto const* pAr = pAttachmentRefs; pAr != pAttachmentRefs + count; pAr++ ) {
-							// Note: for RenderPass compatibility, only the actual attachment
-							// counts - Layout has no effect on compatibility.
-							seed = SpookyHash::Hash64( &pAr->attachment, sizeof( VkAttachmentReference2::attachment ), seed );
-						}
-						return seed;
-					};
+	for ( auto const& key : frame.cached_sampler_keys ) {
+		auto it = self->sampler_cache.find( key );
+		if ( it != self->sampler_cache.end() && it->second.refcount ) {
+			it->second.refcount--;
+		}
+	}
+	frame.cached_sampler_keys.clear();
 
-					// -- For each element in attachment reference, add attachment reference index to the hash
-					//
-					rp_hash = calc_hash_for_attachment_references( s.pColorAttachments, s.colorAttachmentCount, rp_hash );
-					rp_hash = calc_hash_for_attachment_references( s.pInputAttachments, s.inputAttachmentCount, rp_hash );
-					rp_hash = calc_hash_for_attachment_references( s.pDepthStencilAttachment, 1, rp_hash );
+	uint64_t const max_unused_frames = std::max<uint64_t>( *LE_SETTING_BACKEND_RENDERPASS_CACHE_EVICT_AFTER_UNUSED_FRAMES, self->mFrames.size() );
 
-					// Note that we did not calculate hashes for resolve attachments, as these do not contribute
-					// to renderpass compatibility considerations. See: vkSpec:`7.2. Render Pass Compatibility`
+	auto is_stale = [ & ]( uint32_t refcount, uint64_t last_used_frame ) -> bool {
+		return refcount == 0 && last_used_frame + max_unused_frames < self->mFramesCount;
+	};
 
-					// -- preserve attachments are special, because they are not stored as attachment references, but as plain indices
-					if ( s.pPreserveAttachments ) {
-						rp_hash = SpookyHash::Hash64( s.pPreserveAttachments, s.preserveAttachmentCount * sizeof( *s.pPreserveAttachments ), rp_hash );
-					}
-				}
+	for ( auto it = self->framebuffer_cache.begin(); it != self->framebuffer_cache.end(); ) {
+		if ( is_stale( it->second.refcount, it->second.last_used_frame ) ) {
+			render_object_cache_destroy_framebuffer( device, it->second );
+			it = self->framebuffer_cache.erase( it );
+		} else {
+			it++;
+		}
+	}
 
-				// Store *hash for compatible renderpass* with pass so that pipelines can test whether they are compatible.
-				//
-				// "Compatible renderpass" means the hash is not fully representative of the renderpass,
-				// but two renderpasses with same hash should be compatible, as everything that touches
-				// renderpass compatibility has been factored into calculating the hash.
-				//
-				pass.renderpassHash = rp_hash;
-			}
+	for ( auto it = self->renderpass_cache.begin(); it != self->renderpass_cache.end(); ) {
+		bool is_used_by_framebuffer =
+		    std::any_of( self->framebuffer_cache.begin(), self->framebuffer_cache.end(),
+		                 [ rp = it->second.renderpass ]( auto const& fb ) { return fb.second.renderpass == rp; } );
+		if ( !is_used_by_framebuffer && is_stale( it->second.refcount, it->second.last_used_frame ) ) {
+			vkDestroyRenderPass( device, it->second.renderpass, nullptr );
+			it = self->renderpass_cache.erase( it );
+		} else {
+			it++;
+		}
+	}
 
-			VkRenderPassCreateInfo2 renderpassCreateInfo{
-			    .sType                   = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2,
-			    .pNext                   = nullptr, // optional
-			    .flags                   = 0,       // optional
-			    .attachmentCount         = uint32_t( attachments.size() ),
-			    .pAttachments            = attachments.data(),
-			    .subpassCount            = uint32_t( subpasses.size() ),
-			    .pSubpasses              = subpasses.data(),
-			    .dependencyCount         = uint32_t( sizeof( dependencies ) / sizeof( VkSubpassDependency2 ) ),
-			    .pDependencies           = dependencies,
-			    .correlatedViewMaskCount = 0, // optional
-			    .pCorrelatedViewMasks    = 0,
-			};
+	for ( auto it = self->sampler_cache.begin(); it != self->sampler_cache.end(); ) {
+		if ( is_stale( it->second.refcount, it->second.last_used_frame ) ) {
+			vkDestroySampler( device, it->second.sampler, nullptr );
+			it = self->sampler_cache.erase( it );
+		} else {
+			it++;
+		}
+	}
+}
 
-			// Create vulkan renderpass object
+// ----------------------------------------------------------------------
+// Evicts cached image views of the given images, and cached framebuffers which use any of
+// these images as attachments. Must be called before these images get destroyed: views and
+// framebuffers must not outlive their images, and a new image may be created with the handle
+// of a destroyed image.
+static void backend_render_object_cache_evict_images( le_backend_o* self, std::unordered_set<VkImage> const& images, VkDevice device ) {
+	ZoneScoped;
 
-			vkCreateRenderPass2( device, &renderpassCreateInfo, nullptr, &pass.renderPass );
+	if ( images.empty() ) {
+		return;
+	}
 
-			delete dsAttachmentReference; // noo-op if nullptr; we clean up here in case we allocated a
-			                              // depth stencil attachment reference above.
-			                              // Once createRenderPass has consumed the data, we can safely delete.
+	auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-			AbstractPhysicalResource rp;
-			rp.type         = AbstractPhysicalResource::eRenderPass;
-			rp.asRenderPass = pass.renderPass;
+	for ( auto const& img : images ) {
+		auto it = self->image_view_cache.find( img );
+		if ( it != self->image_view_cache.end() ) {
+			for ( auto& [ key, iv ] : it->second ) {
+				vkDestroyImageView( device, iv.image_view, nullptr );
+			}
+			self->image_view_cache.erase( it );
+		}
+	}
 
-			// Add vulkan renderpass object to list of owned and life-time tracked resources, so that
-			// it can be recycled when not needed anymore.
-			frame.ownedResources.emplace_front( std::move( rp ) );
+	for ( auto it = self->framebuffer_cache.begin(); it != self->framebuffer_cache.end(); ) {
+		bool uses_evicted_image =
+		    std::any_of( it->second.images.begin(), it->second.images.end(),
+		                 [ & ]( VkImage img ) { return images.count( img ) != 0; } );
+		if ( uses_evicted_image ) {
+			assert( it->second.refcount == 0 && "framebuffer must not be in use when its attachment gets destroyed" );
+			render_object_cache_destroy_framebuffer( device, it->second );
+			it = self->framebuffer_cache.erase( it );
+		} else {
+			it++;
 		}
-	} // end for each pass
+	}
 }
 
 // ----------------------------------------------------------------------
+// Evicts cached image views and framebuffers for the frame's binned images.
+//
+// Frames which used a binned image have all been cleared by the time the image gets
+// destroyed, which means that the framebuffers we evict here are not referenced anymore.
+static void backend_render_object_cache_evict_binned_images( le_backend_o* self, BackendFrameData& frame, VkDevice device ) {
 
-/// \brief fetchVkBuffer from frame local storage based on resource handle flags
-/// - allocatorBuffers[index] if transient,
-/// - stagingAllocator.buffers[index] if staging,
-/// otherwise, fetch from frame available resources based on an id lookup.
-static inline VkBuffer frame_data_get_buffer_from_le_resource_id( const BackendFrameData& frame, const le_buf_resource_handle& buffer ) {
+	std::unordered_set<VkImage> binned_images;
 
-	if ( buffer->data->flags == uint8_t( le_buf_resource_usage_flags_t::eIsVirtual ) ) {
-		return frame.allocatorBuffers[ buffer->data->index ];
-	} else if ( buffer->data->flags == uint8_t( le_buf_resource_usage_flags_t::eIsStaging ) ) {
-		return frame.stagingAllocator->buffers[ buffer->data->index ];
-	} else {
-		return frame.availableResources.at( buffer ).as.buffer;
+	for ( auto const& a : frame.binnedResources ) {
+		if ( !a.second.info.isBuffer() ) {
+			binned_images.insert( a.second.as.image );
+		}
 	}
-}
 
-// ----------------------------------------------------------------------
-static inline VkImage frame_data_get_image_from_le_resource_id( const BackendFrameData& frame, const le_img_resource_handle& img ) {
-	return frame.availableResources.at( img ).as.image;
+	backend_render_object_cache_evict_images( self, binned_images, device );
 }
 
 // ----------------------------------------------------------------------
-static inline VkFormat frame_data_get_image_format_from_resource_id( BackendFrameData const& frame, const le_img_resource_handle& img ) {
-	return frame.availableResources.at( img ).info.imageInfo.format;
+// Destroys all cached renderpasses, framebuffers, image views, and samplers - device must be idle.
+static void backend_render_object_cache_destroy( le_backend_o* self, VkDevice device ) {
+	auto lock = std::scoped_lock( self->render_object_cache_mutex );
+	for ( auto& fb : self->framebuffer_cache ) {
+		render_object_cache_destroy_framebuffer( device, fb.second );
+	}
+	self->framebuffer_cache.clear();
+	for ( auto& rp : self->renderpass_cache ) {
+		vkDestroyRenderPass( device, rp.second.renderpass, nullptr );
+	}
+	self->renderpass_cache.clear();
+	for ( auto& [ img, views ] : self->image_view_cache ) {
+		for ( auto& [ key, iv ] : views ) {
+			vkDestroyImageView( device, iv.image_view, nullptr );
+		}
+	}
+	self->image_view_cache.clear();
+	for ( auto& [ key, sampler ] : self->sampler_cache ) {
+		vkDestroySampler( device, sampler.sampler, nullptr );
+	}
+	self->sampler_cache.clear();
 }
 
 // ----------------------------------------------------------------------
-
-static inline AllocatedResourceVk const& frame_data_get_allocated_resource_from_resource_id( BackendFrameData& frame, const le_resource_handle& rsp ) {
-	return frame.availableResources.at( rsp );
+// Everything from viewType to the end of subresourceRange is tightly packed.
+static size_t image_view_create_info_key_size() {
+	return offsetof( VkImageViewCreateInfo, subresourceRange ) + sizeof( VkImageViewCreateInfo::subresourceRange ) - offsetof( VkImageViewCreateInfo, viewType );
 }
 
 // ----------------------------------------------------------------------
-// if specific format for texture was not specified, return format of referenced image
-static inline VkFormat frame_data_get_image_format_from_texture_info( BackendFrameData const& frame, le_image_sampler_info_t const& texInfo ) {
-	if ( texInfo.imageView.format == le::Format::eUndefined ) {
-		return ( frame_data_get_image_format_from_resource_id( frame, texInfo.imageView.imageId ) );
-	} else {
-		return static_cast<VkFormat>( texInfo.imageView.format );
-	}
+// Everything from flags to unnormalizedCoordinates is tightly packed.
+static size_t sampler_create_info_key_size() {
+	return offsetof( VkSamplerCreateInfo, unnormalizedCoordinates ) + sizeof( VkSamplerCreateInfo::unnormalizedCoordinates ) - offsetof( VkSamplerCreateInfo, flags );
 }
 
 // ----------------------------------------------------------------------
+// Returns a view from the image view cache, creates and caches view if needed.
+// Only use this for images which are owned by the backend: cached views get
+// destroyed just before their image gets destroyed.
+static VkImageView backend_get_cached_image_view( le_backend_o* self, BackendFrameData& frame, VkDevice device, VkImageViewCreateInfo const& info ) {
 
-VkImageAspectFlags get_aspect_flags_from_format( le::Format const& format ) {
-	VkImageAspectFlags aspectFlags{};
-
-	bool isDepth   = false;
-	bool isStencil = false;
-	le_format_get_is_depth_stencil( format, isDepth, isStencil );
+	static auto logger = LeLog( LOGGER_LABEL );
 
-	if ( isDepth || isStencil ) {
-		if ( isDepth ) {
-			aspectFlags |= VK_IMAGE_ASPECT_DEPTH_BIT;
-		}
-		if ( isStencil ) {
-			aspectFlags |= VK_IMAGE_ASPECT_STENCIL_BIT;
-		}
-	} else {
-		aspectFlags |= VK_IMAGE_ASPECT_COLOR_BIT;
-	}
+	assert( info.pNext == nullptr && "chained image view create info is not part of cache key" );
 
-	return aspectFlags;
-}
+	uint64_t key = SpookyHash::Hash64( &info.viewType, image_view_create_info_key_size(), info.flags );
 
-// ----------------------------------------------------------------------
-// Executes on the DISPATCH FRAME
-//
-// input: Pass
-// output: framebuffer, append newly created imageViews to retained resources list.
-static void backend_create_frame_buffers( BackendFrameData& frame, VkDevice& device ) {
+	{
+		auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-	ZoneScoped;
-	for ( auto& pass : frame.passes ) {
+		auto& views = self->image_view_cache[ info.image ];
+		auto  it    = views.find( key );
 
-		if ( pass.type != le::QueueFlagBits::eGraphics ) {
-			continue;
+		if ( it == views.end() ) {
+			CachedImageView cached_view{};
+			cached_view.info       = info;
+			cached_view.info.pNext = nullptr;
+			vkCreateImageView( device, &info, nullptr, &cached_view.image_view );
+			it = views.emplace( key, cached_view ).first;
 		}
 
-		uint32_t attachmentCount = pass.numColorAttachments +
-		                           pass.numResolveAttachments +
-		                           pass.numDepthStencilAttachments;
+		if ( it->second.info.flags == info.flags &&
+		     0 == memcmp( &it->second.info.viewType, &info.viewType, image_view_create_info_key_size() ) ) {
+			return it->second.image_view;
+		}
+	}
 
-		std::vector<VkImageView> framebufferAttachments;
-		framebufferAttachments.reserve( attachmentCount );
+	// ----------| invariant: hash collision with a different view of the same image - we must not use the cached view.
 
-		auto const attachment_end = pass.attachments + attachmentCount;
-		for ( AttachmentInfo const* attachment = pass.attachments; attachment != attachment_end; attachment++ ) {
+	logger.warn( "Image view cache key collision: %lx. Creating frame-local image view.", key );
 
-			VkImageSubresourceRange subresourceRange{
-			    .aspectMask     = get_aspect_flags_from_format( attachment->format ),
-			    .baseMipLevel   = 0,
-			    .levelCount     = 1,
-			    .baseArrayLayer = 0,
-			    .layerCount     = 1,
-			};
+	VkImageView view = nullptr;
+	vkCreateImageView( device, &info, nullptr, &view );
 
-			VkImage img = frame_data_get_image_from_le_resource_id( frame, attachment->resource );
+	AbstractPhysicalResource res;
+	res.asImageView = view;
+	res.type        = AbstractPhysicalResource::Type::eImageView;
 
-			VkImageViewCreateInfo imageViewCreateInfo{
-			    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-			    .pNext            = nullptr, // optional
-			    .flags            = 0,       // optional
-			    .image            = img,
-			    .viewType         = VK_IMAGE_VIEW_TYPE_2D,
-			    .format           = VkFormat( attachment->format ),
-			    .components       = {},
-			    .subresourceRange = subresourceRange,
-			};
+	frame.ownedResources.emplace_front( std::move( res ) );
 
-			VkImageView imageView = nullptr;
-			{
-				auto result = vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
-				assert( result == VK_SUCCESS );
-			}
+	return view;
+}
 
-			framebufferAttachments.push_back( imageView );
+// ----------------------------------------------------------------------
+// Returns a sampler from the sampler cache, creates and caches sampler if needed.
+// The frame holds a reference to the cached sampler until the frame gets cleared.
+static VkSampler backend_get_cached_sampler( le_backend_o* self, BackendFrameData& frame, VkDevice device, VkSamplerCreateInfo const& info ) {
 
-			{
-				// Retain imageviews in owned resources - they will be released
-				// once not needed anymore.
+	static auto logger = LeLog( LOGGER_LABEL );
 
-				AbstractPhysicalResource iv;
-				iv.type        = AbstractPhysicalResource::eImageView;
-				iv.asImageView = imageView;
+	assert( info.pNext == nullptr && "chained sampler create info is not part of cache key" );
 
-				frame.ownedResources.emplace_front( std::move( iv ) );
-			}
-		}
+	uint64_t key = SpookyHash::Hash64( &info.flags, sampler_create_info_key_size(), 0 );
 
-		VkFramebufferCreateInfo framebufferCreateInfo{
-		    .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		    .pNext           = nullptr, // optional
-		    .flags           = 0,       // optional
-		    .renderPass      = pass.renderPass,
-		    .attachmentCount = attachmentCount, // optional
-		    .pAttachments    = framebufferAttachments.data(),
-		    .width           = pass.width,
-		    .height          = pass.height,
-		    .layers          = 1,
-		};
+	{
+		auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-		auto result = vkCreateFramebuffer( device, &framebufferCreateInfo, nullptr, &pass.framebuffer );
-		assert( result == VK_SUCCESS && "Framebuffer must be valid" );
-		{
-			// Retain framebuffer
+		auto it = self->sampler_cache.find( key );
 
-			AbstractPhysicalResource fb;
-			fb.type          = AbstractPhysicalResource::eFramebuffer;
-			fb.asFramebuffer = pass.framebuffer;
+		if ( it == self->sampler_cache.end() ) {
+			CachedSampler cached_sampler{};
+			cached_sampler.info       = info;
+			cached_sampler.info.pNext = nullptr;
+			vkCreateSampler( device, &info, nullptr, &cached_sampler.sampler );
+			it = self->sampler_cache.emplace( key, cached_sampler ).first;
+		}
 
-			frame.ownedResources.emplace_front( std::move( fb ) );
+		if ( 0 == memcmp( &it->second.info.flags, &info.flags, sampler_create_info_key_size() ) ) {
+			it->second.refcount++;
+			it->second.last_used_frame = frame.frameNumber;
+			frame.cached_sampler_keys.push_back( key );
+			return it->second.sampler;
 		}
 	}
-}
 
-// ----------------------------------------------------------------------
-// Executes on the DISPATCH FRAME
-//
-static void backend_create_descriptor_pools( BackendFrameData& frame, VkDevice& device, size_t numRenderPasses ) {
-	ZoneScoped;
-	// Make sure that there is one descriptorpool for every renderpass.
-	// descriptor pools which were created previously will be re-used,
-	// if we're suddenly rendering more frames, we will add additional
-	// descriptorPools.
+	// ----------| invariant: hash collision with a different sampler - we must not use the cached sampler.
 
-	// At this point it would be nice to have an idea for each renderpass
-	// on how many descriptors to expect, but we cannot know that realistically
-	// without going through the command buffer... yuck.
+	logger.warn( "Sampler cache key collision: %lx. Creating frame-local sampler.", key );
 
-	// This is why we're creating space for a generous amount of descriptors
-	// hoping we're not running out when assembling the command buffer.
+	VkSampler sampler = nullptr;
+	vkCreateSampler( device, &info, nullptr, &sampler );
 
-	constexpr VkDescriptorType DESCRIPTOR_TYPES[] = {
-	    VK_DESCRIPTOR_TYPE_SAMPLER,
-	    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-	    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-	    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-	    VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,
-	    VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
-	    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-	    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-	    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-	    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
-	    VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
-	    VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT,
-	    // VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, // Disabled to pacify validation with vk 1.3.261
-	};
+	AbstractPhysicalResource res;
+	res.asSampler = sampler;
+	res.type      = AbstractPhysicalResource::Type::eSampler;
 
-	constexpr size_t DESCRIPTOR_TYPE_COUNT = sizeof( DESCRIPTOR_TYPES ) / sizeof( VkDescriptorType );
+	frame.ownedResources.emplace_front( std::move( res ) );
 
-	for ( ; frame.descriptorPools.size() < numRenderPasses; ) {
+	return sampler;
+}
 
-		std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
+// ----------------------------------------------------------------------
+/// \brief: Frees all frame local resources
+/// \preliminary: frame fence must have been crossed.
+static bool backend_clear_frame( le_backend_o* self, size_t frameIndex ) {
+	ZoneScoped;
 
-		descriptorPoolSizes.reserve( DESCRIPTOR_TYPE_COUNT );
+	static auto logger = LeLog( LOGGER_LABEL );
 
-		for ( auto i : DESCRIPTOR_TYPES ) {
-			descriptorPoolSizes.push_back( {
-			    .type            = i,
-			    .descriptorCount = 1000,
-			} ); // 1000 descriptors of each type
-		}
+	using namespace le_backend_vk;
 
-		VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{
-		    .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		    .pNext         = nullptr, // optional
-		    .flags         = 0,       // optional
-		    .maxSets       = 2000,
-		    .poolSizeCount = uint32_t( descriptorPoolSizes.size() ),
-		    .pPoolSizes    = descriptorPoolSizes.data(),
-		};
+	auto&    frame  = self->mFrames[ frameIndex ];
+	VkDevice device = self->device->getVkDevice();
 
-		VkDescriptorPool descriptorPool = nullptr;
+	// le::Log( LOGGER_LABEL ).info( "=[%3d]== clear frame ", frameIndex );
 
-		auto result = vkCreateDescriptorPool( device, &descriptorPoolCreateInfo, nullptr, &descriptorPool );
-		assert( result == VK_SUCCESS );
+	// -------- Invariant: fence has been crossed, all resources protected by fence
+	//          can now be claimed back.
 
-		frame.descriptorPools.emplace_back( std::move( descriptorPool ) );
-	}
-}
+	// -- read back gpu timings for this frame's passes
+	backend_frame_read_gpu_queries( self, frame );
 
-// ----------------------------------------------------------------------
-// Returns a VkFormat which will match a given set of LeImageUsageFlags.
-// If a matching format cannot be inferred, this method
-le::Format infer_image_format_from_le_image_usage_flags( le_backend_o* self, le::ImageUsageFlags const& flags ) {
-	le::Format format{};
-	if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eColorAttachment ) ) {
-		// set to default color format
-		format = self->defaultFormatColorAttachment;
-	} else if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eDepthStencilAttachment ) ) {
-		// set to default depth stencil format
-		format = self->defaultFormatDepthStencilAttachment;
-	} else if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eSampled ) ) {
-		format = self->defaultFormatSampledImage;
-	} else {
-		// we don't know what to do because we can't infer the intended use of this resource.
-		format = le::Format::eUndefined;
+	// -- reset all frame-local sub-allocators, and release any blocks which they chained.
+	for ( auto& alloc : frame.allocators ) {
+		le_allocator_linear_i.reset( alloc );
 	}
-	return format;
-}
-// ----------------------------------------------------------------------
 
-static int32_t backend_allocate_image(
-    le_backend_o*                  self,
-    VkImageCreateInfo const*       pImageCreateInfo,
-    VmaAllocationCreateInfo const* pAllocationCreateInfo,
-    VkImage*                       pImage,
-    VmaAllocation*                 pAllocation,
-    VmaAllocationInfo*             pAllocationInfo ) {
+	backend_frame_release_transient_blocks( self, frame );
+	backend_frame_resize_transient_base_blocks( self, frame );
 
-	ZoneScoped;
+	// -- reset frame-local staging allocator
+	le_staging_allocator_i.reset( frame.stagingAllocator );
 
-	auto result =
-	    vmaCreateImage(
-	        self->mAllocator,
-	        pImageCreateInfo,
-	        pAllocationCreateInfo,
-	        pImage,
-	        pAllocation,
-	        pAllocationInfo );
+	// -- remove any texture references
+	frame.textures_per_pass.clear();
 
-	return result;
-}
+	// -- remove any image view references
+	frame.imageViews.clear();
 
-// ----------------------------------------------------------------------
+	// -- remove any frame-local copy of allocated resources
+	frame.availableResources.clear();
+	frame.declared_resources.clear();
 
-static void backend_destroy_image( le_backend_o* self, VkImage image, VmaAllocation allocation ) {
-	ZoneScoped;
-	vmaDestroyImage( self->mAllocator, image, allocation );
-}
+	frame.must_create_queues_dot_graph = false;
+	frame.debug_root_passes_names.clear();
 
-// ----------------------------------------------------------------------
+	for ( auto& d : frame.descriptorPools ) {
+		vkResetDescriptorPool( device, d, VkDescriptorPoolResetFlags() );
+	}
 
-static int32_t backend_allocate_buffer(
-    le_backend_o*                  self,
-    VkBufferCreateInfo const*      pBufferCreateInfo,
-    VmaAllocationCreateInfo const* pAllocationCreateInfo,
-    VkBuffer*                      pBuffer,
-    VmaAllocation*                 pAllocation,
-    VmaAllocationInfo*             pAllocationInfo ) {
+	{ // clear resources owned exclusively by this frame
 
-	ZoneScoped;
-
-	auto result =
-	    vmaCreateBuffer(
-	        self->mAllocator,
-	        pBufferCreateInfo,
-	        pAllocationCreateInfo,
-	        pBuffer,
-	        pAllocation,
-	        pAllocationInfo );
+		for ( auto& r : frame.ownedResources ) {
+			switch ( r.type ) {
+			case AbstractPhysicalResource::eBuffer:
+				vkDestroyBuffer( device, r.asBuffer, nullptr );
+				break;
+			case AbstractPhysicalResource::eFramebuffer:
+				vkDestroyFramebuffer( device, r.asFramebuffer, nullptr );
+				break;
+			case AbstractPhysicalResource::eImage:
+				vkDestroyImage( device, r.asImage, nullptr );
+				break;
+			case AbstractPhysicalResource::eImageView:
+				vkDestroyImageView( device, r.asImageView, nullptr );
+				break;
+			case AbstractPhysicalResource::eRenderPass:
+				vkDestroyRenderPass( device, r.asRenderPass, nullptr );
+				break;
+			case AbstractPhysicalResource::eSampler:
+				vkDestroySampler( device, r.asSampler, nullptr );
+				break;
 
-	return result;
-}
-// ----------------------------------------------------------------------
-static int32_t backend_allocate_gpu_memory(
-    le_backend_o*                  self,
-    VmaAllocationCreateInfo const* pAllocationCreateInfo,
-    VkMemoryRequirements const*    pMemoryRequirements,
-    VmaAllocation*                 pAllocation,
-    VmaAllocationInfo*             pAllocationInfo ) {
+			case AbstractPhysicalResource::eUndefined:
+				logger.warn( "%s: abstract physical resource has unknown type (%p) and cannot be deleted. leaking...", __PRETTY_FUNCTION__, r.type );
+				break;
+			}
+		}
+		frame.ownedResources.clear();
+	}
 
-	ZoneScoped;
+	// -- release references to cached renderpasses and framebuffers, and evict stale ones
+	backend_render_object_cache_release_frame( self, frame, device );
 
-	auto result =
-	    vmaAllocateMemory(
-	        self->mAllocator,
-	        pMemoryRequirements,
-	        pAllocationCreateInfo,
-	        pAllocation,
-	        pAllocationInfo );
+	for ( auto& cp : frame.available_command_pools ) {
+		if ( cp->is_used ) {
+			vkFreeCommandBuffers( device, cp->pool, uint32_t( cp->buffers.size() ), cp->buffers.data() ); // shouldn't clearing the pool implicitly free all command buffers allocated from the pool?
+			vkResetCommandPool( device, cp->pool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT );
+			cp->is_used = false; // mark this command pool as available for recycling.
+		}
+		// Note that we don't clear `cp->buffers` - no need to do this as buffers
+		// get resized and overwritten whenever a pool gets re-used.
+	}
+	frame.queue_submission_data.clear();
 
-	return result;
-}
+	frame.physicalResources.clear();
+	frame.syncChainTable.clear();
 
-static int32_t backend_map_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation, void** ppData ) {
-	ZoneScoped;
-	return vmaMapMemory( self->mAllocator, allocation, ppData );
-}
+	for ( auto& f : frame.passes ) {
+		if ( f.encoder ) {
+			using namespace le_renderer;
+			encoder_i.destroy( f.encoder );
+			f.encoder = nullptr;
+		}
+	}
+	frame.passes.clear();
 
-static void backend_unmap_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation ) {
-	ZoneScoped;
-	vmaUnmapMemory( self->mAllocator, allocation );
-}
+	// Reset command streams
+	for ( auto cs : frame.command_streams ) {
+		cs->reset();
+	}
 
-static void backend_free_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation ) {
-	ZoneScoped;
-	vmaFreeMemory( self->mAllocator, allocation );
-}
+	frame.frameNumber = self->mFramesCount++; // note post-increment
 
+	return true;
+};
 // ----------------------------------------------------------------------
-
-static void backend_destroy_buffer( le_backend_o* self, VkBuffer buffer, VmaAllocation allocation ) {
-	ZoneScoped;
-	vmaDestroyBuffer( self->mAllocator, buffer, allocation );
-}
+// we use this to mask out any reads in srcAccess, as it never makes sense to flush reads
+static constexpr auto ANY_WRITE_VK_ACCESS_2_FLAGS =
+    ( VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
+      VK_ACCESS_2_HOST_WRITE_BIT |
+      VK_ACCESS_2_MEMORY_WRITE_BIT |
+      VK_ACCESS_2_SHADER_WRITE_BIT |
+      VK_ACCESS_2_TRANSFER_WRITE_BIT |
+      VK_ACCESS_2_COMMAND_PREPROCESS_WRITE_BIT_NV |
+      VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT );
 
 // ----------------------------------------------------------------------
-// Allocates and creates a physical vulkan resource using vmaAlloc given an allocator
-// Returns an AllocatedResourceVk, currently does not do any error checking.
-static inline AllocatedResourceVk allocate_resource_vk( const VmaAllocator& alloc, const ResourceCreateInfo& resourceInfo, VkDevice device = nullptr ) {
-	ZoneScoped;
-	static auto         logger = LeLog( LOGGER_LABEL );
-	AllocatedResourceVk res{};
-	res.info = resourceInfo;
-	VmaAllocationCreateInfo allocationCreateInfo{};
-	allocationCreateInfo.flags          = {}; // default flags
-	allocationCreateInfo.usage          = VMA_MEMORY_USAGE_GPU_ONLY;
-	allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-	VkResult result = VK_SUCCESS;
+// Serializes everything which goes into creating a renderpass - unlike `renderpassHash`, which only
+// covers what affects renderpass compatibility, this includes load/store ops, layouts, sync, and
+// any depth/stencil resolve which subpasses chain. Two renderpasses with equal keys are therefore
+// interchangeable. Returns false if the create info chains a structure which we don't know how to
+// serialize - such a renderpass must not be cached.
+static bool renderpass_create_info_get_key( VkRenderPassCreateInfo2 const& info, std::vector<uint64_t>& key ) {
 
-	if ( resourceInfo.isBuffer() ) {
+	key.clear();
 
-		result = vmaCreateBuffer(
-		    alloc,
-		    &resourceInfo.bufferInfo,
-		    &allocationCreateInfo,
-		    &res.as.buffer,
-		    &res.allocation,
-		    &res.allocationInfo );
-		assert( result == VK_SUCCESS );
+	auto add = [ &key ]( uint64_t value ) {
+		key.push_back( value );
+	};
 
-	} else if ( resourceInfo.isImage() ) {
+	auto add_attachment_references = [ &add ]( VkAttachmentReference2 const* pAttachmentRefs, uint32_t count ) {
+		if ( pAttachmentRefs == nullptr ) {
+			add( 0 ); // mark absent references, so that they can't be confused with an empty list
+			return;
+		}
+		add( count );
+		for ( auto const* pAr = pAttachmentRefs; pAr != pAttachmentRefs + count; pAr++ ) {
+			add( pAr->attachment );
+			add( pAr->layout );
+			add( pAr->aspectMask );
+		}
+	};
 
-		result = vmaCreateImage(
-		    alloc,
-		    &resourceInfo.imageInfo,
-		    &allocationCreateInfo,
-		    &res.as.image,
-		    &res.allocation,
-		    &res.allocationInfo );
-		assert( result == VK_SUCCESS );
-	} else if ( resourceInfo.isBlas() ) {
+	if ( info.pNext || info.flags ) {
+		return false;
+	}
 
-		// Allocate bottom level ray tracing acceleration structure
+	// -- attachments: everything from flags up to and including finalLayout
+	add( info.attachmentCount );
+	for ( auto a = info.pAttachments; a != info.pAttachments + info.attachmentCount; a++ ) {
+		if ( a->pNext ) {
+			return false;
+		}
+		add( a->flags );
+		add( a->format );
+		add( a->samples );
+		add( a->loadOp );
+		add( a->storeOp );
+		add( a->stencilLoadOp );
+		add( a->stencilStoreOp );
+		add( a->initialLayout );
+		add( a->finalLayout );
+	}
+
+	// -- subpasses, including depth/stencil resolve, if chained
+	add( info.subpassCount );
+	for ( auto s = info.pSubpasses; s != info.pSubpasses + info.subpassCount; s++ ) {
+		add( s->flags );
+		add( s->pipelineBindPoint );
+		add( s->viewMask );
+
+		add_attachment_references( s->pInputAttachments, s->inputAttachmentCount );
+		add_attachment_references( s->pColorAttachments, s->colorAttachmentCount );
+		add_attachment_references( s->pResolveAttachments, s->colorAttachmentCount );
+		add_attachment_references( s->pDepthStencilAttachment, 1 );
+
+		add( s->preserveAttachmentCount );
+		if ( s->pPreserveAttachments ) {
+			for ( uint32_t i = 0; i != s->preserveAttachmentCount; i++ ) {
+				add( s->pPreserveAttachments[ i ] );
+			}
+		}
 
-		assert( device && "blas allocation needs device" );
+		for ( auto next = static_cast<VkBaseInStructure const*>( s->pNext ); next; next = next->pNext ) {
+			if ( next->sType != VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_DEPTH_STENCIL_RESOLVE ) {
+				return false;
+			}
+			auto const* resolve = reinterpret_cast<VkSubpassDescriptionDepthStencilResolve const*>( next );
+			add( next->sType );
+			add( resolve->depthResolveMode );
+			add( resolve->stencilResolveMode );
+			add_attachment_references( resolve->pDepthStencilResolveAttachment, 1 );
+		}
+	}
 
-		auto const blas = reinterpret_cast<le_rtx_blas_info_o*>( resourceInfo.blasInfo.handle );
+	// -- dependencies, including any memory barriers which they chain
+	add( info.dependencyCount );
+	for ( auto d = info.pDependencies; d != info.pDependencies + info.dependencyCount; d++ ) {
+		add( d->srcSubpass );
+		add( d->dstSubpass );
+		add( d->srcStageMask );
+		add( d->dstStageMask );
+		add( d->srcAccessMask );
+		add( d->dstAccessMask );
+		add( d->dependencyFlags );
+		add( d->viewOffset );
+
+		for ( auto next = static_cast<VkBaseInStructure const*>( d->pNext ); next; next = next->pNext ) {
+			if ( next->sType != VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 ) {
+				return false;
+			}
+			auto const* barrier = reinterpret_cast<VkMemoryBarrier2 const*>( next );
+			add( next->sType );
+			add( barrier->srcStageMask );
+			add( barrier->srcAccessMask );
+			add( barrier->dstStageMask );
+			add( barrier->dstAccessMask );
+		}
+	}
 
-		std::vector<VkAccelerationStructureGeometryKHR> geometries;
-		std::vector<uint32_t>                           primitive_counts;
+	// -- correlated view masks
+	add( info.correlatedViewMaskCount );
+	for ( uint32_t i = 0; i != info.correlatedViewMaskCount; i++ ) {
+		add( info.pCorrelatedViewMasks[ i ] );
+	}
 
-		geometries.reserve( blas->geometries.size() );
-		primitive_counts.reserve( geometries.size() );
+	return true;
+}
 
-		for ( auto const& g : blas->geometries ) {
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME
+//
+// Renderpasses are fetched from the backend's renderpass cache, and only created
+// if no renderpass with identical create info was cached.
+static void backend_create_renderpasses( le_backend_o* self, BackendFrameData& frame, VkDevice& device ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-			VkAccelerationStructureGeometryKHR geom = {
-			    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-			    .pNext        = nullptr, // optional
-			    .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
-			    .geometry     = {
-			            .triangles = {
-			                .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
-			                .pNext         = nullptr, // optional
-			                .vertexFormat  = VkFormat( g.vertex_format ),
-			                .vertexData    = { 0 },
-			                .vertexStride  = 0,
-			                .maxVertex     = g.vertex_count - 1, // highest index of a vertex that will be accessed by build command
-			                .indexType     = VkIndexType( g.index_type ),
-			                .indexData     = { 0 },
-			                .transformData = { 0 },
-                    },
-                },
-			    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
-			};
+	const auto& syncChainTable = frame.syncChainTable;
 
-			geometries.push_back( geom );
+	// Note: This should be trivial to parallelize.
+	for ( auto& pass : frame.passes ) {
 
-			primitive_counts.push_back( g.index_count ? g.index_count / 3 : g.vertex_count / 3 );
+		// The rest of this loop only concerns draw passes
+		//
+		if ( pass.type != le::QueueFlagBits::eGraphics ) {
+			continue;
 		}
 
-		VkAccelerationStructureBuildGeometryInfoKHR build_info = {
-		    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-		    .pNext                    = nullptr, // optional
-		    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
-		    .flags                    = 0, // optional
-		    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-		    .srcAccelerationStructure = 0,                             // optional
-		    .dstAccelerationStructure = 0,                             // optional
-		    .geometryCount            = uint32_t( geometries.size() ), // optional
-		    .pGeometries              = geometries.data(),             // optional
-		    .ppGeometries             = 0,
-		    .scratchData              = { 0 },
-		};
+		// ---------| Invariant: current pass is a draw pass.
 
-		VkAccelerationStructureBuildSizesInfoKHR build_sizes = {
-		    .sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
-		    .pNext                     = nullptr, // optional
-		    .accelerationStructureSize = 0,
-		    .updateScratchSize         = 0,
-		    .buildScratchSize          = 0,
-		};
-		vkGetAccelerationStructureBuildSizesKHR(
-		    device,
-		    VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
-		    &build_info,
-		    primitive_counts.data(),
-		    &build_sizes );
+		std::vector<VkAttachmentDescription2> attachments;
+		attachments.reserve( pass.numColorAttachments + pass.numDepthStencilAttachments );
 
-		VkBufferCreateInfo bufferInfo = {
-		    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-		    .pNext                 = nullptr,
-		    .flags                 = 0,
-		    .size                  = build_sizes.accelerationStructureSize,
-		    .usage                 = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
-		    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-		    .queueFamilyIndexCount = 0,
-		    .pQueueFamilyIndices   = 0,
-		};
+		std::vector<VkAttachmentReference2> colorAttachmentReferences;
+		std::vector<VkAttachmentReference2> resolveAttachmentReferences;
+		VkAttachmentReference2*             dsAttachmentReference = nullptr;
 
-		{
-			result =
-			    vmaCreateBuffer(
-			        alloc,
-			        &static_cast<VkBufferCreateInfo&>( bufferInfo ),
-			        &allocationCreateInfo,
-			        &res.info.blasInfo.buffer,
-			        &res.allocation,
-			        &res.allocationInfo );
+		// We must accumulate these flags over all attachments - they are the
+		// union of all flags required by all attachments in a pass.
+		VkPipelineStageFlags2 srcStageFromExternalFlags  = 0;
+		VkPipelineStageFlags2 dstStageFromExternalFlags  = 0;
+		VkAccessFlags2        srcAccessFromExternalFlags = 0;
+		VkAccessFlags2        dstAccessFromExternalFlags = 0;
 
-			assert( result == VkResult::VK_SUCCESS );
-		}
-
-		VkAccelerationStructureCreateInfoKHR create_info = {
-		    .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
-		    .pNext         = nullptr, // optional
-		    .createFlags   = 0,       // optional
-		    .buffer        = res.info.blasInfo.buffer,
-		    .offset        = 0, // must be a multiple of 256 : vkSpec
-		    .size          = build_sizes.accelerationStructureSize,
-		    .type          = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
-		    .deviceAddress = 0, // if 0, this means no specific device address requested
-		};
+		VkPipelineStageFlags2 srcStageToExternalFlags  = 0;
+		VkPipelineStageFlags2 dstStageToExternalFlags  = 0;
+		VkAccessFlags2        srcAccessToExternalFlags = 0;
+		VkAccessFlags2        dstAccessToExternalFlags = 0;
 
-		vkCreateAccelerationStructureKHR( device, &create_info, nullptr, &res.as.blas );
+		if ( LE_PRINT_DEBUG_MESSAGES ) {
+			logger.info( "* Renderpass: '%s'", pass.debugName );
+			logger.info( " %40s : %30s : %30s : %30s", "Attachment", "Layout initial", "Layout subpass", "Layout final" );
+		}
 
-		logger.info( "Created acceleration structure '%p' with size: %d, scratch size: %d", res.as.blas, build_sizes.accelerationStructureSize, build_sizes.buildScratchSize );
+		auto const attachments_end = pass.attachments +
+		                             pass.numColorAttachments +
+		                             pass.numDepthStencilAttachments +
+		                             pass.numResolveAttachments;
 
-		res.info.blasInfo.buffer_size = build_sizes.accelerationStructureSize;
+		for ( AttachmentInfo const* attachment = pass.attachments; attachment != attachments_end; attachment++ ) {
 
-		// Store memory requirements for scratch buffer into allocation info for this blas element
-		res.info.blasInfo.scratch_buffer_size = build_sizes.buildScratchSize;
+			auto& syncChain = syncChainTable.at( attachment->resource );
 
-		// Query, and store object integer handle, which is used to refer
-		// to this bottom-level acceleration structure from a top-level
-		// acceleration structure
-		VkAccelerationStructureDeviceAddressInfoKHR device_address_info = {
-		    .sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
-		    .pNext                 = nullptr, // optional
-		    .accelerationStructure = res.as.blas,
-		};
-		;
+			const auto& syncInitial = syncChain.at( attachment->initialStateOffset );
+			const auto& syncSubpass = syncChain.at( attachment->initialStateOffset + 1 );
+			const auto& syncFinal   = syncChain.at( attachment->finalStateOffset );
 
-		res.info.blasInfo.device_address =
-		    vkGetAccelerationStructureDeviceAddressKHR( device, &device_address_info );
+			bool isDepth   = false;
+			bool isStencil = false;
+			le_format_get_is_depth_stencil( attachment->format, isDepth, isStencil );
 
-	} else if ( resourceInfo.isTlas() ) {
+			VkAttachmentDescription2 attachmentDescription{
+			    .sType          = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2,
+			    .pNext          = nullptr,                        // optional
+			    .flags          = VkAttachmentDescriptionFlags(), // optional
+			    .format         = VkFormat( attachment->format ),
+			    .samples        = VkSampleCountFlagBits( attachment->numSamples ),
+			    .loadOp         = VkAttachmentLoadOp( attachment->loadOp ),
+			    .storeOp        = VkAttachmentStoreOp( attachment->storeOp ),
+			    .stencilLoadOp  = isStencil ? VkAttachmentLoadOp( attachment->loadOp ) : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			    .stencilStoreOp = isStencil ? VkAttachmentStoreOp( attachment->storeOp ) : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			    .initialLayout  = syncInitial.layout,
+			    .finalLayout    = syncFinal.layout,
+			};
 
-		// Allocate top level ray tracing allocation structure
+			if ( LE_PRINT_DEBUG_MESSAGES ) {
+				logger.info( " %38s@%d : %30s → %30s → %30s | sync chain indices: %4d : %4d : %4d",
+				             attachment->resource->data->debug_name, 1 << attachment->resource->data->num_samples,
+				             to_str_vk_image_layout( syncInitial.layout ),
+				             to_str_vk_image_layout( syncSubpass.layout ),
+				             to_str_vk_image_layout( syncFinal.layout ),
+				             attachment->initialStateOffset,
+				             attachment->initialStateOffset + 1,
+				             attachment->finalStateOffset );
+			}
 
-		assert( device && "tlas allocation needs device" );
+			attachments.emplace_back( attachmentDescription );
 
-		auto const tlas = reinterpret_cast<le_rtx_tlas_info_o*>( resourceInfo.tlasInfo.handle );
+			switch ( attachment->type ) {
+			case AttachmentInfo::Type::eDepthStencilAttachment:
+				dsAttachmentReference = new VkAttachmentReference2{
+				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
+				    .pNext      = nullptr, // optional
+				    .attachment = uint32_t( attachments.size() - 1 ),
+				    .layout     = syncSubpass.layout,
+				    .aspectMask = 0,
+				}; // cleanup at the end of loop
+				break;
+			case AttachmentInfo::Type::eColorAttachment:
+				colorAttachmentReferences.push_back( {
+				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
+				    .pNext      = nullptr, // optional
+				    .attachment = uint32_t( attachments.size() - 1 ),
+				    .layout     = syncSubpass.layout,
+				    .aspectMask = 0,
+				} );
+				break;
+			case AttachmentInfo::Type::eResolveAttachment:
+				resolveAttachmentReferences.push_back( {
+				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
+				    .pNext      = nullptr, // optional
+				    .attachment = uint32_t( attachments.size() - 1 ),
+				    .layout     = syncSubpass.layout,
+				    .aspectMask = 0,
+				} );
+				break;
+			}
 
-		assert( tlas && "tlas must be valid." );
+			srcStageFromExternalFlags |= syncInitial.stage;
+			dstStageFromExternalFlags |= syncSubpass.stage;
+			srcAccessFromExternalFlags |= ( syncInitial.visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS );
+			dstAccessFromExternalFlags |= syncSubpass.visible_access; // & ~(syncInitial.visible_access );
+			// this would make only changes in availability operations happen. it should only happen if there are no src write_access_flags. we leave this out so as to give the driver more info
 
-		VkAccelerationStructureGeometryKHR geom = {
-		    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-		    .pNext        = nullptr, // optional
-		    .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
-		    .geometry     = {
-		            .instances = {
-		                .sType           = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
-		                .pNext           = nullptr, // optional
-		                .arrayOfPointers = 0,
-		                .data            = { 0 },
+			// TODO: deal with other subpasses ...
 
-                } },
-		    .flags = 0, // optional
-		};
+			srcStageToExternalFlags |= syncChain.at( attachment->finalStateOffset - 1 ).stage;
+			dstStageToExternalFlags |= syncFinal.stage;
+			srcAccessToExternalFlags |= ( syncChain.at( attachment->finalStateOffset - 1 ).visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS );
+			dstAccessToExternalFlags |= syncFinal.visible_access;
 
-		VkAccelerationStructureBuildGeometryInfoKHR build_info = {
-		    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-		    .pNext                    = nullptr,
-		    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-		    .flags                    = 0,
-		    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-		    .srcAccelerationStructure = 0,
-		    .dstAccelerationStructure = 0,
-		    .geometryCount            = 1,
-		    .pGeometries              = &geom,
-		    .ppGeometries             = 0,
-		    .scratchData              = { 0 },
-		};
+			if ( 0 == uint64_t( srcStageFromExternalFlags ) ) {
+				// Ensure that the stage mask is valid if no src stage was specified.
+				srcStageFromExternalFlags = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
+			}
+		}
 
-		VkAccelerationStructureBuildSizesInfoKHR build_sizes = {
-		    .sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
-		    .pNext                     = nullptr, // optional
-		    .accelerationStructureSize = 0,
-		    .updateScratchSize         = 0,
-		    .buildScratchSize          = 0,
-		};
-		;
-		vkGetAccelerationStructureBuildSizesKHR( device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &build_info, &tlas->instances_count, &build_sizes );
+		if ( LE_PRINT_DEBUG_MESSAGES ) {
+			logger.info( "" );
+		}
 
-		VkBufferCreateInfo bufferInfo = {
-		    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-		    .pNext                 = nullptr, // optional
-		    .flags                 = 0,       // optional
-		    .size                  = build_sizes.accelerationStructureSize,
-		    .usage                 = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
-		    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-		    .queueFamilyIndexCount = 0, // optional
-		    .pQueueFamilyIndices   = 0,
-		};
+		std::vector<VkSubpassDescription2> subpasses;
+		subpasses.reserve( 1 );
 
 		{
-			result =
-			    vmaCreateBuffer(
-			        alloc,
-			        &bufferInfo,
-			        &allocationCreateInfo,
-			        &res.info.tlasInfo.buffer,
-			        &res.allocation,
-			        &res.allocationInfo );
+			VkSubpassDescription2 subpassDescription{
+			    .sType                   = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2,
+			    .pNext                   = nullptr, // optional
+			    .flags                   = 0,       // optional
+			    .pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS,
+			    .viewMask                = 0,
+			    .inputAttachmentCount    = 0, // optional
+			    .pInputAttachments       = nullptr,
+			    .colorAttachmentCount    = uint32_t( colorAttachmentReferences.size() ), // optional
+			    .pColorAttachments       = colorAttachmentReferences.data(),
+			    .pResolveAttachments     = resolveAttachmentReferences.empty() ? nullptr : resolveAttachmentReferences.data(), // optional
+			    .pDepthStencilAttachment = dsAttachmentReference,                                                              // optional
+			    .preserveAttachmentCount = 0,                                                                                  // optional
+			    .pPreserveAttachments    = nullptr,
+			};
 
-			assert( result == VkResult::VK_SUCCESS );
+			subpasses.emplace_back( subpassDescription );
 		}
 
-		VkAccelerationStructureCreateInfoKHR create_info = {
-		    .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
-		    .pNext         = nullptr, // optional
-		    .createFlags   = 0,       // optional
-		    .buffer        = res.info.tlasInfo.buffer,
-		    .offset        = 0,
-		    .size          = build_sizes.accelerationStructureSize,
-		    .type          = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-		    .deviceAddress = 0, // if 0, this means no specific device address requested
-		};
+		VkMemoryBarrier2     memoryBarriers[ 2 ];
+		VkSubpassDependency2 dependencies[ 2 ];
 
-		vkCreateAccelerationStructureKHR( device, &create_info, nullptr, &res.as.tlas );
+		{
+			if ( LE_PRINT_DEBUG_MESSAGES ) {
 
-		// Store memory requirements for scratch buffer into allocation info for this tlas element
-		res.info.tlasInfo.scratch_buffer_size = build_sizes.buildScratchSize;
-		res.info.tlasInfo.buffer_size         = build_sizes.accelerationStructureSize;
+				logger.info( "Subpass Dependency: VK_SUBPASS_EXTERNAL to subpass `%s`", pass.debugName );
+				logger.info( "\t srcStage: %-40s Anything in stage %1$s must happen-before", to_string_vk_pipeline_stage_flags2( srcStageFromExternalFlags ).c_str() );
+				logger.info( "\t dstStage: %-40s anything in stage %1$s.", to_string_vk_pipeline_stage_flags2( dstStageFromExternalFlags ).c_str() );
+				uint64_t( srcAccessFromExternalFlags )
+				    ? logger.info( "\tsrcAccess: %-40s Memory from stage %s, accessing %1$s must be made available", to_string_vk_access_flags2( srcAccessFromExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( srcStageFromExternalFlags ).c_str() )
+				    : logger.info( "\tsrcAccess: %-40s No memory needs to be made available", to_string_vk_access_flags2( srcAccessFromExternalFlags ).c_str() );
+				logger.info( "\tdstAccess: %-40s before memory is made visible to %1$s in stage %s", to_string_vk_access_flags2( dstAccessFromExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( dstStageFromExternalFlags ).c_str() );
 
-	} else {
-		assert( false && "Cannot allocate unknown resource type." );
-	}
-	assert( result == VK_SUCCESS );
-	return res;
-};
+				logger.info( "Subpass Dependency: subpass `%s` to VK_SUBPASS_EXTERNAL:", pass.debugName );
+				logger.info( "\t srcStage: %-40s Anything in stage %1$s must happen-before", to_string_vk_pipeline_stage_flags2( srcStageToExternalFlags ).c_str() );
+				logger.info( "\t dstStage: %-40s anything in stage %1$s.", to_string_vk_pipeline_stage_flags2( dstStageToExternalFlags ).c_str() );
+				uint64_t( srcAccessToExternalFlags )
+				    ? logger.info( "\tsrcAccess: %-40s Memory from stage %s, accessing %1$s must be made available", to_string_vk_access_flags2( srcAccessToExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( srcStageToExternalFlags ).c_str() )
+				    : logger.info( "\tsrcAccess: %-40s No memory needs to be made available", to_string_vk_access_flags2( srcAccessToExternalFlags ).c_str() );
+				logger.info( "\tdstAccess: %-40s before memory is made visible to %1$s in stage %s", to_string_vk_access_flags2( dstAccessToExternalFlags ).c_str(), to_string_vk_pipeline_stage_flags2( dstStageToExternalFlags ).c_str() );
+				logger.info( "" );
+			}
 
-// ----------------------------------------------------------------------
+			memoryBarriers[ 0 ] = {
+			    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			    .pNext         = nullptr,
+			    .srcStageMask  = srcStageFromExternalFlags,
+			    .srcAccessMask = srcAccessFromExternalFlags,
+			    .dstStageMask  = dstStageFromExternalFlags,
+			    .dstAccessMask = dstAccessFromExternalFlags,
+			};
+			memoryBarriers[ 1 ] = {
+			    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			    .pNext         = nullptr,
+			    .srcStageMask  = srcStageToExternalFlags,
+			    .srcAccessMask = srcAccessToExternalFlags,
+			    .dstStageMask  = dstStageToExternalFlags,
+			    .dstAccessMask = dstAccessToExternalFlags,
+			};
 
-// Creates a new staging allocator
-// Typically, there is one staging allocator associated to each frame.
-static le_staging_allocator_o* staging_allocator_create( VmaAllocator const vmaAlloc, VkDevice const device ) {
-	ZoneScoped;
-	auto self       = new le_staging_allocator_o{};
-	self->allocator = vmaAlloc;
-	self->device    = device;
-	return self;
-}
+			dependencies[ 0 ] = {
+			    // external to subpass
+			    .sType           = VK_STRUCTURE_TYPE_SUBPASS_DEPENDENCY_2,
+			    .pNext           = memoryBarriers,              // optional
+			    .srcSubpass      = VK_SUBPASS_EXTERNAL,         // outside of renderpass
+			    .dstSubpass      = 0,                           // first subpass
+			    .srcStageMask    = 0,                           // not used
+			    .dstStageMask    = 0,                           // not used
+			    .srcAccessMask   = 0,                           // not used
+			    .dstAccessMask   = 0,                           // not used
+			    .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT, // optional
+			    .viewOffset      = 0,
+			};
+			dependencies[ 1 ] = {
+			    // subpass to external
+			    .sType           = VK_STRUCTURE_TYPE_SUBPASS_DEPENDENCY_2,
+			    .pNext           = memoryBarriers + 1,          // optional
+			    .srcSubpass      = 0,                           // last subpass
+			    .dstSubpass      = VK_SUBPASS_EXTERNAL,         // outside of subpass
+			    .srcStageMask    = 0,                           // not used
+			    .dstStageMask    = 0,                           // not used
+			    .srcAccessMask   = 0,                           // not used
+			    .dstAccessMask   = 0,                           // not used
+			    .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT, // optional
+			    .viewOffset      = 0,
+			};
+		}
 
-// ----------------------------------------------------------------------
+		{
+			// -- Build hash for compatible renderpass
+			//
+			// We need to include all information that defines renderpass compatibility.
+			//
+			// We are not clear whether subpasses must be identical between two compatible renderpasses,
+			// therefore we don't include subpass information in calculating renderpass compatibility.
 
-// Allocates a chunk of memory from the vulkan free store via vmaAlloc, and maps it
-// for writing at *pData.
-//
-// If successful, `resource_handle` receives a valid `le_resource_handle` referring to
-// this particular chunk of staging memory.
-//
-// Returns false on error, true on success.
-//
-// Staging memory is only allowed to be used for staging, that is, only
-// TRANSFER_SRC are set for usage flags.
-//
-// Staging memory is typically cache coherent, ie. does not need to be flushed.
-static bool staging_allocator_map( le_staging_allocator_o* self, uint64_t numBytes, void** pData, le_buf_resource_handle* resource_handle ) {
-	ZoneScoped;
+			// -- 1. hash attachments
+			// -- 2. hash subpass descriptions for each subpass
+			//       subpass descriptions are structs with vectors of index references to attachments
 
-	auto lock = std::scoped_lock( self->mtx );
+			{
+				uint64_t rp_hash = 0;
 
-	VmaAllocation     allocation; // handle to allocation
-	VkBuffer          buffer;     // handle to buffer (returned from vmaMemAlloc)
-	VmaAllocationInfo allocationInfo;
+				// -- hash attachments
+				for ( const auto& a : attachments ) {
 
-	VkBufferCreateInfo bufferCreateInfo{
-	    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-	    .pNext                 = nullptr, // optional
-	    .flags                 = 0,       // optional
-	    .size                  = numBytes,
-	    .usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-	    .queueFamilyIndexCount = 0, // optional
-	    .pQueueFamilyIndices   = 0,
-	};
+					// We use offsetof so that we can get everything from flags to the start of the
+					// attachmentdescription to (but not including) loadOp.
+					static_assert(
+					    offsetof( VkAttachmentDescription2, loadOp ) -
+					            offsetof( VkAttachmentDescription2, flags ) ==
+					        sizeof( VkAttachmentDescription2::flags ) +
+					            sizeof( VkAttachmentDescription2::format ) +
+					            sizeof( VkAttachmentDescription2::samples ),
+					    "AttachmentDescription struct must be tightly packed for efficient hashing" );
 
-	VmaAllocationCreateInfo allocationCreateInfo{};
-	allocationCreateInfo.flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-	allocationCreateInfo.usage          = VMA_MEMORY_USAGE_CPU_ONLY;
-	allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+					rp_hash = SpookyHash::Hash64(
+					    &a.flags, offsetof( VkAttachmentDescription2, loadOp ) - offsetof( VkAttachmentDescription2, flags ),
+					    rp_hash );
+				}
 
-	auto result =
-	    vmaCreateBuffer(
-	        self->allocator,
-	        &bufferCreateInfo,
-	        &allocationCreateInfo,
-	        &buffer,
-	        &allocation,
-	        &allocationInfo );
+				// -- Hash subpasses
+				for ( const auto& s : subpasses ) {
 
-	assert( result == VK_SUCCESS );
+					// Note: Attachment references are not that straightforward to hash either, as they contain a layout
+					// field, which we want to ignore, since it makes no difference for render pass compatibility.
 
-	if ( result != VK_SUCCESS ) {
-		return false;
-	}
+					rp_hash = SpookyHash::Hash64( &s.flags, sizeof( s.flags ), rp_hash );
+					rp_hash = SpookyHash::Hash64( &s.pipelineBindPoint, sizeof( s.pipelineBindPoint ), rp_hash );
+					rp_hash = SpookyHash::Hash64( &s.inputAttachmentCount, sizeof( s.inputAttachmentCount ), rp_hash );
+					rp_hash = SpookyHash::Hash64( &s.colorAttachmentCount, sizeof( s.colorAttachmentCount ), rp_hash );
+					rp_hash = SpookyHash::Hash64( &s.preserveAttachmentCount, sizeof( s.preserveAttachmentCount ), rp_hash );
 
-	//---------- | Invariant: create buffer was successful.
+					// We define this as a pure function lambda, and hope for it to be inlined
+					auto calc_hash_for_attachment_references = []( VkAttachmentReference2 const* pAttachmentRefs, unsigned int count, uint64_t seed ) -> uint64_t {
+						if ( pAttachmentRefs == nullptr ) {
+							return seed;
+						}
+						// ----------| invariant: pAttachmentRefs is valid
+						for ( auto const* pAr = pAttachmentRefs; pAr != pAttachmentRefs + count; pAr++ ) {
+							// Note: for RenderPass compatibility, only the actual attachment
+							// counts - Layout has no effect on compatibility.
+							seed = SpookyHash::Hash64( &pAr->attachment, sizeof( VkAttachmentReference2::attachment ), seed );
+						}
+						return seed;
+					};
 
-	{
-		// -- Now store our allocation in the allocations vectors.
-		size_t allocationIndex = self->allocations.size();
+					// -- For each element in attachment reference, add attachment reference index to the hash
+					//
+					rp_hash = calc_hash_for_attachment_references( s.pColorAttachments, s.colorAttachmentCount, rp_hash );
+					rp_hash = calc_hash_for_attachment_references( s.pInputAttachments, s.inputAttachmentCount, rp_hash );
+					rp_hash = calc_hash_for_attachment_references( s.pDepthStencilAttachment, 1, rp_hash );
 
-		self->allocations.push_back( allocation );
-		self->allocationInfo.push_back( allocationInfo );
-		self->buffers.emplace_back( buffer );
+					// Note that we did not calculate hashes for resolve attachments, as these do not contribute
+					// to renderpass compatibility considerations. See: vkSpec:`7.2. Render Pass Compatibility`
 
-		// Staging resources share the same name, but their allocation index is different.
-		//
-		// The staging index makes sure the correct buffer for this handle can be retrieved later.
+					// -- preserve attachments are special, because they are not stored as attachment references, but as plain indices
+					if ( s.pPreserveAttachments ) {
+						rp_hash = SpookyHash::Hash64( s.pPreserveAttachments, s.preserveAttachmentCount * sizeof( *s.pPreserveAttachments ), rp_hash );
+					}
+				}
 
-		static std::vector<le_buf_resource_handle> staging_buffers;
+				// Store *hash for compatible renderpass* with pass so that pipelines can test whether they are compatible.
+				//
+				// "Compatible renderpass" means the hash is not fully representative of the renderpass,
+				// but two renderpasses with same hash should be compatible, as everything that touches
+				// renderpass compatibility has been factored into calculating the hash.
+				//
+				pass.renderpassHash = rp_hash;
+			}
 
-		// We locally cache the names of all the index-specialised
-		// staging buffers on first use, so that we don't have to look them
-		// up in the renderer's resource library on every frame.
-		//
-		if ( allocationIndex < staging_buffers.size() ) {
-			staging_buffers.reserve( allocationIndex );
-		}
-		while ( staging_buffers.size() < self->allocations.size() ) {
-			size_t index = staging_buffers.size();
-			staging_buffers.emplace_back(
-			    le_renderer::renderer_i.produce_buf_resource_handle(
-			        "Le-Staging-Buffer",
-			        le_buf_resource_usage_flags_t::eIsStaging, uint32_t( index ) ) );
-		}
+			VkRenderPassCreateInfo2 renderpassCreateInfo{
+			    .sType                   = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2,
+			    .pNext                   = nullptr, // optional
+			    .flags                   = 0,       // optional
+			    .attachmentCount         = uint32_t( attachments.size() ),
+			    .pAttachments            = attachments.data(),
+			    .subpassCount            = uint32_t( subpasses.size() ),
+			    .pSubpasses              = subpasses.data(),
+			    .dependencyCount         = uint32_t( sizeof( dependencies ) / sizeof( VkSubpassDependency2 ) ),
+			    .pDependencies           = dependencies,
+			    .correlatedViewMaskCount = 0, // optional
+			    .pCorrelatedViewMasks    = 0,
+			};
 
-		*resource_handle = staging_buffers[ allocationIndex ];
-	}
+			// Fetch vulkan renderpass object from cache - only create a new renderpass
+			// if no renderpass with identical create info exists.
 
-	// Map memory so that it may be written to
-	vmaMapMemory( self->allocator, allocation, pData );
+			std::vector<uint64_t> rp_key_data;
 
-	return true;
-};
+			bool     is_cacheable = renderpass_create_info_get_key( renderpassCreateInfo, rp_key_data );
+			uint64_t rp_key       = SpookyHash::Hash64( rp_key_data.data(), rp_key_data.size() * sizeof( uint64_t ), 0 );
 
-// ----------------------------------------------------------------------
+			if ( is_cacheable ) {
+				auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-/// Frees all allocations held by the staging allocator given in `self`
-static void staging_allocator_reset( le_staging_allocator_o* self ) {
-	ZoneScoped;
-	auto lock = std::scoped_lock( self->mtx );
+				auto it = self->renderpass_cache.find( rp_key );
 
-	if ( self->buffers.empty() ) {
-		// early-out
-		return;
-	}
+				if ( it == self->renderpass_cache.end() ) {
+					CachedRenderPass cached_rp{};
+					cached_rp.key = std::move( rp_key_data );
+					vkCreateRenderPass2( device, &renderpassCreateInfo, nullptr, &cached_rp.renderpass );
+					it = self->renderpass_cache.emplace( rp_key, std::move( cached_rp ) ).first;
+				} else if ( it->second.key != rp_key_data ) {
+					// Hash collision with a different renderpass - we must not use the cached renderpass.
+					logger.warn( "Renderpass cache key collision: %lx. Creating frame-local renderpass.", rp_key );
+					is_cacheable = false;
+				}
 
-	// ---------| invariant: buffers are not empty
+				if ( is_cacheable ) {
+					it->second.refcount++;
+					it->second.last_used_frame = frame.frameNumber;
+					pass.renderPass            = it->second.renderpass;
 
-	assert( self->buffers.size() == self->allocations.size() && self->buffers.size() == self->allocationInfo.size() &&
-	        "buffers, allocations, and allocationInfos sizes must match." );
+					// Frame holds a reference to the cached renderpass until the frame gets cleared.
+					frame.cached_renderpass_keys.push_back( rp_key );
+				}
+			}
 
-	// Since buffers were allocated using the VMA allocator,
-	// we cannot delete them directly using the device. We must delete them using the allocator,
-	// so that the allocator can track current allocations.
+			if ( !is_cacheable ) {
+				// Create a renderpass which is owned by the frame, and released once the frame gets cleared.
+				vkCreateRenderPass2( device, &renderpassCreateInfo, nullptr, &pass.renderPass );
 
-	auto allocation = self->allocations.begin();
-	for ( auto b = self->buffers.begin(); b != self->buffers.end(); b++, allocation++ ) {
-		vmaUnmapMemory( self->allocator, *allocation );
-		vmaDestroyBuffer( self->allocator, *b, *allocation ); // implicitly calls vmaFreeMemory()
+				AbstractPhysicalResource rp;
+				rp.type         = AbstractPhysicalResource::eRenderPass;
+				rp.asRenderPass = pass.renderPass;
+
+				frame.ownedResources.emplace_front( std::move( rp ) );
+			}
+
+			delete dsAttachmentReference; // noo-op if nullptr; we clean up here in case we allocated a
+			                              // depth stencil attachment reference above.
+			                              // Once createRenderPass has consumed the data, we can safely delete.
+		}
+	} // end for each pass
+}
+
+// ----------------------------------------------------------------------
+
+/// \brief fetchVkBuffer from frame local storage based on resource handle flags
+/// - allocatorBuffers[index] if transient,
+/// - stagingAllocator.buffers[index] if staging,
+/// otherwise, fetch from frame available resources based on an id lookup.
+static inline VkBuffer frame_data_get_buffer_from_le_resource_id( const BackendFrameData& frame, const le_buf_resource_handle& buffer ) {
+
+	if ( buffer->data->flags == uint8_t( le_buf_resource_usage_flags_t::eIsVirtual ) ) {
+		return frame.allocatorBuffers[ buffer->data->index ];
+	} else if ( buffer->data->flags == uint8_t( le_buf_resource_usage_flags_t::eIsStaging ) ) {
+		return frame.stagingAllocator->buffers[ buffer->data->index ];
+	} else {
+		return frame.availableResources.at( buffer ).as.buffer;
 	}
+}
 
-	self->buffers.clear();
-	self->allocations.clear();
-	self->allocationInfo.clear();
+// ----------------------------------------------------------------------
+static inline VkImage frame_data_get_image_from_le_resource_id( const BackendFrameData& frame, const le_img_resource_handle& img ) {
+	return frame.availableResources.at( img ).as.image;
 }
 
 // ----------------------------------------------------------------------
+static inline VkFormat frame_data_get_image_format_from_resource_id( BackendFrameData const& frame, const le_img_resource_handle& img ) {
+	return frame.availableResources.at( img ).info.imageInfo.format;
+}
 
-// Destroys a staging allocator (and implicitly all of its derived objects)
-static void staging_allocator_destroy( le_staging_allocator_o* self ) {
-	ZoneScoped;
+// ----------------------------------------------------------------------
 
-	// Reset the object first so that dependent objects (vmaAllocations, vulkan objects) are cleaned up.
-	staging_allocator_reset( self );
+static inline AllocatedResourceVk const& frame_data_get_allocated_resource_from_resource_id( BackendFrameData& frame, const le_resource_handle& rsp ) {
+	return frame.availableResources.at( rsp );
+}
 
-	delete self;
+// ----------------------------------------------------------------------
+// if specific format for texture was not specified, return format of referenced image
+static inline VkFormat frame_data_get_image_format_from_texture_info( BackendFrameData const& frame, le_image_sampler_info_t const& texInfo ) {
+	if ( texInfo.imageView.format == le::Format::eUndefined ) {
+		return ( frame_data_get_image_format_from_resource_id( frame, texInfo.imageView.imageId ) );
+	} else {
+		return static_cast<VkFormat>( texInfo.imageView.format );
+	}
 }
 
 // ----------------------------------------------------------------------
 
-// Frees any resources which are marked for being recycled in the current frame.
-inline void frame_release_binned_resources( BackendFrameData& frame, VmaAllocator& allocator ) {
-	ZoneScoped;
-	for ( auto& a : frame.binnedResources ) {
-		if ( a.second.info.isBuffer() ) {
-			vmaDestroyBuffer( allocator, a.second.as.buffer, a.second.allocation );
-		} else {
-			vmaDestroyImage( allocator, a.second.as.image, a.second.allocation );
+VkImageAspectFlags get_aspect_flags_from_format( le::Format const& format ) {
+	VkImageAspectFlags aspectFlags{};
+
+	bool isDepth   = false;
+	bool isStencil = false;
+	le_format_get_is_depth_stencil( format, isDepth, isStencil );
+
+	if ( isDepth || isStencil ) {
+		if ( isDepth ) {
+			aspectFlags |= VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+		if ( isStencil ) {
+			aspectFlags |= VK_IMAGE_ASPECT_STENCIL_BIT;
 		}
+	} else {
+		aspectFlags |= VK_IMAGE_ASPECT_COLOR_BIT;
 	}
-	frame.binnedResources.clear();
+
+	return aspectFlags;
 }
 
 // ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME
+//
+// input: Pass
+// output: framebuffer, either fetched from the backend's framebuffer cache, or newly created.
+//
+// Framebuffers are cached together with their attachment image views, keyed by renderpass,
+// extents, and attachment images and formats. Framebuffers which render into swapchain images
+// are not cached - swapchain images are owned by the swapchain, which may destroy them when it
+// gets re-created; we create these per frame, and add them to the frame's retained resources list.
+static void backend_create_frame_buffers( le_backend_o* self, BackendFrameData& frame, VkDevice& device ) {
 
-static inline void consolidate_resource_info_into( le_resource_info_t& lhs, le_resource_info_t const& rhs ) {
 	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-	// return superset of lhs and rhs in lhs
-	assert( lhs.type == rhs.type );
+	for ( auto& pass : frame.passes ) {
 
-	switch ( lhs.type ) {
-	case LeResourceType::eBuffer: {
+		if ( pass.type != le::QueueFlagBits::eGraphics ) {
+			continue;
+		}
 
-		lhs.buffer.size = std::max( lhs.buffer.size, rhs.buffer.size );
-		lhs.buffer.usage |= rhs.buffer.usage;
+		uint32_t attachmentCount = pass.numColorAttachments +
+		                           pass.numResolveAttachments +
+		                           pass.numDepthStencilAttachments;
 
-		return;
-	}
-	case LeResourceType::eImage: {
-		// TODO (tim): check how we can enforce correct number of array layers and mip levels
+		auto const attachment_end = pass.attachments + attachmentCount;
 
-		lhs.image.samplesFlags |= rhs.image.samplesFlags;
-		assert( lhs.image.sample_count_log2 == 0 ); // NOTE: we expect sample_count_log2 not to be set at this point
-		assert( rhs.image.sample_count_log2 == 0 ); // NOTE: we expect sample_count_log2 not to be set at this point
+		// -- Build cache key, and find out whether this framebuffer may be cached at all.
 
-		if ( rhs.image.arrayLayers > lhs.image.arrayLayers ) {
-			lhs.image.arrayLayers = rhs.image.arrayLayers;
-		}
+		bool is_cacheable = true;
 
-		if ( rhs.image.mipLevels > lhs.image.mipLevels ) {
-			lhs.image.mipLevels = rhs.image.mipLevels;
-		}
+		std::vector<uint64_t> fb_key_data;
+		fb_key_data.reserve( 3 + 2 * attachmentCount );
+		fb_key_data.push_back( reinterpret_cast<uint64_t>( pass.renderPass ) );
+		fb_key_data.push_back( pass.width );
+		fb_key_data.push_back( pass.height );
 
-		if ( uint32_t( rhs.image.imageType ) > uint32_t( lhs.image.imageType ) ) {
-			// this is a bit sketchy.
-			lhs.image.imageType = rhs.image.imageType;
+		for ( AttachmentInfo const* attachment = pass.attachments; attachment != attachment_end; attachment++ ) {
+			for ( auto const& [ key, swp ] : frame.frame_owned_swapchain_state ) {
+				if ( swp.swapchain_data.swapchain_image == attachment->resource ) {
+					is_cacheable = false;
+				}
+			}
+			VkImage img = frame_data_get_image_from_le_resource_id( frame, attachment->resource );
+			fb_key_data.push_back( reinterpret_cast<uint64_t>( img ) );
+			fb_key_data.push_back( uint64_t( attachment->format ) );
 		}
 
-		lhs.image.flags |= rhs.image.flags;
-		lhs.image.usage |= rhs.image.usage;
-
-		// If an image format was explictly set, this takes precedence over eUndefined.
-		// Note that we skip this block if both infos have the same format, so if both
-		// infos are eUndefined, format stays undefined.
+		uint64_t const fb_key = SpookyHash::Hash64( fb_key_data.data(), fb_key_data.size() * sizeof( uint64_t ), 0 );
 
-		if ( rhs.image.format != le::Format::eUndefined && rhs.image.format != lhs.image.format ) {
+		if ( is_cacheable ) {
+			auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-			// ----------| invariant: both formats differ, and second format is not undefined
+			// A framebuffer must not outlive its renderpass - we only cache framebuffers for cached renderpasses.
+			is_cacheable = std::any_of( self->renderpass_cache.begin(), self->renderpass_cache.end(),
+			                            [ rp = pass.renderPass ]( auto const& e ) { return e.second.renderpass == rp; } );
 
-			if ( lhs.image.format == le::Format::eUndefined ) {
-				lhs.image.format = rhs.image.format;
+			auto it = self->framebuffer_cache.find( fb_key );
+			if ( !is_cacheable || it == self->framebuffer_cache.end() ) {
+				// no cached framebuffer - we must create one below.
+			} else if ( it->second.key != fb_key_data ) {
+				// Hash collision with a different framebuffer - we must not use the cached framebuffer.
+				logger.warn( "Framebuffer cache key collision: %lx. Creating frame-local framebuffer.", fb_key );
+				is_cacheable = false;
 			} else {
-				// Houston, we have a problem!
-				// Two different formats were explicitly specified for this image.
-				assert( false );
+				it->second.refcount++;
+				it->second.last_used_frame = frame.frameNumber;
+				pass.framebuffer           = it->second.framebuffer;
+				frame.cached_framebuffer_keys.push_back( fb_key );
+				continue;
 			}
 		}
 
-		// Make sure the image is as large as it needs to be
-
-		lhs.image.extent.width  = std::max( lhs.image.extent.width, rhs.image.extent.width );
-		lhs.image.extent.height = std::max( lhs.image.extent.height, rhs.image.extent.height );
-		lhs.image.extent.depth  = std::max( lhs.image.extent.depth, rhs.image.extent.depth );
-
-		lhs.image.extent_from_pass.width  = std::max( lhs.image.extent_from_pass.width, rhs.image.extent_from_pass.width );
-		lhs.image.extent_from_pass.height = std::max( lhs.image.extent_from_pass.height, rhs.image.extent_from_pass.height );
-		lhs.image.extent_from_pass.depth  = std::max( lhs.image.extent_from_pass.depth, rhs.image.extent_from_pass.depth );
-		return;
-	}
-	case LeResourceType::eRtxBlas: {
-		return;
-	}
-	case LeResourceType::eRtxTlas: {
-		return;
-	}
-
-	case LeResourceType::eUndefined: {
-		assert( false ); // unreachable
-		return;
-	}
-	}
-}
-
-// ----------------------------------------------------------------------
-// TODO: don't use vectors for resourceInfos, consolidate in-place.
-//
-// should return a map of all resources used in all passes, with consolidated infos per-resource.
-static void collect_resource_infos_per_resource(
-    le_renderpass_o const* const*                                     passes,
-    size_t                                                            numRenderPasses,
-    std::unordered_map<le_resource_handle, le_resource_info_t> const& frame_declared_resources, // | pre-declared resources (declared via module)
-    std::unordered_map<le_resource_handle, le_resource_info_t>&       active_resources ) {
-	ZoneScoped;
-
-	using namespace le_renderer;
-
-	for ( auto rp = passes; rp != passes + numRenderPasses; rp++ ) {
-
-		uint32_t                pass_width        = 0;
-		uint32_t                pass_height       = 0;
-		le::SampleCountFlagBits pass_sample_count = {};
-
-		renderpass_i.get_framebuffer_settings( *rp, &pass_width, &pass_height, &pass_sample_count );
-
-		uint16_t pass_num_samples_log2 = get_sample_count_log_2( uint32_t( pass_sample_count ) );
-
-		le_resource_handle const* p_resources              = nullptr;
-		le::AccessFlags2 const*   p_resources_access_flags = nullptr;
-		size_t                    resources_count          = 0;
-
-		renderpass_i.get_used_resources( *rp, &p_resources, &p_resources_access_flags, &resources_count );
+		// ----------| invariant: framebuffer was not found in cache: we must create it.
 
-		for ( size_t i = 0; i != resources_count; ++i ) {
+		std::vector<VkImageView> framebufferAttachments;
+		framebufferAttachments.reserve( attachmentCount );
 
-			le_resource_handle const& resource = p_resources[ i ]; // Resource handle
+		std::vector<VkImage> framebufferImages;
+		framebufferImages.reserve( attachmentCount );
 
-			// Test whether a resource with this id is already in usedResources -
-			// if not, resource_index will be identical to usedResource vector size,
-			// which is useful, because as soon as we add an element to the vector
-			// resource_index will index the correct element.
+		for ( AttachmentInfo const* attachment = pass.attachments; attachment != attachment_end; attachment++ ) {
 
-			// We must ensure that images which are used as Color, or DepthStencil attachments
-			// fit the extents of their renderpass - as this is a Vulkan requirement.
-			//
-			// We do this here, because we know the extents of the renderpass.
-			//
-			// We also need to ensure that the extent has 1 as depth value by default.
+			VkImageSubresourceRange subresourceRange{
+			    .aspectMask     = get_aspect_flags_from_format( attachment->format ),
+			    .baseMipLevel   = 0,
+			    .levelCount     = 1,
+			    .baseArrayLayer = 0,
+			    .layerCount     = 1,
+			};
 
-			le_resource_info_t resourceInfo( resource->data->type ); // empty resource info, but with type set according to resource type
+			VkImage img = frame_data_get_image_from_le_resource_id( frame, attachment->resource );
 
-			if ( resourceInfo.type == LeResourceType::eImage ) {
+			VkImageViewCreateInfo imageViewCreateInfo{
+			    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			    .pNext            = nullptr, // optional
+			    .flags            = 0,       // optional
+			    .image            = img,
+			    .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+			    .format           = VkFormat( attachment->format ),
+			    .components       = {},
+			    .subresourceRange = subresourceRange,
+			};
 
-				auto& imgInfo = resourceInfo.image;
+			VkImageView imageView = nullptr;
+			{
+				auto result = vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
+				assert( result == VK_SUCCESS );
+			}
 
-				imgInfo.extent_from_pass = { pass_width, pass_height, 1 };
+			framebufferAttachments.push_back( imageView );
+			framebufferImages.push_back( img );
 
-				if ( p_resources_access_flags[ i ] &
-				     // automatically detect usage as color attachment
-				     ( le::AccessFlagBits2::eColorAttachmentRead |
-				       le::AccessFlagBits2::eColorAttachmentWrite ) ) {
-					imgInfo.usage |=
-					    le::ImageUsageFlagBits::eColorAttachment;
-				}
+			if ( !is_cacheable ) {
+				// Retain imageviews in owned resources - they will be released
+				// once not needed anymore.
 
-				if ( p_resources_access_flags[ i ] &
-				     // automatically detect usage as depth buffer
-				     ( le::AccessFlagBits2::eDepthStencilAttachmentRead |
-				       le::AccessFlagBits2::eDepthStencilAttachmentWrite ) ) {
-					imgInfo.usage |=
-					    le::ImageUsageFlagBits::eDepthStencilAttachment;
-				}
+				AbstractPhysicalResource iv;
+				iv.type        = AbstractPhysicalResource::eImageView;
+				iv.asImageView = imageView;
 
-				if ( p_resources_access_flags[ i ] & le::AccessFlagBits2::eShaderSampledRead ) {
-					imgInfo.usage |= le::ImageUsageFlagBits::eSampled;
-				}
+				frame.ownedResources.emplace_front( std::move( iv ) );
+			}
+		}
 
-				if ( ( p_resources_access_flags[ i ] &
-				       ( le::AccessFlagBits2::eColorAttachmentWrite |
-				         le::AccessFlagBits2::eColorAttachmentRead |
-				         le::AccessFlagBits2::eDepthStencilAttachmentWrite |
-				         le::AccessFlagBits2::eDepthStencilAttachmentRead ) ) ) {
+		VkFramebufferCreateInfo framebufferCreateInfo{
+		    .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+		    .pNext           = nullptr, // optional
+		    .flags           = 0,       // optional
+		    .renderPass      = pass.renderPass,
+		    .attachmentCount = attachmentCount, // optional
+		    .pAttachments    = framebufferAttachments.data(),
+		    .width           = pass.width,
+		    .height          = pass.height,
+		    .layers          = 1,
+		};
 
-					// ---------- | resource is either used as a depth stencil attachment, or a color attachment
+		auto result = vkCreateFramebuffer( device, &framebufferCreateInfo, nullptr, &pass.framebuffer );
+		assert( result == VK_SUCCESS && "Framebuffer must be valid" );
 
-					imgInfo.mipLevels    = 1;
-					imgInfo.imageType    = le::ImageType::e2D;
-					imgInfo.tiling       = le::ImageTiling::eOptimal;
-					imgInfo.arrayLayers  = 1;
-					imgInfo.samplesFlags = uint32_t( 1 ) << pass_num_samples_log2; // note we set sample count as a flag so that it can be consolidated -
+		if ( is_cacheable ) {
+			// Hand framebuffer, and its image views, over to the cache.
+
+			CachedFramebuffer cached_fb{
+			    .framebuffer     = pass.framebuffer,
+			    .key             = std::move( fb_key_data ),
+			    .image_views     = std::move( framebufferAttachments ),
+			    .images          = std::move( framebufferImages ),
+			    .renderpass      = pass.renderPass,
+			    .refcount        = 1,
+			    .last_used_frame = frame.frameNumber,
+			};
 
-					// imgInfo.sample_count_log2 = 0; // note that we leave sample_count_log2 untouched.
-					imgInfo.extent = { pass_width, pass_height, 1 };
-				}
+			auto lock = std::scoped_lock( self->render_object_cache_mutex );
 
-			} else if ( resourceInfo.type == LeResourceType::eBuffer ) {
-			} else if ( resourceInfo.type == LeResourceType::eRtxBlas ) {
-			} else if ( resourceInfo.type == LeResourceType::eRtxTlas ) {
-			} else {
-				assert( false ); // unreachable
+			if ( self->framebuffer_cache.try_emplace( fb_key, std::move( cached_fb ) ).second ) {
+				frame.cached_framebuffer_keys.push_back( fb_key );
+				continue;
 			}
 
-			{
-				auto emplace_result = active_resources.try_emplace( resource, std::move( resourceInfo ) );
-				if ( !emplace_result.second ) {
-					// entry was not assigned, result.first will hold an iterator to the current element
-					consolidate_resource_info_into( emplace_result.first->second, resourceInfo );
-				}
-			}
-		} // end for all resources
+			// Another frame has cached an identical (or colliding) framebuffer in the meantime -
+			// we keep ours frame-local, and retain it below, together with its image views.
 
-	} // end for all passes
+			for ( auto& iv : cached_fb.image_views ) {
+				AbstractPhysicalResource r;
+				r.type        = AbstractPhysicalResource::eImageView;
+				r.asImageView = iv;
+				frame.ownedResources.emplace_front( std::move( r ) );
+			}
+		}
 
-	// -- Consolidate resources with pre-declared resources
-	//
-	// If any of our active resources has been pre-declared explicitly via the rendergraph,
-	// consolidate its info with the pre-declared resource's info.
-	//
-	// As a side-effect this will also consolidate any frame-declared resources which
-	// are declared more than once and used in the current rendergraph.
+		{
+			// Retain framebuffer
 
-	for ( auto const& [ resource, resource_info ] : frame_declared_resources ) {
+			AbstractPhysicalResource fb;
+			fb.type          = AbstractPhysicalResource::eFramebuffer;
+			fb.asFramebuffer = pass.framebuffer;
 
-		auto find_result = active_resources.find( resource );
-		if ( find_result != active_resources.end() ) {
-			// a declared resource was found for an used resource - we must consolidate the two.
-			consolidate_resource_info_into( find_result->second, resource_info );
+			frame.ownedResources.emplace_front( std::move( fb ) );
 		}
 	}
 }
 
 // ----------------------------------------------------------------------
-
-static void insert_msaa_versions(
-    std::unordered_map<le_resource_handle, le_resource_info_t>& active_resources ) {
+// Executes on the DISPATCH FRAME
+//
+static void backend_create_descriptor_pools( BackendFrameData& frame, VkDevice& device, size_t numRenderPasses ) {
 	ZoneScoped;
-	// For each image resource which is specified with versions of additional sample counts
-	// we create additional resource_ids (by patching in the sample count), and add matching
-	// resource info, so that multisample versions of image resources can be allocated dynamically.
-	std::unordered_map<le_resource_handle, le_resource_info_t> extra_resources;
-
-	for ( auto const& ar : active_resources ) {
-		if ( ar.first->data->type != LeResourceType::eImage ) {
-			continue;
-		}
+	// Make sure that there is one descriptorpool for every renderpass.
+	// descriptor pools which were created previously will be re-used,
+	// if we're suddenly rendering more frames, we will add additional
+	// descriptorPools.
 
-		// ----------| Invariant: resource is an image
+	// At this point it would be nice to have an idea for each renderpass
+	// on how many descriptors to expect, but we cannot know that realistically
+	// without going through the command buffer... yuck.
 
-		// For any samplesFlags, we must create a matching msaa version of the image.
-		std::bitset<sizeof( ar.second.image.samplesFlags ) * 8> samples_flags( ar.second.image.samplesFlags );
+	// This is why we're creating space for a generous amount of descriptors
+	// hoping we're not running out when assembling the command buffer.
 
-		uint32_t sample_count_log_2 = 1;                  // 2^1 evaluates to 2
-		samples_flags               = samples_flags >> 1; // we remove the single-sampled image, as we assume it already exists.
+	constexpr VkDescriptorType DESCRIPTOR_TYPES[] = {
+	    VK_DESCRIPTOR_TYPE_SAMPLER,
+	    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+	    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	    VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,
+	    VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
+	    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+	    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+	    VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+	    VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT,
+	    // VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, // Disabled to pacify validation with vk 1.3.261
+	};
 
-		while ( samples_flags.count() ) {
+	constexpr size_t DESCRIPTOR_TYPE_COUNT = sizeof( DESCRIPTOR_TYPES ) / sizeof( VkDescriptorType );
 
-			if ( samples_flags.test( 0 ) ) {
-				// we must create a resource copy with this sample count
-				le_resource_handle resource_copy =
-				    le_renderer::renderer_i.produce_img_resource_handle(
-				        ar.first->data->debug_name, sample_count_log_2, static_cast<le_img_resource_handle>( ar.first ), 0 );
-				le_resource_info_t resource_info_copy      = ar.second;
-				resource_info_copy.image.sample_count_log2 = sample_count_log_2;
+	for ( ; frame.descriptorPools.size() < numRenderPasses; ) {
 
-				// insert extra resource into extra msaa resources
-				auto result = extra_resources.try_emplace( resource_copy, resource_info_copy );
-				if ( result.second == false ) {
-					// key already existed, must be consolidated
-					consolidate_resource_info_into( result.first->second, resource_info_copy );
-				}
-			}
+		std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
 
-			samples_flags = samples_flags >> 1;
-			sample_count_log_2++;
-		}
-	}
+		descriptorPoolSizes.reserve( DESCRIPTOR_TYPE_COUNT );
 
-	// append extra resources to active resources
-	for ( auto& er : extra_resources ) {
-		auto result = active_resources.try_emplace( er.first, er.second );
-		if ( result.second == false ) {
-			// key already existed, must be consolidated
-			consolidate_resource_info_into( result.first->second, er.second );
+		for ( auto i : DESCRIPTOR_TYPES ) {
+			descriptorPoolSizes.push_back( {
+			    .type            = i,
+			    .descriptorCount = 1000,
+			} ); // 1000 descriptors of each type
 		}
+
+		VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{
+		    .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		    .pNext         = nullptr, // optional
+		    .flags         = 0,       // optional
+		    .maxSets       = 2000,
+		    .poolSizeCount = uint32_t( descriptorPoolSizes.size() ),
+		    .pPoolSizes    = descriptorPoolSizes.data(),
+		};
+
+		VkDescriptorPool descriptorPool = nullptr;
+
+		auto result = vkCreateDescriptorPool( device, &descriptorPoolCreateInfo, nullptr, &descriptorPool );
+		assert( result == VK_SUCCESS );
+
+		frame.descriptorPools.emplace_back( std::move( descriptorPool ) );
 	}
 }
 
 // ----------------------------------------------------------------------
-
-static void printResourceInfo( le_resource_handle const& handle, ResourceCreateInfo const& info, const char* prefix = "" ) {
-	ZoneScoped;
-	static auto logger = LeLog( LOGGER_LABEL );
-	if ( info.isBuffer() ) {
-		logger.info( "%-15s : %-32s : %11d : %30s : %-30s", prefix, handle->data->debug_name, info.bufferInfo.size, "-",
-		             to_string_vk_buffer_usage_flags( info.bufferInfo.usage ).c_str() );
-	} else if ( info.isImage() ) {
-		logger.info( "%-15s : %-30s@%d : %dx%dx%d : %30s : %-30s",
-		             prefix,
-		             !( handle->data->debug_name[ 0 ] == '\0' )
-		                 ? handle->data->debug_name
-		             : handle->data->reference_handle
-		                 ? handle->data->reference_handle->data->debug_name
-		                 : "unnamed",
-		             uint32( info.imageInfo.samples ),
-		             info.imageInfo.extent.width,
-		             info.imageInfo.extent.height,
-		             info.imageInfo.extent.depth,
-		             to_str_vk_format( info.imageInfo.format ),
-		             to_string_vk_image_usage_flags( info.imageInfo.usage ).c_str() );
-	} else if ( info.isBlas() ) {
-		logger.info( "%-15s :%-32s : %11d : (%28d) : %-30s",
-		             prefix,
-		             handle->data->debug_name,
-		             info.blasInfo.buffer_size,
-		             info.blasInfo.scratch_buffer_size,
-		             "-" );
-	} else if ( info.isTlas() ) {
-		logger.info( "%-15s :%-32s : %11d : (%28d) : %-30s",
-		             prefix,
-		             handle->data->debug_name,
-		             info.tlasInfo.buffer_size,
-		             info.tlasInfo.scratch_buffer_size,
-		             "-" );
+// Returns a VkFormat which will match a given set of LeImageUsageFlags.
+// If a matching format cannot be inferred, this method
+le::Format infer_image_format_from_le_image_usage_flags( le_backend_o* self, le::ImageUsageFlags const& flags ) {
+	le::Format format{};
+	if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eColorAttachment ) ) {
+		// set to default color format
+		format = self->defaultFormatColorAttachment;
+	} else if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eDepthStencilAttachment ) ) {
+		// set to default depth stencil format
+		format = self->defaultFormatDepthStencilAttachment;
+	} else if ( flags & le::ImageUsageFlags( le::ImageUsageFlagBits::eSampled ) ) {
+		format = self->defaultFormatSampledImage;
+	} else {
+		// we don't know what to do because we can't infer the intended use of this resource.
+		format = le::Format::eUndefined;
 	}
+	return format;
 }
-
 // ----------------------------------------------------------------------
 
-static void patch_renderpass_extents(
-    le_renderpass_o** passes,
-    size_t            numRenderPasses,
-    uint32_t          default_width,
-    uint32_t          default_height ) {
-	ZoneScoped;
-	using namespace le_renderer;
+static int32_t backend_allocate_image(
+    le_backend_o*                  self,
+    VkImageCreateInfo const*       pImageCreateInfo,
+    VmaAllocationCreateInfo const* pAllocationCreateInfo,
+    VkImage*                       pImage,
+    VmaAllocation*                 pAllocation,
+    VmaAllocationInfo*             pAllocationInfo ) {
 
-	auto passes_end = passes + numRenderPasses;
+	ZoneScoped;
 
-	for ( auto rp = passes; rp != passes_end; rp++ ) {
-		uint32_t pass_width  = 0;
-		uint32_t pass_height = 0;
-		renderpass_i.get_framebuffer_settings( *rp, &pass_width, &pass_height, nullptr );
-		if ( pass_width == 0 ) {
-			// if zero was chosen this means to use the default extents values for a
-			// renderpass, which is to use the frame's current swapchain extents.
-			pass_width = default_width;
-			renderpass_i.set_width( *rp, pass_width );
-		}
+	auto result =
+	    vmaCreateImage(
+	        self->mAllocator,
+	        pImageCreateInfo,
+	        pAllocationCreateInfo,
+	        pImage,
+	        pAllocation,
+	        pAllocationInfo );
 
-		if ( pass_height == 0 ) {
-			// if zero was chosen this means to use the default extents values for a
-			// renderpass, which is to use the frame's current swapchain extents.
-			pass_height = default_height;
-			renderpass_i.set_height( *rp, pass_height );
-		}
-	}
+	return result;
 }
 
 // ----------------------------------------------------------------------
 
-static bool inferImageFormat( le_backend_o* self, le_img_resource_handle const& resource, le::ImageUsageFlags const& usageFlags, ResourceCreateInfo* createInfo ) {
+static void backend_destroy_image( le_backend_o* self, VkImage image, VmaAllocation allocation ) {
 	ZoneScoped;
-	static auto logger = LeLog( LOGGER_LABEL );
+	vmaDestroyImage( self->mAllocator, image, allocation );
+}
 
-	// If image format was not specified, we must try to
-	// infer the image format from usage flags.
-	auto inferred_format = infer_image_format_from_le_image_usage_flags( self, usageFlags );
+// ----------------------------------------------------------------------
 
-	if ( inferred_format == le::Format::eUndefined ) {
-		logger.error( "Fatal: Cannot infer image format, resource underspecified: '%s'", resource->data->debug_name );
-		logger.error( "Specify usage, or provide explicit format option for resource to fix this error. " );
-		logger.error( "Consider using le::RenderModule::declareResource()" );
+static int32_t backend_allocate_buffer(
+    le_backend_o*                  self,
+    VkBufferCreateInfo const*      pBufferCreateInfo,
+    VmaAllocationCreateInfo const* pAllocationCreateInfo,
+    VkBuffer*                      pBuffer,
+    VmaAllocation*                 pAllocation,
+    VmaAllocationInfo*             pAllocationInfo ) {
 
-		assert( false ); // we don't have enough information to infer image format.
-		return false;
-	} else {
-		createInfo->imageInfo.format = static_cast<VkFormat>( inferred_format );
-	}
+	ZoneScoped;
 
-	return true;
-}
+	auto result =
+	    vmaCreateBuffer(
+	        self->mAllocator,
+	        pBufferCreateInfo,
+	        pAllocationCreateInfo,
+	        pBuffer,
+	        pAllocation,
+	        pAllocationInfo );
 
-// ----------------------------------------------------------------------
-// If image has mip levels, we implicitly add usage: "transfer_src", so that mip maps may be created by blitting.
-static void patchImageUsageForMipLevels( ResourceCreateInfo* createInfo ) {
-	if ( createInfo->imageInfo.mipLevels > 1 ) {
-		createInfo->imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-	}
+	return result;
 }
-
 // ----------------------------------------------------------------------
+static int32_t backend_allocate_gpu_memory(
+    le_backend_o*                  self,
+    VmaAllocationCreateInfo const* pAllocationCreateInfo,
+    VkMemoryRequirements const*    pMemoryRequirements,
+    VmaAllocation*                 pAllocation,
+    VmaAllocationInfo*             pAllocationInfo ) {
 
-static void frame_resources_set_debug_names( le_backend_vk_instance_o* instance, VkDevice device_, BackendFrameData::ResourceMap_T& resources ) {
 	ZoneScoped;
-	static auto logger = LeLog( LOGGER_LABEL );
-
-	// We capture the check for extension as a static, as this is not expected to
-	// change for the lifetime of the application, and checking for the extension
-	// on each frame is wasteful.
-	//
-	static bool check_utils_extension_available = le_backend_vk::vk_instance_i.is_extension_available( instance, VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
 
-	if ( !check_utils_extension_available ) {
-		return;
-	}
+	auto result =
+	    vmaAllocateMemory(
+	        self->mAllocator,
+	        pMemoryRequirements,
+	        pAllocationCreateInfo,
+	        pAllocation,
+	        pAllocationInfo );
 
-	// --------| invariant utuls extension is available
+	return result;
+}
 
-	for ( auto const& r : resources ) {
+static int32_t backend_map_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation, void** ppData ) {
+	ZoneScoped;
+	return vmaMapMemory( self->mAllocator, allocation, ppData );
+}
 
-		auto device = VkDevice( device_ );
+static void backend_unmap_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation ) {
+	ZoneScoped;
+	vmaUnmapMemory( self->mAllocator, allocation );
+}
 
-		VkDebugUtilsObjectNameInfoEXT nameInfo{
-		    .sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
-		    .pNext        = nullptr, // optional
-		    .objectType   = VK_OBJECT_TYPE_UNKNOWN,
-		    .objectHandle = 0,
-		    .pObjectName  = "", // optional
-		};
-		;
+static void backend_free_gpu_memory( le_backend_o* self, VmaAllocation_T* allocation ) {
+	ZoneScoped;
+	vmaFreeMemory( self->mAllocator, allocation );
+}
 
-		nameInfo.pObjectName = r.first->data->debug_name;
+// ----------------------------------------------------------------------
 
-		switch ( r.first->data->type ) {
-		case LeResourceType::eImage:
-			nameInfo.objectType   = VK_OBJECT_TYPE_IMAGE;
-			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.image );
-			break;
-		case LeResourceType::eBuffer:
-			nameInfo.objectType   = VK_OBJECT_TYPE_BUFFER;
-			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.buffer );
-			break;
-		case LeResourceType::eRtxBlas:
-			nameInfo.objectType   = VK_OBJECT_TYPE_ACCELERATION_STRUCTURE_KHR;
-			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.blas );
-			break;
-		case LeResourceType::eRtxTlas:
-			nameInfo.objectType   = VK_OBJECT_TYPE_ACCELERATION_STRUCTURE_KHR;
-			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.tlas );
-			break;
-		default:
-			assert( false && "unknown resource type" );
-		}
-
-		VkResult result = vkSetDebugUtilsObjectNameEXT( device, &nameInfo );
-		assert( result == VK_SUCCESS );
-	}
+static void backend_destroy_buffer( le_backend_o* self, VkBuffer buffer, VmaAllocation allocation ) {
+	ZoneScoped;
+	vmaDestroyBuffer( self->mAllocator, buffer, allocation );
 }
 
 // ----------------------------------------------------------------------
-// Executes on the DISPATCH FRAME
-// towards the start of backend_acquire_physical_resources
-//
-// Allocates all physical Vulkan memory resources (Images/Buffers) referenced to by the frame.
-//
-// - If a resource is already available to the backend, the previously allocated resource is
-//   copied into the frame.
-// - If a resource has not yet been seen, it is freshly allocated, then made available to
-//   the frame. It is also copied to the backend, so that the following frames may access it.
-// - If a resource is requested with properties differing from a resource with the same handle
-//   available from the backend, the previous resource is placed in the frame bin for recycling,
-//   and a new resource is allocated and copied to the frame. This resource in the backend is
-//   replaced by the new version, too. (Effectively, the frame has taken ownership of the old
-//   version and keeps it until it disposes of it).
-// - If there are resources in the recycling bin of a frame, these will get freed. Freeing
-//   happens as a first step, so that resources are only freed once the frame has "come around"
-//   and earlier frames which may have still used the old version of the resource have no claim
-//   on the old version of the resource anymore.
-//
-// We are currently not checking for "orphaned" resources (resources which are available in the
-// backend, but not used by the frame) - these could possibly be recycled, too.
+// Allocation parameters for backend resources - pools for long-lived resources must use the same.
+static VmaAllocationCreateInfo get_resource_allocation_create_info() {
+	VmaAllocationCreateInfo allocationCreateInfo{};
+	allocationCreateInfo.flags          = {}; // default flags
+	allocationCreateInfo.usage          = VMA_MEMORY_USAGE_GPU_ONLY;
+	allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	return allocationCreateInfo;
+}
 
-static void backend_allocate_resources( le_backend_o* self, BackendFrameData& frame, le_renderpass_o** passes, size_t numRenderPasses ) {
+// ----------------------------------------------------------------------
+// Allocates and creates a physical vulkan resource using vmaAlloc given an allocator
+// Returns an AllocatedResourceVk. Errors are only asserted, unless `p_result` is given,
+// in which case it receives the result of the allocation and callers must check it.
+// If pool is given, buffers and images are allocated from pool - see `backend_get_resource_pool`.
+static inline AllocatedResourceVk allocate_resource_vk( const VmaAllocator& alloc, const ResourceCreateInfo& resourceInfo, VkDevice device = nullptr, VmaPool pool = nullptr, VkResult* p_result = nullptr ) {
 	ZoneScoped;
-	/*
-	- Frame is only ever allowed to reference frame-local resources.
-	- "Acquire" therefore means we create local copies of backend-wide resource handles.
-	*/
+	static auto         logger = LeLog( LOGGER_LABEL );
+	AllocatedResourceVk res{};
+	res.info                                     = resourceInfo;
+	VmaAllocationCreateInfo allocationCreateInfo = get_resource_allocation_create_info();
+	allocationCreateInfo.pool                    = pool;
 
-	static auto logger = LeLog( LOGGER_LABEL );
+	VkResult result = VK_SUCCESS;
 
-	static le_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
+	if ( resourceInfo.isBuffer() ) {
 
-	// -- first it is our holy duty to drop any binned resources which
-	// were condemned the last time this frame was active.
-	// It's possible that this was more than two frames ago,
-	// depending on how many swapchain images there are.
-	//
-	frame_release_binned_resources( frame, self->mAllocator );
+		result = vmaCreateBuffer(
+		    alloc,
+		    &resourceInfo.bufferInfo,
+		    &allocationCreateInfo,
+		    &res.as.buffer,
+		    &res.allocation,
+		    &res.allocationInfo );
+		assert( p_result || result == VK_SUCCESS );
 
-	// Iterate over all resource declarations in all passes so that we can collect all resources,
-	// and their usage information. Later, we will consolidate their usages so that resources can
-	// be re-used across passes.
-	//
-	// Note that we accumulate all resource infos first, and do consolidation
-	// in a separate step. That way, we can first make sure all flags are combined,
-	// before we make sure to we find a valid image format which matches all uses...
-	//
+	} else if ( resourceInfo.isImage() ) {
 
-	std::unordered_map<le_resource_handle, le_resource_info_t> active_resources;
+		result = vmaCreateImage(
+		    alloc,
+		    &resourceInfo.imageInfo,
+		    &allocationCreateInfo,
+		    &res.as.image,
+		    &res.allocation,
+		    &res.allocationInfo );
+		assert( p_result || result == VK_SUCCESS );
+	} else if ( resourceInfo.isBlas() ) {
 
-	collect_resource_infos_per_resource(
-	    passes, numRenderPasses,
-	    frame.declared_resources,
-	    active_resources );
+		// Allocate bottom level ray tracing acceleration structure
 
-	if ( LE_PRINT_DEBUG_MESSAGES ) {
-		for ( auto const& r : active_resources ) {
-			logger.info( "resource [ %-30s ] : [ %-50s ]", r.first->data->debug_name,
-			             r.second.type == LeResourceType::eImage
-			                 ? to_string_vk_image_usage_flags( r.second.image.usage ).c_str()
-			                 : to_string_vk_buffer_usage_flags( r.second.buffer.usage ).c_str() );
-		}
-	}
+		assert( device && "blas allocation needs device" );
 
-	// For each image resource which has versions of additional sample counts
-	// we create additional resource_ids (by patching in the sample count), and add matching
-	// resource info, so that multisample versions of image resources can be allocated dynamically.
-	insert_msaa_versions( active_resources );
+		auto const blas = reinterpret_cast<le_rtx_blas_info_o*>( resourceInfo.blasInfo.handle );
 
-	// Check if all resources declared in this frame are already available in backend.
-	// If a resource is not available yet, this resource must be allocated.
+		std::vector<VkAccelerationStructureGeometryKHR> geometries;
+		std::vector<uint32_t>                           primitive_counts;
 
-	{
+		geometries.reserve( blas->geometries.size() );
+		primitive_counts.reserve( geometries.size() );
 
-		auto [ backendResources, backend_resources_lock ] = self->get_allocated_resources();
+		for ( auto const& g : blas->geometries ) {
 
-		for ( auto const& ar : active_resources ) {
+			VkAccelerationStructureGeometryKHR geom = {
+			    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+			    .pNext        = nullptr, // optional
+			    .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
+			    .geometry     = {
+			            .triangles = {
+			                .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
+			                .pNext         = nullptr, // optional
+			                .vertexFormat  = VkFormat( g.vertex_format ),
+			                .vertexData    = { 0 },
+			                .vertexStride  = 0,
+			                .maxVertex     = g.vertex_count - 1, // highest index of a vertex that will be accessed by build command
+			                .indexType     = VkIndexType( g.index_type ),
+			                .indexData     = { 0 },
+			                .transformData = { 0 },
+                    },
+                },
+			    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
+			};
 
-			le_resource_handle const& resource     = ar.first;
-			le_resource_info_t const& resourceInfo = ar.second; ///< consolidated resource info for this resource over all passes
+			geometries.push_back( geom );
 
-			// See if a resource with this id is already available to the frame
-			// This may be the case with a swapchain image resource for example,
-			// as it is allocated and managed from within the swapchain, not here.
-			//
-			if ( frame.availableResources.find( resource ) != frame.availableResources.end() ) {
-				// Resource is already available to and present in the frame.
-				continue;
-			}
+			primitive_counts.push_back( g.index_count ? g.index_count / 3 : g.vertex_count / 3 );
+		}
 
-			// ---------| invariant: resource with this id is not yet available to frame.
+		VkAccelerationStructureBuildGeometryInfoKHR build_info = {
+		    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+		    .pNext                    = nullptr, // optional
+		    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+		    .flags                    = 0, // optional
+		    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+		    .srcAccelerationStructure = 0,                             // optional
+		    .dstAccelerationStructure = 0,                             // optional
+		    .geometryCount            = uint32_t( geometries.size() ), // optional
+		    .pGeometries              = geometries.data(),             // optional
+		    .ppGeometries             = 0,
+		    .scratchData              = { 0 },
+		};
 
-			// first check if the resource is available to the frame,
-			// if that is not the chase, check if the resource is available to the frame.
+		VkAccelerationStructureBuildSizesInfoKHR build_sizes = {
+		    .sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
+		    .pNext                     = nullptr, // optional
+		    .accelerationStructureSize = 0,
+		    .updateScratchSize         = 0,
+		    .buildScratchSize          = 0,
+		};
+		vkGetAccelerationStructureBuildSizesKHR(
+		    device,
+		    VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+		    &build_info,
+		    primitive_counts.data(),
+		    &build_sizes );
 
-			auto       resourceCreateInfo = ResourceCreateInfo::from_le_resource_info( resourceInfo );
-			auto       foundIt            = backendResources.find( resource );
-			const bool resourceIdNotFound = ( foundIt == backendResources.end() );
+		VkBufferCreateInfo bufferInfo = {
+		    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		    .pNext                 = nullptr,
+		    .flags                 = 0,
+		    .size                  = build_sizes.accelerationStructureSize,
+		    .usage                 = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
+		    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+		    .queueFamilyIndexCount = 0,
+		    .pQueueFamilyIndices   = 0,
+		};
 
-			if ( resourceIdNotFound ) {
+		{
+			result =
+			    vmaCreateBuffer(
+			        alloc,
+			        &static_cast<VkBufferCreateInfo&>( bufferInfo ),
+			        &allocationCreateInfo,
+			        &res.info.blasInfo.buffer,
+			        &res.allocation,
+			        &res.allocationInfo );
 
-				// Resource does not yet exist, we must allocate this resource and add it to the backend.
-				// Then add a reference to it to the current frame.
+			assert( result == VkResult::VK_SUCCESS );
+		}
 
-				if ( resourceCreateInfo.isImage() ) {
+		VkAccelerationStructureCreateInfoKHR create_info = {
+		    .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
+		    .pNext         = nullptr, // optional
+		    .createFlags   = 0,       // optional
+		    .buffer        = res.info.blasInfo.buffer,
+		    .offset        = 0, // must be a multiple of 256 : vkSpec
+		    .size          = build_sizes.accelerationStructureSize,
+		    .type          = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+		    .deviceAddress = 0, // if 0, this means no specific device address requested
+		};
 
-					patchImageUsageForMipLevels( &resourceCreateInfo );
+		vkCreateAccelerationStructureKHR( device, &create_info, nullptr, &res.as.blas );
 
-					if ( resourceCreateInfo.imageInfo.format == VK_FORMAT_UNDEFINED ) {
-						inferImageFormat( self, static_cast<le_img_resource_handle>( resource ), resourceInfo.image.usage, &resourceCreateInfo );
-					}
-				}
+		logger.info( "Created acceleration structure '%p' with size: %d, scratch size: %d", res.as.blas, build_sizes.accelerationStructureSize, build_sizes.buildScratchSize );
 
-				auto allocatedResource = allocate_resource_vk( self->mAllocator, resourceCreateInfo, self->device->getVkDevice() );
+		res.info.blasInfo.buffer_size = build_sizes.accelerationStructureSize;
 
-				if ( LE_PRINT_DEBUG_MESSAGES || true ) {
-					printResourceInfo( resource, allocatedResource.info, "ALLOC" );
-				}
+		// Store memory requirements for scratch buffer into allocation info for this blas element
+		res.info.blasInfo.scratch_buffer_size = build_sizes.buildScratchSize;
 
-				// Add resource to map of available resources for this frame
-				frame.availableResources.insert_or_assign( resource, allocatedResource );
+		// Query, and store object integer handle, which is used to refer
+		// to this bottom-level acceleration structure from a top-level
+		// acceleration structure
+		VkAccelerationStructureDeviceAddressInfoKHR device_address_info = {
+		    .sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
+		    .pNext                 = nullptr, // optional
+		    .accelerationStructure = res.as.blas,
+		};
+		;
 
-				// Add this newly allocated resource to the backend so that the following frames
-				// may use it, too
-				backendResources.insert_or_assign( resource, allocatedResource );
+		res.info.blasInfo.device_address =
+		    vkGetAccelerationStructureDeviceAddressKHR( device, &device_address_info );
 
-			} else {
+	} else if ( resourceInfo.isTlas() ) {
 
-				// If an existing resource has been found, we must check that it
-				// was allocated with the same properties as the resource we require
+		// Allocate top level ray tracing allocation structure
 
-				auto& foundResourceCreateInfo = foundIt->second.info;
+		assert( device && "tlas allocation needs device" );
 
-				// Note that we use the greater-than operator, which means
-				// that if our foundResource is equal to *or a superset of*
-				// resourceCreateInfo, we can re-use the found resource.
-				//
-				if ( foundResourceCreateInfo >= resourceCreateInfo ) {
+		auto const tlas = reinterpret_cast<le_rtx_tlas_info_o*>( resourceInfo.tlasInfo.handle );
 
-					// -- found info is either equal or a superset
+		assert( tlas && "tlas must be valid." );
 
-					// Add a copy of this resource allocation to the current frame.
-					frame.availableResources.emplace( resource, foundIt->second );
+		VkAccelerationStructureGeometryKHR geom = {
+		    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+		    .pNext        = nullptr, // optional
+		    .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
+		    .geometry     = {
+		            .instances = {
+		                .sType           = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
+		                .pNext           = nullptr, // optional
+		                .arrayOfPointers = 0,
+		                .data            = { 0 },
 
-				} else {
+                } },
+		    .flags = 0, // optional
+		};
 
-					// -- info does not match.
+		VkAccelerationStructureBuildGeometryInfoKHR build_info = {
+		    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+		    .pNext                    = nullptr,
+		    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+		    .flags                    = 0,
+		    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+		    .srcAccelerationStructure = 0,
+		    .dstAccelerationStructure = 0,
+		    .geometryCount            = 1,
+		    .pGeometries              = &geom,
+		    .ppGeometries             = 0,
+		    .scratchData              = { 0 },
+		};
 
-					// We must re-allocate this resource, and add the old version of the resource to the recycling bin.
+		VkAccelerationStructureBuildSizesInfoKHR build_sizes = {
+		    .sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
+		    .pNext                     = nullptr, // optional
+		    .accelerationStructureSize = 0,
+		    .updateScratchSize         = 0,
+		    .buildScratchSize          = 0,
+		};
+		;
+		vkGetAccelerationStructureBuildSizesKHR( device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &build_info, &tlas->instances_count, &build_sizes );
 
-					// -- allocate a new resource
+		VkBufferCreateInfo bufferInfo = {
+		    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		    .pNext                 = nullptr, // optional
+		    .flags                 = 0,       // optional
+		    .size                  = build_sizes.accelerationStructureSize,
+		    .usage                 = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
+		    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+		    .queueFamilyIndexCount = 0, // optional
+		    .pQueueFamilyIndices   = 0,
+		};
 
-					if ( resourceCreateInfo.isImage() ) {
-						patchImageUsageForMipLevels( &resourceCreateInfo );
-						if ( resourceCreateInfo.imageInfo.format == VK_FORMAT_UNDEFINED ) {
-							inferImageFormat( self, static_cast<le_img_resource_handle>( resource ), resourceInfo.image.usage, &resourceCreateInfo );
-						}
-					}
+		{
+			result =
+			    vmaCreateBuffer(
+			        alloc,
+			        &bufferInfo,
+			        &allocationCreateInfo,
+			        &res.info.tlasInfo.buffer,
+			        &res.allocation,
+			        &res.allocationInfo );
 
-					auto allocatedResource = allocate_resource_vk( self->mAllocator, resourceCreateInfo );
+			assert( result == VkResult::VK_SUCCESS );
+		}
 
-					if ( LE_PRINT_DEBUG_MESSAGES || true ) {
-						printResourceInfo( resource, allocatedResource.info, "RE-ALLOC" );
-					}
+		VkAccelerationStructureCreateInfoKHR create_info = {
+		    .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
+		    .pNext         = nullptr, // optional
+		    .createFlags   = 0,       // optional
+		    .buffer        = res.info.tlasInfo.buffer,
+		    .offset        = 0,
+		    .size          = build_sizes.accelerationStructureSize,
+		    .type          = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+		    .deviceAddress = 0, // if 0, this means no specific device address requested
+		};
 
-					// Add a copy of old resource to recycling bin for this frame, so that
-					// these resources get freed when this frame comes round again.
-					//
-					// We don't immediately delete the resources, as in-flight (preceding) frames
-					// might still be using them.
-					frame.binnedResources.try_emplace( resource, foundIt->second );
+		vkCreateAccelerationStructureKHR( device, &create_info, nullptr, &res.as.tlas );
 
-					// add the new version of the resource to frame available resources
-					frame.availableResources.insert_or_assign( resource, allocatedResource );
+		// Store memory requirements for scratch buffer into allocation info for this tlas element
+		res.info.tlasInfo.scratch_buffer_size = build_sizes.buildScratchSize;
+		res.info.tlasInfo.buffer_size         = build_sizes.accelerationStructureSize;
 
-					// Remove old version of resource from backend, and
-					// add new version of resource to backend
-					backendResources.insert_or_assign( resource, allocatedResource );
-				}
-			}
-		} // end for all used resources
-		if ( LE_PRINT_DEBUG_MESSAGES ) {
-			logger.info( "" );
-		}
+	} else {
+		assert( false && "Cannot allocate unknown resource type." );
+	}
+	assert( p_result || result == VK_SUCCESS );
+	if ( p_result ) {
+		*p_result = result;
 	}
+	return res;
+};
 
-	// -- Create rtx acceleration structure scratch buffer
-	{
-		// In case there are acceleration structures with the `build` flag set, we must allocate
-		// a scratch buffer which is large enough to hold the largest of the acceleration structures
-		// with the build flag set
+// ----------------------------------------------------------------------
 
-		// TODO: this should also apply for any acceleration structures which have the `update` flag
-		// set, as updating requires a scratch buffer too.
+// Creates a new staging allocator
+// Typically, there is one staging allocator associated to each frame.
+static le_staging_allocator_o* staging_allocator_create( VmaAllocator const vmaAlloc, VkDevice const device ) {
+	ZoneScoped;
+	auto self             = new le_staging_allocator_o{};
+	self->allocator       = vmaAlloc;
+	self->device          = device;
+	self->current_chunk   = nullptr;
+	self->num_chunks_used = 0;
+	return self;
+}
 
-		uint64_t scratchbuffer_max_size = 0;
+// ----------------------------------------------------------------------
 
-		for ( auto const& ar : active_resources ) {
+// Creates a persistently mapped buffer of `numBytes` for use as a transfer source.
+// Staging memory is typically cache coherent, ie. does not need to be flushed.
+static bool staging_allocator_create_buffer( le_staging_allocator_o* self, uint64_t numBytes, VkBuffer* buffer, VmaAllocation* allocation, VmaAllocationInfo* allocationInfo ) {
 
-			le_resource_handle const& resourceId   = ar.first;
-			le_resource_info_t const& resourceInfo = ar.second; ///< consolidated resource info for this resource over all passes
+	VkBufferCreateInfo bufferCreateInfo{
+	    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+	    .pNext                 = nullptr, // optional
+	    .flags                 = 0,       // optional
+	    .size                  = numBytes,
+	    .usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+	    .queueFamilyIndexCount = 0, // optional
+	    .pQueueFamilyIndices   = 0,
+	};
 
-			if ( resourceInfo.type == LeResourceType::eRtxBlas &&
-			     ( resourceInfo.blas.usage & LE_RTX_BLAS_BUILD_BIT ) ) {
-				auto const& frame_resource = frame.availableResources.at( resourceId );
-				scratchbuffer_max_size     = std::max<uint64_t>( scratchbuffer_max_size, frame_resource.info.blasInfo.scratch_buffer_size );
-			} else if ( resourceInfo.type == LeResourceType::eRtxTlas &&
-			            ( resourceInfo.tlas.usage & LE_RTX_TLAS_BUILD_BIT ) ) {
-				auto const& frame_resource = frame.availableResources.at( resourceId );
-				scratchbuffer_max_size     = std::max<uint64_t>( scratchbuffer_max_size, frame_resource.info.tlasInfo.scratch_buffer_size );
-			}
-		}
+	VmaAllocationCreateInfo allocationCreateInfo{};
+	allocationCreateInfo.flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	allocationCreateInfo.usage          = VMA_MEMORY_USAGE_CPU_ONLY;
+	allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-		if ( scratchbuffer_max_size != 0 ) {
-			// We must allocate a scratch buffer, which needs to be available for exactly one frame.
-			le_resource_info_t resourceInfo{};
-			resourceInfo.buffer.size              = uint32_t( scratchbuffer_max_size );
-			resourceInfo.buffer.usage             = le::BufferUsageFlags( le::BufferUsageFlagBits::eStorageBuffer | le::BufferUsageFlagBits::eShaderDeviceAddress );
-			resourceInfo.type                     = LeResourceType::eBuffer;
-			ResourceCreateInfo resourceCreateInfo = ResourceCreateInfo::from_le_resource_info( resourceInfo );
-			auto               resource_id        = LE_RTX_SCRATCH_BUFFER_HANDLE;
-			auto               allocated_resource = allocate_resource_vk( self->mAllocator, resourceCreateInfo, self->device->getVkDevice() );
-			frame.availableResources.insert_or_assign( resource_id, allocated_resource );
+	auto result =
+	    vmaCreateBuffer(
+	        self->allocator,
+	        &bufferCreateInfo,
+	        &allocationCreateInfo,
+	        buffer,
+	        allocation,
+	        allocationInfo );
 
-			// We immediately bin the buffer resource, so that its lifetime is tied to the current frame.
-			frame.binnedResources.insert_or_assign( resource_id, allocated_resource );
-		}
-	}
+	assert( result == VK_SUCCESS );
 
-	// If we locked backendResources with a mutex, this would be the right place to release it.
+	return result == VK_SUCCESS;
+}
 
-	if ( LE_PRINT_DEBUG_MESSAGES ) {
-		logger.info( "Available Resources" );
-		logger.info( "%10s : %38s : %30s", "Type", "debugName", "Vk Handle" );
-		for ( auto const& r : frame.availableResources ) {
-			switch ( r.second.info.type ) {
-			case ( LeResourceType::eUndefined ):
-				logger.warn( "%10s : %38s : %30p",
-				             "undefined",
-				             r.first->data->debug_name, r.second );
-				break;
-			case ( LeResourceType::eBuffer ):
-				logger.info( "%10s : %38s : %30p",
-				             "Buffer",
-				             r.first->data->debug_name,
-				             r.second.as.buffer );
-				break;
-			case ( LeResourceType::eImage ):
-				logger.info( "%10s : %36s@%d : %30p",
-				             "Image",
-				             r.first->data->debug_name,
-				             1 << r.first->data->num_samples,
-				             r.second.as.buffer );
-				break;
-			case ( LeResourceType::eRtxBlas ):
-				logger.info( "%10s : %36s@%d",
-				             "RtxBLAS",
-				             r.first->data->debug_name );
-				break;
-			case ( LeResourceType::eRtxTlas ):
-				logger.info( "%10s : %36s@%d",
-				             "RtxTLAS",
-				             r.first->data->debug_name );
-				break;
-			}
+// ----------------------------------------------------------------------
+
+// Registers `buffer` for use with the current frame, and returns the staging
+// resource handle under which it can be retrieved later.
+// Must be called with self->mtx held.
+static le_buf_resource_handle staging_allocator_register_buffer( le_staging_allocator_o* self, VkBuffer buffer ) {
+	// Staging resources share the same name, but their allocation index is different.
+	//
+	// The staging index makes sure the correct buffer for this handle can be retrieved later.
+	uint32_t index = uint32_t( self->buffers.size() );
+	self->buffers.push_back( buffer );
+	return le_renderer::renderer_i.produce_buf_resource_handle(
+	    "Le-Staging-Buffer",
+	    le_buf_resource_usage_flags_t::eIsStaging, index );
+}
+
+// ----------------------------------------------------------------------
+
+// Sub-allocates `numBytes` from `chunk`, at an offset which is a multiple of `alignment` -
+// returns false if chunk is exhausted.
+// Lock-free: may be called concurrently from any number of threads.
+static inline bool staging_chunk_try_allocate( le_staging_chunk_t* chunk, uint64_t numBytes, uint64_t alignment, void** pData, le_buf_resource_handle* resource_handle, uint64_t* offset ) {
+	uint64_t chunk_offset = chunk->offset.load( std::memory_order_relaxed );
+	uint64_t aligned_offset;
+
+	// `alignment` need not be a power of two - three-component formats have texel sizes of 3, 6 or 12 bytes.
+	do {
+		aligned_offset = ( ( chunk_offset + alignment - 1 ) / alignment ) * alignment;
+		if ( aligned_offset + numBytes > chunk->capacity ) {
+			return false;
 		}
-	}
+	} while ( !chunk->offset.compare_exchange_weak( chunk_offset, aligned_offset + numBytes, std::memory_order_relaxed ) );
 
-	if ( DEBUG_TAG_RESOURCES ) {
-		frame_resources_set_debug_names( self->instance, self->device->getVkDevice(), frame.availableResources );
-	}
+	*pData           = static_cast<char*>( chunk->allocationInfo.pMappedData ) + aligned_offset;
+	*resource_handle = chunk->handle;
+	*offset          = aligned_offset;
+	return true;
 }
 
 // ----------------------------------------------------------------------
-// Executes on the DISPATCH FRAME
+
+// Sub-allocates a range of `numBytes` from persistently mapped staging memory,
+// and returns a pointer to it in *pData.
+//
+// If successful, `resource_handle` receives a valid `le_resource_handle` referring to
+// the staging buffer which holds the range, and `offset` receives the offset of the
+// range within this buffer.
+//
+// Returns false on error, true on success.
+//
+// Staging memory is only allowed to be used for staging, that is, only
+// TRANSFER_SRC are set for usage flags.
 //
-// Allocates ImageViews, Samplers and Textures requested by individual passes
-// these are tied to the lifetime of the frame, and will be re-created
-static void frame_allocate_transient_resources( BackendFrameData& frame, VkDevice const& device, le_renderpass_o** passes, size_t numRenderPasses ) {
+// The common path is lock-free: all threads which record uploads bump-allocate from
+// the current chunk. Only when the current chunk is exhausted do we take a lock to
+// hand out the next chunk - chunks are kept from frame to frame, so that we only
+// need to create new buffers if a frame uploads more than any frame before it.
+//
+// Uploads larger than LE_STAGING_DEDICATED_THRESHOLD receive a dedicated buffer,
+// which is freed on reset.
+//
+// Ranges start at a multiple of `alignment`, and of LE_STAGING_ALIGNMENT - uploads to
+// images must pass an alignment which is a multiple of the texel block size of the
+// target image format, and of 4, as vkCmdCopyBufferToImage requires this of bufferOffset.
+static bool staging_allocator_map( le_staging_allocator_o* self, uint64_t numBytes, uint64_t alignment, void** pData, le_buf_resource_handle* resource_handle, uint64_t* offset ) {
 	ZoneScoped;
-	using namespace le_renderer;
-	static auto       logger = LeLog( LOGGER_LABEL );
-	le::QueueFlagBits pass_type{};
 
-	// Only for compute passes: Create imageviews for all available
-	// resources which are of type image and which have usage
-	// sampled or storage.
-	//
-	for ( auto p = passes; p != passes + numRenderPasses; p++ ) {
+	alignment = std::lcm( std::max<uint64_t>( alignment, 1 ), uint64_t( LE_STAGING_ALIGNMENT ) );
 
-		// fetch pass type from this passes' queue sumbission info
-		renderpass_i.get_queue_sumbission_info( *p, &pass_type, nullptr );
+	if ( numBytes <= LE_STAGING_DEDICATED_THRESHOLD ) {
 
-		if ( pass_type != le::QueueFlagBits::eCompute ) {
-			continue;
+		le_staging_chunk_t* chunk = self->current_chunk.load( std::memory_order_acquire );
+
+		if ( chunk && staging_chunk_try_allocate( chunk, numBytes, alignment, pData, resource_handle, offset ) ) {
+			return true;
 		}
 
-		const le_resource_handle* resources        = nullptr;
-		const le::AccessFlags2*   resources_access = nullptr;
-		size_t                    resource_count   = 0;
-
-		renderpass_i.get_used_resources( *p, &resources, &resources_access, &resource_count );
-
-		for ( size_t i = 0; i != resource_count; ++i ) {
-			auto const& r = static_cast<le_img_resource_handle>( resources[ i ] );
-
-			if ( r->data->type == LeResourceType::eImage ) {
+		// ----------| invariant: there is no current chunk, or current chunk is exhausted.
 
-				// We create a default image view for this image and store it with the frame. If no explicit image view
-				// for a particular operation has been specified, this default image view is used.
+		auto lock = std::scoped_lock( self->mtx );
 
-				if ( frame.imageViews.find( r ) != frame.imageViews.end() ) {
-					continue;
-				}
+		// Another thread might have published a fresh chunk while we were waiting for the lock.
+		le_staging_chunk_t* published_chunk = self->current_chunk.load( std::memory_order_relaxed );
 
-				// ---------| Invariant: ImageView for this image not yet stored with frame.
+		if ( published_chunk && published_chunk != chunk &&
+		     staging_chunk_try_allocate( published_chunk, numBytes, alignment, pData, resource_handle, offset ) ) {
+			return true;
+		}
 
-				// attempt to look up format via available resources - this is important for
-				// unspecified formats which get automatically inferred, in which case we want
-				// to set the format to whatever was inferred when the image was allocated and placed
-				// in available resources.
+		if ( self->num_chunks_used == self->chunks.size() ) {
 
-				AllocatedResourceVk const& vk_resource_info = frame_data_get_allocated_resource_from_resource_id( frame, r );
+			auto new_chunk = new le_staging_chunk_t{};
 
-				auto const& imageFormat = le::Format( vk_resource_info.info.imageInfo.format );
+			if ( !staging_allocator_create_buffer( self, LE_STAGING_CHUNK_SIZE, &new_chunk->buffer, &new_chunk->allocation, &new_chunk->allocationInfo ) ) {
+				delete new_chunk;
+				return false;
+			}
 
-				// If the format is still undefined at this point, we can only throw our hands up in the air...
-				//
-				if ( imageFormat == le::Format::eUndefined ) {
-					logger.warn( "Cannot create default view for image: '%s', as format is unspecified", r->data->debug_name );
-					continue;
-				}
+			new_chunk->capacity = LE_STAGING_CHUNK_SIZE;
+			self->chunks.push_back( new_chunk );
+		}
 
-				VkImageSubresourceRange subresourceRange{
-				    .aspectMask     = get_aspect_flags_from_format( imageFormat ),
-				    .baseMipLevel   = 0,
-				    .levelCount     = VK_REMAINING_MIP_LEVELS, // we set VK_REMAINING_MIP_LEVELS which activates all mip levels remaining.
-				    .baseArrayLayer = 0,
-				    .layerCount     = 1,
-				};
+		// ----------| invariant: chunks[num_chunks_used] is available
 
-				VkImageViewCreateInfo imageViewCreateInfo{
-				    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				    .pNext            = nullptr, // optional
-				    .flags            = 0,       // optional
-				    .image            = vk_resource_info.as.image,
-				    .viewType         = VK_IMAGE_VIEW_TYPE_2D,
-				    .format           = VkFormat( imageFormat ),
-				    .components       = {}, // default component mapping
-				    .subresourceRange = subresourceRange,
-				};
+		chunk = self->chunks[ self->num_chunks_used++ ];
 
-				VkImageView imageView = nullptr;
-				vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
+		chunk->offset.store( 0, std::memory_order_relaxed );
+		chunk->handle = staging_allocator_register_buffer( self, chunk->buffer );
 
-				// Store image view object with frame, indexed by image resource id,
-				// so that it can be found quickly if need be.
-				frame.imageViews[ r ] = imageView;
+		bool result = staging_chunk_try_allocate( chunk, numBytes, alignment, pData, resource_handle, offset );
+		assert( result && "fresh chunk must have space for allocation" );
 
-				AbstractPhysicalResource imgView{};
-				imgView.type        = AbstractPhysicalResource::Type::eImageView;
-				imgView.asImageView = imageView;
+		// Publish chunk only once it has been fully set up.
+		self->current_chunk.store( chunk, std::memory_order_release );
 
-				frame.ownedResources.emplace_front( std::move( imgView ) );
-			}
-		}
+		return result;
 	}
 
-	frame.textures_per_pass.resize( numRenderPasses );
-
-	// Create Samplers for all images which are used as Textures
-	//
-	for ( size_t pass_idx = 0; pass_idx != numRenderPasses; ++pass_idx ) {
-
-		auto& p = passes[ pass_idx ];
+	// ----------| invariant: upload is too large for chunks - it gets its own buffer.
 
-		// Get all texture names for this pass
-		const le_texture_handle* textureIds     = nullptr;
-		size_t                   textureIdCount = 0;
-		renderpass_i.get_texture_ids( p, &textureIds, &textureIdCount );
+	VkBuffer          buffer;
+	VmaAllocation     allocation;
+	VmaAllocationInfo allocationInfo;
 
-		const le_image_sampler_info_t* textureInfos     = nullptr;
-		size_t                         textureInfoCount = 0;
-		renderpass_i.get_texture_infos( p, &textureInfos, &textureInfoCount );
+	if ( !staging_allocator_create_buffer( self, numBytes, &buffer, &allocation, &allocationInfo ) ) {
+		return false;
+	}
 
-		assert( textureIdCount == textureInfoCount ); // texture info and -id count must be identical, as there is a 1:1 relationship
+	auto lock = std::scoped_lock( self->mtx );
 
-		for ( size_t i = 0; i != textureIdCount; i++ ) {
+	self->dedicatedBuffers.push_back( buffer );
+	self->dedicatedAllocations.push_back( allocation );
 
-			// -- find out if texture with this name has already been alloacted.
-			// -- if not, allocate
+	*resource_handle = staging_allocator_register_buffer( self, buffer );
+	*pData           = allocationInfo.pMappedData;
+	*offset          = 0;
 
-			const le_texture_handle textureId = textureIds[ i ];
+	return true;
+};
 
-			if ( frame.textures_per_pass[ pass_idx ].find( textureId ) == frame.textures_per_pass[ pass_idx ].end() ) {
-				// -- we need to allocate a new texture
+// ----------------------------------------------------------------------
 
-				auto& texInfo = textureInfos[ i ];
+/// Frees all dedicated allocations held by the staging allocator given in `self`,
+/// and makes its chunks available for reuse.
+///
+/// Chunks which were not used since the last reset are freed, so that
+/// a single frame with many uploads does not keep memory alive forever.
+static void staging_allocator_reset( le_staging_allocator_o* self ) {
+	ZoneScoped;
+	auto lock = std::scoped_lock( self->mtx );
 
-				VkImageView imageView{};
-				{
-					// Set or create vkImageview
+	self->current_chunk.store( nullptr, std::memory_order_relaxed );
 
-					auto const& imageFormat = le::Format( frame_data_get_image_format_from_texture_info( frame, texInfo ) );
+	// Since buffers were allocated using the VMA allocator,
+	// we cannot delete them directly using the device. We must delete them using the allocator,
+	// so that the allocator can track current allocations.
 
-					VkImageSubresourceRange subresourceRange{
-					    .aspectMask     = get_aspect_flags_from_format( imageFormat ),
-					    .baseMipLevel   = 0,
-					    .levelCount     = VK_REMAINING_MIP_LEVELS, // we set VK_REMAINING_MIP_LEVELS which activates all mip levels remaining.
-					    .baseArrayLayer = texInfo.imageView.base_array_layer,
-					    .layerCount     = VK_REMAINING_ARRAY_LAYERS, // Fixme: texInfo.imageView.layer_count must be 6 if imageView.type is cubemap
-					};
+	assert( self->dedicatedBuffers.size() == self->dedicatedAllocations.size() &&
+	        "buffers and allocations sizes must match." );
 
-					// TODO: fill in additional image view create info based on info from pass...
+	auto allocation = self->dedicatedAllocations.begin();
+	for ( auto b = self->dedicatedBuffers.begin(); b != self->dedicatedBuffers.end(); b++, allocation++ ) {
+		vmaDestroyBuffer( self->allocator, *b, *allocation ); // implicitly calls vmaFreeMemory()
+	}
 
-					VkImageViewCreateInfo imageViewCreateInfo{
-					    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-					    .pNext            = nullptr, // optional
-					    .flags            = 0,       // optional
-					    .image            = frame_data_get_image_from_le_resource_id( frame, texInfo.imageView.imageId ),
-					    .viewType         = VkImageViewType( texInfo.imageView.image_view_type ),
-					    .format           = VkFormat( imageFormat ),
-					    .components       = {}, // default component mapping
-					    .subresourceRange = subresourceRange,
-					};
+	self->dedicatedBuffers.clear();
+	self->dedicatedAllocations.clear();
 
-					vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
+	size_t num_chunks_to_keep = std::max<size_t>( self->num_chunks_used, 1 );
 
-					// Store vk object references with frame-owned resources, so that
-					// the vk objects can be destroyed when frame crosses the fence.
+	while ( self->chunks.size() > num_chunks_to_keep ) {
+		le_staging_chunk_t* chunk = self->chunks.back();
+		vmaDestroyBuffer( self->allocator, chunk->buffer, chunk->allocation );
+		delete chunk;
+		self->chunks.pop_back();
+	}
 
-					AbstractPhysicalResource res;
-					res.asImageView = imageView;
-					res.type        = AbstractPhysicalResource::Type::eImageView;
+	self->num_chunks_used = 0;
+	self->buffers.clear();
+}
 
-					frame.ownedResources.emplace_front( std::move( res ) );
-				}
+// ----------------------------------------------------------------------
 
-				VkSampler sampler{};
-				{
-					// Create VkSampler object on device.
+// Destroys a staging allocator (and implicitly all of its derived objects)
+static void staging_allocator_destroy( le_staging_allocator_o* self ) {
+	ZoneScoped;
 
-					VkSamplerCreateInfo samplerCreateInfo{
-					    .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-					    .pNext                   = nullptr, // optional
-					    .flags                   = 0,       // optional
-					    .magFilter               = VkFilter( texInfo.sampler.magFilter ),
-					    .minFilter               = VkFilter( texInfo.sampler.minFilter ),
-					    .mipmapMode              = VkSamplerMipmapMode( texInfo.sampler.mipmapMode ),
-					    .addressModeU            = VkSamplerAddressMode( texInfo.sampler.addressModeU ),
-					    .addressModeV            = VkSamplerAddressMode( texInfo.sampler.addressModeV ),
-					    .addressModeW            = VkSamplerAddressMode( texInfo.sampler.addressModeW ),
-					    .mipLodBias              = texInfo.sampler.mipLodBias,
-					    .anisotropyEnable        = texInfo.sampler.anisotropyEnable,
-					    .maxAnisotropy           = texInfo.sampler.maxAnisotropy,
-					    .compareEnable           = texInfo.sampler.compareEnable,
-					    .compareOp               = VkCompareOp( texInfo.sampler.compareOp ),
-					    .minLod                  = texInfo.sampler.minLod,
-					    .maxLod                  = texInfo.sampler.maxLod,
-					    .borderColor             = VkBorderColor( texInfo.sampler.borderColor ),
-					    .unnormalizedCoordinates = texInfo.sampler.unnormalizedCoordinates,
-					};
+	// Reset the object first so that dependent objects (vmaAllocations, vulkan objects) are cleaned up.
+	staging_allocator_reset( self );
 
-					vkCreateSampler( device, &samplerCreateInfo, nullptr, &sampler );
-					// Now store vk object references with frame-owned resources, so that
-					// the vk objects can be destroyed when frame crosses the fence.
+	for ( auto& chunk : self->chunks ) {
+		vmaDestroyBuffer( self->allocator, chunk->buffer, chunk->allocation );
+		delete chunk;
+	}
 
-					AbstractPhysicalResource res;
+	self->chunks.clear();
 
-					res.asSampler = sampler;
-					res.type      = AbstractPhysicalResource::Type::eSampler;
-					frame.ownedResources.emplace_front( std::move( res ) );
-				}
+	delete self;
+}
 
-				// -- Store Texture with frame so that decoder can find references
-				BackendFrameData::Texture tex;
-				tex.imageView = imageView;
-				tex.sampler   = sampler;
+// ----------------------------------------------------------------------
 
-				frame.textures_per_pass[ pass_idx ][ textureId ] = tex;
-			} else {
-				// The frame already has an element with such a texture id.
-				assert( false && "texture must have been defined multiple times using identical id within the same renderpass." );
-			}
-		} // end for all textureIds
-	}     // end for all passes
+// Frees any resources which are marked for being recycled in the current frame.
+inline void frame_release_binned_resources( BackendFrameData& frame, VmaAllocator& allocator ) {
+	ZoneScoped;
+	for ( auto& a : frame.binnedResources ) {
+		if ( a.second.info.isBuffer() ) {
+			vmaDestroyBuffer( allocator, a.second.as.buffer, a.second.allocation );
+		} else {
+			vmaDestroyImage( allocator, a.second.as.image, a.second.allocation );
+		}
+	}
+	frame.binnedResources.clear();
 }
 
 // ----------------------------------------------------------------------
-// Must execute on the DISPATCH FRAME
-//
-// This is one of the most important methods of backend -
-// where we associate virtual with physical resources, allocate physical
-// resources as needed, and keep track of sync state of physical resources.
-//
-static bool backend_acquire_physical_resources( le_backend_o*             self,
-                                                size_t                    frameIndex,
-                                                le_renderpass_o**         passes,
-                                                size_t                    numRenderPasses,
-                                                le_resource_handle const* declared_resources,
-                                                le_resource_info_t const* declared_resources_infos,
-                                                size_t const&             declared_resources_count ) {
 
+static inline void consolidate_resource_info_into( le_resource_info_t& lhs, le_resource_info_t const& rhs ) {
 	ZoneScoped;
-	auto& frame = self->mFrames[ frameIndex ];
 
-	static VkDevice device = self->device->getVkDevice();
+	// return superset of lhs and rhs in lhs
+	assert( lhs.type == rhs.type );
 
-	// ----------| invariant: swapchain image acquisition was successful.
+	switch ( lhs.type ) {
+	case LeResourceType::eBuffer: {
 
-#ifndef NDEBUG
-	// If we're running in debug, there is a chance that we might want to print out
-	// dot graph diagrams for queue sync - in which case we should fetch the global
-	// setting telling us whether to do so or not.
-	LE_SETTING( uint32_t, LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES, 0 );
-	// we fetch this variable to a local copy, and only at a single point, here,
-	// so that there is no risk that the value of the variable is changed on
-	// another thread while the dot graph is being generated
-	frame.must_create_queues_dot_graph = ( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES > 0 );
-	// then, we decrement the number of requested queue sync dot files, so that we only generate
-	// as many dot graph files as requested.
-	if ( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES > 0 ) {
-		--( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES );
-	};
-#endif
+		lhs.buffer.size = std::max( lhs.buffer.size, rhs.buffer.size );
+		lhs.buffer.usage |= rhs.buffer.usage;
 
-	// Setup declared resources per frame - These are resources declared using resource infos
-	// which are explicitly declared by user via the rendergraph, but which may or may not be
-	// actually used in the frame.
-	//
+		return;
+	}
+	case LeResourceType::eImage: {
+		// TODO (tim): check how we can enforce correct number of array layers and mip levels
 
-	for ( size_t i = 0; i != declared_resources_count; i++, declared_resources++, declared_resources_infos++ ) {
+		lhs.image.samplesFlags |= rhs.image.samplesFlags;
+		assert( lhs.image.sample_count_log2 == 0 ); // NOTE: we expect sample_count_log2 not to be set at this point
+		assert( rhs.image.sample_count_log2 == 0 ); // NOTE: we expect sample_count_log2 not to be set at this point
 
-		auto const& [ it, was_inserted ] = frame.declared_resources.emplace( *declared_resources, *declared_resources_infos );
-		if ( was_inserted == false ) {
-			// we must consolidate - find the superset for two resource infos
-			consolidate_resource_info_into( it->second, *declared_resources_infos ); // we must consolidate
+		if ( rhs.image.arrayLayers > lhs.image.arrayLayers ) {
+			lhs.image.arrayLayers = rhs.image.arrayLayers;
 		}
-	}
 
-	{
+		if ( rhs.image.mipLevels > lhs.image.mipLevels ) {
+			lhs.image.mipLevels = rhs.image.mipLevels;
+		}
 
-		// For all passes - set pass width/height to swapchain width/height if not explicitly set.
+		if ( uint32_t( rhs.image.imageType ) > uint32_t( lhs.image.imageType ) ) {
+			// this is a bit sketchy.
+			lhs.image.imageType = rhs.image.imageType;
+		}
 
-		// FIXME: this should be taking into account the rendergraph: any renderpasses which have no
-		// extents must take on the greater extent of any renderpasses they draw into.
-		// we must follow this from the back, so that if nothing is defined, the extent of the swapchain
-		// is applied to all renderpasses that don't have an explicitly defined extent.
+		lhs.image.flags |= rhs.image.flags;
+		lhs.image.usage |= rhs.image.usage;
 
-		static constexpr uint32_t DEFAULT_RENDERPASS_WIDTH  = 1024;
-		static constexpr uint32_t DEFAULT_RENDERPASS_HEIGHT = 1024;
+		// If an image format was explictly set, this takes precedence over eUndefined.
+		// Note that we skip this block if both infos have the same format, so if both
+		// infos are eUndefined, format stays undefined.
 
-		patch_renderpass_extents(
-		    passes,
-		    numRenderPasses,
-		    DEFAULT_RENDERPASS_WIDTH,
-		    DEFAULT_RENDERPASS_HEIGHT );
-	}
-
-	// Note: this consumes frame.declared_resources
-	backend_allocate_resources( self, frame, passes, numRenderPasses );
-
-	{
-		// Initialise, then build sync chain table - each resource receives initial state
-		// from current entry in frame.availableResources resource map -
-
-		frame.syncChainTable.clear();
-		for ( auto const& res : frame.availableResources ) {
-			frame.syncChainTable.insert( { res.first, { res.second.state } } );
-		}
+		if ( rhs.image.format != le::Format::eUndefined && rhs.image.format != lhs.image.format ) {
 
-		// -- build sync chain for each resource, create explicit sync barrier requests for resources
-		// which cannot be implicitly synced.
-		std::vector<le_img_resource_handle> tmp_swapchain_resources{};
-		tmp_swapchain_resources.reserve( frame.frame_owned_swapchain_state.size() );
+			// ----------| invariant: both formats differ, and second format is not undefined
 
-		for ( auto& [ key, swp ] : frame.frame_owned_swapchain_state ) {
-			tmp_swapchain_resources.push_back( swp.swapchain_data.swapchain_image );
+			if ( lhs.image.format == le::Format::eUndefined ) {
+				lhs.image.format = rhs.image.format;
+			} else {
+				// Houston, we have a problem!
+				// Two different formats were explicitly specified for this image.
+				assert( false );
+			}
 		}
 
-		frame_track_resource_state( frame, passes, numRenderPasses, tmp_swapchain_resources );
+		// Make sure the image is as large as it needs to be
 
-		// At this point we know the state for each resource at the end of the sync chain.
-		// this state will be the initial state for the resource
+		lhs.image.extent.width  = std::max( lhs.image.extent.width, rhs.image.extent.width );
+		lhs.image.extent.height = std::max( lhs.image.extent.height, rhs.image.extent.height );
+		lhs.image.extent.depth  = std::max( lhs.image.extent.depth, rhs.image.extent.depth );
 
-		{
-			// Update final sync state for each pre-existing backend resource.
-			// fixme: this breaks the promise that no-one but allocate resources is writing to allocatedResources.
+		lhs.image.extent_from_pass.width  = std::max( lhs.image.extent_from_pass.width, rhs.image.extent_from_pass.width );
+		lhs.image.extent_from_pass.height = std::max( lhs.image.extent_from_pass.height, rhs.image.extent_from_pass.height );
+		lhs.image.extent_from_pass.depth  = std::max( lhs.image.extent_from_pass.depth, rhs.image.extent_from_pass.depth );
+		return;
+	}
+	case LeResourceType::eRtxBlas: {
+		return;
+	}
+	case LeResourceType::eRtxTlas: {
+		return;
+	}
 
-			static le_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
+	case LeResourceType::eUndefined: {
+		assert( false ); // unreachable
+		return;
+	}
+	}
+}
 
-			auto [ backend_resources, lock ] = self->get_allocated_resources();
+// ----------------------------------------------------------------------
+// TODO: don't use vectors for resourceInfos, consolidate in-place.
+//
+// should return a map of all resources used in all passes, with consolidated infos per-resource.
+static void collect_resource_infos_per_resource(
+    le_renderpass_o const* const*                                     passes,
+    size_t                                                            numRenderPasses,
+    ResourceTable<le_resource_handle, le_resource_info_t> const&      frame_declared_resources, // | pre-declared resources (declared via module)
+    std::unordered_map<le_resource_handle, le_resource_info_t>&       active_resources ) {
+	ZoneScoped;
 
-			for ( auto const& tbl : frame.syncChainTable ) {
-				auto const& resId       = tbl.first;
-				auto const& resSyncList = tbl.second;
+	using namespace le_renderer;
 
-				assert( !resSyncList.empty() ); // sync list must have entries
+	for ( auto rp = passes; rp != passes + numRenderPasses; rp++ ) {
 
-				// find element with matching resource ID in list of backend resources
+		uint32_t                pass_width        = 0;
+		uint32_t                pass_height       = 0;
+		le::SampleCountFlagBits pass_sample_count = {};
 
-				auto res = backend_resources.find( resId );
-				if ( res != backend_resources.end() ) {
-					// Element found.
-					// Set sync state for this resource to value of last elment in the sync chain.
-					res->second.state = resSyncList.back();
-				} else {
+		renderpass_i.get_framebuffer_settings( *rp, &pass_width, &pass_height, &pass_sample_count );
 
-					assert(
-					    std::find( tmp_swapchain_resources.begin(),
-					               tmp_swapchain_resources.end(), resId ) !=
-					        tmp_swapchain_resources.end() ||
-					    resId == LE_RTX_SCRATCH_BUFFER_HANDLE );
+		uint16_t pass_num_samples_log2 = get_sample_count_log_2( uint32_t( pass_sample_count ) );
 
-					// Frame local resource must be available as a backend resource,
-					// unless the resource is the swapchain image handle, which is owned and managed
-					// by the swapchain.
-					// Another exception is LE_RTX_SCRATCH_BUFFER, which is a transient resource,
-					// and as such does not end up in backendResources, but starts out directly
-					// as a binned resource.
-					// Otherwise something fishy is going on.
-				}
-			}
+		le_resource_handle const* p_resources              = nullptr;
+		le::AccessFlags2 const*   p_resources_access_flags = nullptr;
+		size_t                    resources_count          = 0;
 
-			// If we use a mutex to protect backend-wide resources, we can release it now.
-		}
-	}
+		renderpass_i.get_used_resources( *rp, &p_resources, &p_resources_access_flags, &resources_count );
 
-	// -- allocate any transient vk objects such as image samplers, and image views
-	frame_allocate_transient_resources( frame, device, passes, numRenderPasses );
+		for ( size_t i = 0; i != resources_count; ++i ) {
 
-	// create renderpasses - use sync chain to apply implicit syncing for image attachment resources
-	backend_create_renderpasses( frame, device );
+			le_resource_handle const& resource = p_resources[ i ]; // Resource handle
 
-	// -- make sure that there is a descriptorpool for every renderpass
-	backend_create_descriptor_pools( frame, device, numRenderPasses );
+			// Test whether a resource with this id is already in usedResources -
+			// if not, resource_index will be identical to usedResource vector size,
+			// which is useful, because as soon as we add an element to the vector
+			// resource_index will index the correct element.
 
-	// patch and retain physical resources in bulk here, so that
-	// each pass may be processed independently
+			// We must ensure that images which are used as Color, or DepthStencil attachments
+			// fit the extents of their renderpass - as this is a Vulkan requirement.
+			//
+			// We do this here, because we know the extents of the renderpass.
+			//
+			// We also need to ensure that the extent has 1 as depth value by default.
 
-	backend_create_frame_buffers( frame, device );
+			le_resource_info_t resourceInfo( resource->data->type ); // empty resource info, but with type set according to resource type
 
-	return true;
-};
+			if ( resourceInfo.type == LeResourceType::eImage ) {
 
-// ----------------------------------------------------------------------
-static le_allocator_o** backend_get_transient_allocators( le_backend_o* self, size_t frameIndex ) {
-	return self->mFrames[ frameIndex ].allocators.data();
-}
+				auto& imgInfo = resourceInfo.image;
 
-// ----------------------------------------------------------------------
+				imgInfo.extent_from_pass = { pass_width, pass_height, 1 };
 
-static le_command_stream_t** backend_get_frame_command_streams( le_backend_o* self, size_t frameIndex, size_t num_command_streams ) {
+				if ( p_resources_access_flags[ i ] &
+				     // automatically detect usage as color attachment
+				     ( le::AccessFlagBits2::eColorAttachmentRead |
+				       le::AccessFlagBits2::eColorAttachmentWrite ) ) {
+					imgInfo.usage |=
+					    le::ImageUsageFlagBits::eColorAttachment;
+				}
 
-	// Check if the command stream pool has enough free command stream elements in the pool for us
-	// If no, we must add some additional command streams
+				if ( p_resources_access_flags[ i ] &
+				     // automatically detect usage as depth buffer
+				     ( le::AccessFlagBits2::eDepthStencilAttachmentRead |
+				       le::AccessFlagBits2::eDepthStencilAttachmentWrite ) ) {
+					imgInfo.usage |=
+					    le::ImageUsageFlagBits::eDepthStencilAttachment;
+				}
 
-	auto& cmd_streams = self->mFrames[ frameIndex ].command_streams;
+				if ( p_resources_access_flags[ i ] & le::AccessFlagBits2::eShaderSampledRead ) {
+					imgInfo.usage |= le::ImageUsageFlagBits::eSampled;
+				}
 
-	// We should maybe find a nicer way to do this...
-	while ( cmd_streams.size() < num_command_streams ) {
-		cmd_streams.insert( cmd_streams.end(), new le_command_stream_t() );
-	}
+				if ( ( p_resources_access_flags[ i ] &
+				       ( le::AccessFlagBits2::eColorAttachmentWrite |
+				         le::AccessFlagBits2::eColorAttachmentRead |
+				         le::AccessFlagBits2::eDepthStencilAttachmentWrite |
+				         le::AccessFlagBits2::eDepthStencilAttachmentRead ) ) ) {
 
-	return cmd_streams.data();
-};
+					// ---------- | resource is either used as a depth stencil attachment, or a color attachment
 
-// ----------------------------------------------------------------------
-static le_allocator_o** backend_create_transient_allocators( le_backend_o* self, size_t frameIndex, size_t numAllocators ) {
+					imgInfo.mipLevels    = 1;
+					imgInfo.imageType    = le::ImageType::e2D;
+					imgInfo.tiling       = le::ImageTiling::eOptimal;
+					imgInfo.arrayLayers  = 1;
+					imgInfo.samplesFlags = uint32_t( 1 ) << pass_num_samples_log2; // note we set sample count as a flag so that it can be consolidated -
 
-	using namespace le_backend_vk;
+					// imgInfo.sample_count_log2 = 0; // note that we leave sample_count_log2 untouched.
+					imgInfo.extent = { pass_width, pass_height, 1 };
+				}
 
-	auto&                           frame                         = self->mFrames[ frameIndex ];
-	static const VkBufferUsageFlags LE_BUFFER_USAGE_FLAGS_SCRATCH = defaults_get_buffer_usage_scratch();
+			} else if ( resourceInfo.type == LeResourceType::eBuffer ) {
+			} else if ( resourceInfo.type == LeResourceType::eRtxBlas ) {
+			} else if ( resourceInfo.type == LeResourceType::eRtxTlas ) {
+			} else {
+				assert( false ); // unreachable
+			}
 
-	for ( size_t i = frame.allocators.size(); i != numAllocators; ++i ) {
+			{
+				auto emplace_result = active_resources.try_emplace( resource, std::move( resourceInfo ) );
+				if ( !emplace_result.second ) {
+					// entry was not assigned, result.first will hold an iterator to the current element
+					consolidate_resource_info_into( emplace_result.first->second, resourceInfo );
+				}
+			}
+		} // end for all resources
 
-		assert( numAllocators < 256 ); // must not have more than 255 allocators, otherwise we cannot store index in LeResourceHandleMeta.
+	} // end for all passes
 
-		VkBuffer          buffer = nullptr;
-		VmaAllocation     allocation;
-		VmaAllocationInfo allocationInfo;
+	// -- Consolidate resources with pre-declared resources
+	//
+	// If any of our active resources has been pre-declared explicitly via the rendergraph,
+	// consolidate its info with the pre-declared resource's info.
+	//
+	// As a side-effect this will also consolidate any frame-declared resources which
+	// are declared more than once and used in the current rendergraph.
 
-		VmaAllocationCreateInfo createInfo{};
-		createInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		createInfo.pool  = frame.allocationPool; // Since we're allocating from a pool all fields but .flags will be taken from the pool
+	for ( auto const& [ resource, resource_info ] : frame_declared_resources ) {
 
-		le_buf_resource_handle res = declare_resource_virtual_buffer( uint8_t( i ) );
+		auto find_result = active_resources.find( resource );
+		if ( find_result != active_resources.end() ) {
+			// a declared resource was found for an used resource - we must consolidate the two.
+			consolidate_resource_info_into( find_result->second, resource_info );
+		}
+	}
+}
 
-		createInfo.pUserData = res;
+// ----------------------------------------------------------------------
 
-		VkBufferCreateInfo bufferCreateInfo{
-		    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-		    .pNext                 = nullptr, // optional
-		    .flags                 = 0,       // optional
-		    .size                  = LE_LINEAR_ALLOCATOR_SIZE,
-		    .usage                 = LE_BUFFER_USAGE_FLAGS_SCRATCH,
-		    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-		    .queueFamilyIndexCount = 0,
-		    .pQueueFamilyIndices   = nullptr,
-		};
+static void insert_msaa_versions(
+    std::unordered_map<le_resource_handle, le_resource_info_t>& active_resources ) {
+	ZoneScoped;
+	// For each image resource which is specified with versions of additional sample counts
+	// we create additional resource_ids (by patching in the sample count), and add matching
+	// resource info, so that multisample versions of image resources can be allocated dynamically.
+	std::unordered_map<le_resource_handle, le_resource_info_t> extra_resources;
 
-		auto result = vmaCreateBuffer( self->mAllocator, &bufferCreateInfo, &createInfo, &buffer, &allocation, &allocationInfo );
+	for ( auto const& ar : active_resources ) {
+		if ( ar.first->data->type != LeResourceType::eImage ) {
+			continue;
+		}
 
-		assert( result == VK_SUCCESS ); // todo: deal with failed allocation
+		// ----------| Invariant: resource is an image
 
-		// Create a new allocator - note that we assume an alignment of 256 bytes
-		le_allocator_o* allocator = le_allocator_linear_i.create( &allocationInfo, 256 );
+		// For any samplesFlags, we must create a matching msaa version of the image.
+		std::bitset<sizeof( ar.second.image.samplesFlags ) * 8> samples_flags( ar.second.image.samplesFlags );
 
-		frame.allocators.emplace_back( allocator );
-		frame.allocatorBuffers.emplace_back( std::move( buffer ) );
-		frame.allocations.emplace_back( std::move( allocation ) );
-		frame.allocationInfos.emplace_back( std::move( allocationInfo ) );
-	}
+		uint32_t sample_count_log_2 = 1;                  // 2^1 evaluates to 2
+		samples_flags               = samples_flags >> 1; // we remove the single-sampled image, as we assume it already exists.
 
-	return frame.allocators.data();
-}
+		while ( samples_flags.count() ) {
 
-// ----------------------------------------------------------------------
+			if ( samples_flags.test( 0 ) ) {
+				// we must create a resource copy with this sample count
+				le_resource_handle resource_copy =
+				    le_renderer::renderer_i.produce_img_resource_handle(
+				        ar.first->data->debug_name, sample_count_log_2, static_cast<le_img_resource_handle>( ar.first ), 0 );
+				le_resource_info_t resource_info_copy      = ar.second;
+				resource_info_copy.image.sample_count_log2 = sample_count_log_2;
 
-static le_staging_allocator_o* backend_get_staging_allocator( le_backend_o* self, size_t frameIndex ) {
-	return self->mFrames[ frameIndex ].stagingAllocator;
-}
+				// insert extra resource into extra msaa resources
+				auto result = extra_resources.try_emplace( resource_copy, resource_info_copy );
+				if ( result.second == false ) {
+					// key already existed, must be consolidated
+					consolidate_resource_info_into( result.first->second, resource_info_copy );
+				}
+			}
 
-void debug_print_le_pipeline_layout_info( le_pipeline_layout_info* info ) {
-	static auto logger = LeLog( LOGGER_LABEL );
-	logger.debug( "pipeline layout: %x", info->pipeline_layout_key );
-	for ( size_t i = 0; i != info->set_layout_count; i++ ) {
-		logger.debug( "set layout key : %x", info->set_layout_keys[ i ] );
+			samples_flags = samples_flags >> 1;
+			sample_count_log_2++;
+		}
 	}
-}
 
-static bool is_equal( le_pipeline_and_layout_info_t const& lhs, le_pipeline_and_layout_info_t const& rhs ) {
-	return lhs.pipeline == rhs.pipeline &&
-	       lhs.layout_info.set_layout_count == rhs.layout_info.set_layout_count &&
-	       0 == memcmp( lhs.layout_info.set_layout_keys, rhs.layout_info.set_layout_keys, sizeof( uint64_t ) * lhs.layout_info.set_layout_count ) &&
-	       lhs.layout_info.active_vk_shader_stages == rhs.layout_info.active_vk_shader_stages;
+	// append extra resources to active resources
+	for ( auto& er : extra_resources ) {
+		auto result = active_resources.try_emplace( er.first, er.second );
+		if ( result.second == false ) {
+			// key already existed, must be consolidated
+			consolidate_resource_info_into( result.first->second, er.second );
+		}
+	}
 }
 
-static bool updateArguments( const VkDevice&                    device,
-                             const VkDescriptorPool&            descriptorPool_,
-                             const ArgumentState&               argumentState,
-                             std::array<DescriptorSetState, 8>& previousSetData,
-                             VkDescriptorSet*                   descriptorSets ) {
+// ----------------------------------------------------------------------
 
+static void printResourceInfo( le_resource_handle const& handle, ResourceCreateInfo const& info, const char* prefix = "" ) {
+	ZoneScoped;
 	static auto logger = LeLog( LOGGER_LABEL );
-	// -- allocate descriptors from descriptorpool based on set layout info
-
-	if ( argumentState.setCount == 0 ) {
-		return true;
+	if ( info.isBuffer() ) {
+		logger.info( "%-15s : %-32s : %11d : %30s : %-30s", prefix, handle->data->debug_name, info.bufferInfo.size, "-",
+		             to_string_vk_buffer_usage_flags( info.bufferInfo.usage ).c_str() );
+	} else if ( info.isImage() ) {
+		logger.info( "%-15s : %-30s@%d : %dx%dx%d : %30s : %-30s",
+		             prefix,
+		             !( handle->data->debug_name[ 0 ] == '\0' )
+		                 ? handle->data->debug_name
+		             : handle->data->reference_handle
+		                 ? handle->data->reference_handle->data->debug_name
+		                 : "unnamed",
+		             uint32( info.imageInfo.samples ),
+		             info.imageInfo.extent.width,
+		             info.imageInfo.extent.height,
+		             info.imageInfo.extent.depth,
+		             to_str_vk_format( info.imageInfo.format ),
+		             to_string_vk_image_usage_flags( info.imageInfo.usage ).c_str() );
+	} else if ( info.isBlas() ) {
+		logger.info( "%-15s :%-32s : %11d : (%28d) : %-30s",
+		             prefix,
+		             handle->data->debug_name,
+		             info.blasInfo.buffer_size,
+		             info.blasInfo.scratch_buffer_size,
+		             "-" );
+	} else if ( info.isTlas() ) {
+		logger.info( "%-15s :%-32s : %11d : (%28d) : %-30s",
+		             prefix,
+		             handle->data->debug_name,
+		             info.tlasInfo.buffer_size,
+		             info.tlasInfo.scratch_buffer_size,
+		             "-" );
 	}
+}
 
-	// ----------| invariant: there are descriptorSets to allocate
+// ----------------------------------------------------------------------
 
-	bool argumentsOk = true;
+static void patch_renderpass_extents(
+    le_renderpass_o** passes,
+    size_t            numRenderPasses,
+    uint32_t          default_width,
+    uint32_t          default_height ) {
+	ZoneScoped;
+	using namespace le_renderer;
 
-	auto get_argument_name = [ &argumentState ]( size_t set_id, uint32_t binding_number ) -> char const* {
-		for ( auto const& b : argumentState.binding_infos ) {
-			if ( b.binding == binding_number && b.setIndex == set_id ) {
-				return le_get_argument_name_from_hash( b.name_hash );
-			}
+	auto passes_end = passes + numRenderPasses;
+
+	for ( auto rp = passes; rp != passes_end; rp++ ) {
+		uint32_t pass_width  = 0;
+		uint32_t pass_height = 0;
+		renderpass_i.get_framebuffer_settings( *rp, &pass_width, &pass_height, nullptr );
+		if ( pass_width == 0 ) {
+			// if zero was chosen this means to use the default extents values for a
+			// renderpass, which is to use the frame's current swapchain extents.
+			pass_width = default_width;
+			renderpass_i.set_width( *rp, pass_width );
 		}
 
-		// ---------| invariant: not found
+		if ( pass_height == 0 ) {
+			// if zero was chosen this means to use the default extents values for a
+			// renderpass, which is to use the frame's current swapchain extents.
+			pass_height = default_height;
+			renderpass_i.set_height( *rp, pass_height );
+		}
+	}
+}
 
-		return nullptr;
-	};
+// ----------------------------------------------------------------------
 
-	// -- write data from descriptorSetData into freshly allocated DescriptorSets
-	for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+static bool inferImageFormat( le_backend_o* self, le_img_resource_handle const& resource, le::ImageUsageFlags const& usageFlags, ResourceCreateInfo* createInfo ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-		// If argumentState contains invalid information (for example if an uniform has not been set yet)
-		// this will lead to SEGFAULT. You must ensure that argumentState contains valid information.
-		//
-		// The most common case for this bug is not providing any data for a uniform used in the shader,
-		// we check for this and skip any argumentStates which have invalid data...
+	// If image format was not specified, we must try to
+	// infer the image format from usage flags.
+	auto inferred_format = infer_image_format_from_le_image_usage_flags( self, usageFlags );
 
-		static constexpr auto NULL_VK_BUFFER                     = VkBuffer( nullptr );
-		static constexpr auto NULL_VK_IMAGE_VIEW                 = VkImageView( nullptr );
-		static constexpr auto NULL_VK_ACCELERATION_STRUCTURE_KHR = VkAccelerationStructureKHR( nullptr );
+	if ( inferred_format == le::Format::eUndefined ) {
+		logger.error( "Fatal: Cannot infer image format, resource underspecified: '%s'", resource->data->debug_name );
+		logger.error( "Specify usage, or provide explicit format option for resource to fix this error. " );
+		logger.error( "Consider using le::RenderModule::declareResource()" );
 
-		// Whether to test that that arguments are set correctly
-		// - we don't do this check by default if we're running a release build
-#ifdef NDEBUG
-		LE_SETTING( bool, LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE, false );
-#else
-		LE_SETTING( bool, LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE, true );
-#endif
+		assert( false ); // we don't have enough information to infer image format.
+		return false;
+	} else {
+		createInfo->imageInfo.format = static_cast<VkFormat>( inferred_format );
+	}
 
-		if ( *LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE ) [[unlikely]] {
-			for ( auto& a : argumentState.setData[ setId ] ) {
+	return true;
+}
 
-				switch ( a.type ) {
-				case le::DescriptorType::eStorageBufferDynamic: //
-				case le::DescriptorType::eUniformBuffer:        //
-				case le::DescriptorType::eUniformBufferDynamic: //
-				case le::DescriptorType::eStorageBuffer:        // fall-through
-					if ( NULL_VK_BUFFER == a.bufferInfo.buffer ) {
-						// if buffer must have valid buffer bound
-						logger.error( "Buffer argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
-						              get_argument_name( setId, a.bindingNumber ),
-						              setId,
-						              a.bindingNumber,
-						              a.arrayIndex );
-						argumentsOk = false;
-					}
-					break;
-				case le::DescriptorType::eCombinedImageSampler:
-				case le::DescriptorType::eSampledImage:
-				case le::DescriptorType::eStorageImage:
-					argumentsOk &= ( NULL_VK_IMAGE_VIEW != a.imageInfo.imageView ); // if sampler, must have valid image view
-					if ( NULL_VK_IMAGE_VIEW == a.imageInfo.imageView ) {
-						// if image - must have valid imageview bound
-						logger.error( "Image argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
-						              get_argument_name( setId, a.bindingNumber ),
-						              setId,
-						              a.bindingNumber,
-						              a.arrayIndex );
-						argumentsOk = false;
-					}
-					break;
-				case le::DescriptorType::eAccelerationStructureKhr:
-					argumentsOk &= ( NULL_VK_ACCELERATION_STRUCTURE_KHR != a.accelerationStructureInfo.accelerationStructure );
-					if ( NULL_VK_ACCELERATION_STRUCTURE_KHR == a.accelerationStructureInfo.accelerationStructure ) {
-						// if image - must have valid acceleration structure bound
-						logger.error( "Acceleration Structure argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
-						              get_argument_name( setId, a.bindingNumber ),
-						              setId,
-						              a.bindingNumber,
-						              a.arrayIndex );
-						argumentsOk = false;
-					}
+// ----------------------------------------------------------------------
+// If image has mip levels, we implicitly add usage: "transfer_src", so that mip maps may be created by blitting.
+static void patchImageUsageForMipLevels( ResourceCreateInfo* createInfo ) {
+	if ( createInfo->imageInfo.mipLevels > 1 ) {
+		createInfo->imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+}
 
-					break;
-				default:
-					argumentsOk &= false;
-					// TODO: check arguments for other types of descriptors
-					assert( false && "unhandled descriptor type" );
-					break;
-				}
+// ----------------------------------------------------------------------
 
-				if ( false == argumentsOk ) {
-					assert( false && "Argument state did not fit template" );
-					break;
-				}
-			}
-		}
+static void frame_resources_set_debug_names( le_backend_vk_instance_o* instance, VkDevice device_, BackendFrameData::ResourceMap_T& resources ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-		if ( argumentsOk ) {
+	// We capture the check for extension as a static, as this is not expected to
+	// change for the lifetime of the application, and checking for the extension
+	// on each frame is wasteful.
+	//
+	static bool check_utils_extension_available = le_backend_vk::vk_instance_i.is_extension_available( instance, VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
 
-			// We test the current argument state of descriptors against the currently bound
-			// descriptors - we only (re-)allocate descriptorsets for when we detect a change
-			// within one of these sets.
+	if ( !check_utils_extension_available ) {
+		return;
+	}
 
-			// FIXME: there is a subtle bug here - if setData is the same between arguments we
-			// should theoretically be able to recycle the descriptorset - but beware! If the
-			// decriptorset requires a different layout, then you must re-allocate. This can
-			// happen when descriptors differ in usage flags, for example (vertex|fragment vs. vertex)
-			// -- in such a case the parameters are the same between two descriptorSets,
-			// but the descriptorSetLayouts will be different, and you must allcate the matching
-			// descriptorSet.
+	// --------| invariant utuls extension is available
 
-			if ( previousSetData[ setId ].setData.empty() ||
-			     previousSetData[ setId ].setData != argumentState.setData[ setId ] ||
-			     previousSetData[ setId ].setLayout != argumentState.layouts[ setId ] ) {
+	for ( auto const& r : resources ) {
 
-				VkDescriptorSetAllocateInfo allocateInfo{
-				    .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-				    .pNext              = nullptr, // optional
-				    .descriptorPool     = descriptorPool_,
-				    .descriptorSetCount = 1,
-				    .pSetLayouts        = &argumentState.layouts[ setId ],
-				};
+		auto device = VkDevice( device_ );
 
-				// -- allocate descriptorSets based on current layout
-				// and place them in the correct position
+		VkDebugUtilsObjectNameInfoEXT nameInfo{
+		    .sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+		    .pNext        = nullptr, // optional
+		    .objectType   = VK_OBJECT_TYPE_UNKNOWN,
+		    .objectHandle = 0,
+		    .pObjectName  = "", // optional
+		};
+		;
 
-				auto result = vkAllocateDescriptorSets( device, &allocateInfo, &descriptorSets[ setId ] );
-
-				assert( result == VK_SUCCESS && "failed to allocate descriptor set" );
+		nameInfo.pObjectName = r.first->data->debug_name;
 
-				if ( /* DISABLES CODE */ ( false ) ) {
-					// I wish that this would work - but it appears that accelerator decriptors cannot be updated using templates.
-					vkUpdateDescriptorSetWithTemplate( device, descriptorSets[ setId ], argumentState.updateTemplates[ setId ], argumentState.setData[ setId ].data() );
+		switch ( r.first->data->type ) {
+		case LeResourceType::eImage:
+			nameInfo.objectType   = VK_OBJECT_TYPE_IMAGE;
+			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.image );
+			break;
+		case LeResourceType::eBuffer:
+			nameInfo.objectType   = VK_OBJECT_TYPE_BUFFER;
+			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.buffer );
+			break;
+		case LeResourceType::eRtxBlas:
+			nameInfo.objectType   = VK_OBJECT_TYPE_ACCELERATION_STRUCTURE_KHR;
+			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.blas );
+			break;
+		case LeResourceType::eRtxTlas:
+			nameInfo.objectType   = VK_OBJECT_TYPE_ACCELERATION_STRUCTURE_KHR;
+			nameInfo.objectHandle = reinterpret_cast<uint64_t>( r.second.as.tlas );
+			break;
+		default:
+			assert( false && "unknown resource type" );
+		}
 
-				} else {
+		VkResult result = vkSetDebugUtilsObjectNameEXT( device, &nameInfo );
+		assert( result == VK_SUCCESS );
+	}
+}
 
-					std::vector<VkWriteDescriptorSet> write_descriptor_sets;
+// ----------------------------------------------------------------------
+// Fills `heaps` with budget and usage per memory heap. If `heaps` is nullptr,
+// only stores the number of memory heaps in `num_heaps`.
+static void backend_get_memory_budget( le_backend_o* self, le_memory_heap_budget_t* heaps, uint32_t* num_heaps ) {
 
-					// We deliberately allocate write descriptor set acceleration structure objects on the heap,
-					// so that the pointer to the object will not change if and when the vector grows.
-					//
-					// This means that we can hand out copies of pointers from this vector without fear from
-					// within the current scope, but also that we must clean up the contents of the vector
-					// manually before leaving the current scope or else we will leak these objects.
-					std::vector<VkWriteDescriptorSetAccelerationStructureKHR*> write_acceleration_structures;
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_MEMORY_BUDGET_MB, 0 ); // 0 means: use the budget reported by the driver
 
-					write_descriptor_sets.reserve( argumentState.setData[ setId ].size() );
+	VkPhysicalDeviceMemoryProperties const* memory_properties = nullptr;
+	vmaGetMemoryProperties( self->mAllocator, &memory_properties );
 
-					for ( auto& a : argumentState.setData[ setId ] ) {
-						VkWriteDescriptorSet w{
-						    .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-						    .pNext            = nullptr, // optional
-						    .dstSet           = descriptorSets[ setId ],
-						    .dstBinding       = a.bindingNumber,
-						    .dstArrayElement  = a.arrayIndex,
-						    .descriptorCount  = 1,
-						    .descriptorType   = VkDescriptorType( a.type ),
-						    .pImageInfo       = 0,
-						    .pBufferInfo      = 0,
-						    .pTexelBufferView = 0,
-						};
-						;
+	if ( heaps == nullptr ) {
+		*num_heaps = memory_properties->memoryHeapCount;
+		return;
+	}
 
-						switch ( a.type ) {
-						case le::DescriptorType::eSampler:
-						case le::DescriptorType::eCombinedImageSampler:
-						case le::DescriptorType::eSampledImage:
-						case le::DescriptorType::eStorageImage:
-						case le::DescriptorType::eInputAttachment:
-							w.pImageInfo = reinterpret_cast<VkDescriptorImageInfo const*>( &a.imageInfo );
-							break;
-						case le::DescriptorType::eUniformTexelBuffer:
-						case le::DescriptorType::eStorageTexelBuffer:
-							w.pTexelBufferView = reinterpret_cast<VkBufferView const*>( &a.texelBufferInfo );
-							break;
-						case le::DescriptorType::eUniformBuffer:
-						case le::DescriptorType::eStorageBuffer:
-						case le::DescriptorType::eUniformBufferDynamic:
-						case le::DescriptorType::eStorageBufferDynamic:
-							w.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo const*>( &a.bufferInfo );
-							break;
-						case le::DescriptorType::eInlineUniformBlockExt:
-							assert( false && "inline uniform blocks are not yet supported" );
-							break;
-						case le::DescriptorType::eAccelerationStructureNv:
-							assert( false && "NV acceleration structures are not supported anymore. Use KHR acceleration structures." );
-							break;
-						case le::DescriptorType::eAccelerationStructureKhr: {
-							// FIXME: use an arena for that - we don't want to allocate on the free store
-							auto wd = new VkWriteDescriptorSetAccelerationStructureKHR{
-							    .sType                      = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
-							    .pNext                      = nullptr, // optional
-							    .accelerationStructureCount = 1,
-							    .pAccelerationStructures    = &reinterpret_cast<VkAccelerationStructureKHR const&>( a.accelerationStructureInfo.accelerationStructure ),
-							};
-							w.pNext = wd;
-							write_acceleration_structures.push_back( wd );
+	// ----------| invariant: heaps points to an array of at least num_heaps elements
 
-						} break;
-						default:
-							assert( false && "Unhandled descriptor Type" );
-						}
+	VmaBudget budgets[ VK_MAX_MEMORY_HEAPS ]{};
+	vmaGetHeapBudgets( self->mAllocator, budgets );
 
-						write_descriptor_sets.emplace_back( w );
-					}
-					vkUpdateDescriptorSets( device, uint32_t( write_descriptor_sets.size() ), write_descriptor_sets.data(), 0, nullptr );
+	uint64_t const configured_budget = uint64_t( *LE_SETTING_BACKEND_MEMORY_BUDGET_MB ) << 20;
 
-					// We must manually delete any WriteDescriptorSetAccelerationStructureKHR objects
-					for ( auto& w : write_acceleration_structures ) {
-						delete ( w );
-					}
-				}
-				previousSetData[ setId ].setData   = argumentState.setData[ setId ];
-				previousSetData[ setId ].setLayout = argumentState.layouts[ setId ];
-			}
+	*num_heaps = std::min( *num_heaps, memory_properties->memoryHeapCount );
 
-		} else {
-			return false;
+	for ( uint32_t i = 0; i != *num_heaps; i++ ) {
+		auto& h            = heaps[ i ];
+		h.is_device_local  = ( memory_properties->memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ) ? 1 : 0;
+		h.budget_bytes     = budgets[ i ].budget;
+		h.usage_bytes      = budgets[ i ].usage;
+		h.allocation_bytes = budgets[ i ].statistics.allocationBytes;
+		h.block_bytes      = budgets[ i ].statistics.blockBytes;
+		h.allocation_count = budgets[ i ].statistics.allocationCount;
+		h.block_count      = budgets[ i ].statistics.blockCount;
+		if ( h.is_device_local && configured_budget != 0 ) {
+			h.budget_bytes = std::min( h.budget_bytes, configured_budget );
 		}
 	}
+}
 
-	return argumentsOk;
-};
+// ----------------------------------------------------------------------
+
+static void backend_set_image_evictable( le_backend_o* self, le_img_resource_handle image, bool evictable ) {
+	auto lock = std::scoped_lock( self->residency_mutex );
+	if ( evictable ) {
+		self->evictable_images.insert( image );
+	} else {
+		self->evictable_images.erase( image );
+		// Cancel any pending eviction - the image must stay resident from now on.
+		self->evicted_images.erase( image );
+		self->residency_pending_evictions.erase( image );
+	}
+}
 
 // ----------------------------------------------------------------------
+// Returns true if image was selected for eviction since the last time this was called for image.
+//
+// Once this returns true, the caller must treat the contents of the image as undefined, and write
+// them again before the image is next used. The backend frees the image only once all frames which
+// were recorded before this call have been acquired - see `backend_evict_images_over_budget`.
+static bool backend_was_image_evicted( le_backend_o* self, le_img_resource_handle image ) {
+	auto lock = std::scoped_lock( self->residency_mutex );
+	if ( self->evicted_images.erase( image ) == 0 ) {
+		return false;
+	}
+	// Frames get their number when they are cleared, which is before they are recorded - any frame
+	// recorded from now on will therefore have a number at least as large as the current count.
+	auto it = self->residency_pending_evictions.find( image );
+	if ( it != self->residency_pending_evictions.end() ) {
+		it->second = self->mFramesCount;
+	}
+	return true;
+}
 
-static void debug_print_command( void*& cmd ) {
-	static auto        logger = LeLog( LOGGER_LABEL );
-	std::ostringstream os;
-	os << "cmd: ";
+// ----------------------------------------------------------------------
+// Publishes memory budget and usage for device-local heaps via LE_SETTING_BACKEND_MEMORY_STATS,
+// so that these can be inspected via the console: `get LE_SETTING_BACKEND_MEMORY_STATS`
+static void backend_publish_memory_stats( le_backend_o* self, le_memory_heap_budget_t const* heaps, uint32_t num_heaps ) {
 
-	auto cmd_header = static_cast<le::CommandHeader*>( cmd );
+	LE_SETTING( le_setting_snapshot_t, LE_SETTING_BACKEND_MEMORY_STATS, "" );
 
-	// clang-format off
-			switch (cmd_header->info.type){
-                case (le::CommandType::eDrawIndexed): os << "eDrawIndexed"; break;
-                case (le::CommandType::eDraw): os << "eDraw"; break;
-                case (le::CommandType::eDispatch): os << "eDispatch"; break;
-                case (le::CommandType::eBufferMemoryBarrier): os << "eBufferMemoryBarrier"; break;
-                case (le::CommandType::eSetLineWidth): os << "eSetLineWidth"; break;
-                case (le::CommandType::eSetViewport): os << "eSetViewport"; break;
-                case (le::CommandType::eSetScissor): os << "eSetScissor"; break;
-                case (le::CommandType::eSetPushConstantData): os << "eSetPushConstantData"; break;
-                case (le::CommandType::eBindArgumentBuffer): os << "eBindArgumentBuffer"; break;
-                case (le::CommandType::eSetArgumentTexture): os << "eSetArgumentTexture"; break;
-                case (le::CommandType::eSetArgumentImage): os << "eSetArgumentImage"; break;
-                case (le::CommandType::eBindIndexBuffer): os << "eBindIndexBuffer"; break;
-                case (le::CommandType::eBindVertexBuffers): os << "eBindVertexBuffers"; break;
-                case (le::CommandType::eBindGraphicsPipeline): os << "eBindGraphicsPipeline"; break;
-                case (le::CommandType::eBindComputePipeline): os << "eBindComputePipeline"; break;
-                case (le::CommandType::eWriteToBuffer): os << "eWriteToBuffer"; break;
-                case (le::CommandType::eBindRtxPipeline): os << "eBindRtxPipeline" ; break;
-                case (le::CommandType::eBuildRtxTlas): os << "eBuildRtxTlas"; break;
-                case (le::CommandType::eBuildRtxBlas): os << "eBuildRtxBlas"; break;
-                case (le::CommandType::eWriteToImage): os << "eWriteToImage"; break;
-                case (le::CommandType::eDrawMeshTasks): os << "eDrawMeshTasks"; break;
-                case (le::CommandType::eTraceRays): os << "eTraceRays"; break;
-                case (le::CommandType::eSetArgumentTlas): os << "eSetArgumentTlas"; break;
-			}
-	// clang-format on
+	std::ostringstream msg;
 
-	if ( cmd_header->info.type == le::CommandType::eBindGraphicsPipeline ) {
-		auto le_cmd = static_cast<le::CommandBindGraphicsPipeline*>( cmd );
-		os << " [" << std::hex << le_cmd->info.gpsoHandle << "]";
+	for ( uint32_t i = 0; i != num_heaps; i++ ) {
+		if ( !heaps[ i ].is_device_local ) {
+			continue;
+		}
+		msg << "heap " << i
+		    << ": usage " << ( heaps[ i ].usage_bytes >> 20 )
+		    << " MB / budget " << ( heaps[ i ].budget_bytes >> 20 )
+		    << " MB (allocations: " << ( heaps[ i ].allocation_bytes >> 20 )
+		    << " MB, blocks: " << ( heaps[ i ].block_bytes >> 20 ) << " MB); ";
 	}
 
-	logger.info( "%s", os.str().c_str() );
-};
+	msg << "evicted: " << self->residency_num_evicted
+	    << " images, " << ( self->residency_bytes_evicted >> 20 ) << " MB; "
+	    << "defragmented: " << self->defragmentation.num_moves
+	    << " moves, " << ( self->defragmentation.bytes_moved >> 20 ) << " MB";
 
-// convert 0xrrggbbaa color to float color
-constexpr static std::array<float, 4> hex_rgba_to_float_colour( uint32_t const& hex ) {
-	std::array<float, 4> result{
-	    ( hex >> 24 ) / 255.f,
-	    ( ( hex >> 16 ) & 0xff ) / 255.f,
-	    ( ( hex >> 8 ) & 0xff ) / 255.f,
-	    ( ( hex )&0xff ) / 255.f,
-	};
-	return result;
+	LE_SETTING_BACKEND_MEMORY_STATS->publish( msg.str() );
 }
 
-static BackendFrameData::CommandPool* backend_frame_data_produce_command_pool(
-    BackendFrameData& frame,
-    uint32_t          queue_family_index,
-    VkDevice          device ) {
+// ----------------------------------------------------------------------
+// Collects target resources of uploads which are pending, or in flight - uploads_mutex must be locked.
+static void backend_uploads_collect_targets( le_backend_o* self, std::unordered_set<le_resource_handle>& upload_targets ) {
+	for ( auto const& r : self->uploads_pending ) {
+		upload_targets.insert( r.dst );
+	}
+	for ( auto const& b : self->uploads_in_flight ) {
+		for ( auto const& r : b.requests ) {
+			upload_targets.insert( r.dst );
+		}
+	}
+}
 
-	ZoneScoped;
-	BackendFrameData::CommandPool* pool = nullptr;
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME, in backend_allocate_resources, once the frame has allocated its resources.
+//
+// Frees images which were selected for eviction, once it is safe to do so - see below.
+// Eviction of an image is cancelled if it was written to, or used, after its eviction was acknowledged,
+// as this means that its owner has re-uploaded it already.
+static void backend_free_pending_evictions( le_backend_o* self, BackendFrameData& frame, std::unordered_map<le_resource_handle, AllocatedResourceVk>& backend_resources ) {
+	static auto logger = LeLog( LOGGER_LABEL );
 
-	// search through available command pools to see if we could recycle one with a matching
-	// queue family index.
+	uint64_t bytes_evicted = 0;
+	uint64_t num_evicted   = 0;
 
-	for ( auto& existing_pool : frame.available_command_pools ) {
-		if ( false == existing_pool->is_used && existing_pool->vk_queue_family_idx == queue_family_index ) {
-			pool          = existing_pool;
-			pool->is_used = true; // mark this command pool as used
-			break;
+	{
+		auto lock = std::scoped_lock( self->residency_mutex, self->uploads_mutex );
+
+		if ( self->residency_pending_evictions.empty() ) {
+			return;
 		}
-	}
 
-	if ( pool == nullptr ) {
-		// we couldn't find a command pool, we must allocate a new one.
+		std::unordered_set<le_resource_handle> upload_targets;
+		backend_uploads_collect_targets( self, upload_targets );
 
-		pool = new BackendFrameData::CommandPool{};
+		for ( auto p = self->residency_pending_evictions.begin(); p != self->residency_pending_evictions.end(); ) {
 
-		VkCommandPoolCreateInfo create_info = {
-		    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-		    .pNext            = nullptr,                              // optional
-		    .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // optional
-		    .queueFamilyIndex = queue_family_index,
-		};
+			uint64_t const acknowledged_frame = p->second;
 
-		vkCreateCommandPool( device, &create_info, nullptr, &pool->pool );
-		le::Log( LOGGER_LABEL ).info( "Created CommandPool %p", pool->pool );
+			if ( frame.frameNumber < acknowledged_frame ) {
+				// Eviction was not acknowledged yet, or frames which were recorded before it was
+				// acknowledged - and which may therefore still use the image - have not all been acquired.
+				p++;
+				continue;
+			}
 
-		frame.available_command_pools.push_back( pool );
-		pool->vk_queue_family_idx = queue_family_index;
-		pool->is_used             = true; // mark this command pool as used
-	}
+			// ----------| invariant: all frames which may have used old contents of the image have been acquired
 
-	assert( pool && "must either find or create valid command pool" );
-	return pool;
-}
+			auto it = backend_resources.find( p->first );
 
-// predictable, repeatable response given queue flags
-static uint32_t backend_find_queue_family_index_from_requirements( le_backend_o* self, VkQueueFlags flags ) {
-	ZoneScoped;
-	uint32_t lowest_num_extra_bits = ~uint32_t( 0 );
-	uint32_t found_family          = ~uint32_t( 0 );
+			if ( it == backend_resources.end() ||
+			     it->second.last_used_frame >= acknowledged_frame ||
+			     upload_targets.count( p->first ) ) {
+				// Image is gone, or its owner has re-uploaded it already - cancel eviction.
+				p = self->residency_pending_evictions.erase( p );
+				continue;
+			}
 
-	static std::unordered_map<VkQueueFlags, uint32_t> cache;
+			if ( !frame.binnedResources.try_emplace( p->first, it->second ).second ) {
+				// A previous version of this image is already in the bin - try again with the next frame.
+				p++;
+				continue;
+			}
 
-	auto cache_entry = cache.emplace( flags, 0 );
+			bytes_evicted += it->second.allocationInfo.size;
+			num_evicted++;
 
-	if ( cache_entry.second == true ) {
-		// element was inserted, this was not a cache hit
-		for ( BackendQueueInfo const* info : self->queues ) {
-			VkQueueFlags available_flags = info->queue_flags;
-			VkQueueFlags requested_flags = flags;
+			backend_resources.erase( it );
 
-			if ( ( available_flags & requested_flags ) == requested_flags ) {
-				// requested_flags are contained in available flags
-				VkQueueFlags leftover_flags = ( available_flags & ( ~requested_flags ) ); // flags which only appear in available_flags
-				size_t       num_extra_bits = std::bitset<sizeof( VkQueueFlags ) * 8>( leftover_flags ).count();
-				if ( num_extra_bits < lowest_num_extra_bits ) {
-					found_family          = info->queue_family_index;
-					lowest_num_extra_bits = num_extra_bits;
-				}
-			}
+			// An evicted image is not owned by any queue family anymore.
+			self->resource_queue_family_ownership[ 0 ].erase( p->first );
+			self->resource_queue_family_ownership[ 1 ].erase( p->first );
+
+			p = self->residency_pending_evictions.erase( p );
 		}
-		cache_entry.first->second = found_family;
 	}
 
-	return cache_entry.first->second;
+	if ( num_evicted == 0 ) {
+		return;
+	}
+
+	self->residency_num_evicted += num_evicted;
+	self->residency_bytes_evicted += bytes_evicted;
+	self->residency_next_eviction_frame = frame.frameNumber + self->mFrames.size();
+
+	logger.info( "Evicted %zu images (%zu MB)", size_t( num_evicted ), size_t( bytes_evicted >> 20 ) );
 }
 
-// Must execute on the RECORD FRAME
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME, in backend_allocate_resources, once the frame has allocated its resources.
 //
-static void backend_acquire_swapchain_resources( le_backend_o* self, size_t frameIndex ) {
+// If device-local memory usage exceeds its budget, selects least recently used evictable images for
+// eviction until we expect to be back within budget. We only select images which no pass has used for
+// at least LE_SETTING_BACKEND_EVICT_AFTER_UNUSED_FRAMES frames, and which are not the target of an upload.
+//
+// Selected images are not freed right away: frames which have been recorded, but not yet acquired, may
+// still use them, as their owner considered them uploaded when it recorded these frames. We therefore
+// tell the owner first (via `was_image_evicted`), and free the image only once all frames recorded
+// before the owner was told have been acquired, in `backend_free_pending_evictions`. Freed images are
+// moved to the frame's bin, and removed from the backend, so that they get freed once this frame comes
+// around again.
+static void backend_evict_images_over_budget( le_backend_o* self, BackendFrameData& frame, std::unordered_map<le_resource_handle, AllocatedResourceVk>& backend_resources ) {
 	ZoneScoped;
-	auto& frame = self->mFrames[ frameIndex ];
-
-	static VkDevice device = self->device->getVkDevice();
-	using namespace le_swapchain_vk;
 	static auto logger = LeLog( LOGGER_LABEL );
 
-	decltype( frame.frame_owned_swapchain_state ) previous_swapchain_state;
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_EVICT_AFTER_UNUSED_FRAMES, 120 );
 
-	std::swap( frame.frame_owned_swapchain_state, previous_swapchain_state ); // we swap into previous so that anything left over in previous will be destroyed at end of scope.
+	backend_free_pending_evictions( self, frame, backend_resources );
 
-	for ( auto& [ key, backend_swapchain_data ] : self->swapchains ) {
-
-		auto previous_it = previous_swapchain_state.find( key );
-		// Item existed before:
-		// we can recycle the semaphores.
-
-		auto const& [ swapchain_state, was_inserted ] =
-		    ( previous_it != previous_swapchain_state.end() )                                          // if item existed in a previous version of this frame
-		        ? frame.frame_owned_swapchain_state.emplace( previous_it->first, previous_it->second ) // then copy previous swapchain info into the current frame
-		        : frame.frame_owned_swapchain_state.emplace( key, swapchain_state_t{} );               // otherwise generate new swapchain info
-
-		swapchain_state_t& local_swapchain_state = swapchain_state->second;
+	le_memory_heap_budget_t heaps[ VK_MAX_MEMORY_HEAPS ];
+	uint32_t                num_heaps = VK_MAX_MEMORY_HEAPS;
 
-		if ( previous_it == previous_swapchain_state.end() ) {
-			// item did not exist before - we must create semaphores.
+	backend_get_memory_budget( self, heaps, &num_heaps );
+	backend_publish_memory_stats( self, heaps, num_heaps );
 
-			VkSemaphoreCreateInfo const create_info = {
-			    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-			    .pNext = nullptr, // optional
-			    .flags = 0,       // optional
-			};
+	if ( frame.frameNumber < self->residency_next_eviction_frame ) {
+		// Images which we evicted earlier have not been freed yet - wait until they have,
+		// so that memory usage reflects our earlier evictions.
+		return;
+	}
 
-			local_swapchain_state.presentComplete = std::shared_ptr<SemaphoreContainer>( new SemaphoreContainer, []( SemaphoreContainer* p ) {
-				logger.info( "destroying present complete semaphore %x", p->semaphore );
-				vkDestroySemaphore( device, p->semaphore, nullptr );
-				delete ( p );
-			} );
-			vkCreateSemaphore( device, &create_info, nullptr, &local_swapchain_state.presentComplete->semaphore );
+	uint64_t bytes_over_budget = 0;
 
-			local_swapchain_state.renderComplete = std::shared_ptr<SemaphoreContainer>( new SemaphoreContainer, []( SemaphoreContainer* p ) {
-				logger.info( "destroying render complete semaphore %x", p->semaphore );
-				vkDestroySemaphore( device, p->semaphore, nullptr );
-				delete ( p );
-			} );
-			vkCreateSemaphore( device, &create_info, nullptr, &local_swapchain_state.renderComplete->semaphore );
+	for ( uint32_t i = 0; i != num_heaps; i++ ) {
+		if ( heaps[ i ].is_device_local && heaps[ i ].usage_bytes > heaps[ i ].budget_bytes ) {
+			bytes_over_budget += heaps[ i ].usage_bytes - heaps[ i ].budget_bytes;
 		}
+	}
 
-		local_swapchain_state.swapchain_data = backend_swapchain_data; // this is where we copy the swapchain into the frame.
-
-		// Acquire swapchain images - this needs to happen on the main thread.
-		//
-		// We try to acquire all images, even if one of the acquisitions fails.
-		//
-		// This is so that every semaphore for presentComplete is correctly
-		// waited upon.
-
-		bool acquire_success = true;
+	if ( bytes_over_budget == 0 ) {
+		return;
+	}
 
-		if ( !swapchain_i.acquire_next_image( local_swapchain_state.swapchain_data.get_swapchain(),
-		                                      local_swapchain_state.presentComplete->semaphore,
-		                                      &local_swapchain_state.image_idx ) ) {
+	// ----------| invariant: we are over budget
 
-			// try to acquire again by creating a new swapchain from the old one
+	// Images must not have been used by any frame which may still be in flight.
+	uint64_t const min_unused_frames = std::max<uint64_t>( *LE_SETTING_BACKEND_EVICT_AFTER_UNUSED_FRAMES, self->mFrames.size() );
 
-			le_swapchain_o* new_swapchain = swapchain_i.create_from_old_swapchain( local_swapchain_state.swapchain_data.get_swapchain() );
-			local_swapchain_state.swapchain_data.replace_swapchain( new_swapchain );
+	if ( frame.frameNumber < min_unused_frames ) {
+		return;
+	}
 
-			if ( swapchain_i.acquire_next_image( new_swapchain,
-			                                     local_swapchain_state.presentComplete->semaphore,
-			                                     &local_swapchain_state.image_idx ) ) {
+	uint64_t const max_last_used_frame = frame.frameNumber - min_unused_frames;
 
-				// if an image was acquired with a newly created swapchain, then
-				// we must query the image width and height.
+	auto lock = std::scoped_lock( self->residency_mutex, self->uploads_mutex );
 
-				local_swapchain_state.swapchain_data.swapchain_surface_format = *swapchain_i.get_surface_format( new_swapchain );
-				local_swapchain_state.swapchain_data.width                    = swapchain_i.get_image_width( new_swapchain );
-				local_swapchain_state.swapchain_data.height                   = swapchain_i.get_image_height( new_swapchain );
+	if ( self->evictable_images.empty() || !self->residency_pending_evictions.empty() ) {
+		// Memory usage does not yet reflect evictions which are pending - wait until these have been freed.
+		return;
+	}
 
-				backend_swapchain_data = local_swapchain_state.swapchain_data; // copy frame swapchain data to backend
+	std::vector<std::pair<uint64_t, le_resource_handle>> candidates; // last used frame, image
 
-				local_swapchain_state.acquire_successful = true;
-				acquire_success                          = true;
-			} else {
-				// TODO: What do we want to do if acquiring with a new swapchain fails?
-				// We should destroy both swapchains for sure.
-				acquire_success                          = false;
-				local_swapchain_state.acquire_successful = false;
-				logger.error( "Could not acquire swapchain" );
-				assert( false );
-			}
-		} else {
-			local_swapchain_state.acquire_successful = true;
-		}
+	std::unordered_set<le_resource_handle> upload_targets;
+	backend_uploads_collect_targets( self, upload_targets );
 
-		if ( !acquire_success ) {
+	for ( auto const& image : self->evictable_images ) {
+		auto it = backend_resources.find( image );
+		if ( it == backend_resources.end() ||
+		     !it->second.info.isImage() ||
+		     it->second.last_used_frame > max_last_used_frame ||
+		     upload_targets.count( image ) ) {
 			continue;
 		}
+		candidates.emplace_back( it->second.last_used_frame, image );
+	}
 
-		// TODO: what happens if we cannot acquire successfully?
-		// in which case, this frame is doomed.
-
-		auto tmp_surface_width  = local_swapchain_state.swapchain_data.width;
-		auto tmp_surface_height = local_swapchain_state.swapchain_data.height;
-
-		{
-			auto& swapchain_image_resource = frame.availableResources[ local_swapchain_state.swapchain_data.swapchain_image ];
+	std::sort( candidates.begin(), candidates.end(),
+	           []( auto const& lhs, auto const& rhs ) { return lhs.first < rhs.first; } );
 
-			swapchain_image_resource.info.type = LeResourceType::eImage;
-			swapchain_image_resource.as.image =
-			    swapchain_i.get_image( local_swapchain_state.swapchain_data.get_swapchain(), local_swapchain_state.image_idx );
+	uint64_t bytes_selected = 0;
+	uint64_t num_selected   = 0;
 
-			{
-				// Fetch Image Info for swapchain image
-				auto& imageInfo = frame.availableResources[ local_swapchain_state.swapchain_data.swapchain_image ].info.imageInfo;
+	for ( auto const& c : candidates ) {
 
-				// Overwrite Image Info
-				imageInfo = {
-				    .sType     = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-				    .pNext     = nullptr, // optional
-				    .flags     = 0,       // optional
-				    .imageType = VK_IMAGE_TYPE_2D,
-				    .format    = local_swapchain_state.swapchain_data.swapchain_surface_format.format,
-				    .extent    = {
-				           .width  = tmp_surface_width,
-				           .height = tmp_surface_height,
-				           .depth  = 1,
-                    },
-				    .mipLevels             = 1,
-				    .arrayLayers           = 1,
-				    .samples               = VK_SAMPLE_COUNT_1_BIT,
-				    .tiling                = VK_IMAGE_TILING_OPTIMAL,
-				    .usage                 = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-				    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-				    .queueFamilyIndexCount = 0, // optional
-				    .pQueueFamilyIndices   = nullptr,
-				    .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
-				};
-			}
+		if ( bytes_selected >= bytes_over_budget ) {
+			break;
 		}
 
-		// Add swapchain resource to automatically- declared resources
-		// We add this so that usage type is automatically defined for this Resource as ColorAttachment.
-		// and so that it automatically receives the correct image format.
+		bytes_selected += backend_resources.at( c.second ).allocationInfo.size;
+		num_selected++;
 
-		{
-			le_resource_info_t img_info = le_renderer::helpers_i.get_default_resource_info_for_image();
-			img_info.image.usage        = le::ImageUsageFlags( le::ImageUsageFlagBits::eColorAttachment );
-			img_info.image.extent       = { .width = tmp_surface_width, .height = tmp_surface_height, .depth = 1 };
-			img_info.image.format       = le::Format( local_swapchain_state.swapchain_data.swapchain_surface_format.format );
+		self->evicted_images.insert( c.second );
+		self->residency_pending_evictions[ c.second ] = UINT64_MAX; // not acknowledged yet
+	}
 
-			auto const& [ it, was_inserted ] = frame.declared_resources.emplace( local_swapchain_state.swapchain_data.swapchain_image, img_info );
-			if ( !was_inserted ) {
-				// If image declaration did already exist, we must consolidate the corresponing image info
-				consolidate_resource_info_into( it->second, img_info );
-			}
-		}
+	if ( num_selected == 0 ) {
+		return;
 	}
+
+	logger.info( "Memory over budget by %zu MB: selected %zu images (%zu MB) for eviction",
+	             size_t( bytes_over_budget >> 20 ), size_t( num_selected ), size_t( bytes_selected >> 20 ) );
 }
 
 // ----------------------------------------------------------------------
-//
-inline DescriptorData* find_descriptor_with_binding_number_and_array_idx(
-    std::vector<DescriptorData>& descriptor_set, uint32_t binding_number, uint32_t array_idx = 0 ) {
-	ZoneScoped;
-	for ( auto& d : descriptor_set ) {
-		if ( d.bindingNumber == binding_number &&
-		     d.arrayIndex == array_idx ) {
-			return &d;
-		}
+// If long-lived resources take part in defragmentation, we implicitly add usage: "transfer_src" and
+// "transfer_dst", so that their contents may be copied when they get moved. Transient attachments
+// can't be used for transfers - these only get moved while they hold no content.
+static void patchUsageForDefragmentation( ResourceCreateInfo* createInfo ) {
+
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME, 16 ); // 0 means: don't defragment
+
+	if ( *LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME == 0 ) {
+		return;
 	}
 
-	return nullptr;
+	if ( createInfo->isBuffer() ) {
+		createInfo->bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	} else if ( createInfo->isImage() && 0 == ( createInfo->imageInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ) ) {
+		createInfo->imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	}
 }
 
 // ----------------------------------------------------------------------
-// Decode commandStream for each pass (may happen in parallel)
-// translate into vk specific commands.
-static void backend_process_frame( le_backend_o* self, size_t frameIndex ) {
+// Returns the pool from which to allocate a long-lived resource, and creates this pool if needed.
+// Returns nullptr if the resource should come from the default pools - this is the case for
+// resources other than buffers and images, and if defragmentation is switched off.
+//
+// Defragmentation may move any allocation within the pool which it defragments, and we only know
+// how to move resources which the backend owns - which is why these get pools of their own.
+//
+// Must be called with allocated resources locked.
+static VmaPool backend_get_resource_pool( le_backend_o* self, ResourceCreateInfo const& info ) {
 
-	ZoneScoped;
-	static auto logger = LeLog( LOGGER_LABEL );
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME, 16 ); // 0 means: don't defragment
 
-	if ( LE_PRINT_DEBUG_MESSAGES ) {
-		logger.debug( "** Process Frame #%8d **", frameIndex );
+	if ( *LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME == 0 || !( info.isBuffer() || info.isImage() ) ) {
+		return nullptr;
 	}
 
-	using namespace le_renderer;   // for encoder
-	using namespace le_backend_vk; // for device
+	VmaAllocationCreateInfo allocationCreateInfo = get_resource_allocation_create_info();
 
-	auto& frame = self->mFrames[ frameIndex ];
+	uint32_t memory_type_index = 0;
+	VkResult result =
+	    info.isBuffer()
+	        ? vmaFindMemoryTypeIndexForBufferInfo( self->mAllocator, &info.bufferInfo, &allocationCreateInfo, &memory_type_index )
+	        : vmaFindMemoryTypeIndexForImageInfo( self->mAllocator, &info.imageInfo, &allocationCreateInfo, &memory_type_index );
 
-	// Only insert debug labels iff validation layers are active - otherwise we will get errors.
-	// Debug labels are useful for RenderDoc, for example.
-	bool const SHOULD_INSERT_DEBUG_LABELS = self->instance->is_using_validation_layers;
+	if ( result != VK_SUCCESS ) {
+		return nullptr;
+	}
 
-	VkDevice device = self->device->getVkDevice();
+	auto& pools = self->defragmentation.pools;
 
-	static_assert( sizeof( VkViewport ) == sizeof( le::Viewport ), "Viewport data size must be same in vk and le" );
-	static_assert( sizeof( VkRect2D ) == sizeof( le::Rect2D ), "Rect2D data size must be same in vk and le" );
+	for ( auto const& [ type_index, pool ] : pools ) {
+		if ( type_index == memory_type_index ) {
+			return pool;
+		}
+	}
 
-	static auto maxVertexInputBindings = vk_device_i.get_vk_physical_device_properties( *self->device )->limits.maxVertexInputBindings;
+	// ----------| invariant: there is no pool for this memory type yet
 
-	bool needs_to_collect_root_pass_names = frame.must_create_queues_dot_graph; // only collect root pass names when these are needed, for example in order to create dot graphs or debug printouts
+	VmaPoolCreateInfo poolInfo{};
+	poolInfo.memoryTypeIndex = memory_type_index; // anything else: same defaults as default pools
 
-	{
+	VmaPool pool = nullptr;
 
-		// -- Collect command buffers for each queue submission by testing against queue submission key.
-		//    if a pass's affinity matches the submission key, it belongs to that particular queue submission.
-		// -- And collect pass indices per queue submission
+	if ( vmaCreatePool( self->mAllocator, &poolInfo, &pool ) != VK_SUCCESS ) {
+		return nullptr;
+	}
 
-		size_t num_invocation_keys = frame.queue_submission_keys.size();
+	pools.emplace_back( memory_type_index, pool );
 
-		for ( size_t i = 0; i != num_invocation_keys; i++ ) {
+	return pool;
+}
 
-			auto const& key = frame.queue_submission_keys[ i ];
+// ----------------------------------------------------------------------
+// Ends defragmentation for the current pool, and moves on to the next pool. Once we have
+// been through all pools, we wait for a while before we start over with the first pool.
+static void backend_defragment_end_pool( le_backend_o* self, uint64_t frame_number ) {
 
-			BackendFrameData::PerQueueSubmissionData submission_data{};
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_DEFRAGMENT_INTERVAL_FRAMES, 600 );
 
-			for ( size_t pi = 0; pi != frame.passes.size(); pi++ ) {
+	auto& d = self->defragmentation;
 
-				auto const& pass = frame.passes[ pi ];
+	if ( d.context ) {
+		vmaEndDefragmentation( self->mAllocator, d.context, nullptr );
+		d.context = nullptr;
+	}
 
-				if ( key & pass.root_passes_affinity ) {
-					submission_data.queue_flags |= VkQueueFlags( pass.type ); // Accumulate queue flags over submission - queue capabilities must be superset
-					submission_data.pass_indices.push_back( uint32_t( pi ) );
-				}
-			}
+	if ( ++d.pool_index >= d.pools.size() ) {
+		d.pool_index       = 0;
+		d.next_sweep_frame = frame_number + *LE_SETTING_BACKEND_DEFRAGMENT_INTERVAL_FRAMES;
+	}
+}
 
-			if ( needs_to_collect_root_pass_names ) {
-				for ( size_t j = 0; j != frame.debug_root_passes_names.size(); j++ ) {
-					if ( key & ( uint64_t( 1 ) << j ) ) {
-						if ( !submission_data.debug_root_passes_names.empty() ) {
-							submission_data.debug_root_passes_names.append( " | " );
-						}
-						submission_data.debug_root_passes_names.append( frame.debug_root_passes_names[ j ] );
-					}
-				}
-			}
+// ----------------------------------------------------------------------
+// Ends the open defragmentation pass: destroys old versions of moved resources, has VMA point
+// moved allocations to their new memory, and frees binned resources which we held back while
+// the pass was open.
+//
+// Only call this once copies for the pass have completed, and once no frame which may use old
+// versions of moved resources is in flight.
+static void backend_defragment_end_pass( le_backend_o* self, uint64_t frame_number, std::unordered_map<le_resource_handle, AllocatedResourceVk>& backend_resources ) {
+	ZoneScoped;
 
-			if ( !submission_data.pass_indices.empty() ) {
-				frame.queue_submission_data.push_back( submission_data );
+	auto&    d      = self->defragmentation;
+	VkDevice device = self->device->getVkDevice();
+
+	{
+		std::unordered_set<VkImage> images;
+
+		for ( auto const& a : d.retired_objects ) {
+			if ( a.info.isImage() ) {
+				images.insert( a.as.image );
+			}
+		}
+		for ( auto const& a : d.deferred_bins ) {
+			if ( a.info.isImage() ) {
+				images.insert( a.as.image );
 			}
 		}
 
-		assert( num_invocation_keys == frame.queue_submission_data.size() && "must have one submission data element per invocaton key" );
+		backend_render_object_cache_evict_images( self, images, device );
+	}
 
-		// -- Control that resources may only be used by the same queue family per-frame.
-		// we adjust for this by making the queue requirements a superset of all resource queue usages,
-		// and accumulating all queue usages per-resource first.
+	// Old versions must be gone before the pass ends - but not their memory, which VMA frees.
+	for ( auto const& a : d.retired_objects ) {
+		if ( a.info.isBuffer() ) {
+			vkDestroyBuffer( device, a.as.buffer, nullptr );
+		} else {
+			vkDestroyImage( device, a.as.image, nullptr );
+		}
+	}
 
-		if ( self->must_track_resources_queue_family_ownership ) {
-			// We only must do this if we have multiple queue families active
-			// as this can get pretty expensive if there are many resources flying around.
+	if ( d.cmd ) {
+		vkFreeCommandBuffers( device, d.command_pool, 1, &d.cmd );
+		d.cmd = nullptr;
+	}
 
-			// We do this to prevent a situation where a resource is claimed by two or more queue families
-			// Ideally, this
+	VkResult result = vmaEndDefragmentationPass( self->mAllocator, d.context, &d.pass );
 
-			// for each resource, accumulate all queue type flags that it gets used with over all submissions
+	// ----------| invariant: moved allocations now refer to their new memory
 
-			std::unordered_map<le_resource_handle, VkQueueFlags> resource_queue_flags;
+	for ( auto const& handle : d.moved_resources ) {
+		auto it = backend_resources.find( handle );
+		if ( it != backend_resources.end() ) {
+			vmaGetAllocationInfo( self->mAllocator, it->second.allocation, &it->second.allocationInfo );
+		}
+	}
 
-			for ( auto const& qs : frame.queue_submission_data ) {
-				for ( auto const& pi : qs.pass_indices ) {
-					for ( auto const& r : frame.passes[ pi ].resources ) {
-						resource_queue_flags[ r ] |= qs.queue_flags;
-					}
-				}
-			}
+	for ( auto const& a : d.deferred_bins ) {
+		if ( a.info.isBuffer() ) {
+			vmaDestroyBuffer( self->mAllocator, a.as.buffer, a.allocation );
+		} else {
+			vmaDestroyImage( self->mAllocator, a.as.image, a.allocation );
+		}
+	}
 
-			// now accumulate submission's queue flags based on the queue flags that all its resources have
+	d.num_moves += d.moved_resources.size();
+	d.bytes_moved += d.pass_bytes_moved;
 
-			for ( auto& qs : frame.queue_submission_data ) {
-				for ( auto const& pi : qs.pass_indices ) {
-					VkQueueFlags flags = qs.queue_flags;
-					for ( auto const& r : frame.passes[ pi ].resources ) {
-						flags |= resource_queue_flags.at( r );
-					}
-					qs.queue_flags = flags;
-				}
-			}
-		}
+	d.moved_resources.clear();
+	d.retired_objects.clear();
+	d.deferred_bins.clear();
+	d.pass         = {};
+	d.is_pass_open = false;
 
-		{
-			/// Assign queues to each submission:
-			///
-			/// we must have a unique mapping from queue_flags to queue family.
-			///
-			/// from this, we can then go through all queues of the queue family
-			/// and pick the queue with the least submissions.
-			///
-			std::vector<uint32_t> num_submissions_per_queue( num_invocation_keys, 0 );
-			for ( size_t i = 0; i != num_invocation_keys; i++ ) {
+	if ( result != VK_INCOMPLETE ) {
+		// Nothing left to move in this pool.
+		backend_defragment_end_pool( self, frame_number );
+	}
+}
 
-				auto const& queues = self->queues;
-				auto const& flags  = frame.queue_submission_data[ i ].queue_flags;
+// ----------------------------------------------------------------------
+// Records commands which copy contents from old versions of moved resources into their
+// new versions into a new command buffer for the open pass.
+static void backend_defragment_record_copies( le_backend_o* self, std::vector<std::pair<AllocatedResourceVk, AllocatedResourceVk>> const& copies ) {
 
-				int      matching_queue          = -1;
-				uint32_t lowest_submission_count = uint32_t( ~0 );
+	auto&    d      = self->defragmentation;
+	VkDevice device = self->device->getVkDevice();
 
-				uint32_t matching_queue_family_index = backend_find_queue_family_index_from_requirements( self, flags );
+	if ( d.command_pool == nullptr ) {
+		VkCommandPoolCreateInfo info = {
+		    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		    .pNext            = nullptr,                              // optional
+		    .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // optional
+		    .queueFamilyIndex = self->queues[ self->queue_default_graphics_idx ]->queue_family_index,
+		};
+		vkCreateCommandPool( device, &info, nullptr, &d.command_pool );
+	}
 
-				// try to find an exact match with the lowest submissions to it
-				for ( uint32_t j = 0; j != queues.size(); j++ ) {
-					if ( queues[ j ]->queue_family_index == matching_queue_family_index ) {
-						// all flags are contained in q.queue_flags
-						if ( num_submissions_per_queue[ j ] < lowest_submission_count ) {
-							matching_queue          = j;
-							lowest_submission_count = num_submissions_per_queue[ j ];
-						}
-					}
-				}
+	VkCommandBufferAllocateInfo allocate_info = {
+	    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+	    .pNext              = nullptr,
+	    .commandPool        = d.command_pool,
+	    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+	    .commandBufferCount = 1,
+	};
 
-				if ( matching_queue == -1 ) {
-					le::Log( LOGGER_LABEL ).error( "Could not find matching queue with capability: %s\n"
-					                               "This could be caused by one or more queue families claiming ownership of the same resource.",
-					                               to_string_vk_queue_flags( flags ).c_str() );
-				}
+	vkAllocateCommandBuffers( device, &allocate_info, &d.cmd );
 
-				assert( matching_queue != -1 && "must have found matching queue" );
+	VkCommandBufferBeginInfo begin_info = {
+	    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .pNext            = nullptr,                                     // optional
+	    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // optional
+	    .pInheritanceInfo = 0,                                           // optional
+	};
 
-				num_submissions_per_queue[ matching_queue ]++;
+	vkBeginCommandBuffer( d.cmd, &begin_info );
 
-				frame.queue_submission_data[ i ].queue_idx = matching_queue;
+	// Wait for any earlier access to old versions - these may be in any layout. New versions
+	// hold no content yet, which is why we may transition them from undefined layout.
+	{
+		VkMemoryBarrier2 memory_barrier{
+		    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		    .pNext         = nullptr,
+		    .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		    .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT,
+		    .dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		    .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		};
+
+		std::vector<VkImageMemoryBarrier2> image_barriers;
+
+		for ( auto const& [ src, dst ] : copies ) {
+
+			if ( !src.info.isImage() ) {
+				continue;
 			}
+
+			VkImageSubresourceRange range{
+			    .aspectMask     = get_aspect_flags_from_format( le::Format( src.info.imageInfo.format ) ),
+			    .baseMipLevel   = 0,
+			    .levelCount     = VK_REMAINING_MIP_LEVELS,
+			    .baseArrayLayer = 0,
+			    .layerCount     = VK_REMAINING_ARRAY_LAYERS,
+			};
+
+			image_barriers.push_back( {
+			    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			    .pNext               = nullptr,
+			    .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			    .srcAccessMask       = VK_ACCESS_2_MEMORY_WRITE_BIT,
+			    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+			    .oldLayout           = src.state.layout,
+			    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			    .image               = src.as.image,
+			    .subresourceRange    = range,
+			} );
+
+			image_barriers.push_back( {
+			    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			    .pNext               = nullptr,
+			    .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+			    .srcAccessMask       = VK_ACCESS_2_NONE,
+			    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			    .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+			    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			    .image               = dst.as.image,
+			    .subresourceRange    = range,
+			} );
 		}
 
-		// for each submission data, allocate pool from the correct queue
+		VkDependencyInfo dependency_info{
+		    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		    .pNext                    = nullptr,
+		    .dependencyFlags          = 0,
+		    .memoryBarrierCount       = 1,
+		    .pMemoryBarriers          = &memory_barrier,
+		    .bufferMemoryBarrierCount = 0,
+		    .pBufferMemoryBarriers    = 0,
+		    .imageMemoryBarrierCount  = uint32_t( image_barriers.size() ),
+		    .pImageMemoryBarriers     = image_barriers.data(),
+		};
 
-		for ( auto& data : frame.queue_submission_data ) {
-			// this submission has passes
-			// find available command pool which has the correct queue family.
+		vkCmdPipelineBarrier2( d.cmd, &dependency_info );
+	}
 
-			data.command_pool = backend_frame_data_produce_command_pool( frame, self->queues[ data.queue_idx ]->queue_family_index, self->device->getVkDevice() );
-			{
-				VkCommandBufferAllocateInfo info = {
-				    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-				    .pNext              = nullptr, // optional
-				    .commandPool        = data.command_pool->pool,
-				    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				    .commandBufferCount = uint32_t( data.pass_indices.size() ),
-				};
+	std::vector<VkImageCopy> regions;
 
-				data.command_pool->buffers.resize( info.commandBufferCount );
-				vkAllocateCommandBuffers( device, &info, data.command_pool->buffers.data() );
-			}
+	for ( auto const& [ src, dst ] : copies ) {
+
+		if ( src.info.isBuffer() ) {
+			VkBufferCopy region{
+			    .srcOffset = 0,
+			    .dstOffset = 0,
+			    .size      = src.info.bufferInfo.size,
+			};
+			vkCmdCopyBuffer( d.cmd, src.as.buffer, dst.as.buffer, 1, &region );
+			continue;
 		}
 
-		if ( LE_PRINT_DEBUG_MESSAGES ) {
-			logger.info( "Listing queue batches and their queue affinity:" );
-			int i = 0;
-			for ( auto const& qf : frame.queue_submission_data ) {
-				logger.info( "#%i, [%-50s]", i, to_string_vk_queue_flags( qf.queue_flags ).c_str() );
-				i++;
-			}
-			logger.info( "" );
+		// ----------| invariant: resource is an image - we copy all array layers, one region per mip level
+
+		VkImageCreateInfo const& info   = src.info.imageInfo;
+		VkImageAspectFlags       aspect = get_aspect_flags_from_format( le::Format( info.format ) );
+
+		regions.clear();
+
+		for ( uint32_t mip = 0; mip != info.mipLevels; mip++ ) {
+			VkImageSubresourceLayers layers{
+			    .aspectMask     = aspect,
+			    .mipLevel       = mip,
+			    .baseArrayLayer = 0,
+			    .layerCount     = info.arrayLayers,
+			};
+			regions.push_back( {
+			    .srcSubresource = layers,
+			    .srcOffset      = { 0, 0, 0 },
+			    .dstSubresource = layers,
+			    .dstOffset      = { 0, 0, 0 },
+			    .extent         = {
+			        .width  = std::max( 1u, info.extent.width >> mip ),
+			        .height = std::max( 1u, info.extent.height >> mip ),
+			        .depth  = std::max( 1u, info.extent.depth >> mip ),
+			    },
+			} );
 		}
+
+		vkCmdCopyImage( d.cmd,
+		                src.as.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		                dst.as.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                uint32_t( regions.size() ), regions.data() );
 	}
 
-	for ( auto const& submission : frame.queue_submission_data ) {
-		std::array<VkClearValue, 16> clearValues{};
-		// split graph into separate submissions by filtering by submission key
-		// accumulate pass types to find out the needed queue flags for the
-		//
-		// create vectors of pass indices per submission
-		// then assign each submission based on best-match to queues
-		// submit submissions to queues in-order.
+	vkEndCommandBuffer( d.cmd );
+}
 
-		// TODO: (parallel for)
-		// note that access to any caches when creating pipelines and layouts and descriptorsets must be
-		// mutex-controlled when processing happens concurrently.
-		uint32_t buffer_index = 0;
-		for ( auto const& passIndex : submission.pass_indices ) {
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME, in backend_allocate_resources, before the frame picks up its resources.
+//
+// Begins a defragmentation pass, unless a pass is open already. For each move which VMA suggests,
+// we create a new version of the resource in the move's destination memory, record commands to
+// copy the contents of the old version into the new version, and swap the new version into
+// backend resources. Resource handles stay the same: this frame, and all frames which follow
+// see the new version. Cached image views and framebuffers are keyed by image, which means that
+// they get re-created for new versions, and evicted for old versions once the pass ends.
+//
+// We only move what we can copy on the default graphics queue: we don't move resources which
+// are owned by another queue family, which are targets of uploads, or which hold content but
+// can't be used for transfers.
+static void backend_defragment_begin_pass( le_backend_o* self, BackendFrameData& frame, std::unordered_map<le_resource_handle, AllocatedResourceVk>& backend_resources ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-			auto& pass           = frame.passes[ passIndex ];
-			auto& cmd            = submission.command_pool->buffers[ buffer_index++ ]; // note that we post-increment, so that next iteration will get next command buffer.
-			auto& descriptorPool = frame.descriptorPools[ passIndex ];
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME, 16 ); // 0 means: don't defragment
 
-			// create frame buffer, based on swapchain and renderpass
+	auto& d = self->defragmentation;
 
-			{
-				VkCommandBufferBeginInfo info = {
-				    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-				    .pNext            = nullptr,                                     // optional
-				    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // optional
-				    .pInheritanceInfo = 0,                                           // optional
-				};
+	if ( *LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME == 0 || d.is_pass_open || d.pools.empty() ) {
+		return;
+	}
 
-				vkBeginCommandBuffer( cmd, &info );
-			}
+	if ( d.context == nullptr ) {
 
-			if ( SHOULD_INSERT_DEBUG_LABELS ) {
-				VkDebugUtilsLabelEXT labelInfo{
-				    .sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
-				    .pNext      = nullptr, // optional
-				    .pLabelName = pass.debugName,
-				    .color      = {},
-				};
+		if ( frame.frameNumber < d.next_sweep_frame ) {
+			return;
+		}
 
-				static constexpr auto LE_COLOUR_LIGHTBLUE    = hex_rgba_to_float_colour( 0x61BBEFFF );
-				static constexpr auto LE_COLOUR_GREENY_BLUE  = hex_rgba_to_float_colour( 0x4EC9B0FF );
-				static constexpr auto LE_COLOUR_BRICK_ORANGE = hex_rgba_to_float_colour( 0xCE4B0EFF );
-				static constexpr auto LE_COLOUR_PALE_PEACH   = hex_rgba_to_float_colour( 0xFFDBA3FF );
+		VmaDefragmentationInfo info{
+		    .flags                 = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+		    .pool                  = d.pools[ d.pool_index ].second,
+		    .maxBytesPerPass       = uint64_t( *LE_SETTING_BACKEND_DEFRAGMENT_MB_PER_FRAME ) << 20,
+		    .maxAllocationsPerPass = 0, // no limit
+		};
 
-				switch ( pass.type ) {
-				case le::QueueFlagBits::eCompute:
-					memcpy( labelInfo.color, LE_COLOUR_LIGHTBLUE.data(), sizeof( float ) * 4 );
-					break;
-				case le::QueueFlagBits::eGraphics:
-					memcpy( labelInfo.color, LE_COLOUR_GREENY_BLUE.data(), sizeof( float ) * 4 );
-					break;
-				case le::QueueFlagBits::eTransfer:
-					memcpy( labelInfo.color, LE_COLOUR_BRICK_ORANGE.data(), sizeof( float ) * 4 );
-					break;
-				default:
-					break;
-				}
+		if ( vmaBeginDefragmentation( self->mAllocator, &info, &d.context ) != VK_SUCCESS ) {
+			d.context = nullptr;
+			backend_defragment_end_pool( self, frame.frameNumber );
+			return;
+		}
+	}
 
-				vkCmdBeginDebugUtilsLabelEXT( cmd, &labelInfo );
-			}
+	// ----------| invariant: we are defragmenting pools[ pool_index ]
 
-			{
+	if ( vmaBeginDefragmentationPass( self->mAllocator, d.context, &d.pass ) != VK_INCOMPLETE ) {
+		// Nothing left to move in this pool.
+		d.pass = {};
+		backend_defragment_end_pool( self, frame.frameNumber );
+		return;
+	}
 
-				if ( LE_PRINT_DEBUG_MESSAGES ) {
-					logger.info( "*** Frame %d *** Queue %d *** Renderpass '%s'", frame.frameNumber, submission.queue_idx, pass.debugName );
-				}
+	d.is_pass_open        = true;
+	d.move_frame_number   = frame.frameNumber;
+	d.copy_complete_value = 0;
+	d.pass_bytes_moved    = 0;
 
-				// -- Issue sync barriers for all resources which require explicit sync.
-				//
-				// We must to this here, as the spec requires barriers to happen
-				// before renderpass begin.
-				//
-				for ( auto const& op : pass.explicit_sync_ops ) {
-					// fill in sync op
+	VkDevice device                = self->device->getVkDevice();
+	uint32_t graphics_family_index = self->queues[ self->queue_default_graphics_idx ]->queue_family_index;
 
-					if ( op.active == false ) {
-						continue;
-					}
+	std::unordered_map<VmaAllocation, le_resource_handle> resource_for_allocation;
 
-					// ---------| invariant: barrier is active.
+	for ( auto const& [ handle, r ] : backend_resources ) {
+		if ( r.info.isBuffer() || r.info.isImage() ) {
+			resource_for_allocation[ r.allocation ] = handle;
+		}
+	}
 
-					auto const& syncChain = frame.syncChainTable[ op.resource ];
+	std::unordered_set<le_resource_handle> upload_targets;
 
-					auto const& stateInitial = syncChain[ op.sync_chain_offset_initial ];
-					auto const& stateFinal   = syncChain[ op.sync_chain_offset_final ];
+	{
+		auto lock = std::scoped_lock( self->uploads_mutex );
+		backend_uploads_collect_targets( self, upload_targets );
+	}
 
-					if ( stateInitial != stateFinal ) {
-						// we must issue an image barrier
+	std::vector<std::pair<AllocatedResourceVk, AllocatedResourceVk>> copies; // old version, new version
 
-						if ( LE_PRINT_DEBUG_MESSAGES ) {
+	for ( uint32_t i = 0; i != d.pass.moveCount; i++ ) {
 
-							// --------| invariant: barrier is active.
+		VmaDefragmentationMove& move = d.pass.pMoves[ i ];
 
-							// print out sync chain for sampled image
-							logger.info( "\t Explicit Barrier for: %s (s: %d)", op.resource->data->debug_name, 1 << op.resource->data->num_samples );
-							logger.info( "\t % 3s : % 30s : % 30s : % 10s", "#", "visible_access", "write_stage", "layout" );
+		// Unless we decide that we can move this resource, we don't.
+		move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
 
-							auto const& syncChain = frame.syncChainTable.at( op.resource );
+		// Allocations which are not backend resources anymore are in some frame's bin.
+		auto found = resource_for_allocation.find( move.srcAllocation );
 
-							for ( size_t i = op.sync_chain_offset_initial; i <= op.sync_chain_offset_final; i++ ) {
-								auto const& s = syncChain[ i ];
-								logger.info( "\t % 3d : % 30s : % 30s : % 10s", i,
-								             to_string_vk_access_flags2( s.visible_access ).c_str(),
-								             to_string_vk_pipeline_stage_flags2( s.stage ).c_str(),
-								             to_str_vk_image_layout( s.layout ) );
-							}
-						}
+		if ( found == resource_for_allocation.end() || upload_targets.count( found->second ) ) {
+			continue;
+		}
 
-						auto dstImage = frame_data_get_image_from_le_resource_id( frame, static_cast<le_img_resource_handle>( op.resource ) );
+		le_resource_handle const& handle = found->second;
+		AllocatedResourceVk&      r      = backend_resources.at( handle );
 
-						VkImageMemoryBarrier2 imageLayoutTransfer{
-						    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-						    .pNext               = nullptr,
-						    .srcStageMask        = uint64_t( stateInitial.stage ) == 0 ? VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT : stateInitial.stage, // happens-before
-						    .srcAccessMask       = ( stateInitial.visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS ),                                  // make available memory update from operation (in case it was a write operation, otherwise don't wait)
-						    .dstStageMask        = stateFinal.stage,                                                                               // happens-after
-						    .dstAccessMask       = stateFinal.visible_access,                                                                      // make visible
-						    .oldLayout           = stateInitial.layout,
-						    .newLayout           = stateFinal.layout,
-						    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-						    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-						    .image               = dstImage,
-						    .subresourceRange    = LE_IMAGE_SUBRESOURCE_RANGE_ALL_MIPLEVELS,
-						};
+		if ( self->must_track_resources_queue_family_ownership ) {
+			bool is_owned_by_other_family = false;
+			for ( auto const& ownership : self->resource_queue_family_ownership ) {
+				auto owner = ownership.find( handle );
+				is_owned_by_other_family |= ( owner != ownership.end() && owner->second != graphics_family_index );
+			}
+			if ( is_owned_by_other_family ) {
+				continue;
+			}
+		}
 
-						VkDependencyInfo dependencyInfo = {
-						    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-						    .pNext                    = nullptr, // optional
-						    .dependencyFlags          = 0,       // optional
-						    .memoryBarrierCount       = 0,       // optional
-						    .pMemoryBarriers          = 0,
-						    .bufferMemoryBarrierCount = 0, // optional
-						    .pBufferMemoryBarriers    = 0,
-						    .imageMemoryBarrierCount  = 1, // optional
-						    .pImageMemoryBarriers     = &imageLayoutTransfer,
-						};
+		bool has_content = r.info.isBuffer() ? ( r.state.stage != 0 ) : ( r.state.layout != VK_IMAGE_LAYOUT_UNDEFINED );
+		bool can_copy =
+		    r.info.isBuffer()
+		        ? ( r.info.bufferInfo.usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT ) && ( r.info.bufferInfo.usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT )
+		        : ( r.info.imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT ) && ( r.info.imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT );
 
-						vkCmdPipelineBarrier2( cmd, &dependencyInfo );
-					}
-				} // end for all explicit sync ops.
-			}
+		if ( has_content && !can_copy ) {
+			continue;
+		}
 
-			// Draw passes must begin by opening a Renderpass context.
-			if ( pass.type == le::QueueFlagBits::eGraphics && pass.renderPass ) {
+		// -- Create new version of resource, and bind it to destination memory
 
-				for ( uint32_t i = 0; i != ( pass.numColorAttachments + pass.numDepthStencilAttachments ); ++i ) {
-					clearValues[ i ] = reinterpret_cast<VkClearValue&>( pass.attachments[ i ].clearValue );
-				}
-
-				VkRenderPassBeginInfo renderPassBeginInfo{
-				    .sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-				    .pNext       = nullptr, // optional
-				    .renderPass  = pass.renderPass,
-				    .framebuffer = pass.framebuffer,
-				    .renderArea  = {
-				         .offset = { 0, 0 },
-				         .extent = { pass.width, pass.height },
-                    },
-				    .clearValueCount = uint32_t( pass.numColorAttachments + pass.numDepthStencilAttachments ), // optional
-				    .pClearValues    = clearValues.data(),
-				};
+		AllocatedResourceVk moved = r;
+		VkResult            result;
 
-				vkCmdBeginRenderPass( cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+		if ( r.info.isBuffer() ) {
+			result = vkCreateBuffer( device, &r.info.bufferInfo, nullptr, &moved.as.buffer );
+			if ( result == VK_SUCCESS ) {
+				result = vmaBindBufferMemory( self->mAllocator, move.dstTmpAllocation, moved.as.buffer );
+				if ( result != VK_SUCCESS ) {
+					vkDestroyBuffer( device, moved.as.buffer, nullptr );
+				}
 			}
+		} else {
+			result = vkCreateImage( device, &r.info.imageInfo, nullptr, &moved.as.image );
+			if ( result == VK_SUCCESS ) {
+				result = vmaBindImageMemory( self->mAllocator, move.dstTmpAllocation, moved.as.image );
+				if ( result != VK_SUCCESS ) {
+					vkDestroyImage( device, moved.as.image, nullptr );
+				}
+			}
+		}
 
-			// -- Translate intermediary command stream data to api-native instructions
+		if ( result != VK_SUCCESS ) {
+			logger.warn( "Could not move resource '%s' for defragmentation: %s", handle->data->debug_name, to_str_vk_result( result ) );
+			continue;
+		}
 
-			void*    commandStream = nullptr;
-			size_t   dataSize      = 0;
-			size_t   numCommands   = 0;
-			size_t   commandIndex  = 0;
-			uint32_t subpassIndex  = 0;
+		// ----------| invariant: new version of resource is bound to destination memory
 
-			VkPipelineLayout currentPipelineLayout                          = nullptr;
-			VkDescriptorSet  descriptorSets[ LE_MAX_BOUND_DESCRIPTOR_SETS ] = {}; // currently bound descriptorSets (allocated from pool, therefore we must not worry about freeing, and may re-use freely)
+		moved.state = {};
 
-			// We store currently bound descriptors so that we only allocate new DescriptorSets
-			// if the descriptors really change. With dynamic descriptors, it is very likely
-			// that we don't need to allocate new descriptors, as the same descriptors are used
-			// for different accessors, only with different dynamic binding offsets.
-			//
-			//
-			std::array<DescriptorSetState, 8> previousSetState; // currently bound descriptorSetLayout+Data for each set
-			ArgumentState                     argumentState{};  //
-			RtxState                          rtx_state{};      // used to keep track of shader binding tables bound with rtx pipelines.
+		if ( has_content ) {
+			copies.emplace_back( r, moved );
+			moved.state.stage          = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			moved.state.visible_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			moved.state.layout         = r.info.isImage() ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		}
 
-			static le_buf_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
+		if ( self->must_track_resources_queue_family_ownership ) {
+			// New version gets written on the default graphics queue, which makes its family the owner.
+			self->resource_queue_family_ownership[ 0 ][ handle ] = graphics_family_index;
+			self->resource_queue_family_ownership[ 1 ][ handle ] = graphics_family_index;
+		}
 
-			if ( pass.encoder ) {
-				encoder_i.get_encoded_data( pass.encoder, &commandStream, &dataSize, &numCommands );
-			} else {
-				// This is legit behaviour for draw passes which are used only to clear attachments,
-				// in which case they don't need to include any draw commands.
-			}
+		d.retired_objects.push_back( r );
+		d.moved_resources.push_back( handle );
+		d.pass_bytes_moved += r.allocationInfo.size;
 
-			if ( commandStream != nullptr && numCommands > 0 ) {
+		r.as    = moved.as;
+		r.state = moved.state;
 
-				le_pipeline_manager_o* pipelineManager = encoder_i.get_pipeline_manager( pass.encoder );
-				assert( pipelineManager );
+		move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY;
+	}
 
-				std::vector<VkBuffer>         vertexInputBindings( maxVertexInputBindings, nullptr );
-				void*                         dataIt = commandStream;
-				le_pipeline_and_layout_info_t currentPipeline{};
+	if ( !copies.empty() ) {
+		backend_defragment_record_copies( self, copies );
+	}
 
-				while ( commandIndex != numCommands ) {
+	if ( d.moved_resources.empty() ) {
+		// We ignored all moves, which means that there is nothing to wait for.
+		backend_defragment_end_pass( self, frame.frameNumber, backend_resources );
+	}
+}
 
-					auto header = static_cast<le::CommandHeader*>( dataIt );
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME, at the start of backend_allocate_resources, before the frame
+// frees its binned resources.
+//
+// Ends the open defragmentation pass, once this is safe. Until then, we hold back binned resources
+// with allocations which take part in the pass, as VMA requires these to stay alive.
+static void backend_defragment_retire_pass( le_backend_o* self, BackendFrameData& frame ) {
+	ZoneScoped;
 
-					if ( /* DISABLES CODE */ ( false ) ) {
-						// Print the command stream to stdout.
-						debug_print_command( dataIt );
-					}
+	auto [ backend_resources, lock ] = self->get_allocated_resources();
 
-					switch ( header->info.type ) {
+	auto& d = self->defragmentation;
 
-					case le::CommandType::eBindGraphicsPipeline: {
-						auto* le_cmd = static_cast<le::CommandBindGraphicsPipeline*>( dataIt );
+	if ( !d.is_pass_open ) {
+		return;
+	}
 
-						if ( pass.type == le::QueueFlagBits::eGraphics ) {
-							// at this point, a valid renderpass must be bound
+	// Frames which may use old versions of moved resources were all acquired before the pass
+	// began - these have all been cleared once the frame which began the pass comes around again.
+	bool is_safe_to_end = d.copy_complete_value != 0 &&
+	                      frame.frameNumber >= d.move_frame_number + self->mFrames.size();
 
-							using namespace le_backend_vk;
-							// -- potentially compile and create pipeline here, based on current pass and subpass
-							auto requestedPipeline = le_pipeline_manager_i.produce_graphics_pipeline( pipelineManager, le_cmd->info.gpsoHandle, pass, subpassIndex );
+	if ( is_safe_to_end ) {
+		uint64_t value = 0;
+		vkGetSemaphoreCounterValue( self->device->getVkDevice(), self->queues[ self->queue_default_graphics_idx ]->semaphore, &value );
+		is_safe_to_end = value >= d.copy_complete_value;
+	}
 
-							if ( /* DISABLES CODE */ ( false ) ) {
+	if ( is_safe_to_end ) {
+		backend_defragment_end_pass( self, frame.frameNumber, backend_resources );
+		return;
+	}
 
-								// Print pipeline debug info when a new pipeline gets bound.
+	for ( auto it = frame.binnedResources.begin(); it != frame.binnedResources.end(); ) {
+		bool is_part_of_pass =
+		    std::any_of( d.pass.pMoves, d.pass.pMoves + d.pass.moveCount,
+		                 [ allocation = it->second.allocation ]( VmaDefragmentationMove const& m ) { return m.srcAllocation == allocation; } );
+		if ( is_part_of_pass ) {
+			d.deferred_bins.push_back( it->second );
+			it = frame.binnedResources.erase( it );
+		} else {
+			it++;
+		}
+	}
+}
 
-								logger.debug( "Requested pipeline: %x ", le_cmd->info.gpsoHandle );
-								debug_print_le_pipeline_layout_info( &requestedPipeline.layout_info );
-							}
+// ----------------------------------------------------------------------
+// Whether resource was moved by the open defragmentation pass. Its copy may not have been
+// submitted, or may still be in flight on the default graphics queue, until the pass ends.
+// Must be called with allocated resources locked.
+static bool backend_defragment_is_moved( le_backend_o const* self, le_resource_handle const& resource ) {
+	auto const& d = self->defragmentation;
+	return d.is_pass_open &&
+	       std::find( d.moved_resources.begin(), d.moved_resources.end(), resource ) != d.moved_resources.end();
+}
 
-							if ( !is_equal( currentPipeline, requestedPipeline ) ) {
-								// update current pipeline
-								currentPipeline = requestedPipeline;
-								// -- grab current pipeline layout from cache
-								currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
-								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+// ----------------------------------------------------------------------
+// Ends any open defragmentation pass, and destroys objects used for defragmentation - device must be idle.
+// Pools are not destroyed here, as these must outlive all resources allocated from them.
+static void backend_defragment_destroy( le_backend_o* self ) {
 
-								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
-								argumentState.binding_infos.clear();
+	auto [ backend_resources, lock ] = self->get_allocated_resources();
 
-								// -- reset dynamic offset count
-								argumentState.dynamicOffsetCount = 0;
+	auto& d = self->defragmentation;
 
-								// let's create descriptorData vector based on current bindings-
-								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+	if ( d.is_pass_open ) {
+		backend_defragment_end_pass( self, 0, backend_resources );
+	}
 
-									// look up set layout info via set layout key
-									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+	if ( d.context ) {
+		vmaEndDefragmentation( self->mAllocator, d.context, nullptr );
+		d.context = nullptr;
+	}
 
-									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+	if ( d.command_pool ) {
+		vkDestroyCommandPool( self->device->getVkDevice(), d.command_pool, nullptr );
+		d.command_pool = nullptr;
+	}
+}
 
-									auto& setData = argumentState.setData[ setId ];
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME
+// towards the start of backend_acquire_physical_resources
+//
+// Allocates all physical Vulkan memory resources (Images/Buffers) referenced to by the frame.
+//
+// - If a resource is already available to the backend, the previously allocated resource is
+//   copied into the frame.
+// - If a resource has not yet been seen, it is freshly allocated, then made available to
+//   the frame. It is also copied to the backend, so that the following frames may access it.
+// - If a resource is requested with properties differing from a resource with the same handle
+//   available from the backend, the previous resource is placed in the frame bin for recycling,
+//   and a new resource is allocated and copied to the frame. This resource in the backend is
+//   replaced by the new version, too. (Effectively, the frame has taken ownership of the old
+//   version and keeps it until it disposes of it).
+// - If there are resources in the recycling bin of a frame, these will get freed. Freeing
+//   happens as a first step, so that resources are only freed once the frame has "come around"
+//   and earlier frames which may have still used the old version of the resource have no claim
+//   on the old version of the resource anymore.
+//
+// We are currently not checking for "orphaned" resources (resources which are available in the
+// backend, but not used by the frame) - these could possibly be recycled, too.
 
-									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
-									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+static void backend_allocate_resources( le_backend_o* self, BackendFrameData& frame, le_renderpass_o** passes, size_t numRenderPasses ) {
+	ZoneScoped;
+	/*
+	- Frame is only ever allowed to reference frame-local resources.
+	- "Acquire" therefore means we create local copies of backend-wide resource handles.
+	*/
 
-									setData.clear();
-									setData.reserve( setLayoutInfo->binding_info.size() );
+	static auto logger = LeLog( LOGGER_LABEL );
 
-									for ( auto b : setLayoutInfo->binding_info ) {
+	static le_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
 
-										if ( b.count == 0 ) {
-											// If this is a placeholder binding, we continue early -
-											// this means that this binding will not be added to argumentState.
-											continue;
-										}
+	// -- first it is our holy duty to drop any binned resources which
+	// were condemned the last time this frame was active.
+	// It's possible that this was more than two frames ago,
+	// depending on how many swapchain images there are.
+	//
+	// Cached framebuffers which use any binned images must go first.
+	//
+	// Binned resources which take part in an open defragmentation pass are held back
+	// until the pass ends.
+	//
+	backend_defragment_retire_pass( self, frame );
+	backend_render_object_cache_evict_binned_images( self, frame, self->device->getVkDevice() );
+	frame_release_binned_resources( frame, self->mAllocator );
 
-										// ----------| invariant: b.count > 0
+	// Let the allocator know that a new frame has started, so that it may refresh its memory budget.
+	vmaSetCurrentFrameIndex( self->mAllocator, uint32_t( frame.frameNumber ) );
 
-										// add an entry for each array element with this binding to setData
-										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
-											DescriptorData descriptorData{};
+	// Iterate over all resource declarations in all passes so that we can collect all resources,
+	// and their usage information. Later, we will consolidate their usages so that resources can
+	// be re-used across passes.
+	//
+	// Note that we accumulate all resource infos first, and do consolidation
+	// in a separate step. That way, we can first make sure all flags are combined,
+	// before we make sure to we find a valid image format which matches all uses...
+	//
 
-											descriptorData.type          = b.type;
-											descriptorData.bindingNumber = uint32_t( b.binding );
-											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+	std::unordered_map<le_resource_handle, le_resource_info_t> active_resources;
 
-											if ( b.type == le::DescriptorType::eStorageBuffer ||
-											     b.type == le::DescriptorType::eUniformBuffer ||
-											     b.type == le::DescriptorType::eStorageBufferDynamic ||
-											     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+	collect_resource_infos_per_resource(
+	    passes, numRenderPasses,
+	    frame.declared_resources,
+	    active_resources );
 
-												descriptorData.bufferInfo.range = b.range;
-											}
+	if ( LE_PRINT_DEBUG_MESSAGES ) {
+		for ( auto const& r : active_resources ) {
+			logger.info( "resource [ %-30s ] : [ %-50s ]", r.first->data->debug_name,
+			             r.second.type == LeResourceType::eImage
+			                 ? to_string_vk_image_usage_flags( r.second.image.usage ).c_str()
+			                 : to_string_vk_buffer_usage_flags( r.second.buffer.usage ).c_str() );
+		}
+	}
 
-											setData.emplace_back( descriptorData );
-										}
+	// For each image resource which has versions of additional sample counts
+	// we create additional resource_ids (by patching in the sample count), and add matching
+	// resource info, so that multisample versions of image resources can be allocated dynamically.
+	insert_msaa_versions( active_resources );
 
-										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
-										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
-											assert( b.count != 0 ); // count cannot be 0
+	// Check if all resources declared in this frame are already available in backend.
+	// If a resource is not available yet, this resource must be allocated.
 
-											// store dynamic offset index for this element
-											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+	{
 
-											// increase dynamic offset count by number of elements in this binding
-											argumentState.dynamicOffsetCount += b.count;
-										}
+		auto [ backendResources, backend_resources_lock ] = self->get_allocated_resources();
 
-										// add this binding to list of current bindings
-										argumentState.binding_infos.push_back( b );
-									}
-								}
+		// Move long-lived resources, if their memory is fragmented - before this frame picks them up.
+		backend_defragment_begin_pass( self, frame, backendResources );
 
-								vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline.pipeline );
-							} else {
-								// Re-using previously bound pipeline. We may keep argumentState state as it is.
-							}
+		for ( auto const& ar : active_resources ) {
 
-							// -- Reset dynamic offsets in argumentState:
-							// we do this regardless of whether pipeline was already bound,
-							// because binding a pipeline should always reset parameters associated
-							// with the pipeline.
+			le_resource_handle const& resource     = ar.first;
+			le_resource_info_t const& resourceInfo = ar.second; ///< consolidated resource info for this resource over all passes
 
-							memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
+			// See if a resource with this id is already available to the frame
+			// This may be the case with a swapchain image resource for example,
+			// as it is allocated and managed from within the swapchain, not here.
+			//
+			if ( frame.availableResources.find( resource ) != frame.availableResources.end() ) {
+				// Resource is already available to and present in the frame.
+				continue;
+			}
 
-						} else {
-							// -- TODO: warn that graphics pipelines may only be bound within
-							// draw passes.
-						}
-					} break;
+			// ---------| invariant: resource with this id is not yet available to frame.
 
-					case le::CommandType::eBindComputePipeline: {
-						auto* le_cmd = static_cast<le::CommandBindComputePipeline*>( dataIt );
-						if ( pass.type == le::QueueFlagBits::eCompute ) {
-							// at this point, a valid renderpass must be bound
+			// first check if the resource is available to the frame,
+			// if that is not the chase, check if the resource is available to the frame.
 
-							using namespace le_backend_vk;
-							// -- potentially compile and create pipeline here, based on current pass and subpass
-							currentPipeline = le_pipeline_manager_i.produce_compute_pipeline( pipelineManager, le_cmd->info.cpsoHandle );
+			auto       resourceCreateInfo = ResourceCreateInfo::from_le_resource_info( resourceInfo );
+			auto       foundIt            = backendResources.find( resource );
+			const bool resourceIdNotFound = ( foundIt == backendResources.end() );
 
-							// -- grab current pipeline layout from cache
-							currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
+			if ( resourceIdNotFound ) {
 
-							{
-								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+				// Resource does not yet exist, we must allocate this resource and add it to the backend.
+				// Then add a reference to it to the current frame.
 
-								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
-								argumentState.binding_infos.clear();
+				if ( resourceCreateInfo.isImage() ) {
 
-								// -- reset dynamic offset count
-								argumentState.dynamicOffsetCount = 0;
+					patchImageUsageForMipLevels( &resourceCreateInfo );
 
-								// let's create descriptorData vector based on current bindings-
-								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+					if ( resourceCreateInfo.imageInfo.format == VK_FORMAT_UNDEFINED ) {
+						inferImageFormat( self, static_cast<le_img_resource_handle>( resource ), resourceInfo.image.usage, &resourceCreateInfo );
+					}
+				}
 
-									// look up set layout info via set layout key
-									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+				patchUsageForDefragmentation( &resourceCreateInfo );
 
-									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+				auto allocatedResource            = allocate_resource_vk( self->mAllocator, resourceCreateInfo, self->device->getVkDevice(), backend_get_resource_pool( self, resourceCreateInfo ) );
+				allocatedResource.last_used_frame = frame.frameNumber;
 
-									auto& setData = argumentState.setData[ setId ];
+				if ( LE_PRINT_DEBUG_MESSAGES || true ) {
+					printResourceInfo( resource, allocatedResource.info, "ALLOC" );
+				}
 
-									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
-									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+				// Add resource to map of available resources for this frame
+				frame.availableResources.insert_or_assign( resource, allocatedResource );
 
-									setData.clear();
-									setData.reserve( setLayoutInfo->binding_info.size() );
+				// Add this newly allocated resource to the backend so that the following frames
+				// may use it, too
+				backendResources.insert_or_assign( resource, allocatedResource );
 
-									for ( auto b : setLayoutInfo->binding_info ) {
+			} else {
 
-										// add an entry for each array element with this binding to setData
-										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
-											DescriptorData descriptorData{};
+				// If an existing resource has been found, we must check that it
+				// was allocated with the same properties as the resource we require
 
-											descriptorData.type          = b.type;
-											descriptorData.bindingNumber = uint32_t( b.binding );
-											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+				auto& foundResourceCreateInfo = foundIt->second.info;
 
-											descriptorData.bufferInfo.range = b.range;
+				// Note that we use the greater-than operator, which means
+				// that if our foundResource is equal to *or a superset of*
+				// resourceCreateInfo, we can re-use the found resource.
+				//
+				if ( foundResourceCreateInfo >= resourceCreateInfo ) {
 
-											setData.emplace_back( std::move( descriptorData ) );
-										}
+					// -- found info is either equal or a superset
 
-										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
-										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
-											assert( b.count != 0 ); // count cannot be 0
+					foundIt->second.last_used_frame = frame.frameNumber;
 
-											// store dynamic offset index for this element
-											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+					// Add a copy of this resource allocation to the current frame.
+					frame.availableResources.emplace( resource, foundIt->second );
 
-											// increase dynamic offset count by number of elements in this binding
-											argumentState.dynamicOffsetCount += b.count;
-										}
+				} else {
 
-										// add this binding to list of current bindings
-										argumentState.binding_infos.emplace_back( std::move( b ) );
-									}
-								}
+					// -- info does not match.
 
-								// -- reset dynamic offsets
-								memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
+					// We must re-allocate this resource, and add the old version of the resource to the recycling bin.
 
-								// we write directly into descriptorsetstate when we update descriptors.
-								// when we bind a pipeline, we update the descriptorsetstate based
-								// on what the pipeline requires.
-							}
-							vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, currentPipeline.pipeline );
+					// -- allocate a new resource
 
-						} else {
-							// -- TODO: warn that compute pipelines may only be bound within
-							// compute passes.
+					if ( resourceCreateInfo.isImage() ) {
+						patchImageUsageForMipLevels( &resourceCreateInfo );
+						if ( resourceCreateInfo.imageInfo.format == VK_FORMAT_UNDEFINED ) {
+							inferImageFormat( self, static_cast<le_img_resource_handle>( resource ), resourceInfo.image.usage, &resourceCreateInfo );
 						}
+					}
 
-					} break;
+					patchUsageForDefragmentation( &resourceCreateInfo );
 
-					case le::CommandType::eBindRtxPipeline: {
-						auto* le_cmd = static_cast<le::CommandBindRtxPipeline*>( dataIt );
-						if ( pass.type == le::QueueFlagBits::eCompute ) {
-							// at this point, a valid renderpass must be bound
+					auto allocatedResource            = allocate_resource_vk( self->mAllocator, resourceCreateInfo, nullptr, backend_get_resource_pool( self, resourceCreateInfo ) );
+					allocatedResource.last_used_frame = frame.frameNumber;
 
-							using namespace le_backend_vk;
+					if ( LE_PRINT_DEBUG_MESSAGES || true ) {
+						printResourceInfo( resource, allocatedResource.info, "RE-ALLOC" );
+					}
 
-							// -- fetch pipeline from pipeline cache, also fetch shader group data, so that
-							// we can verify that the current pipeline state matches the pipeline state which
-							// was used to create the pipeline. The pipeline state may change if pipeline gets recompiled.
+					// Add a copy of old resource to recycling bin for this frame, so that
+					// these resources get freed when this frame comes round again.
+					//
+					// We don't immediately delete the resources, as in-flight (preceding) frames
+					// might still be using them.
+					frame.binnedResources.try_emplace( resource, foundIt->second );
 
-							{
-								currentPipeline.pipeline                        = static_cast<VkPipeline>( le_cmd->info.pipeline_native_handle );
-								currentPipeline.layout_info.pipeline_layout_key = le_cmd->info.pipeline_layout_key;
+					// add the new version of the resource to frame available resources
+					frame.availableResources.insert_or_assign( resource, allocatedResource );
 
-								memcpy( currentPipeline.layout_info.set_layout_keys, le_cmd->info.descriptor_set_layout_keys, sizeof( currentPipeline.layout_info.set_layout_keys ) );
+					// Remove old version of resource from backend, and
+					// add new version of resource to backend
+					backendResources.insert_or_assign( resource, allocatedResource );
+				}
+			}
+		} // end for all used resources
+		if ( LE_PRINT_DEBUG_MESSAGES ) {
+			logger.info( "" );
+		}
 
-								currentPipeline.layout_info.set_layout_count = le_cmd->info.descriptor_set_layout_count;
-							}
+		backend_evict_images_over_budget( self, frame, backendResources );
+	}
 
-							// -- grab current pipeline layout from cache
-							currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
+	// -- Create rtx acceleration structure scratch buffer
+	{
+		// In case there are acceleration structures with the `build` flag set, we must allocate
+		// a scratch buffer which is large enough to hold the largest of the acceleration structures
+		// with the build flag set
 
-							{
-								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+		// TODO: this should also apply for any acceleration structures which have the `update` flag
+		// set, as updating requires a scratch buffer too.
 
-								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
-								argumentState.binding_infos.clear();
+		uint64_t scratchbuffer_max_size = 0;
 
-								// -- reset dynamic offset count
-								argumentState.dynamicOffsetCount = 0;
+		for ( auto const& ar : active_resources ) {
 
-								// let's create descriptorData vector based on current bindings-
-								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+			le_resource_handle const& resourceId   = ar.first;
+			le_resource_info_t const& resourceInfo = ar.second; ///< consolidated resource info for this resource over all passes
 
-									// look up set layout info via set layout key
-									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+			if ( resourceInfo.type == LeResourceType::eRtxBlas &&
+			     ( resourceInfo.blas.usage & LE_RTX_BLAS_BUILD_BIT ) ) {
+				auto const& frame_resource = frame.availableResources.at( resourceId );
+				scratchbuffer_max_size     = std::max<uint64_t>( scratchbuffer_max_size, frame_resource.info.blasInfo.scratch_buffer_size );
+			} else if ( resourceInfo.type == LeResourceType::eRtxTlas &&
+			            ( resourceInfo.tlas.usage & LE_RTX_TLAS_BUILD_BIT ) ) {
+				auto const& frame_resource = frame.availableResources.at( resourceId );
+				scratchbuffer_max_size     = std::max<uint64_t>( scratchbuffer_max_size, frame_resource.info.tlasInfo.scratch_buffer_size );
+			}
+		}
 
-									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+		if ( scratchbuffer_max_size != 0 ) {
+			// We must allocate a scratch buffer, which needs to be available for exactly one frame.
+			le_resource_info_t resourceInfo{};
+			resourceInfo.buffer.size              = uint32_t( scratchbuffer_max_size );
+			resourceInfo.buffer.usage             = le::BufferUsageFlags( le::BufferUsageFlagBits::eStorageBuffer | le::BufferUsageFlagBits::eShaderDeviceAddress );
+			resourceInfo.type                     = LeResourceType::eBuffer;
+			ResourceCreateInfo resourceCreateInfo = ResourceCreateInfo::from_le_resource_info( resourceInfo );
+			auto               resource_id        = LE_RTX_SCRATCH_BUFFER_HANDLE;
+			auto               allocated_resource = allocate_resource_vk( self->mAllocator, resourceCreateInfo, self->device->getVkDevice() );
+			frame.availableResources.insert_or_assign( resource_id, allocated_resource );
 
-									auto& setData = argumentState.setData[ setId ];
+			// We immediately bin the buffer resource, so that its lifetime is tied to the current frame.
+			frame.binnedResources.insert_or_assign( resource_id, allocated_resource );
+		}
+	}
 
-									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
-									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+	// If we locked backendResources with a mutex, this would be the right place to release it.
 
-									setData.clear();
-									setData.reserve( setLayoutInfo->binding_info.size() );
+	if ( LE_PRINT_DEBUG_MESSAGES ) {
+		logger.info( "Available Resources" );
+		logger.info( "%10s : %38s : %30s", "Type", "debugName", "Vk Handle" );
+		for ( auto const& r : frame.availableResources ) {
+			switch ( r.second.info.type ) {
+			case ( LeResourceType::eUndefined ):
+				logger.warn( "%10s : %38s : %30p",
+				             "undefined",
+				             r.first->data->debug_name, r.second );
+				break;
+			case ( LeResourceType::eBuffer ):
+				logger.info( "%10s : %38s : %30p",
+				             "Buffer",
+				             r.first->data->debug_name,
+				             r.second.as.buffer );
+				break;
+			case ( LeResourceType::eImage ):
+				logger.info( "%10s : %36s@%d : %30p",
+				             "Image",
+				             r.first->data->debug_name,
+				             1 << r.first->data->num_samples,
+				             r.second.as.buffer );
+				break;
+			case ( LeResourceType::eRtxBlas ):
+				logger.info( "%10s : %36s@%d",
+				             "RtxBLAS",
+				             r.first->data->debug_name );
+				break;
+			case ( LeResourceType::eRtxTlas ):
+				logger.info( "%10s : %36s@%d",
+				             "RtxTLAS",
+				             r.first->data->debug_name );
+				break;
+			}
+		}
+	}
 
-									for ( auto b : setLayoutInfo->binding_info ) {
+	if ( DEBUG_TAG_RESOURCES ) {
+		frame_resources_set_debug_names( self->instance, self->device->getVkDevice(), frame.availableResources );
+	}
+}
 
-										// add an entry for each array element with this binding to setData
-										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
-											DescriptorData descriptorData{};
+// ----------------------------------------------------------------------
+// Whether image is a swapchain image - swapchain images are owned by their swapchain,
+// which may destroy them whenever it gets re-created.
+static bool frame_is_swapchain_image( BackendFrameData const& frame, le_img_resource_handle const& img ) {
+	for ( auto const& [ key, swp ] : frame.frame_owned_swapchain_state ) {
+		if ( swp.swapchain_data.swapchain_image == img ) {
+			return true;
+		}
+	}
+	return false;
+}
 
-											descriptorData.type          = le::DescriptorType( b.type );
-											descriptorData.bindingNumber = uint32_t( b.binding );
-											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+// ----------------------------------------------------------------------
+// Executes on the DISPATCH FRAME
+//
+// Finds ImageViews, Samplers and Textures requested by individual passes.
+//
+// Samplers, and image views of backend-owned images come from the backend's caches,
+// so that they only get created the first time they are requested. Image views of
+// swapchain images are tied to the lifetime of the frame, and will be re-created.
+static void frame_allocate_transient_resources( le_backend_o* self, BackendFrameData& frame, VkDevice const& device, le_renderpass_o** passes, size_t numRenderPasses ) {
+	ZoneScoped;
+	using namespace le_renderer;
+	static auto       logger = LeLog( LOGGER_LABEL );
+	le::QueueFlagBits pass_type{};
 
-											if ( b.type == le::DescriptorType::eStorageBuffer ||
-											     b.type == le::DescriptorType::eUniformBuffer ||
-											     b.type == le::DescriptorType::eStorageBufferDynamic ||
-											     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+	// Only for compute passes: Create imageviews for all available
+	// resources which are of type image and which have usage
+	// sampled or storage.
+	//
+	for ( auto p = passes; p != passes + numRenderPasses; p++ ) {
 
-												descriptorData.bufferInfo.range = b.range;
-											}
+		// fetch pass type from this passes' queue sumbission info
+		renderpass_i.get_queue_sumbission_info( *p, &pass_type, nullptr );
 
-											setData.emplace_back( std::move( descriptorData ) );
-										}
+		if ( pass_type != le::QueueFlagBits::eCompute ) {
+			continue;
+		}
 
-										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
-										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
-											assert( b.count != 0 ); // count cannot be 0
-
-											// store dynamic offset index for this element
-											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+		const le_resource_handle* resources        = nullptr;
+		const le::AccessFlags2*   resources_access = nullptr;
+		size_t                    resource_count   = 0;
 
-											// increase dynamic offset count by number of elements in this binding
-											argumentState.dynamicOffsetCount += b.count;
-										}
+		renderpass_i.get_used_resources( *p, &resources, &resources_access, &resource_count );
 
-										// add this binding to list of current bindings
-										argumentState.binding_infos.emplace_back( std::move( b ) );
-									}
-								}
+		for ( size_t i = 0; i != resource_count; ++i ) {
+			auto const& r = static_cast<le_img_resource_handle>( resources[ i ] );
 
-								// -- reset dynamic offsets
-								memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
-							}
+			if ( r->data->type == LeResourceType::eImage ) {
 
-							vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, currentPipeline.pipeline );
-							// -- "bind" shader binding table state
+				// We create a default image view for this image and store it with the frame. If no explicit image view
+				// for a particular operation has been specified, this default image view is used.
 
-							{
-								rtx_state.sbt_buffer = le_cmd->info.sbt_buffer;
+				if ( frame.imageViews.find( r ) != frame.imageViews.end() ) {
+					continue;
+				}
 
-								VkBuffer vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.sbt_buffer );
+				// ---------| Invariant: ImageView for this image not yet stored with frame.
 
-								VkBufferDeviceAddressInfo info = {
-								    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-								    .pNext  = nullptr, // optional
-								    .buffer = vk_buffer,
-								};
-								uint64_t offset               = vkGetBufferDeviceAddress( device, &info );
-								rtx_state.ray_gen_sbt_offset  = offset + le_cmd->info.ray_gen_sbt_offset;
-								rtx_state.ray_gen_sbt_size    = le_cmd->info.ray_gen_sbt_size;
-								rtx_state.miss_sbt_offset     = offset + le_cmd->info.miss_sbt_offset;
-								rtx_state.miss_sbt_stride     = le_cmd->info.miss_sbt_stride;
-								rtx_state.miss_sbt_size       = le_cmd->info.miss_sbt_size;
-								rtx_state.hit_sbt_offset      = offset + le_cmd->info.hit_sbt_offset;
-								rtx_state.hit_sbt_stride      = le_cmd->info.hit_sbt_stride;
-								rtx_state.hit_sbt_size        = le_cmd->info.hit_sbt_size;
-								rtx_state.callable_sbt_offset = offset + le_cmd->info.callable_sbt_offset;
-								rtx_state.callable_sbt_stride = le_cmd->info.callable_sbt_stride;
-								rtx_state.callable_sbt_size   = le_cmd->info.callable_sbt_size;
-								rtx_state.is_set              = true;
-							}
+				// attempt to look up format via available resources - this is important for
+				// unspecified formats which get automatically inferred, in which case we want
+				// to set the format to whatever was inferred when the image was allocated and placed
+				// in available resources.
 
-						} else {
-							// -- TODO: warn that rtx pipelines may only be bound within
-							// compute passes.
-						}
+				AllocatedResourceVk const& vk_resource_info = frame_data_get_allocated_resource_from_resource_id( frame, r );
 
-					} break;
-					case le::CommandType::eTraceRays: {
-						auto* le_cmd = static_cast<le::CommandTraceRays*>( dataIt );
+				auto const& imageFormat = le::Format( vk_resource_info.info.imageInfo.format );
 
-						// -- update descriptorsets via template if tainted
-						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+				// If the format is still undefined at this point, we can only throw our hands up in the air...
+				//
+				if ( imageFormat == le::Format::eUndefined ) {
+					logger.warn( "Cannot create default view for image: '%s', as format is unspecified", r->data->debug_name );
+					continue;
+				}
 
-						if ( false == argumentsOk ) {
-							break;
-						}
+				VkImageSubresourceRange subresourceRange{
+				    .aspectMask     = get_aspect_flags_from_format( imageFormat ),
+				    .baseMipLevel   = 0,
+				    .levelCount     = VK_REMAINING_MIP_LEVELS, // we set VK_REMAINING_MIP_LEVELS which activates all mip levels remaining.
+				    .baseArrayLayer = 0,
+				    .layerCount     = 1,
+				};
 
-						// --------| invariant: arguments were updated successfully
+				VkImageViewCreateInfo imageViewCreateInfo{
+				    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				    .pNext            = nullptr, // optional
+				    .flags            = 0,       // optional
+				    .image            = vk_resource_info.as.image,
+				    .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+				    .format           = VkFormat( imageFormat ),
+				    .components       = {}, // default component mapping
+				    .subresourceRange = subresourceRange,
+				};
 
-						if ( argumentState.setCount > 0 ) {
+				VkImageView imageView = nullptr;
 
-							vkCmdBindDescriptorSets(
-							    cmd,
-							    VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
-							    currentPipelineLayout,
-							    0,
-							    argumentState.setCount,
-							    descriptorSets,
-							    argumentState.dynamicOffsetCount,
-							    argumentState.dynamicOffsets.data() );
-						}
+				if ( frame_is_swapchain_image( frame, r ) ) {
+					vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
 
-						assert( rtx_state.is_set && "sbt state must have been set before calling traceRays" );
+					AbstractPhysicalResource imgView{};
+					imgView.type        = AbstractPhysicalResource::Type::eImageView;
+					imgView.asImageView = imageView;
 
-						// VkBuffer sbt_vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, rtx_state.sbt_buffer );
+					frame.ownedResources.emplace_front( std::move( imgView ) );
+				} else {
+					imageView = backend_get_cached_image_view( self, frame, device, imageViewCreateInfo );
+				}
 
-						//					std::cout << "sbt buffer: " << std::hex << sbt_vk_buffer << std::endl
-						//					          << std::flush;
-						//					std::cout << "sbt buffer raygen offset: " << std::dec << rtx_state.ray_gen_sbt_offset << std::endl
-						//					          << std::flush;
+				// Store image view object with frame, indexed by image resource id,
+				// so that it can be found quickly if need be.
+				frame.imageViews[ r ] = imageView;
+			}
+		}
+	}
 
-						// buffer, offset, stride, size
-						VkStridedDeviceAddressRegionKHR sbt_ray_gen{ rtx_state.ray_gen_sbt_offset, rtx_state.ray_gen_sbt_size, rtx_state.ray_gen_sbt_size };
-						VkStridedDeviceAddressRegionKHR sbt_miss{ rtx_state.miss_sbt_offset, rtx_state.miss_sbt_stride, rtx_state.miss_sbt_size };
-						VkStridedDeviceAddressRegionKHR sbt_hit{ rtx_state.hit_sbt_offset, rtx_state.hit_sbt_stride, rtx_state.hit_sbt_size };
-						VkStridedDeviceAddressRegionKHR sbt_callable{ rtx_state.callable_sbt_offset, rtx_state.callable_sbt_stride, rtx_state.callable_sbt_size };
+	frame.textures_per_pass.resize( numRenderPasses );
 
-						vkCmdTraceRaysKHR(
-						    cmd,
-						    &sbt_ray_gen,
-						    &sbt_miss,
-						    &sbt_hit,
-						    &sbt_callable,
-						    le_cmd->info.width,
-						    le_cmd->info.height,
-						    le_cmd->info.depth //
-						);
+	// Create Samplers for all images which are used as Textures
+	//
+	for ( size_t pass_idx = 0; pass_idx != numRenderPasses; ++pass_idx ) {
 
-					} break;
-					case le::CommandType::eDispatch: {
-						auto* le_cmd = static_cast<le::CommandDispatch*>( dataIt );
+		auto& p = passes[ pass_idx ];
 
-						// -- update descriptorsets via template if tainted
-						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+		// Get all texture names for this pass
+		const le_texture_handle* textureIds     = nullptr;
+		size_t                   textureIdCount = 0;
+		renderpass_i.get_texture_ids( p, &textureIds, &textureIdCount );
 
-						if ( false == argumentsOk ) {
-							break;
-						}
+		const le_image_sampler_info_t* textureInfos     = nullptr;
+		size_t                         textureInfoCount = 0;
+		renderpass_i.get_texture_infos( p, &textureInfos, &textureInfoCount );
 
-						// --------| invariant: arguments were updated successfully
+		assert( textureIdCount == textureInfoCount ); // texture info and -id count must be identical, as there is a 1:1 relationship
 
-						if ( argumentState.setCount > 0 ) {
+		for ( size_t i = 0; i != textureIdCount; i++ ) {
 
-							vkCmdBindDescriptorSets( cmd,
-							                         VK_PIPELINE_BIND_POINT_COMPUTE,
-							                         currentPipelineLayout,
-							                         0,
-							                         argumentState.setCount,
-							                         descriptorSets,
-							                         argumentState.dynamicOffsetCount,
-							                         argumentState.dynamicOffsets.data() );
-						}
+			// -- find out if texture with this name has already been alloacted.
+			// -- if not, allocate
 
-						vkCmdDispatch( cmd, le_cmd->info.groupCountX, le_cmd->info.groupCountY, le_cmd->info.groupCountZ );
+			const le_texture_handle textureId = textureIds[ i ];
 
-					} break;
-					case le::CommandType::eBufferMemoryBarrier: {
-						auto*                  le_cmd = static_cast<le::CommandBufferMemoryBarrier*>( dataIt );
-						VkBufferMemoryBarrier2 bufferMemoryBarrier{
-						    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-						    .pNext               = nullptr,
-						    .srcStageMask        = static_cast<VkPipelineStageFlags2>( le_cmd->info.srcStageMask ), // happens-before
-						    .srcAccessMask       = 0,                                                               // FIXME: no memory is made available from src stage ?!
-						    .dstStageMask        = static_cast<VkPipelineStageFlags2>( le_cmd->info.dstStageMask ), // before continuing with dst stage
-						    .dstAccessMask       = static_cast<VkAccessFlagBits2>( le_cmd->info.dstAccessMask ),    // and making memory visible to dst stage
-						    .srcQueueFamilyIndex = 0,
-						    .dstQueueFamilyIndex = 0,
-						    .buffer              = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer ),
-						    .offset              = le_cmd->info.offset,
-						    .size                = le_cmd->info.range,
-						};
+			if ( frame.textures_per_pass[ pass_idx ].find( textureId ) == frame.textures_per_pass[ pass_idx ].end() ) {
+				// -- we need to allocate a new texture
 
-						VkDependencyInfo dependency_info{
-						    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-						    .pNext                    = nullptr, // optional
-						    .dependencyFlags          = 0,       // optional
-						    .memoryBarrierCount       = 0,       // optional
-						    .pMemoryBarriers          = 0,
-						    .bufferMemoryBarrierCount = 1, // optional
-						    .pBufferMemoryBarriers    = &bufferMemoryBarrier,
-						    .imageMemoryBarrierCount  = 0, // optional
-						    .pImageMemoryBarriers     = 0,
-						};
+				auto& texInfo = textureInfos[ i ];
 
-						vkCmdPipelineBarrier2( cmd, &dependency_info );
+				VkImageView imageView{};
+				{
+					// Set or create vkImageview
 
-					} break;
-					case le::CommandType::eDraw: {
-						auto* le_cmd = static_cast<le::CommandDraw*>( dataIt );
+					auto const& imageFormat = le::Format( frame_data_get_image_format_from_texture_info( frame, texInfo ) );
 
-						// -- update descriptorsets via template if tainted
-						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+					VkImageSubresourceRange subresourceRange{
+					    .aspectMask     = get_aspect_flags_from_format( imageFormat ),
+					    .baseMipLevel   = 0,
+					    .levelCount     = VK_REMAINING_MIP_LEVELS, // we set VK_REMAINING_MIP_LEVELS which activates all mip levels remaining.
+					    .baseArrayLayer = texInfo.imageView.base_array_layer,
+					    .layerCount     = VK_REMAINING_ARRAY_LAYERS, // Fixme: texInfo.imageView.layer_count must be 6 if imageView.type is cubemap
+					};
 
-						if ( false == argumentsOk ) {
-							break;
-						}
+					// TODO: fill in additional image view create info based on info from pass...
 
-						// --------| invariant: arguments were updated successfully
+					VkImageViewCreateInfo imageViewCreateInfo{
+					    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+					    .pNext            = nullptr, // optional
+					    .flags            = 0,       // optional
+					    .image            = frame_data_get_image_from_le_resource_id( frame, texInfo.imageView.imageId ),
+					    .viewType         = VkImageViewType( texInfo.imageView.image_view_type ),
+					    .format           = VkFormat( imageFormat ),
+					    .components       = {}, // default component mapping
+					    .subresourceRange = subresourceRange,
+					};
 
-						if ( argumentState.setCount > 0 ) {
+					if ( frame_is_swapchain_image( frame, texInfo.imageView.imageId ) ) {
+						vkCreateImageView( device, &imageViewCreateInfo, nullptr, &imageView );
 
-							vkCmdBindDescriptorSets(
-							    cmd,
-							    VK_PIPELINE_BIND_POINT_GRAPHICS,
-							    currentPipelineLayout,
-							    0,
-							    argumentState.setCount,
-							    descriptorSets,
-							    argumentState.dynamicOffsetCount,
-							    argumentState.dynamicOffsets.data() );
-						}
+						// Store vk object references with frame-owned resources, so that
+						// the vk objects can be destroyed when frame crosses the fence.
 
-						vkCmdDraw( cmd, le_cmd->info.vertexCount, le_cmd->info.instanceCount, le_cmd->info.firstVertex, le_cmd->info.firstInstance );
-					} break;
+						AbstractPhysicalResource res;
+						res.asImageView = imageView;
+						res.type        = AbstractPhysicalResource::Type::eImageView;
 
-					case le::CommandType::eDrawIndexed: {
-						auto* le_cmd = static_cast<le::CommandDrawIndexed*>( dataIt );
+						frame.ownedResources.emplace_front( std::move( res ) );
+					} else {
+						imageView = backend_get_cached_image_view( self, frame, device, imageViewCreateInfo );
+					}
+				}
 
-						// -- update descriptorsets via template if tainted
-						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+				VkSampler sampler{};
+				{
+					// Fetch VkSampler object from cache - it gets created on device if needed.
 
-						if ( false == argumentsOk ) {
-							break;
-						}
+					VkSamplerCreateInfo samplerCreateInfo{
+					    .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+					    .pNext                   = nullptr, // optional
+					    .flags                   = 0,       // optional
+					    .magFilter               = VkFilter( texInfo.sampler.magFilter ),
+					    .minFilter               = VkFilter( texInfo.sampler.minFilter ),
+					    .mipmapMode              = VkSamplerMipmapMode( texInfo.sampler.mipmapMode ),
+					    .addressModeU            = VkSamplerAddressMode( texInfo.sampler.addressModeU ),
+					    .addressModeV            = VkSamplerAddressMode( texInfo.sampler.addressModeV ),
+					    .addressModeW            = VkSamplerAddressMode( texInfo.sampler.addressModeW ),
+					    .mipLodBias              = texInfo.sampler.mipLodBias,
+					    .anisotropyEnable        = texInfo.sampler.anisotropyEnable,
+					    .maxAnisotropy           = texInfo.sampler.maxAnisotropy,
+					    .compareEnable           = texInfo.sampler.compareEnable,
+					    .compareOp               = VkCompareOp( texInfo.sampler.compareOp ),
+					    .minLod                  = texInfo.sampler.minLod,
+					    .maxLod                  = texInfo.sampler.maxLod,
+					    .borderColor             = VkBorderColor( texInfo.sampler.borderColor ),
+					    .unnormalizedCoordinates = texInfo.sampler.unnormalizedCoordinates,
+					};
 
-						// --------| invariant: arguments were updated successfully
+					sampler = backend_get_cached_sampler( self, frame, device, samplerCreateInfo );
+				}
 
-						if ( argumentState.setCount > 0 ) {
+				// -- Store Texture with frame so that decoder can find references
+				BackendFrameData::Texture tex;
+				tex.imageView = imageView;
+				tex.sampler   = sampler;
 
-							vkCmdBindDescriptorSets(
-							    cmd,
-							    VK_PIPELINE_BIND_POINT_GRAPHICS,
-							    currentPipelineLayout,
-							    0,
-							    argumentState.setCount,
-							    descriptorSets,
-							    argumentState.dynamicOffsetCount,
-							    argumentState.dynamicOffsets.data() );
-						}
+				frame.textures_per_pass[ pass_idx ][ textureId ] = tex;
+			} else {
+				// The frame already has an element with such a texture id.
+				assert( false && "texture must have been defined multiple times using identical id within the same renderpass." );
+			}
+		} // end for all textureIds
+	}     // end for all passes
+}
 
-						vkCmdDrawIndexed(
-						    cmd,
-						    le_cmd->info.indexCount,
-						    le_cmd->info.instanceCount,
-						    le_cmd->info.firstIndex,
-						    le_cmd->info.vertexOffset,
-						    le_cmd->info.firstInstance );
-					} break;
+// ----------------------------------------------------------------------
+// Must execute on the DISPATCH FRAME
+//
+// This is one of the most important methods of backend -
+// where we associate virtual with physical resources, allocate physical
+// resources as needed, and keep track of sync state of physical resources.
+//
+static bool backend_acquire_physical_resources( le_backend_o*             self,
+                                                size_t                    frameIndex,
+                                                le_renderpass_o**         passes,
+                                                size_t                    numRenderPasses,
+                                                le_resource_handle const* declared_resources,
+                                                le_resource_info_t const* declared_resources_infos,
+                                                size_t const&             declared_resources_count ) {
 
-					case le::CommandType::eDrawMeshTasks: {
-						auto* le_cmd = static_cast<le::CommandDrawMeshTasks*>( dataIt );
+	ZoneScoped;
+	auto& frame = self->mFrames[ frameIndex ];
 
-						// -- update descriptorsets via template if tainted
-						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+	static VkDevice device = self->device->getVkDevice();
 
-						if ( false == argumentsOk ) {
-							break;
-						}
+	// ----------| invariant: swapchain image acquisition was successful.
 
-						// --------| invariant: arguments were updated successfully
+#ifndef NDEBUG
+	// If we're running in debug, there is a chance that we might want to print out
+	// dot graph diagrams for queue sync - in which case we should fetch the global
+	// setting telling us whether to do so or not.
+	LE_SETTING( uint32_t, LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES, 0 );
+	// we fetch this variable to a local copy, and only at a single point, here,
+	// so that there is no risk that the value of the variable is changed on
+	// another thread while the dot graph is being generated
+	frame.must_create_queues_dot_graph = ( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES > 0 );
+	// then, we decrement the number of requested queue sync dot files, so that we only generate
+	// as many dot graph files as requested.
+	if ( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES > 0 ) {
+		--( *LE_SETTING_GENERATE_QUEUE_SYNC_DOT_FILES );
+	};
+#endif
 
-						if ( argumentState.setCount > 0 ) {
+	// Setup declared resources per frame - These are resources declared using resource infos
+	// which are explicitly declared by user via the rendergraph, but which may or may not be
+	// actually used in the frame.
+	//
 
-							vkCmdBindDescriptorSets( cmd,
-							                         VK_PIPELINE_BIND_POINT_GRAPHICS,
-							                         currentPipelineLayout,
-							                         0,
-							                         argumentState.setCount,
-							                         descriptorSets,
-							                         argumentState.dynamicOffsetCount,
-							                         argumentState.dynamicOffsets.data() );
-						}
+	for ( size_t i = 0; i != declared_resources_count; i++, declared_resources++, declared_resources_infos++ ) {
 
-						vkCmdDrawMeshTasksNV( cmd, le_cmd->info.taskCount, le_cmd->info.firstTask );
-					} break;
+		auto const& [ it, was_inserted ] = frame.declared_resources.emplace( *declared_resources, *declared_resources_infos );
+		if ( was_inserted == false ) {
+			// we must consolidate - find the superset for two resource infos
+			consolidate_resource_info_into( it->second, *declared_resources_infos ); // we must consolidate
+		}
+	}
 
-					case le::CommandType::eSetLineWidth: {
-						auto* le_cmd = static_cast<le::CommandSetLineWidth*>( dataIt );
-						vkCmdSetLineWidth( cmd, le_cmd->info.width );
-					} break;
+	{
 
-					case le::CommandType::eSetViewport: {
-						auto* le_cmd = static_cast<le::CommandSetViewport*>( dataIt );
-						// Since data for viewports *is stored inline*, we increment the typed pointer
-						// of le_cmd by 1 to reach the next slot in the stream, where the data is stored.
-						vkCmdSetViewport( cmd, le_cmd->info.firstViewport, le_cmd->info.viewportCount, reinterpret_cast<VkViewport*>( le_cmd + 1 ) );
-					} break;
+		// For all passes - set pass width/height to swapchain width/height if not explicitly set.
 
-					case le::CommandType::eSetScissor: {
-						auto* le_cmd = static_cast<le::CommandSetScissor*>( dataIt );
-						// Since data for scissors *is stored inline*, we increment the typed pointer
-						// of le_cmd by 1 to reach the next slot in the stream, where the data is stored.
-						vkCmdSetScissor( cmd, le_cmd->info.firstScissor, le_cmd->info.scissorCount, reinterpret_cast<VkRect2D*>( le_cmd + 1 ) );
-					} break;
+		// FIXME: this should be taking into account the rendergraph: any renderpasses which have no
+		// extents must take on the greater extent of any renderpasses they draw into.
+		// we must follow this from the back, so that if nothing is defined, the extent of the swapchain
+		// is applied to all renderpasses that don't have an explicitly defined extent.
 
-					case le::CommandType::eSetPushConstantData: {
-						if ( currentPipelineLayout ) {
+		static constexpr uint32_t DEFAULT_RENDERPASS_WIDTH  = 1024;
+		static constexpr uint32_t DEFAULT_RENDERPASS_HEIGHT = 1024;
 
-#ifndef NDEBUG
-							// Only do extra check when compiling for Debug:
-							//
-							// If current pipeline has not push constants enabled, then exit early, and print an error message.
-							if ( ( currentPipeline.layout_info.push_constants_enabled & 0x1 ) == false ) {
-								// We only want to print this message once.
-								if ( LE_DEBUG_TRUE_ONCE_IF_CHANGED( uint64_t( currentPipeline.pipeline ) ) ) {
-									LeLog( LOGGER_LABEL ).warn( "Push Constants used, but none available for this particular Pipeline: %p\n"
-									                            "\t>> Perhaps Push Constants have been optimised out in shader code as their members are not used by the shader(s)?",
-									                            currentPipeline.pipeline );
-								}
-								break; // early-out, prevents rest of command to be interpreted
-							}
-#endif
-							auto*              le_cmd               = static_cast<le::CommandSetPushConstantData*>( dataIt );
-							VkShaderStageFlags active_shader_stages = VkShaderStageFlags( currentPipeline.layout_info.active_vk_shader_stages );
-							vkCmdPushConstants( cmd, currentPipelineLayout, active_shader_stages, 0, uint32_t( le_cmd->info.num_bytes ), ( le_cmd + 1 ) ); // Note that we fetch inline data at (le_cmd + 1)
-						}
-						break;
-					}
+		patch_renderpass_extents(
+		    passes,
+		    numRenderPasses,
+		    DEFAULT_RENDERPASS_WIDTH,
+		    DEFAULT_RENDERPASS_HEIGHT );
+	}
 
-					case le::CommandType::eBindArgumentBuffer: {
-						// we need to store the data for the dynamic binding which was set as an argument to the ubo
-						// this alters our internal state
-						auto* le_cmd = static_cast<le::CommandBindArgumentBuffer*>( dataIt );
+	// Note: this consumes frame.declared_resources
+	backend_allocate_resources( self, frame, passes, numRenderPasses );
 
-						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+	{
+		// Initialise, then build sync chain table - each resource receives initial state
+		// from current entry in frame.availableResources resource map -
 
-						// find binding info with name referenced in command
+		frame.syncChainTable.clear();
+		for ( auto const& res : frame.availableResources ) {
+			frame.syncChainTable.insert( { res.first, { res.second.state } } );
+		}
 
-						auto b = argumentState.binding_infos.begin();
+		// -- build sync chain for each resource, create explicit sync barrier requests for resources
+		// which cannot be implicitly synced.
+		std::vector<le_img_resource_handle> tmp_swapchain_resources{};
+		tmp_swapchain_resources.reserve( frame.frame_owned_swapchain_state.size() );
 
-						for ( ; b != argumentState.binding_infos.end(); b++ ) {
-							if ( b->name_hash == argument_name_id ) {
-								break;
-							}
-						}
+		for ( auto& [ key, swp ] : frame.frame_owned_swapchain_state ) {
+			tmp_swapchain_resources.push_back( swp.swapchain_data.swapchain_image );
+		}
 
-						if ( b == argumentState.binding_infos.end() ) {
-							static uint64_t wrong_argument = argument_name_id;
-							[]( uint64_t argument ) {
-								static uint64_t argument_id_local = 0;
-								if ( argument_id_local == wrong_argument )
-									return;
-								logger.warn( "Process_frame: \x1b[38;5;209mInvalid argument name: '%s'\x1b[0m id: %x", le_get_argument_name_from_hash( argument ), argument );
-								argument_id_local = argument;
-							}( argument_name_id );
-							break;
-						}
+		frame_track_resource_state( frame, passes, numRenderPasses, tmp_swapchain_resources );
 
-						// ---------| invariant: we found an argument name that matches
+		// At this point we know the state for each resource at the end of the sync chain.
+		// this state will be the initial state for the resource
 
-						DescriptorData* descriptor_data =
-						    find_descriptor_with_binding_number_and_array_idx(
-						        argumentState.setData[ b->setIndex ], b->binding );
+		{
+			// Update final sync state for each pre-existing backend resource.
+			// fixme: this breaks the promise that no-one but allocate resources is writing to allocatedResources.
 
-						if ( descriptor_data ) {
+			static le_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
 
-							// Matching binding found
+			auto [ backend_resources, lock ] = self->get_allocated_resources();
 
-							DescriptorData::BufferInfo& buffer_info = descriptor_data->bufferInfo;
+			for ( auto const& tbl : frame.syncChainTable ) {
+				auto const& resId       = tbl.first;
+				auto const& resSyncList = tbl.second;
 
-							buffer_info.buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer_id );
-							buffer_info.range  = le_cmd->info.range;
+				assert( !resSyncList.empty() ); // sync list must have entries
 
-							if ( buffer_info.range == 0 ) {
+				// find element with matching resource ID in list of backend resources
 
-								// If no range was specified, we must default to VK_WHOLE_SIZE,
-								// as a range setting of 0 is not allowed in Vulkan.
+				auto res = backend_resources.find( resId );
+				if ( res != backend_resources.end() ) {
+					// Element found.
+					// Set sync state for this resource to value of last elment in the sync chain.
+					res->second.state = resSyncList.back();
+				} else {
 
-								buffer_info.range = VK_WHOLE_SIZE;
-							}
+					assert(
+					    std::find( tmp_swapchain_resources.begin(),
+					               tmp_swapchain_resources.end(), resId ) !=
+					        tmp_swapchain_resources.end() ||
+					    resId == LE_RTX_SCRATCH_BUFFER_HANDLE );
 
-							// If binding is in fact a dynamic binding, set the corresponding dynamic offset
-							// and set the buffer offset to 0.
-							if ( b->type == le::DescriptorType::eStorageBufferDynamic ||
-							     b->type == le::DescriptorType::eUniformBufferDynamic ) {
-								auto dynamicOffset                            = b->dynamic_offset_idx;
-								buffer_info.offset                            = 0;
-								argumentState.dynamicOffsets[ dynamicOffset ] = uint32_t( le_cmd->info.offset );
-							} else {
-								buffer_info.offset = le_cmd->info.offset;
-							}
-						}
+					// Frame local resource must be available as a backend resource,
+					// unless the resource is the swapchain image handle, which is owned and managed
+					// by the swapchain.
+					// Another exception is LE_RTX_SCRATCH_BUFFER, which is a transient resource,
+					// and as such does not end up in backendResources, but starts out directly
+					// as a binned resource.
+					// Otherwise something fishy is going on.
+				}
+			}
 
-					} break;
+			// If we use a mutex to protect backend-wide resources, we can release it now.
+		}
+	}
 
-					case le::CommandType::eSetArgumentTexture: {
-						auto*    le_cmd           = static_cast<le::CommandSetArgumentTexture*>( dataIt );
-						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+	// -- allocate any transient vk objects such as image samplers, and image views
+	frame_allocate_transient_resources( self, frame, device, passes, numRenderPasses );
 
-						// Find binding info with name referenced in command
-						auto b = argumentState.binding_infos.begin();
+	// create renderpasses - use sync chain to apply implicit syncing for image attachment resources
+	backend_create_renderpasses( self, frame, device );
 
-						for ( ; b != argumentState.binding_infos.end(); b++ ) {
-							if ( b->name_hash == argument_name_id ) {
-								break;
-							}
-						}
+	// -- make sure that there is a descriptorpool for every renderpass
+	backend_create_descriptor_pools( frame, device, numRenderPasses );
 
-						if ( b == argumentState.binding_infos.end() ) {
-							logger.warn( "Invalid texture argument name id: %x", argument_name_id );
-							break;
-						}
+	// patch and retain physical resources in bulk here, so that
+	// each pass may be processed independently
 
-						// ---------| invariant: we found an argument name that matches
+	backend_create_frame_buffers( self, frame, device );
 
-						auto arrayIndex = uint32_t( le_cmd->info.array_index );
+	return true;
+};
 
-						// Descriptors are stored as flat arrays; we cannot assume that binding number matches
-						// index of descriptor in set, because some types of uniforms may be arrays, and these
-						// arrays will be stored flat in the vector of per-set descriptors.
-						//
-						// Imagine these were bindings for a set: a b c0 c1 c2 c3 c4 d
-						// a(0), b(1), would have their own binding number, but c0(2), c1(2), c2(2), c3(2), c4(2)
-						// would share a single binding number, 2, until d(3), which would have binding number 3.
-						//
-						// To find the correct descriptor, we must therefore iterate over descriptors in-set
-						// until we find one that matches the correct array index.
-						//
+// ----------------------------------------------------------------------
+static le_allocator_o** backend_get_transient_allocators( le_backend_o* self, size_t frameIndex ) {
+	return self->mFrames[ frameIndex ].allocators.data();
+}
 
-						auto bindingData =
-						    find_descriptor_with_binding_number_and_array_idx(
-						        argumentState.setData[ b->setIndex ], b->binding, arrayIndex );
+// ----------------------------------------------------------------------
 
-						if ( bindingData ) {
-							// fetch texture information based on texture id from command
+static le_command_stream_t** backend_get_frame_command_streams( le_backend_o* self, size_t frameIndex, size_t num_command_streams ) {
 
-							auto foundTex = frame.textures_per_pass[ passIndex ].find( le_cmd->info.texture_id );
-							if ( foundTex == frame.textures_per_pass[ passIndex ].end() ) {
-								using namespace le_renderer;
-								logger.error( "Could not find requested texture: '%s', ignoring texture binding command",
-								              renderer_i.texture_handle_get_name( le_cmd->info.texture_id ) );
-								break;
-							}
+	// Check if the command stream pool has enough free command stream elements in the pool for us
+	// If no, we must add some additional command streams
 
-							// ----------| invariant: texture has been found
+	auto& cmd_streams = self->mFrames[ frameIndex ].command_streams;
 
-							bindingData->imageInfo.imageLayout = le::ImageLayout::eShaderReadOnlyOptimal;
-							bindingData->imageInfo.sampler     = foundTex->second.sampler;
-							bindingData->imageInfo.imageView   = foundTex->second.imageView;
-							bindingData->type                  = le::DescriptorType::eCombinedImageSampler;
-						} else {
-							logger.error( "Could not find binding at set: %d, binding: %d, array index: %d.", b->setIndex, b->binding, arrayIndex );
-							assert( bindingData && "could not find specified binding." );
-						}
-					} break;
+	// We should maybe find a nicer way to do this...
+	while ( cmd_streams.size() < num_command_streams ) {
+		cmd_streams.insert( cmd_streams.end(), new le_command_stream_t() );
+	}
 
-					case le::CommandType::eSetArgumentImage: {
-						auto*    le_cmd           = static_cast<le::CommandSetArgumentImage*>( dataIt );
-						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+	return cmd_streams.data();
+};
 
-						// Find binding info with name referenced in command
-						auto b = argumentState.binding_infos.begin();
+// ----------------------------------------------------------------------
+// Creates a mapped buffer which backs a block for a transient (linear) allocator.
+// Blocks come from the frame's allocation pool - unless they are too large to fit
+// into a pool block, in which case we allocate them from the same memory type.
+static bool backend_create_transient_block( le_backend_o* self, BackendFrameData& frame, uint64_t size, uint16_t index, VkBuffer* buffer, VmaAllocation* allocation, VmaAllocationInfo* allocationInfo ) {
 
-						for ( ; b != argumentState.binding_infos.end(); b++ ) {
-							if ( b->name_hash == argument_name_id ) {
-								break;
-							}
-						}
+	static const VkBufferUsageFlags LE_BUFFER_USAGE_FLAGS_SCRATCH = defaults_get_buffer_usage_scratch();
 
-						if ( b == argumentState.binding_infos.end() ) {
-							logger.warn( "Warning: Invalid image argument name id: %x", argument_name_id );
-							break;
-						}
+	VmaAllocationCreateInfo createInfo{};
+	createInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
-						// ---------| invariant: we found an argument name that matches
+	if ( size <= LE_FRAME_DATA_POOL_BLOCK_SIZE ) {
+		createInfo.pool = frame.allocationPool; // Since we're allocating from a pool all fields but .flags will be taken from the pool
+	} else {
+		createInfo.usage          = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		createInfo.memoryTypeBits = 1u << getMemoryIndexForGraphicsScratchBuffer( self->mAllocator, self->queueFamilyIndexGraphics );
+	}
 
-						auto bindingData =
-						    find_descriptor_with_binding_number_and_array_idx(
-						        argumentState.setData[ b->setIndex ], b->binding );
+	createInfo.pUserData = declare_resource_virtual_buffer( index );
 
-						// fetch texture information based on texture id from command
-						if ( bindingData ) {
+	VkBufferCreateInfo bufferCreateInfo{
+	    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+	    .pNext                 = nullptr, // optional
+	    .flags                 = 0,       // optional
+	    .size                  = size,
+	    .usage                 = LE_BUFFER_USAGE_FLAGS_SCRATCH,
+	    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+	    .queueFamilyIndexCount = 0,
+	    .pQueueFamilyIndices   = nullptr,
+	};
 
-							auto foundImgView = frame.imageViews.find( le_cmd->info.image_id );
-							if ( foundImgView == frame.imageViews.end() ) {
-								logger.error( "Could not find image view for image: '%s', ignoring image binding command.",
-								              le_cmd->info.image_id->data->debug_name );
-								break;
-							}
+	auto result = vmaCreateBuffer( self->mAllocator, &bufferCreateInfo, &createInfo, buffer, allocation, allocationInfo );
 
-							// ----------| invariant: image view has been found
+	return result == VK_SUCCESS;
+}
 
-							// FIXME: (sync) image layout at this point *must* be general, if we wanted to write to this image.
-							bindingData->imageInfo.imageLayout = le::ImageLayout::eGeneral;
-							bindingData->imageInfo.imageView   = foundImgView->second;
+// ----------------------------------------------------------------------
+// Called by a transient allocator - possibly from an encoder's worker thread - once
+// the allocator's current block is exhausted. We chain a new block to the frame,
+// which gets released when the frame is cleared.
+static bool backend_transient_allocator_grow( void* user_data, uint64_t min_capacity, VmaAllocationInfo* info ) {
 
-							bindingData->type       = le::DescriptorType::eStorageImage;
-							bindingData->arrayIndex = uint32_t( le_cmd->info.array_index );
-						} else {
-							logger.error( "Could not find binding at set: %d, binding: %d.", b->setIndex, b->binding );
-							assert( bindingData && "Could not find specified binding" );
-						}
+	static auto logger = LeLog( LOGGER_LABEL );
 
-					} break;
-					case le::CommandType::eSetArgumentTlas: {
-						auto*    le_cmd           = static_cast<le::CommandSetArgumentTlas*>( dataIt );
-						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+	auto  source = static_cast<backend_transient_block_source_t*>( user_data );
+	auto  self   = source->backend;
+	auto& frame  = self->mFrames[ source->frame_index ];
 
-						// Find binding info with name referenced in command
-						auto b = argumentState.binding_infos.begin();
+	auto lock = std::unique_lock( self->transient_blocks_mutex );
 
-						for ( ; b != argumentState.binding_infos.end(); b++ ) {
-							if ( b->name_hash == argument_name_id ) {
-								break;
-							}
-						}
+	size_t index = frame.allocatorBuffers.size();
 
-						if ( b == argumentState.binding_infos.end() ) {
-							logger.warn( "Invalid tlas argument name id: %x", argument_name_id );
-							break;
-						}
+	if ( index > UINT16_MAX ) {
+		// We can't encode an index this large in a resource handle.
+		logger.error( "Could not chain transient allocator block: too many blocks" );
+		return false;
+	}
 
-						// ---------| invariant: we found an argument name that matches
+	VkBuffer          buffer = nullptr;
+	VmaAllocation     allocation;
+	VmaAllocationInfo allocationInfo;
 
-						auto bindingData =
-						    find_descriptor_with_binding_number_and_array_idx(
-						        argumentState.setData[ b->setIndex ], b->binding );
+	if ( !backend_create_transient_block( self, frame, std::max<uint64_t>( min_capacity, LE_LINEAR_ALLOCATOR_SIZE ), uint16_t( index ), &buffer, &allocation, &allocationInfo ) ) {
+		logger.error( "Could not chain transient allocator block of %zu bytes", size_t( min_capacity ) );
+		return false;
+	}
 
-						if ( bindingData ) {
-							auto found_resource = frame.availableResources.find( le_cmd->info.tlas_id );
-							if ( found_resource == frame.availableResources.end() ) {
-								logger.error( "Could not find acceleration structure: '%s'. Ignoring top level acceleration structure binding command.", le_cmd->info.tlas_id->data->debug_name );
-								break;
-							}
+	frame.allocatorBuffers.emplace_back( buffer );
+	frame.allocations.emplace_back( allocation );
+	frame.allocationInfos.emplace_back( allocationInfo );
 
-							// ----------| invariant: acceleration structure has been found
+	*info = allocationInfo;
 
-							bindingData->accelerationStructureInfo.accelerationStructure = found_resource->second.as.tlas;
-							bindingData->type                                            = le::DescriptorType::eAccelerationStructureKhr;
-							bindingData->arrayIndex                                      = uint32_t( le_cmd->info.array_index );
-						} else {
-							logger.error( "Could not find binding at set: %d, binding: %d.", b->setIndex, b->binding );
-						}
+	return true;
+}
 
-					} break;
-					case le::CommandType::eBindIndexBuffer: {
-						auto* le_cmd = static_cast<le::CommandBindIndexBuffer*>( dataIt );
-						auto  buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer );
-						vkCmdBindIndexBuffer( cmd, buffer, le_cmd->info.offset, static_cast<VkIndexType>( le_cmd->info.indexType ) );
-					} break;
+// ----------------------------------------------------------------------
+// Releases all blocks which transient allocators chained while the frame was recorded -
+// only call this once all allocators for this frame have been reset.
+static void backend_frame_release_transient_blocks( le_backend_o* self, BackendFrameData& frame ) {
 
-					case le::CommandType::eBindVertexBuffers: {
-						auto* le_cmd = static_cast<le::CommandBindVertexBuffers*>( dataIt );
+	auto lock = std::unique_lock( self->transient_blocks_mutex );
 
-						uint32_t firstBinding = le_cmd->info.firstBinding;
-						uint32_t numBuffers   = le_cmd->info.bindingCount;
+	for ( size_t i = frame.allocators.size(); i < frame.allocatorBuffers.size(); i++ ) {
+		vmaDestroyBuffer( self->mAllocator, frame.allocatorBuffers[ i ], frame.allocations[ i ] );
+	}
 
-						assert( numBuffers && "must at least have one buffer to bind." );
+	frame.allocatorBuffers.resize( frame.allocators.size() );
+	frame.allocations.resize( frame.allocators.size() );
+	frame.allocationInfos.resize( frame.allocators.size() );
+}
 
-						// Bind vertex buffers by looking up le resources and matching them with their corresponding
-						// vk resources.
+// ----------------------------------------------------------------------
+// If any transient allocator needed more memory than its base block holds, we replace
+// its base block with one large enough to cover its peak use - so that allocations
+// stay within one block in the common case. Base blocks only ever grow.
+// Only call this once all allocators for this frame have been reset.
+static void backend_frame_resize_transient_base_blocks( le_backend_o* self, BackendFrameData& frame ) {
 
-						// First, we must relocate pointers into the command stream - we know that this command
-						// is immediately followed by its payload on the command stream.
+	using namespace le_backend_vk;
 
-						// The payload is two tightly packed arrays
-						// - le_buf_handle[bindingCount]
-						// - uint64_t[bindingCount]
+	static auto logger = LeLog( LOGGER_LABEL );
 
-						le_buf_resource_handle* p_buffers = ( le_buf_resource_handle* )( le_cmd + 1 );
-						uint64_t*               p_offsets = ( uint64_t* )( p_buffers + le_cmd->info.bindingCount );
+	for ( size_t i = 0; i != frame.allocators.size(); i++ ) {
 
-						le_buf_resource_handle le_buffer = *p_buffers;
+		le_allocator_stats_t stats{};
+		le_allocator_linear_i.get_stats( frame.allocators[ i ], &stats );
 
-						VkBuffer vk_buffer                  = frame_data_get_buffer_from_le_resource_id( frame, le_buffer );
-						vertexInputBindings[ firstBinding ] = vk_buffer;
+		if ( stats.bytes_high_water <= stats.base_capacity ) {
+			continue;
+		}
 
-						for ( uint32_t b = 1; b != numBuffers; ++b ) {
-							// We optimise for the likely case that the same resource is given a number of times:
-							// we cache the last lookup of a vk_resource, and if the same le_resource is requested again,
-							// we can use the cached value instead of having to do a lookup.
-							le_buf_resource_handle next_buffer = p_buffers[ b ];
-							if ( next_buffer != le_buffer ) {
-								le_buffer = next_buffer;
-								vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, le_buffer );
-							}
-							vertexInputBindings[ b + firstBinding ] = vk_buffer;
-						}
+		// ----------| invariant: base block is too small to hold peak use
 
-						vkCmdBindVertexBuffers( cmd, le_cmd->info.firstBinding, le_cmd->info.bindingCount, &vertexInputBindings[ firstBinding ], p_offsets );
-					} break;
+		// Round up to next multiple of the default block size, so that we don't resize too often.
+		uint64_t new_capacity = ( ( stats.bytes_high_water + LE_LINEAR_ALLOCATOR_SIZE - 1 ) / LE_LINEAR_ALLOCATOR_SIZE ) * LE_LINEAR_ALLOCATOR_SIZE;
 
-					case le::CommandType::eWriteToBuffer: {
+		VkBuffer          buffer = nullptr;
+		VmaAllocation     allocation;
+		VmaAllocationInfo allocationInfo;
 
-						// Enqueue copy buffer command
-						// TODO: we must sync this before the next read.
-						auto* le_cmd = static_cast<le::CommandWriteToBuffer*>( dataIt );
+		if ( !backend_create_transient_block( self, frame, new_capacity, uint16_t( i ), &buffer, &allocation, &allocationInfo ) ) {
+			logger.warn( "Could not grow transient allocator base block to %zu bytes", size_t( new_capacity ) );
+			continue;
+		}
 
-						VkBufferCopy region{
-						    .srcOffset = le_cmd->info.src_offset,
-						    .dstOffset = le_cmd->info.dst_offset,
-						    .size      = le_cmd->info.numBytes,
-						};
+		vmaDestroyBuffer( self->mAllocator, frame.allocatorBuffers[ i ], frame.allocations[ i ] );
 
-						auto srcBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.src_buffer_id );
-						auto dstBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.dst_buffer_id );
+		frame.allocatorBuffers[ i ] = buffer;
+		frame.allocations[ i ]      = allocation;
+		frame.allocationInfos[ i ]  = allocationInfo;
 
-						vkCmdCopyBuffer( cmd, srcBuffer, dstBuffer, 1, &region );
+		le_allocator_linear_i.set_base_block( frame.allocators[ i ], &allocationInfo );
 
-						break;
-					}
+		logger.info( "Frame %zu: Transient allocator %zu base block grown to %zu bytes (peak use: %zu bytes)",
+		             size_t( frame.frameNumber ), i, size_t( new_capacity ), size_t( stats.bytes_high_water ) );
+	}
+}
 
-					case le::CommandType::eWriteToImage: {
+// ----------------------------------------------------------------------
+static le_allocator_o** backend_create_transient_allocators( le_backend_o* self, size_t frameIndex, size_t numAllocators ) {
 
-						auto* le_cmd = static_cast<le::CommandWriteToImage*>( dataIt );
+	using namespace le_backend_vk;
 
-						auto srcBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.src_buffer_id );
-						auto dstImage  = frame_data_get_image_from_le_resource_id( frame, le_cmd->info.dst_image_id );
+	auto& frame = self->mFrames[ frameIndex ];
 
-						// We define a range that covers all miplevels. this is useful as it allows us to transform
-						// Image layouts in bulk, covering the full mip chain.
-						VkImageSubresourceRange rangeAllRemainingMiplevels{
-						    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-						    .baseMipLevel   = le_cmd->info.dst_miplevel,
-						    .levelCount     = VK_REMAINING_MIP_LEVELS, // we want all miplevels to be in transferDstOptimal.
+	// Additional blocks get appended after base blocks - we can only add base
+	// blocks while there are no additional blocks.
+	backend_frame_release_transient_blocks( self, frame );
+
+	if ( nullptr == frame.transientBlockSource ) {
+		frame.transientBlockSource = new backend_transient_block_source_t{ self, frameIndex };
+	}
+
+	for ( size_t i = frame.allocators.size(); i != numAllocators; ++i ) {
+
+		assert( numAllocators <= UINT16_MAX ); // must not have more allocators than we can store as index in a resource handle.
+
+		VkBuffer          buffer = nullptr;
+		VmaAllocation     allocation;
+		VmaAllocationInfo allocationInfo;
+
+		bool result = backend_create_transient_block( self, frame, LE_LINEAR_ALLOCATOR_SIZE, uint16_t( i ), &buffer, &allocation, &allocationInfo );
+
+		assert( result ); // todo: deal with failed allocation
+
+		// Create a new allocator - note that we assume an alignment of 256 bytes
+		le_allocator_o* allocator = le_allocator_linear_i.create( &allocationInfo, 256 );
+		le_allocator_linear_i.set_grow_callback( allocator, backend_transient_allocator_grow, frame.transientBlockSource );
+
+		frame.allocators.emplace_back( allocator );
+		frame.allocatorBuffers.emplace_back( std::move( buffer ) );
+		frame.allocations.emplace_back( std::move( allocation ) );
+		frame.allocationInfos.emplace_back( std::move( allocationInfo ) );
+	}
+
+	return frame.allocators.data();
+}
+
+// ----------------------------------------------------------------------
+
+static le_staging_allocator_o* backend_get_staging_allocator( le_backend_o* self, size_t frameIndex ) {
+	return self->mFrames[ frameIndex ].stagingAllocator;
+}
+
+void debug_print_le_pipeline_layout_info( le_pipeline_layout_info* info ) {
+	static auto logger = LeLog( LOGGER_LABEL );
+	logger.debug( "pipeline layout: %x", info->pipeline_layout_key );
+	for ( size_t i = 0; i != info->set_layout_count; i++ ) {
+		logger.debug( "set layout key : %x", info->set_layout_keys[ i ] );
+	}
+}
+
+static bool is_equal( le_pipeline_and_layout_info_t const& lhs, le_pipeline_and_layout_info_t const& rhs ) {
+	return lhs.pipeline == rhs.pipeline &&
+	       lhs.layout_info.set_layout_count == rhs.layout_info.set_layout_count &&
+	       0 == memcmp( lhs.layout_info.set_layout_keys, rhs.layout_info.set_layout_keys, sizeof( uint64_t ) * lhs.layout_info.set_layout_count ) &&
+	       lhs.layout_info.active_vk_shader_stages == rhs.layout_info.active_vk_shader_stages;
+}
+
+static bool updateArguments( const VkDevice&                    device,
+                             const VkDescriptorPool&            descriptorPool_,
+                             const ArgumentState&               argumentState,
+                             std::array<DescriptorSetState, 8>& previousSetData,
+                             VkDescriptorSet*                   descriptorSets ) {
+
+	static auto logger = LeLog( LOGGER_LABEL );
+	// -- allocate descriptors from descriptorpool based on set layout info
+
+	if ( argumentState.setCount == 0 ) {
+		return true;
+	}
+
+	// ----------| invariant: there are descriptorSets to allocate
+
+	bool argumentsOk = true;
+
+	auto get_argument_name = [ &argumentState ]( size_t set_id, uint32_t binding_number ) -> char const* {
+		for ( auto const& b : argumentState.binding_infos ) {
+			if ( b.binding == binding_number && b.setIndex == set_id ) {
+				return le_get_argument_name_from_hash( b.name_hash );
+			}
+		}
+
+		// ---------| invariant: not found
+
+		return nullptr;
+	};
+
+	// -- write data from descriptorSetData into freshly allocated DescriptorSets
+	for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+
+		// If argumentState contains invalid information (for example if an uniform has not been set yet)
+		// this will lead to SEGFAULT. You must ensure that argumentState contains valid information.
+		//
+		// The most common case for this bug is not providing any data for a uniform used in the shader,
+		// we check for this and skip any argumentStates which have invalid data...
+
+		static constexpr auto NULL_VK_BUFFER                     = VkBuffer( nullptr );
+		static constexpr auto NULL_VK_IMAGE_VIEW                 = VkImageView( nullptr );
+		static constexpr auto NULL_VK_ACCELERATION_STRUCTURE_KHR = VkAccelerationStructureKHR( nullptr );
+
+		// Whether to test that that arguments are set correctly
+		// - we don't do this check by default if we're running a release build
+#ifdef NDEBUG
+		LE_SETTING( bool, LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE, false );
+#else
+		LE_SETTING( bool, LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE, true );
+#endif
+
+		if ( *LE_SETTING_BACKEND_SHOULD_CHECK_ARGUMENT_STATE ) [[unlikely]] {
+			for ( auto& a : argumentState.setData[ setId ] ) {
+
+				switch ( a.type ) {
+				case le::DescriptorType::eStorageBufferDynamic: //
+				case le::DescriptorType::eUniformBuffer:        //
+				case le::DescriptorType::eUniformBufferDynamic: //
+				case le::DescriptorType::eStorageBuffer:        // fall-through
+					if ( NULL_VK_BUFFER == a.bufferInfo.buffer ) {
+						// if buffer must have valid buffer bound
+						logger.error( "Buffer argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
+						              get_argument_name( setId, a.bindingNumber ),
+						              setId,
+						              a.bindingNumber,
+						              a.arrayIndex );
+						argumentsOk = false;
+					}
+					break;
+				case le::DescriptorType::eCombinedImageSampler:
+				case le::DescriptorType::eSampledImage:
+				case le::DescriptorType::eStorageImage:
+					argumentsOk &= ( NULL_VK_IMAGE_VIEW != a.imageInfo.imageView ); // if sampler, must have valid image view
+					if ( NULL_VK_IMAGE_VIEW == a.imageInfo.imageView ) {
+						// if image - must have valid imageview bound
+						logger.error( "Image argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
+						              get_argument_name( setId, a.bindingNumber ),
+						              setId,
+						              a.bindingNumber,
+						              a.arrayIndex );
+						argumentsOk = false;
+					}
+					break;
+				case le::DescriptorType::eAccelerationStructureKhr:
+					argumentsOk &= ( NULL_VK_ACCELERATION_STRUCTURE_KHR != a.accelerationStructureInfo.accelerationStructure );
+					if ( NULL_VK_ACCELERATION_STRUCTURE_KHR == a.accelerationStructureInfo.accelerationStructure ) {
+						// if image - must have valid acceleration structure bound
+						logger.error( "Acceleration Structure argument '%s', at set=%d, binding=%d, array_index=%d not set, not valid, or missing.",
+						              get_argument_name( setId, a.bindingNumber ),
+						              setId,
+						              a.bindingNumber,
+						              a.arrayIndex );
+						argumentsOk = false;
+					}
+
+					break;
+				default:
+					argumentsOk &= false;
+					// TODO: check arguments for other types of descriptors
+					assert( false && "unhandled descriptor type" );
+					break;
+				}
+
+				if ( false == argumentsOk ) {
+					assert( false && "Argument state did not fit template" );
+					break;
+				}
+			}
+		}
+
+		if ( argumentsOk ) {
+
+			// We test the current argument state of descriptors against the currently bound
+			// descriptors - we only (re-)allocate descriptorsets for when we detect a change
+			// within one of these sets.
+
+			// FIXME: there is a subtle bug here - if setData is the same between arguments we
+			// should theoretically be able to recycle the descriptorset - but beware! If the
+			// decriptorset requires a different layout, then you must re-allocate. This can
+			// happen when descriptors differ in usage flags, for example (vertex|fragment vs. vertex)
+			// -- in such a case the parameters are the same between two descriptorSets,
+			// but the descriptorSetLayouts will be different, and you must allcate the matching
+			// descriptorSet.
+
+			if ( previousSetData[ setId ].setData.empty() ||
+			     previousSetData[ setId ].setData != argumentState.setData[ setId ] ||
+			     previousSetData[ setId ].setLayout != argumentState.layouts[ setId ] ) {
+
+				VkDescriptorSetAllocateInfo allocateInfo{
+				    .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				    .pNext              = nullptr, // optional
+				    .descriptorPool     = descriptorPool_,
+				    .descriptorSetCount = 1,
+				    .pSetLayouts        = &argumentState.layouts[ setId ],
+				};
+
+				// -- allocate descriptorSets based on current layout
+				// and place them in the correct position
+
+				auto result = vkAllocateDescriptorSets( device, &allocateInfo, &descriptorSets[ setId ] );
+
+				assert( result == VK_SUCCESS && "failed to allocate descriptor set" );
+
+				if ( /* DISABLES CODE */ ( false ) ) {
+					// I wish that this would work - but it appears that accelerator decriptors cannot be updated using templates.
+					vkUpdateDescriptorSetWithTemplate( device, descriptorSets[ setId ], argumentState.updateTemplates[ setId ], argumentState.setData[ setId ].data() );
+
+				} else {
+
+					std::vector<VkWriteDescriptorSet> write_descriptor_sets;
+
+					// We deliberately allocate write descriptor set acceleration structure objects on the heap,
+					// so that the pointer to the object will not change if and when the vector grows.
+					//
+					// This means that we can hand out copies of pointers from this vector without fear from
+					// within the current scope, but also that we must clean up the contents of the vector
+					// manually before leaving the current scope or else we will leak these objects.
+					std::vector<VkWriteDescriptorSetAccelerationStructureKHR*> write_acceleration_structures;
+
+					write_descriptor_sets.reserve( argumentState.setData[ setId ].size() );
+
+					for ( auto& a : argumentState.setData[ setId ] ) {
+						VkWriteDescriptorSet w{
+						    .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						    .pNext            = nullptr, // optional
+						    .dstSet           = descriptorSets[ setId ],
+						    .dstBinding       = a.bindingNumber,
+						    .dstArrayElement  = a.arrayIndex,
+						    .descriptorCount  = 1,
+						    .descriptorType   = VkDescriptorType( a.type ),
+						    .pImageInfo       = 0,
+						    .pBufferInfo      = 0,
+						    .pTexelBufferView = 0,
+						};
+						;
+
+						switch ( a.type ) {
+						case le::DescriptorType::eSampler:
+						case le::DescriptorType::eCombinedImageSampler:
+						case le::DescriptorType::eSampledImage:
+						case le::DescriptorType::eStorageImage:
+						case le::DescriptorType::eInputAttachment:
+							w.pImageInfo = reinterpret_cast<VkDescriptorImageInfo const*>( &a.imageInfo );
+							break;
+						case le::DescriptorType::eUniformTexelBuffer:
+						case le::DescriptorType::eStorageTexelBuffer:
+							w.pTexelBufferView = reinterpret_cast<VkBufferView const*>( &a.texelBufferInfo );
+							break;
+						case le::DescriptorType::eUniformBuffer:
+						case le::DescriptorType::eStorageBuffer:
+						case le::DescriptorType::eUniformBufferDynamic:
+						case le::DescriptorType::eStorageBufferDynamic:
+							w.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo const*>( &a.bufferInfo );
+							break;
+						case le::DescriptorType::eInlineUniformBlockExt:
+							assert( false && "inline uniform blocks are not yet supported" );
+							break;
+						case le::DescriptorType::eAccelerationStructureNv:
+							assert( false && "NV acceleration structures are not supported anymore. Use KHR acceleration structures." );
+							break;
+						case le::DescriptorType::eAccelerationStructureKhr: {
+							// FIXME: use an arena for that - we don't want to allocate on the free store
+							auto wd = new VkWriteDescriptorSetAccelerationStructureKHR{
+							    .sType                      = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
+							    .pNext                      = nullptr, // optional
+							    .accelerationStructureCount = 1,
+							    .pAccelerationStructures    = &reinterpret_cast<VkAccelerationStructureKHR const&>( a.accelerationStructureInfo.accelerationStructure ),
+							};
+							w.pNext = wd;
+							write_acceleration_structures.push_back( wd );
+
+						} break;
+						default:
+							assert( false && "Unhandled descriptor Type" );
+						}
+
+						write_descriptor_sets.emplace_back( w );
+					}
+					vkUpdateDescriptorSets( device, uint32_t( write_descriptor_sets.size() ), write_descriptor_sets.data(), 0, nullptr );
+
+					// We must manually delete any WriteDescriptorSetAccelerationStructureKHR objects
+					for ( auto& w : write_acceleration_structures ) {
+						delete ( w );
+					}
+				}
+				previousSetData[ setId ].setData   = argumentState.setData[ setId ];
+				previousSetData[ setId ].setLayout = argumentState.layouts[ setId ];
+			}
+
+		} else {
+			return false;
+		}
+	}
+
+	return argumentsOk;
+};
+
+// ----------------------------------------------------------------------
+// With extended dynamic state, some pipeline state is no longer baked into vk pipelines.
+// We set this state explicitly whenever a graphics pipeline gets bound, so that the state
+// given via the pipeline builder acts as default, which encoder commands may then override.
+static void backend_cmd_set_pipeline_dynamic_state( VkCommandBuffer cmd, le_graphics_pipeline_builder_data const* data, uint32_t extended_dynamic_state_level, uint32_t num_color_attachments ) {
+
+	if ( extended_dynamic_state_level >= 1 ) {
+		auto const& ds = data->depthStencilState;
+		vkCmdSetCullMode( cmd, data->rasterizationInfo.cullMode );
+		vkCmdSetFrontFace( cmd, data->rasterizationInfo.frontFace );
+		vkCmdSetPrimitiveTopology( cmd, data->inputAssemblyState.topology );
+		vkCmdSetDepthTestEnable( cmd, ds.depthTestEnable );
+		vkCmdSetDepthWriteEnable( cmd, ds.depthWriteEnable );
+		vkCmdSetDepthCompareOp( cmd, ds.depthCompareOp );
+		vkCmdSetDepthBoundsTestEnable( cmd, ds.depthBoundsTestEnable );
+		vkCmdSetStencilTestEnable( cmd, ds.stencilTestEnable );
+		vkCmdSetStencilOp( cmd, VK_STENCIL_FACE_FRONT_BIT, ds.front.failOp, ds.front.passOp, ds.front.depthFailOp, ds.front.compareOp );
+		vkCmdSetStencilOp( cmd, VK_STENCIL_FACE_BACK_BIT, ds.back.failOp, ds.back.passOp, ds.back.depthFailOp, ds.back.compareOp );
+	}
+
+	if ( extended_dynamic_state_level >= 2 ) {
+		vkCmdSetDepthBiasEnable( cmd, data->rasterizationInfo.depthBiasEnable );
+		vkCmdSetPrimitiveRestartEnable( cmd, data->inputAssemblyState.primitiveRestartEnable );
+		vkCmdSetRasterizerDiscardEnable( cmd, data->rasterizationInfo.rasterizerDiscardEnable );
+	}
+
+	if ( extended_dynamic_state_level >= 3 ) {
+		vkCmdSetPolygonModeEXT( cmd, data->rasterizationInfo.polygonMode );
+		vkCmdSetBlendConstants( cmd, data->blend_factor_constants );
+
+		if ( num_color_attachments > 0 ) {
+			VkBool32                blend_enable[ LE_MAX_COLOR_ATTACHMENTS ];
+			VkColorBlendEquationEXT blend_equations[ LE_MAX_COLOR_ATTACHMENTS ];
+			VkColorComponentFlags   write_masks[ LE_MAX_COLOR_ATTACHMENTS ];
+
+			for ( uint32_t i = 0; i != num_color_attachments; i++ ) {
+				auto const& b        = data->blendAttachmentStates[ i ];
+				blend_enable[ i ]    = b.blendEnable;
+				write_masks[ i ]     = b.colorWriteMask;
+				blend_equations[ i ] = {
+				    .srcColorBlendFactor = b.srcColorBlendFactor,
+				    .dstColorBlendFactor = b.dstColorBlendFactor,
+				    .colorBlendOp        = b.colorBlendOp,
+				    .srcAlphaBlendFactor = b.srcAlphaBlendFactor,
+				    .dstAlphaBlendFactor = b.dstAlphaBlendFactor,
+				    .alphaBlendOp        = b.alphaBlendOp,
+				};
+			}
+
+			vkCmdSetColorBlendEnableEXT( cmd, 0, num_color_attachments, blend_enable );
+			vkCmdSetColorBlendEquationEXT( cmd, 0, num_color_attachments, blend_equations );
+			vkCmdSetColorWriteMaskEXT( cmd, 0, num_color_attachments, write_masks );
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+
+static void debug_print_command( void*& cmd ) {
+	static auto        logger = LeLog( LOGGER_LABEL );
+	std::ostringstream os;
+	os << "cmd: ";
+
+	auto cmd_header = static_cast<le::CommandHeader*>( cmd );
+
+	// clang-format off
+			switch (cmd_header->info.type){
+                case (le::CommandType::eDrawIndexed): os << "eDrawIndexed"; break;
+                case (le::CommandType::eDraw): os << "eDraw"; break;
+                case (le::CommandType::eDispatch): os << "eDispatch"; break;
+                case (le::CommandType::eBufferMemoryBarrier): os << "eBufferMemoryBarrier"; break;
+                case (le::CommandType::eSetLineWidth): os << "eSetLineWidth"; break;
+                case (le::CommandType::eSetViewport): os << "eSetViewport"; break;
+                case (le::CommandType::eSetScissor): os << "eSetScissor"; break;
+                case (le::CommandType::eSetPushConstantData): os << "eSetPushConstantData"; break;
+                case (le::CommandType::eBindArgumentBuffer): os << "eBindArgumentBuffer"; break;
+                case (le::CommandType::eSetArgumentTexture): os << "eSetArgumentTexture"; break;
+                case (le::CommandType::eSetArgumentImage): os << "eSetArgumentImage"; break;
+                case (le::CommandType::eBindIndexBuffer): os << "eBindIndexBuffer"; break;
+                case (le::CommandType::eBindVertexBuffers): os << "eBindVertexBuffers"; break;
+                case (le::CommandType::eBindGraphicsPipeline): os << "eBindGraphicsPipeline"; break;
+                case (le::CommandType::eBindComputePipeline): os << "eBindComputePipeline"; break;
+                case (le::CommandType::eWriteToBuffer): os << "eWriteToBuffer"; break;
+                case (le::CommandType::eBindRtxPipeline): os << "eBindRtxPipeline" ; break;
+                case (le::CommandType::eBuildRtxTlas): os << "eBuildRtxTlas"; break;
+                case (le::CommandType::eBuildRtxBlas): os << "eBuildRtxBlas"; break;
+                case (le::CommandType::eWriteToImage): os << "eWriteToImage"; break;
+                case (le::CommandType::eDrawMeshTasks): os << "eDrawMeshTasks"; break;
+                case (le::CommandType::eTraceRays): os << "eTraceRays"; break;
+                case (le::CommandType::eSetArgumentTlas): os << "eSetArgumentTlas"; break;
+                case (le::CommandType::eSetCullMode): os << "eSetCullMode"; break;
+                case (le::CommandType::eSetFrontFace): os << "eSetFrontFace"; break;
+                case (le::CommandType::eSetPrimitiveTopology): os << "eSetPrimitiveTopology"; break;
+                case (le::CommandType::eSetDepthState): os << "eSetDepthState"; break;
+                case (le::CommandType::eSetPolygonMode): os << "eSetPolygonMode"; break;
+                case (le::CommandType::eSetColorBlendEnable): os << "eSetColorBlendEnable"; break;
+                case (le::CommandType::eSetColorWriteMask): os << "eSetColorWriteMask"; break;
+			}
+	// clang-format on
+
+	if ( cmd_header->info.type == le::CommandType::eBindGraphicsPipeline ) {
+		auto le_cmd = static_cast<le::CommandBindGraphicsPipeline*>( cmd );
+		os << " [" << std::hex << le_cmd->info.gpsoHandle << "]";
+	}
+
+	logger.info( "%s", os.str().c_str() );
+};
+
+// convert 0xrrggbbaa color to float color
+constexpr static std::array<float, 4> hex_rgba_to_float_colour( uint32_t const& hex ) {
+	std::array<float, 4> result{
+	    ( hex >> 24 ) / 255.f,
+	    ( ( hex >> 16 ) & 0xff ) / 255.f,
+	    ( ( hex >> 8 ) & 0xff ) / 255.f,
+	    ( ( hex )&0xff ) / 255.f,
+	};
+	return result;
+}
+
+static BackendFrameData::CommandPool* backend_frame_data_produce_command_pool(
+    BackendFrameData& frame,
+    uint32_t          queue_family_index,
+    VkDevice          device ) {
+
+	ZoneScoped;
+	BackendFrameData::CommandPool* pool = nullptr;
+
+	// search through available command pools to see if we could recycle one with a matching
+	// queue family index.
+
+	for ( auto& existing_pool : frame.available_command_pools ) {
+		if ( false == existing_pool->is_used && existing_pool->vk_queue_family_idx == queue_family_index ) {
+			pool          = existing_pool;
+			pool->is_used = true; // mark this command pool as used
+			break;
+		}
+	}
+
+	if ( pool == nullptr ) {
+		// we couldn't find a command pool, we must allocate a new one.
+
+		pool = new BackendFrameData::CommandPool{};
+
+		VkCommandPoolCreateInfo create_info = {
+		    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		    .pNext            = nullptr,                              // optional
+		    .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // optional
+		    .queueFamilyIndex = queue_family_index,
+		};
+
+		vkCreateCommandPool( device, &create_info, nullptr, &pool->pool );
+		le::Log( LOGGER_LABEL ).info( "Created CommandPool %p", pool->pool );
+
+		frame.available_command_pools.push_back( pool );
+		pool->vk_queue_family_idx = queue_family_index;
+		pool->is_used             = true; // mark this command pool as used
+	}
+
+	assert( pool && "must either find or create valid command pool" );
+	return pool;
+}
+
+// predictable, repeatable response given queue flags
+static uint32_t backend_find_queue_family_index_from_requirements( le_backend_o* self, VkQueueFlags flags ) {
+	ZoneScoped;
+	uint32_t lowest_num_extra_bits = ~uint32_t( 0 );
+	uint32_t found_family          = ~uint32_t( 0 );
+
+	static std::unordered_map<VkQueueFlags, uint32_t> cache;
+
+	auto cache_entry = cache.emplace( flags, 0 );
+
+	if ( cache_entry.second == true ) {
+		// element was inserted, this was not a cache hit
+		for ( BackendQueueInfo const* info : self->queues ) {
+			VkQueueFlags available_flags = info->queue_flags;
+			VkQueueFlags requested_flags = flags;
+
+			if ( ( available_flags & requested_flags ) == requested_flags ) {
+				// requested_flags are contained in available flags
+				VkQueueFlags leftover_flags = ( available_flags & ( ~requested_flags ) ); // flags which only appear in available_flags
+				size_t       num_extra_bits = std::bitset<sizeof( VkQueueFlags ) * 8>( leftover_flags ).count();
+				if ( num_extra_bits < lowest_num_extra_bits ) {
+					found_family          = info->queue_family_index;
+					lowest_num_extra_bits = num_extra_bits;
+				}
+			}
+		}
+		cache_entry.first->second = found_family;
+	}
+
+	return cache_entry.first->second;
+}
+
+// Must execute on the RECORD FRAME
+//
+static void backend_acquire_swapchain_resources( le_backend_o* self, size_t frameIndex ) {
+	ZoneScoped;
+	auto& frame = self->mFrames[ frameIndex ];
+
+	static VkDevice device = self->device->getVkDevice();
+	using namespace le_swapchain_vk;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	decltype( frame.frame_owned_swapchain_state ) previous_swapchain_state;
+
+	std::swap( frame.frame_owned_swapchain_state, previous_swapchain_state ); // we swap into previous so that anything left over in previous will be destroyed at end of scope.
+
+	for ( auto& [ key, backend_swapchain_data ] : self->swapchains ) {
+
+		auto previous_it = previous_swapchain_state.find( key );
+		// Item existed before:
+		// we can recycle the semaphores.
+
+		auto const& [ swapchain_state, was_inserted ] =
+		    ( previous_it != previous_swapchain_state.end() )                                          // if item existed in a previous version of this frame
+		        ? frame.frame_owned_swapchain_state.emplace( previous_it->first, previous_it->second ) // then copy previous swapchain info into the current frame
+		        : frame.frame_owned_swapchain_state.emplace( key, swapchain_state_t{} );               // otherwise generate new swapchain info
+
+		swapchain_state_t& local_swapchain_state = swapchain_state->second;
+
+		if ( previous_it == previous_swapchain_state.end() ) {
+			// item did not exist before - we must create semaphores.
+
+			VkSemaphoreCreateInfo const create_info = {
+			    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			    .pNext = nullptr, // optional
+			    .flags = 0,       // optional
+			};
+
+			local_swapchain_state.presentComplete = std::shared_ptr<SemaphoreContainer>( new SemaphoreContainer, []( SemaphoreContainer* p ) {
+				logger.info( "destroying present complete semaphore %x", p->semaphore );
+				vkDestroySemaphore( device, p->semaphore, nullptr );
+				delete ( p );
+			} );
+			vkCreateSemaphore( device, &create_info, nullptr, &local_swapchain_state.presentComplete->semaphore );
+
+			local_swapchain_state.renderComplete = std::shared_ptr<SemaphoreContainer>( new SemaphoreContainer, []( SemaphoreContainer* p ) {
+				logger.info( "destroying render complete semaphore %x", p->semaphore );
+				vkDestroySemaphore( device, p->semaphore, nullptr );
+				delete ( p );
+			} );
+			vkCreateSemaphore( device, &create_info, nullptr, &local_swapchain_state.renderComplete->semaphore );
+		}
+
+		local_swapchain_state.swapchain_data = backend_swapchain_data; // this is where we copy the swapchain into the frame.
+
+		// Acquire swapchain images - this needs to happen on the main thread.
+		//
+		// We try to acquire all images, even if one of the acquisitions fails.
+		//
+		// This is so that every semaphore for presentComplete is correctly
+		// waited upon.
+
+		bool acquire_success = true;
+
+		if ( !swapchain_i.acquire_next_image( local_swapchain_state.swapchain_data.get_swapchain(),
+		                                      local_swapchain_state.presentComplete->semaphore,
+		                                      &local_swapchain_state.image_idx ) ) {
+
+			// try to acquire again by creating a new swapchain from the old one
+
+			le_swapchain_o* new_swapchain = swapchain_i.create_from_old_swapchain( local_swapchain_state.swapchain_data.get_swapchain() );
+			local_swapchain_state.swapchain_data.replace_swapchain( new_swapchain );
+
+			if ( swapchain_i.acquire_next_image( new_swapchain,
+			                                     local_swapchain_state.presentComplete->semaphore,
+			                                     &local_swapchain_state.image_idx ) ) {
+
+				// if an image was acquired with a newly created swapchain, then
+				// we must query the image width and height.
+
+				local_swapchain_state.swapchain_data.swapchain_surface_format = *swapchain_i.get_surface_format( new_swapchain );
+				local_swapchain_state.swapchain_data.width                    = swapchain_i.get_image_width( new_swapchain );
+				local_swapchain_state.swapchain_data.height                   = swapchain_i.get_image_height( new_swapchain );
+
+				backend_swapchain_data = local_swapchain_state.swapchain_data; // copy frame swapchain data to backend
+
+				local_swapchain_state.acquire_successful = true;
+				acquire_success                          = true;
+			} else {
+				// TODO: What do we want to do if acquiring with a new swapchain fails?
+				// We should destroy both swapchains for sure.
+				acquire_success                          = false;
+				local_swapchain_state.acquire_successful = false;
+				logger.error( "Could not acquire swapchain" );
+				assert( false );
+			}
+		} else {
+			local_swapchain_state.acquire_successful = true;
+		}
+
+		if ( !acquire_success ) {
+			continue;
+		}
+
+		// TODO: what happens if we cannot acquire successfully?
+		// in which case, this frame is doomed.
+
+		auto tmp_surface_width  = local_swapchain_state.swapchain_data.width;
+		auto tmp_surface_height = local_swapchain_state.swapchain_data.height;
+
+		{
+			auto& swapchain_image_resource = frame.availableResources[ local_swapchain_state.swapchain_data.swapchain_image ];
+
+			swapchain_image_resource.info.type = LeResourceType::eImage;
+			swapchain_image_resource.as.image =
+			    swapchain_i.get_image( local_swapchain_state.swapchain_data.get_swapchain(), local_swapchain_state.image_idx );
+
+			{
+				// Fetch Image Info for swapchain image
+				auto& imageInfo = frame.availableResources[ local_swapchain_state.swapchain_data.swapchain_image ].info.imageInfo;
+
+				// Overwrite Image Info
+				imageInfo = {
+				    .sType     = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				    .pNext     = nullptr, // optional
+				    .flags     = 0,       // optional
+				    .imageType = VK_IMAGE_TYPE_2D,
+				    .format    = local_swapchain_state.swapchain_data.swapchain_surface_format.format,
+				    .extent    = {
+				           .width  = tmp_surface_width,
+				           .height = tmp_surface_height,
+				           .depth  = 1,
+                    },
+				    .mipLevels             = 1,
+				    .arrayLayers           = 1,
+				    .samples               = VK_SAMPLE_COUNT_1_BIT,
+				    .tiling                = VK_IMAGE_TILING_OPTIMAL,
+				    .usage                 = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+				    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+				    .queueFamilyIndexCount = 0, // optional
+				    .pQueueFamilyIndices   = nullptr,
+				    .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
+				};
+			}
+		}
+
+		// Add swapchain resource to automatically- declared resources
+		// We add this so that usage type is automatically defined for this Resource as ColorAttachment.
+		// and so that it automatically receives the correct image format.
+
+		{
+			le_resource_info_t img_info = le_renderer::helpers_i.get_default_resource_info_for_image();
+			img_info.image.usage        = le::ImageUsageFlags( le::ImageUsageFlagBits::eColorAttachment );
+			img_info.image.extent       = { .width = tmp_surface_width, .height = tmp_surface_height, .depth = 1 };
+			img_info.image.format       = le::Format( local_swapchain_state.swapchain_data.swapchain_surface_format.format );
+
+			auto const& [ it, was_inserted ] = frame.declared_resources.emplace( local_swapchain_state.swapchain_data.swapchain_image, img_info );
+			if ( !was_inserted ) {
+				// If image declaration did already exist, we must consolidate the corresponing image info
+				consolidate_resource_info_into( it->second, img_info );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+//
+inline DescriptorData* find_descriptor_with_binding_number_and_array_idx(
+    std::vector<DescriptorData>& descriptor_set, uint32_t binding_number, uint32_t array_idx = 0 ) {
+	ZoneScoped;
+	for ( auto& d : descriptor_set ) {
+		if ( d.bindingNumber == binding_number &&
+		     d.arrayIndex == array_idx ) {
+			return &d;
+		}
+	}
+
+	return nullptr;
+}
+
+// ----------------------------------------------------------------------
+// Decode commandStream for each pass (may happen in parallel)
+// translate into vk specific commands.
+static void backend_process_frame( le_backend_o* self, size_t frameIndex ) {
+
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	if ( LE_PRINT_DEBUG_MESSAGES ) {
+		logger.debug( "** Process Frame #%8d **", frameIndex );
+	}
+
+	using namespace le_renderer;   // for encoder
+	using namespace le_backend_vk; // for device
+
+	auto& frame = self->mFrames[ frameIndex ];
+
+	// Only insert debug labels iff validation layers are active - otherwise we will get errors.
+	// Debug labels are useful for RenderDoc, for example.
+	bool const SHOULD_INSERT_DEBUG_LABELS = self->instance->is_using_validation_layers;
+
+	VkDevice device = self->device->getVkDevice();
+
+	static_assert( sizeof( VkViewport ) == sizeof( le::Viewport ), "Viewport data size must be same in vk and le" );
+	static_assert( sizeof( VkRect2D ) == sizeof( le::Rect2D ), "Rect2D data size must be same in vk and le" );
+
+	static auto maxVertexInputBindings = vk_device_i.get_vk_physical_device_properties( *self->device )->limits.maxVertexInputBindings;
+
+	uint32_t const extended_dynamic_state_level = le_backend_vk::api->backend_settings_singleton->extended_dynamic_state_level;
+
+	bool needs_to_collect_root_pass_names = frame.must_create_queues_dot_graph; // only collect root pass names when these are needed, for example in order to create dot graphs or debug printouts
+
+	{
+
+		// -- Collect command buffers for each queue submission by testing against queue submission key.
+		//    if a pass's affinity matches the submission key, it belongs to that particular queue submission.
+		// -- And collect pass indices per queue submission
+
+		size_t num_invocation_keys = frame.queue_submission_keys.size();
+
+		for ( size_t i = 0; i != num_invocation_keys; i++ ) {
+
+			auto const& key = frame.queue_submission_keys[ i ];
+
+			BackendFrameData::PerQueueSubmissionData submission_data{};
+
+			for ( size_t pi = 0; pi != frame.passes.size(); pi++ ) {
+
+				auto const& pass = frame.passes[ pi ];
+
+				if ( key & pass.root_passes_affinity ) {
+					submission_data.queue_flags |= VkQueueFlags( pass.type ); // Accumulate queue flags over submission - queue capabilities must be superset
+					submission_data.pass_indices.push_back( uint32_t( pi ) );
+				}
+			}
+
+			if ( needs_to_collect_root_pass_names ) {
+				for ( size_t j = 0; j != frame.debug_root_passes_names.size(); j++ ) {
+					if ( key & ( uint64_t( 1 ) << j ) ) {
+						if ( !submission_data.debug_root_passes_names.empty() ) {
+							submission_data.debug_root_passes_names.append( " | " );
+						}
+						submission_data.debug_root_passes_names.append( frame.debug_root_passes_names[ j ] );
+					}
+				}
+			}
+
+			if ( !submission_data.pass_indices.empty() ) {
+				frame.queue_submission_data.push_back( submission_data );
+			}
+		}
+
+		assert( num_invocation_keys == frame.queue_submission_data.size() && "must have one submission data element per invocaton key" );
+
+		// -- Control that resources may only be used by the same queue family per-frame.
+		// we adjust for this by making the queue requirements a superset of all resource queue usages,
+		// and accumulating all queue usages per-resource first.
+
+		if ( self->must_track_resources_queue_family_ownership ) {
+			// We only must do this if we have multiple queue families active
+			// as this can get pretty expensive if there are many resources flying around.
+
+			// We do this to prevent a situation where a resource is claimed by two or more queue families
+			// Ideally, this
+
+			// for each resource, accumulate all queue type flags that it gets used with over all submissions
+
+			std::unordered_map<le_resource_handle, VkQueueFlags> resource_queue_flags;
+
+			for ( auto const& qs : frame.queue_submission_data ) {
+				for ( auto const& pi : qs.pass_indices ) {
+					for ( auto const& r : frame.passes[ pi ].resources ) {
+						resource_queue_flags[ r ] |= qs.queue_flags;
+					}
+				}
+			}
+
+			// now accumulate submission's queue flags based on the queue flags that all its resources have
+
+			for ( auto& qs : frame.queue_submission_data ) {
+				for ( auto const& pi : qs.pass_indices ) {
+					VkQueueFlags flags = qs.queue_flags;
+					for ( auto const& r : frame.passes[ pi ].resources ) {
+						flags |= resource_queue_flags.at( r );
+					}
+					qs.queue_flags = flags;
+				}
+			}
+		}
+
+		{
+			/// Assign queues to each submission:
+			///
+			/// we must have a unique mapping from queue_flags to queue family.
+			///
+			/// from this, we can then go through all queues of the queue family
+			/// and pick the queue with the least submissions.
+			///
+			std::vector<uint32_t> num_submissions_per_queue( num_invocation_keys, 0 );
+			for ( size_t i = 0; i != num_invocation_keys; i++ ) {
+
+				auto const& queues = self->queues;
+				auto const& flags  = frame.queue_submission_data[ i ].queue_flags;
+
+				int      matching_queue          = -1;
+				uint32_t lowest_submission_count = uint32_t( ~0 );
+
+				uint32_t matching_queue_family_index = backend_find_queue_family_index_from_requirements( self, flags );
+
+				// try to find an exact match with the lowest submissions to it
+				for ( uint32_t j = 0; j != queues.size(); j++ ) {
+					if ( queues[ j ]->queue_family_index == matching_queue_family_index ) {
+						// all flags are contained in q.queue_flags
+						if ( num_submissions_per_queue[ j ] < lowest_submission_count ) {
+							matching_queue          = j;
+							lowest_submission_count = num_submissions_per_queue[ j ];
+						}
+					}
+				}
+
+				if ( matching_queue == -1 ) {
+					le::Log( LOGGER_LABEL ).error( "Could not find matching queue with capability: %s\n"
+					                               "This could be caused by one or more queue families claiming ownership of the same resource.",
+					                               to_string_vk_queue_flags( flags ).c_str() );
+				}
+
+				assert( matching_queue != -1 && "must have found matching queue" );
+
+				num_submissions_per_queue[ matching_queue ]++;
+
+				frame.queue_submission_data[ i ].queue_idx = matching_queue;
+			}
+		}
+
+		// for each submission data, allocate pool from the correct queue
+
+		for ( auto& data : frame.queue_submission_data ) {
+			// this submission has passes
+			// find available command pool which has the correct queue family.
+
+			data.command_pool = backend_frame_data_produce_command_pool( frame, self->queues[ data.queue_idx ]->queue_family_index, self->device->getVkDevice() );
+			{
+				VkCommandBufferAllocateInfo info = {
+				    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				    .pNext              = nullptr, // optional
+				    .commandPool        = data.command_pool->pool,
+				    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				    .commandBufferCount = uint32_t( data.pass_indices.size() ),
+				};
+
+				data.command_pool->buffers.resize( info.commandBufferCount );
+				vkAllocateCommandBuffers( device, &info, data.command_pool->buffers.data() );
+			}
+		}
+
+		if ( LE_PRINT_DEBUG_MESSAGES ) {
+			logger.info( "Listing queue batches and their queue affinity:" );
+			int i = 0;
+			for ( auto const& qf : frame.queue_submission_data ) {
+				logger.info( "#%i, [%-50s]", i, to_string_vk_queue_flags( qf.queue_flags ).c_str() );
+				i++;
+			}
+			logger.info( "" );
+		}
+	}
+
+	backend_frame_prepare_gpu_queries( self, frame );
+
+	for ( auto const& submission : frame.queue_submission_data ) {
+		std::array<VkClearValue, 16> clearValues{};
+		// split graph into separate submissions by filtering by submission key
+		// accumulate pass types to find out the needed queue flags for the
+		//
+		// create vectors of pass indices per submission
+		// then assign each submission based on best-match to queues
+		// submit submissions to queues in-order.
+
+		// TODO: (parallel for)
+		// note that access to any caches when creating pipelines and layouts and descriptorsets must be
+		// mutex-controlled when processing happens concurrently.
+		uint32_t buffer_index = 0;
+		for ( auto const& passIndex : submission.pass_indices ) {
+
+			auto& pass           = frame.passes[ passIndex ];
+			auto& cmd            = submission.command_pool->buffers[ buffer_index++ ]; // note that we post-increment, so that next iteration will get next command buffer.
+			auto& descriptorPool = frame.descriptorPools[ passIndex ];
+
+			// create frame buffer, based on swapchain and renderpass
+
+			{
+				VkCommandBufferBeginInfo info = {
+				    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				    .pNext            = nullptr,                                     // optional
+				    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // optional
+				    .pInheritanceInfo = 0,                                           // optional
+				};
+
+				vkBeginCommandBuffer( cmd, &info );
+			}
+
+			// If gpu profiling is enabled, bracket the pass with timestamps, and - on graphics
+			// queues - with a pipeline statistics query, if these were requested.
+			uint32_t gpu_query_idx = uint32_t( ~0 );
+
+			if ( frame.gpu_timestamp_pool && self->gpu_timestamp_masks[ submission.queue_idx ] ) {
+				bool has_statistics = frame.gpu_statistics_pool &&
+				                      ( self->queues[ submission.queue_idx ]->queue_flags & VK_QUEUE_GRAPHICS_BIT );
+
+				gpu_query_idx = uint32_t( frame.gpu_pass_queries.size() );
+				frame.gpu_pass_queries.push_back( { pass.debugName, submission.queue_idx, has_statistics } );
+
+				vkCmdWriteTimestamp2( cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, frame.gpu_timestamp_pool, 2 * gpu_query_idx );
+
+				if ( has_statistics ) {
+					vkCmdBeginQuery( cmd, frame.gpu_statistics_pool, gpu_query_idx, 0 );
+				}
+			}
+
+			if ( SHOULD_INSERT_DEBUG_LABELS ) {
+				VkDebugUtilsLabelEXT labelInfo{
+				    .sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+				    .pNext      = nullptr, // optional
+				    .pLabelName = pass.debugName,
+				    .color      = {},
+				};
+
+				static constexpr auto LE_COLOUR_LIGHTBLUE    = hex_rgba_to_float_colour( 0x61BBEFFF );
+				static constexpr auto LE_COLOUR_GREENY_BLUE  = hex_rgba_to_float_colour( 0x4EC9B0FF );
+				static constexpr auto LE_COLOUR_BRICK_ORANGE = hex_rgba_to_float_colour( 0xCE4B0EFF );
+				static constexpr auto LE_COLOUR_PALE_PEACH   = hex_rgba_to_float_colour( 0xFFDBA3FF );
+
+				switch ( pass.type ) {
+				case le::QueueFlagBits::eCompute:
+					memcpy( labelInfo.color, LE_COLOUR_LIGHTBLUE.data(), sizeof( float ) * 4 );
+					break;
+				case le::QueueFlagBits::eGraphics:
+					memcpy( labelInfo.color, LE_COLOUR_GREENY_BLUE.data(), sizeof( float ) * 4 );
+					break;
+				case le::QueueFlagBits::eTransfer:
+					memcpy( labelInfo.color, LE_COLOUR_BRICK_ORANGE.data(), sizeof( float ) * 4 );
+					break;
+				default:
+					break;
+				}
+
+				vkCmdBeginDebugUtilsLabelEXT( cmd, &labelInfo );
+			}
+
+			{
+
+				if ( LE_PRINT_DEBUG_MESSAGES ) {
+					logger.info( "*** Frame %d *** Queue %d *** Renderpass '%s'", frame.frameNumber, submission.queue_idx, pass.debugName );
+				}
+
+				// -- Issue sync barriers for all resources which require explicit sync.
+				//
+				// We must to this here, as the spec requires barriers to happen
+				// before renderpass begin.
+				//
+				for ( auto const& op : pass.explicit_sync_ops ) {
+					// fill in sync op
+
+					if ( op.active == false ) {
+						continue;
+					}
+
+					// ---------| invariant: barrier is active.
+
+					auto const& syncChain = frame.syncChainTable[ op.resource ];
+
+					auto const& stateInitial = syncChain[ op.sync_chain_offset_initial ];
+					auto const& stateFinal   = syncChain[ op.sync_chain_offset_final ];
+
+					if ( stateInitial != stateFinal ) {
+						// we must issue an image barrier
+
+						if ( LE_PRINT_DEBUG_MESSAGES ) {
+
+							// --------| invariant: barrier is active.
+
+							// print out sync chain for sampled image
+							logger.info( "\t Explicit Barrier for: %s (s: %d)", op.resource->data->debug_name, 1 << op.resource->data->num_samples );
+							logger.info( "\t % 3s : % 30s : % 30s : % 10s", "#", "visible_access", "write_stage", "layout" );
+
+							auto const& syncChain = frame.syncChainTable.at( op.resource );
+
+							for ( size_t i = op.sync_chain_offset_initial; i <= op.sync_chain_offset_final; i++ ) {
+								auto const& s = syncChain[ i ];
+								logger.info( "\t % 3d : % 30s : % 30s : % 10s", i,
+								             to_string_vk_access_flags2( s.visible_access ).c_str(),
+								             to_string_vk_pipeline_stage_flags2( s.stage ).c_str(),
+								             to_str_vk_image_layout( s.layout ) );
+							}
+						}
+
+						auto dstImage = frame_data_get_image_from_le_resource_id( frame, static_cast<le_img_resource_handle>( op.resource ) );
+
+						VkImageMemoryBarrier2 imageLayoutTransfer{
+						    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+						    .pNext               = nullptr,
+						    .srcStageMask        = uint64_t( stateInitial.stage ) == 0 ? VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT : stateInitial.stage, // happens-before
+						    .srcAccessMask       = ( stateInitial.visible_access & ANY_WRITE_VK_ACCESS_2_FLAGS ),                                  // make available memory update from operation (in case it was a write operation, otherwise don't wait)
+						    .dstStageMask        = stateFinal.stage,                                                                               // happens-after
+						    .dstAccessMask       = stateFinal.visible_access,                                                                      // make visible
+						    .oldLayout           = stateInitial.layout,
+						    .newLayout           = stateFinal.layout,
+						    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						    .image               = dstImage,
+						    .subresourceRange    = LE_IMAGE_SUBRESOURCE_RANGE_ALL_MIPLEVELS,
+						};
+
+						VkDependencyInfo dependencyInfo = {
+						    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+						    .pNext                    = nullptr, // optional
+						    .dependencyFlags          = 0,       // optional
+						    .memoryBarrierCount       = 0,       // optional
+						    .pMemoryBarriers          = 0,
+						    .bufferMemoryBarrierCount = 0, // optional
+						    .pBufferMemoryBarriers    = 0,
+						    .imageMemoryBarrierCount  = 1, // optional
+						    .pImageMemoryBarriers     = &imageLayoutTransfer,
+						};
+
+						vkCmdPipelineBarrier2( cmd, &dependencyInfo );
+					}
+				} // end for all explicit sync ops.
+			}
+
+			// Draw passes must begin by opening a Renderpass context.
+			if ( pass.type == le::QueueFlagBits::eGraphics && pass.renderPass ) {
+
+				for ( uint32_t i = 0; i != ( pass.numColorAttachments + pass.numDepthStencilAttachments ); ++i ) {
+					clearValues[ i ] = reinterpret_cast<VkClearValue&>( pass.attachments[ i ].clearValue );
+				}
+
+				VkRenderPassBeginInfo renderPassBeginInfo{
+				    .sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+				    .pNext       = nullptr, // optional
+				    .renderPass  = pass.renderPass,
+				    .framebuffer = pass.framebuffer,
+				    .renderArea  = {
+				         .offset = { 0, 0 },
+				         .extent = { pass.width, pass.height },
+                    },
+				    .clearValueCount = uint32_t( pass.numColorAttachments + pass.numDepthStencilAttachments ), // optional
+				    .pClearValues    = clearValues.data(),
+				};
+
+				vkCmdBeginRenderPass( cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+			}
+
+			// -- Translate intermediary command stream data to api-native instructions
+
+			void*    commandStream = nullptr;
+			size_t   dataSize      = 0;
+			size_t   numCommands   = 0;
+			size_t   commandIndex  = 0;
+			uint32_t subpassIndex  = 0;
+
+			VkPipelineLayout currentPipelineLayout                          = nullptr;
+			VkDescriptorSet  descriptorSets[ LE_MAX_BOUND_DESCRIPTOR_SETS ] = {}; // currently bound descriptorSets (allocated from pool, therefore we must not worry about freeing, and may re-use freely)
+
+			// We store currently bound descriptors so that we only allocate new DescriptorSets
+			// if the descriptors really change. With dynamic descriptors, it is very likely
+			// that we don't need to allocate new descriptors, as the same descriptors are used
+			// for different accessors, only with different dynamic binding offsets.
+			//
+			//
+			std::array<DescriptorSetState, 8> previousSetState; // currently bound descriptorSetLayout+Data for each set
+			ArgumentState                     argumentState{};  //
+			RtxState                          rtx_state{};      // used to keep track of shader binding tables bound with rtx pipelines.
+
+			static le_buf_resource_handle LE_RTX_SCRATCH_BUFFER_HANDLE = LE_BUF_RESOURCE( "le_rtx_scratch_buffer_handle" ); // opaque handle for rtx scratch buffer
+
+			if ( pass.encoder ) {
+				encoder_i.get_encoded_data( pass.encoder, &commandStream, &dataSize, &numCommands );
+			} else {
+				// This is legit behaviour for draw passes which are used only to clear attachments,
+				// in which case they don't need to include any draw commands.
+			}
+
+			if ( commandStream != nullptr && numCommands > 0 ) {
+
+				le_pipeline_manager_o* pipelineManager = encoder_i.get_pipeline_manager( pass.encoder );
+				assert( pipelineManager );
+
+				std::vector<VkBuffer>         vertexInputBindings( maxVertexInputBindings, nullptr );
+				void*                         dataIt = commandStream;
+				le_pipeline_and_layout_info_t currentPipeline{};
+				uint32_t                      numSkippedDraws = 0; // draws skipped because their pipeline is still being compiled in the background
+
+				while ( commandIndex != numCommands ) {
+
+					auto header = static_cast<le::CommandHeader*>( dataIt );
+
+					if ( /* DISABLES CODE */ ( false ) ) {
+						// Print the command stream to stdout.
+						debug_print_command( dataIt );
+					}
+
+					switch ( header->info.type ) {
+
+					case le::CommandType::eBindGraphicsPipeline: {
+						auto* le_cmd = static_cast<le::CommandBindGraphicsPipeline*>( dataIt );
+
+						if ( pass.type == le::QueueFlagBits::eGraphics ) {
+							// at this point, a valid renderpass must be bound
+
+							using namespace le_backend_vk;
+							// -- potentially compile and create pipeline here, based on current pass and subpass
+							auto requestedPipeline = le_pipeline_manager_i.produce_graphics_pipeline( pipelineManager, le_cmd->info.gpsoHandle, pass, subpassIndex );
+
+							if ( /* DISABLES CODE */ ( false ) ) {
+
+								// Print pipeline debug info when a new pipeline gets bound.
+
+								logger.debug( "Requested pipeline: %x ", le_cmd->info.gpsoHandle );
+								debug_print_le_pipeline_layout_info( &requestedPipeline.layout_info );
+							}
+
+							if ( !is_equal( currentPipeline, requestedPipeline ) ) {
+								// update current pipeline
+								currentPipeline = requestedPipeline;
+								// -- grab current pipeline layout from cache
+								currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
+								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+
+								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
+								argumentState.binding_infos.clear();
+
+								// -- reset dynamic offset count
+								argumentState.dynamicOffsetCount = 0;
+
+								// let's create descriptorData vector based on current bindings-
+								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+
+									// look up set layout info via set layout key
+									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+
+									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+
+									auto& setData = argumentState.setData[ setId ];
+
+									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
+									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+
+									setData.clear();
+									setData.reserve( setLayoutInfo->binding_info.size() );
+
+									for ( auto b : setLayoutInfo->binding_info ) {
+
+										if ( b.count == 0 ) {
+											// If this is a placeholder binding, we continue early -
+											// this means that this binding will not be added to argumentState.
+											continue;
+										}
+
+										// ----------| invariant: b.count > 0
+
+										// add an entry for each array element with this binding to setData
+										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
+											DescriptorData descriptorData{};
+
+											descriptorData.type          = b.type;
+											descriptorData.bindingNumber = uint32_t( b.binding );
+											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+
+											if ( b.type == le::DescriptorType::eStorageBuffer ||
+											     b.type == le::DescriptorType::eUniformBuffer ||
+											     b.type == le::DescriptorType::eStorageBufferDynamic ||
+											     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+
+												descriptorData.bufferInfo.range = b.range;
+											}
+
+											setData.emplace_back( descriptorData );
+										}
+
+										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
+										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+											assert( b.count != 0 ); // count cannot be 0
+
+											// store dynamic offset index for this element
+											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+
+											// increase dynamic offset count by number of elements in this binding
+											argumentState.dynamicOffsetCount += b.count;
+										}
+
+										// add this binding to list of current bindings
+										argumentState.binding_infos.push_back( b );
+									}
+								}
+
+								if ( currentPipeline.pipeline ) {
+									vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline.pipeline );
+								} else {
+									// Pipeline is being compiled in the background: we keep argument state
+									// for its layout, but any draws will be skipped until it is ready.
+								}
+							} else {
+								// Re-using previously bound pipeline. We may keep argumentState state as it is.
+							}
+
+							if ( extended_dynamic_state_level > 0 ) {
+								// Different psos may share the same vk pipeline if they only differ in dynamic state,
+								// we must therefore always (re-)apply dynamic state defaults for the requested pso.
+								auto pso_data = le_pipeline_manager_i.get_graphics_pipeline_state_data( pipelineManager, le_cmd->info.gpsoHandle );
+								assert( pso_data && "pso must have been introduced to pipeline manager" );
+								backend_cmd_set_pipeline_dynamic_state( cmd, pso_data, extended_dynamic_state_level, pass.numColorAttachments );
+							}
+
+							// -- Reset dynamic offsets in argumentState:
+							// we do this regardless of whether pipeline was already bound,
+							// because binding a pipeline should always reset parameters associated
+							// with the pipeline.
+
+							memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
+
+						} else {
+							// -- TODO: warn that graphics pipelines may only be bound within
+							// draw passes.
+						}
+					} break;
+
+					case le::CommandType::eBindComputePipeline: {
+						auto* le_cmd = static_cast<le::CommandBindComputePipeline*>( dataIt );
+						if ( pass.type == le::QueueFlagBits::eCompute ) {
+							// at this point, a valid renderpass must be bound
+
+							using namespace le_backend_vk;
+							// -- potentially compile and create pipeline here, based on current pass and subpass
+							currentPipeline = le_pipeline_manager_i.produce_compute_pipeline( pipelineManager, le_cmd->info.cpsoHandle );
+
+							// -- grab current pipeline layout from cache
+							currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
+
+							{
+								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+
+								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
+								argumentState.binding_infos.clear();
+
+								// -- reset dynamic offset count
+								argumentState.dynamicOffsetCount = 0;
+
+								// let's create descriptorData vector based on current bindings-
+								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+
+									// look up set layout info via set layout key
+									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+
+									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+
+									auto& setData = argumentState.setData[ setId ];
+
+									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
+									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+
+									setData.clear();
+									setData.reserve( setLayoutInfo->binding_info.size() );
+
+									for ( auto b : setLayoutInfo->binding_info ) {
+
+										// add an entry for each array element with this binding to setData
+										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
+											DescriptorData descriptorData{};
+
+											descriptorData.type          = b.type;
+											descriptorData.bindingNumber = uint32_t( b.binding );
+											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+
+											descriptorData.bufferInfo.range = b.range;
+
+											setData.emplace_back( std::move( descriptorData ) );
+										}
+
+										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
+										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+											assert( b.count != 0 ); // count cannot be 0
+
+											// store dynamic offset index for this element
+											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+
+											// increase dynamic offset count by number of elements in this binding
+											argumentState.dynamicOffsetCount += b.count;
+										}
+
+										// add this binding to list of current bindings
+										argumentState.binding_infos.emplace_back( std::move( b ) );
+									}
+								}
+
+								// -- reset dynamic offsets
+								memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
+
+								// we write directly into descriptorsetstate when we update descriptors.
+								// when we bind a pipeline, we update the descriptorsetstate based
+								// on what the pipeline requires.
+							}
+							vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, currentPipeline.pipeline );
+
+						} else {
+							// -- TODO: warn that compute pipelines may only be bound within
+							// compute passes.
+						}
+
+					} break;
+
+					case le::CommandType::eBindRtxPipeline: {
+						auto* le_cmd = static_cast<le::CommandBindRtxPipeline*>( dataIt );
+						if ( pass.type == le::QueueFlagBits::eCompute ) {
+							// at this point, a valid renderpass must be bound
+
+							using namespace le_backend_vk;
+
+							// -- fetch pipeline from pipeline cache, also fetch shader group data, so that
+							// we can verify that the current pipeline state matches the pipeline state which
+							// was used to create the pipeline. The pipeline state may change if pipeline gets recompiled.
+
+							{
+								currentPipeline.pipeline                        = static_cast<VkPipeline>( le_cmd->info.pipeline_native_handle );
+								currentPipeline.layout_info.pipeline_layout_key = le_cmd->info.pipeline_layout_key;
+
+								memcpy( currentPipeline.layout_info.set_layout_keys, le_cmd->info.descriptor_set_layout_keys, sizeof( currentPipeline.layout_info.set_layout_keys ) );
+
+								currentPipeline.layout_info.set_layout_count = le_cmd->info.descriptor_set_layout_count;
+							}
+
+							// -- grab current pipeline layout from cache
+							currentPipelineLayout = le_pipeline_manager_i.get_pipeline_layout( pipelineManager, currentPipeline.layout_info.pipeline_layout_key );
+
+							{
+								// -- update pipelineData - that's the data values for all descriptors which are currently bound
+
+								argumentState.setCount = uint32_t( currentPipeline.layout_info.set_layout_count );
+								argumentState.binding_infos.clear();
+
+								// -- reset dynamic offset count
+								argumentState.dynamicOffsetCount = 0;
+
+								// let's create descriptorData vector based on current bindings-
+								for ( size_t setId = 0; setId != argumentState.setCount; ++setId ) {
+
+									// look up set layout info via set layout key
+									auto const& set_layout_key = currentPipeline.layout_info.set_layout_keys[ setId ];
+
+									auto const setLayoutInfo = le_pipeline_manager_i.get_descriptor_set_layout( pipelineManager, set_layout_key );
+
+									auto& setData = argumentState.setData[ setId ];
+
+									argumentState.layouts[ setId ]         = setLayoutInfo->vk_descriptor_set_layout;
+									argumentState.updateTemplates[ setId ] = setLayoutInfo->vk_descriptor_update_template;
+
+									setData.clear();
+									setData.reserve( setLayoutInfo->binding_info.size() );
+
+									for ( auto b : setLayoutInfo->binding_info ) {
+
+										// add an entry for each array element with this binding to setData
+										for ( size_t arrayIndex = 0; arrayIndex != b.count; arrayIndex++ ) {
+											DescriptorData descriptorData{};
+
+											descriptorData.type          = le::DescriptorType( b.type );
+											descriptorData.bindingNumber = uint32_t( b.binding );
+											descriptorData.arrayIndex    = uint32_t( arrayIndex );
+
+											if ( b.type == le::DescriptorType::eStorageBuffer ||
+											     b.type == le::DescriptorType::eUniformBuffer ||
+											     b.type == le::DescriptorType::eStorageBufferDynamic ||
+											     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+
+												descriptorData.bufferInfo.range = b.range;
+											}
+
+											setData.emplace_back( std::move( descriptorData ) );
+										}
+
+										if ( b.type == le::DescriptorType::eStorageBufferDynamic ||
+										     b.type == le::DescriptorType::eUniformBufferDynamic ) {
+											assert( b.count != 0 ); // count cannot be 0
+
+											// store dynamic offset index for this element
+											b.dynamic_offset_idx = argumentState.dynamicOffsetCount;
+
+											// increase dynamic offset count by number of elements in this binding
+											argumentState.dynamicOffsetCount += b.count;
+										}
+
+										// add this binding to list of current bindings
+										argumentState.binding_infos.emplace_back( std::move( b ) );
+									}
+								}
+
+								// -- reset dynamic offsets
+								memset( argumentState.dynamicOffsets.data(), 0, sizeof( uint32_t ) * argumentState.dynamicOffsetCount );
+							}
+
+							vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, currentPipeline.pipeline );
+							// -- "bind" shader binding table state
+
+							{
+								rtx_state.sbt_buffer = le_cmd->info.sbt_buffer;
+
+								VkBuffer vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.sbt_buffer );
+
+								VkBufferDeviceAddressInfo info = {
+								    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+								    .pNext  = nullptr, // optional
+								    .buffer = vk_buffer,
+								};
+								uint64_t offset               = vkGetBufferDeviceAddress( device, &info );
+								rtx_state.ray_gen_sbt_offset  = offset + le_cmd->info.ray_gen_sbt_offset;
+								rtx_state.ray_gen_sbt_size    = le_cmd->info.ray_gen_sbt_size;
+								rtx_state.miss_sbt_offset     = offset + le_cmd->info.miss_sbt_offset;
+								rtx_state.miss_sbt_stride     = le_cmd->info.miss_sbt_stride;
+								rtx_state.miss_sbt_size       = le_cmd->info.miss_sbt_size;
+								rtx_state.hit_sbt_offset      = offset + le_cmd->info.hit_sbt_offset;
+								rtx_state.hit_sbt_stride      = le_cmd->info.hit_sbt_stride;
+								rtx_state.hit_sbt_size        = le_cmd->info.hit_sbt_size;
+								rtx_state.callable_sbt_offset = offset + le_cmd->info.callable_sbt_offset;
+								rtx_state.callable_sbt_stride = le_cmd->info.callable_sbt_stride;
+								rtx_state.callable_sbt_size   = le_cmd->info.callable_sbt_size;
+								rtx_state.is_set              = true;
+							}
+
+						} else {
+							// -- TODO: warn that rtx pipelines may only be bound within
+							// compute passes.
+						}
+
+					} break;
+					case le::CommandType::eTraceRays: {
+						auto* le_cmd = static_cast<le::CommandTraceRays*>( dataIt );
+
+						// -- update descriptorsets via template if tainted
+						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+
+						if ( false == argumentsOk ) {
+							break;
+						}
+
+						// --------| invariant: arguments were updated successfully
+
+						if ( argumentState.setCount > 0 ) {
+
+							vkCmdBindDescriptorSets(
+							    cmd,
+							    VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
+							    currentPipelineLayout,
+							    0,
+							    argumentState.setCount,
+							    descriptorSets,
+							    argumentState.dynamicOffsetCount,
+							    argumentState.dynamicOffsets.data() );
+						}
+
+						assert( rtx_state.is_set && "sbt state must have been set before calling traceRays" );
+
+						// VkBuffer sbt_vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, rtx_state.sbt_buffer );
+
+						//					std::cout << "sbt buffer: " << std::hex << sbt_vk_buffer << std::endl
+						//					          << std::flush;
+						//					std::cout << "sbt buffer raygen offset: " << std::dec << rtx_state.ray_gen_sbt_offset << std::endl
+						//					          << std::flush;
+
+						// buffer, offset, stride, size
+						VkStridedDeviceAddressRegionKHR sbt_ray_gen{ rtx_state.ray_gen_sbt_offset, rtx_state.ray_gen_sbt_size, rtx_state.ray_gen_sbt_size };
+						VkStridedDeviceAddressRegionKHR sbt_miss{ rtx_state.miss_sbt_offset, rtx_state.miss_sbt_stride, rtx_state.miss_sbt_size };
+						VkStridedDeviceAddressRegionKHR sbt_hit{ rtx_state.hit_sbt_offset, rtx_state.hit_sbt_stride, rtx_state.hit_sbt_size };
+						VkStridedDeviceAddressRegionKHR sbt_callable{ rtx_state.callable_sbt_offset, rtx_state.callable_sbt_stride, rtx_state.callable_sbt_size };
+
+						vkCmdTraceRaysKHR(
+						    cmd,
+						    &sbt_ray_gen,
+						    &sbt_miss,
+						    &sbt_hit,
+						    &sbt_callable,
+						    le_cmd->info.width,
+						    le_cmd->info.height,
+						    le_cmd->info.depth //
+						);
+
+					} break;
+					case le::CommandType::eDispatch: {
+						auto* le_cmd = static_cast<le::CommandDispatch*>( dataIt );
+
+						// -- update descriptorsets via template if tainted
+						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+
+						if ( false == argumentsOk ) {
+							break;
+						}
+
+						// --------| invariant: arguments were updated successfully
+
+						if ( argumentState.setCount > 0 ) {
+
+							vkCmdBindDescriptorSets( cmd,
+							                         VK_PIPELINE_BIND_POINT_COMPUTE,
+							                         currentPipelineLayout,
+							                         0,
+							                         argumentState.setCount,
+							                         descriptorSets,
+							                         argumentState.dynamicOffsetCount,
+							                         argumentState.dynamicOffsets.data() );
+						}
+
+						vkCmdDispatch( cmd, le_cmd->info.groupCountX, le_cmd->info.groupCountY, le_cmd->info.groupCountZ );
+
+					} break;
+					case le::CommandType::eBufferMemoryBarrier: {
+						auto*                  le_cmd = static_cast<le::CommandBufferMemoryBarrier*>( dataIt );
+						VkBufferMemoryBarrier2 bufferMemoryBarrier{
+						    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+						    .pNext               = nullptr,
+						    .srcStageMask        = static_cast<VkPipelineStageFlags2>( le_cmd->info.srcStageMask ), // happens-before
+						    .srcAccessMask       = 0,                                                               // FIXME: no memory is made available from src stage ?!
+						    .dstStageMask        = static_cast<VkPipelineStageFlags2>( le_cmd->info.dstStageMask ), // before continuing with dst stage
+						    .dstAccessMask       = static_cast<VkAccessFlagBits2>( le_cmd->info.dstAccessMask ),    // and making memory visible to dst stage
+						    .srcQueueFamilyIndex = 0,
+						    .dstQueueFamilyIndex = 0,
+						    .buffer              = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer ),
+						    .offset              = le_cmd->info.offset,
+						    .size                = le_cmd->info.range,
+						};
+
+						VkDependencyInfo dependency_info{
+						    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+						    .pNext                    = nullptr, // optional
+						    .dependencyFlags          = 0,       // optional
+						    .memoryBarrierCount       = 0,       // optional
+						    .pMemoryBarriers          = 0,
+						    .bufferMemoryBarrierCount = 1, // optional
+						    .pBufferMemoryBarriers    = &bufferMemoryBarrier,
+						    .imageMemoryBarrierCount  = 0, // optional
+						    .pImageMemoryBarriers     = 0,
+						};
+
+						vkCmdPipelineBarrier2( cmd, &dependency_info );
+
+					} break;
+					case le::CommandType::eDraw: {
+						auto* le_cmd = static_cast<le::CommandDraw*>( dataIt );
+
+						if ( nullptr == currentPipeline.pipeline ) {
+							// pipeline not yet available - it is being compiled in the background.
+							numSkippedDraws++;
+							break;
+						}
+
+						// -- update descriptorsets via template if tainted
+						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+
+						if ( false == argumentsOk ) {
+							break;
+						}
+
+						// --------| invariant: arguments were updated successfully
+
+						if ( argumentState.setCount > 0 ) {
+
+							vkCmdBindDescriptorSets(
+							    cmd,
+							    VK_PIPELINE_BIND_POINT_GRAPHICS,
+							    currentPipelineLayout,
+							    0,
+							    argumentState.setCount,
+							    descriptorSets,
+							    argumentState.dynamicOffsetCount,
+							    argumentState.dynamicOffsets.data() );
+						}
+
+						vkCmdDraw( cmd, le_cmd->info.vertexCount, le_cmd->info.instanceCount, le_cmd->info.firstVertex, le_cmd->info.firstInstance );
+					} break;
+
+					case le::CommandType::eDrawIndexed: {
+						auto* le_cmd = static_cast<le::CommandDrawIndexed*>( dataIt );
+
+						if ( nullptr == currentPipeline.pipeline ) {
+							// pipeline not yet available - it is being compiled in the background.
+							numSkippedDraws++;
+							break;
+						}
+
+						// -- update descriptorsets via template if tainted
+						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+
+						if ( false == argumentsOk ) {
+							break;
+						}
+
+						// --------| invariant: arguments were updated successfully
+
+						if ( argumentState.setCount > 0 ) {
+
+							vkCmdBindDescriptorSets(
+							    cmd,
+							    VK_PIPELINE_BIND_POINT_GRAPHICS,
+							    currentPipelineLayout,
+							    0,
+							    argumentState.setCount,
+							    descriptorSets,
+							    argumentState.dynamicOffsetCount,
+							    argumentState.dynamicOffsets.data() );
+						}
+
+						vkCmdDrawIndexed(
+						    cmd,
+						    le_cmd->info.indexCount,
+						    le_cmd->info.instanceCount,
+						    le_cmd->info.firstIndex,
+						    le_cmd->info.vertexOffset,
+						    le_cmd->info.firstInstance );
+					} break;
+
+					case le::CommandType::eDrawMeshTasks: {
+						auto* le_cmd = static_cast<le::CommandDrawMeshTasks*>( dataIt );
+
+						if ( nullptr == currentPipeline.pipeline ) {
+							// pipeline not yet available - it is being compiled in the background.
+							numSkippedDraws++;
+							break;
+						}
+
+						// -- update descriptorsets via template if tainted
+						bool argumentsOk = updateArguments( device, descriptorPool, argumentState, previousSetState, descriptorSets );
+
+						if ( false == argumentsOk ) {
+							break;
+						}
+
+						// --------| invariant: arguments were updated successfully
+
+						if ( argumentState.setCount > 0 ) {
+
+							vkCmdBindDescriptorSets( cmd,
+							                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+							                         currentPipelineLayout,
+							                         0,
+							                         argumentState.setCount,
+							                         descriptorSets,
+							                         argumentState.dynamicOffsetCount,
+							                         argumentState.dynamicOffsets.data() );
+						}
+
+						vkCmdDrawMeshTasksNV( cmd, le_cmd->info.taskCount, le_cmd->info.firstTask );
+					} break;
+
+					case le::CommandType::eSetLineWidth: {
+						auto* le_cmd = static_cast<le::CommandSetLineWidth*>( dataIt );
+						vkCmdSetLineWidth( cmd, le_cmd->info.width );
+					} break;
+
+					case le::CommandType::eSetCullMode: {
+						auto* le_cmd = static_cast<le::CommandSetCullMode*>( dataIt );
+						assert( extended_dynamic_state_level >= 1 && "setting cull mode requires extended dynamic state" );
+						if ( extended_dynamic_state_level >= 1 ) {
+							vkCmdSetCullMode( cmd, VkCullModeFlags( le_cmd->info.cull_mode ) );
+						}
+					} break;
+
+					case le::CommandType::eSetFrontFace: {
+						auto* le_cmd = static_cast<le::CommandSetFrontFace*>( dataIt );
+						assert( extended_dynamic_state_level >= 1 && "setting front face requires extended dynamic state" );
+						if ( extended_dynamic_state_level >= 1 ) {
+							vkCmdSetFrontFace( cmd, VkFrontFace( le_cmd->info.front_face ) );
+						}
+					} break;
+
+					case le::CommandType::eSetPrimitiveTopology: {
+						auto* le_cmd = static_cast<le::CommandSetPrimitiveTopology*>( dataIt );
+						assert( extended_dynamic_state_level >= 1 && "setting primitive topology requires extended dynamic state" );
+						if ( extended_dynamic_state_level >= 1 ) {
+							vkCmdSetPrimitiveTopology( cmd, VkPrimitiveTopology( le_cmd->info.topology ) );
+						}
+					} break;
+
+					case le::CommandType::eSetDepthState: {
+						auto* le_cmd = static_cast<le::CommandSetDepthState*>( dataIt );
+						assert( extended_dynamic_state_level >= 1 && "setting depth state requires extended dynamic state" );
+						if ( extended_dynamic_state_level >= 1 ) {
+							vkCmdSetDepthTestEnable( cmd, le_cmd->info.depth_test_enable );
+							vkCmdSetDepthWriteEnable( cmd, le_cmd->info.depth_write_enable );
+							vkCmdSetDepthCompareOp( cmd, VkCompareOp( le_cmd->info.depth_compare_op ) );
+						}
+					} break;
+
+					case le::CommandType::eSetPolygonMode: {
+						auto* le_cmd = static_cast<le::CommandSetPolygonMode*>( dataIt );
+						assert( extended_dynamic_state_level >= 3 && "setting polygon mode requires extended dynamic state level 3" );
+						if ( extended_dynamic_state_level >= 3 ) {
+							vkCmdSetPolygonModeEXT( cmd, VkPolygonMode( le_cmd->info.polygon_mode ) );
+						}
+					} break;
+
+					case le::CommandType::eSetColorBlendEnable: {
+						auto* le_cmd = static_cast<le::CommandSetColorBlendEnable*>( dataIt );
+						assert( extended_dynamic_state_level >= 3 && "setting color blend enable requires extended dynamic state level 3" );
+						if ( extended_dynamic_state_level >= 3 && le_cmd->info.attachment < pass.numColorAttachments ) {
+							VkBool32 blend_enable = le_cmd->info.blend_enable;
+							vkCmdSetColorBlendEnableEXT( cmd, le_cmd->info.attachment, 1, &blend_enable );
+						}
+					} break;
+
+					case le::CommandType::eSetColorWriteMask: {
+						auto* le_cmd = static_cast<le::CommandSetColorWriteMask*>( dataIt );
+						assert( extended_dynamic_state_level >= 3 && "setting color write mask requires extended dynamic state level 3" );
+						if ( extended_dynamic_state_level >= 3 && le_cmd->info.attachment < pass.numColorAttachments ) {
+							VkColorComponentFlags write_mask = le_cmd->info.write_mask;
+							vkCmdSetColorWriteMaskEXT( cmd, le_cmd->info.attachment, 1, &write_mask );
+						}
+					} break;
+
+					case le::CommandType::eSetViewport: {
+						auto* le_cmd = static_cast<le::CommandSetViewport*>( dataIt );
+						// Since data for viewports *is stored inline*, we increment the typed pointer
+						// of le_cmd by 1 to reach the next slot in the stream, where the data is stored.
+						vkCmdSetViewport( cmd, le_cmd->info.firstViewport, le_cmd->info.viewportCount, reinterpret_cast<VkViewport*>( le_cmd + 1 ) );
+					} break;
+
+					case le::CommandType::eSetScissor: {
+						auto* le_cmd = static_cast<le::CommandSetScissor*>( dataIt );
+						// Since data for scissors *is stored inline*, we increment the typed pointer
+						// of le_cmd by 1 to reach the next slot in the stream, where the data is stored.
+						vkCmdSetScissor( cmd, le_cmd->info.firstScissor, le_cmd->info.scissorCount, reinterpret_cast<VkRect2D*>( le_cmd + 1 ) );
+					} break;
+
+					case le::CommandType::eSetPushConstantData: {
+						if ( currentPipelineLayout ) {
+
+#ifndef NDEBUG
+							// Only do extra check when compiling for Debug:
+							//
+							// If current pipeline has not push constants enabled, then exit early, and print an error message.
+							if ( ( currentPipeline.layout_info.push_constants_enabled & 0x1 ) == false ) {
+								// We only want to print this message once.
+								if ( LE_DEBUG_TRUE_ONCE_IF_CHANGED( uint64_t( currentPipeline.pipeline ) ) ) {
+									LeLog( LOGGER_LABEL ).warn( "Push Constants used, but none available for this particular Pipeline: %p\n"
+									                            "\t>> Perhaps Push Constants have been optimised out in shader code as their members are not used by the shader(s)?",
+									                            currentPipeline.pipeline );
+								}
+								break; // early-out, prevents rest of command to be interpreted
+							}
+#endif
+							auto*              le_cmd               = static_cast<le::CommandSetPushConstantData*>( dataIt );
+							VkShaderStageFlags active_shader_stages = VkShaderStageFlags( currentPipeline.layout_info.active_vk_shader_stages );
+							vkCmdPushConstants( cmd, currentPipelineLayout, active_shader_stages, 0, uint32_t( le_cmd->info.num_bytes ), ( le_cmd + 1 ) ); // Note that we fetch inline data at (le_cmd + 1)
+						}
+						break;
+					}
+
+					case le::CommandType::eBindArgumentBuffer: {
+						// we need to store the data for the dynamic binding which was set as an argument to the ubo
+						// this alters our internal state
+						auto* le_cmd = static_cast<le::CommandBindArgumentBuffer*>( dataIt );
+
+						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+
+						// find binding info with name referenced in command
+
+						auto b = argumentState.binding_infos.begin();
+
+						for ( ; b != argumentState.binding_infos.end(); b++ ) {
+							if ( b->name_hash == argument_name_id ) {
+								break;
+							}
+						}
+
+						if ( b == argumentState.binding_infos.end() ) {
+							static uint64_t wrong_argument = argument_name_id;
+							[]( uint64_t argument ) {
+								static uint64_t argument_id_local = 0;
+								if ( argument_id_local == wrong_argument )
+									return;
+								logger.warn( "Process_frame: \x1b[38;5;209mInvalid argument name: '%s'\x1b[0m id: %x", le_get_argument_name_from_hash( argument ), argument );
+								argument_id_local = argument;
+							}( argument_name_id );
+							break;
+						}
+
+						// ---------| invariant: we found an argument name that matches
+
+						DescriptorData* descriptor_data =
+						    find_descriptor_with_binding_number_and_array_idx(
+						        argumentState.setData[ b->setIndex ], b->binding );
+
+						if ( descriptor_data ) {
+
+							// Matching binding found
+
+							DescriptorData::BufferInfo& buffer_info = descriptor_data->bufferInfo;
+
+							buffer_info.buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer_id );
+							buffer_info.range  = le_cmd->info.range;
+
+							if ( buffer_info.range == 0 ) {
+
+								// If no range was specified, we must default to VK_WHOLE_SIZE,
+								// as a range setting of 0 is not allowed in Vulkan.
+
+								buffer_info.range = VK_WHOLE_SIZE;
+							}
+
+							// If binding is in fact a dynamic binding, set the corresponding dynamic offset
+							// and set the buffer offset to 0.
+							if ( b->type == le::DescriptorType::eStorageBufferDynamic ||
+							     b->type == le::DescriptorType::eUniformBufferDynamic ) {
+								auto dynamicOffset                            = b->dynamic_offset_idx;
+								buffer_info.offset                            = 0;
+								argumentState.dynamicOffsets[ dynamicOffset ] = uint32_t( le_cmd->info.offset );
+							} else {
+								buffer_info.offset = le_cmd->info.offset;
+							}
+						}
+
+					} break;
+
+					case le::CommandType::eSetArgumentTexture: {
+						auto*    le_cmd           = static_cast<le::CommandSetArgumentTexture*>( dataIt );
+						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+
+						// Find binding info with name referenced in command
+						auto b = argumentState.binding_infos.begin();
+
+						for ( ; b != argumentState.binding_infos.end(); b++ ) {
+							if ( b->name_hash == argument_name_id ) {
+								break;
+							}
+						}
+
+						if ( b == argumentState.binding_infos.end() ) {
+							logger.warn( "Invalid texture argument name id: %x", argument_name_id );
+							break;
+						}
+
+						// ---------| invariant: we found an argument name that matches
+
+						auto arrayIndex = uint32_t( le_cmd->info.array_index );
+
+						// Descriptors are stored as flat arrays; we cannot assume that binding number matches
+						// index of descriptor in set, because some types of uniforms may be arrays, and these
+						// arrays will be stored flat in the vector of per-set descriptors.
+						//
+						// Imagine these were bindings for a set: a b c0 c1 c2 c3 c4 d
+						// a(0), b(1), would have their own binding number, but c0(2), c1(2), c2(2), c3(2), c4(2)
+						// would share a single binding number, 2, until d(3), which would have binding number 3.
+						//
+						// To find the correct descriptor, we must therefore iterate over descriptors in-set
+						// until we find one that matches the correct array index.
+						//
+
+						auto bindingData =
+						    find_descriptor_with_binding_number_and_array_idx(
+						        argumentState.setData[ b->setIndex ], b->binding, arrayIndex );
+
+						if ( bindingData ) {
+							// fetch texture information based on texture id from command
+
+							auto foundTex = frame.textures_per_pass[ passIndex ].find( le_cmd->info.texture_id );
+							if ( foundTex == frame.textures_per_pass[ passIndex ].end() ) {
+								using namespace le_renderer;
+								logger.error( "Could not find requested texture: '%s', ignoring texture binding command",
+								              renderer_i.texture_handle_get_name( le_cmd->info.texture_id ) );
+								break;
+							}
+
+							// ----------| invariant: texture has been found
+
+							bindingData->imageInfo.imageLayout = le::ImageLayout::eShaderReadOnlyOptimal;
+							bindingData->imageInfo.sampler     = foundTex->second.sampler;
+							bindingData->imageInfo.imageView   = foundTex->second.imageView;
+							bindingData->type                  = le::DescriptorType::eCombinedImageSampler;
+						} else {
+							logger.error( "Could not find binding at set: %d, binding: %d, array index: %d.", b->setIndex, b->binding, arrayIndex );
+							assert( bindingData && "could not find specified binding." );
+						}
+					} break;
+
+					case le::CommandType::eSetArgumentImage: {
+						auto*    le_cmd           = static_cast<le::CommandSetArgumentImage*>( dataIt );
+						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+
+						// Find binding info with name referenced in command
+						auto b = argumentState.binding_infos.begin();
+
+						for ( ; b != argumentState.binding_infos.end(); b++ ) {
+							if ( b->name_hash == argument_name_id ) {
+								break;
+							}
+						}
+
+						if ( b == argumentState.binding_infos.end() ) {
+							logger.warn( "Warning: Invalid image argument name id: %x", argument_name_id );
+							break;
+						}
+
+						// ---------| invariant: we found an argument name that matches
+
+						auto bindingData =
+						    find_descriptor_with_binding_number_and_array_idx(
+						        argumentState.setData[ b->setIndex ], b->binding );
+
+						// fetch texture information based on texture id from command
+						if ( bindingData ) {
+
+							auto foundImgView = frame.imageViews.find( le_cmd->info.image_id );
+							if ( foundImgView == frame.imageViews.end() ) {
+								logger.error( "Could not find image view for image: '%s', ignoring image binding command.",
+								              le_cmd->info.image_id->data->debug_name );
+								break;
+							}
+
+							// ----------| invariant: image view has been found
+
+							// FIXME: (sync) image layout at this point *must* be general, if we wanted to write to this image.
+							bindingData->imageInfo.imageLayout = le::ImageLayout::eGeneral;
+							bindingData->imageInfo.imageView   = foundImgView->second;
+
+							bindingData->type       = le::DescriptorType::eStorageImage;
+							bindingData->arrayIndex = uint32_t( le_cmd->info.array_index );
+						} else {
+							logger.error( "Could not find binding at set: %d, binding: %d.", b->setIndex, b->binding );
+							assert( bindingData && "Could not find specified binding" );
+						}
+
+					} break;
+					case le::CommandType::eSetArgumentTlas: {
+						auto*    le_cmd           = static_cast<le::CommandSetArgumentTlas*>( dataIt );
+						uint64_t argument_name_id = le_cmd->info.argument_name_id;
+
+						// Find binding info with name referenced in command
+						auto b = argumentState.binding_infos.begin();
+
+						for ( ; b != argumentState.binding_infos.end(); b++ ) {
+							if ( b->name_hash == argument_name_id ) {
+								break;
+							}
+						}
+
+						if ( b == argumentState.binding_infos.end() ) {
+							logger.warn( "Invalid tlas argument name id: %x", argument_name_id );
+							break;
+						}
+
+						// ---------| invariant: we found an argument name that matches
+
+						auto bindingData =
+						    find_descriptor_with_binding_number_and_array_idx(
+						        argumentState.setData[ b->setIndex ], b->binding );
+
+						if ( bindingData ) {
+							auto found_resource = frame.availableResources.find( le_cmd->info.tlas_id );
+							if ( found_resource == frame.availableResources.end() ) {
+								logger.error( "Could not find acceleration structure: '%s'. Ignoring top level acceleration structure binding command.", le_cmd->info.tlas_id->data->debug_name );
+								break;
+							}
+
+							// ----------| invariant: acceleration structure has been found
+
+							bindingData->accelerationStructureInfo.accelerationStructure = found_resource->second.as.tlas;
+							bindingData->type                                            = le::DescriptorType::eAccelerationStructureKhr;
+							bindingData->arrayIndex                                      = uint32_t( le_cmd->info.array_index );
+						} else {
+							logger.error( "Could not find binding at set: %d, binding: %d.", b->setIndex, b->binding );
+						}
+
+					} break;
+					case le::CommandType::eBindIndexBuffer: {
+						auto* le_cmd = static_cast<le::CommandBindIndexBuffer*>( dataIt );
+						auto  buffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.buffer );
+						vkCmdBindIndexBuffer( cmd, buffer, le_cmd->info.offset, static_cast<VkIndexType>( le_cmd->info.indexType ) );
+					} break;
+
+					case le::CommandType::eBindVertexBuffers: {
+						auto* le_cmd = static_cast<le::CommandBindVertexBuffers*>( dataIt );
+
+						uint32_t firstBinding = le_cmd->info.firstBinding;
+						uint32_t numBuffers   = le_cmd->info.bindingCount;
+
+						assert( numBuffers && "must at least have one buffer to bind." );
+
+						// Bind vertex buffers by looking up le resources and matching them with their corresponding
+						// vk resources.
+
+						// First, we must relocate pointers into the command stream - we know that this command
+						// is immediately followed by its payload on the command stream.
+
+						// The payload is two tightly packed arrays
+						// - le_buf_handle[bindingCount]
+						// - uint64_t[bindingCount]
+
+						le_buf_resource_handle* p_buffers = ( le_buf_resource_handle* )( le_cmd + 1 );
+						uint64_t*               p_offsets = ( uint64_t* )( p_buffers + le_cmd->info.bindingCount );
+
+						le_buf_resource_handle le_buffer = *p_buffers;
+
+						VkBuffer vk_buffer                  = frame_data_get_buffer_from_le_resource_id( frame, le_buffer );
+						vertexInputBindings[ firstBinding ] = vk_buffer;
+
+						for ( uint32_t b = 1; b != numBuffers; ++b ) {
+							// We optimise for the likely case that the same resource is given a number of times:
+							// we cache the last lookup of a vk_resource, and if the same le_resource is requested again,
+							// we can use the cached value instead of having to do a lookup.
+							le_buf_resource_handle next_buffer = p_buffers[ b ];
+							if ( next_buffer != le_buffer ) {
+								le_buffer = next_buffer;
+								vk_buffer = frame_data_get_buffer_from_le_resource_id( frame, le_buffer );
+							}
+							vertexInputBindings[ b + firstBinding ] = vk_buffer;
+						}
+
+						vkCmdBindVertexBuffers( cmd, le_cmd->info.firstBinding, le_cmd->info.bindingCount, &vertexInputBindings[ firstBinding ], p_offsets );
+					} break;
+
+					case le::CommandType::eWriteToBuffer: {
+
+						// Enqueue copy buffer command
+						// TODO: we must sync this before the next read.
+						auto* le_cmd = static_cast<le::CommandWriteToBuffer*>( dataIt );
+
+						VkBufferCopy region{
+						    .srcOffset = le_cmd->info.src_offset,
+						    .dstOffset = le_cmd->info.dst_offset,
+						    .size      = le_cmd->info.numBytes,
+						};
+
+						auto srcBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.src_buffer_id );
+						auto dstBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.dst_buffer_id );
+
+						vkCmdCopyBuffer( cmd, srcBuffer, dstBuffer, 1, &region );
+
+						break;
+					}
+
+					case le::CommandType::eWriteToImage: {
+
+						auto* le_cmd = static_cast<le::CommandWriteToImage*>( dataIt );
+
+						auto srcBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.src_buffer_id );
+						auto dstImage  = frame_data_get_image_from_le_resource_id( frame, le_cmd->info.dst_image_id );
+
+						// We define a range that covers all miplevels. this is useful as it allows us to transform
+						// Image layouts in bulk, covering the full mip chain.
+						VkImageSubresourceRange rangeAllRemainingMiplevels{
+						    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+						    .baseMipLevel   = le_cmd->info.dst_miplevel,
+						    .levelCount     = VK_REMAINING_MIP_LEVELS, // we want all miplevels to be in transferDstOptimal.
 						    .baseArrayLayer = le_cmd->info.dst_array_layer,
 						    .layerCount     = VK_REMAINING_ARRAY_LAYERS, // we want the range to encompass all layers
 						};
 
-						{
+						{
+
+							// Note: this barrier prepares the buffer resource for transfer read
+							VkBufferMemoryBarrier2 bufferTransferBarrier{
+							    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+							    .pNext               = nullptr,                          // optional
+							    .srcStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,     // any host operation
+							    .srcAccessMask       = VK_ACCESS_2_HOST_WRITE_BIT,       // make HostWrite memory available (flush host-write)
+							    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT, // must complete before transfer operation
+							    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,    // and it must be visible for transferRead - so that we might read
+							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .buffer              = srcBuffer,
+							    .offset              = le_cmd->info.src_offset,
+							    .size                = le_cmd->info.numBytes,
+							};
+
+							// Note: this barrier is to prepare the image resource for receiving data
+							VkImageMemoryBarrier2 imageLayoutToTransferDstOptimal{
+							    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+							    .pNext               = nullptr,                             // optional
+							    .srcStageMask        = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, // wait for nothing as no memory must be made available
+							    .srcAccessMask       = {},                                  // no memory must be made available - our image is garbage data at first
+							    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,    // layout transiton must complete before transfer operation
+							    .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,      // make memory visible to transferWrite - so that we may write
+							    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+							    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .image               = dstImage,
+							    .subresourceRange    = rangeAllRemainingMiplevels,
+							};
+							VkDependencyInfo dependency_info{
+							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+							    .pNext                    = nullptr,
+							    .dependencyFlags          = 0,
+							    .memoryBarrierCount       = 0,
+							    .pMemoryBarriers          = 0,
+							    .bufferMemoryBarrierCount = 1,
+							    .pBufferMemoryBarriers    = &bufferTransferBarrier,
+							    .imageMemoryBarrierCount  = 1,
+							    .pImageMemoryBarriers     = &imageLayoutToTransferDstOptimal,
+							};
+
+							vkCmdPipelineBarrier2( cmd, &dependency_info );
+						}
+
+						{
+							// Copy data for first mip level from buffer to image.
+							//
+							// Then use the first mip level as a source for subsequent mip levels.
+							// When copying from a lower mip level to a higher mip level, we must make
+							// sure to add barriers, as these blit operations are transfers.
+							//
+
+							VkImageSubresourceLayers imageSubresourceLayers{
+							    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+							    .mipLevel       = 0,
+							    .baseArrayLayer = le_cmd->info.dst_array_layer,
+							    .layerCount     = 1,
+							};
+
+							VkBufferImageCopy region{
+							    .bufferOffset      = le_cmd->info.src_offset,             // offset of staging range within staging buffer
+							    .bufferRowLength   = 0,                                   // 0 means tightly packed
+							    .bufferImageHeight = 0,                                   // 0 means tightly packed
+							    .imageSubresource  = std::move( imageSubresourceLayers ), // stored inline
+							    .imageOffset =
+							        { .x = le_cmd->info.offset_x,
+							          .y = le_cmd->info.offset_y,
+							          .z = le_cmd->info.offset_z },
+							    .imageExtent =
+							        { .width  = le_cmd->info.image_w,
+							          .height = le_cmd->info.image_h,
+							          .depth  = le_cmd->info.image_d } };
+							;
+
+							vkCmdCopyBufferToImage( cmd, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+						}
+
+						if ( le_cmd->info.num_miplevels > 1 ) {
+
+							// We generate additional miplevels by issueing scaled blits from one image subresource to the
+							// next higher mip level subresource.
+
+							// For this to work, we must first make sure that the image subresource we just wrote to
+							// is ready to be read back. We do this by issueing a read-after-write barrier, and with
+							// the same barrier we also transition the source subresource image to transfer_src_optimal
+							// layout (which is a requirement for blitting operations)
+							//
+							// The target image subresource is already in layout transfer_dst_optimal, as this is the
+							// layout we applied to the whole mip chain when
+
+							const uint32_t base_miplevel = le_cmd->info.dst_miplevel;
+							{
+								VkImageMemoryBarrier2 prepareBlit{
+								    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+								    .pNext               = nullptr,                              //
+								    .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     //
+								    .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,       // make transfer write memory available (flush) to layout transition
+								    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     //
+								    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make cache (after layout transition) visible to transferRead op
+								    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // layout transition from transfer dst optimal,
+								    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to shader readonly optimal - note: implicitly makes memory available
+								    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+								    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+								    .image               = dstImage,
+								    .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, base_miplevel, 1, 0, 1 },
+								};
+
+								VkDependencyInfo dependency_info{
+								    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+								    .pNext                    = nullptr,
+								    .dependencyFlags          = 0,
+								    .memoryBarrierCount       = 0,
+								    .pMemoryBarriers          = 0,
+								    .bufferMemoryBarrierCount = 0,
+								    .pBufferMemoryBarriers    = 0,
+								    .imageMemoryBarrierCount  = 1,
+								    .pImageMemoryBarriers     = &prepareBlit,
+								};
+
+								vkCmdPipelineBarrier2( cmd, &dependency_info );
+							}
+							// Now blit from the srcMipLevel to dstMipLevel
+
+							int32_t srcImgWidth  = int32_t( le_cmd->info.image_w );
+							int32_t srcImgHeight = int32_t( le_cmd->info.image_h );
+
+							for ( uint32_t dstMipLevel = le_cmd->info.dst_miplevel + 1; dstMipLevel < le_cmd->info.num_miplevels; dstMipLevel++ ) {
+
+								// Blit from lower mip level into next higher mip level
+								auto srcMipLevel = dstMipLevel - 1;
+
+								// Calculate width and height for next image in mip chain as half the corresponding source
+								// image dimension, unless dimension is smaller or equal to 2, in which case clamp to 1.
+								auto dstImgWidth  = srcImgWidth > 2 ? srcImgWidth >> 1 : 1;
+								auto dstImgHeight = srcImgHeight > 2 ? srcImgHeight >> 1 : 1;
+
+								VkOffset3D  offsetZero = { .x = 0, .y = 0, .z = 0 };
+								VkOffset3D  offsetSrc  = { .x = srcImgWidth, .y = srcImgHeight, .z = 1 };
+								VkOffset3D  offsetDst  = { .x = dstImgWidth, .y = dstImgHeight, .z = 1 };
+								VkImageBlit region{
+								    .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, srcMipLevel, 0, 1 },
+								    .srcOffsets     = { offsetZero, offsetSrc },
+								    .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, dstMipLevel, 0, 1 },
+								    .dstOffsets     = { offsetZero, offsetDst },
+								};
+
+								vkCmdBlitImage(
+								    cmd,
+								    dstImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+								    dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+								    1, &region, VK_FILTER_LINEAR );
+
+								// Now we barrier Read after Write, and transition our freshly blitted subresource to transferSrc,
+								// so that the next iteration may read from it.
+
+								{
+									VkImageMemoryBarrier2 finishBlit{
+									    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+									    .pNext               = nullptr,                              // optional
+									    .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     // wait on transfer op
+									    .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,       // flush transfer writes so that memory becomes available to layout transition
+									    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     // before next transfer op
+									    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make transitioned image visible to subsequent transfer read ops
+									    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // transition from transfer dst optimal
+									    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to shader readonly optimal
+									    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+									    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+									    .image               = dstImage,
+									    .subresourceRange    = {
+									           .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+									           .baseMipLevel   = dstMipLevel,
+									           .levelCount     = 1,
+									           .baseArrayLayer = 0,
+									           .layerCount     = 1,
+                                        },
+									};
+
+									VkDependencyInfo dependency_info{
+									    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+									    .pNext                    = nullptr,
+									    .dependencyFlags          = 0,
+									    .memoryBarrierCount       = 0,
+									    .pMemoryBarriers          = 0,
+									    .bufferMemoryBarrierCount = 0,
+									    .pBufferMemoryBarriers    = 0,
+									    .imageMemoryBarrierCount  = 1,
+									    .pImageMemoryBarriers     = &finishBlit,
+									};
+
+									vkCmdPipelineBarrier2( cmd, &dependency_info );
+								}
+
+								// Store this miplevel image's dimensions for next iteration
+								srcImgHeight = dstImgHeight;
+								srcImgWidth  = dstImgWidth;
+							}
+
+						} // end if mipLevelCount > 1
+
+						// Transition image from transfer src optimal to shader read only optimal layout
+
+						{
+							VkImageMemoryBarrier2 imageLayoutToShaderReadOptimal{
+							    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+							    .pNext               = nullptr,
+							    .srcStageMask        = 0,
+							    .srcAccessMask       = 0,
+							    .dstStageMask        = 0,
+							    .dstAccessMask       = 0,
+							    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+							    .newLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+							    .image               = dstImage,
+							    .subresourceRange    = rangeAllRemainingMiplevels,
+							};
+							;
+
+							if ( le_cmd->info.num_miplevels > 1 ) {
+
+								// If there were additional miplevels, the miplevel generation logic ensures that all subresources
+								// are left in transfer_src layout.
+
+								imageLayoutToShaderReadOptimal.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;         // anything in transfer must happen-before
+								imageLayoutToShaderReadOptimal.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;  // anything that fragment shader does
+								imageLayoutToShaderReadOptimal.srcAccessMask = {};                                       // no memory needs to be made available - nothing to flush, as previous barriers ensure flush
+								imageLayoutToShaderReadOptimal.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;              // make layout transitioned image visible to shader read in FragmentShader stage
+								imageLayoutToShaderReadOptimal.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;     // transition from transfer src optimal
+								imageLayoutToShaderReadOptimal.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // ...to shader readonly optimal -and make transitioned image available;
+							} else {
+
+								// If there are no additional miplevels, the single subresource will still be in
+								// transfer_dst layout after pixel data was uploaded to it.
+
+								imageLayoutToShaderReadOptimal.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;         // anything in transfer must happen-before
+								imageLayoutToShaderReadOptimal.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;  // anything in fragment shader
+								imageLayoutToShaderReadOptimal.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;           // make available what is in transferwrite - image layout transition will need it
+								imageLayoutToShaderReadOptimal.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;              // make visible the result of the image layout transition to shader read in FragmentShader stage
+								imageLayoutToShaderReadOptimal.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;     // transition the single one subresource , which is in transfer dst optimal...
+								imageLayoutToShaderReadOptimal.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // ... to shader readonly optimal -and make the transitioned image available;
+								;
+							}
+
+							VkDependencyInfo dependency_info{
+							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+							    .pNext                    = nullptr,
+							    .dependencyFlags          = 0,
+							    .memoryBarrierCount       = 0,
+							    .pMemoryBarriers          = 0,
+							    .bufferMemoryBarrierCount = 0,
+							    .pBufferMemoryBarriers    = 0,
+							    .imageMemoryBarrierCount  = 1,
+							    .pImageMemoryBarriers     = &imageLayoutToShaderReadOptimal,
+							};
+
+							vkCmdPipelineBarrier2( cmd, &dependency_info ); // images: prepare for shader read
+						}
+
+						break;
+					}
+					case le::CommandType::eBuildRtxBlas: {
+						auto* le_cmd = static_cast<le::CommandBuildRtxBlas*>( dataIt );
+
+						size_t     num_blas_handles  = le_cmd->info.blas_handles_count;
+						auto const blas_handle_begin = reinterpret_cast<le_resource_handle*>( le_cmd + 1 );
+
+						auto const blas_end = blas_handle_begin + num_blas_handles;
+
+						VkBuffer scratchBuffer = frame_data_get_buffer_from_le_resource_id( frame, LE_RTX_SCRATCH_BUFFER_HANDLE );
+
+						for ( auto blas_handle = blas_handle_begin; blas_handle != blas_end; blas_handle++ ) {
+
+							auto const&                allocated_resource        = frame.availableResources.at( *blas_handle );
+							VkAccelerationStructureKHR vk_acceleration_structure = allocated_resource.as.blas;
+							auto                       blas_info                 = reinterpret_cast<le_rtx_blas_info_o*>( allocated_resource.info.blasInfo.handle );
+
+							// Translate geometry info from internal format toVkgeometryKHR format.
+							// We do this for each blas, which in turn may have an array of geometries.
+
+							std::vector<VkAccelerationStructureGeometryKHR> geometries;
+							geometries.reserve( blas_info->geometries.size() );
+
+							std::vector<VkAccelerationStructureBuildRangeInfoKHR> build_ranges;
+							build_ranges.reserve( blas_info->geometries.size() );
+
+							for ( auto const& g : blas_info->geometries ) {
+
+								// TODO: we may want to cache this - so that we don't have to lookup addresses more than once
+
+								VkBuffer vertex_buffer = frame_data_get_buffer_from_le_resource_id( frame, g.vertex_buffer );
+								VkBuffer index_buffer  = frame_data_get_buffer_from_le_resource_id( frame, g.index_buffer );
+
+								VkDeviceOrHostAddressConstKHR vertex_addr = { .deviceAddress = 0 };
+								VkDeviceOrHostAddressConstKHR index_addr  = { .deviceAddress = 0 };
+
+								{
+									VkBufferDeviceAddressInfo info = {
+									    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+									    .pNext  = nullptr, // optional
+									    .buffer = vertex_buffer,
+									};
+
+									vertex_addr.deviceAddress = g.vertex_offset + vkGetBufferDeviceAddress( device, &info );
+								}
+
+								{
+									VkBufferDeviceAddressInfo info = {
+									    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+									    .pNext  = nullptr, // optional
+									    .buffer = index_buffer,
+									};
+									index_addr.deviceAddress =
+									    g.index_count
+									        ? g.index_offset + vkGetBufferDeviceAddress( device, &info )
+									        : 0;
+								}
+
+								VkAccelerationStructureGeometryKHR geometry = {
+								    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+								    .pNext        = nullptr, // optional
+								    .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
+								    .geometry     = {
+								            .triangles = {
+								                .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
+								                .pNext         = nullptr, // optional
+								                .vertexFormat  = VkFormat( g.vertex_format ),
+								                .vertexData    = vertex_addr,
+								                .vertexStride  = g.vertex_stride,
+								                .maxVertex     = g.vertex_count - 1, // highest index of a vertex that will be accessed via build command
+								                .indexType     = VkIndexType( g.index_type ),
+								                .indexData     = index_addr,
+								                .transformData = {}, // no transform data
+                                        } },
+								    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
+								};
+
+								geometries.emplace_back( geometry );
+
+								VkAccelerationStructureBuildRangeInfoKHR build_range = {
+								    .primitiveCount  = 0,
+								    .primitiveOffset = 0,
+								    .firstVertex     = 0,
+								    .transformOffset = 0,
+								};
+
+								if ( g.index_count ) {
+									// indexed geometry
+									build_range.primitiveCount = g.index_count / 3;
+								} else {
+									// non-indexed geometry
+									build_range.primitiveCount = g.vertex_count / 3;
+								}
+
+								build_ranges.emplace_back( build_range );
+							}
+
+							VkAccelerationStructureBuildRangeInfoKHR const* pBuildRangeInfos = build_ranges.data();
+
+							VkDeviceOrHostAddressKHR scratchDataAddr = {};
+							//  We get the device address by querying from the buffer.
+							{
+								VkBufferDeviceAddressInfo info = {
+								    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+								    .pNext  = nullptr, // optional
+								    .buffer = scratchBuffer,
+								};
+
+								scratchDataAddr.deviceAddress = vkGetBufferDeviceAddress( device, &info );
+							}
+
+							VkAccelerationStructureBuildGeometryInfoKHR info = {
+							    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+							    .pNext                    = nullptr, // optional
+							    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+							    .flags                    = blas_info->flags, // optional
+							    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+							    .srcAccelerationStructure = nullptr,                       // optional
+							    .dstAccelerationStructure = vk_acceleration_structure,     // optional
+							    .geometryCount            = uint32_t( geometries.size() ), // optional
+							    .pGeometries              = geometries.data(),             // optional
+							    .ppGeometries             = 0,
+							    .scratchData              = scratchDataAddr,
+							};
+
+							vkCmdBuildAccelerationStructuresKHR( cmd, 1, &info, &pBuildRangeInfos );
+
+							// Since the scratch buffer is reused across builds, we need a barrier to ensure one build
+							// is finished before starting the next one - theoretically we could limit this to the scratch
+							// buffer by issueing a buffer memory barrier, but since no one else will probably use the
+							// acceleration structure memory caches, we should be fine with this more general barrier.
+
+							{
+								VkMemoryBarrier2 barrier = {
+								    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+								    .pNext         = nullptr,                                                  // optional
+								    .srcStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, //
+								    .srcAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,         // make anything written in previous acceleration structure build stage available
+								    .dstStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, // before the next acceleration build stage
+								    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR,          // memory which has been previously written (and made available) must be visible after the barrier
+								};
+								VkDependencyInfo dependency_info = {
+								    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+								    .pNext                    = nullptr, // optional
+								    .dependencyFlags          = 0,       // optional
+								    .memoryBarrierCount       = 1,       // optional
+								    .pMemoryBarriers          = &barrier,
+								    .bufferMemoryBarrierCount = 0, // optional
+								    .pBufferMemoryBarriers    = 0,
+								    .imageMemoryBarrierCount  = 0,
+								    .pImageMemoryBarriers     = 0,
+								};
+
+								vkCmdPipelineBarrier2( cmd, &dependency_info );
+							}
+
+						} // end for each blas element in array
+
+						break;
+					}
+					case le::CommandType::eBuildRtxTlas: {
+						auto*                       le_cmd              = static_cast<le::CommandBuildRtxTlas*>( dataIt );
+						void*                       payload_addr        = le_cmd + 1;
+						le_resource_handle const*   resources           = static_cast<le_resource_handle*>( payload_addr );
+						void*                       scratch_memory_addr = le_cmd->info.staging_buffer_mapped_memory;
+						le_rtx_geometry_instance_t* instances           = static_cast<le_rtx_geometry_instance_t*>( scratch_memory_addr );
+
+						// Foreach resource, we must patch the corresponding instance
+
+						const size_t instances_count = le_cmd->info.geometry_instances_count;
+
+						// TODO: Error checking: we should skip this command and issue a
+						// warning if any blas resource could not be found.
+
+						for ( size_t i = 0; i != instances_count; i++ ) {
+							// Update blas handles in-place on GPU mapped, coherent memory.
+							//
+							// The 64bit integer handles for bottom level acceleration structures were queried from the GPU when
+							// building bottom level acceleration structures.
+							instances[ i ].blas_handle = frame.availableResources.at( resources[ i ] ).info.blasInfo.device_address;
+						}
+
+						// Invariant: all instances should be patched right now, we can use the buffer at offset as
+						// instance data to build tlas.
+						auto const&                allocated_resource        = frame.availableResources.at( le_cmd->info.tlas_handle );
+						VkAccelerationStructureKHR vk_acceleration_structure = allocated_resource.as.tlas;
+						auto                       tlas_info                 = reinterpret_cast<le_rtx_tlas_info_o*>( allocated_resource.info.tlasInfo.handle );
+
+						// Issue barrier to make sure that transfer to instances buffer is complete
+						// before building top-level acceleration structure
+
+						{
+							VkMemoryBarrier2 barrier = {
+							    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+							    .pNext         = nullptr,                                                  //
+							    .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,                         // transfer must happen before barrier
+							    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,                           // anything written in transfer must have been made available
+							    .dstStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, // acceleration structure build must happen-after barrier
+							    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,         // and memory must have been made visible to acceleration structure write
+							};
+							VkDependencyInfo dependency_info = {
+							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+							    .pNext                    = nullptr, // optional
+							    .dependencyFlags          = 0,       // optional
+							    .memoryBarrierCount       = 1,       // optional
+							    .pMemoryBarriers          = &barrier,
+							    .bufferMemoryBarrierCount = 0, // optional
+							    .pBufferMemoryBarriers    = 0,
+							    .imageMemoryBarrierCount  = 0, // optional
+							    .pImageMemoryBarriers     = 0,
+							};
+							vkCmdPipelineBarrier2( cmd, &dependency_info );
+						}
+
+						// instances information is encoded via buffer, but that buffer is also available as host memory,
+						// because it is held in staging_buffer_mapped_memory...
+						VkBuffer instanceBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.staging_buffer_id );
+						VkBuffer scratchBuffer  = frame_data_get_buffer_from_le_resource_id( frame, LE_RTX_SCRATCH_BUFFER_HANDLE );
+
+						VkDeviceOrHostAddressConstKHR instanceBufferDeviceAddress = {};
+
+						{
+							VkBufferDeviceAddressInfo info = {
+							    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+							    .pNext  = nullptr, // optional
+							    .buffer = instanceBuffer,
+							};
+
+							instanceBufferDeviceAddress.deviceAddress =
+							    le_cmd->info.staging_buffer_offset +
+							    vkGetBufferDeviceAddress( device, &info );
+						}
+
+						VkAccelerationStructureGeometryKHR khr_instances_data = {
+						    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+						    .pNext        = nullptr, // optional
+						    .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
+						    .geometry     = {
+						            .instances = {
+						                .sType           = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
+						                .pNext           = nullptr, // optional
+						                .arrayOfPointers = false,
+						                .data            = instanceBufferDeviceAddress,
+                                } },
+						    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
+						};
+						// Take pointer to array of khr_instances - we will need one further indirection because reasons.
+
+						//  we get the device address by querying from the buffer.
+						VkDeviceOrHostAddressKHR scratch_data_addr = {};
+						{
+							VkBufferDeviceAddressInfo info = {
+							    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+							    .pNext  = nullptr, // optional
+							    .buffer = scratchBuffer,
+							};
+							scratch_data_addr.deviceAddress = vkGetBufferDeviceAddress( device, &info );
+						}
+						VkAccelerationStructureBuildGeometryInfoKHR info = {
+						    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+						    .pNext                    = nullptr, // optional
+						    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+						    .flags                    = tlas_info->flags, // optional
+						    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+						    .srcAccelerationStructure = 0,                         // optional
+						    .dstAccelerationStructure = vk_acceleration_structure, // optional
+						    .geometryCount            = 1,                         // optional
+						    .pGeometries              = &khr_instances_data,       // optional
+						    .ppGeometries             = 0,
+						    .scratchData              = scratch_data_addr,
+						};
+
+						VkAccelerationStructureBuildRangeInfoKHR build_ranges = {
+						    .primitiveCount  = tlas_info->instances_count, // This is where we set the number of instances.
+						    .primitiveOffset = 0,                          // spec states: must be a multiple of 16?!!
+						    .firstVertex     = 0,
+						    .transformOffset = 0,
+						};
+
+						VkAccelerationStructureBuildRangeInfoKHR* p_build_ranges = &build_ranges;
+
+						vkCmdBuildAccelerationStructuresKHR( cmd, 1, &info, &p_build_ranges );
+
+						break;
+					}
+					default: {
+						assert( false && "command not handled" );
+					}
+					} // end switch header.info.type
+
+					// Move iterator by size of current le_command so that it points
+					// to the next command in the list.
+					dataIt = static_cast<char*>( dataIt ) + header->info.size;
+
+					++commandIndex;
+				}
+
+				le_pipeline_manager_i.add_skipped_draws( pipelineManager, numSkippedDraws );
+			}
+
+			// non-draw passes don't need renderpasses.
+			if ( pass.type == le::QueueFlagBits::eGraphics && pass.renderPass ) {
+				vkCmdEndRenderPass( cmd );
+			}
+
+			if ( gpu_query_idx != uint32_t( ~0 ) ) {
+				if ( frame.gpu_pass_queries[ gpu_query_idx ].has_statistics ) {
+					vkCmdEndQuery( cmd, frame.gpu_statistics_pool, gpu_query_idx );
+				}
+				vkCmdWriteTimestamp2( cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, frame.gpu_timestamp_pool, 2 * gpu_query_idx + 1 );
+			}
+
+			if ( SHOULD_INSERT_DEBUG_LABELS ) {
+				vkCmdEndDebugUtilsLabelEXT( cmd );
+			}
+
+			vkEndCommandBuffer( cmd );
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+// This method gets called once per frame (via renderer.update()) in order
+// to poll shader modules for updates
+static void backend_update_shader_modules( le_backend_o* self ) {
+	using namespace le_backend_vk;
+	le_pipeline_manager_i.update_shader_modules( self->pipelineCache );
+}
+
+// ----------------------------------------------------------------------
+static le_shader_module_handle backend_create_shader_module(
+    le_backend_o*                     self,
+    char const*                       path,
+    const LeShaderSourceLanguageEnum& shader_source_language,
+    const le::ShaderStageFlagBits&    moduleType,
+    char const*                       macro_definitions,
+    le_shader_module_handle           handle,
+    VkSpecializationMapEntry const*   specialization_map_entries,
+    uint32_t                          specialization_map_entries_count,
+    void*                             specialization_map_data,
+    uint32_t                          specialization_map_data_num_bytes ) {
+
+	using namespace le_backend_vk;
+	return le_pipeline_manager_i.create_shader_module(
+	    self->pipelineCache,
+	    path,
+	    shader_source_language,
+	    moduleType,
+	    macro_definitions,
+	    handle,
+	    specialization_map_entries,
+	    specialization_map_entries_count,
+	    specialization_map_data,
+	    specialization_map_data_num_bytes );
+}
+
+// ----------------------------------------------------------------------
+
+static le_pipeline_manager_o* backend_get_pipeline_cache( le_backend_o* self ) {
+	return self->pipelineCache;
+}
+
+// ----------------------------------------------------------------------
+// Return a pointer to a queue info structure holding the queue
+// which we use for default graphics operations. This is also
+// the queue which is used for swapchain present.
+static BackendQueueInfo* backend_get_default_graphics_queue_info( le_backend_o* self ) {
+
+	assert( !self->queues.empty() && "No queues available; Cannot retrieve default graphics queue" );
+	// -----------| Invariant: queue available
+
+	static auto result = self->queues[ self->queue_default_graphics_idx ];
+
+	// It's safe to return a pointer to a vector element, and to cache it here,
+	// as `self->queues` is constant once a device has been created.
+	// There is no way to add or remove queues at a later stage because queues
+	// are owned by device.
+
+	return result;
+}
+
+struct QueueSubmissionLoggerData {
+
+	struct info_t {
+		uint32_t value;
+		uint32_t semaphore_id;
+	};
+
+	struct submission_t {
+		BackendQueueInfo*   queue;
+		std::string         label;
+		std::vector<info_t> wait_semaphores;
+		std::vector<info_t> signal_semaphores;
+	};
 
-							// Note: this barrier prepares the buffer resource for transfer read
-							VkBufferMemoryBarrier2 bufferTransferBarrier{
-							    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-							    .pNext               = nullptr,                          // optional
-							    .srcStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,     // any host operation
-							    .srcAccessMask       = VK_ACCESS_2_HOST_WRITE_BIT,       // make HostWrite memory available (flush host-write)
-							    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT, // must complete before transfer operation
-							    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,    // and it must be visible for transferRead - so that we might read
-							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .buffer              = srcBuffer,
-							    .offset              = 0, // we assume a fresh buffer was allocated, so offset must be 0
-							    .size                = le_cmd->info.numBytes,
-							};
+	std::vector<submission_t> submissions;
+};
 
-							// Note: this barrier is to prepare the image resource for receiving data
-							VkImageMemoryBarrier2 imageLayoutToTransferDstOptimal{
-							    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-							    .pNext               = nullptr,                             // optional
-							    .srcStageMask        = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, // wait for nothing as no memory must be made available
-							    .srcAccessMask       = {},                                  // no memory must be made available - our image is garbage data at first
-							    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,    // layout transiton must complete before transfer operation
-							    .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,      // make memory visible to transferWrite - so that we may write
-							    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-							    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .image               = dstImage,
-							    .subresourceRange    = rangeAllRemainingMiplevels,
-							};
-							VkDependencyInfo dependency_info{
-							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-							    .pNext                    = nullptr,
-							    .dependencyFlags          = 0,
-							    .memoryBarrierCount       = 0,
-							    .pMemoryBarriers          = 0,
-							    .bufferMemoryBarrierCount = 1,
-							    .pBufferMemoryBarriers    = &bufferTransferBarrier,
-							    .imageMemoryBarrierCount  = 1,
-							    .pImageMemoryBarriers     = &imageLayoutToTransferDstOptimal,
-							};
+std::unordered_map<VkSemaphore, uint32_t>* get_semaphore_indices() {
+	static std::unordered_map<VkSemaphore, uint32_t> semaphore_index;
+	return &semaphore_index;
+}
+std::vector<std::string>* get_semaphore_names() {
+	static std::vector<std::string> semaphore_names;
+	return &semaphore_names;
+}
+QueueSubmissionLoggerData* get_queue_submission_logger_data() {
+	static QueueSubmissionLoggerData data;
+	return &data;
+}
 
-							vkCmdPipelineBarrier2( cmd, &dependency_info );
-						}
+std::vector<std::string>* backend_initialise_semaphore_names( le_backend_o const* backend ) {
 
-						{
-							// Copy data for first mip level from buffer to image.
-							//
-							// Then use the first mip level as a source for subsequent mip levels.
-							// When copying from a lower mip level to a higher mip level, we must make
-							// sure to add barriers, as these blit operations are transfers.
-							//
+	auto semaphore_names   = get_semaphore_names();
+	auto semaphore_indices = get_semaphore_indices();
 
-							VkImageSubresourceLayers imageSubresourceLayers{
-							    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-							    .mipLevel       = 0,
-							    .baseArrayLayer = le_cmd->info.dst_array_layer,
-							    .layerCount     = 1,
-							};
+	char img_name_c_str[ 80 ];
 
-							VkBufferImageCopy region{
-							    .bufferOffset      = 0,                                   // buffer offset is 0, since staging buffer is a fresh, specially allocated buffer
-							    .bufferRowLength   = 0,                                   // 0 means tightly packed
-							    .bufferImageHeight = 0,                                   // 0 means tightly packed
-							    .imageSubresource  = std::move( imageSubresourceLayers ), // stored inline
-							    .imageOffset =
-							        { .x = le_cmd->info.offset_x,
-							          .y = le_cmd->info.offset_y,
-							          .z = le_cmd->info.offset_z },
-							    .imageExtent =
-							        { .width  = le_cmd->info.image_w,
-							          .height = le_cmd->info.image_h,
-							          .depth  = le_cmd->info.image_d } };
-							;
+	for ( auto const& f : backend->mFrames ) {
+		for ( auto const& [ swapchain_handle, swapchain_state ] : f.frame_owned_swapchain_state ) {
+			{
+				auto const& [ it, was_inserted ] = semaphore_indices->emplace( swapchain_state.presentComplete->semaphore, uint32_t( semaphore_indices->size() ) );
+				if ( was_inserted ) {
+					// if an element was inserted
+					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
+					semaphore_names->push_back( img_name_c_str );
+					assert( semaphore_names->size() == semaphore_indices->size() );
+				} else {
+					// we must update the element that was already present
+					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
+					( *semaphore_names )[ it->second ] = img_name_c_str;
+					assert( semaphore_names->size() == semaphore_indices->size() );
+				}
+			}
+			{
+				auto const& [ it, was_inserted ] = semaphore_indices->emplace( swapchain_state.renderComplete->semaphore, uint32_t( semaphore_indices->size() ) );
+				if ( was_inserted ) {
+					// if an element was inserted
+					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
+					semaphore_names->push_back( img_name_c_str );
+					assert( semaphore_names->size() == semaphore_indices->size() );
+				} else {
+					snprintf( img_name_c_str, sizeof( img_name_c_str ), "RENDER_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
+					( *semaphore_names )[ it->second ] = img_name_c_str;
+					assert( semaphore_names->size() == semaphore_indices->size() );
+				}
+			}
+		}
+	}
+	return semaphore_names;
+};
 
-							vkCmdCopyBufferToImage( cmd, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
-						}
+// ----------------------------------------------------------------------
 
-						if ( le_cmd->info.num_miplevels > 1 ) {
+static void backend_emit_queue_sync_dot_file( le_backend_o const* backend, uint64_t frame_number ) {
 
-							// We generate additional miplevels by issueing scaled blits from one image subresource to the
-							// next higher mip level subresource.
+	static std::filesystem::path exe_path = []() {
+		char result[ 1024 ] = { 0 };
 
-							// For this to work, we must first make sure that the image subresource we just wrote to
-							// is ready to be read back. We do this by issueing a read-after-write barrier, and with
-							// the same barrier we also transition the source subresource image to transfer_src_optimal
-							// layout (which is a requirement for blitting operations)
-							//
-							// The target image subresource is already in layout transfer_dst_optimal, as this is the
-							// layout we applied to the whole mip chain when
+#ifdef _MSC_VER
 
-							const uint32_t base_miplevel = le_cmd->info.dst_miplevel;
-							{
-								VkImageMemoryBarrier2 prepareBlit{
-								    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-								    .pNext               = nullptr,                              //
-								    .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     //
-								    .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,       // make transfer write memory available (flush) to layout transition
-								    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     //
-								    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make cache (after layout transition) visible to transferRead op
-								    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // layout transition from transfer dst optimal,
-								    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to shader readonly optimal - note: implicitly makes memory available
-								    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-								    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-								    .image               = dstImage,
-								    .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, base_miplevel, 1, 0, 1 },
-								};
+		// When NULL is passed to GetModuleHandle, the handle of the exe itself is returned
+		HMODULE hModule = GetModuleHandle( NULL );
+		if ( hModule != NULL ) {
+			// Use GetModuleFileName() with module handle to get the path
+			GetModuleFileName( hModule, result, ( sizeof( result ) ) );
+		}
+		size_t count = strnlen_s( result, sizeof( result ) );
+#else
+		ssize_t count = readlink( "/proc/self/exe", result, 1024 );
+#endif
 
-								VkDependencyInfo dependency_info{
-								    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-								    .pNext                    = nullptr,
-								    .dependencyFlags          = 0,
-								    .memoryBarrierCount       = 0,
-								    .pMemoryBarriers          = 0,
-								    .bufferMemoryBarrierCount = 0,
-								    .pBufferMemoryBarriers    = 0,
-								    .imageMemoryBarrierCount  = 1,
-								    .pImageMemoryBarriers     = &prepareBlit,
-								};
+		return std::string( result, ( count > 0 ) ? size_t( count ) : 0 );
+	}();
 
-								vkCmdPipelineBarrier2( cmd, &dependency_info );
-							}
-							// Now blit from the srcMipLevel to dstMipLevel
+	static QueueSubmissionLoggerData*               data = get_queue_submission_logger_data();
+	static std::unordered_map<VkQueue, std::string> queue_name;
+	std::vector<std::string>*                       semaphore_names = backend_initialise_semaphore_names( backend );
 
-							int32_t srcImgWidth  = int32_t( le_cmd->info.image_w );
-							int32_t srcImgHeight = int32_t( le_cmd->info.image_h );
+	std::ostringstream                     os;
+	std::unordered_map<uint64_t, uint32_t> wait_info_to_submission; // wait info to submission id
+	std::unordered_map<uint64_t, uint32_t> sign_info_to_submission; // signal info to submission id
+	uint32_t                               submission_id = 0;
 
-							for ( uint32_t dstMipLevel = le_cmd->info.dst_miplevel + 1; dstMipLevel < le_cmd->info.num_miplevels; dstMipLevel++ ) {
+	os << "digraph g {\n"
+	      "rankdir = LR;\n"
+	      "node [shape = plaintext; margin=0; height = 1; fontname = \"IBM Plex Sans\";];\n"
+	      "graph [label = <<table border='0' cellborder='0' cellspacing='0' cellpadding='3'>";
+	for ( size_t i = 0; i != backend->queues.size(); i++ ) {
 
-								// Blit from lower mip level into next higher mip level
-								auto srcMipLevel = dstMipLevel - 1;
+		os << "<tr><td align='left'>queue_" << i << " : {" << to_string_vk_queue_flags( backend->queues[ i ]->queue_flags ) << "}</td></tr>";
+	}
+	os << "<tr><td align='left'>\"" << exe_path.string() << "\"</td></tr>"
+	   << "<tr><td align='left'>Island Queue Sync @ Frame \xe2\x84\x96" << frame_number << "</td></tr>"
+	   << "</table>>; splines = true; nodesep = 0.7; fontname = \"IBM Plex Sans\"; fontsize = 10; labeljust = \"l\";];\n";
+	;
 
-								// Calculate width and height for next image in mip chain as half the corresponding source
-								// image dimension, unless dimension is smaller or equal to 2, in which case clamp to 1.
-								auto dstImgWidth  = srcImgWidth > 2 ? srcImgWidth >> 1 : 1;
-								auto dstImgHeight = srcImgHeight > 2 ? srcImgHeight >> 1 : 1;
+	// -- Go through each submission in sequence
+	for ( auto const& submission : data->submissions ) {
+		// each submission represents one queue submission
 
-								VkOffset3D  offsetZero = { .x = 0, .y = 0, .z = 0 };
-								VkOffset3D  offsetSrc  = { .x = srcImgWidth, .y = srcImgHeight, .z = 1 };
-								VkOffset3D  offsetDst  = { .x = dstImgWidth, .y = dstImgHeight, .z = 1 };
-								VkImageBlit region{
-								    .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, srcMipLevel, 0, 1 },
-								    .srcOffsets     = { offsetZero, offsetSrc },
-								    .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, dstMipLevel, 0, 1 },
-								    .dstOffsets     = { offsetZero, offsetDst },
-								};
+		os << "struct_" << submission_id << " [\n";
 
-								vkCmdBlitImage(
-								    cmd,
-								    dstImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-								    dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-								    1, &region, VK_FILTER_LINEAR );
+		auto queue_name_it = queue_name.emplace( submission.queue->queue, "" );
+		if ( queue_name_it.second == true ) {
+			// there was no entry there, yet
+
+			std::ostringstream oname;
+			{
+				size_t i = 0;
+				for ( ; i != backend->queues.size(); i++ ) {
+					if ( backend->queues[ i ] == submission.queue ) {
+						break;
+					}
+				}
+				if ( i != backend->queues.size() ) {
+				}
+				oname << "queue_" << i << " : ";
+			}
+
+			queue_name_it.first->second = oname.str();
+		}
+
+		os << "\tlabel = <\n";
+		os << "<table border=\"0\" cellborder=\"1\" cellspacing=\"0\" cellpadding=\"4\">\n\t<tr>";
+		os << "<td colspan=\"2\" port=\"port_struct_" << submission_id << "\">" << queue_name_it.first->second << "</td></tr>";
+		os << "\n\t<tr><td colspan=\"2\">" << submission.label << "</td></tr>";
+
+		{
+			auto w_it = submission.wait_semaphores.begin();
+			auto s_it = submission.signal_semaphores.begin();
+			do {
 
-								// Now we barrier Read after Write, and transition our freshly blitted subresource to transferSrc,
-								// so that the next iteration may read from it.
+				os << "\n\t<tr>";
+				if ( w_it != submission.wait_semaphores.end() ) {
+					os << "<td port=\"port_" << w_it->semaphore_id << "_w_" << w_it->value << "\">";
+					os << "S<sub><font point-size='9'>" << ( *semaphore_names )[ w_it->semaphore_id ] << "</font></sub> \xe2\x8c\x9b";
+					if ( ( *semaphore_names )[ w_it->semaphore_id ][ 0 ] <= '9' ) {
+						// only show value if we have a non-binary semaphore (that's a semaphore with an alphanumeric name)
+						os << w_it->value;
+					}
+					os << " ";
+					wait_info_to_submission.emplace( uint64( w_it->value ) << 32 | w_it->semaphore_id, submission_id );
+					w_it++;
+				} else {
+					os << "<td>";
+				}
+				os << "</td>";
+				if ( s_it != submission.signal_semaphores.end() ) {
+					os << "<td port=\"port_" << s_it->semaphore_id << "_s_" << s_it->value << "\">"
+					   << "S<sub><font point-size='9'>" << ( *semaphore_names )[ s_it->semaphore_id ] << "</font></sub> \xf0\x9f\x8f\x81 ";
+					if ( ( *semaphore_names )[ s_it->semaphore_id ][ 0 ] <= '9' ) {
+						// only show value if we have a non-binary semaphore (that's a semaphore with an alphanumeric name)
+						os << s_it->value << "";
+					}
+					sign_info_to_submission.emplace( uint64( s_it->value ) << 32 | s_it->semaphore_id, submission_id );
+					s_it++;
+				} else {
+					os << "<td>";
+				}
+				os << "</td></tr>";
+			} while ( w_it != submission.wait_semaphores.end() || s_it != submission.signal_semaphores.end() );
+		}
+		os << "\n</table>>];\n";
+		submission_id++;
+	}
 
-								{
-									VkImageMemoryBarrier2 finishBlit{
-									    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-									    .pNext               = nullptr,                              // optional
-									    .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     // wait on transfer op
-									    .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,       // flush transfer writes so that memory becomes available to layout transition
-									    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,     // before next transfer op
-									    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make transitioned image visible to subsequent transfer read ops
-									    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // transition from transfer dst optimal
-									    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to shader readonly optimal
-									    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-									    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-									    .image               = dstImage,
-									    .subresourceRange    = {
-									           .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-									           .baseMipLevel   = dstMipLevel,
-									           .levelCount     = 1,
-									           .baseArrayLayer = 0,
-									           .layerCount     = 1,
-                                        },
-									};
+	// for all the waits, find a matching signal
+	os << "\n";
 
-									VkDependencyInfo dependency_info{
-									    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-									    .pNext                    = nullptr,
-									    .dependencyFlags          = 0,
-									    .memoryBarrierCount       = 0,
-									    .pMemoryBarriers          = 0,
-									    .bufferMemoryBarrierCount = 0,
-									    .pBufferMemoryBarriers    = 0,
-									    .imageMemoryBarrierCount  = 1,
-									    .pImageMemoryBarriers     = &finishBlit,
-									};
+	for ( auto const& w : wait_info_to_submission ) {
+		auto it = sign_info_to_submission.find( w.first );
+		if ( it != sign_info_to_submission.end() ) {
 
-									vkCmdPipelineBarrier2( cmd, &dependency_info );
-								}
+			os << "\tstruct_" << it->second << ":port_" << ( it->first & ~uint32_t( 0 ) ) << "_s_" << ( it->first >> 32 ) << " -> "
+			   << "struct_" << w.second << ":port_" << ( w.first & ~uint32_t( 0 ) ) << "_w_" << ( w.first >> 32 ) << "\n";
+		}
+	}
 
-								// Store this miplevel image's dimensions for next iteration
-								srcImgHeight = dstImgHeight;
-								srcImgWidth  = dstImgWidth;
-							}
+	// we want to link back to the last submission on the same queue
+	{
+		os << "edge [style=dashed;];\n";
+		std::unordered_map<VkQueue, uint32_t> queue_to_last_submission;
+		uint32_t                              i = 0;
+		for ( auto const& s : data->submissions ) {
 
-						} // end if mipLevelCount > 1
+			auto it = queue_to_last_submission.emplace( s.queue->queue, i );
 
-						// Transition image from transfer src optimal to shader read only optimal layout
+			if ( it.second == false ) {
+				// there was already a previous entry for this queue
 
-						{
-							VkImageMemoryBarrier2 imageLayoutToShaderReadOptimal{
-							    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-							    .pNext               = nullptr,
-							    .srcStageMask        = 0,
-							    .srcAccessMask       = 0,
-							    .dstStageMask        = 0,
-							    .dstAccessMask       = 0,
-							    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-							    .newLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-							    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-							    .image               = dstImage,
-							    .subresourceRange    = rangeAllRemainingMiplevels,
-							};
-							;
+				os << "\tstruct_" << it.first->second << ":port_struct_" << it.first->second << " -> "
+				   << "\tstruct_" << i << ":port_struct_" << i << "\n";
 
-							if ( le_cmd->info.num_miplevels > 1 ) {
+				it.first->second = i;
+			}
 
-								// If there were additional miplevels, the miplevel generation logic ensures that all subresources
-								// are left in transfer_src layout.
+			i++;
+		}
+	}
 
-								imageLayoutToShaderReadOptimal.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;         // anything in transfer must happen-before
-								imageLayoutToShaderReadOptimal.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;  // anything that fragment shader does
-								imageLayoutToShaderReadOptimal.srcAccessMask = {};                                       // no memory needs to be made available - nothing to flush, as previous barriers ensure flush
-								imageLayoutToShaderReadOptimal.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;              // make layout transitioned image visible to shader read in FragmentShader stage
-								imageLayoutToShaderReadOptimal.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;     // transition from transfer src optimal
-								imageLayoutToShaderReadOptimal.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // ...to shader readonly optimal -and make transitioned image available;
-							} else {
+	os << "}\n";
 
-								// If there are no additional miplevels, the single subresource will still be in
-								// transfer_dst layout after pixel data was uploaded to it.
+	auto write_to_file = []( char const* filename, std::ostringstream const& os ) {
+		FILE* out_file = fopen( filename, "wb" );
+		fprintf( out_file, "%s\n", os.str().c_str() );
+		fclose( out_file );
 
-								imageLayoutToShaderReadOptimal.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;         // anything in transfer must happen-before
-								imageLayoutToShaderReadOptimal.dstStageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;  // anything in fragment shader
-								imageLayoutToShaderReadOptimal.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;           // make available what is in transferwrite - image layout transition will need it
-								imageLayoutToShaderReadOptimal.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;              // make visible the result of the image layout transition to shader read in FragmentShader stage
-								imageLayoutToShaderReadOptimal.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;     // transition the single one subresource , which is in transfer dst optimal...
-								imageLayoutToShaderReadOptimal.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // ... to shader readonly optimal -and make the transitioned image available;
-								;
-							}
+		le::Log( LOGGER_LABEL ).info( "Generated .dot file: '%s'", filename );
+	};
 
-							VkDependencyInfo dependency_info{
-							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-							    .pNext                    = nullptr,
-							    .dependencyFlags          = 0,
-							    .memoryBarrierCount       = 0,
-							    .pMemoryBarriers          = 0,
-							    .bufferMemoryBarrierCount = 0,
-							    .pBufferMemoryBarriers    = 0,
-							    .imageMemoryBarrierCount  = 1,
-							    .pImageMemoryBarriers     = &imageLayoutToShaderReadOptimal,
-							};
+	char filename[ 32 ] = "";
+	snprintf( filename, sizeof( filename ), "queues_%08zu.dot", frame_number );
 
-							vkCmdPipelineBarrier2( cmd, &dependency_info ); // images: prepare for shader read
-						}
+	std::filesystem::path full_path = exe_path.parent_path() / filename;
+	write_to_file( full_path.string().c_str(), os );
 
-						break;
-					}
-					case le::CommandType::eBuildRtxBlas: {
-						auto* le_cmd = static_cast<le::CommandBuildRtxBlas*>( dataIt );
+	std::error_code ec;
 
-						size_t     num_blas_handles  = le_cmd->info.blas_handles_count;
-						auto const blas_handle_begin = reinterpret_cast<le_resource_handle*>( le_cmd + 1 );
+	std::filesystem::path link_path = exe_path.parent_path() / "queues.dot";
+	if ( std::filesystem::exists( link_path ) ) {
+		std::filesystem::remove( link_path );
+	}
+	std::filesystem::create_symlink( full_path, link_path, ec );
 
-						auto const blas_end = blas_handle_begin + num_blas_handles;
+	auto error_str = ec.message();
 
-						VkBuffer scratchBuffer = frame_data_get_buffer_from_le_resource_id( frame, LE_RTX_SCRATCH_BUFFER_HANDLE );
+	data->submissions.clear();
+}
 
-						for ( auto blas_handle = blas_handle_begin; blas_handle != blas_end; blas_handle++ ) {
+// ----------------------------------------------------------------------
+// we log all parameters for a queue submission, so that we can generate queue sync dot files.
+static void backend_queue_submission_log( BackendQueueInfo* queue, VkSubmitInfo2 const* submitInfo, std::string const& debug_info ) {
 
-							auto const&                allocated_resource        = frame.availableResources.at( *blas_handle );
-							VkAccelerationStructureKHR vk_acceleration_structure = allocated_resource.as.blas;
-							auto                       blas_info                 = reinterpret_cast<le_rtx_blas_info_o*>( allocated_resource.info.blasInfo.handle );
+	{
+		static QueueSubmissionLoggerData* data = get_queue_submission_logger_data();
 
-							// Translate geometry info from internal format toVkgeometryKHR format.
-							// We do this for each blas, which in turn may have an array of geometries.
+		VkSemaphoreSubmitInfo const*       wait_info      = submitInfo->pWaitSemaphoreInfos;
+		VkSemaphoreSubmitInfo const* const wait_infos_end = wait_info + submitInfo->waitSemaphoreInfoCount;
+		VkSemaphoreSubmitInfo const*       sign_info      = submitInfo->pSignalSemaphoreInfos;
+		VkSemaphoreSubmitInfo const* const sign_infos_end = sign_info + submitInfo->signalSemaphoreInfoCount;
 
-							std::vector<VkAccelerationStructureGeometryKHR> geometries;
-							geometries.reserve( blas_info->geometries.size() );
+		static auto semaphore_index = get_semaphore_indices();
+		static auto semaphore_names = get_semaphore_names();
 
-							std::vector<VkAccelerationStructureBuildRangeInfoKHR> build_ranges;
-							build_ranges.reserve( blas_info->geometries.size() );
+		QueueSubmissionLoggerData::submission_t submission;
+		submission.queue = queue;
+		do {
+			if ( wait_info != wait_infos_end ) {
+				auto it = semaphore_index->emplace( wait_info->semaphore, uint32_t( semaphore_index->size() ) );
+				if ( it.second ) {
+					// if an element was inserted
+					semaphore_names->push_back( std::to_string( semaphore_names->size() ) );
+					assert( semaphore_names->size() == semaphore_index->size() );
+				}
+				uint32_t                          wait_semaphore_id = it.first->second;
+				QueueSubmissionLoggerData::info_t info;
+				info.semaphore_id = wait_semaphore_id;
+				info.value        = uint32_t( wait_info->value & ~uint32_t( 0 ) ); // truncate to 32 bit value
+				submission.wait_semaphores.emplace_back( std::move( info ) );
+				wait_info++;
+			}
+			if ( sign_info != sign_infos_end ) {
+				auto it = semaphore_index->emplace( sign_info->semaphore, uint32_t( semaphore_index->size() ) );
+				if ( it.second ) {
+					// if an element was inserted
+					semaphore_names->push_back( std::to_string( semaphore_names->size() ) );
+					assert( semaphore_names->size() == semaphore_index->size() );
+				}
+				uint32_t                          sign_semaphore_id = it.first->second;
+				QueueSubmissionLoggerData::info_t info;
+				info.semaphore_id = sign_semaphore_id;
+				info.value        = uint32_t( sign_info->value & ~uint32_t( 0 ) ); // truncate to 32bit value
+				submission.signal_semaphores.emplace_back( std::move( info ) );
+				sign_info++;
+			}
 
-							for ( auto const& g : blas_info->geometries ) {
+		} while ( sign_info != sign_infos_end || wait_info != wait_infos_end );
+		submission.label = debug_info;
+		data->submissions.emplace_back( std::move( submission ) );
+	}
+};
 
-								// TODO: we may want to cache this - so that we don't have to lookup addresses more than once
+// ----------------------------------------------------------------------
+// Collects the submissions which a frame makes on dispatch, so that we can hand all submissions
+// for a queue to the driver with a single call to vkQueueSubmit2 - on some drivers, each call
+// costs noticeable cpu time, however little work it submits.
+//
+// Submissions keep their order per queue. Across queues, submissions only synchronise via
+// timeline semaphores, which may be waited upon before their signal has been submitted - so
+// it does not matter in which order we flush queues. Binary semaphores which we wait upon
+// (swapchain present complete) have been signalled before dispatch, and binary semaphores
+// which we signal (render complete) are only waited upon after the batch has been flushed.
+struct BackendSubmissionBatch {
+	struct submission_t {
+		std::vector<VkSemaphoreSubmitInfo>     wait_semaphores;
+		std::vector<VkCommandBufferSubmitInfo> command_buffers;
+		std::vector<VkSemaphoreSubmitInfo>     signal_semaphores;
+		std::string                            debug_info; // label for queue sync dot files
+	};
+	struct queue_submissions_t {
+		BackendQueueInfo*         queue;
+		std::vector<submission_t> submissions; // in submission order
+	};
+	std::vector<queue_submissions_t> queues;                   // in order of first submission
+	bool                             should_generate_dot_files = false;
+};
 
-								VkBuffer vertex_buffer = frame_data_get_buffer_from_le_resource_id( frame, g.vertex_buffer );
-								VkBuffer index_buffer  = frame_data_get_buffer_from_le_resource_id( frame, g.index_buffer );
+// ----------------------------------------------------------------------
+// Adds a submission to the batch - copies everything that submit_info points to.
+static void backend_submission_batch_add( BackendSubmissionBatch& batch, BackendQueueInfo* queue, VkSubmitInfo2 const& submit_info, std::string const& debug_info ) {
 
-								VkDeviceOrHostAddressConstKHR vertex_addr = { .deviceAddress = 0 };
-								VkDeviceOrHostAddressConstKHR index_addr  = { .deviceAddress = 0 };
+	auto it = std::find_if( batch.queues.begin(), batch.queues.end(), [ queue ]( auto const& q ) { return q.queue == queue; } );
 
-								{
-									VkBufferDeviceAddressInfo info = {
-									    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-									    .pNext  = nullptr, // optional
-									    .buffer = vertex_buffer,
-									};
+	if ( it == batch.queues.end() ) {
+		it = batch.queues.insert( batch.queues.end(), { queue, {} } );
+	}
+
+	auto& submission = it->submissions.emplace_back();
 
-									vertex_addr.deviceAddress = g.vertex_offset + vkGetBufferDeviceAddress( device, &info );
-								}
+	submission.wait_semaphores.assign( submit_info.pWaitSemaphoreInfos, submit_info.pWaitSemaphoreInfos + submit_info.waitSemaphoreInfoCount );
+	submission.command_buffers.assign( submit_info.pCommandBufferInfos, submit_info.pCommandBufferInfos + submit_info.commandBufferInfoCount );
+	submission.signal_semaphores.assign( submit_info.pSignalSemaphoreInfos, submit_info.pSignalSemaphoreInfos + submit_info.signalSemaphoreInfoCount );
 
-								{
-									VkBufferDeviceAddressInfo info = {
-									    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-									    .pNext  = nullptr, // optional
-									    .buffer = index_buffer,
-									};
-									index_addr.deviceAddress =
-									    g.index_count
-									        ? g.index_offset + vkGetBufferDeviceAddress( device, &info )
-									        : 0;
-								}
+	if ( batch.should_generate_dot_files ) {
+		submission.debug_info = debug_info;
+	}
+}
 
-								VkAccelerationStructureGeometryKHR geometry = {
-								    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-								    .pNext        = nullptr, // optional
-								    .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
-								    .geometry     = {
-								            .triangles = {
-								                .sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
-								                .pNext         = nullptr, // optional
-								                .vertexFormat  = VkFormat( g.vertex_format ),
-								                .vertexData    = vertex_addr,
-								                .vertexStride  = g.vertex_stride,
-								                .maxVertex     = g.vertex_count - 1, // highest index of a vertex that will be accessed via build command
-								                .indexType     = VkIndexType( g.index_type ),
-								                .indexData     = index_addr,
-								                .transformData = {}, // no transform data
-                                        } },
-								    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
-								};
+// ----------------------------------------------------------------------
+// Submits everything in batch, with one call to vkQueueSubmit2 per queue, and empties batch.
+//
+// Submissions which signal nothing get folded into the submission which follows them on the
+// same queue - this is what happens with submissions which only wait (for swapchain images,
+// for acquire barriers). Since nothing can wait for them, it makes no difference if they also
+// wait for what their successor waits for - and the driver has fewer batches to process.
+static void backend_submission_batch_flush( BackendSubmissionBatch& batch, uint32_t* num_submit_calls, uint32_t* num_submissions ) {
 
-								geometries.emplace_back( geometry );
+	ZoneScoped;
 
-								VkAccelerationStructureBuildRangeInfoKHR build_range = {
-								    .primitiveCount  = 0,
-								    .primitiveOffset = 0,
-								    .firstVertex     = 0,
-								    .transformOffset = 0,
-								};
+	using submission_t = BackendSubmissionBatch::submission_t;
 
-								if ( g.index_count ) {
-									// indexed geometry
-									build_range.primitiveCount = g.index_count / 3;
-								} else {
-									// non-indexed geometry
-									build_range.primitiveCount = g.vertex_count / 3;
-								}
+	for ( auto& q : batch.queues ) {
 
-								build_ranges.emplace_back( build_range );
-							}
+		std::vector<submission_t> merged;
+		merged.reserve( q.submissions.size() );
 
-							VkAccelerationStructureBuildRangeInfoKHR const* pBuildRangeInfos = build_ranges.data();
+		for ( auto& s : q.submissions ) {
+			if ( !merged.empty() && merged.back().signal_semaphores.empty() ) {
+				auto& prev = merged.back();
+				prev.wait_semaphores.insert( prev.wait_semaphores.end(), s.wait_semaphores.begin(), s.wait_semaphores.end() );
+				prev.command_buffers.insert( prev.command_buffers.end(), s.command_buffers.begin(), s.command_buffers.end() );
+				prev.signal_semaphores = std::move( s.signal_semaphores );
+				if ( batch.should_generate_dot_files ) {
+					prev.debug_info += " + " + s.debug_info;
+				}
+			} else {
+				merged.emplace_back( std::move( s ) );
+			}
+		}
 
-							VkDeviceOrHostAddressKHR scratchDataAddr = {};
-							//  We get the device address by querying from the buffer.
-							{
-								VkBufferDeviceAddressInfo info = {
-								    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-								    .pNext  = nullptr, // optional
-								    .buffer = scratchBuffer,
-								};
+		std::vector<VkSubmitInfo2> submit_infos;
+		submit_infos.reserve( merged.size() );
 
-								scratchDataAddr.deviceAddress = vkGetBufferDeviceAddress( device, &info );
-							}
+		for ( auto const& m : merged ) {
+			submit_infos.push_back( {
+			    .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			    .pNext                    = nullptr,
+			    .flags                    = 0,
+			    .waitSemaphoreInfoCount   = uint32_t( m.wait_semaphores.size() ),
+			    .pWaitSemaphoreInfos      = m.wait_semaphores.data(),
+			    .commandBufferInfoCount   = uint32_t( m.command_buffers.size() ),
+			    .pCommandBufferInfos      = m.command_buffers.data(),
+			    .signalSemaphoreInfoCount = uint32_t( m.signal_semaphores.size() ),
+			    .pSignalSemaphoreInfos    = m.signal_semaphores.data(),
+			} );
 
-							VkAccelerationStructureBuildGeometryInfoKHR info = {
-							    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-							    .pNext                    = nullptr, // optional
-							    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
-							    .flags                    = blas_info->flags, // optional
-							    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-							    .srcAccelerationStructure = nullptr,                       // optional
-							    .dstAccelerationStructure = vk_acceleration_structure,     // optional
-							    .geometryCount            = uint32_t( geometries.size() ), // optional
-							    .pGeometries              = geometries.data(),             // optional
-							    .ppGeometries             = 0,
-							    .scratchData              = scratchDataAddr,
-							};
+			if ( batch.should_generate_dot_files ) {
+				backend_queue_submission_log( q.queue, &submit_infos.back(), m.debug_info );
+			}
+		}
 
-							vkCmdBuildAccelerationStructuresKHR( cmd, 1, &info, &pBuildRangeInfos );
+		// --------- the actual queue submission happens here
 
-							// Since the scratch buffer is reused across builds, we need a barrier to ensure one build
-							// is finished before starting the next one - theoretically we could limit this to the scratch
-							// buffer by issueing a buffer memory barrier, but since no one else will probably use the
-							// acceleration structure memory caches, we should be fine with this more general barrier.
+		vkQueueSubmit2( q.queue->queue, uint32_t( submit_infos.size() ), submit_infos.data(), nullptr );
 
-							{
-								VkMemoryBarrier2 barrier = {
-								    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
-								    .pNext         = nullptr,                                                  // optional
-								    .srcStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, //
-								    .srcAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,         // make anything written in previous acceleration structure build stage available
-								    .dstStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, // before the next acceleration build stage
-								    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR,          // memory which has been previously written (and made available) must be visible after the barrier
-								};
-								VkDependencyInfo dependency_info = {
-								    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-								    .pNext                    = nullptr, // optional
-								    .dependencyFlags          = 0,       // optional
-								    .memoryBarrierCount       = 1,       // optional
-								    .pMemoryBarriers          = &barrier,
-								    .bufferMemoryBarrierCount = 0, // optional
-								    .pBufferMemoryBarriers    = 0,
-								    .imageMemoryBarrierCount  = 0,
-								    .pImageMemoryBarriers     = 0,
-								};
+		( *num_submit_calls )++;
+		( *num_submissions ) += uint32_t( submit_infos.size() );
+	}
 
-								vkCmdPipelineBarrier2( cmd, &dependency_info );
-							}
+	batch.queues.clear();
+}
 
-						} // end for each blas element in array
+// ----------------------------------------------------------------------
+// Asynchronous uploads
+//
+// Uploads via `write_to_buffer`/`write_to_image` are recorded into transfer passes of the frame
+// which requests them - the frame can't complete before its uploads have completed. For
+// streaming large assets, we offer an alternative: uploads which are submitted on a transfer
+// queue of their own, and which complete independently of any frame.
+//
+// Upload requests copy their data into a dedicated staging buffer immediately. Pending requests
+// are submitted on dispatch, in batches of up to LE_SETTING_BACKEND_UPLOAD_MB_PER_FRAME. Each
+// batch signals a timeline semaphore on completion, which is how we know when we may free its
+// staging buffers, and when tickets are complete.
+//
+// Once a target resource has been uploaded on a queue family other than the one which will
+// consume it, the existing queue ownership tracking (see `backend_submit_queue_transfer_ops`)
+// adds the release/acquire barriers needed to transfer ownership with the first frame that
+// uses the resource.
+//
+// ----------------------------------------------------------------------
 
-						break;
-					}
-					case le::CommandType::eBuildRtxTlas: {
-						auto*                       le_cmd              = static_cast<le::CommandBuildRtxTlas*>( dataIt );
-						void*                       payload_addr        = le_cmd + 1;
-						le_resource_handle const*   resources           = static_cast<le_resource_handle*>( payload_addr );
-						void*                       scratch_memory_addr = le_cmd->info.staging_buffer_mapped_memory;
-						le_rtx_geometry_instance_t* instances           = static_cast<le_rtx_geometry_instance_t*>( scratch_memory_addr );
+// Picks the queue which we prefer for uploads: if there is a queue which supports transfer,
+// but neither graphics nor compute, we assume that it maps to a dedicated DMA engine.
+static void backend_uploads_setup( le_backend_o* self ) {
+	static auto logger = LeLog( LOGGER_LABEL );
 
-						// Foreach resource, we must patch the corresponding instance
+	self->uploads_queue_idx = self->queue_default_graphics_idx;
 
-						const size_t instances_count = le_cmd->info.geometry_instances_count;
+	for ( uint32_t i = 0; i != self->queues.size(); i++ ) {
+		VkQueueFlags flags = self->queues[ i ]->queue_flags;
+		if ( ( flags & VK_QUEUE_TRANSFER_BIT ) &&
+		     0 == ( flags & ( VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT ) ) ) {
+			self->uploads_queue_idx = i;
+			break;
+		}
+	}
 
-						// TODO: Error checking: we should skip this command and issue a
-						// warning if any blas resource could not be found.
+	if ( self->uploads_queue_idx != self->queue_default_graphics_idx ) {
+		logger.info( "Asynchronous uploads use transfer-only queue [%d], family %d.",
+		             self->uploads_queue_idx, self->queues[ self->uploads_queue_idx ]->queue_family_index );
+	} else {
+		logger.info( "No transfer-only queue available - asynchronous uploads use default graphics queue." );
+	}
+}
 
-						for ( size_t i = 0; i != instances_count; i++ ) {
-							// Update blas handles in-place on GPU mapped, coherent memory.
-							//
-							// The 64bit integer handles for bottom level acceleration structures were queried from the GPU when
-							// building bottom level acceleration structures.
-							instances[ i ].blas_handle = frame.availableResources.at( resources[ i ] ).info.blasInfo.device_address;
-						}
+// ----------------------------------------------------------------------
 
-						// Invariant: all instances should be patched right now, we can use the buffer at offset as
-						// instance data to build tlas.
-						auto const&                allocated_resource        = frame.availableResources.at( le_cmd->info.tlas_handle );
-						VkAccelerationStructureKHR vk_acceleration_structure = allocated_resource.as.tlas;
-						auto                       tlas_info                 = reinterpret_cast<le_rtx_tlas_info_o*>( allocated_resource.info.tlasInfo.handle );
+static void backend_upload_request_free_staging( le_backend_o* self, BackendUploadRequest& request ) {
+	vmaDestroyBuffer( self->mAllocator, request.staging_buffer, request.staging_allocation );
+	request.staging_buffer     = nullptr;
+	request.staging_allocation = nullptr;
+}
 
-						// Issue barrier to make sure that transfer to instances buffer is complete
-						// before building top-level acceleration structure
+// ----------------------------------------------------------------------
+// Must only be called once the device is idle.
+static void backend_uploads_destroy( le_backend_o* self ) {
+	VkDevice device = self->device->getVkDevice();
 
-						{
-							VkMemoryBarrier2 barrier = {
-							    .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
-							    .pNext         = nullptr,                                                  //
-							    .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,                         // transfer must happen before barrier
-							    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,                           // anything written in transfer must have been made available
-							    .dstStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, // acceleration structure build must happen-after barrier
-							    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,         // and memory must have been made visible to acceleration structure write
-							};
-							VkDependencyInfo dependency_info = {
-							    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-							    .pNext                    = nullptr, // optional
-							    .dependencyFlags          = 0,       // optional
-							    .memoryBarrierCount       = 1,       // optional
-							    .pMemoryBarriers          = &barrier,
-							    .bufferMemoryBarrierCount = 0, // optional
-							    .pBufferMemoryBarriers    = 0,
-							    .imageMemoryBarrierCount  = 0, // optional
-							    .pImageMemoryBarriers     = 0,
-							};
-							vkCmdPipelineBarrier2( cmd, &dependency_info );
-						}
+	auto lock = std::scoped_lock( self->uploads_mutex );
 
-						// instances information is encoded via buffer, but that buffer is also available as host memory,
-						// because it is held in staging_buffer_mapped_memory...
-						VkBuffer instanceBuffer = frame_data_get_buffer_from_le_resource_id( frame, le_cmd->info.staging_buffer_id );
-						VkBuffer scratchBuffer  = frame_data_get_buffer_from_le_resource_id( frame, LE_RTX_SCRATCH_BUFFER_HANDLE );
+	for ( auto& r : self->uploads_pending ) {
+		backend_upload_request_free_staging( self, r );
+	}
+	self->uploads_pending.clear();
 
-						VkDeviceOrHostAddressConstKHR instanceBufferDeviceAddress = {};
+	for ( auto& batch : self->uploads_in_flight ) {
+		for ( auto& r : batch.requests ) {
+			backend_upload_request_free_staging( self, r );
+		}
+	}
+	self->uploads_in_flight.clear();
 
-						{
-							VkBufferDeviceAddressInfo info = {
-							    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-							    .pNext  = nullptr, // optional
-							    .buffer = instanceBuffer,
-							};
+	// Command buffers are freed implicitly with their pools.
+	for ( auto& [ family_index, pool ] : self->uploads_command_pools ) {
+		vkDestroyCommandPool( device, pool, nullptr );
+	}
+	self->uploads_command_pools.clear();
 
-							instanceBufferDeviceAddress.deviceAddress =
-							    le_cmd->info.staging_buffer_offset +
-							    vkGetBufferDeviceAddress( device, &info );
-						}
+	for ( auto& [ queue_index, timeline ] : self->uploads_timelines ) {
+		vkDestroySemaphore( device, timeline.semaphore, nullptr );
+	}
+	self->uploads_timelines.clear();
+}
 
-						VkAccelerationStructureGeometryKHR khr_instances_data = {
-						    .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-						    .pNext        = nullptr, // optional
-						    .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
-						    .geometry     = {
-						            .instances = {
-						                .sType           = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
-						                .pNext           = nullptr, // optional
-						                .arrayOfPointers = false,
-						                .data            = instanceBufferDeviceAddress,
-                                } },
-						    .flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // optional
-						};
-						// Take pointer to array of khr_instances - we will need one further indirection because reasons.
+// ----------------------------------------------------------------------
+// Copies `num_bytes` from `data` into a new staging buffer, and adds a request to the
+// list of pending uploads. Returns the ticket for the request, or 0 on error.
+static uint64_t backend_uploads_add_request( le_backend_o* self, BackendUploadRequest&& request, void const* data ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
 
-						//  we get the device address by querying from the buffer.
-						VkDeviceOrHostAddressKHR scratch_data_addr = {};
-						{
-							VkBufferDeviceAddressInfo info = {
-							    .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-							    .pNext  = nullptr, // optional
-							    .buffer = scratchBuffer,
-							};
-							scratch_data_addr.deviceAddress = vkGetBufferDeviceAddress( device, &info );
-						}
-						VkAccelerationStructureBuildGeometryInfoKHR info = {
-						    .sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-						    .pNext                    = nullptr, // optional
-						    .type                     = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-						    .flags                    = tlas_info->flags, // optional
-						    .mode                     = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-						    .srcAccelerationStructure = 0,                         // optional
-						    .dstAccelerationStructure = vk_acceleration_structure, // optional
-						    .geometryCount            = 1,                         // optional
-						    .pGeometries              = &khr_instances_data,       // optional
-						    .ppGeometries             = 0,
-						    .scratchData              = scratch_data_addr,
-						};
+	VkBufferCreateInfo bufferCreateInfo{
+	    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+	    .pNext                 = nullptr, // optional
+	    .flags                 = 0,       // optional
+	    .size                  = request.num_bytes,
+	    .usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+	    .queueFamilyIndexCount = 0, // optional
+	    .pQueueFamilyIndices   = 0,
+	};
+
+	VmaAllocationCreateInfo allocationCreateInfo{};
+	allocationCreateInfo.flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	allocationCreateInfo.usage          = VMA_MEMORY_USAGE_CPU_ONLY;
+	allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-						VkAccelerationStructureBuildRangeInfoKHR build_ranges = {
-						    .primitiveCount  = tlas_info->instances_count, // This is where we set the number of instances.
-						    .primitiveOffset = 0,                          // spec states: must be a multiple of 16?!!
-						    .firstVertex     = 0,
-						    .transformOffset = 0,
-						};
+	VmaAllocationInfo allocationInfo{};
 
-						VkAccelerationStructureBuildRangeInfoKHR* p_build_ranges = &build_ranges;
+	auto result = vmaCreateBuffer( self->mAllocator, &bufferCreateInfo, &allocationCreateInfo,
+	                               &request.staging_buffer, &request.staging_allocation, &allocationInfo );
 
-						vkCmdBuildAccelerationStructuresKHR( cmd, 1, &info, &p_build_ranges );
+	if ( result != VK_SUCCESS ) {
+		logger.error( "Could not allocate %zu Bytes of staging memory for upload to resource '%s'",
+		              size_t( request.num_bytes ), request.dst->data->debug_name );
+		return 0;
+	}
 
-						break;
-					}
-					default: {
-						assert( false && "command not handled" );
-					}
-					} // end switch header.info.type
+	// ----------| invariant: staging buffer was allocated and is mapped.
 
-					// Move iterator by size of current le_command so that it points
-					// to the next command in the list.
-					dataIt = static_cast<char*>( dataIt ) + header->info.size;
+	memcpy( allocationInfo.pMappedData, data, request.num_bytes );
 
-					++commandIndex;
-				}
-			}
+	// Make sure host writes are visible to the device, in case memory is not host-coherent.
+	vmaFlushAllocation( self->mAllocator, request.staging_allocation, 0, VK_WHOLE_SIZE );
 
-			// non-draw passes don't need renderpasses.
-			if ( pass.type == le::QueueFlagBits::eGraphics && pass.renderPass ) {
-				vkCmdEndRenderPass( cmd );
-			}
+	auto lock      = std::scoped_lock( self->uploads_mutex );
+	request.ticket = self->uploads_next_ticket++;
+	self->uploads_pending.emplace_back( std::move( request ) );
 
-			if ( SHOULD_INSERT_DEBUG_LABELS ) {
-				vkCmdEndDebugUtilsLabelEXT( cmd );
-			}
+	return self->uploads_pending.back().ticket;
+}
 
-			vkEndCommandBuffer( cmd );
-		}
+// ----------------------------------------------------------------------
+
+static uint64_t backend_upload_to_buffer( le_backend_o* self, le_buf_resource_handle dst_buffer, le_resource_info_t const* dst_info, uint64_t dst_offset, void const* data, uint64_t num_bytes ) {
+
+	if ( num_bytes == 0 || data == nullptr ) {
+		return 0;
+	}
+
+	BackendUploadRequest request{};
+	request.dst          = dst_buffer;
+	request.has_dst_info = ( dst_info != nullptr );
+	request.dst_offset   = dst_offset;
+	request.num_bytes    = num_bytes;
+
+	if ( dst_info ) {
+		request.dst_info = *dst_info;
 	}
+
+	return backend_uploads_add_request( self, std::move( request ), data );
 }
 
 // ----------------------------------------------------------------------
-// This method gets called once per frame (via renderer.update()) in order
-// to poll shader modules for updates
-static void backend_update_shader_modules( le_backend_o* self ) {
-	using namespace le_backend_vk;
-	le_pipeline_manager_i.update_shader_modules( self->pipelineCache );
+
+static uint64_t backend_upload_to_image( le_backend_o* self, le_img_resource_handle dst_image, le_resource_info_t const* dst_info, le_write_to_image_settings_t const* write_info, void const* data, uint64_t num_bytes ) {
+
+	if ( num_bytes == 0 || data == nullptr || write_info == nullptr ) {
+		return 0;
+	}
+
+	assert( write_info->num_miplevels != 0 ); // number of miplevels must be at least 1.
+
+	BackendUploadRequest request{};
+	request.dst            = dst_image;
+	request.has_dst_info   = ( dst_info != nullptr );
+	request.image_settings = *write_info;
+	request.num_bytes      = num_bytes;
+
+	if ( dst_info ) {
+		request.dst_info = *dst_info;
+	}
+
+	return backend_uploads_add_request( self, std::move( request ), data );
 }
 
 // ----------------------------------------------------------------------
-static le_shader_module_handle backend_create_shader_module(
-    le_backend_o*                     self,
-    char const*                       path,
-    const LeShaderSourceLanguageEnum& shader_source_language,
-    const le::ShaderStageFlagBits&    moduleType,
-    char const*                       macro_definitions,
-    le_shader_module_handle           handle,
-    VkSpecializationMapEntry const*   specialization_map_entries,
-    uint32_t                          specialization_map_entries_count,
-    void*                             specialization_map_data,
-    uint32_t                          specialization_map_data_num_bytes ) {
+// Returns whether the upload for `upload_ticket` is still pending, has completed on the GPU,
+// or has failed. May be called from any thread.
+//
+// A failed ticket is forgotten once it has been reported as failed, so that failed tickets
+// don't pile up - its owner must not query it again.
+static le_upload_status_t backend_get_upload_status( le_backend_o* self, uint64_t upload_ticket ) {
 
-	using namespace le_backend_vk;
-	return le_pipeline_manager_i.create_shader_module(
-	    self->pipelineCache,
-	    path,
-	    shader_source_language,
-	    moduleType,
-	    macro_definitions,
-	    handle,
-	    specialization_map_entries,
-	    specialization_map_entries_count,
-	    specialization_map_data,
-	    specialization_map_data_num_bytes );
+	auto lock = std::scoped_lock( self->uploads_mutex );
+
+	if ( upload_ticket == 0 || upload_ticket >= self->uploads_next_ticket ) {
+		// Ticket was never issued - 0 is what upload requests return on error.
+		return le_upload_status_t::eFailed;
+	}
+
+	if ( self->uploads_failed.erase( upload_ticket ) ) {
+		return le_upload_status_t::eFailed;
+	}
+
+	for ( auto const& r : self->uploads_pending ) {
+		if ( r.ticket == upload_ticket ) {
+			return le_upload_status_t::ePending;
+		}
+	}
+
+	for ( auto const& batch : self->uploads_in_flight ) {
+		for ( auto const& r : batch.requests ) {
+			if ( r.ticket == upload_ticket ) {
+				uint64_t value = 0;
+				vkGetSemaphoreCounterValue( self->device->getVkDevice(), batch.semaphore, &value );
+				return value >= batch.signal_value ? le_upload_status_t::eComplete : le_upload_status_t::ePending;
+			}
+		}
+	}
+
+	// Ticket was neither failed, pending nor in-flight: it must have been retired.
+	return le_upload_status_t::eComplete;
 }
 
 // ----------------------------------------------------------------------
+// Frees staging memory and command buffers for batches which have completed.
+static void backend_uploads_retire_completed( le_backend_o* self ) {
+	ZoneScoped;
 
-static le_pipeline_manager_o* backend_get_pipeline_cache( le_backend_o* self ) {
-	return self->pipelineCache;
+	VkDevice device = self->device->getVkDevice();
+
+	auto lock = std::scoped_lock( self->uploads_mutex );
+
+	for ( auto batch = self->uploads_in_flight.begin(); batch != self->uploads_in_flight.end(); ) {
+		uint64_t value = 0;
+		vkGetSemaphoreCounterValue( device, batch->semaphore, &value );
+
+		if ( value < batch->signal_value ) {
+			batch++;
+			continue;
+		}
+
+		// ----------| invariant: batch has completed
+
+		for ( auto& r : batch->requests ) {
+			backend_upload_request_free_staging( self, r );
+		}
+
+		vkFreeCommandBuffers( device, self->uploads_command_pools.at( batch->queue_family_index ), 1, &batch->cmd );
+		batch = self->uploads_in_flight.erase( batch );
+	}
 }
 
 // ----------------------------------------------------------------------
-// Return a pointer to a queue info structure holding the queue
-// which we use for default graphics operations. This is also
-// the queue which is used for swapchain present.
-static BackendQueueInfo* backend_get_default_graphics_queue_info( le_backend_o* self ) {
+// Records commands to copy data from the staging buffer for `request` into `dst`, and
+// updates the sync state for `dst` so that following frames can pick up from there.
+static void backend_uploads_record_request( VkCommandBuffer cmd, BackendUploadRequest const& request, AllocatedResourceVk& dst, bool should_generate_miplevels ) {
+
+	if ( dst.info.isBuffer() ) {
+
+		// Wait for any previous access to the buffer on this queue before we overwrite it.
+		VkBufferMemoryBarrier2 barrier{
+		    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		    .pNext               = nullptr,
+		    .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		    .srcAccessMask       = VK_ACCESS_2_MEMORY_WRITE_BIT,
+		    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		    .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .buffer              = dst.as.buffer,
+		    .offset              = request.dst_offset,
+		    .size                = request.num_bytes,
+		};
 
-	assert( !self->queues.empty() && "No queues available; Cannot retrieve default graphics queue" );
-	// -----------| Invariant: queue available
+		VkDependencyInfo dependency_info{
+		    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		    .pNext                    = nullptr,
+		    .dependencyFlags          = 0,
+		    .memoryBarrierCount       = 0,
+		    .pMemoryBarriers          = 0,
+		    .bufferMemoryBarrierCount = 1,
+		    .pBufferMemoryBarriers    = &barrier,
+		    .imageMemoryBarrierCount  = 0,
+		    .pImageMemoryBarriers     = 0,
+		};
 
-	static auto result = self->queues[ self->queue_default_graphics_idx ];
+		vkCmdPipelineBarrier2( cmd, &dependency_info );
 
-	// It's safe to return a pointer to a vector element, and to cache it here,
-	// as `self->queues` is constant once a device has been created.
-	// There is no way to add or remove queues at a later stage because queues
-	// are owned by device.
+		VkBufferCopy region{
+		    .srcOffset = 0,
+		    .dstOffset = request.dst_offset,
+		    .size      = request.num_bytes,
+		};
 
-	return result;
-}
+		vkCmdCopyBuffer( cmd, request.staging_buffer, dst.as.buffer, 1, &region );
 
-struct QueueSubmissionLoggerData {
+		dst.state.stage          = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		dst.state.visible_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		return;
+	}
 
-	struct info_t {
-		uint32_t value;
-		uint32_t semaphore_id;
-	};
+	// ----------| invariant: dst is an image
 
-	struct submission_t {
-		BackendQueueInfo*   queue;
-		std::string         label;
-		std::vector<info_t> wait_semaphores;
-		std::vector<info_t> signal_semaphores;
-	};
+	auto const& info  = request.image_settings;
+	VkImage     image = dst.as.image;
 
-	std::vector<submission_t> submissions;
-};
+	// Transition all subresources into transfer_dst layout, so that the image ends up in a single
+	// layout which we can track. We transition from the current layout, so that contents outside
+	// of the target region are preserved.
+	{
+		VkImageMemoryBarrier2 barrier{
+		    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		    .pNext               = nullptr,
+		    .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		    .srcAccessMask       = VK_ACCESS_2_MEMORY_WRITE_BIT,
+		    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		    .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		    .oldLayout           = dst.state.layout,
+		    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .image               = image,
+		    .subresourceRange    = LE_IMAGE_SUBRESOURCE_RANGE_ALL_MIPLEVELS,
+		};
 
-std::unordered_map<VkSemaphore, uint32_t>* get_semaphore_indices() {
-	static std::unordered_map<VkSemaphore, uint32_t> semaphore_index;
-	return &semaphore_index;
-}
-std::vector<std::string>* get_semaphore_names() {
-	static std::vector<std::string> semaphore_names;
-	return &semaphore_names;
-}
-QueueSubmissionLoggerData* get_queue_submission_logger_data() {
-	static QueueSubmissionLoggerData data;
-	return &data;
-}
+		VkDependencyInfo dependency_info{
+		    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		    .pNext                    = nullptr,
+		    .dependencyFlags          = 0,
+		    .memoryBarrierCount       = 0,
+		    .pMemoryBarriers          = 0,
+		    .bufferMemoryBarrierCount = 0,
+		    .pBufferMemoryBarriers    = 0,
+		    .imageMemoryBarrierCount  = 1,
+		    .pImageMemoryBarriers     = &barrier,
+		};
 
-std::vector<std::string>* backend_initialise_semaphore_names( le_backend_o const* backend ) {
+		vkCmdPipelineBarrier2( cmd, &dependency_info );
+	}
 
-	auto semaphore_names   = get_semaphore_names();
-	auto semaphore_indices = get_semaphore_indices();
+	{
+		VkImageSubresourceLayers imageSubresourceLayers{
+		    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+		    .mipLevel       = info.dst_miplevel,
+		    .baseArrayLayer = info.dst_array_layer,
+		    .layerCount     = 1,
+		};
 
-	char img_name_c_str[ 80 ];
+		VkBufferImageCopy region{
+		    .bufferOffset      = 0, // each request has a staging buffer of its own
+		    .bufferRowLength   = 0, // 0 means tightly packed
+		    .bufferImageHeight = 0, // 0 means tightly packed
+		    .imageSubresource  = imageSubresourceLayers,
+		    .imageOffset       = { .x = info.offset_x, .y = info.offset_y, .z = info.offset_z },
+		    .imageExtent       = { .width = info.image_w, .height = info.image_h, .depth = info.image_d },
+		};
 
-	for ( auto const& f : backend->mFrames ) {
-		for ( auto const& [ swapchain_handle, swapchain_state ] : f.frame_owned_swapchain_state ) {
-			{
-				auto const& [ it, was_inserted ] = semaphore_indices->emplace( swapchain_state.presentComplete->semaphore, uint32_t( semaphore_indices->size() ) );
-				if ( was_inserted ) {
-					// if an element was inserted
-					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
-					semaphore_names->push_back( img_name_c_str );
-					assert( semaphore_names->size() == semaphore_indices->size() );
-				} else {
-					// we must update the element that was already present
-					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
-					( *semaphore_names )[ it->second ] = img_name_c_str;
-					assert( semaphore_names->size() == semaphore_indices->size() );
-				}
-			}
-			{
-				auto const& [ it, was_inserted ] = semaphore_indices->emplace( swapchain_state.renderComplete->semaphore, uint32_t( semaphore_indices->size() ) );
-				if ( was_inserted ) {
-					// if an element was inserted
-					snprintf( img_name_c_str, sizeof( img_name_c_str ), "PRESENT_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
-					semaphore_names->push_back( img_name_c_str );
-					assert( semaphore_names->size() == semaphore_indices->size() );
-				} else {
-					snprintf( img_name_c_str, sizeof( img_name_c_str ), "RENDER_COMPLETE: %s", swapchain_state.swapchain_data.swapchain_image->data->debug_name );
-					( *semaphore_names )[ it->second ] = img_name_c_str;
-					assert( semaphore_names->size() == semaphore_indices->size() );
-				}
-			}
+		vkCmdCopyBufferToImage( cmd, request.staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+	}
+
+	if ( should_generate_miplevels ) {
+
+		// Generate miplevels by blitting each miplevel into the next, smaller miplevel. Before each blit,
+		// the source miplevel moves to transfer_src layout - after the blit, it returns to transfer_dst
+		// layout, so that all subresources end up in transfer_dst layout again.
+
+		VkImageMemoryBarrier2 barrier{
+		    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		    .pNext               = nullptr,
+		    .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		    .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		    .dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+		    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		    .image               = image,
+		    .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, info.dst_array_layer, 1 },
+		};
+
+		VkDependencyInfo dependency_info{
+		    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		    .pNext                    = nullptr,
+		    .dependencyFlags          = 0,
+		    .memoryBarrierCount       = 0,
+		    .pMemoryBarriers          = 0,
+		    .bufferMemoryBarrierCount = 0,
+		    .pBufferMemoryBarriers    = 0,
+		    .imageMemoryBarrierCount  = 1,
+		    .pImageMemoryBarriers     = &barrier,
+		};
+
+		int32_t src_width  = int32_t( info.image_w );
+		int32_t src_height = int32_t( info.image_h );
+
+		for ( uint32_t dst_miplevel = info.dst_miplevel + 1; dst_miplevel < info.num_miplevels; dst_miplevel++ ) {
+
+			uint32_t src_miplevel = dst_miplevel - 1;
+
+			int32_t dst_width  = src_width > 2 ? src_width >> 1 : 1;
+			int32_t dst_height = src_height > 2 ? src_height >> 1 : 1;
+
+			// transfer_dst -> transfer_src for source miplevel
+			barrier.srcAccessMask                 = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask                 = VK_ACCESS_2_TRANSFER_READ_BIT;
+			barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.subresourceRange.baseMipLevel = src_miplevel;
+			vkCmdPipelineBarrier2( cmd, &dependency_info );
+
+			VkImageBlit region{
+			    .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, src_miplevel, info.dst_array_layer, 1 },
+			    .srcOffsets     = { { 0, 0, 0 }, { src_width, src_height, 1 } },
+			    .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, dst_miplevel, info.dst_array_layer, 1 },
+			    .dstOffsets     = { { 0, 0, 0 }, { dst_width, dst_height, 1 } },
+			};
+
+			vkCmdBlitImage( cmd,
+			                image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			                image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			                1, &region, VK_FILTER_LINEAR );
+
+			// transfer_src -> transfer_dst for source miplevel, once blit has read from it
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			vkCmdPipelineBarrier2( cmd, &dependency_info );
+
+			src_width  = dst_width;
+			src_height = dst_height;
 		}
 	}
-	return semaphore_names;
-};
+
+	dst.state.stage          = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	dst.state.visible_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	dst.state.layout         = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+}
 
 // ----------------------------------------------------------------------
+// Allocates the target resource for `request` via its resource info.
+// Must be called with allocated resources locked.
+static bool backend_uploads_allocate_dst( le_backend_o* self, BackendUploadRequest const& request, std::unordered_map<le_resource_handle, AllocatedResourceVk>& backend_resources ) {
+	static auto logger = LeLog( LOGGER_LABEL );
 
-static void backend_emit_queue_sync_dot_file( le_backend_o const* backend, uint64_t frame_number ) {
+	auto resourceCreateInfo = ResourceCreateInfo::from_le_resource_info( request.dst_info );
 
-	static std::filesystem::path exe_path = []() {
-		char result[ 1024 ] = { 0 };
+	if ( resourceCreateInfo.isImage() ) {
+		resourceCreateInfo.imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		patchImageUsageForMipLevels( &resourceCreateInfo );
+		if ( resourceCreateInfo.imageInfo.format == VK_FORMAT_UNDEFINED ) {
+			inferImageFormat( self, static_cast<le_img_resource_handle>( request.dst ), request.dst_info.image.usage, &resourceCreateInfo );
+		}
+	} else if ( resourceCreateInfo.isBuffer() ) {
+		resourceCreateInfo.bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	} else {
+		logger.error( "Cannot upload to resource '%s': only buffers and images may be uploaded to.", request.dst->data->debug_name );
+		return false;
+	}
 
-#ifdef _MSC_VER
+	patchUsageForDefragmentation( &resourceCreateInfo );
 
-		// When NULL is passed to GetModuleHandle, the handle of the exe itself is returned
-		HMODULE hModule = GetModuleHandle( NULL );
-		if ( hModule != NULL ) {
-			// Use GetModuleFileName() with module handle to get the path
-			GetModuleFileName( hModule, result, ( sizeof( result ) ) );
-		}
-		size_t count = strnlen_s( result, sizeof( result ) );
-#else
-		ssize_t count = readlink( "/proc/self/exe", result, 1024 );
-#endif
+	VkResult result                   = VK_SUCCESS;
+	auto     allocatedResource        = allocate_resource_vk( self->mAllocator, resourceCreateInfo, self->device->getVkDevice(), backend_get_resource_pool( self, resourceCreateInfo ), &result );
+	allocatedResource.last_used_frame = self->mFramesCount;
+
+	if ( result != VK_SUCCESS ) {
+		logger.error( "Could not allocate resource '%s' for upload: %s", request.dst->data->debug_name, to_str_vk_result( result ) );
+		return false;
+	}
+
+	if ( LE_PRINT_DEBUG_MESSAGES ) {
+		printResourceInfo( request.dst, allocatedResource.info, "ALLOC (upload)" );
+	}
+
+	backend_resources.insert_or_assign( request.dst, allocatedResource );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Records and submits pending uploads, up to LE_SETTING_BACKEND_UPLOAD_MB_PER_FRAME.
+// Must only be called on dispatch.
+//
+// Requests for resources which don't exist yet - and which carry no resource info from
+// which we could allocate them - remain pending until a frame allocates their resource.
+static void backend_uploads_submit_pending( le_backend_o* self, BackendSubmissionBatch& submissions ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	LE_SETTING( uint32_t, LE_SETTING_BACKEND_UPLOAD_MB_PER_FRAME, 64 );
+
+	VkDevice device = self->device->getVkDevice();
+
+	auto [ backend_resources, resources_lock ] = self->get_allocated_resources();
+
+	size_t first_new_batch = 0; // index of first batch in uploads_in_flight which we must record and submit
+
+	{
+		auto lock = std::scoped_lock( self->uploads_mutex );
 
-		return std::string( result, ( count > 0 ) ? size_t( count ) : 0 );
-	}();
+		if ( self->uploads_pending.empty() ) {
+			return;
+		}
 
-	static QueueSubmissionLoggerData*               data = get_queue_submission_logger_data();
-	static std::unordered_map<VkQueue, std::string> queue_name;
-	std::vector<std::string>*                       semaphore_names = backend_initialise_semaphore_names( backend );
+		// ----------| invariant: there are pending requests
 
-	std::ostringstream                     os;
-	std::unordered_map<uint64_t, uint32_t> wait_info_to_submission; // wait info to submission id
-	std::unordered_map<uint64_t, uint32_t> sign_info_to_submission; // signal info to submission id
-	uint32_t                               submission_id = 0;
+		// Requests go to the upload queue, unless their resource is currently owned by
+		// another queue family, in which case they go to the default queue of that family,
+		// so that we don't need to transfer ownership before we can write.
+		//
+		// Generating miplevels requires blits, which need a graphics queue.
 
-	os << "digraph g {\n"
-	      "rankdir = LR;\n"
-	      "node [shape = plaintext; margin=0; height = 1; fontname = \"IBM Plex Sans\";];\n"
-	      "graph [label = <<table border='0' cellborder='0' cellspacing='0' cellpadding='3'>";
-	for ( size_t i = 0; i != backend->queues.size(); i++ ) {
+		std::unordered_map<uint32_t, std::vector<BackendUploadRequest>> requests_per_queue;
 
-		os << "<tr><td align='left'>queue_" << i << " : {" << to_string_vk_queue_flags( backend->queues[ i ]->queue_flags ) << "}</td></tr>";
-	}
-	os << "<tr><td align='left'>\"" << exe_path.string() << "\"</td></tr>"
-	   << "<tr><td align='left'>Island Queue Sync @ Frame \xe2\x84\x96" << frame_number << "</td></tr>"
-	   << "</table>>; splines = true; nodesep = 0.7; fontname = \"IBM Plex Sans\"; fontsize = 10; labeljust = \"l\";];\n";
-	;
+		uint64_t const budget      = uint64_t( *LE_SETTING_BACKEND_UPLOAD_MB_PER_FRAME ) << 20;
+		uint64_t       num_bytes   = 0;
+		size_t         num_skipped = 0;
 
-	// -- Go through each submission in sequence
-	for ( auto const& submission : data->submissions ) {
-		// each submission represents one queue submission
+		for ( auto r = self->uploads_pending.begin(); r != self->uploads_pending.end(); ) {
 
-		os << "struct_" << submission_id << " [\n";
+			// We always submit at least one request, even if it is larger than the budget.
+			if ( num_bytes != 0 && num_bytes + r->num_bytes > budget ) {
+				break;
+			}
 
-		auto queue_name_it = queue_name.emplace( submission.queue->queue, "" );
-		if ( queue_name_it.second == true ) {
-			// there was no entry there, yet
+			if ( backend_defragment_is_moved( self, r->dst ) ) {
+				// Keep request pending until the defragmentation pass which moved its resource
+				// has ended - uploads may go to another queue, and don't wait for the copy, which
+				// could otherwise overwrite what we upload.
+				r++;
+				continue;
+			}
 
-			std::ostringstream oname;
-			{
-				size_t i = 0;
-				for ( ; i != backend->queues.size(); i++ ) {
-					if ( backend->queues[ i ] == submission.queue ) {
-						break;
-					}
+			if ( backend_resources.find( r->dst ) == backend_resources.end() ) {
+				if ( !r->has_dst_info ) {
+					// Keep request pending until resource has been allocated by a frame.
+					num_skipped++;
+					r++;
+					continue;
 				}
-				if ( i != backend->queues.size() ) {
+				if ( !backend_uploads_allocate_dst( self, *r, backend_resources ) ) {
+					// Record failure, so that `get_upload_status` does not report this ticket as complete.
+					self->uploads_failed.insert( r->ticket );
+					backend_upload_request_free_staging( self, *r );
+					r = self->uploads_pending.erase( r );
+					continue;
 				}
-				oname << "queue_" << i << " : ";
 			}
 
-			queue_name_it.first->second = oname.str();
-		}
-
-		os << "\tlabel = <\n";
-		os << "<table border=\"0\" cellborder=\"1\" cellspacing=\"0\" cellpadding=\"4\">\n\t<tr>";
-		os << "<td colspan=\"2\" port=\"port_struct_" << submission_id << "\">" << queue_name_it.first->second << "</td></tr>";
-		os << "\n\t<tr><td colspan=\"2\">" << submission.label << "</td></tr>";
-
-		{
-			auto w_it = submission.wait_semaphores.begin();
-			auto s_it = submission.signal_semaphores.begin();
-			do {
+			uint32_t queue_idx       = self->uploads_queue_idx;
+			bool     is_family_owned = false;
 
-				os << "\n\t<tr>";
-				if ( w_it != submission.wait_semaphores.end() ) {
-					os << "<td port=\"port_" << w_it->semaphore_id << "_w_" << w_it->value << "\">";
-					os << "S<sub><font point-size='9'>" << ( *semaphore_names )[ w_it->semaphore_id ] << "</font></sub> \xe2\x8c\x9b";
-					if ( ( *semaphore_names )[ w_it->semaphore_id ][ 0 ] <= '9' ) {
-						// only show value if we have a non-binary semaphore (that's a semaphore with an alphanumeric name)
-						os << w_it->value;
-					}
-					os << " ";
-					wait_info_to_submission.emplace( uint64( w_it->value ) << 32 | w_it->semaphore_id, submission_id );
-					w_it++;
-				} else {
-					os << "<td>";
+			if ( self->must_track_resources_queue_family_ownership ) {
+				auto owner = self->resource_queue_family_ownership[ 0 ].find( r->dst );
+				if ( owner != self->resource_queue_family_ownership[ 0 ].end() ) {
+					queue_idx       = self->default_queue_for_family_index.at( uint32_t( owner->second ) );
+					is_family_owned = true;
 				}
-				os << "</td>";
-				if ( s_it != submission.signal_semaphores.end() ) {
-					os << "<td port=\"port_" << s_it->semaphore_id << "_s_" << s_it->value << "\">"
-					   << "S<sub><font point-size='9'>" << ( *semaphore_names )[ s_it->semaphore_id ] << "</font></sub> \xf0\x9f\x8f\x81 ";
-					if ( ( *semaphore_names )[ s_it->semaphore_id ][ 0 ] <= '9' ) {
-						// only show value if we have a non-binary semaphore (that's a semaphore with an alphanumeric name)
-						os << s_it->value << "";
-					}
-					sign_info_to_submission.emplace( uint64( s_it->value ) << 32 | s_it->semaphore_id, submission_id );
-					s_it++;
+			}
+
+			if ( r->dst->data->type == LeResourceType::eImage &&
+			     r->image_settings.num_miplevels > 1 &&
+			     0 == ( self->queues[ queue_idx ]->queue_flags & VK_QUEUE_GRAPHICS_BIT ) ) {
+				if ( !is_family_owned ) {
+					queue_idx = self->queue_default_graphics_idx;
 				} else {
-					os << "<td>";
+					logger.warn( "Cannot generate miplevels for image '%s' on a queue without graphics capabilities - only uploading miplevel %d.",
+					             r->dst->data->debug_name, r->image_settings.dst_miplevel );
+					r->image_settings.num_miplevels = 1;
 				}
-				os << "</td></tr>";
-			} while ( w_it != submission.wait_semaphores.end() || s_it != submission.signal_semaphores.end() );
+			}
+
+			num_bytes += r->num_bytes;
+			requests_per_queue[ queue_idx ].emplace_back( std::move( *r ) );
+			r = self->uploads_pending.erase( r );
 		}
-		os << "\n</table>>];\n";
-		submission_id++;
-	}
 
-	// for all the waits, find a matching signal
-	os << "\n";
+		if ( requests_per_queue.empty() ) {
+			if ( LE_DEBUG_TRUE_ONCE_IF_CHANGED( num_skipped ) ) {
+				logger.warn( "%zu upload request(s) waiting for their target resources to be allocated.", num_skipped );
+			}
+			return;
+		}
 
-	for ( auto const& w : wait_info_to_submission ) {
-		auto it = sign_info_to_submission.find( w.first );
-		if ( it != sign_info_to_submission.end() ) {
+		// ----------| invariant: there are requests to submit with this frame.
 
-			os << "\tstruct_" << it->second << ":port_" << ( it->first & ~uint32_t( 0 ) ) << "_s_" << ( it->first >> 32 ) << " -> "
-			   << "struct_" << w.second << ":port_" << ( w.first & ~uint32_t( 0 ) ) << "_w_" << ( w.first >> 32 ) << "\n";
-		}
-	}
+		// Create one batch per queue. We add batches to the list of in-flight batches before we
+		// submit them, so that their tickets never appear to have completed early - their
+		// semaphores can't reach their signal values before they have been submitted.
 
-	// we want to link back to the last submission on the same queue
-	{
-		os << "edge [style=dashed;];\n";
-		std::unordered_map<VkQueue, uint32_t> queue_to_last_submission;
-		uint32_t                              i = 0;
-		for ( auto const& s : data->submissions ) {
+		first_new_batch = self->uploads_in_flight.size();
 
-			auto it = queue_to_last_submission.emplace( s.queue->queue, i );
+		for ( auto& [ queue_idx, queue_requests ] : requests_per_queue ) {
 
-			if ( it.second == false ) {
-				// there was already a previous entry for this queue
+			uint32_t queue_family_index = self->queues[ queue_idx ]->queue_family_index;
 
-				os << "\tstruct_" << it.first->second << ":port_struct_" << it.first->second << " -> "
-				   << "\tstruct_" << i << ":port_struct_" << i << "\n";
+			// -- Fetch, or create command pool for the queue family
 
-				it.first->second = i;
+			VkCommandPool& pool = self->uploads_command_pools[ queue_family_index ];
+
+			if ( pool == nullptr ) {
+				VkCommandPoolCreateInfo info = {
+				    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+				    .pNext            = nullptr,                              // optional
+				    .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // optional
+				    .queueFamilyIndex = queue_family_index,
+				};
+				vkCreateCommandPool( device, &info, nullptr, &pool );
 			}
 
-			i++;
+			// -- Fetch, or create timeline semaphore for the queue
+
+			auto timeline = self->uploads_timelines.find( queue_idx );
+
+			if ( timeline == self->uploads_timelines.end() ) {
+				VkSemaphoreTypeCreateInfo type_info = {
+				    .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+				    .pNext         = nullptr, // optional
+				    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+				    .initialValue  = 0,
+				};
+				VkSemaphoreCreateInfo semaphore_create_info = {
+				    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+				    .pNext = &type_info, // optional
+				    .flags = 0,          // optional
+				};
+				BackendUploadTimeline new_timeline{};
+				vkCreateSemaphore( device, &semaphore_create_info, nullptr, &new_timeline.semaphore );
+				timeline = self->uploads_timelines.emplace( queue_idx, new_timeline ).first;
+			}
+
+			BackendUploadBatch batch{};
+			batch.requests           = std::move( queue_requests );
+			batch.queue_idx          = queue_idx;
+			batch.queue_family_index = queue_family_index;
+			batch.semaphore          = timeline->second.semaphore;
+			batch.signal_value       = ++timeline->second.value;
+
+			VkCommandBufferAllocateInfo allocate_info = {
+			    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			    .pNext              = nullptr,
+			    .commandPool        = pool,
+			    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			    .commandBufferCount = 1,
+			};
+
+			vkAllocateCommandBuffers( device, &allocate_info, &batch.cmd );
+
+			self->uploads_in_flight.emplace_back( std::move( batch ) );
 		}
 	}
 
-	os << "}\n";
+	// ----------| invariant: uploads_in_flight[first_new_batch..] hold batches which we must record and submit.
+	//
+	// Note that only dispatch adds or removes in-flight batches, which is why we may
+	// access them without holding uploads_mutex from here on.
 
-	auto write_to_file = []( char const* filename, std::ostringstream const& os ) {
-		FILE* out_file = fopen( filename, "wb" );
-		fprintf( out_file, "%s\n", os.str().c_str() );
-		fclose( out_file );
+	for ( size_t i = first_new_batch; i != self->uploads_in_flight.size(); i++ ) {
 
-		le::Log( LOGGER_LABEL ).info( "Generated .dot file: '%s'", filename );
-	};
+		BackendUploadBatch const& batch = self->uploads_in_flight[ i ];
+		BackendQueueInfo*         queue = self->queues[ batch.queue_idx ];
 
-	char filename[ 32 ] = "";
-	snprintf( filename, sizeof( filename ), "queues_%08zu.dot", frame_number );
+		VkCommandBufferBeginInfo begin_info = {
+		    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		    .pNext            = nullptr,                                     // optional
+		    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // optional
+		    .pInheritanceInfo = 0,                                           // optional
+		};
 
-	std::filesystem::path full_path = exe_path.parent_path() / filename;
-	write_to_file( full_path.string().c_str(), os );
+		vkBeginCommandBuffer( batch.cmd, &begin_info );
 
-	std::error_code ec;
+		bool queue_supports_graphics = ( queue->queue_flags & VK_QUEUE_GRAPHICS_BIT );
 
-	std::filesystem::path link_path = exe_path.parent_path() / "queues.dot";
-	if ( std::filesystem::exists( link_path ) ) {
-		std::filesystem::remove( link_path );
-	}
-	std::filesystem::create_symlink( full_path, link_path, ec );
+		for ( auto const& r : batch.requests ) {
 
-	auto error_str = ec.message();
+			auto& dst = backend_resources.at( r.dst );
 
-	data->submissions.clear();
+			bool should_generate_miplevels = queue_supports_graphics &&
+			                                 dst.info.isImage() &&
+			                                 r.image_settings.num_miplevels > 1;
+
+			backend_uploads_record_request( batch.cmd, r, dst, should_generate_miplevels );
+
+			// Count upload as use, so that an image which was re-uploaded after it was selected
+			// for eviction does not get freed - see `backend_free_pending_evictions`.
+			dst.last_used_frame = self->mFramesCount;
+
+			if ( self->must_track_resources_queue_family_ownership ) {
+				// Record new owner in both front and back buffer, so that the next frame which
+				// uses this resource detects an ownership change, whichever buffer is current.
+				self->resource_queue_family_ownership[ 0 ][ r.dst ] = batch.queue_family_index;
+				self->resource_queue_family_ownership[ 1 ][ r.dst ] = batch.queue_family_index;
+			}
+		}
+
+		vkEndCommandBuffer( batch.cmd );
+
+		VkCommandBufferSubmitInfo cmd_submit_info{
+		    .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+		    .pNext         = nullptr,
+		    .commandBuffer = batch.cmd,
+		    .deviceMask    = 0, // replaces vkDeviceGroupSubmitInfo
+		};
+
+		VkSemaphoreSubmitInfo signal_upload_complete = {
+		    .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		    .pNext       = nullptr,
+		    .semaphore   = batch.semaphore,
+		    .value       = batch.signal_value,
+		    .stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, // signal semaphore once all commands have been processed
+		    .deviceIndex = 0,
+		};
+
+		VkSubmitInfo2 submit_info{
+		    .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+		    .pNext                    = nullptr,
+		    .flags                    = 0,
+		    .waitSemaphoreInfoCount   = 0,
+		    .pWaitSemaphoreInfos      = nullptr,
+		    .commandBufferInfoCount   = 1,
+		    .pCommandBufferInfos      = &cmd_submit_info,
+		    .signalSemaphoreInfoCount = 1,
+		    .pSignalSemaphoreInfos    = &signal_upload_complete,
+		};
+
+		// Note that we don't signal the per-queue timeline semaphore: frames wait for all
+		// per-queue semaphores before they present, and uploads must not hold up frames.
+		backend_submission_batch_add( submissions, queue, submit_info, "upload" );
+	}
 }
 
 // ----------------------------------------------------------------------
-// we wrap queue submissions so that we can log all parameters for a queue submission.
-static void backend_queue_submit( BackendQueueInfo* queue, uint32_t submission_count, VkSubmitInfo2 const* submitInfo, VkFence fence, bool should_generate_dot_files, std::string const& debug_info ) {
+// Submits copies for the open defragmentation pass to the default graphics queue. We submit
+// even if there is nothing to copy, as the timeline value which we signal tells us once it is
+// safe to end the pass.
+//
+// Frames which were acquired before the pass began may still use old versions of moved
+// resources - we must not submit copies with these frames, or old versions could be written
+// to after they have been copied. These frames have all been dispatched by the time we submit,
+// but their work may still be in flight on any queue: copies wait for every queue's timeline
+// to reach its last signalled value.
+//
+// Returns the timeline value which signals that copies have completed, for as long as the pass is
+// open - submissions to queues other than the default graphics queue must wait for this value, as
+// they may use moved resources. Returns 0 if there is nothing to wait for.
+static uint64_t backend_defragment_submit( le_backend_o* self, BackendFrameData const& frame, BackendSubmissionBatch& submissions ) {
 
-	if ( should_generate_dot_files ) {
+	auto [ backend_resources, lock ] = self->get_allocated_resources();
 
-		static QueueSubmissionLoggerData* data = get_queue_submission_logger_data();
+	auto& d = self->defragmentation;
 
-		VkSemaphoreSubmitInfo const*       wait_info      = submitInfo->pWaitSemaphoreInfos;
-		VkSemaphoreSubmitInfo const* const wait_infos_end = wait_info + submitInfo->waitSemaphoreInfoCount;
-		VkSemaphoreSubmitInfo const*       sign_info      = submitInfo->pSignalSemaphoreInfos;
-		VkSemaphoreSubmitInfo const* const sign_infos_end = sign_info + submitInfo->signalSemaphoreInfoCount;
+	if ( !d.is_pass_open || frame.frameNumber < d.move_frame_number ) {
+		return 0;
+	}
 
-		static auto semaphore_index = get_semaphore_indices();
-		static auto semaphore_names = get_semaphore_names();
+	if ( d.copy_complete_value != 0 ) {
+		// Copies were submitted with an earlier frame - but the pass has not ended yet.
+		return d.copy_complete_value;
+	}
 
-		QueueSubmissionLoggerData::submission_t submission;
-		submission.queue = queue;
-		do {
-			if ( wait_info != wait_infos_end ) {
-				auto it = semaphore_index->emplace( wait_info->semaphore, uint32_t( semaphore_index->size() ) );
-				if ( it.second ) {
-					// if an element was inserted
-					semaphore_names->push_back( std::to_string( semaphore_names->size() ) );
-					assert( semaphore_names->size() == semaphore_index->size() );
-				}
-				uint32_t                          wait_semaphore_id = it.first->second;
-				QueueSubmissionLoggerData::info_t info;
-				info.semaphore_id = wait_semaphore_id;
-				info.value        = uint32_t( wait_info->value & ~uint32_t( 0 ) ); // truncate to 32 bit value
-				submission.wait_semaphores.emplace_back( std::move( info ) );
-				wait_info++;
-			}
-			if ( sign_info != sign_infos_end ) {
-				auto it = semaphore_index->emplace( sign_info->semaphore, uint32_t( semaphore_index->size() ) );
-				if ( it.second ) {
-					// if an element was inserted
-					semaphore_names->push_back( std::to_string( semaphore_names->size() ) );
-					assert( semaphore_names->size() == semaphore_index->size() );
-				}
-				uint32_t                          sign_semaphore_id = it.first->second;
-				QueueSubmissionLoggerData::info_t info;
-				info.semaphore_id = sign_semaphore_id;
-				info.value        = uint32_t( sign_info->value & ~uint32_t( 0 ) ); // truncate to 32bit value
-				submission.signal_semaphores.emplace_back( std::move( info ) );
-				sign_info++;
-			}
+	// ----------| invariant: copies for the open pass have not been submitted yet
 
-		} while ( sign_info != sign_infos_end || wait_info != wait_infos_end );
-		submission.label = debug_info;
-		data->submissions.emplace_back( std::move( submission ) );
+	std::vector<VkSemaphoreSubmitInfo> wait_queues_idle;
+	wait_queues_idle.reserve( self->queues.size() );
+
+	for ( uint32_t i = 0; i != self->queues.size(); i++ ) {
+		if ( i == self->queue_default_graphics_idx || self->queues[ i ]->semaphore_wait_value == 0 ) {
+			// Earlier work on the default graphics queue is ordered before the copies by their leading barrier.
+			continue;
+		}
+		wait_queues_idle.push_back( {
+		    .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		    .pNext       = nullptr,
+		    .semaphore   = self->queues[ i ]->semaphore,
+		    .value       = self->queues[ i ]->semaphore_wait_value, // last value signalled by any earlier submission to this queue
+		    .stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		    .deviceIndex = 0,
+		} );
 	}
 
-	// --------- the actual queue submission happens here
+	BackendQueueInfo* queue = self->queues[ self->queue_default_graphics_idx ];
 
-	vkQueueSubmit2( queue->queue, submission_count, submitInfo, fence );
-};
+	d.copy_complete_value = queue->semaphore_get_next_signal_value();
+
+	VkCommandBufferSubmitInfo cmd_submit_info{
+	    .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+	    .pNext         = nullptr,
+	    .commandBuffer = d.cmd,
+	    .deviceMask    = 0, // replaces vkDeviceGroupSubmitInfo
+	};
+
+	VkSemaphoreSubmitInfo signal_copy_complete = {
+	    .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+	    .pNext       = nullptr,
+	    .semaphore   = queue->semaphore,
+	    .value       = d.copy_complete_value,
+	    .stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, // signal semaphore once all commands have been processed
+	    .deviceIndex = 0,
+	};
+
+	VkSubmitInfo2 submit_info{
+	    .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+	    .pNext                    = nullptr,
+	    .flags                    = 0,
+	    .waitSemaphoreInfoCount   = uint32_t( wait_queues_idle.size() ),
+	    .pWaitSemaphoreInfos      = wait_queues_idle.data(),
+	    .commandBufferInfoCount   = d.cmd ? 1u : 0u,
+	    .pCommandBufferInfos      = &cmd_submit_info,
+	    .signalSemaphoreInfoCount = 1,
+	    .pSignalSemaphoreInfos    = &signal_copy_complete,
+	};
+
+	backend_submission_batch_add( submissions, queue, submit_info, "defragment" );
+
+	return d.copy_complete_value;
+}
 
 // ----------------------------------------------------------------------
-static void backend_submit_queue_transfer_ops( le_backend_o* self, size_t frameIndex, bool should_generate_queue_sync_dot_files ) {
+static void backend_submit_queue_transfer_ops( le_backend_o* self, size_t frameIndex, BackendSubmissionBatch& submissions ) {
 
 	static auto logger = LeLog( LOGGER_LABEL );
 	auto&       frame  = self->mFrames[ frameIndex ];
@@ -7477,7 +10734,7 @@ static void backend_submit_queue_transfer_ops( le_backend_o* self, size_t frameI
 			};
 
 			// submit on the default queue for this queue family
-			backend_queue_submit( queue, 1, &submitInfo, nullptr, should_generate_queue_sync_dot_files, "release" );
+			backend_submission_batch_add( submissions, queue, submitInfo, "release" );
 		}
 	}
 
@@ -7572,7 +10829,7 @@ static void backend_submit_queue_transfer_ops( le_backend_o* self, size_t frameI
 			};
 
 			// submit on the queue chosen for this acquire barrier
-			backend_queue_submit( queue, 1, &submitInfo, nullptr, should_generate_queue_sync_dot_files, "acquire" );
+			backend_submission_batch_add( submissions, queue, submitInfo, "acquire" );
 		}
 	}
 
@@ -7651,7 +10908,7 @@ static void backend_submit_queue_transfer_ops( le_backend_o* self, size_t frameI
 
 			auto const& queue = self->queues[ queue_idx ];
 			// submit on the nd queue chosen for this acquire barrier
-			backend_queue_submit( queue, 1, &submitInfo, nullptr, should_generate_queue_sync_dot_files, "must_wait_acquire" );
+			backend_submission_batch_add( submissions, queue, submitInfo, "must_wait_acquire" );
 		}
 	}
 }
@@ -7665,9 +10922,24 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 	auto&       frame          = self->mFrames[ frameIndex ];
 	static auto graphics_queue = self->queues[ self->queue_default_graphics_idx ]->queue; // will not change for the duration of the program.
 
+	// All submissions for this frame are collected here, and handed to the driver
+	// in one go, just before we present.
+	BackendSubmissionBatch submissions;
+	submissions.should_generate_dot_files = frame.must_create_queues_dot_graph;
+
+	// Copies for defragmentation go first, so that uploads and passes see moved resources with their contents.
+	// Until the pass ends, this gives us the value which signals that copies have completed.
+	uint64_t const defragment_copy_value = backend_defragment_submit( self, frame, submissions );
+
+	// Free staging memory for uploads which have completed, and submit any pending uploads.
+	// Submitting uploads updates queue family ownership for their target resources, which is
+	// why this must happen before we add queue ownership transfer ops.
+	backend_uploads_retire_completed( self );
+	backend_uploads_submit_pending( self, submissions );
+
 	if ( self->must_track_resources_queue_family_ownership ) {
 		// add queue ownership transfer operations for resources which are shared across queue families.
-		backend_submit_queue_transfer_ops( self, frameIndex, frame.must_create_queues_dot_graph );
+		backend_submit_queue_transfer_ops( self, frameIndex, submissions );
 	}
 
 	std::vector<VkSemaphoreSubmitInfo> wait_present_complete_semaphore_submit_infos;
@@ -7716,7 +10988,7 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 
 		};
 
-		backend_queue_submit( self->queues[ self->queue_default_graphics_idx ], 1, &submitInfo, nullptr, frame.must_create_queues_dot_graph, "wait_present_complete" );
+		backend_submission_batch_add( submissions, self->queues[ self->queue_default_graphics_idx ], submitInfo, "wait_present_complete" );
 	}
 
 	for ( auto const& current_submission : frame.queue_submission_data ) {
@@ -7746,12 +11018,27 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 		    .deviceIndex = 0,
 		};
 
+		// Copies for defragmentation were submitted to the default graphics queue - until the
+		// defragmentation pass ends, submissions to other queues must wait for these, as they may
+		// use moved resources - even if they are the first submissions to their queue since the copies.
+		VkSemaphoreSubmitInfo wait_defragment_copies = {
+		    .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		    .pNext       = nullptr,
+		    .semaphore   = self->queues[ self->queue_default_graphics_idx ]->semaphore,
+		    .value       = defragment_copy_value,
+		    .stageMask   = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		    .deviceIndex = 0,
+		};
+
+		bool const must_wait_for_defragment_copies =
+		    defragment_copy_value != 0 && current_submission.queue_idx != self->queue_default_graphics_idx;
+
 		VkSubmitInfo2 submitInfo{
 		    .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
 		    .pNext                    = nullptr,
 		    .flags                    = 0,
-		    .waitSemaphoreInfoCount   = 0,
-		    .pWaitSemaphoreInfos      = nullptr,
+		    .waitSemaphoreInfoCount   = must_wait_for_defragment_copies ? 1u : 0u,
+		    .pWaitSemaphoreInfos      = must_wait_for_defragment_copies ? &wait_defragment_copies : nullptr,
 		    .commandBufferInfoCount   = uint32_t( command_buffer_submit_infos.size() ),
 		    .pCommandBufferInfos      = command_buffer_submit_infos.data(),
 		    .signalSemaphoreInfoCount = 1,
@@ -7760,7 +11047,7 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 
 		auto queue = self->queues[ current_submission.queue_idx ];
 
-		backend_queue_submit( queue, 1, &submitInfo, nullptr, frame.must_create_queues_dot_graph, " subgraph { " + current_submission.debug_root_passes_names + " }" );
+		backend_submission_batch_add( submissions, queue, submitInfo, " subgraph { " + current_submission.debug_root_passes_names + " }" );
 	}
 
 	{
@@ -7794,6 +11081,23 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 			} );
 		}
 
+		// Once this batch has completed, the whole frame has completed - we signal the default
+		// graphics queue's timeline semaphore, so that we can tell when the frame may be cleared.
+		// Note that we must do this after we have collected wait values above.
+
+		auto graphics_queue_info = self->queues[ self->queue_default_graphics_idx ];
+		frame.completion_value   = graphics_queue_info->semaphore_get_next_signal_value();
+
+		render_complete_semaphore_submit_infos.push_back(
+		    {
+		        .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		        .pNext       = nullptr,
+		        .semaphore   = graphics_queue_info->semaphore,
+		        .value       = frame.completion_value,
+		        .stageMask   = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		        .deviceIndex = 0,
+		    } );
+
 		// On default draw queue, wait for all timeline semaphores before signalling render complete.
 
 		VkSubmitInfo2 submitInfo{
@@ -7805,11 +11109,28 @@ static bool backend_dispatch_frame( le_backend_o* self, size_t frameIndex ) {
 		    .commandBufferInfoCount   = 0,                                           // No commands submitted, this submission is purely for synchronisation
 		    .pCommandBufferInfos      = nullptr,
 		    .signalSemaphoreInfoCount = uint32_t( render_complete_semaphore_submit_infos.size() ),
-		    .pSignalSemaphoreInfos    = render_complete_semaphore_submit_infos.data(), // signal render complete once this batch has finished processing
+		    .pSignalSemaphoreInfos    = render_complete_semaphore_submit_infos.data(), // signal render complete, and frame complete, once this batch has finished processing
 
 		};
 
-		backend_queue_submit( self->queues[ self->queue_default_graphics_idx ], 1, &submitInfo, frame.frameFence, frame.must_create_queues_dot_graph, "graphics_queue_finalize" );
+		backend_submission_batch_add( submissions, graphics_queue_info, submitInfo, "graphics_queue_finalize" );
+	}
+
+	{
+		LE_SETTING( le_setting_snapshot_t, LE_SETTING_BACKEND_QUEUE_SUBMIT_STATS, "" );
+
+		frame.num_queue_submit_calls = 0;
+		frame.num_queue_submissions  = 0;
+
+		backend_submission_batch_flush( submissions, &frame.num_queue_submit_calls, &frame.num_queue_submissions );
+
+		TracyPlot( "vkQueueSubmit2 calls", int64_t( frame.num_queue_submit_calls ) );
+
+		std::ostringstream msg;
+		msg << "vkQueueSubmit2 calls: " << frame.num_queue_submit_calls
+		    << ", batches: " << frame.num_queue_submissions;
+
+		LE_SETTING_BACKEND_QUEUE_SUBMIT_STATS->publish( msg.str() );
 	}
 
 	bool overall_result = true;
@@ -7939,6 +11260,7 @@ LE_MODULE_REGISTER_IMPL( le_backend_vk, api_ ) {
 	vk_backend_i.get_staging_allocator           = backend_get_staging_allocator;
 	vk_backend_i.get_frame_command_streams       = backend_get_frame_command_streams;
 	vk_backend_i.poll_frame_fence                = backend_poll_frame_fence;
+	vk_backend_i.wait_frame_fence                = backend_wait_frame_fence;
 	vk_backend_i.clear_frame                     = backend_clear_frame;
 	vk_backend_i.acquire_physical_resources      = backend_acquire_physical_resources;
 	vk_backend_i.process_frame                   = backend_process_frame;
@@ -7961,6 +11283,15 @@ LE_MODULE_REGISTER_IMPL( le_backend_vk, api_ ) {
 	vk_backend_i.create_rtx_blas_info = backend_create_rtx_blas_info;
 	vk_backend_i.create_rtx_tlas_info = backend_create_rtx_tlas_info;
 
+	vk_backend_i.upload_to_buffer   = backend_upload_to_buffer;
+	vk_backend_i.upload_to_image    = backend_upload_to_image;
+	vk_backend_i.get_upload_status  = backend_get_upload_status;
+
+	vk_backend_i.get_memory_budget    = backend_get_memory_budget;
+	vk_backend_i.get_gpu_pass_timings = backend_get_gpu_pass_timings;
+	vk_backend_i.set_image_evictable  = backend_set_image_evictable;
+	vk_backend_i.was_image_evicted    = backend_was_image_evicted;
+
 	auto& private_backend_i                                     = api_i->private_backend_vk_i;
 	private_backend_i.get_vk_device                             = backend_get_vk_device;
 	private_backend_i.get_vk_physical_device                    = backend_get_vk_physical_device;
@@ -8002,12 +11333,24 @@ LE_MODULE_REGISTER_IMPL( le_backend_vk, api_ ) {
 	auto& backend_settings_i                                        = api_i->le_backend_settings_i;
 	backend_settings_i.add_required_device_extension                = le_backend_vk_settings_add_required_device_extension;
 	backend_settings_i.add_required_instance_extension              = le_backend_vk_settings_add_required_instance_extension;
+	backend_settings_i.add_optional_device_extension                = le_backend_vk_settings_add_optional_device_extension;
+	backend_settings_i.get_optional_device_extensions               = le_backend_vk_settings_get_optional_device_extensions;
 	backend_settings_i.get_requested_physical_device_features_chain = le_backend_vk_get_requested_physical_device_features_chain;
 	backend_settings_i.set_concurrency_count                        = le_backend_vk_settings_set_concurrency_count;
 	backend_settings_i.get_requested_queue_capabilities             = le_backend_vk_settings_get_requested_queue_capabilities;
 	backend_settings_i.add_requested_queue_capabilities             = le_backend_vk_settings_add_requested_queue_capabilities;
 	backend_settings_i.set_requested_queue_capabilities             = le_backend_vk_settings_set_requested_queue_capabilities;
 	backend_settings_i.set_data_frames_count                        = le_backend_vk_settings_set_data_frames_count;
+	backend_settings_i.set_extended_dynamic_state_level             = le_backend_vk_settings_set_extended_dynamic_state_level;
+	backend_settings_i.get_extended_dynamic_state_level             = le_backend_vk_settings_get_extended_dynamic_state_level;
+	backend_settings_i.set_async_pipeline_compilation_threads       = le_backend_vk_settings_set_async_pipeline_compilation_threads;
+	backend_settings_i.get_async_pipeline_compilation_threads       = le_backend_vk_settings_get_async_pipeline_compilation_threads;
+	backend_settings_i.set_graphics_pipeline_library_enabled        = le_backend_vk_settings_set_graphics_pipeline_library_enabled;
+	backend_settings_i.get_graphics_pipeline_library_enabled        = le_backend_vk_settings_get_graphics_pipeline_library_enabled;
+	backend_settings_i.set_gpu_profiling_level                      = le_backend_vk_settings_set_gpu_profiling_level;
+	backend_settings_i.get_gpu_profiling_level                      = le_backend_vk_settings_get_gpu_profiling_level;
+	backend_settings_i.set_memory_budget_enabled                    = le_backend_vk_settings_set_memory_budget_enabled;
+	backend_settings_i.get_memory_budget_enabled                    = le_backend_vk_settings_get_memory_budget_enabled;
 
 	void** p_settings_singleton_addr = le_core_produce_dictionary_entry( hash_64_fnv1a_const( "backend_api_settings_singleton" ) );
 
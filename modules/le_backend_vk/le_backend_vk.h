@@ -86,9 +86,25 @@ struct LeShaderSourceLanguageEnum;
 
 
 struct le_resource_info_t;
+struct le_write_to_image_settings_t;
 
 struct le_backend_vk_settings_o; // global settings for backend singleton
 
+// Callback which provides an additional block of mapped memory to a linear allocator
+// once its current block is exhausted - must return false if no block could be provided.
+// Block must be at least `min_capacity` bytes, and `info->pUserData` must hold the
+// le_buf_resource_handle of the buffer which backs the block.
+typedef bool ( *le_allocator_grow_fun_t )( void* user_data, uint64_t min_capacity, VmaAllocationInfo* info );
+
+struct le_allocator_stats_t {
+	uint64_t bytes_allocated;    // bytes allocated since last reset, over all blocks
+	uint64_t bytes_high_water;   // peak bytes allocated between any two resets
+	uint64_t base_capacity;      // capacity of base block in bytes
+	uint32_t num_blocks_chained; // number of additional blocks chained since last reset
+};
+
+struct le_graphics_pipeline_builder_data; // ffdecl, see private/le_backend_vk/le_backend_types_pipeline.inl
+
 struct le_pipeline_layout_info {
 	uint64_t pipeline_layout_key     = 0;  // handle to pipeline layout
 	uint64_t set_layout_keys[ 8 ]    = {}; // maximum number of DescriptorSets is 8
@@ -102,17 +118,81 @@ struct le_pipeline_and_layout_info_t {
 	le_pipeline_layout_info layout_info;
 };
 
+struct le_pipeline_compilation_stats_t {
+	uint64_t num_pipelines_pending;    // pipelines which have been requested, but are not yet ready
+	uint64_t num_pipelines_compiled;   // total number of pipelines created on background threads
+	uint64_t num_draws_skipped;        // total number of draws skipped because their pipeline was not yet ready
+	uint64_t compile_latency_last_us;  // time from request to availability for the most recent pipeline, in microseconds
+	uint64_t compile_latency_max_us;   // maximum time from request to availability, in microseconds
+	uint64_t compile_latency_total_us; // sum over all times from request to availability, in microseconds
+};
+
+enum class le_upload_status_t : uint32_t {
+	ePending = 0, // upload was requested, but has not completed yet
+	eComplete,    // upload has completed on the GPU - the target resource may be used
+	eFailed,      // upload could not be submitted - the target resource was not written to
+};
+
+struct le_memory_heap_budget_t {
+	uint64_t budget_bytes;     // how much memory may be used from this heap - from the driver, capped by LE_SETTING_BACKEND_MEMORY_BUDGET_MB
+	uint64_t usage_bytes;      // how much memory this process currently uses from this heap
+	uint64_t allocation_bytes; // bytes in allocations made through the backend's allocator
+	uint64_t block_bytes;      // bytes in device memory blocks held by the backend's allocator
+	uint32_t allocation_count; // number of allocations made through the backend's allocator
+	uint32_t block_count;      // number of device memory blocks held by the backend's allocator
+	uint32_t is_device_local;  // whether this heap is device-local - budgets are enforced only for device-local heaps
+};
+
+struct le_gpu_pass_timing_t {
+	char const* debug_name;                  // pass debug name - stays valid for the lifetime of the backend
+	uint64_t    frame_number;                // frame in which this pass was last measured
+	double      gpu_ms;                      // GPU time spent on this pass, in milliseconds - summed over passes with the same name
+	uint64_t    input_assembly_primitives;   // pipeline statistics: only collected at gpu profiling level 2, and only on graphics queues
+	uint64_t    vertex_shader_invocations;   // -"-
+	uint64_t    fragment_shader_invocations; // -"-
+	uint64_t    compute_shader_invocations;  // -"-
+};
+
 struct le_backend_vk_api {
 
 	struct backend_vk_settings_interface_t // global settings for backend - must be set before backend setup- after that, settings are read-only.
 	{
 		bool ( *add_required_device_extension )( char const* ext );                           // returns true if successfully added - returns false if setting was already present
 		bool ( *add_required_instance_extension )( char const* ext );                         // -"-
+		bool ( *add_optional_device_extension )( char const* ext );                           // only enabled if supported by the physical device - see vk_device_i.is_extension_available
+		void ( *get_optional_device_extensions )( char const** exts, uint32_t* num_exts );    // call with exts == nullptr to query num_exts
 		VkPhysicalDeviceFeatures2 const* ( *get_requested_physical_device_features_chain )(); // readonly
 
 		void ( *set_concurrency_count )( uint32_t concurrency_count );
 		bool ( *set_data_frames_count )( uint32_t data_frames_count );
 
+		/// 0: off (default), 1..3: raster, depth, topology (and at level 3, blend) state become dynamic -
+		/// it is set via the encoder, and no longer contributes to vk pipeline hashes.
+		bool ( *set_extended_dynamic_state_level )( uint32_t level );
+		uint32_t ( *get_extended_dynamic_state_level )();
+
+		/// 0: off (default), otherwise: number of background threads which create graphics pipelines -
+		/// draws which use a pipeline that is not yet ready are skipped, or use the pso's fallback.
+		bool ( *set_async_pipeline_compilation_threads )( uint32_t num_threads );
+		uint32_t ( *get_async_pipeline_compilation_threads )();
+
+		/// false: off (default), true: link graphics pipelines from cached pipeline libraries,
+		/// so that new pipelines which share shader stages are fast to create. Uses VK_EXT_graphics_pipeline_library
+		/// if the device supports it - otherwise this setting is reset to false when the device is created.
+		bool ( *set_graphics_pipeline_library_enabled )( bool enabled );
+		bool ( *get_graphics_pipeline_library_enabled )();
+
+		/// 0: off (default), 1: measure GPU time per pass via timestamp queries,
+		/// 2: also collect pipeline statistics for passes on graphics queues. See `get_gpu_pass_timings`.
+		bool ( *set_gpu_profiling_level )( uint32_t level );
+		uint32_t ( *get_gpu_profiling_level )();
+
+		/// false: off (default), true: query per-heap memory budgets from the driver. Uses VK_EXT_memory_budget
+		/// if the device supports it - otherwise this setting is reset to false when the device is created.
+		/// If off, budgets are estimated from heap sizes.
+		bool ( *set_memory_budget_enabled )( bool enabled );
+		bool ( *get_memory_budget_enabled )();
+
 		void ( *get_requested_queue_capabilities )( VkQueueFlags* queues, uint32_t* num_queues );
 		/// prefer add over set - as set will erase any previously added queues
 		bool ( *set_requested_queue_capabilities )( VkQueueFlags* queues, uint32_t num_queues );
@@ -127,7 +207,8 @@ struct le_backend_vk_api {
 		void 				   ( *initialise 				 ) ( le_backend_o* self);
 		void                   ( *setup                      ) ( le_backend_o *self);
 
-		bool                   ( *poll_frame_fence           ) ( le_backend_o* self, size_t frameIndex);
+		bool                   ( *poll_frame_fence           ) ( le_backend_o* self, size_t frameIndex); // never blocks
+		bool                   ( *wait_frame_fence           ) ( le_backend_o* self, size_t frameIndex, uint64_t timeout_ns); // returns false on timeout
 		bool                   ( *clear_frame                ) ( le_backend_o *self, size_t frameIndex );
 		void                   ( *process_frame              ) ( le_backend_o *self, size_t frameIndex );
 		bool                   ( *acquire_physical_resources ) ( le_backend_o *self, size_t frameIndex, le_renderpass_o **passes, size_t numRenderPasses, le_resource_handle const * declared_resources, le_resource_info_t const * declared_resources_infos, size_t const & declared_resources_count );
@@ -165,6 +246,31 @@ struct le_backend_vk_api {
 
 		le_rtx_blas_info_handle( *create_rtx_blas_info )(le_backend_o* self, le_rtx_geometry_t const * geometries, uint32_t geometries_count,le::BuildAccelerationStructureFlagsKHR const * flags);
 		le_rtx_tlas_info_handle( *create_rtx_tlas_info )(le_backend_o* self,  uint32_t instances_count, le::BuildAccelerationStructureFlagsKHR const * flags);
+
+		// Asynchronous uploads: data is copied to staging memory immediately, and then written to the target resource
+		// on a transfer queue (if available) over the next frames. Returns an upload ticket, or 0 on error.
+		// `dst_info` is optional: if given, the target resource is allocated if it does not exist yet.
+		// The target resource must not be used by any rendergraph until `get_upload_status` returns eComplete for its ticket.
+		// `get_upload_status` reports eFailed only once per ticket - a ticket must not be queried again after that.
+		uint64_t               ( *upload_to_buffer   ) ( le_backend_o* self, le_buf_resource_handle dst_buffer, le_resource_info_t const* dst_info, uint64_t dst_offset, void const* data, uint64_t num_bytes );
+		uint64_t               ( *upload_to_image    ) ( le_backend_o* self, le_img_resource_handle dst_image, le_resource_info_t const* dst_info, le_write_to_image_settings_t const* write_info, void const* data, uint64_t num_bytes );
+		le_upload_status_t     ( *get_upload_status  ) ( le_backend_o* self, uint64_t upload_ticket );
+
+		// Memory budget: fills `heaps` with one entry per memory heap; call with `heaps` == nullptr to query `num_heaps`.
+		void                   ( *get_memory_budget  ) ( le_backend_o* self, le_memory_heap_budget_t* heaps, uint32_t* num_heaps );
+
+		// GPU profiling: fills `timings` with the most recent GPU timings per pass debug name; call with `timings` == nullptr to query `num_timings`.
+		// Only available if gpu profiling level was set via backend settings.
+		void                   ( *get_gpu_pass_timings ) ( le_backend_o* self, le_gpu_pass_timing_t* timings, uint32_t* num_timings );
+
+		// Evictable images may be freed by the backend if device-local memory exceeds its budget, and
+		// the image was not used by any pass for a while. Once `was_image_evicted` - which returns true
+		// once per eviction - says so, whoever set the image evictable must write its contents again
+		// before a pass next reads from it, and should not touch it until then.
+		// The image is only freed once all frames recorded before that have been acquired - if it is
+		// written to or used again before then, its eviction is cancelled.
+		void                   ( *set_image_evictable ) ( le_backend_o* self, le_img_resource_handle image, bool evictable );
+		bool                   ( *was_image_evicted   ) ( le_backend_o* self, le_img_resource_handle image );
 	};
 
 	struct private_backend_vk_interface_t {
@@ -253,10 +359,18 @@ struct le_backend_vk_api {
 		le_pipeline_and_layout_info_t            ( *produce_rtx_pipeline              ) ( le_pipeline_manager_o *self, le_rtxpso_handle rtxpsoHandle, char ** shader_group_data);
 		le_pipeline_and_layout_info_t            ( *produce_compute_pipeline          ) ( le_pipeline_manager_o *self, le_cpso_handle cpsoHandle);
 
+		// Async pipeline compilation - see backend settings: set_async_pipeline_compilation_threads
+		void                                     ( *get_async_compilation_stats       ) ( le_pipeline_manager_o* self, le_pipeline_compilation_stats_t* stats );
+		void                                     ( *add_skipped_draws                 ) ( le_pipeline_manager_o* self, uint32_t num_draws );
+
+		// Creates graphics pipelines recorded in the pipeline manifest (see LE_SETTING_RECORD_PIPELINE_MANIFEST) - returns number of pipelines created.
+		uint32_t                                 ( *create_pipelines_from_manifest    ) ( le_pipeline_manager_o* self );
+
 		le_shader_module_handle                  ( *create_shader_module              ) ( le_pipeline_manager_o* self, char const * path, const LeShaderSourceLanguageEnum& shader_source_language, const le::ShaderStageFlagBits& moduleType, char const *macro_definitions, le_shader_module_handle handle, VkSpecializationMapEntry const * specialization_map_entries, uint32_t specialization_map_entries_count, void * specialization_map_data, uint32_t specialization_map_data_num_bytes);
 		void                                     ( *update_shader_modules             ) ( le_pipeline_manager_o* self );
 
         bool                                     ( *graphics_pipeline_add_shader_stage )(le_pipeline_manager_o* self, le_gpso_handle gpsoHandle, le_shader_module_handle shader_stage);
+		le_graphics_pipeline_builder_data const* ( *get_graphics_pipeline_state_data  ) ( le_pipeline_manager_o* self, le_gpso_handle gpsoHandle );
 
 		struct VkPipelineLayout_T*               ( *get_pipeline_layout               ) ( le_pipeline_manager_o* self, uint64_t pipeline_layout_key);
 		const struct le_descriptor_set_layout_t* ( *get_descriptor_set_layout         ) ( le_pipeline_manager_o* self, uint64_t setlayout_key);
@@ -267,13 +381,21 @@ struct le_backend_vk_api {
 		void                    ( *destroy              ) ( le_allocator_o* self );
 		bool                    ( *allocate             ) ( le_allocator_o* self, uint64_t numBytes, void ** pData, uint64_t* bufferOffset, le_buf_resource_handle *p_buffer);
 		void                    ( *reset                ) ( le_allocator_o* self );
+
+		// Replaces base block - only valid directly after reset.
+		void                    ( *set_base_block       ) ( le_allocator_o* self, VmaAllocationInfo const *info );
+		// If set, allocator chains a block provided by grow_fun whenever its current block is exhausted.
+		void                    ( *set_grow_callback    ) ( le_allocator_o* self, le_allocator_grow_fun_t grow_fun, void* user_data );
+		void                    ( *get_stats            ) ( le_allocator_o* self, le_allocator_stats_t* stats );
 	};
 
 	struct staging_allocator_interface_t {
 		le_staging_allocator_o* ( *create  )( VmaAllocator_T* const vmaAlloc, VkDevice_T* const device );
 		void                    ( *destroy )( le_staging_allocator_o* self ) ;
 		void                    ( *reset   )( le_staging_allocator_o* self );
-		bool                    ( *map     )( le_staging_allocator_o* self, uint64_t numBytes, void **pData, le_buf_resource_handle *resource_handle );
+		// Sub-allocates numBytes of mapped staging memory; data written to *pData may be read by transfer
+		// commands via *resource_handle at *offset, for the current frame. *offset is a multiple of alignment.
+		bool                    ( *map     )( le_staging_allocator_o* self, uint64_t numBytes, uint64_t alignment, void **pData, le_buf_resource_handle *resource_handle, uint64_t* offset );
 	};
 
 	struct shader_module_interface_t {
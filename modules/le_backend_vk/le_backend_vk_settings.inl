@@ -8,6 +8,7 @@
 #include <string>
 #include <vulkan/vulkan.h>
 #include <cstring> // for memcpy
+#include <algorithm> // for std::find
 
 struct le_backend_vk_settings_o {
 	std::set<std::string> required_instance_extensions_set; // we use set to give us permanent addresses for char*, and to ensure uniqueness of requested extensions
@@ -17,15 +18,20 @@ struct le_backend_vk_settings_o {
 	                                                        //
 	std::vector<char const*> required_instance_extensions;  //
 	std::vector<char const*> required_device_extensions;    //
+                                                        //
+	std::set<std::string>    optional_device_extensions_set; // extensions which are only enabled if the physical device supports them
+	std::vector<char const*> optional_device_extensions;     // kept in sync with optional_device_extensions_set
 
 	struct RequestedDeviceFeatures {
-		VkPhysicalDeviceFeatures2                        features;
-		VkPhysicalDeviceVulkan11Features                 vk_11;
-		VkPhysicalDeviceVulkan12Features                 vk_12;
-		VkPhysicalDeviceVulkan13Features                 vk_13;
-		VkPhysicalDeviceRayTracingPipelineFeaturesKHR    ray_tracing_pipeline;
-		VkPhysicalDeviceAccelerationStructureFeaturesKHR acceleration_structure;
-		VkPhysicalDeviceMeshShaderFeaturesNV             mesh_shader;
+		VkPhysicalDeviceFeatures2                          features;
+		VkPhysicalDeviceVulkan11Features                   vk_11;
+		VkPhysicalDeviceVulkan12Features                   vk_12;
+		VkPhysicalDeviceVulkan13Features                   vk_13;
+		VkPhysicalDeviceRayTracingPipelineFeaturesKHR      ray_tracing_pipeline;
+		VkPhysicalDeviceAccelerationStructureFeaturesKHR   acceleration_structure;
+		VkPhysicalDeviceMeshShaderFeaturesNV               mesh_shader;
+		VkPhysicalDeviceExtendedDynamicState3FeaturesEXT   extended_dynamic_state_3;
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphics_pipeline_library;
 	} requested_device_features;
 
 	std::vector<VkQueueFlags> requested_queues_capabilities = {
@@ -33,9 +39,14 @@ struct le_backend_vk_settings_o {
 	    //	    VK_QUEUE_COMPUTE_BIT,
 	}; // each entry stands for one queue and its capabilities
 
-	uint32_t         data_frames_count = 2; // mumber of backend data frames - must be at minimum 2
-	uint32_t         concurrency_count = 1; // number of potential worker threads
-	std::atomic_bool readonly          = false;
+	uint32_t         data_frames_count                  = 2; // mumber of backend data frames - must be at minimum 2
+	uint32_t         concurrency_count                  = 1; // number of potential worker threads
+	uint32_t         extended_dynamic_state_level       = 0; // 0: off, 1..3: which VK_EXT_extended_dynamic_state{,2,3} states are set via the encoder rather than baked into pipelines
+	uint32_t         async_pipeline_compilation_threads = 0;     // 0: off, otherwise number of background threads used to create graphics pipelines
+	bool             graphics_pipeline_library_enabled  = false; // whether graphics pipelines are linked from pipeline libraries (VK_EXT_graphics_pipeline_library)
+	uint32_t         gpu_profiling_level                = 0;     // 0: off, 1: per-pass GPU timestamps, 2: timestamps and pipeline statistics
+	bool             memory_budget_enabled              = false; // whether per-heap memory budgets are queried from the driver (VK_EXT_memory_budget)
+	std::atomic_bool readonly                           = false;
 };
 
 static bool le_backend_vk_settings_set_requested_queue_capabilities( VkQueueFlags* queues, uint32_t num_queues ) {
@@ -205,6 +216,14 @@ static le_backend_vk_settings_o* le_backend_vk_settings_create() {
 	};
 	self->requested_device_features.mesh_shader = {
 	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_NV,
+	    .pNext = &self->requested_device_features.extended_dynamic_state_3, // optional
+	};
+	self->requested_device_features.extended_dynamic_state_3 = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+	    .pNext = &self->requested_device_features.graphics_pipeline_library, // optional
+	};
+	self->requested_device_features.graphics_pipeline_library = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
 	    .pNext = nullptr, // optional
 	};
 
@@ -252,6 +271,47 @@ static void le_backend_vk_settings_destroy( le_backend_vk_settings_o* self ) {
 	delete self;
 }
 
+// ----------------------------------------------------------------------
+// Optional device extensions are only enabled if the physical device supports them -
+// use `vk_device_i.is_extension_available` to find out whether they were enabled.
+static bool le_backend_vk_settings_add_optional_device_extension( le_backend_vk_settings_o* self, char const* ext ) {
+	if ( self->readonly == false ) {
+		auto const& [ str, was_inserted ] = self->optional_device_extensions_set.emplace( ext );
+		if ( was_inserted ) {
+			self->optional_device_extensions.push_back( str->c_str() );
+		}
+		return true;
+	} else {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot add optional device extension '%s'", ext );
+		return false;
+	}
+}
+
+// ----------------------------------------------------------------------
+
+static void le_backend_vk_settings_remove_optional_device_extension( le_backend_vk_settings_o* self, char const* ext ) {
+	auto it = self->optional_device_extensions_set.find( ext );
+	if ( it == self->optional_device_extensions_set.end() ) {
+		return;
+	}
+	// ----------| invariant: extension was found in set - remove it from vector before it gets erased from set
+	self->optional_device_extensions.erase( std::find( self->optional_device_extensions.begin(), self->optional_device_extensions.end(), it->c_str() ) );
+	self->optional_device_extensions_set.erase( it );
+}
+
+// ----------------------------------------------------------------------
+
+static void le_backend_vk_settings_get_optional_device_extensions( char const** exts, uint32_t* num_exts ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( num_exts ) {
+		*num_exts = uint32_t( self->optional_device_extensions.size() );
+	}
+	if ( exts ) {
+		memcpy( exts, self->optional_device_extensions.data(), self->optional_device_extensions.size() * sizeof( char const* ) );
+	}
+}
+
 // ----------------------------------------------------------------------
 
 static bool le_backend_vk_settings_add_required_instance_extension( char const* ext ) {
@@ -268,6 +328,13 @@ static bool le_backend_vk_settings_add_required_device_extension( char const* ex
 
 // ----------------------------------------------------------------------
 
+static bool le_backend_vk_settings_add_optional_device_extension( char const* ext ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return le_backend_vk_settings_add_optional_device_extension( self, ext );
+}
+
+// ----------------------------------------------------------------------
+
 static void le_backend_vk_settings_set_concurrency_count( uint32_t concurrency_count ) {
 	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
 	self->concurrency_count        = concurrency_count;
@@ -284,6 +351,162 @@ static bool le_backend_vk_settings_set_data_frames_count( uint32_t data_frames_c
 	return true;
 }
 
+// ----------------------------------------------------------------------
+// Level 1 and 2 states (cull mode, front face, topology, depth/stencil test, depth bias enable,
+// primitive restart, rasterizer discard) are core since Vulkan 1.3, level 3 (polygon mode,
+// colour blend, colour write mask) requires VK_EXT_extended_dynamic_state3.
+static bool le_backend_vk_settings_set_extended_dynamic_state_level( uint32_t level ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( self->readonly || level > 3 ) {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot set extended dynamic state level to %d", level );
+		return false;
+	}
+	// ----------| invariant: settings is not readonly, level is valid
+	self->extended_dynamic_state_level = level;
+
+	if ( level >= 3 ) {
+		le_backend_vk_settings_add_required_device_extension( self, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME );
+
+		auto& features                                   = self->requested_device_features.extended_dynamic_state_3;
+		features.extendedDynamicState3PolygonMode        = VK_TRUE;
+		features.extendedDynamicState3ColorBlendEnable   = VK_TRUE;
+		features.extendedDynamicState3ColorBlendEquation = VK_TRUE;
+		features.extendedDynamicState3ColorWriteMask     = VK_TRUE;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t le_backend_vk_settings_get_extended_dynamic_state_level() {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return self->extended_dynamic_state_level;
+}
+
+// ----------------------------------------------------------------------
+// If set to a non-zero number of threads, graphics pipelines which are not yet available
+// get created on background threads, and draws which would use them are skipped (or use
+// the pipeline's fallback, if it has one) until they are ready.
+static bool le_backend_vk_settings_set_async_pipeline_compilation_threads( uint32_t num_threads ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( self->readonly ) {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot set async pipeline compilation threads: settings are readonly" );
+		return false;
+	}
+	// ----------| invariant: settings is not readonly
+	self->async_pipeline_compilation_threads = num_threads;
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t le_backend_vk_settings_get_async_pipeline_compilation_threads() {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return self->async_pipeline_compilation_threads;
+}
+
+// ----------------------------------------------------------------------
+// If enabled, graphics pipelines are linked from pipeline libraries, which the pipeline
+// manager caches per shader stage set - this requires VK_EXT_graphics_pipeline_library.
+//
+// The extension is requested as optional: if the device does not support it, device
+// creation resets this setting to false, and pipelines are created monolithically.
+static bool le_backend_vk_settings_set_graphics_pipeline_library_enabled( bool enabled ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( self->readonly ) {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot set graphics pipeline library enabled: settings are readonly" );
+		return false;
+	}
+	// ----------| invariant: settings is not readonly
+	self->graphics_pipeline_library_enabled = enabled;
+
+	if ( enabled ) {
+		le_backend_vk_settings_add_optional_device_extension( self, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME );
+		le_backend_vk_settings_add_optional_device_extension( self, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME );
+	} else {
+		le_backend_vk_settings_remove_optional_device_extension( self, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME );
+		le_backend_vk_settings_remove_optional_device_extension( self, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME );
+	}
+
+	self->requested_device_features.graphics_pipeline_library.graphicsPipelineLibrary = enabled ? VK_TRUE : VK_FALSE;
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static bool le_backend_vk_settings_get_graphics_pipeline_library_enabled() {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return self->graphics_pipeline_library_enabled;
+}
+
+// ----------------------------------------------------------------------
+// If enabled, the backend's allocator queries per-heap budget and usage from the
+// driver - otherwise, budgets are estimated from heap sizes and own allocations.
+//
+// The extension is requested as optional: if the device does not support it, device
+// creation resets this setting to false, and budgets are estimated from heap sizes.
+static bool le_backend_vk_settings_set_memory_budget_enabled( bool enabled ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( self->readonly ) {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot set memory budget enabled: settings are readonly" );
+		return false;
+	}
+	// ----------| invariant: settings is not readonly
+	self->memory_budget_enabled = enabled;
+
+	if ( enabled ) {
+		le_backend_vk_settings_add_optional_device_extension( self, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+	} else {
+		le_backend_vk_settings_remove_optional_device_extension( self, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static bool le_backend_vk_settings_get_memory_budget_enabled() {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return self->memory_budget_enabled;
+}
+
+// ----------------------------------------------------------------------
+// Level 1 measures GPU time per pass via timestamp queries, level 2 adds pipeline
+// statistics queries for passes on graphics queues.
+static bool le_backend_vk_settings_set_gpu_profiling_level( uint32_t level ) {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	if ( self->readonly || level > 2 ) {
+		static auto logger = LeLog( "le_backend_vk_settings" );
+		logger.error( "Cannot set gpu profiling level to %d", level );
+		return false;
+	}
+	// ----------| invariant: settings is not readonly, level is valid
+	self->gpu_profiling_level = level;
+
+	if ( level >= 1 ) {
+		// We reset query pools from the host, once we have read back their results.
+		self->requested_device_features.vk_12.hostQueryReset = VK_TRUE;
+	}
+	if ( level >= 2 ) {
+		self->requested_device_features.features.features.pipelineStatisticsQuery = VK_TRUE;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t le_backend_vk_settings_get_gpu_profiling_level() {
+	le_backend_vk_settings_o* self = le_backend_vk::api->backend_settings_singleton;
+	return self->gpu_profiling_level;
+}
+
 // ----------------------------------------------------------------------
 
 static VkPhysicalDeviceFeatures2 const* le_backend_vk_get_requested_physical_device_features_chain() {
@@ -40,7 +40,7 @@ struct le_device_o {
 	std::vector<VkQueueFlags> queues_flags;        // per-queue capability flags
 	std::vector<uint32_t>     queues_family_index; // per-queue family index
 
-	std::set<std::string> requestedDeviceExtensions;
+	std::set<std::string> requestedDeviceExtensions; // extensions which the device was created with - required, and supported optional extensions
 
 	VkFormat defaultDepthStencilFormat;
 	VkFormat defaultColorAttachmentFormat;
@@ -343,6 +343,71 @@ static le_device_o* device_create( le_backend_vk_instance_o* backend_instance, c
 			self->requestedDeviceExtensions.insert( *ext );
 		}
 
+		// Optional extensions are only enabled if the physical device supports them -
+		// this means that `requestedDeviceExtensions` holds exactly the extensions
+		// which the device is created with.
+
+		std::set<std::string> supportedDeviceExtensions;
+		{
+			uint32_t num_supported_extensions = 0;
+			vkEnumerateDeviceExtensionProperties( self->vkPhysicalDevice, nullptr, &num_supported_extensions, nullptr );
+			std::vector<VkExtensionProperties> supported_extensions( num_supported_extensions );
+			vkEnumerateDeviceExtensionProperties( self->vkPhysicalDevice, nullptr, &num_supported_extensions, supported_extensions.data() );
+			for ( auto const& p : supported_extensions ) {
+				supportedDeviceExtensions.insert( p.extensionName );
+			}
+		}
+
+		// Graphics pipeline libraries need the device feature as well as the extension - if either
+		// is missing we switch the setting off; this also removes its optional extensions.
+		// Settings are still writable at this point, as they only become readonly on backend setup.
+
+		if ( settings_i.get_graphics_pipeline_library_enabled() ) {
+
+			bool is_supported = supportedDeviceExtensions.count( VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME ) &&
+			                    supportedDeviceExtensions.count( VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME );
+
+			if ( is_supported ) {
+				VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl_features = {
+				    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+				    .pNext = nullptr,
+				};
+				VkPhysicalDeviceFeatures2 features = {
+				    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+				    .pNext = &gpl_features,
+				};
+				vkGetPhysicalDeviceFeatures2( self->vkPhysicalDevice, &features );
+				is_supported = ( gpl_features.graphicsPipelineLibrary == VK_TRUE );
+			}
+
+			if ( !is_supported ) {
+				logger.warn( "Graphics pipeline libraries are not supported by this device - graphics pipelines will be created without them." );
+				settings_i.set_graphics_pipeline_library_enabled( false );
+			}
+		}
+
+		// Without VK_EXT_memory_budget, we switch off querying budgets from the driver - the
+		// allocator then estimates budgets from heap sizes instead.
+
+		if ( settings_i.get_memory_budget_enabled() &&
+		     0 == supportedDeviceExtensions.count( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME ) ) {
+			logger.warn( "Memory budgets are not supported by this device - budgets will be estimated from heap sizes." );
+			settings_i.set_memory_budget_enabled( false );
+		}
+
+		uint32_t num_optional_extensions = 0;
+		settings_i.get_optional_device_extensions( nullptr, &num_optional_extensions );
+		std::vector<char const*> optional_extensions( num_optional_extensions );
+		settings_i.get_optional_device_extensions( optional_extensions.data(), &num_optional_extensions );
+
+		for ( auto const& ext : optional_extensions ) {
+			if ( supportedDeviceExtensions.count( ext ) ) {
+				self->requestedDeviceExtensions.insert( ext );
+			} else {
+				logger.warn( "Optional device extension not supported, will not be enabled: '%s'", ext );
+			}
+		}
+
 		// We then copy the strings with the names for requested extensions
 		// into this object's storage, so that we can be sure the pointers
 		// will not go stale.
@@ -9,13 +9,20 @@
 #include <filesystem> // for parsing shader source file paths
 #include <fstream>    // for reading shader source files
 #include <cstring>    // for memcpy
+#include <cstdio>     // for snprintf
 #include <mutex>
 #include <shared_mutex>
 #include <atomic>
 #include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <type_traits>
 
 #include "le_core.h"
 #include "le_shader_compiler.h"
+#include "le_jobs.h"
 
 #include "util/spirv_reflect/spirv_reflect.h"
 
@@ -27,9 +34,21 @@ static constexpr auto LOGGER_LABEL = "le_pipeline";
 
 #include <vulkan/vulkan.h>
 #include "private/le_backend_vk/le_backend_types_pipeline.inl"
+#include "private/le_backend_vk/le_hash_map.h"
 
 #include "le_tracy.h"
 
+#ifndef LE_MT
+#	define LE_MT 0
+#endif
+
+#ifdef _MSC_VER
+#	define NOMINMAX     // we do this so that Windows.h does not define min and max macros
+#	include <Windows.h> // for GetModuleFileName
+#else
+#	include <unistd.h> // for readlink
+#endif
+
 typedef void ( *file_watcher_callback_fun_t )( char const*, void* );
 
 struct specialization_map_info_t {
@@ -55,153 +74,6 @@ struct le_shader_module_o {
 	specialization_map_info_t                      specialization_map_info; ///< information concerning specialization constants for this shader stage
 };
 
-// A table from `handle` -> `object*`, protected by mutex.
-//
-// Access is internally synchronised.
-//
-// lookup time will deteriorate linearly with number of elements,
-// but cache locality is very good for lookups, so this should work
-// fairly well for small number of resources such as pipelines.
-template <typename T, typename U>
-class HashTable : NoCopy, NoMove {
-
-	std::shared_mutex mtx;
-	std::vector<T>    handles;
-	std::vector<U*>   objects; // owning, object is copied on add_entry
-
-  public:
-	// Insert a new obj into table, object is copied.
-	// return true if successful, false if entry aready existed.
-	// in case return value is false, object was not copied.
-	bool try_insert( T const& handle, U* obj ) {
-		mtx.lock();
-		size_t i = 0;
-		for ( auto const& h : handles ) {
-			if ( h == handle ) {
-				break;
-			}
-			i++;
-		}
-		if ( i != handles.size() ) {
-			// entry already existed - this is strange.
-			mtx.unlock();
-			return false;
-		}
-		// -------| invariant: i == handles.size()
-		handles.push_back( handle );
-		objects.emplace_back( new U( *obj ) ); // make a copy
-		mtx.unlock();
-		return true;
-	}
-
-	// Looks up table entry under `needle`,
-	// returns nullptr if not found.
-	U* const try_find( T const& needle ) {
-		mtx.lock_shared();
-		U* const* obj = objects.data();
-		for ( auto const& h : handles ) {
-			if ( h == needle ) {
-				mtx.unlock();
-				return *obj;
-			}
-			obj++;
-		}
-		// --------| Invariant: no handle matching needle found
-		mtx.unlock();
-		return nullptr;
-	}
-
-	typedef void ( *iterator_fun )( U* e, void* user_data );
-
-	// do something on all objects
-	void iterator( iterator_fun fun, void* user_data ) {
-		mtx.lock();
-		for ( auto& e : objects ) {
-			fun( e, user_data );
-		}
-		mtx.unlock();
-	}
-
-	void clear() {
-		mtx.lock();
-		for ( auto& obj : objects ) {
-			delete obj;
-		}
-		handles.clear();
-		objects.clear();
-		mtx.unlock();
-	}
-
-	~HashTable() {
-		clear();
-	}
-};
-
-//
-template <typename S, typename T>
-class HashMap : NoCopy, NoMove {
-
-	std::shared_mutex         mtx;
-	std::unordered_map<S, T*> store; // owning, object is copied on successful try_insert
-
-  public:
-	T* try_find( S needle ) {
-		mtx.lock_shared();
-		auto e = store.find( needle );
-		if ( e == store.end() ) {
-			mtx.unlock();
-			return nullptr;
-		} else {
-			auto ret = e->second;
-			mtx.unlock();
-			return ret;
-		}
-	}
-	// returns true and stores copy of obj in internal hash - or
-	// returns false if element with key already existed.
-	bool try_insert( S handle, T* obj ) {
-
-		mtx.lock();
-
-		// we attempt an insertion - a nullptr will go in as a placeholder
-		// because we cannot tell at this point whether the insertion will
-		// be successful.
-		auto result = store.emplace( handle, nullptr );
-
-		if ( result.second ) {
-			// Insertion was successful - replace the placeholder with a copy of the actual object.
-			result.first->second = new T( *obj );
-		}
-
-		mtx.unlock();
-
-		return result.second;
-	}
-
-	typedef void ( *iterator_fun )( T* e, void* user_data );
-
-	// do something on all objects
-	void iterator( iterator_fun fun, void* user_data ) {
-		mtx.lock();
-		for ( auto& e : store ) {
-			fun( e.second, user_data );
-		}
-		mtx.unlock();
-	}
-
-	void clear() {
-		mtx.lock();
-		for ( auto& e : store ) {
-			delete ( e.second );
-		}
-		store.clear();
-		mtx.unlock();
-	}
-	~HashMap() {
-		clear();
-	}
-};
-
 struct ProtectedModuleDependencies {
 	std::mutex                                                         mtx;
 	std::unordered_map<std::string, std::set<le_shader_module_handle>> moduleDependencies; // map 'canonical shader source file path, watch_id' -> [shader modules]
@@ -220,8 +92,53 @@ struct le_shader_manager_o {
 
 	le_shader_compiler_o* shader_compiler   = nullptr; // owning
 	le_file_watcher_o*    shaderFileWatcher = nullptr; // owning
+
+	std::vector<le_shader_compiler_o*> worker_shader_compilers; // owning, one per le_jobs worker thread, created on first use; only accessed by the worker thread with matching index
+
+	std::shared_mutex modules_mtx; // held exclusively while modified shader modules are applied; shared while pipelines get created on background threads
+};
+
+// Attachment description - holds only what matters for renderpass compatibility.
+struct le_pipeline_compatible_attachment_t {
+	uint32_t format;  // VkFormat
+	uint32_t samples; // VkSampleCountFlagBits
+	uint32_t type;    // AttachmentInfo::Type
+	uint32_t reserved;
+};
+
+// A request to create a graphics pipeline on a background thread.
+//
+// Pipeline creation needs a renderpass which is compatible with the renderpass that
+// the pipeline is used with. We can't borrow the requesting frame's renderpass, as the
+// frame may be cleared before the request completes - instead, each request keeps a
+// description of its renderpass attachments, from which the background thread creates
+// a compatible renderpass which only lives for as long as the request.
+struct le_pipeline_compile_request_t {
+	uint64_t                                         pipeline_hash;         // hash under which to publish the pipeline
+	graphics_pipeline_state_o const*                 pso;                   // non-owning, psos are never removed from the pipeline manager
+	std::vector<le_pipeline_compatible_attachment_t> attachments;           // attachments of the requesting renderpass
+	uint64_t                                         renderpass_hash;       // hash for *compatible* renderpass
+	uint16_t                                         num_color_attachments; //
+	le::SampleCountFlagBits                          sample_count;          //
+	uint32_t                                         subpass;               //
+	std::chrono::steady_clock::time_point            time_requested;        // used to calculate compile latency
+};
+
+struct le_pipeline_async_compiler_o {
+	std::vector<std::thread> threads;
+
+	std::mutex              mtx;         // protects all members below
+	std::condition_variable cv_requests; // signalled when a request was added, or when threads should stop
+
+	std::deque<le_pipeline_compile_request_t> requests;          // pending requests, in order of submission
+	std::set<uint64_t>                        pending_pipelines; // pipeline hashes which were requested, but not yet published
+	bool                                      should_stop = false;
+
+	le_pipeline_compilation_stats_t stats = {};
 };
 
+struct le_pipeline_manifest_o; // ffdecl, see le_pipeline_manifest_record
+
 // NOTE: It might make sense to have one pipeline manager per worker thread, and
 //       to consolidate after the frame has been processed.
 struct le_pipeline_manager_o {
@@ -230,7 +147,15 @@ struct le_pipeline_manager_o {
 
 	std::mutex mtx;
 
-	VkPipelineCache vulkanCache = nullptr;
+	VkPipelineCache  vulkanCache        = nullptr;
+	std::atomic_bool vulkanCacheIsDirty = false; // set when pipelines were created since vulkanCache was last written to disk
+	uint64_t         updateCount        = 0;     // number of calls to update_shader_modules, used to save vulkanCache periodically
+
+	uint32_t extended_dynamic_state_level    = 0;     // copied from backend settings on creation, see le_backend_vk_settings_o
+	bool     use_graphics_pipeline_libraries = false; // set on creation if enabled via backend settings - see le_pipeline_library_link_graphics_pipeline
+
+	le_pipeline_async_compiler_o* asyncCompiler = nullptr; // owning, only set if async pipeline compilation was requested via backend settings
+	le_pipeline_manifest_o*       manifest      = nullptr; // owning, only set if pipeline manifest recording is enabled
 
 	le_shader_manager_o* shaderManager = nullptr; // owning: does it make sense to have a shader manager additionally to the pipeline manager?
 
@@ -239,6 +164,7 @@ struct le_pipeline_manager_o {
 	HashTable<le_rtxpso_handle, rtx_pipeline_state_o>    rtxPso;
 
 	HashMap<uint64_t, VkPipeline>              pipelines;             // indexed by pipeline_hash
+	HashMap<uint64_t, VkPipeline>              pipelineLibraries;     // indexed by library key, only used with graphics pipeline libraries
 	HashTable<uint64_t, char*>                 rtx_shader_group_data; // indexed by pipeline_hash
 	HashMap<uint64_t, le_pipeline_layout_info> pipelineLayoutInfos;
 
@@ -512,6 +438,279 @@ static bool check_is_data_spirv( const void* raw_data, size_t data_size ) {
 	}
 }
 
+// ----------------------------------------------------------------------
+// Returns the directory which contains the current executable - we use this
+// as the root for any on-disk caches, so that caches don't depend on the
+// current working directory.
+static std::filesystem::path le_pipeline_get_executable_directory() {
+
+	static std::filesystem::path exe_directory = []() {
+		char result[ 1024 ] = { 0 };
+
+#ifdef _MSC_VER
+		// When NULL is passed to GetModuleHandle, the handle of the exe itself is returned
+		HMODULE hModule = GetModuleHandle( NULL );
+		if ( hModule != NULL ) {
+			// Use GetModuleFileName() with module handle to get the path
+			GetModuleFileName( hModule, result, ( sizeof( result ) ) );
+		}
+		size_t count = strnlen_s( result, sizeof( result ) );
+#else
+		ssize_t count = readlink( "/proc/self/exe", result, 1024 );
+#endif
+		std::filesystem::path exe_path = std::string( result, ( count > 0 ) ? size_t( count ) : 0 );
+		return exe_path.parent_path();
+	}();
+
+	return exe_directory;
+}
+
+// ----------------------------------------------------------------------
+// Compiled SPIR-V is cached on disk, so that we don't have to invoke the shader
+// compiler for shader sources which have not changed since the last run.
+//
+// Each cache entry lives in its own file, named after the cache key. The key
+// covers everything which goes into a compilation: source text, source path
+// (relative includes are resolved against it), macro defines, shader stage,
+// source language, and a hash of the options which le_shader_compiler applies
+// to every compilation (optimization level, target environment, ...).
+//
+// Include file contents can't be part of the key, since we only learn which
+// files are included by compiling. Instead, each entry stores the paths of all
+// files it depends on, together with a hash of their contents at the time of
+// compilation. An entry is only used if all its dependencies still hash the same.
+//
+// Storing the dependency paths also means that a cache hit gives us the same
+// set of includes as a compilation would - which is what hot-reloading needs
+// to set up its file watchers.
+//
+struct le_shader_cache_file_header_t {
+	uint32_t magic;            // must be LE_SHADER_CACHE_FILE_MAGIC
+	uint32_t version;          // must be LE_SHADER_CACHE_VERSION
+	uint64_t key;              // cache key, repeated here to guard against hash collisions on file name
+	uint32_t num_dependencies; // number of dependency records following this header
+	uint32_t spirv_size;       // number of uint32_t words of spirv code following dependency records
+};
+
+// Each dependency record is a le_shader_cache_dependency_header_t, immediately
+// followed by `path_size` bytes of path string (not null-terminated).
+struct le_shader_cache_dependency_header_t {
+	uint64_t contents_hash; // SpookyHash over contents of the file at `path`
+	uint32_t path_size;     // number of bytes in path string
+	uint32_t reserved;      // padding, must be 0
+};
+
+static constexpr uint32_t LE_SHADER_CACHE_FILE_MAGIC = 0x4353454c; // 'LESC'
+static constexpr uint32_t LE_SHADER_CACHE_VERSION    = 2;          // bump this if the layout of cache files changes
+
+// ----------------------------------------------------------------------
+
+static std::filesystem::path le_shader_cache_get_entry_path( uint64_t key ) {
+	char file_name[ 32 ];
+	snprintf( file_name, sizeof( file_name ), "%016llx.spv", ( unsigned long long )key );
+	return le_pipeline_get_executable_directory() / "le_shader_cache" / file_name;
+}
+
+// ----------------------------------------------------------------------
+
+static uint64_t le_shader_cache_calculate_key(
+    void const*                       source_text,
+    size_t                            source_text_size,
+    LeShaderSourceLanguageEnum const& shader_source_language,
+    le::ShaderStage const&            stage,
+    char const*                       original_file_name,
+    std::string const&                shader_defines,
+    uint64_t                          compiler_options_hash ) {
+
+	uint64_t key = LE_SHADER_CACHE_VERSION;
+
+	key = SpookyHash::Hash64( &compiler_options_hash, sizeof( uint64_t ), key );
+	key = SpookyHash::Hash64( &shader_source_language, sizeof( LeShaderSourceLanguageEnum ), key );
+	key = SpookyHash::Hash64( &stage, sizeof( le::ShaderStage ), key );
+	key = SpookyHash::Hash64( original_file_name, strlen( original_file_name ), key );
+	key = SpookyHash::Hash64( shader_defines.data(), shader_defines.size(), key );
+	key = SpookyHash::Hash64( source_text, source_text_size, key );
+
+	return key;
+}
+
+// ----------------------------------------------------------------------
+// Returns false if file at path does not exist, or could not be read.
+static bool le_shader_cache_hash_file_contents( std::string const& path, uint64_t* hash ) {
+	std::error_code ec;
+	if ( !std::filesystem::exists( path, ec ) ) {
+		return false;
+	}
+
+	std::vector<char> contents;
+
+	if ( !load_file( path, contents ) ) {
+		return false;
+	}
+
+	*hash = SpookyHash::Hash64( contents.data(), contents.size(), 0 );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Returns true and fills in spirvCode and includesSet if a valid cache entry
+// was found for `key`. Returns false if there was no entry, or if any of the
+// files which the entry depends on have changed since it was written.
+static bool le_shader_cache_try_load( uint64_t key, std::vector<uint32_t>& spirvCode, std::set<std::string>& includesSet ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	auto const file_path = le_shader_cache_get_entry_path( key );
+
+	std::error_code ec;
+	if ( !std::filesystem::exists( file_path, ec ) ) {
+		return false;
+	}
+
+	// ----------| invariant: cache entry exists
+
+	std::vector<char> file_contents;
+
+	if ( !load_file( file_path, file_contents ) ||
+	     file_contents.size() < sizeof( le_shader_cache_file_header_t ) ) {
+		return false;
+	}
+
+	le_shader_cache_file_header_t header;
+	memcpy( &header, file_contents.data(), sizeof( header ) );
+
+	if ( header.magic != LE_SHADER_CACHE_FILE_MAGIC ||
+	     header.version != LE_SHADER_CACHE_VERSION ||
+	     header.key != key ) {
+		return false;
+	}
+
+	char const* p_data     = file_contents.data() + sizeof( header );
+	char const* p_data_end = file_contents.data() + file_contents.size();
+
+	std::set<std::string> dependencies;
+
+	for ( uint32_t i = 0; i != header.num_dependencies; i++ ) {
+
+		le_shader_cache_dependency_header_t dependency;
+
+		if ( size_t( p_data_end - p_data ) < sizeof( dependency ) ) {
+			return false;
+		}
+
+		memcpy( &dependency, p_data, sizeof( dependency ) );
+		p_data += sizeof( dependency );
+
+		if ( size_t( p_data_end - p_data ) < dependency.path_size ) {
+			return false;
+		}
+
+		std::string path( p_data, dependency.path_size );
+		p_data += dependency.path_size;
+
+		uint64_t contents_hash = 0;
+
+		if ( !le_shader_cache_hash_file_contents( path, &contents_hash ) ||
+		     contents_hash != dependency.contents_hash ) {
+			logger.debug( "Shader cache entry %016llx is stale: '%s' has changed.", ( unsigned long long )key, path.c_str() );
+			return false;
+		}
+
+		dependencies.emplace( std::move( path ) );
+	}
+
+	if ( size_t( p_data_end - p_data ) != header.spirv_size * sizeof( uint32_t ) ||
+	     !check_is_data_spirv( p_data, size_t( p_data_end - p_data ) ) ) {
+		logger.warn( "Ignoring shader cache entry '%s': data is corrupt.", file_path.string().c_str() );
+		return false;
+	}
+
+	// ----------| invariant: cache entry is valid, and all its dependencies are up-to-date
+
+	spirvCode.resize( header.spirv_size );
+	memcpy( spirvCode.data(), p_data, header.spirv_size * sizeof( uint32_t ) );
+
+	includesSet.merge( dependencies );
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Writes a cache entry for `key`. As with the pipeline cache, we write to a
+// temporary file first, and then rename, so that readers never see a partially
+// written entry.
+static bool le_shader_cache_store( uint64_t key, std::vector<uint32_t> const& spirvCode, std::set<std::string> const& includesSet ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	auto const file_path = le_shader_cache_get_entry_path( key );
+
+	std::error_code ec;
+	std::filesystem::create_directories( file_path.parent_path(), ec );
+
+	if ( ec ) {
+		logger.warn( "Could not create shader cache directory: '%s' (%s)", file_path.parent_path().string().c_str(), ec.message().c_str() );
+		return false;
+	}
+
+	le_shader_cache_file_header_t header{};
+	header.magic            = LE_SHADER_CACHE_FILE_MAGIC;
+	header.version          = LE_SHADER_CACHE_VERSION;
+	header.key              = key;
+	header.num_dependencies = uint32_t( includesSet.size() );
+	header.spirv_size       = uint32_t( spirvCode.size() );
+
+	std::vector<char> data( reinterpret_cast<char const*>( &header ), reinterpret_cast<char const*>( &header ) + sizeof( header ) );
+
+	for ( auto const& path : includesSet ) {
+		le_shader_cache_dependency_header_t dependency{};
+
+		if ( !le_shader_cache_hash_file_contents( path, &dependency.contents_hash ) ) {
+			// If we can't read back a dependency there is no way to tell whether
+			// the entry is stale later on - we'd rather not cache at all.
+			return false;
+		}
+
+		dependency.path_size = uint32_t( path.size() );
+
+		data.insert( data.end(), reinterpret_cast<char const*>( &dependency ), reinterpret_cast<char const*>( &dependency ) + sizeof( dependency ) );
+		data.insert( data.end(), path.begin(), path.end() );
+	}
+
+	data.insert( data.end(), reinterpret_cast<char const*>( spirvCode.data() ), reinterpret_cast<char const*>( spirvCode.data() + spirvCode.size() ) );
+
+	// Temporary file name must be unique, as entries may be written from more than one thread.
+	static std::atomic<uint32_t> temp_file_counter = 0;
+
+	auto file_path_temp = file_path;
+	file_path_temp += "." + std::to_string( temp_file_counter++ ) + ".tmp";
+
+	{
+		std::ofstream file( file_path_temp, std::ios::out | std::ios::binary | std::ios::trunc );
+
+		if ( !file.is_open() ) {
+			logger.warn( "Could not open shader cache file for writing: '%s'", file_path_temp.string().c_str() );
+			return false;
+		}
+
+		file.write( data.data(), std::streamsize( data.size() ) );
+
+		if ( !file.good() ) {
+			logger.warn( "Could not write shader cache file: '%s'", file_path_temp.string().c_str() );
+			return false;
+		}
+	}
+
+	std::filesystem::rename( file_path_temp, file_path, ec );
+
+	if ( ec ) {
+		logger.warn( "Could not move shader cache file into place: '%s' (%s)", file_path.string().c_str(), ec.message().c_str() );
+		return false;
+	}
+
+	return true;
+}
+
 // ----------------------------------------------------------------------
 
 /// \brief translate a binary blob into spirv code if possible
@@ -539,8 +738,22 @@ static bool translate_to_spirv_code(
 
 		// ----------| Invariant: Data is not SPIRV, it still needs to be compiled
 
+		LE_SETTING( bool, LE_SETTING_SHADER_CACHE_ENABLED, true );
+
 		using namespace le_shader_compiler;
 
+		uint64_t const cache_key =
+		    le_shader_cache_calculate_key( raw_data, numBytes, shader_source_language, moduleType, original_file_name, shaderDefines,
+		                                   compiler_i.get_options_hash( shader_compiler ) );
+
+		if ( *LE_SETTING_SHADER_CACHE_ENABLED && le_shader_cache_try_load( cache_key, spirvCode, includesSet ) ) {
+			static auto logger = LeLog( LOGGER_LABEL );
+			logger.info( "Using cached spir-v for shader file: '%s'", original_file_name );
+			return true;
+		}
+
+		// ----------| Invariant: No valid cached spir-v for this data, we must invoke the compiler
+
 		auto compilation_result = compiler_i.result_create();
 
 		compiler_i.compile_source(
@@ -568,6 +781,11 @@ static bool translate_to_spirv_code(
 				// -- update set of includes for this module
 				includesSet.emplace( pStr, strSz );
 			}
+
+			if ( *LE_SETTING_SHADER_CACHE_ENABLED ) {
+				le_shader_cache_store( cache_key, spirvCode, includesSet );
+			}
+
 			result = true;
 		} else {
 			result = false;
@@ -1079,19 +1297,14 @@ static std::vector<le_shader_binding_info> shader_modules_merge_bindings( le_sha
 
 // ----------------------------------------------------------------------
 
-static void le_shader_manager_shader_module_update( le_shader_manager_o* self, le_shader_module_handle handle ) {
-
-	// Shader module needs updating if shader code has changed.
-	// if this happens, a new vulkan object for the module must be created.
-
-	// The module must be locked for this, as we need exclusive access just in case the module is
-	// in use by the frame recording thread, which may want to create pipelines.
-	//
-	// Vulkan lifetimes require us only to keep module alive for as long as a pipeline is being
-	// generated from it. This means we "only" need to protect against any threads which might be
-	// creating pipelines.
+// Compiles the current source of a shader module into spirv_code, and collects
+// all source files which the module depends on into includesSet.
+//
+// This does not modify the module, and may therefore run concurrently for
+// different modules, as long as each concurrent call uses its own compiler.
+static void le_shader_manager_shader_module_compile( le_shader_manager_o* self, le_shader_compiler_o* shader_compiler, le_shader_module_handle handle, std::vector<uint32_t>& spirv_code, std::set<std::string>& includesSet ) {
 
-	auto module = self->shaderModules.try_find( handle );
+	le_shader_module_o const* module = self->shaderModules.try_find( handle );
 	assert( module && "module not found" );
 
 	// -- get module spirv code
@@ -1102,16 +1315,33 @@ static void le_shader_manager_shader_module_update( le_shader_manager_o* self, l
 		return;
 	}
 
-	std::vector<uint32_t> spirv_code;
-	std::set<std::string> includesSet{ { module->filepath.string() } }; // let first element be the original source file path
+	includesSet.emplace( module->filepath.string() ); // let first element be the original source file path
+
+	translate_to_spirv_code( shader_compiler, source_text.data(), source_text.size(), { module->source_language }, module->stage, module->filepath.string().c_str(), spirv_code, includesSet, module->macro_defines );
+}
+
+// ----------------------------------------------------------------------
+// Applies freshly compiled spirv code to a shader module.
+static void le_shader_manager_shader_module_apply( le_shader_manager_o* self, le_shader_module_handle handle, std::vector<uint32_t>& spirv_code, std::set<std::string>& includesSet ) {
+
+	// Shader module needs updating if shader code has changed.
+	// if this happens, a new vulkan object for the module must be created.
 
-	translate_to_spirv_code( self->shader_compiler, source_text.data(), source_text.size(), { module->source_language }, module->stage, module->filepath.string().c_str(), spirv_code, includesSet, module->macro_defines );
+	// The module must be locked for this, as we need exclusive access just in case the module is
+	// in use by the frame recording thread, which may want to create pipelines.
+	//
+	// Vulkan lifetimes require us only to keep module alive for as long as a pipeline is being
+	// generated from it. This means we "only" need to protect against any threads which might be
+	// creating pipelines.
 
 	if ( spirv_code.empty() ) {
 		// no spirv code available, bail out.
 		return;
 	}
 
+	auto module = self->shaderModules.try_find( handle );
+	assert( module && "module not found" );
+
 	module->hash_shader_defines = SpookyHash::Hash64( module->macro_defines.data(), module->macro_defines.size(), 0 );
 
 	// -- check spirv code hash against module spirv hash
@@ -1180,11 +1410,85 @@ static void le_shader_manager_update_shader_modules( le_shader_manager_o* self )
 
 	// -- update only modules which have been tainted
 
+	if ( self->modifiedShaderModules.empty() ) {
+		return;
+	}
+
+	ZoneScoped;
+
+	struct compile_job_params_t {
+		le_shader_manager_o*    shader_manager;
+		le_shader_module_handle handle;
+		std::vector<uint32_t>   spirv_code;
+		std::set<std::string>   includes;
+	};
+
+	std::vector<compile_job_params_t> compile_params;
+	compile_params.reserve( self->modifiedShaderModules.size() );
+
 	for ( auto& s : self->modifiedShaderModules ) {
-		le_shader_manager_shader_module_update( self, s );
+		compile_params.push_back( { self, s, {}, {} } );
 	}
 
 	self->modifiedShaderModules.clear();
+
+	if ( LE_MT > 0 && compile_params.size() > 1 ) {
+
+		// Compile each module as a job of its own, so that a change to an include
+		// file which many modules share does not make us compile these modules
+		// one after another.
+		//
+		// Each worker thread uses its own compiler. Jobs only write to their own
+		// params, and modules are only modified once all jobs have completed.
+
+		auto compile_fun = []( void* param_ ) {
+			auto p              = static_cast<compile_job_params_t*>( param_ );
+			auto shader_manager = p->shader_manager;
+
+			le_shader_compiler_o* shader_compiler = shader_manager->shader_compiler;
+			int32_t               worker_id       = le_jobs::get_current_worker_id();
+
+			if ( worker_id >= 0 && size_t( worker_id ) < shader_manager->worker_shader_compilers.size() ) {
+				auto& worker_compiler = shader_manager->worker_shader_compilers[ worker_id ];
+				if ( nullptr == worker_compiler ) {
+					worker_compiler = le_shader_compiler::compiler_i.create();
+				}
+				shader_compiler = worker_compiler;
+			}
+
+			le_shader_manager_shader_module_compile( shader_manager, shader_compiler, p->handle, p->spirv_code, p->includes );
+		};
+
+		std::vector<le_jobs::job_t> jobs;
+		jobs.reserve( compile_params.size() );
+
+		for ( auto& p : compile_params ) {
+			jobs.push_back( { compile_fun, &p } );
+		}
+
+		le_jobs::counter_t* counter;
+		le_jobs::run_jobs( jobs.data(), uint32_t( jobs.size() ), &counter );
+		le_jobs::wait_for_counter_and_free( counter, 0 );
+
+	} else {
+		for ( auto& p : compile_params ) {
+			le_shader_manager_shader_module_compile( self, self->shader_compiler, p.handle, p.spirv_code, p.includes );
+		}
+	}
+
+	// ----------| invariant: all compilations have completed
+
+	// Apply results in order, on this thread - this is where modules, dependencies,
+	// and file watches are updated, and vulkan shader module objects are replaced.
+	//
+	// We must not replace any modules while pipelines are being created from them
+	// on background threads, which is why we hold an exclusive lock here.
+
+	auto lock = std::unique_lock( self->modules_mtx );
+
+	for ( auto& p : compile_params ) {
+		le_shader_manager_shader_module_apply( self, p.handle, p.spirv_code, p.includes );
+	}
 }
 
 // ----------------------------------------------------------------------
@@ -1198,6 +1502,9 @@ le_shader_manager_o* le_shader_manager_create( VkDevice_T* device ) {
 	using namespace le_shader_compiler;
 	self->shader_compiler = compiler_i.create();
 
+	// -- worker thread compilers are created on demand, see le_shader_manager_update_shader_modules
+	self->worker_shader_compilers.resize( LE_MT, nullptr );
+
 	// -- create file watcher for shader files so that changes can be detected
 	self->shaderFileWatcher = le_file_watcher::le_file_watcher_i.create();
 
@@ -1223,6 +1530,13 @@ static void le_shader_manager_destroy( le_shader_manager_o* self ) {
 		self->shader_compiler = nullptr;
 	}
 
+	for ( auto& c : self->worker_shader_compilers ) {
+		if ( c ) {
+			compiler_i.destroy( c );
+			c = nullptr;
+		}
+	}
+
 	// -- destroy retained shader modules
 	self->shaderModules.iterator( []( le_shader_module_o* module, void* user_data ) {
 		VkDevice device = *static_cast<VkDevice*>( user_data );
@@ -1403,7 +1717,292 @@ static VkPipelineLayout le_pipeline_manager_get_pipeline_layout( le_pipeline_man
 }
 
 // ----------------------------------------------------------------------
-// Creates a vulkan graphics pipeline based on a shader state object and a given renderpass and subpass index.
+// Graphics pipeline libraries (VK_EXT_graphics_pipeline_library)
+//
+// A graphics pipeline is split into four parts, each of which we create as a
+// pipeline library, and cache independently:
+//
+//  + vertex input interface   : vertex input, and input assembly state
+//  + pre-rasterization shaders: vertex/tessellation/geometry/mesh stages, rasterization state
+//  + fragment shader          : fragment stage, depth/stencil state
+//  + fragment output interface: colour blend state
+//
+// Linking a pipeline from cached libraries is a fraction of the cost of creating a
+// monolithic pipeline. New pipelines which only differ in vertex input, or in blend
+// state, and pipelines whose shader stages were not touched by a hot-reload, can
+// therefore re-use libraries which have already been compiled.
+//
+// Each part is keyed by a hash over all state which it bakes in - this includes
+// the renderpass hash, as shader and fragment output libraries must be created
+// for a compatible renderpass.
+//
+enum class le_pipeline_library_part : uint32_t {
+	eVertexInputInterface = 0,
+	ePreRasterizationShaders,
+	eFragmentShader,
+	eFragmentOutputInterface,
+};
+
+// ----------------------------------------------------------------------
+
+static VkGraphicsPipelineLibraryFlagsEXT le_pipeline_library_part_to_vk_flags( le_pipeline_library_part part ) {
+	// clang-format off
+	switch ( part ) {
+	case le_pipeline_library_part::eVertexInputInterface    : return VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+	case le_pipeline_library_part::ePreRasterizationShaders : return VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+	case le_pipeline_library_part::eFragmentShader          : return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+	case le_pipeline_library_part::eFragmentOutputInterface : return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+	} // clang-format on
+	assert( false && "unknown pipeline library part" );
+	return 0;
+}
+
+// ----------------------------------------------------------------------
+// Folds pipeline state into a library key one field at a time.
+//
+// We don't hash Vk*CreateInfo structs as a whole: these hold `sType`/`pNext`, and
+// pointers such as `pSampleMask`, and may contain padding bytes - identical state
+// could otherwise end up with different keys.
+struct le_pipeline_library_key_t {
+	uint64_t value;
+
+	template <typename T>
+	void add( T const& v ) {
+		static_assert( std::is_scalar<T>::value, "only hash scalar fields - structs may contain padding" );
+		value = SpookyHash::Hash64( &v, sizeof( T ), value );
+	}
+
+	template <typename T>
+	void add_array( T const* data, uint32_t count ) {
+		// Only use for structs which are made of 32 bit fields, and therefore can't contain padding.
+		static_assert( sizeof( T ) % sizeof( uint32_t ) == 0 && alignof( T ) == alignof( uint32_t ), "array elements must not contain padding" );
+		add( count );
+		if ( count && data ) {
+			value = SpookyHash::Hash64( data, sizeof( T ) * count, value );
+		}
+	}
+
+	void add( VkPipelineInputAssemblyStateCreateInfo const* s ) {
+		add( s->topology );
+		add( s->primitiveRestartEnable );
+	}
+
+	void add( VkPipelineTessellationStateCreateInfo const* s ) {
+		add( s ? s->patchControlPoints : 0u );
+	}
+
+	void add( VkPipelineRasterizationStateCreateInfo const* s ) {
+		add( s->depthClampEnable );
+		add( s->rasterizerDiscardEnable );
+		add( s->polygonMode );
+		add( s->cullMode );
+		add( s->frontFace );
+		add( s->depthBiasEnable );
+		add( s->depthBiasConstantFactor );
+		add( s->depthBiasClamp );
+		add( s->depthBiasSlopeFactor );
+		add( s->lineWidth );
+	}
+
+	void add( VkPipelineMultisampleStateCreateInfo const* s ) {
+		add( s->rasterizationSamples );
+		add( s->sampleShadingEnable );
+		add( s->minSampleShading );
+		add_array( s->pSampleMask, s->pSampleMask ? ( uint32_t( s->rasterizationSamples ) + 31 ) / 32 : 0 );
+		add( s->alphaToCoverageEnable );
+		add( s->alphaToOneEnable );
+	}
+
+	void add( VkPipelineDepthStencilStateCreateInfo const* s ) {
+		add( s->depthTestEnable );
+		add( s->depthWriteEnable );
+		add( s->depthCompareOp );
+		add( s->depthBoundsTestEnable );
+		add( s->stencilTestEnable );
+		add_array( &s->front, 1 );
+		add_array( &s->back, 1 );
+		add( s->minDepthBounds );
+		add( s->maxDepthBounds );
+	}
+
+	void add( VkPipelineColorBlendStateCreateInfo const* s ) {
+		add( s->logicOpEnable );
+		add( s->logicOp );
+		add_array( s->pAttachments, s->attachmentCount );
+		add_array( s->blendConstants, 4 );
+	}
+
+	void add( VkPipelineDynamicStateCreateInfo const* s ) {
+		add_array( s->pDynamicStates, s->dynamicStateCount );
+	}
+};
+
+// ----------------------------------------------------------------------
+// Returns the cached pipeline library for `key` - or creates one from the state given
+// in `gpi` which is relevant to `part`, and adds it to the cache.
+static VkPipeline le_pipeline_library_produce( le_pipeline_manager_o* self, le_pipeline_library_part part, uint64_t key, VkGraphicsPipelineCreateInfo const& gpi ) {
+
+	if ( VkPipeline const* p = self->pipelineLibraries.try_find( key ) ) {
+		return *p;
+	}
+
+	// ----------| invariant: library does not exist yet - we must create it
+
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	VkGraphicsPipelineLibraryCreateInfoEXT library_info = {
+	    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+	    .pNext = nullptr,
+	    .flags = le_pipeline_library_part_to_vk_flags( part ),
+	};
+
+	// Vulkan only reads state which belongs to the library part that we request
+	// via `library_info` - we may therefore hand it the complete create info.
+	VkGraphicsPipelineCreateInfo library_gpi = gpi;
+	library_gpi.pNext                        = &library_info;
+	library_gpi.flags                        = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+
+	// Shader stages must only be given to the library part which they belong to.
+	std::vector<VkPipelineShaderStageCreateInfo> stages;
+
+	if ( part == le_pipeline_library_part::ePreRasterizationShaders ||
+	     part == le_pipeline_library_part::eFragmentShader ) {
+		for ( uint32_t i = 0; i != gpi.stageCount; i++ ) {
+			bool is_fragment_stage = ( gpi.pStages[ i ].stage == VK_SHADER_STAGE_FRAGMENT_BIT );
+			if ( is_fragment_stage == ( part == le_pipeline_library_part::eFragmentShader ) ) {
+				stages.push_back( gpi.pStages[ i ] );
+			}
+		}
+	}
+
+	library_gpi.stageCount = uint32_t( stages.size() );
+	library_gpi.pStages    = stages.data();
+
+	VkPipeline library = nullptr;
+	auto       result  = vkCreateGraphicsPipelines( self->device, self->vulkanCache, 1, &library_gpi, nullptr, &library );
+
+	if ( result != VK_SUCCESS ) {
+		logger.error( "Could not create graphics pipeline library (part: %d)", uint32_t( part ) );
+		return nullptr;
+	}
+
+	if ( false == self->pipelineLibraries.try_insert( key, &library ) ) {
+		// Another thread created the same library in the meantime - use theirs.
+		vkDestroyPipeline( self->device, library, nullptr );
+		return *self->pipelineLibraries.try_find( key );
+	}
+
+	self->vulkanCacheIsDirty = true;
+	logger.info( "New VK Graphics Pipeline Library created: %p (part: %d)", key, uint32_t( part ) );
+
+	return library;
+}
+
+// ----------------------------------------------------------------------
+// Links a complete graphics pipeline from pipeline libraries - libraries are taken from
+// cache if possible, and only created if they don't exist yet.
+//
+// `modules` must hold the shader module objects for `gpi.pStages`, in the same order.
+// Returns VK_SUCCESS if the pipeline could be linked.
+static VkResult le_pipeline_library_link_graphics_pipeline(
+    le_pipeline_manager_o*              self,
+    VkGraphicsPipelineCreateInfo const& gpi,
+    le_shader_module_o* const*          modules,
+    uint64_t                            renderpass_hash,
+    VkPipeline*                         pipeline ) {
+
+	// -- Calculate keys for each library part. Each key covers the state which is baked into its part.
+
+	uint64_t const seed        = SpookyHash::Hash64( &renderpass_hash, sizeof( renderpass_hash ), uint64_t( gpi.subpass ) );
+	uint64_t const layout_seed = SpookyHash::Hash64( &gpi.layout, sizeof( VkPipelineLayout ), seed ); // shader stages depend on pipeline layout
+
+	le_pipeline_library_key_t key_vertex_input{ seed };
+	le_pipeline_library_key_t key_pre_raster{ layout_seed };
+	le_pipeline_library_key_t key_fragment{ layout_seed };
+	le_pipeline_library_key_t key_fragment_out{ seed };
+	bool                      has_vertex_stage = false;
+
+	for ( uint32_t i = 0; i != gpi.stageCount; i++ ) {
+		le_shader_module_o const* m = modules[ i ];
+
+		auto& key = ( m->stage == le::ShaderStage::eFragment ) ? key_fragment : key_pre_raster;
+
+		key.add( m->hash );
+		key.add( uint64_t( m->stage ) );
+		key.add( SpookyHash::Hash64( m->specialization_map_info.data.data(), m->specialization_map_info.data.size(), 0 ) );
+
+		has_vertex_stage |= ( m->stage == le::ShaderStage::eVertex );
+	}
+
+	auto const& vi = *gpi.pVertexInputState;
+
+	key_vertex_input.add_array( vi.pVertexBindingDescriptions, vi.vertexBindingDescriptionCount );
+	key_vertex_input.add_array( vi.pVertexAttributeDescriptions, vi.vertexAttributeDescriptionCount );
+	key_vertex_input.add( gpi.pInputAssemblyState );
+	key_vertex_input.add( gpi.pDynamicState );
+
+	key_pre_raster.add( gpi.pRasterizationState );
+	key_pre_raster.add( gpi.pTessellationState );
+	key_pre_raster.add( gpi.pDynamicState );
+
+	key_fragment.add( gpi.pDepthStencilState );
+	key_fragment.add( gpi.pMultisampleState );
+	key_fragment.add( gpi.pDynamicState );
+
+	key_fragment_out.add( gpi.pColorBlendState );
+	key_fragment_out.add( gpi.pMultisampleState );
+	key_fragment_out.add( gpi.pDynamicState );
+
+	// Make sure that keys for different parts can never collide, as all parts share one cache.
+	key_vertex_input.add( uint32_t( le_pipeline_library_part::eVertexInputInterface ) );
+	key_pre_raster.add( uint32_t( le_pipeline_library_part::ePreRasterizationShaders ) );
+	key_fragment.add( uint32_t( le_pipeline_library_part::eFragmentShader ) );
+	key_fragment_out.add( uint32_t( le_pipeline_library_part::eFragmentOutputInterface ) );
+
+	// -- Fetch, or create libraries
+
+	VkPipeline libraries[ 4 ] = {};
+	uint32_t   num_libraries  = 0;
+
+	if ( has_vertex_stage ) {
+		// Mesh shader pipelines must not include a vertex input interface
+		libraries[ num_libraries++ ] = le_pipeline_library_produce( self, le_pipeline_library_part::eVertexInputInterface, key_vertex_input.value, gpi );
+	}
+
+	libraries[ num_libraries++ ] = le_pipeline_library_produce( self, le_pipeline_library_part::ePreRasterizationShaders, key_pre_raster.value, gpi );
+	libraries[ num_libraries++ ] = le_pipeline_library_produce( self, le_pipeline_library_part::eFragmentShader, key_fragment.value, gpi );
+	libraries[ num_libraries++ ] = le_pipeline_library_produce( self, le_pipeline_library_part::eFragmentOutputInterface, key_fragment_out.value, gpi );
+
+	for ( uint32_t i = 0; i != num_libraries; i++ ) {
+		if ( nullptr == libraries[ i ] ) {
+			return VK_ERROR_INITIALIZATION_FAILED;
+		}
+	}
+
+	// -- Link libraries into a complete pipeline - we don't ask for link time optimisation,
+	// as this is what would make linking as expensive as creating a monolithic pipeline.
+
+	VkPipelineLibraryCreateInfoKHR linking_info = {
+	    .sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+	    .pNext        = nullptr,
+	    .libraryCount = num_libraries,
+	    .pLibraries   = libraries,
+	};
+
+	VkGraphicsPipelineCreateInfo link_gpi = {
+	    .sType      = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+	    .pNext      = &linking_info,
+	    .flags      = 0,
+	    .layout     = gpi.layout,
+	    .renderPass = gpi.renderPass,
+	    .subpass    = gpi.subpass,
+	};
+
+	return vkCreateGraphicsPipelines( self->device, self->vulkanCache, 1, &link_gpi, nullptr, pipeline );
+}
+
+// ----------------------------------------------------------------------
+// Creates a vulkan graphics pipeline based on a shader state object and a given renderpass and subpass index.
 //
 static VkPipeline le_pipeline_cache_create_graphics_pipeline( le_pipeline_manager_o* self, graphics_pipeline_state_o const* pso, const BackendRenderPass& pass, uint32_t subpass ) {
 
@@ -1413,6 +2012,9 @@ static VkPipeline le_pipeline_cache_create_graphics_pipeline( le_pipeline_manage
 	std::vector<VkSpecializationInfo*> p_specialization_infos;
 	p_specialization_infos.reserve( pso->shaderModules.size() );
 
+	std::vector<le_shader_module_o*> shaderModules; // one per pipeline stage, needed if we link from pipeline libraries
+	shaderModules.reserve( pso->shaderModules.size() );
+
 	le_shader_module_o* vertexShaderModule = nullptr; // We may need the vertex shader module later
 
 	for ( auto const& shader_stage : pso->shaderModules ) {
@@ -1455,6 +2057,7 @@ static VkPipeline le_pipeline_cache_create_graphics_pipeline( le_pipeline_manage
 		};
 
 		pipelineStages.emplace_back( info );
+		shaderModules.emplace_back( s );
 	}
 
 	std::vector<VkVertexInputBindingDescription>   vertexBindingDescriptions;        // Where to get data from
@@ -1558,17 +2161,47 @@ static VkPipeline le_pipeline_cache_create_graphics_pipeline( le_pipeline_manage
 
 	// We will allways keep Scissor, Viewport and LineWidth as dynamic states,
 	// otherwise we might have way too many pipelines flying around.
-	VkDynamicState dynamicStates[] = {
+	//
+	// With extended dynamic state enabled, we add more states - the backend
+	// sets these whenever a pipeline gets bound, and the encoder may change them
+	// thereafter. Any state listed here must be masked out in
+	// `graphics_pipeline_state_mask_dynamic_state`.
+	VkDynamicState dynamicStates[ 32 ] = {
 	    VK_DYNAMIC_STATE_SCISSOR,
 	    VK_DYNAMIC_STATE_VIEWPORT,
 	    VK_DYNAMIC_STATE_LINE_WIDTH,
 	};
+	uint32_t dynamicStatesCount = 3;
+
+	if ( self->extended_dynamic_state_level >= 1 ) {
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_CULL_MODE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_FRONT_FACE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_DEPTH_COMPARE_OP;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_STENCIL_OP;
+	}
+	if ( self->extended_dynamic_state_level >= 2 ) {
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE;
+	}
+	if ( self->extended_dynamic_state_level >= 3 ) {
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_POLYGON_MODE_EXT;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT;
+		dynamicStates[ dynamicStatesCount++ ] = VK_DYNAMIC_STATE_BLEND_CONSTANTS;
+	}
 
 	VkPipelineDynamicStateCreateInfo dynamicState = {
 	    .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
 	    .pNext             = nullptr,
 	    .flags             = 0,
-	    .dynamicStateCount = sizeof( dynamicStates ) / sizeof( VkDynamicState ),
+	    .dynamicStateCount = dynamicStatesCount,
 	    .pDynamicStates    = dynamicStates,
 	};
 
@@ -1604,7 +2237,13 @@ static VkPipeline le_pipeline_cache_create_graphics_pipeline( le_pipeline_manage
 	    };
 
 	VkPipeline pipeline = nullptr;
-	auto       result   = vkCreateGraphicsPipelines( self->device, self->vulkanCache, 1, &gpi, nullptr, &pipeline );
+	VkResult   result   = VK_SUCCESS;
+
+	if ( self->use_graphics_pipeline_libraries ) {
+		result = le_pipeline_library_link_graphics_pipeline( self, gpi, shaderModules.data(), pass.renderpassHash, &pipeline );
+	} else {
+		result = vkCreateGraphicsPipelines( self->device, self->vulkanCache, 1, &gpi, nullptr, &pipeline );
+	}
 
 	// cleanup temporary specialisation info objects
 	for ( auto& p_spec : p_specialization_infos ) {
@@ -2056,177 +2695,659 @@ static inline void le_pipeline_manager_produce_pipeline_layout_info(
 
 // ----------------------------------------------------------------------
 
-/// \brief Creates - or loads a pipeline from cache - based on current pipeline state
-/// \note This method may lock the gpso/cpso cache and is therefore costly.
-//
-// + Only the 'command buffer recording'-slice of a frame shall be able to modify the cache.
-//   The cache must be exclusively accessed through this method
-//
-// + NOTE: Access to this method must be sequential - no two frames may access this method
-//   at the same time - and no two renderpasses may access this method at the same time.
-static le_pipeline_and_layout_info_t le_pipeline_manager_produce_graphics_pipeline(
-    le_pipeline_manager_o*   self,
-    le_gpso_handle           gpso_handle,
-    const BackendRenderPass& pass, uint32_t subpass ) {
-
-	// TODO: Do we need this lock, or are the try_finds with their internal mutexes enough?
-	auto lock = std::unique_lock( self->mtx ); // Enforce sequentiality via scoped lock: no two renderpasses may access cache concurrently.
-
-	// TODO: Check whether the current gpso is dirty - if not, we should be able to use a cached version
-	// via self.pipelines
+// ----------------------------------------------------------------------
+// Calculates a combined hash for pipeline, renderpass, and all contributing shader stages.
+static uint64_t le_pipeline_manager_calculate_graphics_pipeline_hash( le_pipeline_manager_o* self, graphics_pipeline_state_o const* pso, uint64_t renderpass_hash, uint64_t pipeline_layout_hash ) {
 
-	// What would taint the gpso: if any of the modules a gpso depends upon had changed, that would mean it
-	// was tainted. We could keep an internal table of modules -> gpso and taint any gpso that made use of
-	// a changed module.
+	uint64_t pso_renderpass_hash_data[ 12 ]       = {}; // we use a c-style array, with an entry count so that this is reliably allocated on the stack and not on the heap.
+	uint64_t pso_renderpass_hash_data_num_entries = 0;  // number of entries in pso_renderpass_hash_data
 
-	static auto                   logger                   = LeLog( LOGGER_LABEL );
-	le_pipeline_and_layout_info_t pipeline_and_layout_info = {};
+	pso_renderpass_hash_data[ 0 ]        = pso->vk_pipeline_hash; // Hash over `pso` state which is not dynamic
+	pso_renderpass_hash_data[ 1 ]        = renderpass_hash;       // Hash for *compatible* renderpass
+	pso_renderpass_hash_data_num_entries = 2;
 
-	// -- 0. Fetch pso from cache using its hash key
-	graphics_pipeline_state_o const* pso = self->graphicsPso.try_find( gpso_handle );
-	assert( pso );
+	for ( auto const& s : pso->shaderModules ) {
+		auto p_module = self->shaderManager->shaderModules.try_find( s );
+		assert( p_module && "shader module not found" );
+		pso_renderpass_hash_data[ pso_renderpass_hash_data_num_entries++ ] = p_module->hash; // Module state - may have been recompiled, hash must be current
+	}
 
-	// -- 1. get pipeline layout info for a pipeline with these bindings
-	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+	// -- create combined hash for pipeline, renderpass
+	return SpookyHash::Hash64( pso_renderpass_hash_data, sizeof( uint64_t ) * pso_renderpass_hash_data_num_entries, pipeline_layout_hash );
+}
 
-	uint64_t pipeline_layout_hash{};
-	le_pipeline_manager_produce_pipeline_layout_info( self, pso->shaderModules.data(), pso->shaderModules.size(),
-	                                                  &pipeline_and_layout_info.layout_info, &pipeline_layout_hash );
+// ----------------------------------------------------------------------
+// Describes attachments of a backend renderpass, in the order in which the backend
+// creates its attachment references.
+static std::vector<le_pipeline_compatible_attachment_t> le_pipeline_get_compatible_attachments( BackendRenderPass const& pass ) {
+
+	std::vector<le_pipeline_compatible_attachment_t> result;
+
+	size_t num_attachments = size_t( pass.numColorAttachments ) + pass.numDepthStencilAttachments + pass.numResolveAttachments;
+	result.reserve( num_attachments );
+
+	for ( AttachmentInfo const* a = pass.attachments; a != pass.attachments + num_attachments; a++ ) {
+		result.push_back( {
+		    .format   = uint32_t( a->format ),
+		    .samples  = uint32_t( a->numSamples ),
+		    .type     = uint32_t( a->type ),
+		    .reserved = 0,
+		} );
+	}
 
-	// -- 2. get vk pipeline object
-	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+	return result;
+}
 
-	uint64_t pipeline_hash = 0;
-	{
-		// Create a combined hash for pipeline, renderpass, and all contributing shader stages.
+// ----------------------------------------------------------------------
+// Creates a renderpass which is compatible with a backend renderpass with the given
+// attachments: attachment formats, sample counts, and attachment references must
+// match - load/store ops, layouts and subpass dependencies don't affect compatibility.
+static VkRenderPass le_pipeline_create_compatible_renderpass( VkDevice device, std::vector<le_pipeline_compatible_attachment_t> const& compatible_attachments ) {
+
+	std::vector<VkAttachmentDescription2> attachments;
+	std::vector<VkAttachmentReference2>   colorAttachmentReferences;
+	std::vector<uint32_t>                 colorAttachmentImageIndices; // per color attachment: index of its image among non-resolve attachments
+	std::vector<VkAttachmentReference2>   resolveAttachmentReferences; // in order of non-resolve attachments, as the backend adds one resolve attachment per image
+	VkAttachmentReference2                dsAttachmentReference{};
+	bool                                  hasDepthStencilAttachment = false;
+	uint32_t                              numImageAttachments       = 0;
+
+	attachments.reserve( compatible_attachments.size() );
+
+	for ( auto const& a : compatible_attachments ) {
+
+		bool const    isDepthStencil = ( AttachmentInfo::Type( a.type ) == AttachmentInfo::Type::eDepthStencilAttachment );
+		VkImageLayout layout         = isDepthStencil ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		attachments.push_back( {
+		    .sType          = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2,
+		    .pNext          = nullptr, // optional
+		    .flags          = 0,       // optional
+		    .format         = VkFormat( a.format ),
+		    .samples        = VkSampleCountFlagBits( a.samples ),
+		    .loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		    .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		    .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		    .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		    .initialLayout  = layout,
+		    .finalLayout    = layout,
+		} );
+
+		VkAttachmentReference2 reference = {
+		    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
+		    .pNext      = nullptr, // optional
+		    .attachment = uint32_t( attachments.size() - 1 ),
+		    .layout     = layout,
+		    .aspectMask = 0,
+		};
 
-		uint64_t pso_renderpass_hash_data[ 12 ]       = {}; // we use a c-style array, with an entry count so that this is reliably allocated on the stack and not on the heap.
-		uint64_t pso_renderpass_hash_data_num_entries = 0;  // number of entries in pso_renderpass_hash_data
+		switch ( AttachmentInfo::Type( a.type ) ) {
+		case AttachmentInfo::Type::eDepthStencilAttachment:
+			dsAttachmentReference     = reference;
+			hasDepthStencilAttachment = true;
+			numImageAttachments++;
+			break;
+		case AttachmentInfo::Type::eColorAttachment:
+			colorAttachmentReferences.push_back( reference );
+			colorAttachmentImageIndices.push_back( numImageAttachments++ );
+			break;
+		case AttachmentInfo::Type::eResolveAttachment:
+			resolveAttachmentReferences.push_back( reference );
+			break;
+		}
+	}
 
-		pso_renderpass_hash_data[ 0 ]        = reinterpret_cast<uint64_t>( gpso_handle ); // Hash associated with `pso`
-		pso_renderpass_hash_data[ 1 ]        = pass.renderpassHash;                       // Hash for *compatible* renderpass
-		pso_renderpass_hash_data_num_entries = 2;
+	// pResolveAttachments, if set, must have one entry per color attachment - we match resolve
+	// attachments to their color attachments, and mark any gaps as unused. Depth stencil
+	// resolves are not part of pResolveAttachments, and don't affect compatibility.
+	std::vector<VkAttachmentReference2> colorResolveAttachmentReferences;
 
-		for ( auto const& s : pso->shaderModules ) {
-			auto p_module = self->shaderManager->shaderModules.try_find( s );
-			assert( p_module && "shader module not found" );
-			pso_renderpass_hash_data[ pso_renderpass_hash_data_num_entries++ ] = p_module->hash; // Module state - may have been recompiled, hash must be current
+	if ( !resolveAttachmentReferences.empty() ) {
+		colorResolveAttachmentReferences.reserve( colorAttachmentReferences.size() );
+		for ( uint32_t image_index : colorAttachmentImageIndices ) {
+			if ( image_index < resolveAttachmentReferences.size() ) {
+				colorResolveAttachmentReferences.push_back( resolveAttachmentReferences[ image_index ] );
+			} else {
+				colorResolveAttachmentReferences.push_back( {
+				    .sType      = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2,
+				    .pNext      = nullptr, // optional
+				    .attachment = VK_ATTACHMENT_UNUSED,
+				    .layout     = VK_IMAGE_LAYOUT_UNDEFINED,
+				    .aspectMask = 0,
+				} );
+			}
 		}
-
-		// -- create combined hash for pipeline, renderpass
-		pipeline_hash = SpookyHash::Hash64( pso_renderpass_hash_data, sizeof( uint64_t ) * pso_renderpass_hash_data_num_entries, pipeline_layout_hash );
 	}
 
-	// -- look up if pipeline with this hash already exists in cache
-	auto p = self->pipelines.try_find( pipeline_hash );
+	VkSubpassDescription2 subpassDescription{
+	    .sType                   = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2,
+	    .pNext                   = nullptr, // optional
+	    .flags                   = 0,       // optional
+	    .pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS,
+	    .viewMask                = 0,
+	    .inputAttachmentCount    = 0, // optional
+	    .pInputAttachments       = nullptr,
+	    .colorAttachmentCount    = uint32_t( colorAttachmentReferences.size() ), // optional
+	    .pColorAttachments       = colorAttachmentReferences.data(),
+	    .pResolveAttachments     = colorResolveAttachmentReferences.empty() ? nullptr : colorResolveAttachmentReferences.data(), // optional
+	    .pDepthStencilAttachment = hasDepthStencilAttachment ? &dsAttachmentReference : nullptr,                                 // optional
+	    .preserveAttachmentCount = 0,                                                                                            // optional
+	    .pPreserveAttachments    = nullptr,
+	};
 
-	if ( p ) {
-		// pipeline exists
-		pipeline_and_layout_info.pipeline = *p;
-	} else {
-		// -- if not, create pipeline in pipeline cache and store / retain it
-		pipeline_and_layout_info.pipeline = le_pipeline_cache_create_graphics_pipeline( self, pso, pass, subpass );
-		logger.info( "New VK Graphics Pipeline created: %p", pipeline_hash );
-		bool result = self->pipelines.try_insert( pipeline_hash, &pipeline_and_layout_info.pipeline );
-		assert( result && " pipeline insertion must be successful " );
-	}
+	// Backend renderpasses only ever have a single subpass, and so does this renderpass.
+	VkRenderPassCreateInfo2 renderpassCreateInfo{
+	    .sType                   = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2,
+	    .pNext                   = nullptr, // optional
+	    .flags                   = 0,       // optional
+	    .attachmentCount         = uint32_t( attachments.size() ),
+	    .pAttachments            = attachments.data(),
+	    .subpassCount            = 1,
+	    .pSubpasses              = &subpassDescription,
+	    .dependencyCount         = 0,
+	    .pDependencies           = nullptr,
+	    .correlatedViewMaskCount = 0,
+	    .pCorrelatedViewMasks    = nullptr,
+	};
 
-	return pipeline_and_layout_info;
+	VkRenderPass renderpass = nullptr;
+	vkCreateRenderPass2( device, &renderpassCreateInfo, nullptr, &renderpass );
+
+	return renderpass;
 }
 
-/// \brief Creates - or loads a pipeline from cache - based on current pipeline state
-/// \note This method may lock the pso cache and is therefore costly.
-//
-// + Only the 'command buffer recording'-slice of a frame shall be able to modify the cache.
-//   The cache must be exclusively accessed through this method
-//
-// + NOTE: Access to this method must be sequential - no two frames may access this method
-//   at the same time - and no two renderpasses may access this method at the same time.
-static le_pipeline_and_layout_info_t le_pipeline_manager_produce_rtx_pipeline( le_pipeline_manager_o* self, le_rtxpso_handle pso_handle, char** maybe_shader_group_data ) {
-	le_pipeline_and_layout_info_t pipeline_and_layout_info = {};
+// ----------------------------------------------------------------------
+// Runs on each async pipeline compiler thread: takes requests from the queue,
+// creates pipelines, and publishes them into the pipeline manager's `pipelines` map.
+static void le_pipeline_async_compiler_thread_main( le_pipeline_manager_o* self ) {
 
 	static auto logger = LeLog( LOGGER_LABEL );
-	// -- 0. Fetch pso from cache using its hash key
-	rtx_pipeline_state_o const* pso = self->rtxPso.try_find( pso_handle );
-	assert( pso );
+	auto        ac     = self->asyncCompiler;
 
-	// -- 1. get pipeline layout info for a pipeline with these bindings
-	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+	for ( ;; ) {
 
-	uint64_t pipeline_layout_hash{};
-	le_pipeline_manager_produce_pipeline_layout_info( self, pso->shaderStages.data(), pso->shaderStages.size(),
-	                                                  &pipeline_and_layout_info.layout_info, &pipeline_layout_hash );
+		le_pipeline_compile_request_t request;
 
-	// -- 2. get vk pipeline object
-	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+		{
+			auto lock = std::unique_lock( ac->mtx );
+			ac->cv_requests.wait( lock, [ ac ]() { return ac->should_stop || !ac->requests.empty(); } );
 
-	uint64_t pipeline_hash = 0;
-	{
-		// Create a hash over shader group data
+			if ( ac->should_stop ) {
+				return;
+			}
 
-		std::vector<uint64_t> pso_hash_data;
-		pso_hash_data.reserve( 64 );
+			request = std::move( ac->requests.front() );
+			ac->requests.pop_front();
+		}
 
-		pso_hash_data.emplace_back( reinterpret_cast<uint64_t>( pso_handle ) ); // Hash associated with `pso`
+		VkPipeline pipeline = nullptr;
 
-		for ( auto const& shader_stage : pso->shaderStages ) {
-			auto s = self->shaderManager->shaderModules.try_find( shader_stage );
-			assert( s && "could not find shader module" );
-			pso_hash_data.emplace_back( s->hash ); // Module state - may have been recompiled, hash must be current
+		{
+			ZoneScopedN( "Create Graphics Pipeline (async)" );
+
+			// Shader modules must not be replaced while we create a pipeline from them.
+			auto modules_lock = std::shared_lock( self->shaderManager->modules_mtx );
+
+			// Shader modules may have been updated since this request was made - in which case
+			// the pipeline we would create is outdated: the next frame will request a new one.
+			uint64_t layout_hash   = shader_modules_get_pipeline_layout_hash( self->shaderManager, request.pso->shaderModules.data(), request.pso->shaderModules.size() );
+			uint64_t pipeline_hash = le_pipeline_manager_calculate_graphics_pipeline_hash( self, request.pso, request.renderpass_hash, layout_hash );
+
+			if ( pipeline_hash == request.pipeline_hash ) {
+				BackendRenderPass pass{};
+				pass.renderPass          = le_pipeline_create_compatible_renderpass( self->device, request.attachments );
+				pass.renderpassHash      = request.renderpass_hash;
+				pass.numColorAttachments = request.num_color_attachments;
+				pass.sampleCount         = request.sample_count;
+
+				if ( pass.renderPass ) {
+					pipeline = le_pipeline_cache_create_graphics_pipeline( self, request.pso, pass, request.subpass );
+					vkDestroyRenderPass( self->device, pass.renderPass, nullptr );
+				}
+			}
 		}
 
-		// -- create combined hash for pipeline, renderpass
-		pipeline_hash = SpookyHash::Hash64( pso_hash_data.data(), pso_hash_data.size() * sizeof( uint64_t ), pipeline_layout_hash );
+		if ( pipeline ) {
+			if ( self->pipelines.try_insert( request.pipeline_hash, &pipeline ) ) {
+				self->vulkanCacheIsDirty = true;
+				logger.info( "New VK Graphics Pipeline created (async): %p", request.pipeline_hash );
+			} else {
+				vkDestroyPipeline( self->device, pipeline, nullptr );
+			}
+		}
 
-		// -- mix in hash over shader groups associated with the pso
+		{
+			auto lock = std::unique_lock( ac->mtx );
 
-		pipeline_hash = SpookyHash::Hash64( pso->shaderGroups.data(), pso->shaderGroups.size() * sizeof( le_rtx_shader_group_info ), pipeline_hash );
-	}
+			ac->pending_pipelines.erase( request.pipeline_hash );
 
-	// -- look up if pipeline with this hash already exists in cache
-	auto p = self->pipelines.try_find( pipeline_hash );
+			if ( pipeline ) {
+				uint64_t latency_us = uint64_t( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - request.time_requested ).count() );
 
-	if ( p ) {
-		// -- Pipeline was found: return pipeline found in hash map
-		pipeline_and_layout_info.pipeline = *p;
-	} else {
-		// -- Pipeline not found: Create pipeline in pipeline cache and store / retain it
-		pipeline_and_layout_info.pipeline = le_pipeline_cache_create_rtx_pipeline( self, pso );
+				ac->stats.num_pipelines_compiled++;
+				ac->stats.compile_latency_last_us = latency_us;
+				ac->stats.compile_latency_max_us  = std::max( ac->stats.compile_latency_max_us, latency_us );
+				ac->stats.compile_latency_total_us += latency_us;
+			}
 
-		logger.info( "New VK RTX Graphics Pipeline created: %p", pipeline_hash );
+			ac->stats.num_pipelines_pending = ac->pending_pipelines.size();
+		}
+	}
+}
 
-		// Store pipeline in pipeline cache
-		bool result = self->pipelines.try_insert( pipeline_hash, &pipeline_and_layout_info.pipeline );
+// ----------------------------------------------------------------------
 
-		assert( result && "pipeline insertion must be successful" );
+static le_pipeline_async_compiler_o* le_pipeline_async_compiler_create( le_pipeline_manager_o* self, uint32_t num_threads ) {
+	auto ac             = new le_pipeline_async_compiler_o();
+	self->asyncCompiler = ac;
+
+	for ( uint32_t i = 0; i != num_threads; i++ ) {
+		ac->threads.emplace_back( le_pipeline_async_compiler_thread_main, self );
 	}
 
-	if ( maybe_shader_group_data ) {
+	return ac;
+}
 
-		// -- shader group data was requested
+// ----------------------------------------------------------------------
+// Any requests which have not been started yet get dropped; we wait for
+// requests which are currently in flight to complete.
+static void le_pipeline_async_compiler_destroy( le_pipeline_async_compiler_o* self ) {
+	{
+		auto lock         = std::unique_lock( self->mtx );
+		self->should_stop = true;
+		self->requests.clear();
+	}
 
-		auto g = self->rtx_shader_group_data.try_find( pipeline_hash );
+	self->cv_requests.notify_all();
 
-		if ( g ) {
-			*maybe_shader_group_data = *g;
-		} else {
-			// If shader group data was not found, we must must query, and store it.
-			static VkPhysicalDeviceRayTracingPipelinePropertiesKHR props;
+	for ( auto& t : self->threads ) {
+		t.join();
+	}
 
-			le_backend_vk::vk_device_i.get_vk_physical_device_ray_tracing_properties( self->le_device, &props );
+	delete self;
+}
 
-			size_t dataSize   = props.shaderGroupHandleSize * pso->shaderGroups.size();
-			size_t bufferSize = dataSize + sizeof( LeShaderGroupDataHeader );
+// ----------------------------------------------------------------------
 
-			// Allocate buffer to store handles
-			char* handles = static_cast<char*>( malloc( bufferSize ) );
+static void le_pipeline_manager_get_async_compilation_stats( le_pipeline_manager_o* self, le_pipeline_compilation_stats_t* stats ) {
+	if ( nullptr == self->asyncCompiler ) {
+		*stats = {};
+		return;
+	}
+	auto lock = std::unique_lock( self->asyncCompiler->mtx );
+	*stats    = self->asyncCompiler->stats;
+}
 
-			// The buffer used to store handles contains a header,
-			// First element is header size,
+// ----------------------------------------------------------------------
 
-			LeShaderGroupDataHeader header;
-			header.pipeline_obj                    = pipeline_and_layout_info.pipeline;
-			header.data_byte_count                 = uint32_t( dataSize );
+static void le_pipeline_manager_add_skipped_draws( le_pipeline_manager_o* self, uint32_t num_draws ) {
+	if ( nullptr == self->asyncCompiler || 0 == num_draws ) {
+		return;
+	}
+	auto lock = std::unique_lock( self->asyncCompiler->mtx );
+	self->asyncCompiler->stats.num_draws_skipped += num_draws;
+}
+
+// ----------------------------------------------------------------------
+// The pipeline manifest records everything needed to re-create graphics pipelines
+// which were produced during a previous run: pso state, the shader modules used
+// by the pso, and a description of the renderpass that the pipeline must be
+// compatible with. At load time, the manifest may be replayed so that pipelines
+// are ready before they are first drawn with.
+//
+struct le_pipeline_manifest_shader_module_t {
+	std::string                           path;
+	std::string                           macro_defines;
+	le::ShaderStage                       stage;
+	le::ShaderSourceLanguage              source_language;
+	std::vector<VkSpecializationMapEntry> specialization_map_entries;
+	std::vector<char>                     specialization_map_data;
+};
+
+struct le_pipeline_manifest_entry_t {
+	uint64_t                                           pipeline_hash;   // at the time of recording, used to de-duplicate entries
+	le_graphics_pipeline_builder_data                  pso_data;
+	std::vector<le_vertex_input_attribute_description> explicit_vertex_attribute_descriptions;
+	std::vector<le_vertex_input_binding_description>   explicit_vertex_input_binding_descriptions;
+	std::vector<le_pipeline_manifest_shader_module_t>  shader_modules;
+	uint64_t                                           renderpass_hash; // hash for *compatible* renderpass, as calculated by the backend
+	uint32_t                                           subpass;
+	uint32_t                                           num_color_attachments;
+	uint32_t                                           sample_count;    // le::SampleCountFlagBits
+	uint32_t                                           num_runs_unused; // number of runs since this pipeline was last created, or found to be current
+	std::vector<le_pipeline_compatible_attachment_t>   attachments;
+};
+
+struct le_pipeline_manifest_o {
+	std::mutex                                mtx;
+	std::vector<le_pipeline_manifest_entry_t> entries;
+	std::unordered_map<uint64_t, size_t>      entry_indices;    // pipeline hash -> index into entries, size_t(-1) while an entry is being added
+	bool                                      is_dirty = false; // whether entries were changed since the manifest was last written to disk
+};
+
+// ----------------------------------------------------------------------
+// Marks the manifest entry for this pipeline as used in the current run - stale entries,
+// which have not been used for a number of runs, get dropped when the manifest is loaded.
+static void le_pipeline_manifest_mark_used( le_pipeline_manifest_o* manifest, uint64_t pipeline_hash ) {
+	if ( nullptr == manifest ) {
+		return;
+	}
+
+	auto lock = std::unique_lock( manifest->mtx );
+	auto it   = manifest->entry_indices.find( pipeline_hash );
+
+	if ( it != manifest->entry_indices.end() && it->second < manifest->entries.size() &&
+	     manifest->entries[ it->second ].num_runs_unused != 0 ) {
+		manifest->entries[ it->second ].num_runs_unused = 0;
+		manifest->is_dirty                              = true;
+	}
+}
+
+// ----------------------------------------------------------------------
+// Adds an entry to the pipeline manifest, if recording is enabled, and the
+// manifest does not yet have an entry for this pipeline.
+static void le_pipeline_manifest_record( le_pipeline_manager_o* self, graphics_pipeline_state_o const* pso, BackendRenderPass const& pass, uint32_t subpass, uint64_t pipeline_hash ) {
+
+	auto manifest = self->manifest;
+
+	if ( nullptr == manifest ) {
+		return;
+	}
+
+	{
+		auto lock = std::unique_lock( manifest->mtx );
+		auto it   = manifest->entry_indices.find( pipeline_hash );
+		if ( it != manifest->entry_indices.end() ) {
+			// We already have an entry for this pipeline - or another thread is about to add one
+			if ( it->second < manifest->entries.size() && manifest->entries[ it->second ].num_runs_unused != 0 ) {
+				manifest->entries[ it->second ].num_runs_unused = 0;
+				manifest->is_dirty                              = true;
+			}
+			return;
+		}
+		manifest->entry_indices[ pipeline_hash ] = size_t( -1 ); // reserve, so that no other thread adds this pipeline
+	}
+
+	// ----------| invariant: this pipeline is new to the manifest
+
+	le_pipeline_manifest_entry_t entry{};
+
+	entry.pipeline_hash                              = pipeline_hash;
+	entry.pso_data                                   = pso->data;
+	entry.explicit_vertex_attribute_descriptions     = pso->explicitVertexAttributeDescriptions;
+	entry.explicit_vertex_input_binding_descriptions = pso->explicitVertexInputBindingDescriptions;
+	entry.renderpass_hash                            = pass.renderpassHash;
+	entry.subpass                                    = subpass;
+	entry.num_color_attachments                      = pass.numColorAttachments;
+	entry.sample_count                               = uint32_t( pass.sampleCount );
+	entry.num_runs_unused                            = 0;
+
+	for ( auto const& s : pso->shaderModules ) {
+		auto p_module = self->shaderManager->shaderModules.try_find( s );
+		assert( p_module && "shader module not found" );
+
+		entry.shader_modules.push_back( {
+		    .path                       = p_module->filepath.string(),
+		    .macro_defines              = p_module->macro_defines,
+		    .stage                      = p_module->stage,
+		    .source_language            = p_module->source_language,
+		    .specialization_map_entries = p_module->specialization_map_info.entries,
+		    .specialization_map_data    = p_module->specialization_map_info.data,
+		} );
+	}
+
+	entry.attachments = le_pipeline_get_compatible_attachments( pass );
+
+	auto lock                                = std::unique_lock( manifest->mtx );
+	manifest->entry_indices[ pipeline_hash ] = manifest->entries.size();
+	manifest->entries.emplace_back( std::move( entry ) );
+	manifest->is_dirty = true;
+}
+
+// ----------------------------------------------------------------------
+// Note: expects self->mtx to be held by caller.
+static le_pipeline_and_layout_info_t le_pipeline_manager_produce_graphics_pipeline_locked(
+    le_pipeline_manager_o*   self,
+    le_gpso_handle           gpso_handle,
+    const BackendRenderPass& pass, uint32_t subpass,
+    bool                     allow_async ) {
+
+	// TODO: Check whether the current gpso is dirty - if not, we should be able to use a cached version
+	// via self.pipelines
+
+	// What would taint the gpso: if any of the modules a gpso depends upon had changed, that would mean it
+	// was tainted. We could keep an internal table of modules -> gpso and taint any gpso that made use of
+	// a changed module.
+
+	static auto                   logger                   = LeLog( LOGGER_LABEL );
+	le_pipeline_and_layout_info_t pipeline_and_layout_info = {};
+
+	// -- 0. Fetch pso from cache using its hash key
+	graphics_pipeline_state_o const* pso = self->graphicsPso.try_find( gpso_handle );
+	assert( pso );
+
+	// -- 1. get pipeline layout info for a pipeline with these bindings
+	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+
+	uint64_t pipeline_layout_hash{};
+	le_pipeline_manager_produce_pipeline_layout_info( self, pso->shaderModules.data(), pso->shaderModules.size(),
+	                                                  &pipeline_and_layout_info.layout_info, &pipeline_layout_hash );
+
+	// -- 2. get vk pipeline object
+	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+
+	uint64_t pipeline_hash = le_pipeline_manager_calculate_graphics_pipeline_hash( self, pso, pass.renderpassHash, pipeline_layout_hash );
+
+	// -- look up if pipeline with this hash already exists in cache
+	auto p = self->pipelines.try_find( pipeline_hash );
+
+	if ( p ) {
+		// pipeline exists
+		pipeline_and_layout_info.pipeline = *p;
+	} else if ( allow_async && self->asyncCompiler ) {
+
+		// -- Request pipeline to be created in the background. Until it is ready, we return
+		// the pso's fallback pipeline, if it has one - otherwise a null pipeline, which tells
+		// the caller to skip any draws which would use this pipeline.
+
+		auto ac             = self->asyncCompiler;
+		bool is_new_request = false;
+		{
+			auto lock = std::unique_lock( ac->mtx );
+
+			if ( ac->pending_pipelines.insert( pipeline_hash ).second ) {
+				is_new_request = true;
+				ac->requests.push_back( {
+				    .pipeline_hash         = pipeline_hash,
+				    .pso                   = pso,
+				    .attachments           = le_pipeline_get_compatible_attachments( pass ),
+				    .renderpass_hash       = pass.renderpassHash,
+				    .num_color_attachments = pass.numColorAttachments,
+				    .sample_count          = pass.sampleCount,
+				    .subpass               = subpass,
+				    .time_requested        = std::chrono::steady_clock::now(),
+				} );
+				ac->stats.num_pipelines_pending = ac->pending_pipelines.size();
+				ac->cv_requests.notify_one();
+			}
+		}
+
+		if ( is_new_request ) {
+			le_pipeline_manifest_record( self, pso, pass, subpass, pipeline_hash );
+		}
+
+		pipeline_and_layout_info.pipeline = nullptr;
+
+		if ( pso->fallback_pso ) {
+			// Fallback pipelines are always created synchronously, so that they are guaranteed to be available.
+			graphics_pipeline_state_o const* fallback_pso = self->graphicsPso.try_find( pso->fallback_pso );
+			assert( fallback_pso );
+
+			uint64_t fallback_layout_hash = shader_modules_get_pipeline_layout_hash( self->shaderManager, fallback_pso->shaderModules.data(), fallback_pso->shaderModules.size() );
+
+			// Arguments get bound according to the requested pipeline's layout - we may only draw
+			// with the fallback if its layout is the same; otherwise draws must be skipped.
+			if ( fallback_layout_hash == pipeline_layout_hash ) {
+				pipeline_and_layout_info.pipeline =
+				    le_pipeline_manager_produce_graphics_pipeline_locked( self, pso->fallback_pso, pass, subpass, false ).pipeline;
+			}
+		}
+	} else {
+		// -- if not, create pipeline in pipeline cache and store / retain it
+		VkPipeline pipeline = le_pipeline_cache_create_graphics_pipeline( self, pso, pass, subpass );
+
+		if ( self->pipelines.try_insert( pipeline_hash, &pipeline ) ) {
+			self->vulkanCacheIsDirty = true;
+			logger.info( "New VK Graphics Pipeline created: %p", pipeline_hash );
+			le_pipeline_manifest_record( self, pso, pass, subpass, pipeline_hash );
+			pipeline_and_layout_info.pipeline = pipeline;
+		} else {
+			// An asynchronous compile - or pipeline pre-creation from the manifest - has published
+			// this pipeline while we were creating it: use the published pipeline, and drop ours.
+			vkDestroyPipeline( self->device, pipeline, nullptr );
+			pipeline_and_layout_info.pipeline = *self->pipelines.try_find( pipeline_hash );
+		}
+	}
+
+	return pipeline_and_layout_info;
+}
+
+/// \brief Creates - or loads a pipeline from cache - based on current pipeline state
+/// \note This method only locks the pipeline manager if a pipeline must be created - lookups of existing pipelines are lock-free.
+//
+// + Only the 'command buffer recording'-slice of a frame shall be able to modify the cache.
+//   The cache must be exclusively accessed through this method
+//
+// + NOTE: Access to this method must be sequential - no two frames may access this method
+//   at the same time - and no two renderpasses may access this method at the same time.
+//
+// + If async pipeline compilation is enabled, the returned pipeline may be nullptr if the
+//   pipeline is not ready yet, and the pso has no fallback - draws using it must be skipped.
+static le_pipeline_and_layout_info_t le_pipeline_manager_produce_graphics_pipeline(
+    le_pipeline_manager_o*   self,
+    le_gpso_handle           gpso_handle,
+    const BackendRenderPass& pass, uint32_t subpass ) {
+
+	// Fast path: pipeline and pipeline layout info already exist - all lookups are wait-free,
+	// which means that we don't need to take the lock in the common case.
+	{
+		graphics_pipeline_state_o const* pso = self->graphicsPso.try_find( gpso_handle );
+		assert( pso );
+
+		uint64_t pipeline_layout_hash = shader_modules_get_pipeline_layout_hash( self->shaderManager, pso->shaderModules.data(), pso->shaderModules.size() );
+
+		le_pipeline_layout_info const* layout_info = self->pipelineLayoutInfos.try_find( pipeline_layout_hash );
+
+		if ( layout_info ) {
+			uint64_t pipeline_hash = le_pipeline_manager_calculate_graphics_pipeline_hash( self, pso, pass.renderpassHash, pipeline_layout_hash );
+
+			if ( VkPipeline const* p = self->pipelines.try_find( pipeline_hash ) ) {
+				return { .pipeline = *p, .layout_info = *layout_info };
+			}
+		}
+	}
+
+	// ----------| invariant: pipeline, or pipeline layout info must be created, or requested
+
+	auto lock = std::unique_lock( self->mtx ); // Enforce sequentiality via scoped lock: no two renderpasses may modify cache concurrently.
+
+	return le_pipeline_manager_produce_graphics_pipeline_locked( self, gpso_handle, pass, subpass, true );
+}
+
+/// \brief Creates - or loads a pipeline from cache - based on current pipeline state
+/// \note This method may lock the pso cache and is therefore costly.
+//
+// + Only the 'command buffer recording'-slice of a frame shall be able to modify the cache.
+//   The cache must be exclusively accessed through this method
+//
+// + NOTE: Access to this method must be sequential - no two frames may access this method
+//   at the same time - and no two renderpasses may access this method at the same time.
+static le_pipeline_and_layout_info_t le_pipeline_manager_produce_rtx_pipeline( le_pipeline_manager_o* self, le_rtxpso_handle pso_handle, char** maybe_shader_group_data ) {
+	le_pipeline_and_layout_info_t pipeline_and_layout_info = {};
+
+	static auto logger = LeLog( LOGGER_LABEL );
+	// -- 0. Fetch pso from cache using its hash key
+	rtx_pipeline_state_o const* pso = self->rtxPso.try_find( pso_handle );
+	assert( pso );
+
+	// -- 1. get pipeline layout info for a pipeline with these bindings
+	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+
+	uint64_t pipeline_layout_hash{};
+	le_pipeline_manager_produce_pipeline_layout_info( self, pso->shaderStages.data(), pso->shaderStages.size(),
+	                                                  &pipeline_and_layout_info.layout_info, &pipeline_layout_hash );
+
+	// -- 2. get vk pipeline object
+	// we try to fetch it from the cache first, if it doesn't exist, we must create it, and add it to the cache.
+
+	uint64_t pipeline_hash = 0;
+	{
+		// Create a hash over shader group data
+
+		std::vector<uint64_t> pso_hash_data;
+		pso_hash_data.reserve( 64 );
+
+		pso_hash_data.emplace_back( reinterpret_cast<uint64_t>( pso_handle ) ); // Hash associated with `pso`
+
+		for ( auto const& shader_stage : pso->shaderStages ) {
+			auto s = self->shaderManager->shaderModules.try_find( shader_stage );
+			assert( s && "could not find shader module" );
+			pso_hash_data.emplace_back( s->hash ); // Module state - may have been recompiled, hash must be current
+		}
+
+		// -- create combined hash for pipeline, renderpass
+		pipeline_hash = SpookyHash::Hash64( pso_hash_data.data(), pso_hash_data.size() * sizeof( uint64_t ), pipeline_layout_hash );
+
+		// -- mix in hash over shader groups associated with the pso
+
+		pipeline_hash = SpookyHash::Hash64( pso->shaderGroups.data(), pso->shaderGroups.size() * sizeof( le_rtx_shader_group_info ), pipeline_hash );
+	}
+
+	// -- look up if pipeline with this hash already exists in cache
+	auto p = self->pipelines.try_find( pipeline_hash );
+
+	if ( p ) {
+		// -- Pipeline was found: return pipeline found in hash map
+		pipeline_and_layout_info.pipeline = *p;
+	} else {
+		// -- Pipeline not found: Create pipeline in pipeline cache and store / retain it
+		pipeline_and_layout_info.pipeline = le_pipeline_cache_create_rtx_pipeline( self, pso );
+		self->vulkanCacheIsDirty          = true;
+
+		logger.info( "New VK RTX Graphics Pipeline created: %p", pipeline_hash );
+
+		// Store pipeline in pipeline cache
+		bool result = self->pipelines.try_insert( pipeline_hash, &pipeline_and_layout_info.pipeline );
+
+		assert( result && "pipeline insertion must be successful" );
+	}
+
+	if ( maybe_shader_group_data ) {
+
+		// -- shader group data was requested
+
+		auto g = self->rtx_shader_group_data.try_find( pipeline_hash );
+
+		if ( g ) {
+			*maybe_shader_group_data = *g;
+		} else {
+			// If shader group data was not found, we must must query, and store it.
+			static VkPhysicalDeviceRayTracingPipelinePropertiesKHR props;
+
+			le_backend_vk::vk_device_i.get_vk_physical_device_ray_tracing_properties( self->le_device, &props );
+
+			size_t dataSize   = props.shaderGroupHandleSize * pso->shaderGroups.size();
+			size_t bufferSize = dataSize + sizeof( LeShaderGroupDataHeader );
+
+			// Allocate buffer to store handles
+			char* handles = static_cast<char*>( malloc( bufferSize ) );
+
+			// The buffer used to store handles contains a header,
+			// First element is header size,
+
+			LeShaderGroupDataHeader header;
+			header.pipeline_obj                    = pipeline_and_layout_info.pipeline;
+			header.data_byte_count                 = uint32_t( dataSize );
 			header.rtx_shader_group_handle_size    = props.shaderGroupHandleSize;
 			header.rtx_shader_group_base_alignment = props.shaderGroupBaseAlignment;
 
@@ -2307,6 +3428,7 @@ static le_pipeline_and_layout_info_t le_pipeline_manager_produce_compute_pipelin
 	} else {
 		// -- if not, create pipeline in pipeline cache and store / retain it
 		pipeline_and_layout_info.pipeline = le_pipeline_cache_create_compute_pipeline( self, pso );
+		self->vulkanCacheIsDirty          = true;
 		logger.info( "New VK Compute Pipeline created: %p", pipeline_hash );
 		bool result = self->pipelines.try_insert( pipeline_hash, &pipeline_and_layout_info.pipeline );
 		assert( result && "insertion must be successful" );
@@ -2315,6 +3437,68 @@ static le_pipeline_and_layout_info_t le_pipeline_manager_produce_compute_pipelin
 	return pipeline_and_layout_info;
 }
 
+// ----------------------------------------------------------------------
+// Returns a representative topology for the topology class of `topology` -
+// with dynamic primitive topology, the topology used for pipeline creation
+// must only match the topology class of the topology set dynamically.
+static VkPrimitiveTopology vk_primitive_topology_get_class( VkPrimitiveTopology const& topology ) {
+	switch ( topology ) {
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:                     // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:                    // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:      // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:     //
+		return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:                 // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:                // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:                  // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST_WITH_ADJACENCY:  // fall-through
+	case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY: //
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	default:
+		return topology;
+	}
+}
+
+// ----------------------------------------------------------------------
+// Resets any state in `data` which is set dynamically at the given extended dynamic
+// state level, so that it does not contribute to the vk pipeline hash.
+// This must mirror the dynamic states set up in `le_pipeline_cache_create_graphics_pipeline`
+static void graphics_pipeline_state_mask_dynamic_state( le_graphics_pipeline_builder_data& data, uint32_t extended_dynamic_state_level ) {
+
+	if ( extended_dynamic_state_level >= 1 ) {
+		data.rasterizationInfo.cullMode              = {};
+		data.rasterizationInfo.frontFace             = {};
+		data.inputAssemblyState.topology             = vk_primitive_topology_get_class( data.inputAssemblyState.topology );
+		data.depthStencilState.depthTestEnable       = {};
+		data.depthStencilState.depthWriteEnable      = {};
+		data.depthStencilState.depthCompareOp        = {};
+		data.depthStencilState.depthBoundsTestEnable = {};
+		data.depthStencilState.stencilTestEnable     = {};
+		data.depthStencilState.front.failOp          = {};
+		data.depthStencilState.front.passOp          = {};
+		data.depthStencilState.front.depthFailOp     = {};
+		data.depthStencilState.front.compareOp       = {};
+		data.depthStencilState.back.failOp           = {};
+		data.depthStencilState.back.passOp           = {};
+		data.depthStencilState.back.depthFailOp      = {};
+		data.depthStencilState.back.compareOp        = {};
+	}
+
+	if ( extended_dynamic_state_level >= 2 ) {
+		data.rasterizationInfo.depthBiasEnable         = {};
+		data.rasterizationInfo.rasterizerDiscardEnable = {};
+		data.inputAssemblyState.primitiveRestartEnable = {};
+	}
+
+	if ( extended_dynamic_state_level >= 3 ) {
+		data.rasterizationInfo.polygonMode = {};
+		memset( data.blend_factor_constants, 0, sizeof( data.blend_factor_constants ) );
+		memset( data.blendAttachmentStates, 0, sizeof( data.blendAttachmentStates ) );
+	}
+}
+
 // ----------------------------------------------------------------------
 // This method may get called through the pipeline builder -
 // via RECORD in command buffer recording state
@@ -2323,6 +3507,24 @@ bool le_pipeline_manager_introduce_graphics_pipeline_state( le_pipeline_manager_
 
 	constexpr size_t hash_msg_size = sizeof( le_graphics_pipeline_builder_data );
 	uint64_t         hash_value    = SpookyHash::Hash64( &pso->data, hash_msg_size, 0 );
+
+	// If any state is dynamic, we calculate a second hash over pso state with dynamic state
+	// masked out - this second hash identifies the vk pipeline, while the first hash
+	// (`hash_value`) identifies the pso, including its defaults for any dynamic state.
+
+	uint64_t vk_pipeline_hash_value = hash_value;
+
+	if ( self->extended_dynamic_state_level > 0 ) {
+		le_graphics_pipeline_builder_data static_data = pso->data;
+		graphics_pipeline_state_mask_dynamic_state( static_data, self->extended_dynamic_state_level );
+		vk_pipeline_hash_value = SpookyHash::Hash64( &static_data, hash_msg_size, 0 );
+	}
+
+	// The fallback pipeline is part of the pso - psos which only differ in their fallback must
+	// not share a handle. It only affects which pipeline gets used while this pso's vk pipeline
+	// is not yet available, and is therefore not part of `vk_pipeline_hash_value`.
+	hash_value = SpookyHash::Hash64( &pso->fallback_pso, sizeof( le_gpso_handle ), hash_value );
+
 	// Calculate a meta-hash over shader stage hash entries so that we can
 	// detect if a shader component has changed
 	//
@@ -2344,7 +3546,8 @@ bool le_pipeline_manager_introduce_graphics_pipeline_state( le_pipeline_manager_
 	// Mix in the meta-hash over shader stages with the previous hash over pipeline state
 	// which gives the complete hash representing a pipeline state object.
 
-	hash_value = SpookyHash::Hash64( stageHashEntries, stageHashEntriesUsed * sizeof( uint64_t ), hash_value );
+	hash_value             = SpookyHash::Hash64( stageHashEntries, stageHashEntriesUsed * sizeof( uint64_t ), hash_value );
+	vk_pipeline_hash_value = SpookyHash::Hash64( stageHashEntries, stageHashEntriesUsed * sizeof( uint64_t ), vk_pipeline_hash_value );
 
 	// -- If pipeline has explicit attribute binding stages that must be factored in with the hash.
 
@@ -2360,8 +3563,18 @@ bool le_pipeline_manager_introduce_graphics_pipeline_state( le_pipeline_manager_
 		hash_value = SpookyHash::Hash64( pso->explicitVertexAttributeDescriptions.data(),
 		                                 pso->explicitVertexAttributeDescriptions.size() * sizeof( le_vertex_input_attribute_description ),
 		                                 hash_value );
+
+		vk_pipeline_hash_value = SpookyHash::Hash64( pso->explicitVertexInputBindingDescriptions.data(),
+		                                             pso->explicitVertexInputBindingDescriptions.size() * sizeof( le_vertex_input_binding_description ),
+		                                             vk_pipeline_hash_value );
+
+		vk_pipeline_hash_value = SpookyHash::Hash64( pso->explicitVertexAttributeDescriptions.data(),
+		                                             pso->explicitVertexAttributeDescriptions.size() * sizeof( le_vertex_input_attribute_description ),
+		                                             vk_pipeline_hash_value );
 	}
 
+	pso->vk_pipeline_hash = vk_pipeline_hash_value;
+
 	// Cast hash_value to a pipeline handle, so we can use the type system with it.
 	// Its value, of course, is still equivalent to hash_value.
 
@@ -2425,6 +3638,14 @@ bool le_pipeline_manager_introduce_rtx_pipeline_state( le_pipeline_manager_o* se
 	return self->rtxPso.try_insert( *handle, pso );
 };
 
+// ----------------------------------------------------------------------
+// Returns pso state data so that the backend may set any dynamic state to
+// the defaults given via the pipeline builder when binding a pipeline.
+static le_graphics_pipeline_builder_data const* le_pipeline_manager_get_graphics_pipeline_state_data( le_pipeline_manager_o* self, le_gpso_handle gpso_handle ) {
+	graphics_pipeline_state_o const* pso = self->graphicsPso.try_find( gpso_handle );
+	return pso ? &pso->data : nullptr;
+}
+
 // ----------------------------------------------------------------------
 
 static VkPipelineLayout le_pipeline_manager_get_pipeline_layout_public( le_pipeline_manager_o* self, uint64_t key ) {
@@ -2466,32 +3687,731 @@ static le_shader_module_handle le_pipeline_manager_create_shader_module(
 }
 
 // ----------------------------------------------------------------------
+// The vulkan pipeline cache is persisted to disk so that pipelines don't have to be
+// compiled from scratch on every application start. The driver validates its own
+// cache data, but we prefix the file with a header of our own so that we may reject
+// data written by a different device or driver, or a truncated file, up-front.
+//
+struct le_pipeline_cache_file_header_t {
+	uint32_t magic;                               // must be LE_PIPELINE_CACHE_FILE_MAGIC
+	uint32_t header_size;                         // sizeof(le_pipeline_cache_file_header_t)
+	uint32_t vendor_id;                           // VkPhysicalDeviceProperties::vendorID
+	uint32_t device_id;                           // VkPhysicalDeviceProperties::deviceID
+	uint32_t driver_version;                      // VkPhysicalDeviceProperties::driverVersion
+	uint32_t reserved;                            // padding, must be 0
+	uint8_t  pipeline_cache_uuid[ VK_UUID_SIZE ]; // VkPhysicalDeviceProperties::pipelineCacheUUID
+	uint64_t data_size;                           // number of bytes of vk pipeline cache data following this header
+	uint64_t data_hash;                           // SpookyHash over vk pipeline cache data following this header
+};
 
-static void le_pipeline_manager_update_shader_modules( le_pipeline_manager_o* self ) {
-	le_shader_manager_update_shader_modules( self->shaderManager );
+static constexpr uint32_t LE_PIPELINE_CACHE_FILE_MAGIC = 0x4350454c; // 'LEPC'
+
+// ----------------------------------------------------------------------
+// Pipeline cache file lives in the same directory as the executable
+static std::filesystem::path le_pipeline_cache_get_file_path() {
+	return le_pipeline_get_executable_directory() / "le_pipeline_cache.bin";
 }
 
 // ----------------------------------------------------------------------
 
-static le_pipeline_manager_o* le_pipeline_manager_create( le_device_o* le_device ) {
-	auto self = new le_pipeline_manager_o();
+static le_pipeline_cache_file_header_t le_pipeline_cache_file_header_create( le_pipeline_manager_o const* self ) {
 
 	using namespace le_backend_vk;
-	self->le_device = le_device;
-	vk_device_i.increase_reference_count( le_device );
-	self->device = vk_device_i.get_vk_device( le_device );
+	VkPhysicalDeviceProperties const* props = vk_device_i.get_vk_physical_device_properties( self->le_device );
 
-	VkPipelineCacheCreateInfo info = {
-	    .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-	    .pNext           = nullptr, // optional
-	    .flags           = 0,       // optional
-	    .initialDataSize = 0,       // optional
-	    .pInitialData    = nullptr,
+	le_pipeline_cache_file_header_t header{};
+
+	header.magic          = LE_PIPELINE_CACHE_FILE_MAGIC;
+	header.header_size    = sizeof( le_pipeline_cache_file_header_t );
+	header.vendor_id      = props->vendorID;
+	header.device_id      = props->deviceID;
+	header.driver_version = props->driverVersion;
+	memcpy( header.pipeline_cache_uuid, props->pipelineCacheUUID, VK_UUID_SIZE );
+
+	return header;
+}
+
+// ----------------------------------------------------------------------
+// Loads pipeline cache data from disk into `data` - returns false if there was no
+// cache file, or if the cache file did not match the current device and driver.
+static bool le_pipeline_cache_load_from_disk( le_pipeline_manager_o const* self, std::vector<char>& data ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	auto const file_path = le_pipeline_cache_get_file_path();
+
+	std::error_code ec;
+	if ( !std::filesystem::exists( file_path, ec ) ) {
+		return false;
+	}
+
+	// ----------| invariant: cache file exists
+
+	std::vector<char> file_contents;
+
+	if ( !load_file( file_path, file_contents ) ||
+	     file_contents.size() < sizeof( le_pipeline_cache_file_header_t ) ) {
+		logger.warn( "Could not read pipeline cache file: '%s'", file_path.string().c_str() );
+		return false;
+	}
+
+	le_pipeline_cache_file_header_t stored_header;
+	memcpy( &stored_header, file_contents.data(), sizeof( le_pipeline_cache_file_header_t ) );
+
+	le_pipeline_cache_file_header_t const expected_header = le_pipeline_cache_file_header_create( self );
+
+	char const* payload = file_contents.data() + sizeof( le_pipeline_cache_file_header_t );
+
+	if ( stored_header.magic != expected_header.magic ||
+	     stored_header.header_size != expected_header.header_size ||
+	     stored_header.vendor_id != expected_header.vendor_id ||
+	     stored_header.device_id != expected_header.device_id ||
+	     stored_header.driver_version != expected_header.driver_version ||
+	     0 != memcmp( stored_header.pipeline_cache_uuid, expected_header.pipeline_cache_uuid, VK_UUID_SIZE ) ) {
+		logger.info( "Ignoring pipeline cache file '%s': it was written by a different device or driver.", file_path.string().c_str() );
+		return false;
+	}
+
+	if ( stored_header.data_size != file_contents.size() - sizeof( le_pipeline_cache_file_header_t ) ||
+	     stored_header.data_hash != SpookyHash::Hash64( payload, stored_header.data_size, 0 ) ) {
+		logger.warn( "Ignoring pipeline cache file '%s': data is corrupt.", file_path.string().c_str() );
+		return false;
+	}
+
+	// ----------| invariant: cache file is valid for this device and driver
+
+	data.assign( payload, payload + stored_header.data_size );
+
+	logger.info( "Loaded pipeline cache from '%s' (%zu bytes)", file_path.string().c_str(), data.size() );
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Writes current vk pipeline cache data to disk.
+// We write to a temporary file first, and then rename, so that a crash while writing can't
+// leave a partially written cache file behind.
+static bool le_pipeline_cache_write_to_disk( le_pipeline_manager_o* self ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	size_t data_size = 0;
+	vkGetPipelineCacheData( self->device, self->vulkanCache, &data_size, nullptr );
+
+	std::vector<char> data( data_size );
+
+	// Note that data_size may change in-between calls, if pipelines are being created
+	// concurrently - in which case data gets truncated to a valid (partial) cache.
+	auto result = vkGetPipelineCacheData( self->device, self->vulkanCache, &data_size, data.data() );
+
+	if ( result != VK_SUCCESS && result != VK_INCOMPLETE ) {
+		logger.warn( "Could not retrieve pipeline cache data." );
+		return false;
+	}
+
+	data.resize( data_size );
+
+	le_pipeline_cache_file_header_t header = le_pipeline_cache_file_header_create( self );
+
+	header.data_size = data.size();
+	header.data_hash = SpookyHash::Hash64( data.data(), data.size(), 0 );
+
+	auto const file_path      = le_pipeline_cache_get_file_path();
+	auto       file_path_temp = file_path;
+	file_path_temp += ".tmp";
+
+	{
+		std::ofstream file( file_path_temp, std::ios::out | std::ios::binary | std::ios::trunc );
+
+		if ( !file.is_open() ) {
+			logger.warn( "Could not open pipeline cache file for writing: '%s'", file_path_temp.string().c_str() );
+			return false;
+		}
+
+		file.write( reinterpret_cast<char const*>( &header ), sizeof( header ) );
+		file.write( data.data(), std::streamsize( data.size() ) );
+
+		if ( !file.good() ) {
+			logger.warn( "Could not write pipeline cache file: '%s'", file_path_temp.string().c_str() );
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( file_path_temp, file_path, ec );
+
+	if ( ec ) {
+		logger.warn( "Could not move pipeline cache file into place: '%s' (%s)", file_path.string().c_str(), ec.message().c_str() );
+		return false;
+	}
+
+	logger.info( "Saved pipeline cache to '%s' (%zu bytes)", file_path.string().c_str(), data.size() );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Writes vk pipeline cache data to disk if any pipelines were created since the last successful write.
+static bool le_pipeline_cache_save_to_disk( le_pipeline_manager_o* self ) {
+
+	if ( nullptr == self->vulkanCache || false == self->vulkanCacheIsDirty.exchange( false ) ) {
+		return false;
+	}
+
+	// ----------| invariant: pipeline cache has new contents
+
+	// We clear the dirty flag before we fetch cache data, so that pipelines which get created
+	// while we write mark the cache as dirty again. If the write fails, we restore the flag,
+	// so that the next save tries again.
+	if ( false == le_pipeline_cache_write_to_disk( self ) ) {
+		self->vulkanCacheIsDirty = true;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Pipeline manifest file: a header, followed by serialized manifest entries.
+//
+struct le_pipeline_manifest_file_header_t {
+	uint32_t magic;         // must be LE_PIPELINE_MANIFEST_FILE_MAGIC
+	uint32_t version;       // must be LE_PIPELINE_MANIFEST_VERSION
+	uint32_t pso_data_size; // sizeof(le_graphics_pipeline_builder_data) - entries can't be read if this changed
+	uint32_t num_entries;   // number of manifest entries following this header
+	uint64_t data_size;     // number of bytes of entry data following this header
+	uint64_t data_hash;     // SpookyHash over entry data following this header
+};
+
+static constexpr uint32_t LE_PIPELINE_MANIFEST_FILE_MAGIC = 0x4d50454c; // 'LEPM'
+static constexpr uint32_t LE_PIPELINE_MANIFEST_VERSION    = 2;
+
+// ----------------------------------------------------------------------
+
+static std::filesystem::path le_pipeline_manifest_get_file_path() {
+	return le_pipeline_get_executable_directory() / "le_pipeline_manifest.bin";
+}
+
+// ----------------------------------------------------------------------
+
+struct le_pipeline_manifest_writer_t {
+	std::vector<char> data;
+
+	template <typename T>
+	void write( T const& value ) {
+		static_assert( std::is_trivially_copyable_v<T>, "value must be trivially copyable" );
+		data.insert( data.end(), reinterpret_cast<char const*>( &value ), reinterpret_cast<char const*>( &value ) + sizeof( T ) );
+	}
+
+	template <typename T>
+	void write_vector( std::vector<T> const& values ) {
+		static_assert( std::is_trivially_copyable_v<T>, "values must be trivially copyable" );
+		write( uint32_t( values.size() ) );
+		data.insert( data.end(), reinterpret_cast<char const*>( values.data() ), reinterpret_cast<char const*>( values.data() + values.size() ) );
+	}
+
+	void write_string( std::string const& str ) {
+		write( uint32_t( str.size() ) );
+		data.insert( data.end(), str.begin(), str.end() );
+	}
+};
+
+// ----------------------------------------------------------------------
+// All read methods return false if there was not enough data left to read.
+struct le_pipeline_manifest_reader_t {
+	char const* pos;
+	char const* end;
+
+	template <typename T>
+	bool read( T& value ) {
+		static_assert( std::is_trivially_copyable_v<T>, "value must be trivially copyable" );
+		if ( size_t( end - pos ) < sizeof( T ) ) {
+			return false;
+		}
+		memcpy( &value, pos, sizeof( T ) );
+		pos += sizeof( T );
+		return true;
+	}
+
+	template <typename T>
+	bool read_vector( std::vector<T>& values ) {
+		static_assert( std::is_trivially_copyable_v<T>, "values must be trivially copyable" );
+		uint32_t count = 0;
+		if ( !read( count ) || size_t( end - pos ) / sizeof( T ) < count ) {
+			return false;
+		}
+		values.resize( count );
+		memcpy( values.data(), pos, count * sizeof( T ) );
+		pos += count * sizeof( T );
+		return true;
+	}
+
+	bool read_string( std::string& str ) {
+		uint32_t count = 0;
+		if ( !read( count ) || size_t( end - pos ) < count ) {
+			return false;
+		}
+		str.assign( pos, count );
+		pos += count;
+		return true;
+	}
+};
+
+// ----------------------------------------------------------------------
+
+static void le_pipeline_manifest_entry_write( le_pipeline_manifest_writer_t& w, le_pipeline_manifest_entry_t const& e ) {
+	w.write( e.pipeline_hash );
+	w.write( e.pso_data );
+	w.write_vector( e.explicit_vertex_attribute_descriptions );
+	w.write_vector( e.explicit_vertex_input_binding_descriptions );
+
+	w.write( uint32_t( e.shader_modules.size() ) );
+
+	for ( auto const& m : e.shader_modules ) {
+		w.write_string( m.path );
+		w.write_string( m.macro_defines );
+		w.write( m.stage );
+		w.write( m.source_language );
+		w.write_vector( m.specialization_map_entries );
+		w.write_vector( m.specialization_map_data );
+	}
+
+	w.write( e.renderpass_hash );
+	w.write( e.subpass );
+	w.write( e.num_color_attachments );
+	w.write( e.sample_count );
+	w.write( e.num_runs_unused );
+	w.write_vector( e.attachments );
+}
+
+// ----------------------------------------------------------------------
+
+static bool le_pipeline_manifest_entry_read( le_pipeline_manifest_reader_t& r, le_pipeline_manifest_entry_t& e ) {
+	uint32_t num_shader_modules = 0;
+
+	if ( !r.read( e.pipeline_hash ) ||
+	     !r.read( e.pso_data ) ||
+	     !r.read_vector( e.explicit_vertex_attribute_descriptions ) ||
+	     !r.read_vector( e.explicit_vertex_input_binding_descriptions ) ||
+	     !r.read( num_shader_modules ) ) {
+		return false;
+	}
+
+	e.shader_modules.resize( num_shader_modules );
+
+	for ( auto& m : e.shader_modules ) {
+		if ( !r.read_string( m.path ) ||
+		     !r.read_string( m.macro_defines ) ||
+		     !r.read( m.stage ) ||
+		     !r.read( m.source_language ) ||
+		     !r.read_vector( m.specialization_map_entries ) ||
+		     !r.read_vector( m.specialization_map_data ) ) {
+			return false;
+		}
+	}
+
+	return r.read( e.renderpass_hash ) &&
+	       r.read( e.subpass ) &&
+	       r.read( e.num_color_attachments ) &&
+	       r.read( e.sample_count ) &&
+	       r.read( e.num_runs_unused ) &&
+	       r.read_vector( e.attachments );
+}
+
+// ----------------------------------------------------------------------
+// Reads manifest entries from disk - returns false if there was no manifest
+// file, or if the file could not be read.
+static bool le_pipeline_manifest_load_from_disk( std::vector<le_pipeline_manifest_entry_t>& entries ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	auto const file_path = le_pipeline_manifest_get_file_path();
+
+	std::error_code ec;
+	if ( !std::filesystem::exists( file_path, ec ) ) {
+		return false;
+	}
+
+	// ----------| invariant: manifest file exists
+
+	std::vector<char> file_contents;
+
+	if ( !load_file( file_path, file_contents ) ||
+	     file_contents.size() < sizeof( le_pipeline_manifest_file_header_t ) ) {
+		logger.warn( "Could not read pipeline manifest file: '%s'", file_path.string().c_str() );
+		return false;
+	}
+
+	le_pipeline_manifest_file_header_t header;
+	memcpy( &header, file_contents.data(), sizeof( header ) );
+
+	char const* payload = file_contents.data() + sizeof( header );
+
+	if ( header.magic != LE_PIPELINE_MANIFEST_FILE_MAGIC ||
+	     header.version != LE_PIPELINE_MANIFEST_VERSION ||
+	     header.pso_data_size != sizeof( le_graphics_pipeline_builder_data ) ||
+	     header.data_size != file_contents.size() - sizeof( header ) ||
+	     header.data_hash != SpookyHash::Hash64( payload, header.data_size, 0 ) ) {
+		logger.warn( "Ignoring pipeline manifest file '%s': it is outdated, or corrupt.", file_path.string().c_str() );
+		return false;
+	}
+
+	le_pipeline_manifest_reader_t reader{ payload, payload + header.data_size };
+
+	entries.resize( header.num_entries );
+
+	for ( auto& e : entries ) {
+		if ( !le_pipeline_manifest_entry_read( reader, e ) ) {
+			logger.warn( "Ignoring pipeline manifest file '%s': data is corrupt.", file_path.string().c_str() );
+			entries.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Writes manifest to disk if entries were added since the last write.
+static bool le_pipeline_manifest_save_to_disk( le_pipeline_manifest_o* self ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	if ( nullptr == self ) {
+		return false;
+	}
+
+	le_pipeline_manifest_writer_t writer;
+	uint32_t                      num_entries = 0;
+
+	{
+		auto lock = std::unique_lock( self->mtx );
+
+		if ( false == self->is_dirty ) {
+			return false;
+		}
+
+		for ( auto const& e : self->entries ) {
+			le_pipeline_manifest_entry_write( writer, e );
+		}
+
+		num_entries    = uint32_t( self->entries.size() );
+		self->is_dirty = false;
+	}
+
+	// If we can't write the file, the manifest must stay dirty, so that the next save tries again.
+	auto restore_dirty_flag = [ self ]() {
+		auto lock      = std::unique_lock( self->mtx );
+		self->is_dirty = true;
+	};
+
+	le_pipeline_manifest_file_header_t header{
+	    .magic         = LE_PIPELINE_MANIFEST_FILE_MAGIC,
+	    .version       = LE_PIPELINE_MANIFEST_VERSION,
+	    .pso_data_size = sizeof( le_graphics_pipeline_builder_data ),
+	    .num_entries   = num_entries,
+	    .data_size     = writer.data.size(),
+	    .data_hash     = SpookyHash::Hash64( writer.data.data(), writer.data.size(), 0 ),
+	};
+
+	auto const file_path      = le_pipeline_manifest_get_file_path();
+	auto       file_path_temp = file_path;
+	file_path_temp += ".tmp";
+
+	{
+		std::ofstream file( file_path_temp, std::ios::out | std::ios::binary | std::ios::trunc );
+
+		if ( !file.is_open() ) {
+			logger.warn( "Could not open pipeline manifest file for writing: '%s'", file_path_temp.string().c_str() );
+			restore_dirty_flag();
+			return false;
+		}
+
+		file.write( reinterpret_cast<char const*>( &header ), sizeof( header ) );
+		file.write( writer.data.data(), std::streamsize( writer.data.size() ) );
+
+		if ( !file.good() ) {
+			logger.warn( "Could not write pipeline manifest file: '%s'", file_path_temp.string().c_str() );
+			restore_dirty_flag();
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( file_path_temp, file_path, ec );
+
+	if ( ec ) {
+		logger.warn( "Could not move pipeline manifest file into place: '%s' (%s)", file_path.string().c_str(), ec.message().c_str() );
+		restore_dirty_flag();
+		return false;
+	}
+
+	logger.info( "Saved pipeline manifest to '%s' (%d pipelines)", file_path.string().c_str(), num_entries );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Creates all pipelines recorded in the pipeline manifest, so that they don't need
+// to be created when they are first drawn with.
+//
+// Shader modules and psos are set up on the calling thread; vk pipelines are then
+// created in parallel. Call this while loading - before any frames get recorded.
+//
+// Returns the number of pipelines which were created.
+static uint32_t le_pipeline_manager_create_pipelines_from_manifest( le_pipeline_manager_o* self ) {
+	ZoneScoped;
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	std::vector<le_pipeline_manifest_entry_t> entries;
+
+	if ( !le_pipeline_manifest_load_from_disk( entries ) ) {
+		return 0;
+	}
+
+	// ----------| invariant: we have manifest entries
+
+	struct create_params_t {
+		uint64_t                         pipeline_hash;
+		graphics_pipeline_state_o const* pso;
+		BackendRenderPass                pass;
+		uint32_t                         subpass;
+	};
+
+	std::vector<create_params_t>               params;
+	std::unordered_map<uint64_t, VkRenderPass> renderpasses; // temporary compatible renderpasses, indexed by renderpass hash
+
+	{
+		auto lock = std::unique_lock( self->mtx );
+
+		for ( auto const& e : entries ) {
+
+			// Backend renderpasses only have a single subpass - an entry for any other subpass
+			// can't have been recorded by this backend, and would not be valid with our renderpass.
+			if ( e.subpass != 0 ) {
+				logger.warn( "Skipping manifest pipeline: subpass %d is not supported.", e.subpass );
+				continue;
+			}
+
+			// -- Re-create shader modules - this also makes sure that pipelines use current shader code
+
+			graphics_pipeline_state_o pso{};
+			pso.data                                   = e.pso_data;
+			pso.explicitVertexAttributeDescriptions    = e.explicit_vertex_attribute_descriptions;
+			pso.explicitVertexInputBindingDescriptions = e.explicit_vertex_input_binding_descriptions;
+
+			bool all_modules_ok = true;
+
+			for ( auto const& m : e.shader_modules ) {
+				std::error_code ec;
+				if ( !std::filesystem::exists( m.path, ec ) ) {
+					logger.warn( "Skipping manifest pipeline: shader source '%s' not found.", m.path.c_str() );
+					all_modules_ok = false;
+					break;
+				}
+
+				le_shader_module_handle module = le_shader_manager_create_shader_module(
+				    self->shaderManager, m.path.c_str(), { m.source_language }, m.stage, m.macro_defines.c_str(), nullptr,
+				    m.specialization_map_entries.data(), uint32_t( m.specialization_map_entries.size() ),
+				    const_cast<char*>( m.specialization_map_data.data() ), uint32_t( m.specialization_map_data.size() ) );
+
+				if ( nullptr == module ) {
+					all_modules_ok = false;
+					break;
+				}
+
+				pso.shaderModules.push_back( module );
+				pso.shaderStagePerModule.push_back( m.stage );
+			}
+
+			if ( !all_modules_ok ) {
+				continue;
+			}
+
+			// -- Introduce pso, and make sure its pipeline layout exists
+
+			le_gpso_handle gpso_handle = nullptr;
+			le_pipeline_manager_introduce_graphics_pipeline_state( self, &pso, &gpso_handle );
+
+			graphics_pipeline_state_o const* p_pso = self->graphicsPso.try_find( gpso_handle );
+			assert( p_pso );
+
+			le_pipeline_layout_info layout_info{};
+			uint64_t                layout_hash = 0;
+			le_pipeline_manager_produce_pipeline_layout_info( self, p_pso->shaderModules.data(), p_pso->shaderModules.size(), &layout_info, &layout_hash );
+
+			uint64_t pipeline_hash = le_pipeline_manager_calculate_graphics_pipeline_hash( self, p_pso, e.renderpass_hash, layout_hash );
+
+			// If the pipeline hash still matches, the entry is current: shaders and pso have not changed
+			// since it was recorded. Otherwise, a new entry gets recorded once the pipeline is used,
+			// and this entry will eventually be dropped.
+			if ( pipeline_hash == e.pipeline_hash ) {
+				le_pipeline_manifest_mark_used( self->manifest, pipeline_hash );
+			}
+
+			if ( self->pipelines.try_find( pipeline_hash ) ) {
+				// pipeline already exists
+				continue;
+			}
+
+			// -- Find, or create a compatible renderpass
+
+			auto& renderpass = renderpasses[ e.renderpass_hash ];
+
+			if ( nullptr == renderpass ) {
+				renderpass = le_pipeline_create_compatible_renderpass( self->device, e.attachments );
+			}
+
+			create_params_t p{
+			    .pipeline_hash = pipeline_hash,
+			    .pso           = p_pso,
+			    .pass          = {},
+			    .subpass       = e.subpass,
+			};
+
+			p.pass.renderPass          = renderpass;
+			p.pass.renderpassHash      = e.renderpass_hash;
+			p.pass.numColorAttachments = uint16_t( e.num_color_attachments );
+			p.pass.sampleCount         = le::SampleCountFlagBits( e.sample_count );
+
+			params.emplace_back( std::move( p ) );
+		}
+	}
+
+	// -- Create vk pipelines in parallel
+
+	std::atomic<size_t> next_param  = 0;
+	std::atomic<size_t> num_created = 0;
+
+	auto create_pipelines = [ self, &params, &next_param, &num_created ]() {
+		// Shader modules must not get updated while we create pipelines which use them
+		auto modules_lock = std::shared_lock( self->shaderManager->modules_mtx );
+
+		for ( size_t i = next_param++; i < params.size(); i = next_param++ ) {
+			auto const& p = params[ i ];
+
+			VkPipeline pipeline = le_pipeline_cache_create_graphics_pipeline( self, p.pso, p.pass, p.subpass );
+
+			if ( self->pipelines.try_insert( p.pipeline_hash, &pipeline ) ) {
+				num_created++;
+			} else {
+				vkDestroyPipeline( self->device, pipeline, nullptr );
+			}
+		}
+	};
+
+	size_t num_threads = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), params.size() );
+
+	std::vector<std::thread> threads;
+
+	for ( size_t i = 1; i < num_threads; i++ ) {
+		threads.emplace_back( create_pipelines );
+	}
+
+	create_pipelines(); // calling thread helps out
+
+	for ( auto& t : threads ) {
+		t.join();
+	}
+
+	for ( auto& [ hash, renderpass ] : renderpasses ) {
+		vkDestroyRenderPass( self->device, renderpass, nullptr );
+	}
+
+	if ( num_created > 0 ) {
+		self->vulkanCacheIsDirty = true;
+	}
+
+	logger.info( "Created %zu pipelines from pipeline manifest (%zu entries)", size_t( num_created ), entries.size() );
+
+	return uint32_t( num_created );
+}
+
+// ----------------------------------------------------------------------
+// Gets called once per frame, via the renderer, before any frame gets recorded.
+static void le_pipeline_manager_update_shader_modules( le_pipeline_manager_o* self ) {
+	le_shader_manager_update_shader_modules( self->shaderManager );
+
+	// Periodically persist the vulkan pipeline cache, so that we don't lose newly
+	// created pipelines if the application does not shut down cleanly.
+	// A value of 0 disables periodic saving; the cache is then only saved on shutdown.
+	LE_SETTING( uint32_t, LE_SETTING_PIPELINE_CACHE_SAVE_INTERVAL_FRAMES, 600 );
+
+	if ( *LE_SETTING_PIPELINE_CACHE_SAVE_INTERVAL_FRAMES > 0 &&
+	     ++self->updateCount % *LE_SETTING_PIPELINE_CACHE_SAVE_INTERVAL_FRAMES == 0 ) {
+		le_pipeline_cache_save_to_disk( self );
+		le_pipeline_manifest_save_to_disk( self->manifest );
+	}
+}
+
+// ----------------------------------------------------------------------
+
+static le_pipeline_manager_o* le_pipeline_manager_create( le_device_o* le_device ) {
+	auto self = new le_pipeline_manager_o();
+
+	using namespace le_backend_vk;
+	self->le_device = le_device;
+	vk_device_i.increase_reference_count( le_device );
+	self->device = vk_device_i.get_vk_device( le_device );
+
+	// Try to initialise pipeline cache with data from a previous run.
+	std::vector<char> initial_data;
+	le_pipeline_cache_load_from_disk( self, initial_data );
+
+	VkPipelineCacheCreateInfo info = {
+	    .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+	    .pNext           = nullptr,             // optional
+	    .flags           = 0,                   // optional
+	    .initialDataSize = initial_data.size(), // optional
+	    .pInitialData    = initial_data.empty() ? nullptr : initial_data.data(),
 	};
 
-	vkCreatePipelineCache( self->device, &info, nullptr, &self->vulkanCache );
+	auto result = vkCreatePipelineCache( self->device, &info, nullptr, &self->vulkanCache );
+
+	if ( result != VK_SUCCESS && !initial_data.empty() ) {
+		// The driver rejected our cached data - fall back to an empty pipeline cache.
+		static auto logger = LeLog( LOGGER_LABEL );
+		logger.warn( "Could not create pipeline cache from cached data, starting with empty pipeline cache." );
+		info.initialDataSize = 0;
+		info.pInitialData    = nullptr;
+		vkCreatePipelineCache( self->device, &info, nullptr, &self->vulkanCache );
+	}
 	self->shaderManager = le_shader_manager_create( self->device );
 
+	// Settings are readonly by the time the pipeline manager gets created
+	self->extended_dynamic_state_level = settings_i.get_extended_dynamic_state_level();
+
+	self->use_graphics_pipeline_libraries = settings_i.get_graphics_pipeline_library_enabled() &&
+	                                        vk_device_i.is_extension_available( le_device, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME );
+
+	if ( uint32_t num_threads = settings_i.get_async_pipeline_compilation_threads() ) {
+		le_pipeline_async_compiler_create( self, num_threads );
+	}
+
+	// If enabled, record all graphics pipelines that get created into a manifest, so that
+	// they may be re-created up-front in a future run via `create_pipelines_from_manifest`.
+	// We start with the previous manifest, so that pipelines from earlier runs are kept -
+	// but we drop entries which have not been used for LE_SETTING_PIPELINE_MANIFEST_MAX_UNUSED_RUNS runs.
+	LE_SETTING( bool, LE_SETTING_RECORD_PIPELINE_MANIFEST, false );
+	LE_SETTING( uint32_t, LE_SETTING_PIPELINE_MANIFEST_MAX_UNUSED_RUNS, 8 );
+
+	if ( *LE_SETTING_RECORD_PIPELINE_MANIFEST ) {
+		self->manifest = new le_pipeline_manifest_o();
+
+		std::vector<le_pipeline_manifest_entry_t> entries;
+		le_pipeline_manifest_load_from_disk( entries );
+
+		for ( auto& e : entries ) {
+			if ( ++e.num_runs_unused > *LE_SETTING_PIPELINE_MANIFEST_MAX_UNUSED_RUNS ||
+			     self->manifest->entry_indices.count( e.pipeline_hash ) ) {
+				continue;
+			}
+			self->manifest->entry_indices[ e.pipeline_hash ] = self->manifest->entries.size();
+			self->manifest->entries.emplace_back( std::move( e ) );
+		}
+
+		// Entries have aged by one run, and stale entries were dropped.
+		self->manifest->is_dirty = !entries.empty();
+	}
+
 	return self;
 }
 
@@ -2501,6 +4421,18 @@ static void le_pipeline_manager_destroy( le_pipeline_manager_o* self ) {
 
 	static auto logger = LeLog( LOGGER_LABEL );
 
+	if ( self->asyncCompiler ) {
+		// Must happen before we destroy shader modules, as these may be in use by compiler threads.
+		le_pipeline_async_compiler_destroy( self->asyncCompiler );
+		self->asyncCompiler = nullptr;
+	}
+
+	if ( self->manifest ) {
+		le_pipeline_manifest_save_to_disk( self->manifest );
+		delete self->manifest;
+		self->manifest = nullptr;
+	}
+
 	le_shader_manager_destroy( self->shaderManager );
 	self->shaderManager = nullptr;
 
@@ -2544,15 +4476,25 @@ static void le_pipeline_manager_destroy( le_pipeline_manager_o* self ) {
 
 	self->pipelines.clear();
 
+	self->pipelineLibraries.iterator(
+	    []( VkPipeline* p, void* user_data ) {
+		    auto device = *static_cast<VkDevice*>( user_data );
+		    vkDestroyPipeline( device, *p, nullptr );
+	    },
+	    &self->device );
+
+	self->pipelineLibraries.clear();
+
 	self->rtx_shader_group_data.iterator(
 	    []( char** p_buffer, void* ) {
 		    free( *p_buffer );
 	    },
 	    nullptr );
 
-	// Destroy Pipeline Cache
+	// Destroy Pipeline Cache - but persist its contents first
 
 	if ( self->vulkanCache ) {
+		le_pipeline_cache_save_to_disk( self );
 		vkDestroyPipelineCache( self->device, self->vulkanCache, nullptr );
 	}
 
@@ -2583,6 +4525,10 @@ void register_le_pipeline_vk_api( void* api_ ) {
 		i.produce_graphics_pipeline         = le_pipeline_manager_produce_graphics_pipeline;
 		i.produce_rtx_pipeline              = le_pipeline_manager_produce_rtx_pipeline;
 		i.produce_compute_pipeline          = le_pipeline_manager_produce_compute_pipeline;
+		i.get_async_compilation_stats       = le_pipeline_manager_get_async_compilation_stats;
+		i.add_skipped_draws                 = le_pipeline_manager_add_skipped_draws;
+		i.create_pipelines_from_manifest    = le_pipeline_manager_create_pipelines_from_manifest;
+		i.get_graphics_pipeline_state_data  = le_pipeline_manager_get_graphics_pipeline_state_data;
 	}
 	{
 		auto& i = le_backend_vk_api_i->le_shader_module_i;
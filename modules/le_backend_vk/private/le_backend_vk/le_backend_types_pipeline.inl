@@ -15,6 +15,10 @@ struct le_graphics_pipeline_builder_data {
 struct graphics_pipeline_state_o {
 	le_graphics_pipeline_builder_data data{};
 
+	uint64_t vk_pipeline_hash = 0; // hash over state which gets baked into vk pipeline; excludes any state which is dynamic. Set when pso is introduced to pipeline manager.
+
+	le_gpso_handle fallback_pso = nullptr; // optional; used in place of this pso while its vk pipeline is being created asynchronously
+
 	std::vector<le_shader_module_handle> shaderModules;        // non-owning; refers opaquely to shader modules (or not)
 	std::vector<le::ShaderStage>         shaderStagePerModule; // refers to shader module handle of same index
 
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring> // for memcpy, memcmp
+#include <type_traits>
+
+#include "le_core.h" // for NoCopy, NoMove
+
+/*
+ * Insert-only concurrent hash map from `key` -> `object*`.
+ *
+ * This is what the pipeline manager uses to store pipelines, pipeline layouts,
+ * descriptor set layouts, psos, and shader modules. These stores are looked up
+ * many times per draw call, but only ever grow - and they only grow rarely, once
+ * the application has warmed up.
+ *
+ * Lookups are therefore wait-free: `try_find` never takes a lock, and never
+ * writes to shared memory, so that readers on different cores don't contend.
+ * Inserts are serialised via a mutex.
+ *
+ * Entries live in an open-addressing table with linear probing. A slot is
+ * published by atomically storing its object pointer *after* its key was
+ * written. Readers acquire-load the object pointer before they look at the key.
+ * Because entries are never removed (except through `clear`), a slot which holds
+ * a nullptr object terminates a probe sequence.
+ *
+ * When the table fills up past its maximum load factor, the writer builds a
+ * table twice the size, and publishes it atomically. Readers which still probe
+ * the previous table will find all entries which were published before the swap
+ * - so a previous table must stay alive as long as readers may access it. We
+ * keep previous tables until `clear` gets called. As tables double in size, this
+ * costs at most as much memory as the current table.
+ *
+ * Objects are owned by the map, and are copied on successful insert. Pointers
+ * to objects returned by `try_find` stay valid until `clear` gets called.
+ *
+ * Note: `clear` and `iterator` must not be called while other threads may
+ * access the map.
+ *
+ */
+template <typename S, typename T>
+class HashMap : NoCopy, NoMove {
+
+	static_assert( sizeof( S ) <= sizeof( uint64_t ) && std::is_trivially_copyable_v<S>,
+	               "key must be an integral type or a handle" );
+
+	struct slot_t {
+		S               key;
+		std::atomic<T*> obj; // nullptr means slot is empty
+	};
+
+	struct table_t {
+		size_t  mask;  // number of slots - 1, number of slots is always a power of two
+		slot_t* slots; // owning
+	};
+
+	static constexpr size_t INITIAL_CAPACITY = 64; // must be a power of two
+
+	std::atomic<table_t*> table = nullptr;
+	std::mutex            mtx;            // protects everything below, must be held for writing
+	size_t                num_entries = 0;
+	std::vector<table_t*> tables;         // owning: current table, plus any previous tables which readers may still access
+
+	static uint64_t hash_key( S const& key ) {
+		uint64_t h = 0;
+		memcpy( &h, &key, sizeof( S ) );
+		// splitmix64 finalizer - keys may be pointers, or sequential, and we must
+		// spread them evenly over the table, since we use the lower bits as index.
+		h ^= h >> 30;
+		h *= 0xbf58476d1ce4e5b9ull;
+		h ^= h >> 27;
+		h *= 0x94d049bb133111ebull;
+		h ^= h >> 31;
+		return h;
+	}
+
+	static table_t* table_create( size_t capacity ) {
+		auto t   = new table_t();
+		t->mask  = capacity - 1;
+		t->slots = new slot_t[ capacity ]{};
+		return t;
+	}
+
+	static void table_destroy( table_t* t ) {
+		delete[] t->slots;
+		delete t;
+	}
+
+	// Must only be called by writer, with mtx held.
+	// Does not check whether an entry with key already exists.
+	static void table_insert( table_t* t, S const& key, T* obj ) {
+		for ( size_t i = hash_key( key ) & t->mask;; i = ( i + 1 ) & t->mask ) {
+			slot_t& s = t->slots[ i ];
+			if ( nullptr == s.obj.load( std::memory_order_relaxed ) ) {
+				s.key = key;
+				s.obj.store( obj, std::memory_order_release ); // publish: key must be visible before obj
+				return;
+			}
+		}
+	}
+
+	static T* table_find( table_t const* t, S const& needle ) {
+		for ( size_t i = hash_key( needle ) & t->mask;; i = ( i + 1 ) & t->mask ) {
+			slot_t const& s   = t->slots[ i ];
+			T*            obj = s.obj.load( std::memory_order_acquire );
+			if ( nullptr == obj ) {
+				return nullptr; // empty slot terminates probe sequence
+			}
+			if ( 0 == memcmp( &s.key, &needle, sizeof( S ) ) ) {
+				return obj;
+			}
+		}
+	}
+
+  public:
+	// Looks up entry under `needle`, returns nullptr if not found.
+	// Wait-free, may be called concurrently with `try_insert`.
+	T* try_find( S const& needle ) const {
+		table_t const* t = table.load( std::memory_order_acquire );
+		if ( nullptr == t ) {
+			return nullptr;
+		}
+		return table_find( t, needle );
+	}
+
+	// Returns true and stores copy of obj in map - or
+	// returns false if element with key already existed,
+	// in which case obj was not copied.
+	bool try_insert( S const& key, T* obj ) {
+
+		auto lock = std::unique_lock( mtx );
+
+		table_t* t = table.load( std::memory_order_relaxed );
+
+		if ( nullptr == t ) {
+			t = table_create( INITIAL_CAPACITY );
+			tables.push_back( t );
+			table.store( t, std::memory_order_release );
+		} else if ( table_find( t, key ) ) {
+			return false;
+		}
+
+		// ----------| invariant: no entry for key exists in the current table
+
+		if ( ( num_entries + 1 ) * 2 > t->mask + 1 ) {
+			// Maximum load factor of 0.5 would be exceeded - grow table. We fill the
+			// new table before we publish it, so that readers always see a complete table.
+			table_t* t_new = table_create( ( t->mask + 1 ) * 2 );
+			for ( size_t i = 0; i <= t->mask; i++ ) {
+				slot_t const& s = t->slots[ i ];
+				if ( T* o = s.obj.load( std::memory_order_relaxed ) ) {
+					table_insert( t_new, s.key, o );
+				}
+			}
+			tables.push_back( t_new );
+			table.store( t_new, std::memory_order_release );
+			t = t_new;
+		}
+
+		table_insert( t, key, new T( *obj ) ); // make a copy
+		num_entries++;
+
+		return true;
+	}
+
+	typedef void ( *iterator_fun )( T* e, void* user_data );
+
+	// do something on all objects
+	void iterator( iterator_fun fun, void* user_data ) {
+		auto     lock = std::unique_lock( mtx );
+		table_t* t    = table.load( std::memory_order_relaxed );
+		if ( nullptr == t ) {
+			return;
+		}
+		for ( size_t i = 0; i <= t->mask; i++ ) {
+			if ( T* o = t->slots[ i ].obj.load( std::memory_order_relaxed ) ) {
+				fun( o, user_data );
+			}
+		}
+	}
+
+	size_t size() {
+		auto lock = std::unique_lock( mtx );
+		return num_entries;
+	}
+
+	void clear() {
+		auto     lock = std::unique_lock( mtx );
+		table_t* t    = table.load( std::memory_order_relaxed );
+		if ( t ) {
+			for ( size_t i = 0; i <= t->mask; i++ ) {
+				delete t->slots[ i ].obj.load( std::memory_order_relaxed );
+			}
+		}
+		table.store( nullptr, std::memory_order_release );
+		for ( auto& previous_table : tables ) {
+			table_destroy( previous_table );
+		}
+		tables.clear();
+		num_entries = 0;
+	}
+
+	~HashMap() {
+		clear();
+	}
+};
+
+// A table from `handle` -> `object*` - same implementation as HashMap.
+template <typename T, typename U>
+using HashTable = HashMap<T, U>;
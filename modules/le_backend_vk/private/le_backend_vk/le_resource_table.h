@@ -0,0 +1,161 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "private/le_renderer/le_resource_handle_t.inl"
+
+/*
+ * Flat table from resource handle -> `T`, used for per-frame resource state in the backend.
+ *
+ * Every resource handle carries a dense, stable `slot` id, which the renderer assigns
+ * when it first creates the handle. We use this slot to index into `positions`, which
+ * holds, per slot, the position of the handle's entry in `items` - so that lookups cost
+ * two array accesses instead of hashing the handle.
+ *
+ * Entries are stored contiguously in insertion order, so that iterating over all entries
+ * is cheap, too. Iterators and references are invalidated by insertion and erasure.
+ *
+ * `clear` keeps the capacity of both arrays, so that a table which is cleared and refilled
+ * every frame does not allocate once it has warmed up.
+ *
+ * The interface mirrors the subset of std::unordered_map which the backend uses.
+ *
+ */
+template <typename K, typename T>
+class ResourceTable {
+
+	std::vector<std::pair<K, T>> items;     // dense storage, in insertion order
+	std::vector<uint32_t>        positions; // per handle slot: 1 + index into items, 0 if handle has no entry
+
+	static uint32_t slot_of( K const& key ) {
+		return key->data->slot;
+	}
+
+	uint32_t position_of( K const& key ) const {
+		uint32_t slot = slot_of( key );
+		return slot < positions.size() ? positions[ slot ] : 0;
+	}
+
+  public:
+	using iterator       = typename std::vector<std::pair<K, T>>::iterator;
+	using const_iterator = typename std::vector<std::pair<K, T>>::const_iterator;
+
+	iterator begin() {
+		return items.begin();
+	}
+	iterator end() {
+		return items.end();
+	}
+	const_iterator begin() const {
+		return items.begin();
+	}
+	const_iterator end() const {
+		return items.end();
+	}
+
+	size_t size() const {
+		return items.size();
+	}
+
+	bool empty() const {
+		return items.empty();
+	}
+
+	iterator find( K const& key ) {
+		uint32_t p = position_of( key );
+		return p ? items.begin() + ( p - 1 ) : items.end();
+	}
+
+	const_iterator find( K const& key ) const {
+		uint32_t p = position_of( key );
+		return p ? items.begin() + ( p - 1 ) : items.end();
+	}
+
+	size_t count( K const& key ) const {
+		return position_of( key ) ? 1 : 0;
+	}
+
+	T& at( K const& key ) {
+		uint32_t p = position_of( key );
+		assert( p && "resource not found in table" );
+		return items[ p - 1 ].second;
+	}
+
+	T const& at( K const& key ) const {
+		uint32_t p = position_of( key );
+		assert( p && "resource not found in table" );
+		return items[ p - 1 ].second;
+	}
+
+	// Inserts value under key if there is no entry for key yet.
+	// Returns iterator to entry for key, and whether value was inserted.
+	std::pair<iterator, bool> try_emplace( K const& key, T const& value = T() ) {
+		uint32_t slot = slot_of( key );
+		if ( slot >= positions.size() ) {
+			positions.resize( slot + 1, 0 );
+		}
+		if ( positions[ slot ] ) {
+			return { items.begin() + ( positions[ slot ] - 1 ), false };
+		}
+		items.emplace_back( key, value );
+		positions[ slot ] = uint32_t( items.size() );
+		return { items.end() - 1, true };
+	}
+
+	std::pair<iterator, bool> emplace( K const& key, T const& value ) {
+		return try_emplace( key, value );
+	}
+
+	std::pair<iterator, bool> insert( std::pair<K, T> const& entry ) {
+		return try_emplace( entry.first, entry.second );
+	}
+
+	std::pair<iterator, bool> insert_or_assign( K const& key, T const& value ) {
+		auto result = try_emplace( key, value );
+		if ( !result.second ) {
+			result.first->second = value;
+		}
+		return result;
+	}
+
+	T& operator[]( K const& key ) {
+		return try_emplace( key ).first->second;
+	}
+
+	// Removes entry for key by moving the last entry into its place.
+	size_t erase( K const& key ) {
+		uint32_t slot = slot_of( key ); // we must read slot first: key may refer to the entry which we overwrite
+		uint32_t p    = position_of( key );
+		if ( p == 0 ) {
+			return 0;
+		}
+		if ( p != items.size() ) {
+			items[ p - 1 ]                               = std::move( items.back() );
+			positions[ slot_of( items[ p - 1 ].first ) ] = p;
+		}
+		items.pop_back();
+		positions[ slot ] = 0;
+		return 1;
+	}
+
+	// Removes entry at pos by moving the last entry into its place. Returns an iterator to
+	// pos, which now holds what was the last entry - so that a loop which erases while it
+	// iterates does not skip that entry - or end() if pos was the last entry.
+	iterator erase( iterator pos ) {
+		size_t index = size_t( pos - items.begin() );
+		erase( K( pos->first ) ); // copy key, as its entry gets overwritten
+		return items.begin() + index;
+	}
+
+	// Removes all entries, but keeps capacity.
+	void clear() {
+		for ( auto const& item : items ) {
+			positions[ slot_of( item.first ) ] = 0;
+		}
+		items.clear();
+	}
+};
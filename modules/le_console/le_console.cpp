@@ -29,6 +29,7 @@
 #include "private/le_console/le_char_tree.h"
 
 #include "private/le_core/le_settings_private_types.inl"
+#include "private/le_core/le_setting_snapshot.h"
 
 // Translation between winsock and posix sockets
 #ifdef _WIN32
@@ -1102,12 +1103,18 @@ static void cb_get_setting_command( Command const* cmd, std::string const& str,
 			case ( SettingType::eUint32_t ):
 				msg << found_setting->name << " [ uint32_t ] == '" << ( *( uint32_t* )found_setting->p_opj ) << "'\n\r";
 				break;
+			case ( SettingType::eUint64_t ):
+				msg << found_setting->name << " [ uint64_t ] == '" << ( *( uint64_t* )found_setting->p_opj ) << "'\n\r";
+				break;
 			case ( SettingType::eInt ):
 				msg << found_setting->name << " [ int ] == '" << ( *( int* )found_setting->p_opj ) << "'\n\r";
 				break;
 			case ( SettingType::eStdString ):
 				msg << found_setting->name << " [ std::string ] == '" << ( *( std::string* )found_setting->p_opj ) << "'\n\r";
 				break;
+			case ( SettingType::eSnapshot ):
+				msg << found_setting->name << " [ snapshot ] == '" << ( ( le_setting_snapshot_t const* )found_setting->p_opj )->get() << "'\n\r";
+				break;
 			default:
 				msg << found_setting->name << " [ unknown ] == '" << std::hex << found_setting->p_opj << "'\n\r";
 				break;
@@ -1142,6 +1149,9 @@ static void cb_set_setting_command( Command const* cmd, std::string const& str,
 			case SettingType::eUint32_t:
 				*( uint32_t* )( setting ) = uint32_t( strtoul( setting_value, nullptr, 10 ) );
 				break;
+			case SettingType::eUint64_t:
+				*( uint64_t* )( setting ) = uint64_t( strtoull( setting_value, nullptr, 10 ) );
+				break;
 			case SettingType::eInt32_t:
 				*( int32_t* )( setting ) = int32_t( strtoul( setting_value, nullptr, 10 ) );
 				break;
@@ -1151,6 +1161,9 @@ static void cb_set_setting_command( Command const* cmd, std::string const& str,
 			case SettingType::eStdString:
 				*( std::string* )( setting ) = std::string( setting_value );
 				break;
+			case SettingType::eSnapshot:
+				logger.warn( "Cannot set value for setting: '%s'. Snapshot settings are read-only.", found_setting->name.c_str() );
+				break;
 			default:
 				break;
 			}
@@ -1185,12 +1198,18 @@ static void cb_list_settings_command( Command const* cmd, std::string const& str
 		case ( SettingType::eUint32_t ):
 			msg << s.second.name << " [ uint32_t ] = '" << ( *( uint32_t* )s.second.p_opj ) << "'\n\r";
 			break;
+		case ( SettingType::eUint64_t ):
+			msg << s.second.name << " [ uint64_t ] = '" << ( *( uint64_t* )s.second.p_opj ) << "'\n\r";
+			break;
 		case ( SettingType::eInt ):
 			msg << s.second.name << " [ int ] = '" << ( *( int* )s.second.p_opj ) << "'\n\r";
 			break;
 		case ( SettingType::eStdString ):
 			msg << s.second.name << " [ std::string ] = '" << ( *( std::string* )s.second.p_opj ) << "'\n\r";
 			break;
+		case ( SettingType::eSnapshot ):
+			msg << s.second.name << " [ snapshot ] = '" << ( ( le_setting_snapshot_t const* )s.second.p_opj )->get() << "'\n\r";
+			break;
 		default:
 			msg << s.second.name << " [ unknown ] = '" << std::hex << s.second.p_opj << "'\n\r";
 			break;
@@ -81,6 +81,16 @@ inline uint32_t hash_32_fnv1a( char const* const input ) noexcept {
 #define LE_SHADER_MODULE_HANDLE( x ) \
 	reinterpret_cast<struct le_shader_module_handle_t*>( hash_64_fnv1a_const( x ) )
 
+// ----------------------------------------------------------------------
+// Advances xorshift64 generator `state`, and returns its new value - cheap
+// pseudo-random numbers, for test data and benchmarks. `state` must not be 0.
+inline uint64_t xorshift_64( uint64_t& state ) noexcept {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
 // ----------------------------------------------------------------------
 // Returns value of key itself as hash value; useful if you
 // want to enforce key and hash value to be identical.
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+// A string setting which one thread may publish while others read it -
+// use this with LE_SETTING for stats which are updated on a render or
+// worker thread, so that the console can show them without a data race:
+//
+//     LE_SETTING( le_setting_snapshot_t, LE_SETTING_MY_STATS, "" );
+//     LE_SETTING_MY_STATS->publish( msg.str() );
+//
+// Snapshots are read-only from the console.
+struct le_setting_snapshot_t {
+
+	explicit le_setting_snapshot_t( char const* initial_value )
+	    : value( initial_value ) {
+	}
+
+	void publish( std::string&& new_value ) {
+		auto lock = std::scoped_lock( mtx );
+		value.swap( new_value );
+	}
+
+	std::string get() const {
+		auto lock = std::scoped_lock( mtx );
+		return value;
+	}
+
+  private:
+	mutable std::mutex mtx;
+	std::string        value;
+};
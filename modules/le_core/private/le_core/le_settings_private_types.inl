@@ -3,10 +3,12 @@
 enum SettingType : uint64_t {
 	eInt       = hash_64_fnv1a_const( "int" ),
 	eUint32_t  = hash_64_fnv1a_const( "uint32_t" ),
+	eUint64_t  = hash_64_fnv1a_const( "uint64_t" ),
 	eInt32_t   = hash_64_fnv1a_const( "int32_t" ),
 	eStdString = hash_64_fnv1a_const( "std::string" ),
 	eBool      = hash_64_fnv1a_const( "bool" ),
 	eConstBool = hash_64_fnv1a_const( "const bool" ),
+	eSnapshot  = hash_64_fnv1a_const( "le_setting_snapshot_t" ), // see le_setting_snapshot.h
 };
 struct LeSettingEntry {
 	std::string name;
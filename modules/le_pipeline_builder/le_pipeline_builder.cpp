@@ -489,6 +489,12 @@ static void le_graphics_pipeline_builder_set_multisample_info( le_graphics_pipel
 static void le_graphics_pipeline_builder_set_depth_stencil_info( le_graphics_pipeline_builder_o* self, const VkPipelineDepthStencilStateCreateInfo& depthStencilInfo ) {
 	self->obj->data.depthStencilState = depthStencilInfo;
 }
+
+// Fallback pipeline gets used instead of this pipeline while this pipeline is being
+// created in the background - only has an effect if async pipeline compilation is enabled.
+static void le_graphics_pipeline_builder_set_fallback_pipeline( le_graphics_pipeline_builder_o* self, le_gpso_handle fallback_pipeline ) {
+	self->obj->fallback_pso = fallback_pipeline;
+}
 // ----------------------------------------------------------------------
 
 static void le_graphics_pipeline_builder_destroy( le_graphics_pipeline_builder_o* self ) {
@@ -792,6 +798,7 @@ LE_MODULE_REGISTER_IMPL( le_pipeline_builder, api ) {
 		i.set_vertex_input_binding_descriptions   = le_graphics_pipeline_builder_set_vertex_input_binding_descriptions;
 		i.set_multisample_info                    = le_graphics_pipeline_builder_set_multisample_info;
 		i.set_depth_stencil_info                  = le_graphics_pipeline_builder_set_depth_stencil_info;
+		i.set_fallback_pipeline                   = le_graphics_pipeline_builder_set_fallback_pipeline;
 
 		i.attribute_binding_state_i.add_binding                 = le_graphics_pipeline_builder_add_binding;
 		i.attribute_binding_state_i.set_binding_input_rate      = le_graphics_pipeline_builder_set_binding_input_rate;
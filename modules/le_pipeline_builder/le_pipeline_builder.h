@@ -59,6 +59,10 @@ struct le_pipeline_builder_api {
 		void     ( * set_multisample_info                    ) ( le_graphics_pipeline_builder_o *self, const VkPipelineMultisampleStateCreateInfo &multisampleInfo );
 		void     ( * set_depth_stencil_info                  ) ( le_graphics_pipeline_builder_o *self, const VkPipelineDepthStencilStateCreateInfo &depthStencilInfo );
 
+		// Only has an effect if async pipeline compilation is enabled: fallback pipeline is used in place of this pipeline until this pipeline is ready.
+		// Fallback must use the same descriptor bindings and push constants as this pipeline - otherwise draws are skipped until this pipeline is ready.
+		void     ( * set_fallback_pipeline                   ) ( le_graphics_pipeline_builder_o *self, le_gpso_handle fallback_pipeline );
+
 		le_gpso_handle_t* ( * build             ) ( le_graphics_pipeline_builder_o* self );
 
 		struct attribute_binding_state_t{
@@ -912,6 +916,11 @@ class LeGraphicsPipelineBuilder : NoCopy, NoMove {
 		return *this;
 	}
 
+	LeGraphicsPipelineBuilder& setFallbackPipeline( le_gpso_handle fallbackPipeline ) {
+		le_pipeline_builder::le_graphics_pipeline_builder_i.set_fallback_pipeline( self, fallbackPipeline );
+		return *this;
+	}
+
 	AttributeBindingState& withAttributeBindingState() {
 		return mAttributeBindingState;
 	}
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <vector>
 #include <algorithm>
+#include <numeric> // for std::lcm
 
 #ifdef _WIN32
 #	define __PRETTY_FUNCTION__ __FUNCSIG__
@@ -132,6 +133,58 @@ static void cbe_set_line_width( le_command_buffer_encoder_o* self, float lineWid
 	cmd->info.width = lineWidth;
 }
 
+// ----------------------------------------------------------------------
+// Note: the following state setters require the backend to have been set up with
+// extended dynamic state (see le_backend_vk settings: set_extended_dynamic_state_level).
+// Any state set here is reset to pipeline defaults when a graphics pipeline is bound.
+
+static void cbe_set_cull_mode( le_command_buffer_encoder_o* self, le::CullModeFlags const& cull_mode ) {
+	auto cmd            = self->mCommandStream->emplace_cmd<le::CommandSetCullMode>(); // placement new into data array
+	cmd->info.cull_mode = cull_mode;
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_front_face( le_command_buffer_encoder_o* self, le::FrontFace const& front_face ) {
+	auto cmd             = self->mCommandStream->emplace_cmd<le::CommandSetFrontFace>(); // placement new into data array
+	cmd->info.front_face = front_face;
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_primitive_topology( le_command_buffer_encoder_o* self, le::PrimitiveTopology const& topology ) {
+	auto cmd           = self->mCommandStream->emplace_cmd<le::CommandSetPrimitiveTopology>(); // placement new into data array
+	cmd->info.topology = topology;
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_depth_state( le_command_buffer_encoder_o* self, bool depth_test_enable, bool depth_write_enable, le::CompareOp const& depth_compare_op ) {
+	auto cmd  = self->mCommandStream->emplace_cmd<le::CommandSetDepthState>(); // placement new into data array
+	cmd->info = { depth_test_enable, depth_write_enable, depth_compare_op, 0 };
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_polygon_mode( le_command_buffer_encoder_o* self, le::PolygonMode const& polygon_mode ) {
+	auto cmd               = self->mCommandStream->emplace_cmd<le::CommandSetPolygonMode>(); // placement new into data array
+	cmd->info.polygon_mode = polygon_mode;
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_color_blend_enable( le_command_buffer_encoder_o* self, uint32_t attachment, bool blend_enable ) {
+	auto cmd  = self->mCommandStream->emplace_cmd<le::CommandSetColorBlendEnable>(); // placement new into data array
+	cmd->info = { attachment, blend_enable };
+}
+
+// ----------------------------------------------------------------------
+
+static void cbe_set_color_write_mask( le_command_buffer_encoder_o* self, uint32_t attachment, le::ColorComponentFlags const& write_mask ) {
+	auto cmd  = self->mCommandStream->emplace_cmd<le::CommandSetColorWriteMask>(); // placement new into data array
+	cmd->info = { attachment, write_mask };
+}
+
 // ----------------------------------------------------------------------
 
 static void cbe_dispatch( le_command_buffer_encoder_o* self, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ ) {
@@ -700,6 +753,7 @@ static void cbe_write_to_buffer( le_command_buffer_encoder_o* self, le_buf_resou
 	using namespace le_backend_vk; // for le_allocator_linear_i
 	void*                  memAddr;
 	le_buf_resource_handle srcResourceId;
+	uint64_t               srcOffset;
 
 	// -- Allocate memory using staging allocator
 	//
@@ -708,12 +762,12 @@ static void cbe_write_to_buffer( le_command_buffer_encoder_o* self, le_buf_resou
 	// allocated so that it is only used for TRANSFER_SRC, and shared amongst encoders so that we
 	// use available memory more efficiently.
 	//
-	if ( le_staging_allocator_i.map( self->stagingAllocator, numBytes, &memAddr, &srcResourceId ) ) {
+	if ( le_staging_allocator_i.map( self->stagingAllocator, numBytes, 4, &memAddr, &srcResourceId, &srcOffset ) ) {
 		// -- Write data to scratch memory now
 		memcpy( memAddr, data, numBytes );
 
 		cmd->info.src_buffer_id = srcResourceId;
-		cmd->info.src_offset    = 0; // staging allocator will give us a fresh buffer, and src memory will be placed at its start
+		cmd->info.src_offset    = srcOffset; // staging allocator sub-allocates from a shared staging buffer
 		cmd->info.dst_offset    = dst_offset;
 		cmd->info.numBytes      = numBytes;
 		cmd->info.dst_buffer_id = dst_buffer;
@@ -739,6 +793,7 @@ static void cbe_write_to_image( le_command_buffer_encoder_o*        self,
 	using namespace le_backend_vk; // for le_allocator_linear_i
 	void*                  memAddr;
 	le_buf_resource_handle stagingBufferId;
+	uint64_t               stagingOffset;
 
 	// -- Allocate memory using staging allocator
 	//
@@ -747,14 +802,25 @@ static void cbe_write_to_image( le_command_buffer_encoder_o*        self,
 	// allocated so that it is only used for TRANSFER_SRC, and shared amongst encoders so that we
 	// use available memory more efficiently.
 	//
-	if ( le_staging_allocator_i.map( self->stagingAllocator, numBytes, &memAddr, &stagingBufferId ) ) {
+	// vkCmdCopyBufferToImage requires the staging offset to be a multiple of the texel block size
+	// of the image format, and of 4. We don't know the image format here, but data for image writes
+	// is tightly packed - if it divides evenly into texels, we can infer the texel size from it.
+	// Otherwise the format must be block-compressed, with blocks of up to 16 Bytes, which the staging
+	// allocator's minimum alignment covers.
+	//
+	uint64_t const num_texels = uint64_t( writeInfo.image_w ) * writeInfo.image_h * writeInfo.image_d;
+	uint64_t const texel_size = ( num_texels && numBytes % num_texels == 0 ) ? numBytes / num_texels : 1;
+	uint64_t const alignment  = std::lcm( texel_size, uint64_t( 4 ) );
+
+	if ( le_staging_allocator_i.map( self->stagingAllocator, numBytes, alignment, &memAddr, &stagingBufferId, &stagingOffset ) ) {
 
-		// -- Write data to the freshly allocated buffer
+		// -- Write data to the freshly allocated staging range
 		memcpy( memAddr, data, numBytes );
 
 		assert( writeInfo.num_miplevels != 0 ); // number of miplevels must be at least 1.
 
 		cmd->info.src_buffer_id   = stagingBufferId;           // resource id of staging buffer
+		cmd->info.src_offset      = stagingOffset;             // offset of staging range within staging buffer
 		cmd->info.numBytes        = numBytes;                  // total number of bytes from staging buffer which need to be synchronised.
 		cmd->info.dst_image_id    = dst_img;                   // resouce id for target image resource
 		cmd->info.dst_miplevel    = writeInfo.dst_miplevel;    // default 0, use higher number to manually upload higher mip levels.
@@ -966,6 +1032,13 @@ void register_le_command_buffer_encoder_api( void* api_ ) {
 	    .set_line_width         = cbe_set_line_width,
 	    .set_viewport           = cbe_set_viewport,
 	    .set_scissor            = cbe_set_scissor,
+	    .set_cull_mode          = cbe_set_cull_mode,
+	    .set_front_face         = cbe_set_front_face,
+	    .set_primitive_topology = cbe_set_primitive_topology,
+	    .set_depth_state        = cbe_set_depth_state,
+	    .set_polygon_mode       = cbe_set_polygon_mode,
+	    .set_color_blend_enable = cbe_set_color_blend_enable,
+	    .set_color_write_mask   = cbe_set_color_write_mask,
 	    .bind_index_buffer      = cbe_bind_index_buffer,
 	    .bind_vertex_buffers    = cbe_bind_vertex_buffers,
 	    .set_index_data         = cbe_set_index_data,
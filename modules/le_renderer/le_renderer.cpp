@@ -14,13 +14,21 @@
 #include "assert.h"
 #include <mutex>
 #include <unordered_map>
+#include <map>
 #include <algorithm>
 #include <string>
+#include <string_view>
+#include <atomic>
 #include <cstring> // for memcpy
+#include <cstdlib> // for getenv
+#include <fstream>
 #include <bitset>
+#include <thread>
 
 #include "private/le_renderer/le_resource_handle_t.inl"
 #include "private/le_renderer/le_rendergraph.h"
+#include "private/le_renderer/le_intern_table.h"
+#include "private/le_renderer/le_spsc_queue.h"
 
 #include "le_tracy.h"
 
@@ -58,20 +66,89 @@ struct FrameData {
 	le_rendergraph_o* rendergraph = nullptr;
 
 	size_t frameNumber = size_t( ~0 );
+
+	NanoTime dispatch_time{}; // when this frame was last dispatched - used for low-latency frame pacing
+
+	enum Stage : uint32_t {
+		eStageRendergraphBuild = 0,
+		eStageRecord,
+		eStageAcquire,
+		eStageProcess,
+		eStageDispatch,
+		eStageClear,
+		eStageCount,
+	};
+
+	double stage_ms[ eStageCount ]{}; // cpu time spent on each stage of this frame, in milliseconds
+};
+
+static constexpr char const* FRAME_STAGE_NAMES[ FrameData::eStageCount ] = {
+    "rendergraph_build",
+    "record",
+    "acquire",
+    "process",
+    "dispatch",
+    "clear",
+};
+
+static double ms_since( NanoTime const& t0 ) {
+	return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - t0 ).count();
+}
+
+// ----------------------------------------------------------------------
+// Headless benchmark: renders a fixed number of frames into image swapchains which discard
+// their images, with a fixed timebase, and then writes a JSON report. Apps quit once
+// `is_benchmark_complete` returns true. Set up from environment variables, so that any
+// application which checks for completion can be benchmarked without further changes:
+//
+// LE_BENCHMARK_FRAMES=600 LE_BENCHMARK_REPORT=report.json ./Island-HelloTriangle
+//
+// LE_BENCHMARK_FRAMES          number of frames to render - benchmark mode is off unless this is set
+// LE_BENCHMARK_WARMUP_FRAMES   number of initial frames which don't count towards summaries (default: 10)
+// LE_BENCHMARK_REPORT          path of the JSON report (default: "benchmark_report.json")
+//
+struct le_renderer_benchmark_t {
+
+	struct frame_result_t {
+		uint64_t                                    frame_number;
+		double                                      stage_ms[ FrameData::eStageCount ];
+		uint64_t                                    allocation_count; // live allocations in the backend's allocator, once frame was cleared
+		uint64_t                                    block_count;      // device memory blocks held by the backend's allocator, once frame was cleared
+		std::vector<std::pair<std::string, double>> gpu_pass_ms;      // gpu time per pass debug name
+	};
+
+	uint32_t                    num_frames            = 0;
+	uint32_t                    warmup_frames         = 0;
+	std::string                 report_path;
+	uint64_t                    last_gpu_frame_number = 0;     // most recent frame number for which we took gpu pass timings
+	bool                        is_complete           = false; // set once all frames were rendered, and the report was written
+	std::mutex                  mtx;                           // protects everything below - frames may get cleared on the render thread
+	std::vector<frame_result_t> frames;                        // one entry per frame, in the order in which frames were cleared
 };
 
 struct le_texture_handle_t {
 	std::string debug_name;
 };
 
+struct le_texture_name_hash {
+	uint64_t operator()( std::string_view const& name ) const noexcept {
+		return std::hash<std::string_view>()( name );
+	}
+};
+
+// Named handles are interned, so that looking up a name which was seen before does not
+// need a lock. Unnamed handles are always unique; we only keep them so that we own them.
 struct le_texture_handle_store_t {
-	std::unordered_multimap<std::string, le_texture_handle_t> texture_handles;
-	std::mutex                                                mtx;
+	InternTable<std::string, le_texture_handle_t, le_texture_name_hash> texture_handles;         // named handles, interned by name
+	std::vector<le_texture_handle_t*>                                   unnamed_texture_handles; // owning
+	std::mutex                                                          mtx;                     // protects unnamed_texture_handles
 };
 
 struct le_resource_handle_store_t {
-	std::unordered_multimap<le_resource_handle_data_t, le_resource_handle_t, le_resource_handle_data_hash> resource_handles;
-	std::mutex                                                                                             mtx;
+	InternTable<le_resource_handle_data_t, le_resource_handle_t, le_resource_handle_data_hash> resource_handles;         // named handles, interned by handle data
+	std::vector<le_resource_handle_t*>                                                         unnamed_resource_handles; // owning
+	std::mutex                                                                                 mtx;                      // protects unnamed_resource_handles
+	std::atomic<uint32_t>                                                                      next_slot = 0;            // slot for the next handle which gets created
 };
 
 static le_texture_handle_store_t* get_texture_handle_library( bool erase = false ) {
@@ -144,10 +221,31 @@ struct le_renderer_o {
 	std::vector<FrameData> frames;
 	size_t                 backendDataFramesCount = 0;
 	size_t                 currentFrameNumber = size_t( ~0 ); // ever increasing number of current frame
+	size_t                 dispatch_lag       = 0;            // number of updates between recording and dispatching a frame - derived from frames count, 0 in low-latency mode
 	le_renderer_settings_t settings;
+
+	// Low-latency frame pacing - only used if settings.low_latency_mode is set.
+	NanoTime pacing_update_end{};      // when `update` last returned control to the application
+	NanoTime pacing_last_fence{};      // when we last saw a frame fence signalled
+	NanoTime pacing_gpu_available{};   // estimated time at which the gpu will have finished the most recently dispatched frame
+	double   pacing_cpu_ms      = 0.0; // smoothed time from returning control to the application until the next frame was dispatched
+	double   pacing_gpu_ms      = 0.0; // smoothed gpu time per frame, measured at frame fences
+
+	le_renderer_benchmark_t* benchmark = nullptr; // owning, only set if running a headless benchmark
+
+	le_renderer_api::pfn_renderer_idle_t idle_fun       = nullptr; // optional, called while we wait for the gpu to complete a frame
+	void*                                idle_user_data = nullptr; //
+
+	// Render thread - only used if settings.use_render_thread is set.
+	std::thread            render_thread;
+	SpscQueue<size_t>*     render_queue = nullptr;               // owning; frame numbers of recorded frames, pushed by update, popped by render thread
+	std::atomic<size_t>    render_thread_frames_processed = 0;   // number of frames which the render thread has dispatched, and after which it has cleared the oldest frame
 };
 
 static void renderer_clear_frame( le_renderer_o* self, size_t frameIndex ); // ffdecl
+static void renderer_render_thread_run( le_renderer_o* self );              // ffdecl
+static void renderer_render_thread_stop( le_renderer_o* self );             // ffdecl
+static void renderer_render_thread_drain( le_renderer_o* self );            // ffdecl
 
 // ----------------------------------------------------------------------
 
@@ -167,35 +265,31 @@ static le_renderer_o* renderer_create() {
 // ----------------------------------------------------------------------
 
 // creates a new handle if no name was given, or given name was not found in list of current handles.
+// May be called concurrently from any thread; looking up a name which was seen before does not lock.
 static le_texture_handle renderer_produce_texture_handle( char const* maybe_name ) {
 
-	// lock handle library for reading/writing
 	static le_texture_handle_store_t* texture_handle_library = get_texture_handle_library();
-	std::scoped_lock                  lock( texture_handle_library->mtx );
 
 	le_texture_handle handle;
 
 	if ( maybe_name ) {
-		// if a string was given, search for multimap and see if we can find something.
-		auto it = texture_handle_library->texture_handles.find( maybe_name );
-		if ( it == texture_handle_library->texture_handles.end() ) {
-			// not found, insert a new element
-			handle = &texture_handle_library->texture_handles.emplace( maybe_name, le_texture_handle_t( { maybe_name } ) )->second;
-		} else {
-			// found, return a pointer to the found element
-			handle = &it->second;
+		// if a string was given, see if we can find it without creating a std::string first.
+		handle = texture_handle_library->texture_handles.try_find( std::string_view( maybe_name ) );
+		if ( nullptr == handle ) {
+			// not found, insert a new element - unless another thread beat us to it
+			handle = texture_handle_library->texture_handles.find_or_insert(
+			    maybe_name, [ & ]() { return le_texture_handle_t{ maybe_name }; } );
 		}
 	} else {
-		// no name given: handle is set to address of newly inserted element
-		// As this is a multimap, there can be any number of textures with the same
-		// key "unnamed" in the map.
-		handle = &texture_handle_library->texture_handles.emplace( "unnamed", le_texture_handle_t{} )->second;
+		// no name given: handle is set to address of newly allocated element.
+		// There can be any number of unnamed textures.
+		handle = new le_texture_handle_t{};
+		std::scoped_lock lock( texture_handle_library->mtx );
+		texture_handle_library->unnamed_texture_handles.push_back( handle );
 	}
 
-	// handle is a pointer to the element in the container, and as such it is
-	// guaranteed to stay valid, even through rehashes of the texture_handles
-	// container, because that's a guarantee that maps give us in c++, until
-	// the element gets erased.
+	// handle is a pointer to an element which is owned by the handle library,
+	// and as such it is guaranteed to stay valid for as long as the library lives.
 
 	return handle;
 }
@@ -211,6 +305,7 @@ static char const* texture_handle_get_name( le_texture_handle texture ) {
 }
 
 // creates a new resource if no name was given, or given name was not found in list of current handles.
+// May be called concurrently from any thread; looking up a handle which was seen before does not lock.
 le_resource_handle renderer_produce_resource_handle(
     char const*           maybe_name,
     LeResourceType const& resource_type,
@@ -220,41 +315,38 @@ le_resource_handle renderer_produce_resource_handle(
     le_resource_handle    reference_handle = nullptr ) {
 
 	static le_resource_handle_store_t* resource_handle_library = get_resource_handle_library();
-	// lock handle library for reading/writing
-	std::scoped_lock lock( resource_handle_library->mtx );
 
 	le_resource_handle handle;
 
-	le_resource_handle_data_t* p_data = new le_resource_handle_data_t{};
-	p_data->flags                     = flags;
-	p_data->num_samples               = num_samples;
-	p_data->reference_handle          = reference_handle;
-	p_data->type                      = resource_type;
-	p_data->index                     = index;
+	le_resource_handle_data_t data{};
+	data.flags            = flags;
+	data.num_samples      = num_samples;
+	data.reference_handle = reference_handle;
+	data.type             = resource_type;
+	data.index            = index;
 
 	if ( maybe_name && maybe_name[ 0 ] != '\0' ) {
-		memcpy( p_data->debug_name, maybe_name, sizeof( p_data->debug_name ) );
-		// if a string was given, search for multimap and see if we can find something.
-		auto it = resource_handle_library->resource_handles.find( *p_data );
-		if ( it == resource_handle_library->resource_handles.end() ) {
-			// not found, insert a new element
-			handle = &resource_handle_library->resource_handles.emplace( *p_data, le_resource_handle_t{ p_data } )->second;
-		} else {
-			// found, return a pointer to the found element
-			handle = &it->second;
-			delete ( p_data );
-		}
+		memcpy( data.debug_name, maybe_name, sizeof( data.debug_name ) );
+		// if a string was given, intern handle data: this only allocates if no
+		// matching handle exists yet, and only locks in that case, too.
+		handle = resource_handle_library->resource_handles.find_or_insert(
+		    data, [ & ]() {
+			    le_resource_handle_data_t* p_data = new le_resource_handle_data_t( data );
+			    p_data->slot                      = resource_handle_library->next_slot++;
+			    return le_resource_handle_t{ p_data };
+		    } );
 	} else {
-		// no name given: handle is set to address of newly inserted element
-		// As this is a multimap, there can be any number of textures with the same
-		// key "unnamed" in the map.
-		handle = &resource_handle_library->resource_handles.emplace( *p_data, le_resource_handle_t{ p_data } )->second;
+		// no name given: handle is set to address of newly allocated element.
+		// There can be any number of unnamed resources.
+		le_resource_handle_data_t* p_data = new le_resource_handle_data_t( data );
+		p_data->slot                      = resource_handle_library->next_slot++;
+		handle                            = new le_resource_handle_t{ p_data };
+		std::scoped_lock lock( resource_handle_library->mtx );
+		resource_handle_library->unnamed_resource_handles.push_back( handle );
 	}
 
-	// handle is a pointer to the element in the container, and as such it is
-	// guaranteed to stay valid, even through rehashes of the resource_handle_library
-	// container, because that's a guarantee that maps give us in c++, until
-	// the element gets erased.
+	// handle is a pointer to an element which is owned by the handle library,
+	// and as such it is guaranteed to stay valid for as long as the library lives.
 
 	return handle;
 }
@@ -291,6 +383,9 @@ static void renderer_destroy( le_renderer_o* self ) {
 
 	using namespace le_renderer; // for rendergraph_i
 
+	// Render thread must have let go of all frames before we can clear them here.
+	renderer_render_thread_stop( self );
+
 	const auto& lastIndex = self->currentFrameNumber;
 
 	for ( size_t i = 0; i != self->frames.size(); ++i ) {
@@ -303,15 +398,27 @@ static void renderer_destroy( le_renderer_o* self ) {
 
 	self->frames.clear();
 
-	// Delete texture handle library
-	get_texture_handle_library( false );
+	{
+		// Delete unnamed texture handles, which the texture handle library owns.
+		// Named handles are owned by the library's intern table.
+		le_texture_handle_store_t* texture_handle_library = get_texture_handle_library( false );
+		std::scoped_lock           lock( texture_handle_library->mtx );
+		for ( auto& h : texture_handle_library->unnamed_texture_handles ) {
+			delete ( h );
+		}
+		texture_handle_library->unnamed_texture_handles.clear();
+	}
 
 	{
 		le_resource_handle_store_t* resource_handle_library = get_resource_handle_library();
 		if ( resource_handle_library ) {
 			// we must deallocate manually allocated data for resource handles
-			for ( auto& e : resource_handle_library->resource_handles ) {
-				delete ( e.second.data );
+			resource_handle_library->resource_handles.for_each( []( le_resource_handle_t& h ) {
+				delete ( h.data );
+			} );
+			for ( auto& h : resource_handle_library->unnamed_resource_handles ) {
+				delete ( h->data );
+				delete ( h );
 			}
 			// Delete static pointer to resource handle library
 			get_resource_handle_library( true );
@@ -329,6 +436,7 @@ static void renderer_destroy( le_renderer_o* self ) {
 	le_jobs::terminate();
 #endif
 
+	delete self->benchmark;
 	delete self;
 }
 
@@ -378,12 +486,258 @@ static bool renderer_request_swapchain_capabilities( le_renderer_o* self, le_swa
 
 // ----------------------------------------------------------------------
 
+// Returns a new benchmark if LE_BENCHMARK_FRAMES is set, nullptr otherwise.
+static le_renderer_benchmark_t* renderer_benchmark_create_from_environment() {
+
+	char const* num_frames = getenv( "LE_BENCHMARK_FRAMES" );
+
+	if ( nullptr == num_frames || 0 == strtoul( num_frames, nullptr, 10 ) ) {
+		return nullptr;
+	}
+
+	// ----------| invariant: benchmark was requested
+
+	char const* warmup_frames = getenv( "LE_BENCHMARK_WARMUP_FRAMES" );
+	char const* report_path   = getenv( "LE_BENCHMARK_REPORT" );
+
+	auto benchmark           = new le_renderer_benchmark_t();
+	benchmark->num_frames    = uint32_t( strtoul( num_frames, nullptr, 10 ) );
+	benchmark->warmup_frames = warmup_frames ? uint32_t( strtoul( warmup_frames, nullptr, 10 ) ) : 10;
+	benchmark->report_path   = report_path ? report_path : "benchmark_report.json";
+	benchmark->frames.reserve( benchmark->num_frames );
+
+	return benchmark;
+}
+
+// ----------------------------------------------------------------------
+// Turns window and direct swapchains into image swapchains of the same size,
+// which render as usual, but which neither present nor save their images.
+static void renderer_benchmark_make_swapchain_headless( le_swapchain_settings_t& settings ) {
+	if ( settings.type != le_swapchain_settings_t::LE_IMG_SWAPCHAIN ) {
+		settings.init_img_settings();
+	}
+	settings.img_settings.discard_images = 1;
+}
+
+// ----------------------------------------------------------------------
+// Takes results for a frame which has just been cleared - at this point, its gpu pass timings
+// have been read back, and its transient allocations have been returned to the allocator.
+static void renderer_benchmark_add_frame( le_renderer_o* self, FrameData const& frame ) {
+
+	using namespace le_backend_vk;
+
+	auto benchmark = self->benchmark;
+
+	le_renderer_benchmark_t::frame_result_t result{};
+	result.frame_number = frame.frameNumber;
+	memcpy( result.stage_ms, frame.stage_ms, sizeof( result.stage_ms ) );
+
+	{
+		le_memory_heap_budget_t heaps[ 16 ]{}; // VK_MAX_MEMORY_HEAPS
+		uint32_t                num_heaps = 16;
+		vk_backend_i.get_memory_budget( self->backend, heaps, &num_heaps );
+		for ( uint32_t i = 0; i != num_heaps; i++ ) {
+			result.allocation_count += heaps[ i ].allocation_count;
+			result.block_count += heaps[ i ].block_count;
+		}
+	}
+
+	uint32_t num_timings = 0;
+	vk_backend_i.get_gpu_pass_timings( self->backend, nullptr, &num_timings );
+	std::vector<le_gpu_pass_timing_t> timings( num_timings );
+	vk_backend_i.get_gpu_pass_timings( self->backend, timings.data(), &num_timings );
+
+	auto lock = std::scoped_lock( benchmark->mtx );
+
+	// Timings are kept per pass name, and only updated when a pass gets measured - we only
+	// take timings from the most recently measured frame, and only once.
+	uint64_t gpu_frame_number = benchmark->last_gpu_frame_number;
+
+	for ( uint32_t i = 0; i != num_timings; i++ ) {
+		gpu_frame_number = std::max( gpu_frame_number, timings[ i ].frame_number );
+	}
+
+	if ( gpu_frame_number != benchmark->last_gpu_frame_number ) {
+		for ( uint32_t i = 0; i != num_timings; i++ ) {
+			if ( timings[ i ].frame_number == gpu_frame_number ) {
+				result.gpu_pass_ms.emplace_back( timings[ i ].debug_name, timings[ i ].gpu_ms );
+			}
+		}
+		benchmark->last_gpu_frame_number = gpu_frame_number;
+	}
+
+	benchmark->frames.emplace_back( std::move( result ) );
+}
+
+// ----------------------------------------------------------------------
+
+static std::string json_escape( std::string const& str ) {
+	std::string result;
+	result.reserve( str.size() );
+	for ( char c : str ) {
+		if ( c == '"' || c == '\\' ) {
+			result += '\\';
+			result += c;
+		} else if ( uint8_t( c ) < 0x20 ) {
+			char buf[ 8 ];
+			snprintf( buf, sizeof( buf ), "\\u%04x", uint32_t( c ) );
+			result += buf;
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+// ----------------------------------------------------------------------
+
+struct benchmark_summary_t {
+	double   mean_ms   = 0;
+	double   median_ms = 0;
+	double   p95_ms    = 0;
+	double   min_ms    = 0;
+	double   max_ms    = 0;
+	uint64_t samples   = 0;
+};
+
+static benchmark_summary_t benchmark_summarise( std::vector<double>& samples ) {
+	benchmark_summary_t s{};
+	if ( samples.empty() ) {
+		return s;
+	}
+	std::sort( samples.begin(), samples.end() );
+	double sum = 0;
+	for ( auto const& v : samples ) {
+		sum += v;
+	}
+	s.samples   = samples.size();
+	s.mean_ms   = sum / double( samples.size() );
+	s.median_ms = samples[ samples.size() / 2 ];
+	s.p95_ms    = samples[ std::min( samples.size() - 1, ( samples.size() * 95 ) / 100 ) ];
+	s.min_ms    = samples.front();
+	s.max_ms    = samples.back();
+	return s;
+}
+
+static void benchmark_write_summary( std::ostream& os, benchmark_summary_t const& s ) {
+	os << "{ \"mean_ms\": " << s.mean_ms
+	   << ", \"median_ms\": " << s.median_ms
+	   << ", \"p95_ms\": " << s.p95_ms
+	   << ", \"min_ms\": " << s.min_ms
+	   << ", \"max_ms\": " << s.max_ms
+	   << ", \"samples\": " << s.samples << " }";
+}
+
+// ----------------------------------------------------------------------
+// Writes report with summaries per stage and per gpu pass over all frames after the
+// warmup frames, followed by raw results per frame.
+static bool renderer_benchmark_write_report( le_renderer_o* self ) {
+
+	static auto logger    = LeLog( "le_renderer" );
+	auto        benchmark = self->benchmark;
+	auto        lock      = std::scoped_lock( benchmark->mtx );
+
+	std::ofstream os( benchmark->report_path, std::ios::out | std::ios::trunc );
+
+	if ( !os.is_open() ) {
+		logger.error( "Could not open benchmark report file '%s' for writing.", benchmark->report_path.c_str() );
+		return false;
+	}
+
+	os << std::fixed << std::setprecision( 4 );
+
+	size_t const first_frame = std::min<size_t>( benchmark->warmup_frames, benchmark->frames.size() );
+
+	os << "{\n";
+	os << "  \"frames\": " << benchmark->frames.size() << ",\n";
+	os << "  \"warmup_frames\": " << first_frame << ",\n";
+	os << "  \"frames_in_flight\": " << self->frames.size() << ",\n";
+	os << "  \"render_thread\": " << ( self->settings.use_render_thread ? "true" : "false" ) << ",\n";
+	os << "  \"mt_workers\": " << LE_MT << ",\n";
+
+	os << "  \"cpu_stages\": {\n";
+	for ( uint32_t stage = 0; stage != FrameData::eStageCount; stage++ ) {
+		std::vector<double> samples;
+		for ( size_t i = first_frame; i < benchmark->frames.size(); i++ ) {
+			samples.push_back( benchmark->frames[ i ].stage_ms[ stage ] );
+		}
+		os << "    \"" << FRAME_STAGE_NAMES[ stage ] << "\": ";
+		benchmark_write_summary( os, benchmark_summarise( samples ) );
+		os << ( stage + 1 != FrameData::eStageCount ? ",\n" : "\n" );
+	}
+	os << "  },\n";
+
+	{
+		std::map<std::string, std::vector<double>> pass_samples; // ordered, so that reports are easy to diff
+		for ( size_t i = first_frame; i < benchmark->frames.size(); i++ ) {
+			for ( auto const& [ name, ms ] : benchmark->frames[ i ].gpu_pass_ms ) {
+				pass_samples[ name ].push_back( ms );
+			}
+		}
+		os << "  \"gpu_passes\": {";
+		char const* delim = "\n";
+		for ( auto& [ name, samples ] : pass_samples ) {
+			os << delim << "    \"" << json_escape( name ) << "\": ";
+			benchmark_write_summary( os, benchmark_summarise( samples ) );
+			delim = ",\n";
+		}
+		os << ( pass_samples.empty() ? "},\n" : "\n  },\n" );
+	}
+
+	os << "  \"per_frame\": [";
+	for ( size_t i = 0; i != benchmark->frames.size(); i++ ) {
+		auto const& f = benchmark->frames[ i ];
+		os << ( i ? ",\n" : "\n" );
+		os << "    { \"frame\": " << f.frame_number << ", \"cpu_ms\": { ";
+		for ( uint32_t stage = 0; stage != FrameData::eStageCount; stage++ ) {
+			os << ( stage ? ", " : "" ) << "\"" << FRAME_STAGE_NAMES[ stage ] << "\": " << f.stage_ms[ stage ];
+		}
+		os << " }, \"allocations\": " << f.allocation_count
+		   << ", \"memory_blocks\": " << f.block_count
+		   << ", \"gpu_ms\": { ";
+		for ( size_t j = 0; j != f.gpu_pass_ms.size(); j++ ) {
+			os << ( j ? ", " : "" ) << "\"" << json_escape( f.gpu_pass_ms[ j ].first ) << "\": " << f.gpu_pass_ms[ j ].second;
+		}
+		os << " } }";
+	}
+	os << "\n  ]\n}\n";
+
+	os.close();
+
+	logger.info( "Wrote benchmark report for %zu frames to '%s'", benchmark->frames.size(), benchmark->report_path.c_str() );
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
 static void renderer_setup( le_renderer_o* self, le_renderer_settings_t const* settings ) {
 
 	// We store swapchain settings with the renderer so that we can pass
 	// backend a permanent pointer to it.
 
 	self->settings = *settings;
+
+	self->benchmark = renderer_benchmark_create_from_environment();
+
+	if ( self->benchmark ) {
+		static auto logger = LeLog( "le_renderer" );
+		logger.info( "Running headless benchmark over %d frames.", self->benchmark->num_frames );
+
+		for ( size_t i = 0; i < self->settings.num_swapchain_settings; i++ ) {
+			renderer_benchmark_make_swapchain_headless( self->settings.swapchain_settings[ i ] );
+		}
+
+		if ( 0 == le_backend_vk::settings_i.get_gpu_profiling_level() ) {
+			le_backend_vk::settings_i.set_gpu_profiling_level( 1 );
+		}
+
+		// Animations which use le_timebase advance by 1/60th of a second per frame, so that
+		// each run renders the same frames. Timebase counts 12000 ticks per second.
+		LE_SETTING( uint64_t, LE_SETTING_TIMEBASE_FIXED_INTERVAL_TICKS, 0 );
+		*LE_SETTING_TIMEBASE_FIXED_INTERVAL_TICKS = 12000 / 60;
+	}
+
 	{
 		// Before we can initialise the backend, we must query for any required
 		// capabilities and extensions that come implied via swapchains:
@@ -394,6 +748,12 @@ static void renderer_setup( le_renderer_o* self, le_renderer_settings_t const* s
 		le_backend_vk::settings_i.set_concurrency_count( LE_MT );
 #endif
 
+		if ( self->settings.frames_in_flight ) {
+			// Note that the number of frames may still be adapted once we know how many
+			// images the first swapchain provides.
+			le_backend_vk::settings_i.set_data_frames_count( std::clamp( self->settings.frames_in_flight, 2u, 4u ) );
+		}
+
 		// We can now initialize the backend so that it hopefully conforms to
 		// any requirements and capabilities that have been requested so far...
 		//
@@ -435,7 +795,28 @@ static void renderer_setup( le_renderer_o* self, le_renderer_settings_t const* s
 
 	self->currentFrameNumber = 0;
 
+	// Derive pipeline depth from the number of frames: We record one frame per update, and we
+	// clear the oldest frame at the end of each update, so that it can be recorded into next.
+	// In between, a frame waits `dispatch_lag` updates before we dispatch it. More lag means
+	// that the cpu may run further ahead of the gpu - in low-latency mode we don't want that.
+	self->dispatch_lag = self->settings.low_latency_mode ? 0 : ( self->backendDataFramesCount > 2 ? self->backendDataFramesCount - 2 : 0 );
+
+	if ( self->settings.use_render_thread ) {
+		static auto logger = LeLog( "le_renderer" );
 
+		if ( self->settings.low_latency_mode ) {
+			// Pacing measures and delays the thread which dispatches frames - with a render thread,
+			// this is no longer the thread which samples input, so pacing would not reduce latency.
+			logger.warn( "Low-latency mode is not available when rendering on a render thread - ignoring low-latency mode." );
+			self->settings.low_latency_mode = false;
+		}
+
+		// Queue never holds more frames than there are frames, as update waits for the
+		// render thread before it records into a frame which the render thread still owns.
+		// We add one slot so that the stop signal always fits.
+		self->render_queue  = new SpscQueue<size_t>( self->backendDataFramesCount + 1 );
+		self->render_thread = std::thread( renderer_render_thread_run, self );
+	}
 }
 // ----------------------------------------------------------------------
 
@@ -445,6 +826,13 @@ static le_renderer_settings_t const* renderer_get_settings( le_renderer_o* self
 
 // ----------------------------------------------------------------------
 
+static void renderer_set_idle_callback( le_renderer_o* self, void* user_data, le_renderer_api::pfn_renderer_idle_t idle_fun ) {
+	self->idle_fun       = idle_fun;
+	self->idle_user_data = user_data;
+}
+
+// ----------------------------------------------------------------------
+
 static void renderer_clear_frame( le_renderer_o* self, size_t frameIndex ) {
 
 	auto& frame = self->frames[ frameIndex ];
@@ -458,18 +846,50 @@ static void renderer_clear_frame( le_renderer_o* self, size_t frameIndex ) {
 
 	// ----------| invariant: frame was not yet cleared
 
+	NanoTime   t0             = std::chrono::high_resolution_clock::now();
+	bool const was_dispatched = frame.state == FrameData::State::eDispatched;
+
 	// + ensure frame fence has been reached
 	if ( frame.state == FrameData::State::eDispatched ||
 	     frame.state == FrameData::State::eFailedDispatch ||
 	     frame.state == FrameData::State::eFailedClear ) {
 
+		bool did_wait = false;
+
+		// Polling does not block - while the gpu is still busy with this frame, we give
+		// the application's idle callback a chance to do some work. Only once there is
+		// no more work do we block on the frame fence.
 		while ( false == vk_backend_i.poll_frame_fence( self->backend, frameIndex ) ) {
-			// Note: this call may block until the fence has been reached.
+			did_wait = true;
+
+			if ( self->idle_fun && self->idle_fun( self->idle_user_data ) ) {
+				continue;
+			}
+
+			if ( vk_backend_i.wait_frame_fence( self->backend, frameIndex, 100'000'000 ) ) {
+				break;
+			}
+
 #if ( LE_MT > 0 )
-			le_jobs::yield();
+			if ( !self->settings.use_render_thread ) {
+				// Render thread is not a job worker thread, and must not yield.
+				le_jobs::yield();
+			}
 #endif
 		}
 
+		if ( self->settings.low_latency_mode && frame.state == FrameData::State::eDispatched ) {
+			// If we had to wait for the fence, the gpu was busy with this frame until just now -
+			// it started on this frame once it had been dispatched, and the previous frame was done.
+			auto now = std::chrono::high_resolution_clock::now();
+			if ( did_wait ) {
+				auto   gpu_start = std::max( frame.dispatch_time, self->pacing_last_fence );
+				double gpu_ms    = std::chrono::duration<double, std::milli>( now - gpu_start ).count();
+				self->pacing_gpu_ms += ( gpu_ms - self->pacing_gpu_ms ) * 0.1;
+			}
+			self->pacing_last_fence = now;
+		}
+
 		bool result = vk_backend_i.clear_frame( self->backend, frameIndex );
 
 		if ( result != true ) {
@@ -483,6 +903,12 @@ static void renderer_clear_frame( le_renderer_o* self, size_t frameIndex ) {
 	//	std::cout << "CLEAR FRAME " << frameIndex << std::endl
 	//	          << std::flush;
 
+	frame.stage_ms[ FrameData::eStageClear ] = ms_since( t0 ); // includes time spent waiting for the frame fence
+
+	if ( self->benchmark && was_dispatched ) {
+		renderer_benchmark_add_frame( self, frame );
+	}
+
 	frame.state = FrameData::State::eCleared;
 }
 
@@ -513,12 +939,18 @@ static void renderer_record_frame( le_renderer_o* self, size_t frameIndex, le_re
 	// and stores their descriptors (information needed to allocate physical resources)
 	//
 	using namespace le_renderer; // for rendergraph_i, rendergraph_i
+
+	NanoTime t0 = std::chrono::high_resolution_clock::now();
+
 	le_renderer::api->le_rendergraph_private_i.setup_passes( graph_, frame.rendergraph );
 
 	// find out which renderpasses contribute, only add contributing render passes to
 	// rendergraph
 	le_renderer::api->le_rendergraph_private_i.build( frame.rendergraph, frameNumber );
 
+	frame.stage_ms[ FrameData::eStageRendergraphBuild ] = ms_since( t0 );
+	t0                                                  = std::chrono::high_resolution_clock::now();
+
 	// declare any resources that come from swapchains
 	le_backend_vk::vk_backend_i.acquire_swapchain_resources( self->backend, frameIndex );
 
@@ -527,6 +959,8 @@ static void renderer_record_frame( le_renderer_o* self, size_t frameIndex, le_re
 	//
 	le_renderer::api->le_rendergraph_private_i.execute( frame.rendergraph, frameIndex, self->backend );
 
+	frame.stage_ms[ FrameData::eStageRecord ] = ms_since( t0 );
+
 	frame.state = FrameData::State::eRecorded;
 }
 
@@ -549,6 +983,8 @@ static const FrameData::State& renderer_acquire_backend_resources( le_renderer_o
 
 	// ----------| invariant: frame is either initial, or cleared.
 
+	NanoTime t0 = std::chrono::high_resolution_clock::now();
+
 	le_renderpass_o** passes          = frame.rendergraph->passes.data();
 	size_t            numRenderPasses = frame.rendergraph->passes.size();
 
@@ -577,6 +1013,7 @@ static const FrameData::State& renderer_acquire_backend_resources( le_renderer_o
 		    frame.rendergraph->root_debug_names.data(), frame.rendergraph->root_debug_names.size() );
 	}
 
+	frame.stage_ms[ FrameData::eStageAcquire ] = ms_since( t0 );
 
 	frame.state = FrameData::State::eAcquired;
 
@@ -598,7 +1035,9 @@ static const FrameData::State& renderer_process_frame( le_renderer_o* self, size
 	// ---------| invariant: frame was previously recorded successfully
 
 	// translate intermediate draw lists into vk command buffers, and sync primitives
+	NanoTime t0 = std::chrono::high_resolution_clock::now();
 	vk_backend_i.process_frame( self->backend, frameIndex );
+	frame.stage_ms[ FrameData::eStageProcess ] = ms_since( t0 );
 
 	frame.state = FrameData::State::eProcessed;
 	return frame.state;
@@ -618,9 +1057,126 @@ static void renderer_dispatch_frame( le_renderer_o* self, size_t frameIndex ) {
 
 	// ---------| invariant: frame was successfully processed previously
 
+	NanoTime t0 = std::chrono::high_resolution_clock::now();
 	vk_backend_i.dispatch_frame( self->backend, frameIndex );
 
-	frame.state = FrameData::State::eDispatched;
+	frame.dispatch_time                         = std::chrono::high_resolution_clock::now();
+	frame.stage_ms[ FrameData::eStageDispatch ] = std::chrono::duration<double, std::milli>( frame.dispatch_time - t0 ).count();
+	frame.state                                 = FrameData::State::eDispatched;
+}
+
+// ----------------------------------------------------------------------
+// Low-latency frame pacing: we delay returning control to the application - and with it
+// the application's next input sampling and recording - so that the next frame gets dispatched
+// just before we expect the gpu to have finished the frame which was dispatched in this update.
+//
+// We estimate when the gpu will be available based on smoothed gpu frame times, which we
+// measure at frame fences, and subtract the smoothed time that it took the application and
+// the renderer to get from returning control to dispatching a frame.
+static void renderer_pace_frame( le_renderer_o* self, size_t dispatched_frame_index ) {
+	ZoneScoped;
+
+	auto& frame = self->frames[ dispatched_frame_index ];
+
+	if ( frame.state == FrameData::State::eDispatched && frame.dispatch_time > self->pacing_update_end ) {
+
+		double cpu_ms = std::chrono::duration<double, std::milli>( frame.dispatch_time - self->pacing_update_end ).count();
+
+		if ( self->pacing_update_end != NanoTime{} ) {
+			self->pacing_cpu_ms += ( cpu_ms - self->pacing_cpu_ms ) * 0.1;
+		}
+
+		auto gpu_start = std::max( frame.dispatch_time, self->pacing_gpu_available );
+
+		self->pacing_gpu_available =
+		    gpu_start + std::chrono::duration_cast<NanoTime::duration>( std::chrono::duration<double, std::milli>( self->pacing_gpu_ms ) );
+
+		auto wake_time = self->pacing_gpu_available -
+		                 std::chrono::duration_cast<NanoTime::duration>( std::chrono::duration<double, std::milli>( self->pacing_cpu_ms ) );
+
+		// Never wait for longer than one gpu frame, so that a bad estimate can't stall us.
+		auto latest_wake_time = std::chrono::high_resolution_clock::now() +
+		                        std::chrono::duration_cast<NanoTime::duration>( std::chrono::duration<double, std::milli>( self->pacing_gpu_ms ) );
+
+		std::this_thread::sleep_until( std::min( wake_time, latest_wake_time ) );
+	}
+
+	self->pacing_update_end = std::chrono::high_resolution_clock::now();
+}
+
+// ----------------------------------------------------------------------
+// Render thread: pops frames which update has recorded, and acquires, processes, and
+// dispatches them in order. After it has dispatched a frame, it clears the oldest frame -
+// which is the frame that update will record into next - so that the application thread
+// only ever needs to wait for the render thread if it runs more than one frame ahead.
+static void renderer_render_thread_run( le_renderer_o* self ) {
+
+	const size_t numFrames = self->frames.size();
+
+	for ( ;; ) {
+
+		size_t frame_number;
+
+		while ( !self->render_queue->try_pop( frame_number ) ) {
+			self->render_queue->wait_until_not_empty();
+		}
+
+		if ( frame_number == size_t( ~0 ) ) {
+			return; // stop signal
+		}
+
+		// ----------| invariant: frame_number is the number of a frame which has been recorded
+
+		size_t frameIndex = frame_number % numFrames;
+
+		renderer_acquire_backend_resources( self, frameIndex );
+		renderer_process_frame( self, frameIndex );
+		renderer_dispatch_frame( self, frameIndex );
+
+		if ( frame_number + 1 >= numFrames ) {
+			// frame with index frame_number+1 gets recorded into the slot of the oldest frame,
+			// unless it is among the first numFrames frames, in which case its slot was never used.
+			renderer_clear_frame( self, ( frame_number + 1 ) % numFrames );
+		}
+
+		self->render_thread_frames_processed.store( frame_number + 1, std::memory_order_release );
+		self->render_thread_frames_processed.notify_all();
+	}
+}
+
+// ----------------------------------------------------------------------
+// Blocks until the render thread has processed all frames up to (not including) frame_number.
+static void renderer_render_thread_wait_for( le_renderer_o* self, size_t frame_number ) {
+	size_t processed = self->render_thread_frames_processed.load( std::memory_order_acquire );
+	while ( processed < frame_number ) {
+		self->render_thread_frames_processed.wait( processed, std::memory_order_acquire );
+		processed = self->render_thread_frames_processed.load( std::memory_order_acquire );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Blocks until the render thread has dispatched all recorded frames. Call this before
+// anything which the backend must not do while it is processing a frame - such as adding
+// or removing swapchains.
+static void renderer_render_thread_drain( le_renderer_o* self ) {
+	if ( !self->render_thread.joinable() ) {
+		return;
+	}
+	renderer_render_thread_wait_for( self, self->currentFrameNumber );
+}
+
+// ----------------------------------------------------------------------
+
+static void renderer_render_thread_stop( le_renderer_o* self ) {
+	if ( !self->render_thread.joinable() ) {
+		return;
+	}
+	while ( !self->render_queue->try_push( size_t( ~0 ) ) ) {
+		std::this_thread::yield();
+	}
+	self->render_thread.join();
+	delete self->render_queue;
+	self->render_queue = nullptr;
 }
 
 // ----------------------------------------------------------------------
@@ -653,6 +1209,12 @@ static le_swapchain_handle renderer_add_swapchain( le_renderer_o* self, le_swapc
 	ZoneScoped;
 	using namespace le_backend_vk;
 	assert( self->backend && "Backend must exist" );
+	renderer_render_thread_drain( self );
+	if ( self->benchmark ) {
+		le_swapchain_settings_t headless_settings = *settings;
+		renderer_benchmark_make_swapchain_headless( headless_settings );
+		return vk_backend_i.add_swapchain( self->backend, &headless_settings );
+	}
 	return vk_backend_i.add_swapchain( self->backend, settings );
 };
 // ----------------------------------------------------------------------
@@ -661,6 +1223,7 @@ static bool renderer_remove_swapchain( le_renderer_o* self, le_swapchain_handle
 	ZoneScoped;
 	using namespace le_backend_vk;
 	assert( self->backend && "Backend must exist" );
+	renderer_render_thread_drain( self );
 	return vk_backend_i.remove_swapchain( self->backend, swapchain );
 };
 
@@ -681,10 +1244,33 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 	const auto& index     = self->currentFrameNumber;
 	const auto& numFrames = self->frames.size();
 
+	// We record into the current frame, dispatch the frame which was recorded `dispatch_lag`
+	// updates ago, and clear the oldest frame, which is the frame we will record into next.
+	const size_t record_index   = index % numFrames;
+	const size_t dispatch_index = ( index + numFrames - self->dispatch_lag ) % numFrames;
+	const size_t clear_index    = ( index + 1 ) % numFrames;
+
 	// If necessary, recompile and reload shader modules
 	// - this must be complete before the record_frame step
 
-	if ( LE_MT > 0 ) {
+	if ( self->render_thread.joinable() ) {
+
+		// Record on this thread, then hand the frame over to the render thread, which acquires,
+		// processes, and dispatches it while the application moves on to its next frame.
+		vk_backend_i.update_shader_modules( self->backend );
+
+		if ( index >= numFrames ) {
+			// The render thread clears our frame once it has dispatched the previous frame.
+			renderer_render_thread_wait_for( self, index );
+		}
+
+		renderer_record_frame( self, record_index, graph_, index );
+
+		while ( !self->render_queue->try_push( index ) ) {
+			std::this_thread::yield(); // can't happen: queue has room for every frame, plus the stop signal
+		}
+
+	} else if ( LE_MT > 0 ) {
 		// use task system (experimental)
 
 		le_jobs::counter_t* shader_counter;
@@ -716,6 +1302,14 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 
 			le_jobs::wait_for_counter_and_free( p->shader_counter, 0 );
 			renderer_record_frame( p->renderer, p->frame_index, p->rendergraph, p->current_frame_number );
+
+			if ( p->renderer->dispatch_lag == 0 ) {
+				// frame gets dispatched in the same update in which it was recorded -
+				// we must do this on the same job, as it must happen after recording.
+				renderer_acquire_backend_resources( p->renderer, p->frame_index );
+				renderer_process_frame( p->renderer, p->frame_index );
+				renderer_dispatch_frame( p->renderer, p->frame_index );
+			}
 		};
 
 		auto process_frame_fun = []( void* param_ ) {
@@ -738,28 +1332,29 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 
 		record_params_t record_frame_params;
 		record_frame_params.renderer             = self;
-		record_frame_params.frame_index          = ( index + 0 ) % numFrames;
+		record_frame_params.frame_index          = record_index;
 		record_frame_params.rendergraph          = graph_;
 		record_frame_params.current_frame_number = self->currentFrameNumber;
 		record_frame_params.shader_counter       = shader_counter;
 
 		frame_params_t process_frame_params;
 		process_frame_params.renderer    = self;
-		process_frame_params.frame_index = ( index + 2 ) % numFrames;
+		process_frame_params.frame_index = dispatch_index;
 
 		frame_params_t clear_frame_params;
 		clear_frame_params.renderer    = self;
-		clear_frame_params.frame_index = ( index + 1 ) % numFrames;
+		clear_frame_params.frame_index = clear_index;
 
-		jobs[ 0 ] = { process_frame_fun, &process_frame_params };
+		jobs[ 0 ] = { record_frame_fun, &record_frame_params };
 		jobs[ 1 ] = { clear_frame_fun, &clear_frame_params };
-		jobs[ 2 ] = { record_frame_fun, &record_frame_params };
+		jobs[ 2 ] = { process_frame_fun, &process_frame_params };
 
 		le_jobs::counter_t* counter;
 
 		assert( self->backend );
 
-		le_jobs::run_jobs( jobs, 3, &counter );
+		// if there is no dispatch lag, the record job also dispatches.
+		le_jobs::run_jobs( jobs, self->dispatch_lag ? 3 : 2, &counter );
 
 		// we could theoretically do some more work on the main thread here...
 
@@ -772,7 +1367,7 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 
 		{
 			// RECORD FRAME
-			auto frameIndex = ( index + 0 ) % numFrames;
+			auto frameIndex = record_index;
 			// logger.info( "+++ [%5d] RECO", frameIndex );
 			renderer_record_frame( self, frameIndex, graph_, self->currentFrameNumber ); // generate an intermediary, api-agnostic, representation of the frame
 		}
@@ -781,7 +1376,7 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 			// DISPATCH FRAME
 			// acquire external backend resources such as swapchain
 			// and create any temporary resources
-			auto frameIndex = ( index + 2 ) % numFrames;
+			auto frameIndex = dispatch_index;
 			// logger.info( "+++ [%5d] DISP", frameIndex );
 			renderer_acquire_backend_resources( self, frameIndex ); //
 			renderer_process_frame( self, frameIndex );             // generate api commands for the frame
@@ -791,15 +1386,39 @@ static void renderer_update( le_renderer_o* self, le_rendergraph_o* graph_ ) {
 		{
 			// CLEAR FRAME
 			// wait for frame to come back (important to do this last, as it may block...)
-			auto frameIndex = ( index + 1 ) % numFrames;
+			auto frameIndex = clear_index;
 			// logger.info( "+++ [%5d] CLEA", frameIndex );
 			renderer_clear_frame( self, frameIndex );
 		}
 	}
 
+	if ( self->settings.low_latency_mode ) {
+		renderer_pace_frame( self, dispatch_index );
+	}
+
 	// logger.info( "+++ NEXT FRAME\n" );
 	++self->currentFrameNumber;
 	FrameMark; // We have completed the current frame - this signals it to tracy
+
+	if ( self->benchmark && !self->benchmark->is_complete && self->currentFrameNumber >= self->benchmark->num_frames ) {
+		size_t num_frames_complete;
+		{
+			auto lock           = std::scoped_lock( self->benchmark->mtx );
+			num_frames_complete = self->benchmark->frames.size();
+		}
+		if ( num_frames_complete >= self->benchmark->num_frames ) {
+			// We write the report exactly once - it is up to the app to stop calling update,
+			// which it should do once `is_benchmark_complete` returns true.
+			renderer_benchmark_write_report( self );
+			self->benchmark->is_complete = true;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+
+static bool renderer_is_benchmark_complete( le_renderer_o* self ) {
+	return self->benchmark && self->benchmark->is_complete;
 }
 
 // ----------------------------------------------------------------------
@@ -854,7 +1473,9 @@ LE_MODULE_REGISTER_IMPL( le_renderer, api ) {
 	le_renderer_i.destroy                        = renderer_destroy;
 	le_renderer_i.setup                          = renderer_setup;
 	le_renderer_i.update                         = renderer_update;
+	le_renderer_i.is_benchmark_complete          = renderer_is_benchmark_complete;
 	le_renderer_i.get_settings                   = renderer_get_settings;
+	le_renderer_i.set_idle_callback              = renderer_set_idle_callback;
 	le_renderer_i.get_swapchain_extent           = renderer_get_swapchain_extent;
 	le_renderer_i.get_pipeline_manager           = renderer_get_pipeline_manager;
 	le_renderer_i.get_backend                    = renderer_get_backend;
@@ -32,6 +32,11 @@ struct le_shader_binding_table_o;
 // clang-format off
 struct le_renderer_api {
 
+	// Called repeatedly while the renderer waits for the gpu to complete a frame - return true
+	// if you did some work, and would like to be called again; false if there is nothing to do,
+	// in which case the renderer blocks until the frame has completed.
+	typedef bool ( *pfn_renderer_idle_t )( void* user_data );
+
 	struct renderer_interface_t {
 		le_renderer_o *                ( *create                  )( );
 		void                           ( *destroy                 )( le_renderer_o *obj );
@@ -39,10 +44,16 @@ struct le_renderer_api {
 
 		void                           ( *update                  )( le_renderer_o *obj, le_rendergraph_o *rendergraph);
 
+		// Returns true once a headless benchmark (see LE_BENCHMARK_FRAMES) has rendered all its frames, and written its report - the app should then quit.
+		bool                           ( *is_benchmark_complete   )( le_renderer_o* self );
+
         le_renderer_settings_t const * ( *get_settings            )( le_renderer_o* self );
 
 		le_backend_o*                  ( *get_backend             )( le_renderer_o* self );
 
+		// Idle callback runs on whichever thread clears frames - the render thread, a job worker, or the thread which calls update.
+		void                           ( *set_idle_callback       )( le_renderer_o* self, void* user_data, pfn_renderer_idle_t idle_fun );
+
 	
 		// note: this method must be called before setup()
 
@@ -163,6 +174,15 @@ struct le_renderer_api {
 		void                         ( *set_viewport           )( le_command_buffer_encoder_o *self, uint32_t firstViewport, const uint32_t viewportCount, const le::Viewport *pViewports );
 		void                         ( *set_scissor            )( le_command_buffer_encoder_o *self, uint32_t firstScissor, const uint32_t scissorCount, const le::Rect2D *pViewports );
 
+		// extended dynamic state - only available if backend extended dynamic state level is set high enough (level >= 1, or for polygon mode & blend: level >= 3)
+		void                         ( *set_cull_mode          )( le_command_buffer_encoder_o *self, le::CullModeFlags const & cull_mode );
+		void                         ( *set_front_face         )( le_command_buffer_encoder_o *self, le::FrontFace const & front_face );
+		void                         ( *set_primitive_topology )( le_command_buffer_encoder_o *self, le::PrimitiveTopology const & topology );
+		void                         ( *set_depth_state        )( le_command_buffer_encoder_o *self, bool depth_test_enable, bool depth_write_enable, le::CompareOp const & depth_compare_op );
+		void                         ( *set_polygon_mode       )( le_command_buffer_encoder_o *self, le::PolygonMode const & polygon_mode );
+		void                         ( *set_color_blend_enable )( le_command_buffer_encoder_o *self, uint32_t attachment, bool blend_enable );
+		void                         ( *set_color_write_mask   )( le_command_buffer_encoder_o *self, uint32_t attachment, le::ColorComponentFlags const & write_mask );
+
 		void                         ( *bind_index_buffer      )( le_command_buffer_encoder_o *self, le_buf_resource_handle const bufferId, uint64_t offset, le::IndexType const & indexType);
 		void                         ( *bind_vertex_buffers    )( le_command_buffer_encoder_o *self, uint32_t firstBinding, uint32_t bindingCount, le_buf_resource_handle const * pBufferId, uint64_t const * pOffsets );
 
@@ -5,7 +5,8 @@
 #	include "le_renderer.h"
 
 namespace le {
-using Presentmode = le_swapchain_settings_t::khr_settings_t::Presentmode;
+using Presentmode  = le_swapchain_settings_t::khr_settings_t::Presentmode;
+using ImageEncoder = le_swapchain_settings_t::img_settings_t::Encoder;
 
 #	define BUILDER_IMPLEMENT( builder, method_name, param_type, param, default_value ) \
 		constexpr builder& method_name( param_type param default_value ) {              \
@@ -95,6 +96,17 @@ class RendererInfoBuilder {
 			return *this;
 		}
 
+		ImgSwapchainInfoBuilder& setDiscardImages( bool discard_images = true ) {
+			settings.discard_images = discard_images;
+			return *this;
+		}
+
+		// Images are encoded on le_jobs worker threads, one image per job - unless encoder is ePipe.
+		ImgSwapchainInfoBuilder& setEncoder( le::ImageEncoder encoder = le::ImageEncoder::ePng ) {
+			settings.encoder = encoder;
+			return *this;
+		}
+
 		auto& end() {
 			return parent;
 		}
@@ -186,6 +198,10 @@ class RendererInfoBuilder {
 		}
 	}
 
+	BUILDER_IMPLEMENT( RendererInfoBuilder, setFramesInFlight, uint32_t, frames_in_flight, = 2 )
+	BUILDER_IMPLEMENT( RendererInfoBuilder, setLowLatencyMode, bool, low_latency_mode, = true )
+	BUILDER_IMPLEMENT( RendererInfoBuilder, setUseRenderThread, bool, use_render_thread, = true )
+
 	SwapchainSettingsBuilderT<RendererInfoBuilder> addSwapchain() {
 
 		if ( initial_window ) {
@@ -392,6 +408,11 @@ class Renderer {
 		le_renderer::renderer_i.update( self, rendergraph );
 	}
 
+	/// Returns true once a headless benchmark has completed - apps should quit their update loop when this happens.
+	bool isBenchmarkComplete() const {
+		return le_renderer::renderer_i.is_benchmark_complete( self );
+	}
+
 	le_swapchain_handle addSwapchain( le_swapchain_settings_t const* swapchain_settings ) noexcept {
 		return le_renderer::renderer_i.add_swapchain( self, swapchain_settings );
 	}
@@ -400,6 +421,11 @@ class Renderer {
 		return le_renderer::renderer_i.remove_swapchain( self, swapchain );
 	}
 
+	/// Lets the renderer run your work (e.g. asset streaming) while it waits for the gpu to complete a frame.
+	void setIdleCallback( void* user_data, le_renderer_api::pfn_renderer_idle_t idle_fun ) {
+		le_renderer::renderer_i.set_idle_callback( self, user_data, idle_fun );
+	}
+
 	le_renderer_settings_t const& getSettings() const noexcept {
 		return *le_renderer::renderer_i.get_settings( self );
 	}
@@ -813,6 +839,44 @@ class GraphicsEncoder {
 		return *this;
 	}
 
+	// Extended dynamic state: these require backend setting `extended_dynamic_state_level` >= 1
+	// (>= 3 for polygon mode and colour blend). Binding a pipeline resets these to pipeline defaults.
+
+	GraphicsEncoder& setCullMode( le::CullModeFlags const& cullMode ) {
+		le_renderer::encoder_graphics_i.set_cull_mode( self, cullMode );
+		return *this;
+	}
+
+	GraphicsEncoder& setFrontFace( le::FrontFace const& frontFace ) {
+		le_renderer::encoder_graphics_i.set_front_face( self, frontFace );
+		return *this;
+	}
+
+	GraphicsEncoder& setPrimitiveTopology( le::PrimitiveTopology const& topology ) {
+		le_renderer::encoder_graphics_i.set_primitive_topology( self, topology );
+		return *this;
+	}
+
+	GraphicsEncoder& setDepthState( bool depthTestEnable, bool depthWriteEnable, le::CompareOp const& depthCompareOp ) {
+		le_renderer::encoder_graphics_i.set_depth_state( self, depthTestEnable, depthWriteEnable, depthCompareOp );
+		return *this;
+	}
+
+	GraphicsEncoder& setPolygonMode( le::PolygonMode const& polygonMode ) {
+		le_renderer::encoder_graphics_i.set_polygon_mode( self, polygonMode );
+		return *this;
+	}
+
+	GraphicsEncoder& setColorBlendEnable( uint32_t attachment, bool blendEnable ) {
+		le_renderer::encoder_graphics_i.set_color_blend_enable( self, attachment, blendEnable );
+		return *this;
+	}
+
+	GraphicsEncoder& setColorWriteMask( uint32_t attachment, le::ColorComponentFlags const& writeMask ) {
+		le_renderer::encoder_graphics_i.set_color_write_mask( self, attachment, writeMask );
+		return *this;
+	}
+
 	GraphicsEncoder& bindIndexBuffer( le_buf_resource_handle const& bufferId, uint64_t const& offset, IndexType const& indexType = IndexType::eUint16 ) {
 		le_renderer::encoder_graphics_i.bind_index_buffer( self, bufferId, offset, indexType );
 		return *this;
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "le_core.h"                             // for NoCopy, NoMove
+#include "private/le_backend_vk/le_hash_map.h" // for HashMap
+
+/*
+ * Insert-only concurrent interning table from `key` -> `value`.
+ *
+ * This is what the renderer uses to intern named resource handles and texture
+ * handles: Producing a handle for a name which was seen before must return the
+ * same handle - and this happens many times per frame, from any worker thread
+ * which runs a pass setup callback. Inserts, on the other hand, only happen the
+ * first time that a name is seen.
+ *
+ * Keys may be larger than what HashMap accepts, so we store entries in a HashMap
+ * keyed by the hash of their key. Entries whose keys hash to the same value form
+ * a chain: the first entry lives in the HashMap, and each entry links to the
+ * next. A chained entry is published by atomically storing its pointer into the
+ * previous entry *after* it was fully constructed.
+ *
+ * Lookups are therefore lock-free: `try_find` never takes a lock, and never
+ * writes to shared memory. Only `find_or_insert` takes a lock, and only if the
+ * key was not found without it.
+ *
+ * Pointers to values stay valid until the interning table gets destroyed.
+ *
+ * `Hash` must be callable with `key`, and with any needle type with which
+ * `try_find` gets called; `key` must be comparable with `==` against needles.
+ *
+ */
+template <typename K, typename V, typename Hash>
+class InternTable : NoCopy, NoMove {
+
+	struct entry_t {
+		K                     key;
+		V                     value;
+		std::atomic<entry_t*> next = nullptr; // owning: next entry with the same hash
+
+		entry_t( K const& key_, V&& value_ )
+		    : key( key_ )
+		    , value( std::move( value_ ) ) {
+		}
+
+		// HashMap stores a copy of the first entry per hash - which has no next entry yet.
+		entry_t( entry_t const& rhs )
+		    : key( rhs.key )
+		    , value( rhs.value )
+		    , next( rhs.next.load( std::memory_order_relaxed ) ) {
+		}
+	};
+
+	HashMap<uint64_t, entry_t> entries;         // first entry per hash
+	std::mutex                 mtx;             // protects num_entries, must be held for writing
+	size_t                     num_entries = 0; //
+
+	template <typename N>
+	static entry_t* chain_find( entry_t* e, N const& needle ) {
+		for ( ; e != nullptr; e = e->next.load( std::memory_order_acquire ) ) {
+			if ( e->key == needle ) {
+				return e;
+			}
+		}
+		return nullptr;
+	}
+
+  public:
+	// Looks up entry under `needle`, returns nullptr if not found.
+	// Lock-free, may be called concurrently with `find_or_insert`.
+	template <typename N>
+	V* try_find( N const& needle ) const {
+		entry_t* e = chain_find( entries.try_find( Hash()( needle ) ), needle );
+		return e ? &e->value : nullptr;
+	}
+
+	// Returns value stored under `key` - or, if there is no entry for `key`
+	// yet, inserts a new entry with value `make_value()`, and returns it.
+	//
+	// `make_value` is only called if a new entry gets inserted, and it is
+	// called with the table's lock held, so that it runs at most once per key.
+	template <typename MakeValueFn>
+	V* find_or_insert( K const& key, MakeValueFn&& make_value ) {
+
+		if ( V* v = try_find( key ) ) {
+			return v; // fast path: no lock needed
+		}
+
+		uint64_t const hash = Hash()( key );
+
+		auto lock = std::unique_lock( mtx );
+
+		entry_t* first = entries.try_find( hash );
+
+		if ( entry_t* e = chain_find( first, key ) ) {
+			return &e->value; // another thread inserted key while we were waiting for the lock
+		}
+
+		// ----------| invariant: no entry for key exists
+
+		num_entries++;
+
+		if ( nullptr == first ) {
+			entry_t e{ key, make_value() };
+			entries.try_insert( hash, &e ); // stores a copy of e
+			return &entries.try_find( hash )->value;
+		}
+
+		entry_t* last = first;
+		while ( entry_t* next = last->next.load( std::memory_order_relaxed ) ) {
+			last = next;
+		}
+
+		entry_t* e = new entry_t{ key, make_value() };
+		last->next.store( e, std::memory_order_release ); // publish: entry must be visible before pointer
+
+		return &e->value;
+	}
+
+	// Calls fun on all values. Must not be called while other threads may access the table.
+	template <typename Fn>
+	void for_each( Fn&& fun ) {
+		entries.iterator(
+		    []( entry_t* first, void* user_data ) {
+			    auto& fun = *static_cast<std::remove_reference_t<Fn>*>( user_data );
+			    for ( entry_t* e = first; e != nullptr; e = e->next.load( std::memory_order_relaxed ) ) {
+				    fun( e->value );
+			    }
+		    },
+		    &fun );
+	}
+
+	size_t size() {
+		auto lock = std::unique_lock( mtx );
+		return num_entries;
+	}
+
+	~InternTable() {
+		// First entries are owned by `entries`, we must only delete chained entries.
+		entries.iterator(
+		    []( entry_t* first, void* ) {
+			    entry_t* e = first->next.load( std::memory_order_relaxed );
+			    while ( e ) {
+				    entry_t* next = e->next.load( std::memory_order_relaxed );
+				    delete e;
+				    e = next;
+			    }
+		    },
+		    nullptr );
+	}
+};
@@ -243,7 +243,15 @@ struct le_swapchain_settings_t {
 		char const*                 display_name; // will be matched against display name
 	};
 	struct img_settings_t {
-		char const* pipe_cmd; // command used to save images - will receive stream of images via stdin
+		enum class Encoder : uint32_t {
+			ePipe = 0, // stream raw images to pipe_cmd via stdin
+			eRaw,      // write one raw .rgba file per image
+			ePng,      // write one .png file per image
+			eQoi,      // write one .qoi file per image
+		};
+		char const* pipe_cmd;       // command used to save images - will receive stream of images via stdin
+		uint32_t    discard_images; // if set, images are rendered, but not saved - pipe_cmd is ignored
+		Encoder     encoder;        // how images are saved - anything but ePipe writes image files, and ignores pipe_cmd
 	};
 
 	Type       type            = LE_KHR_SWAPCHAIN;
@@ -273,14 +281,18 @@ struct le_swapchain_settings_t {
 	}
 	void init_img_settings() {
 		this->type                  = LE_IMG_SWAPCHAIN;
-		this->img_settings.pipe_cmd = "";
+		this->img_settings.pipe_cmd       = "";
+		this->img_settings.discard_images = 0;
+		this->img_settings.encoder        = img_settings_t::Encoder::ePipe;
 	}
 };
 
 struct le_renderer_settings_t {
 	le_swapchain_settings_t swapchain_settings[ 16 ] = {}; // todo: rename this to initial_swapchain_settings; make sure that this is only accessed during renderer::setup, and not any later. convert this into a linked list!
 	size_t                  num_swapchain_settings   = 0;
-	// TODO: add a hint for number of swapchain frames
+	uint32_t                frames_in_flight         = 0;     // number of data frames, 2..4 - 0 means: use backend default. more frames mean more throughput, but also more latency
+	bool                    low_latency_mode         = false; // dispatch frames as soon as they are recorded, and delay the next frame until just before the gpu is expected to become available
+	bool                    use_render_thread        = false; // acquire, process, dispatch and clear frames on a dedicated render thread, so that update returns once a frame has been recorded
 };
 
 // specifies parameters for an image write operation.
@@ -580,6 +592,13 @@ enum class CommandType : uint32_t {
 	eBindRtxPipeline,
 	eWriteToBuffer,
 	eWriteToImage,
+	eSetCullMode,          // requires extended dynamic state level >= 1
+	eSetFrontFace,         // requires extended dynamic state level >= 1
+	eSetPrimitiveTopology, // requires extended dynamic state level >= 1
+	eSetDepthState,        // requires extended dynamic state level >= 1
+	eSetPolygonMode,       // requires extended dynamic state level >= 3
+	eSetColorBlendEnable,  // requires extended dynamic state level >= 3
+	eSetColorWriteMask,    // requires extended dynamic state level >= 3
 };
 
 struct CommandHeader {
@@ -743,6 +762,64 @@ struct CommandSetLineWidth {
 	} info;
 };
 
+struct CommandSetCullMode {
+	CommandHeader header = { { { CommandType::eSetCullMode, sizeof( CommandSetCullMode ) } } };
+	struct {
+		le::CullModeFlags cull_mode;
+		uint32_t          reserved; // padding
+	} info;
+};
+
+struct CommandSetFrontFace {
+	CommandHeader header = { { { CommandType::eSetFrontFace, sizeof( CommandSetFrontFace ) } } };
+	struct {
+		le::FrontFace front_face;
+		uint32_t      reserved; // padding
+	} info;
+};
+
+struct CommandSetPrimitiveTopology {
+	CommandHeader header = { { { CommandType::eSetPrimitiveTopology, sizeof( CommandSetPrimitiveTopology ) } } };
+	struct {
+		le::PrimitiveTopology topology; // must be of the same topology class as topology given via pipeline builder
+		uint32_t              reserved; // padding
+	} info;
+};
+
+struct CommandSetDepthState {
+	CommandHeader header = { { { CommandType::eSetDepthState, sizeof( CommandSetDepthState ) } } };
+	struct {
+		uint32_t      depth_test_enable;
+		uint32_t      depth_write_enable;
+		le::CompareOp depth_compare_op;
+		uint32_t      reserved; // padding
+	} info;
+};
+
+struct CommandSetPolygonMode {
+	CommandHeader header = { { { CommandType::eSetPolygonMode, sizeof( CommandSetPolygonMode ) } } };
+	struct {
+		le::PolygonMode polygon_mode;
+		uint32_t        reserved; // padding
+	} info;
+};
+
+struct CommandSetColorBlendEnable {
+	CommandHeader header = { { { CommandType::eSetColorBlendEnable, sizeof( CommandSetColorBlendEnable ) } } };
+	struct {
+		uint32_t attachment;
+		uint32_t blend_enable;
+	} info;
+};
+
+struct CommandSetColorWriteMask {
+	CommandHeader header = { { { CommandType::eSetColorWriteMask, sizeof( CommandSetColorWriteMask ) } } };
+	struct {
+		uint32_t                attachment;
+		le::ColorComponentFlags write_mask;
+	} info;
+};
+
 struct CommandBindVertexBuffers {
 	CommandHeader header = { { { CommandType::eBindVertexBuffers, sizeof( CommandBindVertexBuffers ) } } };
 	struct {
@@ -817,6 +894,7 @@ struct CommandWriteToImage {
 	struct {
 		le_buf_resource_handle src_buffer_id;   // le buffer id of scratch buffer
 		le_img_resource_handle dst_image_id;    // which resource to write to
+		uint64_t               src_offset;      // offset in scratch buffer where to find source data
 		uint64_t               numBytes;        // number of bytes
 		uint32_t               image_w;         // target region width in texels
 		uint32_t               image_h;         // target region height in texels
@@ -25,6 +25,7 @@ struct le_resource_handle_data_t {
 	uint8_t               flags            = 0;        // bitfield of either buffer - or img_resource_useage_flags;
 	uint16_t              index            = 0;        // allocator index if virtual buffer
 	le_resource_handle_t *reference_handle = nullptr;  // if auto-generated from another handle, we keep a reference to the parent.
+	uint32_t              slot             = 0;        // dense, stable id assigned on creation - used to index per-frame resource tables; not part of identity
 	char                  debug_name[ 48 ] = { '\0' }; // space for 47 chars + \0
 
 	bool
@@ -54,7 +55,7 @@ struct le_resource_handle_data_hash {
 
 		uint8_t     value;
 		char const *key_data_begin = reinterpret_cast<char const *>( &key );
-		char const *key_data_end   = key_data_begin + offsetof( le_resource_handle_data_t, debug_name );
+		char const *key_data_end   = key_data_begin + offsetof( le_resource_handle_data_t, slot ); // slot is not part of a handle's identity
 
 		for ( char const *i = key_data_begin; i != key_data_end; ++i ) {
 			value = static_cast<uint8_t const &>( *i );
@@ -62,7 +63,7 @@ struct le_resource_handle_data_hash {
 			hash  = hash * FNV1A_PRIME_64_CONST;
 		}
 
-		for ( char const *i = key_data_end; *i != 0; ++i ) {
+		for ( char const *i = key.debug_name; *i != 0; ++i ) {
 			value = static_cast<uint8_t const &>( *i );
 			hash  = hash ^ value;
 			hash  = hash * FNV1A_PRIME_64_CONST;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "le_core.h" // for NoCopy, NoMove
+
+/*
+ * Bounded, lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * This is how the renderer hands recorded frames from the application thread to
+ * its render thread. Items live in a ring buffer; `tail` is only ever written by
+ * the producer, and `head` is only ever written by the consumer, so that neither
+ * side needs a lock, or a compare-and-swap. The producer publishes an item by
+ * release-storing `tail` after it has written the item; the consumer acquire-loads
+ * `tail` before it reads the item - and the same in reverse for `head`, so that the
+ * producer never overwrites an item which the consumer has not read yet.
+ *
+ * The consumer may block in `wait_until_not_empty` rather than spin - this uses
+ * `std::atomic::wait`, which the producer wakes in `try_push`.
+ *
+ */
+template <typename T>
+class SpscQueue : NoCopy, NoMove {
+
+	std::vector<T> items;
+	size_t         mask; // capacity - 1, capacity is always a power of two
+
+	alignas( 64 ) std::atomic<uint64_t> head = 0; // index of next item to pop, only written by consumer
+	alignas( 64 ) std::atomic<uint64_t> tail = 0; // index of next item to push, only written by producer
+
+  public:
+	explicit SpscQueue( size_t min_capacity ) {
+		size_t capacity = 1;
+		while ( capacity < min_capacity ) {
+			capacity <<= 1;
+		}
+		items.resize( capacity );
+		mask = capacity - 1;
+	}
+
+	// Producer only. Returns false if queue is full.
+	bool try_push( T const& item ) {
+		uint64_t t = tail.load( std::memory_order_relaxed );
+		if ( t - head.load( std::memory_order_acquire ) > mask ) {
+			return false;
+		}
+		items[ t & mask ] = item;
+		tail.store( t + 1, std::memory_order_release ); // publish: item must be visible before tail
+		tail.notify_one();
+		return true;
+	}
+
+	// Consumer only. Returns false if queue is empty.
+	bool try_pop( T& item ) {
+		uint64_t h = head.load( std::memory_order_relaxed );
+		if ( h == tail.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+		item = items[ h & mask ];
+		head.store( h + 1, std::memory_order_release ); // slot may be overwritten once head has moved past it
+		return true;
+	}
+
+	// Consumer only. Blocks until there is at least one item to pop.
+	void wait_until_not_empty() const {
+		uint64_t h = head.load( std::memory_order_relaxed );
+		tail.wait( h, std::memory_order_acquire ); // returns immediately if tail != h
+	}
+};
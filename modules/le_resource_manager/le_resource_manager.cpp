@@ -2,9 +2,12 @@
 #include "le_core.h"
 #include "le_renderer.hpp"
 #include "le_pixels.h"
+#include "le_backend_vk.h"
+#include "le_log.h"
 
 #include <string>
 #include <vector>
+#include <deque>
 #include <assert.h>
 
 #include "private/le_renderer/le_resource_handle_t.inl"
@@ -16,16 +19,22 @@ struct le_resource_manager_o {
 	struct image_data_layer_t {
 		le_pixels_o* pixels;
 		std::string  path;
-		bool         was_uploaded = false;
+		bool         was_uploaded    = false;
+		uint64_t     upload_ticket   = 0; // only used when streaming: ticket for asynchronous backend upload
+		uint32_t     upload_attempts = 0; // only used when streaming: number of asynchronous uploads requested for this layer
 	};
 
 	struct resource_item_t {
 		le_img_resource_handle          image_handle;
 		le_resource_info_t              image_info;
-		std::vector<image_data_layer_t> image_layers; // must have at least one element
+		std::vector<image_data_layer_t> image_layers;       // must have at least one element
+		bool                            is_evicted = false; // evicted by residency backend: written again by a transfer pass once a pass uses the image
 	};
 
-	std::vector<resource_item_t> resources;
+	std::deque<resource_item_t> resources; // deque, so that items stay in place when items get added - re-upload passes refer to items
+
+	le_backend_o* streaming_backend = nullptr; // optional, non-owning: if set, images are streamed via asynchronous backend uploads
+	le_backend_o* residency_backend = nullptr; // optional, non-owning: if set, images may be evicted by this backend, and are then uploaded again
 };
 
 // TODO:
@@ -64,6 +73,45 @@ static bool setupTransferPass( le_renderpass_o* pRp, void* user_data ) {
 	return needsTransfer;
 }
 
+// ----------------------------------------------------------------------
+static void encode_write_image_layer( le::TransferEncoder& encoder, le_resource_manager_o::resource_item_t const& r, uint32_t layer ) {
+
+	using namespace le_pixels;
+
+	uint32_t const image_width    = r.image_info.image.extent.width;
+	uint32_t const image_height   = r.image_info.image.extent.height;
+	uint32_t const image_depth    = r.image_info.image.extent.depth;
+	uint32_t const num_mip_levels = r.image_info.image.mipLevels;
+
+	// we can fill in the correct handling for mutliple mip levels later.
+	// for now, assert that there is exatcly one mip level.
+
+	for ( uint32_t mip_level = 0; mip_level != 1; mip_level++ ) {
+
+		assert( mip_level == 0 && "mip level greater than 0 not implemented" );
+		uint32_t width  = image_width >> mip_level;
+		uint32_t height = image_height >> mip_level;
+		uint32_t depth  = image_depth;
+
+		le_write_to_image_settings_t write_info =
+		    le::WriteToImageSettingsBuilder()
+		        .setDstMiplevel( mip_level )
+		        .setNumMiplevels( num_mip_levels )
+		        .setArrayLayer( layer ) // faces are indexed: +x, -x, +y, -y, +z, -z
+		        .setImageH( height )
+		        .setImageW( width )
+		        .setImageD( depth )
+		        .build();
+
+		auto     pixels    = r.image_layers[ layer ].pixels;
+		auto     info      = le_pixels_i.get_info( pixels );
+		uint32_t num_bytes = info.byte_count; // TODO: make sure to get correct byte count for mip level, or compressed image.
+		void*    bytes     = le_pixels_i.get_data( pixels );
+
+		encoder.writeToImage( r.image_handle, write_info, bytes, num_bytes );
+	}
+}
+
 // ----------------------------------------------------------------------
 static void execTransferPass( le_command_buffer_encoder_o* pEncoder, void* user_data ) {
 	le::TransferEncoder encoder{ pEncoder };
@@ -74,55 +122,171 @@ static void execTransferPass( le_command_buffer_encoder_o* pEncoder, void* user_
 
 	// First figure out whether we must write to an image at all
 
-	using namespace le_pixels;
-
 	for ( auto& r : manager->resources ) {
 
-		uint32_t const num_layers     = uint32_t( r.image_layers.size() );
-		uint32_t const image_width    = r.image_info.image.extent.width;
-		uint32_t const image_height   = r.image_info.image.extent.height;
-		uint32_t const image_depth    = r.image_info.image.extent.depth;
-		uint32_t const num_mip_levels = r.image_info.image.mipLevels;
+		uint32_t const num_layers = uint32_t( r.image_layers.size() );
 
 		for ( uint32_t layer = 0; layer != num_layers; layer++ ) {
 
-			// we can fill in the correct handling for mutliple mip levels later.
-			// for now, assert that there is exatcly one mip level.
 			if ( r.image_layers[ layer ].was_uploaded ) {
 				continue;
 			}
 
 			// --------| invariant: layer was not yet uploaded.
 
-			for ( uint32_t mip_level = 0; mip_level != 1; mip_level++ ) {
-
-				assert( mip_level == 0 && "mip level greater than 0 not implemented" );
-				uint32_t width  = image_width >> mip_level;
-				uint32_t height = image_height >> mip_level;
-				uint32_t depth  = image_depth;
-
-				le_write_to_image_settings_t write_info =
-				    le::WriteToImageSettingsBuilder()
-				        .setDstMiplevel( mip_level )
-				        .setNumMiplevels( num_mip_levels )
-				        .setArrayLayer( layer ) // faces are indexed: +x, -x, +y, -y, +z, -z
-				        .setImageH( height )
-				        .setImageW( width )
-				        .setImageD( depth )
-				        .build();
-
-				auto     pixels    = r.image_layers[ layer ].pixels;
-				auto     info      = le_pixels_i.get_info( pixels );
-				uint32_t num_bytes = info.byte_count; // TODO: make sure to get correct byte count for mip level, or compressed image.
-				void*    bytes     = le_pixels_i.get_data( pixels );
-
-				encoder.writeToImage( r.image_handle, write_info, bytes, num_bytes );
-			}
+			encode_write_image_layer( encoder, r, layer );
 			r.image_layers[ layer ].was_uploaded = true;
 		}
 	}
 }
 
+// ----------------------------------------------------------------------
+// There is one re-upload pass per evicted image, so that the rendergraph drops
+// the pass - and with it, the upload - unless another pass reads from the image.
+static bool setupReuploadPass( le_renderpass_o* pRp, void* user_data ) {
+	le::RenderPass rp{ pRp };
+	auto           r = static_cast<le_resource_manager_o::resource_item_t const*>( user_data );
+
+	rp.useImageResource( r->image_handle, le::AccessFlagBits2::eTransferWrite );
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Only gets called if a pass in this frame uses the evicted image.
+static void execReuploadPass( le_command_buffer_encoder_o* pEncoder, void* user_data ) {
+	le::TransferEncoder encoder{ pEncoder };
+	auto                r = static_cast<le_resource_manager_o::resource_item_t*>( user_data );
+
+	uint32_t const num_layers = uint32_t( r->image_layers.size() );
+
+	for ( uint32_t layer = 0; layer != num_layers; layer++ ) {
+		encode_write_image_layer( encoder, *r, layer );
+	}
+
+	r->is_evicted = false;
+}
+
+// ----------------------------------------------------------------------
+
+static bool resource_item_is_ready( le_resource_manager_o::resource_item_t const& r ) {
+	for ( auto const& layer : r.image_layers ) {
+		if ( layer.was_uploaded == false ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Requests asynchronous uploads for any layers which were not yet requested,
+// and marks layers as uploaded once their uploads have completed.
+//
+// Failed uploads are requested again, up to MAX_UPLOAD_ATTEMPTS times per layer - after
+// that, the layer is given up on, and its image never becomes ready.
+static void le_resource_manager_stream_items( le_resource_manager_o* manager ) {
+
+	static constexpr uint32_t MAX_UPLOAD_ATTEMPTS = 3;
+
+	static auto logger = LeLog( "le_resource_manager" );
+
+	using namespace le_pixels;
+	using namespace le_backend_vk;
+
+	for ( auto& r : manager->resources ) {
+
+		uint32_t const num_layers = uint32_t( r.image_layers.size() );
+
+		for ( uint32_t layer = 0; layer != num_layers; layer++ ) {
+
+			auto& layer_data = r.image_layers[ layer ];
+
+			if ( layer_data.was_uploaded ) {
+				continue;
+			}
+
+			if ( layer_data.upload_ticket != 0 ) {
+				switch ( vk_backend_i.get_upload_status( manager->streaming_backend, layer_data.upload_ticket ) ) {
+				case le_upload_status_t::ePending:
+					break;
+				case le_upload_status_t::eComplete:
+					layer_data.was_uploaded = true;
+					break;
+				case le_upload_status_t::eFailed:
+					// Image was never written to - we request the upload again with the next update, unless we ran out of attempts.
+					layer_data.upload_ticket = 0;
+					if ( layer_data.upload_attempts < MAX_UPLOAD_ATTEMPTS ) {
+						logger.warn( "Upload failed for image '%s', layer %d - will retry.", layer_data.path.c_str(), layer );
+					} else {
+						logger.error( "Upload failed for image '%s', layer %d - giving up after %d attempts.", layer_data.path.c_str(), layer, layer_data.upload_attempts );
+					}
+					break;
+				}
+				continue;
+			}
+
+			if ( layer_data.upload_attempts >= MAX_UPLOAD_ATTEMPTS ) {
+				continue;
+			}
+
+			// --------| invariant: layer was not yet requested for upload.
+
+			layer_data.upload_attempts++;
+
+			le_write_to_image_settings_t write_info =
+			    le::WriteToImageSettingsBuilder()
+			        .setDstMiplevel( 0 )
+			        .setNumMiplevels( r.image_info.image.mipLevels )
+			        .setArrayLayer( layer ) // faces are indexed: +x, -x, +y, -y, +z, -z
+			        .setImageH( r.image_info.image.extent.height )
+			        .setImageW( r.image_info.image.extent.width )
+			        .setImageD( r.image_info.image.extent.depth )
+			        .build();
+
+			auto info = le_pixels_i.get_info( layer_data.pixels );
+
+			// We pass image info with each layer so that the backend may allocate the image for whichever layer comes first.
+			layer_data.upload_ticket =
+			    vk_backend_i.upload_to_image( manager->streaming_backend, r.image_handle, &r.image_info, &write_info,
+			                                  le_pixels_i.get_data( layer_data.pixels ), info.byte_count );
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+// Marks images which the residency backend has evicted as evicted - these get written
+// again from their retained pixels only once a pass uses them again. Until then, nothing
+// uses the image, and the backend is free to release its memory.
+static void le_resource_manager_mark_evicted_items( le_resource_manager_o* manager ) {
+
+	using namespace le_backend_vk;
+
+	for ( auto& r : manager->resources ) {
+		if ( vk_backend_i.was_image_evicted( manager->residency_backend, r.image_handle ) ) {
+			r.is_evicted = true;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+
+static void le_resource_manager_add_reupload_passes( le_resource_manager_o* manager, le_rendergraph_o* module ) {
+	using namespace le_renderer;
+
+	for ( auto& r : manager->resources ) {
+		if ( !r.is_evicted ) {
+			continue;
+		}
+		auto renderPassReupload =
+		    le::RenderPass( "xfer_le_resource_manager_reupload", le::QueueFlagBits::eTransfer )
+		        .setSetupCallback( &r, setupReuploadPass ) //
+		        .setExecuteCallback( &r, execReuploadPass ) //
+		    ;
+
+		rendergraph_i.add_renderpass( module, renderPassReupload );
+	}
+}
+
 // ----------------------------------------------------------------------
 
 static void le_resource_manager_update( le_resource_manager_o* manager, le_rendergraph_o* module ) {
@@ -130,6 +294,27 @@ static void le_resource_manager_update( le_resource_manager_o* manager, le_rende
 
 	// TODO: reload any images if you detect that their source on disk has changed.
 
+	if ( manager->residency_backend ) {
+		le_resource_manager_mark_evicted_items( manager );
+	}
+
+	le_resource_manager_add_reupload_passes( manager, module );
+
+	if ( manager->streaming_backend ) {
+
+		le_resource_manager_stream_items( manager );
+
+		// Only declare images once they have been uploaded: until then, they must not be used.
+		// Evicted images stay declared: using them is what triggers their re-upload.
+		for ( auto& r : manager->resources ) {
+			if ( resource_item_is_ready( r ) ) {
+				rendergraph_i.declare_resource( module, r.image_handle, r.image_info );
+			}
+		}
+
+		return;
+	}
+
 	for ( auto& r : manager->resources ) {
 		rendergraph_i.declare_resource( module, r.image_handle, r.image_info );
 	}
@@ -217,11 +402,52 @@ static void le_resource_manager_add_item( le_resource_manager_o*        self,
 	        item.image_info.image.extent.depth != 0 &&
 	        "Image extents for resource are not valid." );
 
+	if ( self->residency_backend ) {
+		le_backend_vk::vk_backend_i.set_image_evictable( self->residency_backend, item.image_handle, true );
+	}
+
 	self->resources.emplace_back( item );
 }
 
 // ----------------------------------------------------------------------
 
+static void le_resource_manager_set_streaming_backend( le_resource_manager_o* self, le_backend_o* backend ) {
+	self->streaming_backend = backend;
+}
+
+// ----------------------------------------------------------------------
+// Registers all images as evictable with backend - and unregisters them from
+// any previous residency backend. Set backend to nullptr to turn off eviction.
+static void le_resource_manager_set_residency_backend( le_resource_manager_o* self, le_backend_o* backend ) {
+
+	using namespace le_backend_vk;
+
+	for ( auto const& r : self->resources ) {
+		if ( self->residency_backend ) {
+			vk_backend_i.set_image_evictable( self->residency_backend, r.image_handle, false );
+		}
+		if ( backend ) {
+			vk_backend_i.set_image_evictable( backend, r.image_handle, true );
+		}
+	}
+
+	self->residency_backend = backend;
+}
+
+// ----------------------------------------------------------------------
+// Returns true if all layers of the image have been uploaded - always returns false
+// for images which are not managed by this resource manager.
+static bool le_resource_manager_is_item_ready( le_resource_manager_o* self, le_img_resource_handle const* image_handle ) {
+	for ( auto const& r : self->resources ) {
+		if ( r.image_handle == *image_handle ) {
+			return resource_item_is_ready( r );
+		}
+	}
+	return false;
+}
+
+// ----------------------------------------------------------------------
+
 static le_resource_manager_o* le_resource_manager_create() {
 	auto self = new le_resource_manager_o{};
 	return self;
@@ -253,4 +479,8 @@ LE_MODULE_REGISTER_IMPL( le_resource_manager, api ) {
 	le_resource_manager_i.destroy  = le_resource_manager_destroy;
 	le_resource_manager_i.update   = le_resource_manager_update;
 	le_resource_manager_i.add_item = le_resource_manager_add_item;
+
+	le_resource_manager_i.set_streaming_backend = le_resource_manager_set_streaming_backend;
+	le_resource_manager_i.is_item_ready         = le_resource_manager_is_item_ready;
+	le_resource_manager_i.set_residency_backend = le_resource_manager_set_residency_backend;
 }
@@ -43,6 +43,37 @@ Call update with the rendermodule you want to use the resources with.
 
 * * *
 
+If you want images to be uploaded in the background, over the next frames,
+instead of with the first frame which uses them, set a streaming backend:
+
+    // In app.setup():
+
+        app->resource_manager.set_streaming_backend( le_renderer::renderer_i.get_backend( app->renderer ) );
+
+    // In app.update():
+
+        if ( app->resource_manager.is_item_ready( image_handle ) ) {
+            // only now may passes use image_handle
+        }
+
+Streamed images are only declared to the rendermodule once they are ready.
+
+* * *
+
+If you load more images than fit into GPU memory, set a residency backend:
+
+    // In app.setup():
+
+        app->resource_manager.set_residency_backend( le_renderer::renderer_i.get_backend( app->renderer ) );
+
+The backend may then evict images which no pass has used for a while, once
+device-local memory exceeds its budget (see LE_SETTING_BACKEND_MEMORY_BUDGET_MB).
+ResourceManager keeps the pixels for each image, and keeps declaring evicted
+images: it uploads an evicted image again only once a pass uses it again, in
+the same frame, before that pass.
+
+* * *
+
 If you want to upload multiple layers for images - for cubemap images for example -
 you can specify multiple paths. NOTE you must specify the number of image array layers
 when you specify the image info for the resource
@@ -76,6 +107,7 @@ when you specify the image info for the resource
 struct le_resource_manager_o;
 struct le_rendergraph_o; // ffdecl. (from le_renderer)
 struct le_resource_info_t; // ffdecl. (from le_renderer)
+struct le_backend_o; // ffdecl. (from le_backend_vk)
 
 LE_OPAQUE_HANDLE( le_img_resource_handle ); // declared in le_renderer.h
 
@@ -89,6 +121,10 @@ struct le_resource_manager_api {
 		void                     ( * update    ) ( le_resource_manager_o* self, le_rendergraph_o* module );
         void                     ( * add_item  ) ( le_resource_manager_o* self, le_img_resource_handle const * image_handle, le_resource_info_t const * image_info, char const * const * arr_image_paths);
 
+		void                     ( * set_streaming_backend ) ( le_resource_manager_o* self, le_backend_o* backend );
+		bool                     ( * is_item_ready         ) ( le_resource_manager_o* self, le_img_resource_handle const * image_handle );
+		void                     ( * set_residency_backend ) ( le_resource_manager_o* self, le_backend_o* backend );
+
 	};
 
 	le_resource_manager_interface_t       le_resource_manager_i;
@@ -126,6 +162,18 @@ class LeResourceManager : NoCopy, NoMove {
 		le_resource_manager::le_resource_manager_i.add_item( self, &image_handle, &image_info, arr_image_paths );
 	}
 
+	void set_streaming_backend( le_backend_o* backend ) {
+		le_resource_manager::le_resource_manager_i.set_streaming_backend( self, backend );
+	}
+
+	bool is_item_ready( le_img_resource_handle const& image_handle ) {
+		return le_resource_manager::le_resource_manager_i.is_item_ready( self, &image_handle );
+	}
+
+	void set_residency_backend( le_backend_o* backend ) {
+		le_resource_manager::le_resource_manager_i.set_residency_backend( self, backend );
+	}
+
 	operator auto() {
 		return self;
 	}
@@ -3,6 +3,7 @@
 
 #include "shaderc/shaderc.hpp"
 #include "le_log.h"
+#include "le_hash_util.h"
 #include "private/le_renderer/le_renderer_types.h" // for shader type
 
 #include <iomanip>
@@ -19,9 +20,24 @@
 
 static constexpr auto LOGGER_LABEL = "le_shader_compiler";
 
+// Options which le_shader_compiler applies to every compilation. We keep these
+// in one place, so that they can be hashed - anyone caching compiler output
+// must know when options have changed.
+struct le_shader_compiler_settings_t {
+	uint32_t generate_debug_info;  // bool
+	uint32_t optimization_level;   // shaderc_optimization_level
+	uint32_t target_env;           // shaderc_target_env
+	uint32_t target_env_version;   // shaderc_env_version
+	uint32_t target_spirv_version; // shaderc_spirv_version
+	uint32_t spv_version;          // spir-v version supported by shaderc, as reported by shaderc_get_spv_version
+	uint32_t spv_revision;         // spir-v revision supported by shaderc, as reported by shaderc_get_spv_version
+};
+
 struct le_shader_compiler_o {
-	shaderc_compiler_t        compiler;
-	shaderc_compile_options_t options;
+	shaderc_compiler_t            compiler;
+	shaderc_compile_options_t     options;
+	le_shader_compiler_settings_t settings;
+	uint64_t                      compiler_fingerprint; // hash over spir-v which this compiler generates for a probe shader - changes with the compiler version
 };
 
 // ---------------------------------------------------------------
@@ -155,6 +171,44 @@ static bool le_shader_compilation_result_get_result_success( le_shader_compilati
 	return shaderc_result_get_compilation_status( res->result ) == shaderc_compilation_status_success;
 }
 
+// ---------------------------------------------------------------
+// Shaderc has no way to query its version - and neither the version of the glslang
+// which it wraps. We therefore compile a small probe shader, and hash the spir-v which
+// we get: its header holds the generator version, and its code changes whenever
+// a compiler update changes code generation.
+static uint64_t le_shader_compiler_calculate_fingerprint( le_shader_compiler_o* self ) {
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	static constexpr char probe_source[] =
+	    "#version 450\n"
+	    "layout( local_size_x = 8 ) in;\n"
+	    "layout( std430, binding = 0 ) buffer Data { vec4 values[]; };\n"
+	    "void main() {\n"
+	    "    uint i = gl_GlobalInvocationID.x;\n"
+	    "    values[ i ] = normalize( values[ i ] ) * inversesqrt( float( i + 1 ) );\n"
+	    "}\n";
+
+	shaderc_compilation_result_t result =
+	    shaderc_compile_into_spv( self->compiler, probe_source, sizeof( probe_source ) - 1,
+	                              shaderc_compute_shader, "le_shader_compiler_probe", "main", self->options );
+
+	uint64_t hash = FNV1A_VAL_64_CONST;
+
+	if ( shaderc_result_get_compilation_status( result ) == shaderc_compilation_status_success ) {
+		auto const bytes     = reinterpret_cast<uint8_t const*>( shaderc_result_get_bytes( result ) );
+		size_t     num_bytes = shaderc_result_get_length( result );
+		for ( size_t i = 0; i != num_bytes; i++ ) {
+			hash = ( hash ^ bytes[ i ] ) * FNV1A_PRIME_64_CONST;
+		}
+	} else {
+		logger.warn( "Could not compile shader compiler probe: %s", shaderc_result_get_error_message( result ) );
+	}
+
+	shaderc_result_release( result );
+
+	return hash;
+}
+
 // ---------------------------------------------------------------
 
 static le_shader_compiler_o* le_shader_compiler_create() {
@@ -162,15 +216,57 @@ static le_shader_compiler_o* le_shader_compiler_create() {
 	obj->compiler = shaderc_compiler_initialize();
 
 	{
+		auto& settings = obj->settings;
+
+		settings.generate_debug_info  = 1;
+		settings.optimization_level   = shaderc_optimization_level_performance;
+		settings.target_env           = shaderc_target_env_vulkan;
+		settings.target_env_version   = shaderc_env_version_vulkan_1_2;
+		settings.target_spirv_version = shaderc_spirv_version_1_5;
+
+		unsigned int spv_version  = 0;
+		unsigned int spv_revision = 0;
+		shaderc_get_spv_version( &spv_version, &spv_revision );
+		settings.spv_version  = spv_version;
+		settings.spv_revision = spv_revision;
+	}
+
+	{
+		auto const& settings = obj->settings;
+
 		obj->options = shaderc_compile_options_initialize();
-		shaderc_compile_options_set_generate_debug_info( obj->options );
+		if ( settings.generate_debug_info ) {
+			shaderc_compile_options_set_generate_debug_info( obj->options );
+		}
 		shaderc_compile_options_set_source_language( obj->options, shaderc_source_language::shaderc_source_language_glsl );
-		shaderc_compile_options_set_optimization_level( obj->options, shaderc_optimization_level_performance );
+		shaderc_compile_options_set_optimization_level( obj->options, shaderc_optimization_level( settings.optimization_level ) );
+		shaderc_compile_options_set_target_env( obj->options, shaderc_target_env( settings.target_env ), settings.target_env_version );
+		shaderc_compile_options_set_target_spirv( obj->options, shaderc_spirv_version( settings.target_spirv_version ) );
 	}
 
+	obj->compiler_fingerprint = le_shader_compiler_calculate_fingerprint( obj );
+
 	return obj;
 }
 
+// ---------------------------------------------------------------
+// Returns a hash over all options which this compiler applies to every compilation,
+// and over the compiler version. Per-compilation inputs (source, stage, language,
+// macro definitions) are not included.
+static uint64_t le_shader_compiler_get_options_hash( le_shader_compiler_o* self ) {
+
+	uint64_t           hash  = self->compiler_fingerprint;
+	constexpr uint64_t prime = FNV1A_PRIME_64_CONST;
+
+	auto const bytes = reinterpret_cast<uint8_t const*>( &self->settings );
+
+	for ( size_t i = 0; i != sizeof( le_shader_compiler_settings_t ); i++ ) {
+		hash = ( hash ^ bytes[ i ] ) * prime;
+	}
+
+	return hash;
+}
+
 // ---------------------------------------------------------------
 
 static void le_shader_compiler_destroy( le_shader_compiler_o* self ) {
@@ -532,9 +628,6 @@ static bool le_shader_compiler_compile_source(
 	    le_shaderc_include_result_destroy,
 	    &result->includes );
 
-	shaderc_compile_options_set_target_env( local_options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2 );
-	shaderc_compile_options_set_target_spirv( local_options, shaderc_spirv_version_1_5 );
-
 	// -- Preprocess GLSL source - this will expand macros and includes
 	auto preprocessorResult =
 	    shaderc_compile_into_preprocessed_text(
@@ -607,6 +700,8 @@ LE_MODULE_REGISTER_IMPL( le_shader_compiler, api_ ) {
 	compiler_i.destroy        = le_shader_compiler_destroy;
 	compiler_i.compile_source = le_shader_compiler_compile_source;
 
+	compiler_i.get_options_hash = le_shader_compiler_get_options_hash;
+
 	compiler_i.result_create       = le_shader_compilation_result_create;
 	compiler_i.result_get_bytes    = le_shader_compilation_result_get_result_bytes;
 	compiler_i.result_get_success  = le_shader_compilation_result_get_result_success;
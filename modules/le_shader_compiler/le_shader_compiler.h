@@ -23,6 +23,9 @@ struct le_shader_compiler_api {
 
 		bool                            (* compile_source        ) ( le_shader_compiler_o *compiler, const char *sourceText, size_t sourceTextSize, const LeShaderSourceLanguageEnum& shader_source_language, const le::ShaderStageFlagBits& shaderType, const char *original_file_path, char const * macroDefinitionsStr, size_t macroDefinitionsStrSz, le_shader_compilation_result_o* result );
 
+        // hash over options which the compiler applies to every compilation - changes whenever compiler output for the same inputs may change
+		uint64_t                        (* get_options_hash      ) ( le_shader_compiler_o *compiler );
+
         // create a compilation result object - this is needed for compile_source 
 		le_shader_compilation_result_o* (* result_create         ) ( );
 		
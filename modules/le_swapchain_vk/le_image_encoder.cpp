@@ -0,0 +1,509 @@
+#include "private/le_swapchain_vk/le_image_encoder.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "le_tracy.h"
+
+// ----------------------------------------------------------------------
+
+static inline void put_u32_be( std::vector<uint8_t>& out, uint32_t v ) {
+	out.push_back( uint8_t( v >> 24 ) );
+	out.push_back( uint8_t( v >> 16 ) );
+	out.push_back( uint8_t( v >> 8 ) );
+	out.push_back( uint8_t( v ) );
+}
+
+// ----------------------------------------------------------------------
+// Copies one row of source pixels into dst as rgba.
+static void image_encoder_load_row( le_image_encoder_source_t const& src, uint32_t y, uint8_t* dst ) {
+	uint8_t const* row        = src.pixels + size_t( y ) * src.width * 4;
+	size_t const   row_stride = size_t( src.width ) * 4;
+
+	if ( !src.is_bgra ) {
+		memcpy( dst, row, row_stride );
+		return;
+	}
+
+	for ( size_t i = 0; i != row_stride; i += 4 ) {
+		dst[ i + 0 ] = row[ i + 2 ];
+		dst[ i + 1 ] = row[ i + 1 ];
+		dst[ i + 2 ] = row[ i + 0 ];
+		dst[ i + 3 ] = row[ i + 3 ];
+	}
+}
+
+// ----------------------------------------------------------------------
+// PNG
+// ----------------------------------------------------------------------
+
+static uint32_t crc32_update( uint32_t crc, uint8_t const* data, size_t num_bytes ) {
+
+	struct crc_table_t {
+		uint32_t entries[ 256 ];
+		crc_table_t() {
+			for ( uint32_t n = 0; n != 256; n++ ) {
+				uint32_t c = n;
+				for ( int k = 0; k != 8; k++ ) {
+					c = ( c & 1 ) ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+				}
+				entries[ n ] = c;
+			}
+		}
+	};
+
+	static const crc_table_t table;
+
+	crc = ~crc;
+	for ( size_t i = 0; i != num_bytes; i++ ) {
+		crc = table.entries[ ( crc ^ data[ i ] ) & 0xff ] ^ ( crc >> 8 );
+	}
+	return ~crc;
+}
+
+// ----------------------------------------------------------------------
+
+static uint32_t adler32( uint8_t const* data, size_t num_bytes ) {
+	uint32_t a = 1;
+	uint32_t b = 0;
+	while ( num_bytes ) {
+		// 5552 is the largest number of bytes for which b can't overflow before we take the modulo.
+		size_t n = std::min<size_t>( num_bytes, 5552 );
+		num_bytes -= n;
+		while ( n-- ) {
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return ( b << 16 ) | a;
+}
+
+// ----------------------------------------------------------------------
+
+static inline uint8_t paeth_predictor( int a, int b, int c ) {
+	int p  = a + b - c;
+	int pa = abs( p - a );
+	int pb = abs( p - b );
+	int pc = abs( p - c );
+	if ( pa <= pb && pa <= pc ) {
+		return uint8_t( a );
+	}
+	return uint8_t( pb <= pc ? b : c );
+}
+
+// ----------------------------------------------------------------------
+// Turns source pixels into PNG scanlines: one filter type byte, followed by the filtered row.
+// For each row, we pick whichever of the Sub, Up, and Paeth filters gives the smallest sum of
+// absolute (signed) residuals - the heuristic which the PNG specification recommends.
+static void png_filter_rows( le_image_encoder_source_t const& src, std::vector<uint8_t>& scanlines ) {
+
+	ZoneScoped;
+
+	size_t const row_stride = size_t( src.width ) * 4;
+
+	scanlines.resize( ( row_stride + 1 ) * src.height );
+
+	std::vector<uint8_t> rows( row_stride * 2, 0 );  // previous row, and current row - previous row is zero for first row
+	std::vector<uint8_t> filtered( row_stride * 3 ); // candidate rows: sub, up, paeth
+
+	uint8_t* prev = rows.data();
+	uint8_t* cur  = rows.data() + row_stride;
+
+	uint8_t* const sub   = filtered.data();
+	uint8_t* const up    = filtered.data() + row_stride;
+	uint8_t* const paeth = filtered.data() + row_stride * 2;
+
+	static constexpr uint8_t FILTER_TYPES[ 3 ] = { 1, 2, 4 }; // sub, up, paeth
+
+	uint8_t* dst = scanlines.data();
+
+	for ( uint32_t y = 0; y != src.height; y++ ) {
+
+		image_encoder_load_row( src, y, cur );
+
+		uint64_t cost[ 3 ] = {};
+
+		for ( size_t i = 0; i != row_stride; i++ ) {
+			int x = cur[ i ];
+			int a = i >= 4 ? cur[ i - 4 ] : 0;  // left
+			int b = prev[ i ];                  // above
+			int c = i >= 4 ? prev[ i - 4 ] : 0; // above left
+
+			sub[ i ]   = uint8_t( x - a );
+			up[ i ]    = uint8_t( x - b );
+			paeth[ i ] = uint8_t( x - paeth_predictor( a, b, c ) );
+
+			cost[ 0 ] += abs( int8_t( sub[ i ] ) );
+			cost[ 1 ] += abs( int8_t( up[ i ] ) );
+			cost[ 2 ] += abs( int8_t( paeth[ i ] ) );
+		}
+
+		size_t best = 0;
+		for ( size_t f = 1; f != 3; f++ ) {
+			if ( cost[ f ] < cost[ best ] ) {
+				best = f;
+			}
+		}
+
+		*dst++ = FILTER_TYPES[ best ];
+		memcpy( dst, filtered.data() + row_stride * best, row_stride );
+		dst += row_stride;
+
+		std::swap( prev, cur );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Deflate (RFC 1951), using a single block with fixed Huffman codes.
+//
+// Fixed codes mean that we don't have to gather symbol statistics, nor build
+// and transmit code tables, so that we can emit symbols as soon as we find them.
+
+static constexpr uint16_t DEFLATE_LENGTH_BASE[ 29 ]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr uint8_t  DEFLATE_LENGTH_EXTRA[ 29 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr uint16_t DEFLATE_DIST_BASE[ 30 ]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr uint8_t  DEFLATE_DIST_EXTRA[ 30 ]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static constexpr uint32_t DEFLATE_WINDOW_SIZE = 32768;
+static constexpr uint32_t DEFLATE_MIN_MATCH   = 3;
+static constexpr uint32_t DEFLATE_MAX_MATCH   = 258;
+static constexpr uint32_t DEFLATE_HASH_BITS   = 15;
+
+struct deflate_tables_t {
+	uint16_t lit_code[ 288 ];      // fixed literal/length codes, bit-reversed, so that we can write them lsb first
+	uint8_t  lit_bits[ 288 ];      // number of bits per literal/length code
+	uint8_t  dist_code[ 30 ];      // fixed distance codes (5 bits each), bit-reversed
+	uint8_t  length_symbol[ 259 ]; // match length -> index into DEFLATE_LENGTH_BASE
+	uint8_t  dist_symbol_lo[ 257 ]; // distance 1..256 -> index into DEFLATE_DIST_BASE
+	uint8_t  dist_symbol_hi[ 256 ]; // ( distance - 1 ) >> 7, for distance > 256 -> index into DEFLATE_DIST_BASE
+
+	static uint32_t reverse_bits( uint32_t code, uint32_t num_bits ) {
+		uint32_t result = 0;
+		for ( uint32_t i = 0; i != num_bits; i++ ) {
+			result = ( result << 1 ) | ( code & 1 );
+			code >>= 1;
+		}
+		return result;
+	}
+
+	deflate_tables_t() {
+		for ( uint32_t s = 0; s != 288; s++ ) {
+			uint32_t code, bits;
+			if ( s < 144 ) {
+				code = 0x30 + s, bits = 8;
+			} else if ( s < 256 ) {
+				code = 0x190 + ( s - 144 ), bits = 9;
+			} else if ( s < 280 ) {
+				code = s - 256, bits = 7;
+			} else {
+				code = 0xc0 + ( s - 280 ), bits = 8;
+			}
+			lit_code[ s ] = uint16_t( reverse_bits( code, bits ) );
+			lit_bits[ s ] = uint8_t( bits );
+		}
+
+		for ( uint32_t s = 0; s != 30; s++ ) {
+			dist_code[ s ] = uint8_t( reverse_bits( s, 5 ) );
+		}
+
+		for ( uint32_t s = 0; s != 29; s++ ) {
+			uint32_t last = s + 1 < 29 ? DEFLATE_LENGTH_BASE[ s + 1 ] - 1 : DEFLATE_MAX_MATCH;
+			for ( uint32_t len = DEFLATE_LENGTH_BASE[ s ]; len <= last; len++ ) {
+				length_symbol[ len ] = uint8_t( s );
+			}
+		}
+
+		for ( uint32_t s = 0; s != 30; s++ ) {
+			uint32_t last = s + 1 < 30 ? DEFLATE_DIST_BASE[ s + 1 ] - 1 : DEFLATE_WINDOW_SIZE;
+			for ( uint32_t dist = DEFLATE_DIST_BASE[ s ]; dist <= last; dist++ ) {
+				if ( dist <= 256 ) {
+					dist_symbol_lo[ dist ] = uint8_t( s );
+				} else {
+					dist_symbol_hi[ ( dist - 1 ) >> 7 ] = uint8_t( s );
+				}
+			}
+		}
+	}
+};
+
+// ----------------------------------------------------------------------
+
+class DeflateBitWriter {
+	std::vector<uint8_t>& out;
+	uint64_t              bits     = 0;
+	uint32_t              num_bits = 0;
+
+  public:
+	explicit DeflateBitWriter( std::vector<uint8_t>& out_ )
+	    : out( out_ ) {
+	}
+
+	// Appends lowest `count` bits of `value`, lsb first.
+	void put( uint32_t value, uint32_t count ) {
+		bits |= uint64_t( value ) << num_bits;
+		num_bits += count;
+		if ( num_bits >= 32 ) {
+			out.push_back( uint8_t( bits ) );
+			out.push_back( uint8_t( bits >> 8 ) );
+			out.push_back( uint8_t( bits >> 16 ) );
+			out.push_back( uint8_t( bits >> 24 ) );
+			bits >>= 32;
+			num_bits -= 32;
+		}
+	}
+
+	// Writes any pending bits, padded with zeroes to the next byte boundary.
+	void flush() {
+		while ( num_bits > 0 ) {
+			out.push_back( uint8_t( bits ) );
+			bits >>= 8;
+			num_bits = num_bits > 8 ? num_bits - 8 : 0;
+		}
+		bits = 0;
+	}
+};
+
+// ----------------------------------------------------------------------
+
+static inline uint32_t deflate_hash( uint8_t const* p ) {
+	uint32_t v = uint32_t( p[ 0 ] ) | ( uint32_t( p[ 1 ] ) << 8 ) | ( uint32_t( p[ 2 ] ) << 16 );
+	return ( v * 2654435761u ) >> ( 32 - DEFLATE_HASH_BITS );
+}
+
+// ----------------------------------------------------------------------
+// Compresses data, and appends it to out as a raw deflate stream.
+//
+// We find matches greedily: for each position, the hash table holds the most recent
+// position with the same first three bytes, and we take whatever match this gives us.
+// This misses many matches which zlib would find, but costs one lookup per byte.
+static void deflate_fixed( uint8_t const* data, size_t num_bytes, std::vector<uint8_t>& out ) {
+
+	ZoneScoped;
+
+	static const deflate_tables_t tables;
+
+	DeflateBitWriter writer( out );
+
+	writer.put( 1, 1 ); // BFINAL: this is the last block
+	writer.put( 1, 2 ); // BTYPE : fixed Huffman codes
+
+	std::vector<uint32_t> head( size_t( 1 ) << DEFLATE_HASH_BITS, 0 ); // per hash: 1 + most recent position, 0 if none
+
+	auto put_literal = [ & ]( uint8_t b ) {
+		writer.put( tables.lit_code[ b ], tables.lit_bits[ b ] );
+	};
+
+	size_t i = 0;
+
+	while ( i + DEFLATE_MIN_MATCH <= num_bytes ) {
+
+		uint32_t h         = deflate_hash( data + i );
+		size_t   candidate = head[ h ];
+		head[ h ]          = uint32_t( i + 1 );
+
+		if ( candidate != 0 ) {
+			candidate -= 1;
+			size_t dist = i - candidate;
+
+			if ( dist <= DEFLATE_WINDOW_SIZE && 0 == memcmp( data + candidate, data + i, DEFLATE_MIN_MATCH ) ) {
+
+				size_t max_len = std::min<size_t>( DEFLATE_MAX_MATCH, num_bytes - i );
+				size_t len     = DEFLATE_MIN_MATCH;
+
+				while ( len < max_len && data[ candidate + len ] == data[ i + len ] ) {
+					len++;
+				}
+
+				uint32_t ls = tables.length_symbol[ len ];
+				writer.put( tables.lit_code[ 257 + ls ], tables.lit_bits[ 257 + ls ] );
+				writer.put( uint32_t( len - DEFLATE_LENGTH_BASE[ ls ] ), DEFLATE_LENGTH_EXTRA[ ls ] );
+
+				uint32_t ds = dist <= 256 ? tables.dist_symbol_lo[ dist ] : tables.dist_symbol_hi[ ( dist - 1 ) >> 7 ];
+				writer.put( tables.dist_code[ ds ], 5 );
+				writer.put( uint32_t( dist - DEFLATE_DIST_BASE[ ds ] ), DEFLATE_DIST_EXTRA[ ds ] );
+
+				// Remember positions inside the match, so that later matches may refer to them.
+				size_t match_end = i + len;
+				for ( size_t j = i + 1; j < match_end && j + DEFLATE_MIN_MATCH <= num_bytes; j++ ) {
+					head[ deflate_hash( data + j ) ] = uint32_t( j + 1 );
+				}
+
+				i = match_end;
+				continue;
+			}
+		}
+
+		put_literal( data[ i ] );
+		i++;
+	}
+
+	for ( ; i < num_bytes; i++ ) {
+		put_literal( data[ i ] );
+	}
+
+	writer.put( tables.lit_code[ 256 ], tables.lit_bits[ 256 ] ); // end of block
+	writer.flush();
+}
+
+// ----------------------------------------------------------------------
+
+static void png_write_chunk( std::vector<uint8_t>& out, char const* type, uint8_t const* data, uint32_t num_bytes ) {
+	put_u32_be( out, num_bytes );
+	size_t crc_begin = out.size();
+	out.insert( out.end(), type, type + 4 );
+	out.insert( out.end(), data, data + num_bytes );
+	put_u32_be( out, crc32_update( 0, out.data() + crc_begin, out.size() - crc_begin ) );
+}
+
+// ----------------------------------------------------------------------
+
+void le_image_encode_png( le_image_encoder_source_t const& src, std::vector<uint8_t>& out ) {
+
+	ZoneScoped;
+
+	static constexpr uint8_t PNG_SIGNATURE[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	std::vector<uint8_t> scanlines;
+	png_filter_rows( src, scanlines );
+
+	out.clear();
+	out.reserve( scanlines.size() / 2 ); // guess: filtered frames usually compress to less than half
+	out.insert( out.end(), PNG_SIGNATURE, PNG_SIGNATURE + 8 );
+
+	{
+		uint8_t ihdr[ 13 ] = {
+		    uint8_t( src.width >> 24 ), uint8_t( src.width >> 16 ), uint8_t( src.width >> 8 ), uint8_t( src.width ),
+		    uint8_t( src.height >> 24 ), uint8_t( src.height >> 16 ), uint8_t( src.height >> 8 ), uint8_t( src.height ),
+		    8, // bit depth
+		    6, // colour type: rgba
+		    0, // compression method: deflate
+		    0, // filter method: adaptive
+		    0, // interlace method: none
+		};
+		png_write_chunk( out, "IHDR", ihdr, sizeof( ihdr ) );
+	}
+
+	if ( src.is_srgb ) {
+		uint8_t rendering_intent = 0; // perceptual
+		png_write_chunk( out, "sRGB", &rendering_intent, 1 );
+	}
+
+	{
+		// We compress straight into the IDAT chunk, and patch its length once we know it.
+		size_t chunk_begin = out.size();
+		put_u32_be( out, 0 );
+		out.insert( out.end(), { 'I', 'D', 'A', 'T' } );
+
+		out.push_back( 0x78 ); // zlib CMF: deflate, 32K window
+		out.push_back( 0x01 ); // zlib FLG: no dictionary, fastest compression, check bits
+
+		deflate_fixed( scanlines.data(), scanlines.size(), out );
+		put_u32_be( out, adler32( scanlines.data(), scanlines.size() ) );
+
+		uint32_t data_size = uint32_t( out.size() - chunk_begin - 8 );
+		out[ chunk_begin + 0 ] = uint8_t( data_size >> 24 );
+		out[ chunk_begin + 1 ] = uint8_t( data_size >> 16 );
+		out[ chunk_begin + 2 ] = uint8_t( data_size >> 8 );
+		out[ chunk_begin + 3 ] = uint8_t( data_size );
+
+		put_u32_be( out, crc32_update( 0, out.data() + chunk_begin + 4, data_size + 4 ) );
+	}
+
+	png_write_chunk( out, "IEND", nullptr, 0 );
+}
+
+// ----------------------------------------------------------------------
+// QOI
+// ----------------------------------------------------------------------
+
+void le_image_encode_qoi( le_image_encoder_source_t const& src, std::vector<uint8_t>& out ) {
+
+	ZoneScoped;
+
+	static constexpr uint8_t QOI_OP_INDEX = 0x00;
+	static constexpr uint8_t QOI_OP_DIFF  = 0x40;
+	static constexpr uint8_t QOI_OP_LUMA  = 0x80;
+	static constexpr uint8_t QOI_OP_RUN   = 0xc0;
+	static constexpr uint8_t QOI_OP_RGB   = 0xfe;
+	static constexpr uint8_t QOI_OP_RGBA  = 0xff;
+
+	size_t const num_pixels = size_t( src.width ) * src.height;
+	size_t const row_stride = size_t( src.width ) * 4;
+
+	out.clear();
+	out.reserve( 14 + num_pixels * 5 + 8 ); // worst case: every pixel needs QOI_OP_RGBA
+	out.insert( out.end(), { 'q', 'o', 'i', 'f' } );
+	put_u32_be( out, src.width );
+	put_u32_be( out, src.height );
+	out.push_back( 4 );                    // channels
+	out.push_back( src.is_srgb ? 0 : 1 ); // colorspace: 0 - sRGB with linear alpha, 1 - all channels linear
+
+	uint8_t  index[ 64 ][ 4 ] = {};
+	uint8_t  px_prev[ 4 ]     = { 0, 0, 0, 255 };
+	uint32_t run              = 0;
+
+	std::vector<uint8_t> row( row_stride );
+
+	for ( uint32_t y = 0; y != src.height; y++ ) {
+
+		image_encoder_load_row( src, y, row.data() );
+
+		for ( size_t x = 0; x != row_stride; x += 4 ) {
+			uint8_t const* px = row.data() + x;
+
+			if ( 0 == memcmp( px, px_prev, 4 ) ) {
+				run++;
+				if ( run == 62 ) {
+					out.push_back( uint8_t( QOI_OP_RUN | ( run - 1 ) ) );
+					run = 0;
+				}
+				continue;
+			}
+
+			if ( run > 0 ) {
+				out.push_back( uint8_t( QOI_OP_RUN | ( run - 1 ) ) );
+				run = 0;
+			}
+
+			uint32_t index_pos = ( px[ 0 ] * 3 + px[ 1 ] * 5 + px[ 2 ] * 7 + px[ 3 ] * 11 ) % 64;
+
+			if ( 0 == memcmp( index[ index_pos ], px, 4 ) ) {
+				out.push_back( uint8_t( QOI_OP_INDEX | index_pos ) );
+			} else {
+				memcpy( index[ index_pos ], px, 4 );
+
+				if ( px[ 3 ] == px_prev[ 3 ] ) {
+					int8_t vr   = int8_t( px[ 0 ] - px_prev[ 0 ] );
+					int8_t vg   = int8_t( px[ 1 ] - px_prev[ 1 ] );
+					int8_t vb   = int8_t( px[ 2 ] - px_prev[ 2 ] );
+					int8_t vg_r = int8_t( vr - vg );
+					int8_t vg_b = int8_t( vb - vg );
+
+					if ( vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2 ) {
+						out.push_back( uint8_t( QOI_OP_DIFF | ( vr + 2 ) << 4 | ( vg + 2 ) << 2 | ( vb + 2 ) ) );
+					} else if ( vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8 ) {
+						out.push_back( uint8_t( QOI_OP_LUMA | ( vg + 32 ) ) );
+						out.push_back( uint8_t( ( vg_r + 8 ) << 4 | ( vg_b + 8 ) ) );
+					} else {
+						out.push_back( QOI_OP_RGB );
+						out.insert( out.end(), px, px + 3 );
+					}
+				} else {
+					out.push_back( QOI_OP_RGBA );
+					out.insert( out.end(), px, px + 4 );
+				}
+			}
+
+			memcpy( px_prev, px, 4 );
+		}
+	}
+
+	if ( run > 0 ) {
+		out.push_back( uint8_t( QOI_OP_RUN | ( run - 1 ) ) );
+	}
+
+	out.insert( out.end(), { 0, 0, 0, 0, 0, 0, 0, 1 } ); // end marker
+}
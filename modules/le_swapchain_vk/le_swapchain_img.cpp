@@ -9,6 +9,10 @@
 #include <cassert>
 #include "util/vk_mem_alloc/vk_mem_alloc.h"
 #include "le_log.h"
+#include "le_jobs.h"
+#include "le_tracy.h"
+#include "private/le_swapchain_vk/le_image_encoder.h"
+#include "private/le_core/le_setting_snapshot.h" // for publishing writer stats to the console
 
 #include <cstring>
 #include <iostream>
@@ -16,19 +20,39 @@
 #include <fstream>
 #include <sstream>
 #include <ctime>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <deque>
+
+#ifndef LE_MT
+#	define LE_MT 0
+#endif
 
 static constexpr auto LOGGER_LABEL = "le_swapchain_img";
 
+using ImageEncoder = le_swapchain_settings_t::img_settings_t::Encoder;
+
 struct TransferFrame {
-	VkImage           image            = nullptr; // Owned. Handle to image
-	VkBuffer          buffer           = nullptr; // Owned. Handle to buffer
-	VmaAllocation     imageAllocation  = nullptr; // Owned. Handle to image allocation
-	VmaAllocation     bufferAllocation = nullptr; // Owned. Handle to buffer allocation
+	VkImage           image           = nullptr; // Owned. Handle to image
+	VmaAllocation     imageAllocation = nullptr; // Owned. Handle to image allocation
 	VmaAllocationInfo imageAllocationInfo{};
-	VmaAllocationInfo bufferAllocationInfo{};
-	VkFence           frameFence;
-	VkCommandBuffer   cmdPresent; // copies from image to buffer
-	VkCommandBuffer   cmdAcquire; // transfers image back to correct layout
+	uint64_t          presentValue = 0; // swapchain timeline reaches this value once the most recent present of this image has completed
+	VkCommandBuffer   cmdPresent;       // copies from image to readback buffer - recorded on present, as the readback buffer changes
+	VkCommandBuffer   cmdAcquire;       // transfers image back to correct layout
+};
+
+// Host-visible buffer into which we copy a presented image, so that the writer thread
+// can write it out. Once present has submitted the copy, it hands the buffer over to the
+// writer thread, which waits for the swapchain timeline to reach the buffer's value, and
+// then reads the buffer.
+struct ReadbackBuffer {
+	VkBuffer          buffer     = nullptr; // Owned. Handle to buffer
+	VmaAllocation     allocation = nullptr; // Owned. Handle to buffer allocation
+	VmaAllocationInfo allocationInfo{};
+	uint64_t          timeline_value = 0; // swapchain timeline reaches this value once copy into buffer is complete
+	uint32_t          image_number   = 0; // number of the image which was copied into this buffer - used for file names
 };
 
 struct img_data_o {
@@ -43,13 +67,105 @@ struct img_data_o {
 	VkDevice                   device;                // Owned by backend
 	VkPhysicalDevice           physicalDevice;        // Owned by backend
 	VkCommandPool              vkCommandPool;         // Command pool from wich we allocate present and acquire command buffers
+	VkSemaphore                timeline;              // Owned. Timeline semaphore, signalled once per present - we never wait for fences
+	uint64_t                   timelineValue;         // most recent value which present has asked timeline to signal
 	le_backend_o*              backend = nullptr;     // Not owned. Backend owns swapchain.
 	std::vector<TransferFrame> transferFrames;        //
 	FILE*                      pipe = nullptr;        // Pipe to ffmpeg. Owned. must be closed if opened
 	std::string                pipe_cmd;              // command line
+	bool                       discard_images;        // if set, we neither open a pipe, nor write image files
+	ImageEncoder               encoder;               // ePipe: write images to pipe, otherwise: encode images, and write them to files
 	BackendQueueInfo*          queue_info = nullptr;  // Non-owning. Present-enabled queue, initially null, set at create
+
+	// Writer thread - only used if images are not discarded.
+	//
+	// Readback buffers form a ring: present fills them in order, and the writer thread writes
+	// them out in the same order. Present may only fill a buffer once the writer thread has
+	// written it out - if all buffers are still waiting to be written, present must stall.
+	std::thread                 writerThread;
+	std::vector<ReadbackBuffer> readbackBuffers;        // Owned. Ring of readback buffers
+	uint64_t                    readbackSubmitted;      // number of readback buffers which present has filled - only accessed by present
+	std::atomic<uint64_t>       readbackQueued;         // number of readback buffers handed over to writer thread; WRITER_STOP_BIT is set once writer should stop
+	std::atomic<uint64_t>       readbackWritten;        // number of readback buffers which writer thread has written out
+	uint64_t                    writerStallCount;       // number of presents which had to wait for the writer thread
+	double                      writerStallMs;          // total time which presents spent waiting for the writer thread
 };
 
+static constexpr uint64_t WRITER_STOP_BIT = 1ull << 63;
+
+// ----------------------------------------------------------------------
+// Records commands which copy frame's image into dst_buffer. Command buffer must not be pending:
+// we call this on present, after we have made sure that the frame's previous present has completed.
+static void swapchain_img_record_readback( img_data_o* self, TransferFrame& frame, VkBuffer dst_buffer ) {
+	VkCommandBuffer& cmdPresent = frame.cmdPresent;
+	{
+		VkCommandBufferBeginInfo info = {
+		    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		    .pNext            = nullptr, // optional
+		    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // optional
+		    .pInheritanceInfo = 0,                                           // optional
+		};
+
+		vkBeginCommandBuffer( cmdPresent, &info );
+	}
+
+	{
+
+		VkImageMemoryBarrier2 img_barrier{
+		    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		    .pNext               = nullptr,                              // optional
+		    .srcStageMask        = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,  // wait for nothing
+		    .srcAccessMask       = 0,                                    // flush nothing
+		    .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, // block on any transfer stage
+		    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make memory visible to transfer read (after layout transition)
+		    .oldLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,      // transition from present_src
+		    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to transfer_src optimal
+		    .srcQueueFamilyIndex = self->vk_queue_family_index,
+		    .dstQueueFamilyIndex = self->vk_queue_family_index,
+		    .image               = frame.image,
+		    .subresourceRange    = {
+		           .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+		           .baseMipLevel   = 0,
+		           .levelCount     = 1,
+		           .baseArrayLayer = 0,
+		           .layerCount     = 1,
+            },
+		};
+
+		VkDependencyInfo info{
+		    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		    .pNext                    = nullptr, // optional
+		    .dependencyFlags          = 0,       // optional
+		    .memoryBarrierCount       = 0,       // optional
+		    .pMemoryBarriers          = 0,
+		    .bufferMemoryBarrierCount = 0, // optional
+		    .pBufferMemoryBarriers    = 0,
+		    .imageMemoryBarrierCount  = 1, // optional
+		    .pImageMemoryBarriers     = &img_barrier,
+		};
+
+		vkCmdPipelineBarrier2( cmdPresent, &info );
+	}
+
+	VkBufferImageCopy imgCopy{
+	    .bufferOffset      = 0,
+	    .bufferRowLength   = self->mSwapchainExtent.width,
+	    .bufferImageHeight = self->mSwapchainExtent.height,
+	    .imageSubresource  = {
+	         .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+	         .mipLevel       = 0,
+	         .baseArrayLayer = 0,
+	         .layerCount     = 1,
+        },
+	    .imageOffset = {},
+	    .imageExtent = self->mSwapchainExtent,
+	};
+
+	// Image must be transferred to a buffer - we can then read from this buffer.
+	vkCmdCopyImageToBuffer( cmdPresent, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_buffer, 1, &imgCopy );
+	vkEndCommandBuffer( cmdPresent );
+}
+
 // ----------------------------------------------------------------------
 
 static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settings_t* settings_ ) {
@@ -69,7 +185,6 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 	assert( self->mSettings.type == le_swapchain_settings_t::Type::LE_IMG_SWAPCHAIN );
 
 	VkResult imgAllocationResult = VK_ERROR_UNKNOWN;
-	VkResult bufAllocationResult = VK_ERROR_UNKNOWN;
 
 	uint32_t const numFrames = self->mImagecount;
 
@@ -77,7 +192,6 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 
 	for ( auto& frame : self->transferFrames ) {
 
-		uint64_t image_size_in_bytes = 0;
 		{
 			// Allocate space for an image which can hold a render surface
 
@@ -113,52 +227,6 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 			        &frame.imageAllocation,
 			        &frame.imageAllocationInfo ) );
 			assert( imgAllocationResult == VK_SUCCESS );
-			image_size_in_bytes = frame.imageAllocationInfo.size;
-		}
-
-		{
-			// Allocate space for a buffer in which to read back the image data.
-			//
-			// now we need a buffer which is host visible and coherent, which we can use to read out our data.
-			// there needs to be one buffer per image;
-			using namespace le_backend_vk;
-
-			VkBufferCreateInfo bufferCreateInfo{
-			    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-			    .pNext                 = nullptr, // optional
-			    .flags                 = 0,       // optional
-			    .size                  = image_size_in_bytes,
-			    .usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-			    .queueFamilyIndexCount = 1, // optional
-			    .pQueueFamilyIndices   = &self->vk_queue_family_index,
-			};
-
-			VmaAllocationCreateInfo allocationCreateInfo{};
-			allocationCreateInfo.flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-			allocationCreateInfo.usage          = VMA_MEMORY_USAGE_CPU_ONLY;
-			allocationCreateInfo.preferredFlags = 0;
-
-			bufAllocationResult = VkResult(
-			    private_backend_vk_i.allocate_buffer(
-			        self->backend,
-			        &bufferCreateInfo,
-			        &allocationCreateInfo,
-			        &frame.buffer,
-			        &frame.bufferAllocation,
-			        &frame.bufferAllocationInfo //
-			        ) );
-			assert( bufAllocationResult == VK_SUCCESS );
-		}
-
-		{
-			VkFenceCreateInfo info{
-			    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-			    .pNext = nullptr, // optional
-			    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
-			};
-
-			vkCreateFence( self->device, &info, nullptr, &frame.frameFence );
 		}
 	}
 
@@ -185,94 +253,23 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 		}
 	}
 
-	// Add commands to command buffers for all frames.
+	// Add commands to acquire command buffers for all frames - present command buffers
+	// get recorded on present, since the readback buffer into which they copy changes.
 
 	for ( auto& frame : self->transferFrames ) {
-		{
-			// copy == transfer image to buffer memory
-			VkCommandBuffer& cmdPresent = frame.cmdPresent;
-			{
-				VkCommandBufferBeginInfo info = {
-				    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-				    .pNext            = nullptr, // optional
-				    .flags            = 0,       // optional
-				    .pInheritanceInfo = 0,       // optional
-				};
-
-				vkBeginCommandBuffer( cmdPresent, &info );
-			}
-
-			{
-
-				VkImageMemoryBarrier2 img_barrier{
-				    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-				    .pNext               = nullptr,                              // optional
-				    .srcStageMask        = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,  // wait for nothing
-				    .srcAccessMask       = 0,                                    // flush nothing
-				    .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, // block on any transfer stage
-				    .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,        // make memory visible to transfer read (after layout transition)
-				    .oldLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,      // transition from present_src
-				    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // to transfer_src optimal
-				    .srcQueueFamilyIndex = self->vk_queue_family_index,
-				    .dstQueueFamilyIndex = self->vk_queue_family_index,
-				    .image               = frame.image,
-				    .subresourceRange    = {
-				           .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-				           .baseMipLevel   = 0,
-				           .levelCount     = 1,
-				           .baseArrayLayer = 0,
-				           .layerCount     = 1,
-                    },
-				};
-
-				VkDependencyInfo info{
-				    .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-				    .pNext                    = nullptr, // optional
-				    .dependencyFlags          = 0,       // optional
-				    .memoryBarrierCount       = 0,       // optional
-				    .pMemoryBarriers          = 0,
-				    .bufferMemoryBarrierCount = 0, // optional
-				    .pBufferMemoryBarriers    = 0,
-				    .imageMemoryBarrierCount  = 1, // optional
-				    .pImageMemoryBarriers     = &img_barrier,
-				};
-
-				vkCmdPipelineBarrier2( cmdPresent, &info );
-			}
-
-			VkBufferImageCopy imgCopy{
-			    .bufferOffset      = 0,
-			    .bufferRowLength   = self->mSwapchainExtent.width,
-			    .bufferImageHeight = self->mSwapchainExtent.height,
-			    .imageSubresource  = {
-			         .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-			         .mipLevel       = 0,
-			         .baseArrayLayer = 0,
-			         .layerCount     = 1,
-                },
-			    .imageOffset = {},
-			    .imageExtent = self->mSwapchainExtent,
-			};
-			;
-
-			// TODO: here we must wait for the buffer read event to have been signalled - because that means that the buffer
-			// is available for writing again. Perhaps we should use a buffer which is not persistently mapped, if that's faster.
-
-			// Image must be transferred to a buffer - we can then read from this buffer.
-			vkCmdCopyImageToBuffer( cmdPresent, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame.buffer, 1, &imgCopy );
-			vkEndCommandBuffer( cmdPresent );
-		}
 		{
 			// Move ownership of image back from transfer -> graphics
 			// Change image layout back to colorattachment
 
 			VkCommandBuffer& cmdAcquire = frame.cmdAcquire;
 			{
+				// Acquire does not wait on the cpu for the previous submission of this command
+				// buffer to complete - it may still be pending when we submit it again.
 				VkCommandBufferBeginInfo info = {
 				    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-				    .pNext            = nullptr, // optional
-				    .flags            = 0,       // optional
-				    .pInheritanceInfo = 0,       // optional
+				    .pNext            = nullptr,                                      // optional
+				    .flags            = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, // optional
+				    .pInheritanceInfo = 0,                                            // optional
 				};
 
 				vkBeginCommandBuffer( cmdAcquire, &info );
@@ -283,7 +280,7 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 				VkImageMemoryBarrier2 img_read_to_acquire_barrier = {
 				    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
 				    .pNext               = nullptr,                                         // optional
-				    .srcStageMask        = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,               //
+				    .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,            // chain with the timeline wait, so that we don't transition while present still copies
 				    .srcAccessMask       = 0,                                               //
 				    .dstStageMask        = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, // block on color attachment output
 				    .dstAccessMask       = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,          // make image memory visible to attachment write (after layout transition)
@@ -323,6 +320,223 @@ static void swapchain_img_reset( le_swapchain_o* base, const le_swapchain_settin
 
 // ----------------------------------------------------------------------
 
+// Allocates ring of readback buffers. By default, we use one buffer more than there are
+// images, so that the writer thread may work on one buffer while the gpu fills the others.
+// If we encode images, we add one buffer per worker thread, so that each worker may encode
+// an image of its own.
+static void swapchain_img_create_readback_buffers( img_data_o* self ) {
+
+	LE_SETTING( uint32_t, LE_SETTING_SWAPCHAIN_IMG_READBACK_BUFFER_COUNT, 0 ); // 0 means: number of images + 1 (+ number of workers if encoding)
+
+	uint32_t const num_encoders = self->encoder == ImageEncoder::ePipe ? 0 : LE_MT;
+
+	uint32_t const count = *LE_SETTING_SWAPCHAIN_IMG_READBACK_BUFFER_COUNT
+	                           ? *LE_SETTING_SWAPCHAIN_IMG_READBACK_BUFFER_COUNT
+	                           : self->mImagecount + 1 + num_encoders;
+
+	self->readbackBuffers = std::vector<ReadbackBuffer>( count );
+
+	for ( auto& rb : self->readbackBuffers ) {
+		{
+			// We need a buffer which is host visible and coherent, which we can use to read out our data.
+			using namespace le_backend_vk;
+
+			VkBufferCreateInfo bufferCreateInfo{
+			    .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			    .pNext                 = nullptr, // optional
+			    .flags                 = 0,       // optional
+			    .size                  = uint64_t( self->mSwapchainExtent.width ) * self->mSwapchainExtent.height * 4,
+			    .usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			    .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+			    .queueFamilyIndexCount = 1, // optional
+			    .pQueueFamilyIndices   = &self->vk_queue_family_index,
+			};
+
+			VmaAllocationCreateInfo allocationCreateInfo{};
+			allocationCreateInfo.flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+			allocationCreateInfo.usage          = VMA_MEMORY_USAGE_CPU_ONLY;
+			allocationCreateInfo.preferredFlags = 0;
+
+			VkResult bufAllocationResult = VkResult(
+			    private_backend_vk_i.allocate_buffer(
+			        self->backend,
+			        &bufferCreateInfo,
+			        &allocationCreateInfo,
+			        &rb.buffer,
+			        &rb.allocation,
+			        &rb.allocationInfo //
+			        ) );
+			assert( bufAllocationResult == VK_SUCCESS );
+		}
+	}
+}
+
+// ----------------------------------------------------------------------
+// Blocks until the swapchain timeline has reached value - returns false on timeout.
+static bool swapchain_img_wait_for_timeline( img_data_o const* self, uint64_t value, uint64_t timeout_ns ) {
+
+	VkSemaphoreWaitInfo info{
+	    .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .pNext          = nullptr, // optional
+	    .flags          = 0,       // optional
+	    .semaphoreCount = 1,
+	    .pSemaphores    = &self->timeline,
+	    .pValues        = &value,
+	};
+
+	return VK_SUCCESS == vkWaitSemaphores( self->device, &info, timeout_ns );
+}
+
+// ----------------------------------------------------------------------
+// Writes one readback buffer to an image file, encoded with the swapchain's encoder.
+// There is one of these per readback buffer which is being written - the writer thread
+// owns them, and keeps them alive until their job has completed.
+struct ImageFileJob {
+	img_data_o const*     swapchain;
+	ReadbackBuffer const* rb;                // present won't touch rb until the writer thread releases it
+	le_jobs::counter_t*   counter = nullptr; // null if job ran on the writer thread
+	std::atomic<bool>     done    = false;   // set once file has been written
+};
+
+// ----------------------------------------------------------------------
+// Encodes and writes out an image file - runs as a job, one job per image, so that
+// images are encoded in parallel.
+static void swapchain_img_write_image_file( void* param_ ) {
+
+	ZoneScoped;
+
+	static auto logger = LeLog( LOGGER_LABEL );
+
+	auto       job  = static_cast<ImageFileJob*>( param_ );
+	auto const self = job->swapchain;
+
+	VkFormat const format = self->windowSurfaceFormat.format;
+
+	le_image_encoder_source_t src{
+	    .pixels  = static_cast<uint8_t const*>( job->rb->allocationInfo.pMappedData ),
+	    .width   = self->mSwapchainExtent.width,
+	    .height  = self->mSwapchainExtent.height,
+	    .is_bgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB,
+	    .is_srgb = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_SRGB,
+	};
+
+	std::vector<uint8_t> encoded;
+	uint8_t const*       data      = src.pixels;
+	size_t               num_bytes = size_t( src.width ) * src.height * 4;
+	char const*          extension = "rgba";
+
+	switch ( self->encoder ) {
+	case ImageEncoder::ePng:
+		le_image_encode_png( src, encoded );
+		extension = "png";
+		break;
+	case ImageEncoder::eQoi:
+		le_image_encode_qoi( src, encoded );
+		extension = "qoi";
+		break;
+	default: // raw: write pixels as they are
+		break;
+	}
+
+	if ( !encoded.empty() ) {
+		data      = encoded.data();
+		num_bytes = encoded.size();
+	}
+
+	char file_name[ 1024 ];
+	snprintf( file_name, sizeof( file_name ), "isl_%08d.%s", job->rb->image_number, extension );
+	std::ofstream myfile( file_name, std::ios::out | std::ios::binary );
+	myfile.write( ( char const* )data, std::streamsize( num_bytes ) );
+	myfile.close();
+	logger.info( "Wrote Image: %s", file_name );
+
+	job->done.store( true, std::memory_order_release );
+}
+
+// ----------------------------------------------------------------------
+// Writer thread: writes out readback buffers - to the ffmpeg pipe, or, if there is no pipe,
+// to image files - in the order in which present has filled them. It waits for each buffer's
+// timeline value, so that neither present nor acquire have to wait for a copy to complete, and it is
+// the only place where we block on writing.
+//
+// Image files are encoded and written by jobs, so that we may encode as many images in
+// parallel as there are readback buffers. Jobs may complete in any order, but we release
+// buffers back to present strictly in order, as they form a ring.
+static void swapchain_img_writer_run( img_data_o* self ) {
+
+	size_t const num_bytes   = size_t( self->mSwapchainExtent.width ) * self->mSwapchainExtent.height * 4;
+	uint64_t     num_written = 0; // number of buffers released back to present
+	uint64_t     num_started = 0; // number of buffers which we have started writing
+
+	std::deque<ImageFileJob> jobs; // jobs in flight, oldest first
+
+	auto release_oldest_job = [ & ]() {
+		if ( jobs.front().counter ) {
+			le_jobs::wait_for_counter_and_free( jobs.front().counter, 0 );
+		}
+		jobs.pop_front();
+		num_written++;
+		self->readbackWritten.store( num_written, std::memory_order_release ); // buffer may now be filled again
+		self->readbackWritten.notify_one();
+	};
+
+	for ( ;; ) {
+
+		while ( !jobs.empty() && jobs.front().done.load( std::memory_order_acquire ) ) {
+			release_oldest_job();
+		}
+
+		uint64_t queued = self->readbackQueued.load( std::memory_order_acquire );
+
+		if ( num_started != ( queued & ~WRITER_STOP_BIT ) ) {
+
+			// ----------| invariant: there is at least one readback buffer waiting to be written
+
+			ReadbackBuffer const& rb = self->readbackBuffers[ num_started % self->readbackBuffers.size() ];
+
+			swapchain_img_wait_for_timeline( self, rb.timeline_value, UINT64_MAX );
+			num_started++;
+
+			if ( self->encoder == ImageEncoder::ePipe ) {
+				// Write out frame contents to ffmpeg via pipe.
+				fwrite( rb.allocationInfo.pMappedData, num_bytes, 1, self->pipe );
+				num_written++;
+				self->readbackWritten.store( num_written, std::memory_order_release );
+				self->readbackWritten.notify_one();
+				continue;
+			}
+
+			ImageFileJob& job = jobs.emplace_back();
+			job.swapchain     = self;
+			job.rb            = &rb;
+
+			if ( LE_MT > 0 ) {
+				le_jobs::job_t j{ swapchain_img_write_image_file, &job };
+				le_jobs::run_jobs( &j, 1, &job.counter );
+			} else {
+				swapchain_img_write_image_file( &job );
+			}
+
+			continue;
+		}
+
+		// ----------| invariant: there are no buffers waiting to be started
+
+		if ( !jobs.empty() ) {
+			release_oldest_job(); // blocks until oldest job has completed
+			continue;
+		}
+
+		if ( queued & WRITER_STOP_BIT ) {
+			return; // all buffers which were handed over to us have been written
+		}
+
+		self->readbackQueued.wait( queued, std::memory_order_acquire );
+	}
+}
+
+// ----------------------------------------------------------------------
+
 static le_swapchain_o* swapchain_img_create( le_backend_o* backend, const le_swapchain_settings_t* settings ) {
 	static auto logger = LeLog( LOGGER_LABEL );
 	auto        base   = new le_swapchain_o( le_swapchain_vk::api->swapchain_img_i );
@@ -334,6 +548,8 @@ static le_swapchain_o* swapchain_img_create( le_backend_o* backend, const le_swa
 	self->windowSurfaceFormat.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 	self->mImageIndex                    = uint32_t( ~0 );
 	self->pipe_cmd                       = std::string( settings->img_settings.pipe_cmd );
+	self->discard_images                 = settings->img_settings.discard_images != 0;
+	self->encoder                        = settings->img_settings.encoder;
 	{
 
 		using namespace le_backend_vk;
@@ -355,9 +571,25 @@ static le_swapchain_o* swapchain_img_create( le_backend_o* backend, const le_swa
 		vkCreateCommandPool( self->device, &createInfo, nullptr, &self->vkCommandPool );
 	}
 
+	{
+		VkSemaphoreTypeCreateInfo type_info{
+		    .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		    .pNext         = nullptr, // optional
+		    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		    .initialValue  = 0,
+		};
+		VkSemaphoreCreateInfo createInfo{
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		    .pNext = &type_info, // optional
+		    .flags = 0,          // optional
+		};
+
+		vkCreateSemaphore( self->device, &createInfo, nullptr, &self->timeline );
+	}
+
 	swapchain_img_reset( base, settings );
 
-	{
+	if ( !self->discard_images && self->encoder == ImageEncoder::ePipe ) {
 		// Generate a timestamp string so that we can generate unique filenames,
 		// making sure that output files generated by successive runs are not
 		// overwritten.
@@ -415,6 +647,15 @@ static le_swapchain_o* swapchain_img_create( le_backend_o* backend, const le_swa
 
 		assert( self->pipe != nullptr );
 #endif // _MSC_VER
+
+		if ( self->pipe == nullptr ) {
+			self->encoder = ImageEncoder::eRaw; // without a pipe, we fall back to writing raw image files
+		}
+	}
+
+	if ( !self->discard_images ) {
+		swapchain_img_create_readback_buffers( self );
+		self->writerThread = std::thread( swapchain_img_writer_run, self );
 	}
 
 	logger.info( "Created Swapchain: %p: Image Swapchain", base );
@@ -434,6 +675,13 @@ static void swapchain_img_destroy( le_swapchain_o* base ) {
 	static auto logger = LeLog( LOGGER_LABEL );
 	auto        self   = static_cast<img_data_o* const>( base->data );
 
+	if ( self->writerThread.joinable() ) {
+		// Writer thread writes out all images which were presented so far before it stops.
+		self->readbackQueued.fetch_or( WRITER_STOP_BIT, std::memory_order_release );
+		self->readbackQueued.notify_one();
+		self->writerThread.join();
+	}
+
 	if ( self->pipe ) {
 #ifdef _MSC_VER
 
@@ -447,38 +695,36 @@ static void swapchain_img_destroy( le_swapchain_o* base ) {
 	using namespace le_backend_vk;
 
 	{
-		// -- Wait for current in-flight frame to be completed on device.
+		// -- Wait for all presents to be completed on device.
 
 		// We must do this since we're not allowed to delete any vulkan resources
-		// which are currently used by the device. Awaiting the fence guarantees
-		// that no resources are in-flight at this point.
-
-		auto imageIndex = ( self->mImageIndex ) % self->mImagecount;
-
-		auto fenceWaitResult = vkWaitForFences( self->device, 1, &self->transferFrames[ imageIndex ].frameFence, VK_TRUE, 100'000'000 );
+		// which are currently used by the device. Once the timeline has reached
+		// its most recent value, no resources are in-flight.
 
-		if ( fenceWaitResult != VK_SUCCESS ) {
-			// assert( false ); // waiting for fence took too long.
+		if ( false == swapchain_img_wait_for_timeline( self, self->timelineValue, 100'000'000 ) ) {
+			// assert( false ); // waiting for timeline took too long.
 		}
 	}
 
 	for ( auto& f : self->transferFrames ) {
-
 		// Destroy image allocation for this frame.
 		private_backend_vk_i.destroy_image( self->backend, f.image, f.imageAllocation );
-		// Destroy buffer allocation for this frame.
-		private_backend_vk_i.destroy_buffer( self->backend, f.buffer, f.bufferAllocation );
-
-		if ( f.frameFence ) {
-			vkDestroyFence( self->device, f.frameFence, nullptr );
-			f.frameFence = nullptr;
-		}
 	}
 
 	// Clear TransferFrame
 
 	self->transferFrames.clear();
 
+	// Writer thread has waited for all readback buffers - no readback buffer is in use.
+
+	for ( auto& rb : self->readbackBuffers ) {
+		private_backend_vk_i.destroy_buffer( self->backend, rb.buffer, rb.allocation );
+	}
+
+	vkDestroySemaphore( self->device, self->timeline, nullptr );
+
+	self->readbackBuffers.clear();
+
 	if ( self->vkCommandPool ) {
 
 		// Destroying the command pool implicitly frees all command buffers
@@ -508,52 +754,30 @@ static bool swapchain_img_acquire_next_image( le_swapchain_o* base, VkSemaphore
 	// acquire next image, signal semaphore
 	*imageIndex = ( self->mImageIndex + 1 ) % self->mImagecount;
 
-	auto fenceWaitResult = vkWaitForFences( self->device, 1, &self->transferFrames[ *imageIndex ].frameFence, VK_TRUE, 100'000'000 );
-
-	if ( fenceWaitResult != VK_SUCCESS ) {
-		assert( false ); // waiting for fence took too long.
-	}
-
-	vkResetFences( self->device, 1, &self->transferFrames[ *imageIndex ].frameFence );
-
 	self->mImageIndex = *imageIndex;
 
-	// We only want to write out images which have made the round-trip
-	// the first n images will be black...
-	if ( self->totalImages > self->mImagecount ) {
-		if ( self->pipe ) {
-			// TODO: we should be able to do the write on the back thread.
-			// the back thread must signal that it is complete with writing
-			// before the next present command is executed.
-
-			// Write out frame contents to ffmpeg via pipe.
-			auto const& frame = self->transferFrames[ *imageIndex ];
-			fwrite( frame.bufferAllocationInfo.pMappedData, self->mSwapchainExtent.width * self->mSwapchainExtent.height * 4, 1, self->pipe );
+	++self->totalImages;
 
-		} else {
-			char file_name[ 1024 ];
-			sprintf( file_name, "isl_%08d.rgba", self->totalImages );
-			auto const&   frame = self->transferFrames[ *imageIndex ];
-			std::ofstream myfile( file_name, std::ios::out | std::ios::binary );
-			myfile.write( ( char* )frame.bufferAllocationInfo.pMappedData,
-			              self->mSwapchainExtent.width * self->mSwapchainExtent.height * 4 );
-			myfile.close();
-			logger.info( "Wrote Image: %s", file_name );
-		}
-	}
+	// We don't wait on the cpu for the previous present of this image to complete: instead,
+	// the acquire submission waits on the gpu for the timeline to reach the image's present value.
 
-	++self->totalImages;
+	VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
-	// The number of array elements must correspond to the number of wait semaphores, as each
-	// mask specifies what the semaphore is waiting for.
-	// std::array<VkPipelineStageFlags, 1> wait_dst_stage_mask = { VkPipelineStageFlagBits::eTransfer };
+	VkTimelineSemaphoreSubmitInfo timelineInfo{
+	    .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+	    .pNext                     = nullptr, // optional
+	    .waitSemaphoreValueCount   = 1,       // optional
+	    .pWaitSemaphoreValues      = &self->transferFrames[ *imageIndex ].presentValue,
+	    .signalSemaphoreValueCount = 0, // optional - signal semaphore is binary
+	    .pSignalSemaphoreValues    = nullptr,
+	};
 
 	VkSubmitInfo submitInfo{
 	    .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-	    .pNext                = nullptr, // optional
-	    .waitSemaphoreCount   = 0,       // optional
-	    .pWaitSemaphores      = 0,
-	    .pWaitDstStageMask    = 0,
+	    .pNext                = &timelineInfo, // optional
+	    .waitSemaphoreCount   = 1,             // optional
+	    .pWaitSemaphores      = &self->timeline,
+	    .pWaitDstStageMask    = &wait_dst_stage_mask,
 	    .commandBufferCount   = 1, // optional
 	    .pCommandBuffers      = &self->transferFrames[ *imageIndex ].cmdAcquire,
 	    .signalSemaphoreCount = 1, // optional
@@ -581,25 +805,103 @@ static bool swapchain_img_acquire_next_image( le_swapchain_o* base, VkSemaphore
 
 // ----------------------------------------------------------------------
 
+// Returns the next readback buffer in the ring - once the writer thread has written it out.
+// If the writer thread can't keep up, this blocks, and counts as a stall.
+static ReadbackBuffer& swapchain_img_wait_for_readback_buffer( img_data_o* self ) {
+
+	size_t const num_buffers = self->readbackBuffers.size();
+	uint64_t     written     = self->readbackWritten.load( std::memory_order_acquire );
+
+	if ( self->readbackSubmitted - written >= num_buffers ) {
+		auto t0 = std::chrono::steady_clock::now();
+		do {
+			self->readbackWritten.wait( written, std::memory_order_acquire );
+			written = self->readbackWritten.load( std::memory_order_acquire );
+		} while ( self->readbackSubmitted - written >= num_buffers );
+		self->writerStallCount++;
+		self->writerStallMs += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count();
+	}
+
+	return self->readbackBuffers[ self->readbackSubmitted % num_buffers ];
+}
+
+// ----------------------------------------------------------------------
+
 static bool swapchain_img_present( le_swapchain_o* base, VkQueue queue, VkSemaphore renderCompleteSemaphore_, uint32_t* pImageIndex ) {
 
-	auto self = static_cast<img_data_o* const>( base->data );
+	auto  self  = static_cast<img_data_o* const>( base->data );
+	auto& frame = self->transferFrames[ *pImageIndex ];
 
 	VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
 
+	// Cmd present for this frame was last submitted with this frame's previous present - it
+	// must have completed before we may submit it again, or record into it.
+	uint64_t const previousPresentValue = frame.presentValue;
+
+	frame.presentValue = ++self->timelineValue;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{
+	    .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+	    .pNext                     = nullptr, // optional
+	    .waitSemaphoreValueCount   = 0,       // optional - wait semaphore is binary
+	    .pWaitSemaphoreValues      = nullptr,
+	    .signalSemaphoreValueCount = 1, // optional
+	    .pSignalSemaphoreValues    = &frame.presentValue,
+	};
+
 	VkSubmitInfo submitInfo{
 	    .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-	    .pNext                = nullptr, // optional
+	    .pNext                = &timelineInfo, // optional
 	    .waitSemaphoreCount   = 1,
 	    .pWaitSemaphores      = &renderCompleteSemaphore_, // tells us that the image has been written
 	    .pWaitDstStageMask    = &wait_dst_stage_mask,
 	    .commandBufferCount   = 1,
-	    .pCommandBuffers      = &self->transferFrames[ *pImageIndex ].cmdPresent, // copies image to buffer
-	    .signalSemaphoreCount = 0,                                                // optional
-	    .pSignalSemaphores    = 0,
+	    .pCommandBuffers      = &frame.cmdPresent, // copies image to readback buffer
+	    .signalSemaphoreCount = 1,                 // optional
+	    .pSignalSemaphores    = &self->timeline,   // tells acquire, and the writer thread, that this present has completed
 	};
 
-	vkQueueSubmit( queue, 1, &submitInfo, self->transferFrames[ *pImageIndex ].frameFence );
+	if ( self->readbackBuffers.empty() ) {
+		// Images are discarded - we don't copy, but we must still wait for the semaphore.
+		submitInfo.commandBufferCount = 0;
+		vkQueueSubmit( queue, 1, &submitInfo, nullptr );
+		return true;
+	}
+
+	// ----------| invariant: we must read back the image
+
+	LE_SETTING( le_setting_snapshot_t, LE_SETTING_SWAPCHAIN_IMG_WRITER_STATS, "" );
+
+	ReadbackBuffer& rb = swapchain_img_wait_for_readback_buffer( self );
+
+	// ----------| invariant: writer thread is done with rb
+
+	// This only blocks if the gpu is a whole swapchain's worth of images behind us - the
+	// renderer's frame fences usually make sure that this never happens.
+	swapchain_img_wait_for_timeline( self, previousPresentValue, UINT64_MAX );
+
+	rb.image_number   = self->totalImages;
+	rb.timeline_value = frame.presentValue;
+
+	swapchain_img_record_readback( self, frame, rb.buffer );
+
+	vkQueueSubmit( queue, 1, &submitInfo, nullptr );
+
+	self->readbackSubmitted++;
+	self->readbackQueued.fetch_add( 1, std::memory_order_release );
+	self->readbackQueued.notify_one();
+
+	uint64_t written = self->readbackWritten.load( std::memory_order_relaxed );
+
+	std::ostringstream msg;
+	msg << "written: " << written
+	    << ", waiting: " << ( self->readbackSubmitted - written )
+	    << " / " << self->readbackBuffers.size()
+	    << ", stalls: " << self->writerStallCount
+	    << " (" << std::fixed << std::setprecision( 3 ) << self->writerStallMs << " ms)";
+
+	LE_SETTING_SWAPCHAIN_IMG_WRITER_STATS->publish( msg.str() );
+
 	return true;
 };
 
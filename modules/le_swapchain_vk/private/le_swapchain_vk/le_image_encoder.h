@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * Built-in image encoders for the image swapchain.
+ *
+ * These let the image swapchain write compressed image files without having to
+ * pipe frames to an external process. Encoders are self-contained, and only touch
+ * their source and their output, so that any number of frames may be encoded in
+ * parallel, one frame per worker thread.
+ *
+ * Source pixels are tightly packed, 8 bits per channel, 4 channels per pixel.
+ *
+ */
+struct le_image_encoder_source_t {
+	uint8_t const* pixels;  // tightly packed, width * height * 4 bytes
+	uint32_t       width;   //
+	uint32_t       height;  //
+	bool           is_bgra; // if set, pixels are stored as bgra - encoders swizzle them to rgba
+	bool           is_srgb; // if set, colour channels are sRGB encoded - only used as a hint for the file header
+};
+
+// Encodes source as a PNG file - uses fixed-Huffman deflate with a greedy, single-candidate
+// LZ77 matcher, which is much faster than zlib at its default level, and compresses somewhat less.
+void le_image_encode_png( le_image_encoder_source_t const& src, std::vector<uint8_t>& out );
+
+// Encodes source as a QOI file ("Quite OK Image Format", see https://qoiformat.org/).
+void le_image_encode_qoi( le_image_encoder_source_t const& src, std::vector<uint8_t>& out );
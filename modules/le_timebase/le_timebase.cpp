@@ -41,6 +41,14 @@ static void le_timebase_destroy( le_timebase_o* self ) {
 
 static void le_timebase_update( le_timebase_o* self, uint64_t fixed_interval ) {
 
+	// If set, overrides clock-based intervals, so that animations advance by the same
+	// amount each frame - the renderer sets this when it runs a headless benchmark.
+	LE_SETTING( uint64_t, LE_SETTING_TIMEBASE_FIXED_INTERVAL_TICKS, 0 );
+
+	if ( 0 == fixed_interval ) {
+		fixed_interval = *LE_SETTING_TIMEBASE_FIXED_INTERVAL_TICKS;
+	}
+
 	self->ticks_before_previous_update = self->ticks_before_update;
 
 	if ( fixed_interval ) {
@@ -0,0 +1,120 @@
+#!/bin/bash
+
+# Runs apps as headless benchmarks, and collects one JSON report per app.
+#
+# Each app renders a fixed number of frames into an image swapchain which discards
+# its images, with a fixed timebase, and then exits - see `le_renderer_benchmark_t`
+# in le_renderer.cpp for details. Reports go into ./benchmarks/<app_name>.json
+#
+# To run on a software Vulkan driver (so that results are comparable across
+# machines without a gpu), point VK_ICD_FILENAMES to lavapipe - by default,
+# we use lavapipe if we can find it:
+#
+#   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./run_benchmarks.sh
+#
+# Apps which create a window still need an X server, even though nothing gets
+# presented to it - if there is no display, we run apps via `xvfb-run`.
+
+# list apps you want to benchmark
+
+apps_list=("
+	examples/hello_triangle:Island-HelloTriangle
+	examples/hello_world:Island-HelloWorld
+	examples/asterisks:Island-Asterisks
+	examples/bitonic_merge_sort_example:Island-BitonicMergeSortExample
+")
+
+BENCHMARK_FRAMES=${BENCHMARK_FRAMES:-600}
+BENCHMARK_WARMUP_FRAMES=${BENCHMARK_WARMUP_FRAMES:-60}
+REPORT_DIR=`pwd`/benchmarks
+
+if [ -z "$VK_ICD_FILENAMES" ]
+then
+	for icd in /usr/share/vulkan/icd.d/lvp_icd*.json
+	do
+		if [ -f "$icd" ]
+		then
+			export VK_ICD_FILENAMES=$icd
+			break
+		fi
+	done
+fi
+
+run_prefix=""
+
+if [ -z "$DISPLAY" ]
+then
+	run_prefix="xvfb-run -a"
+fi
+
+# build app using ninja - create build directory if it does not exist yet
+build_app(){
+	local build_dir=$1
+
+	mkdir -p $build_dir
+	pushd $build_dir
+	cmake ../.. -DCMAKE_BUILD_TYPE=Release -GNinja && ninja
+	local return_code=$?
+	popd
+	return $return_code
+}
+
+benchmark_app(){
+	IFS=: read -ra app_names -d '' <<<"$1"
+	local app_dir=${app_names[0]}
+	local app_name=${app_names[1]}
+	local app_base_dir="../../apps/$app_dir"
+	local build_dir="${app_base_dir}/build/Desktop-Benchmark"
+
+	if [ ! -d $app_base_dir ]
+	then
+		echo "directory not found: '${app_base_dir}'"
+		exit 1
+	fi
+
+	build_app $build_dir &>build.log
+
+	if test $? -ne 0
+	then
+		printf "[ FAIL ] %- 10s: %s\n" "Build" ${app_name}
+		cat build.log
+		return 1
+	fi
+
+	rm -f ${REPORT_DIR}/${app_name}.json
+
+	pushd $build_dir > /dev/null
+	env LE_BENCHMARK_FRAMES=${BENCHMARK_FRAMES} \
+	    LE_BENCHMARK_WARMUP_FRAMES=${BENCHMARK_WARMUP_FRAMES} \
+	    LE_BENCHMARK_REPORT=${REPORT_DIR}/${app_name}.json \
+	    ${run_prefix} ./${app_name} &>run.log
+	local return_code=$?
+	popd > /dev/null
+
+	if test $return_code -ne 0
+	then
+		printf "[ FAIL ] %- 10s: %s\n" "Run" ${app_name}
+		cat ${build_dir}/run.log
+		return 1
+	fi
+
+	if [ ! -f ${REPORT_DIR}/${app_name}.json ]
+	then
+		printf "[ FAIL ] %- 10s: %s\n" "Report" ${app_name}
+		cat ${build_dir}/run.log
+		return 1
+	fi
+
+	printf "[  OK  ] %- 10s: %s\n" "Benchmark" ${app_name}
+}
+
+# main script
+
+mkdir -p $REPORT_DIR
+
+IFS=$'\n' read -ra arr -d '' <<<"$apps_list"
+
+for a in "${arr[@]}"; do
+	b=`echo $a | tr -d [:space:]`;
+	benchmark_app $b
+done
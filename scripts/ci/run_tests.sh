@@ -13,6 +13,7 @@ apps_list=("
 	examples/imgui_example:Island-ImguiExample
 	examples/asterisks:Island-Asterisks
 	examples/bitonic_merge_sort_example:Island-BitonicMergeSortExample
+	examples/image_encoder_test:Island-ImageEncoderTest
 ")
 
 tempfiles=( )